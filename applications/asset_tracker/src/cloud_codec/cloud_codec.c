@@ -19,7 +19,9 @@
 
 #include "cJSON.h"
 #include "cJSON_os.h"
+#include <json_writer.h>
 #include "cloud_codec.h"
+#include "cloud_codec_cbor.h"
 
 #include "service_info.h"
 #include "env_sensors.h"
@@ -276,49 +278,6 @@ static int cloud_set_chan_cfg_item(const enum cloud_channel channel,
 				   const enum sensor_chan_cfg_item_type type,
 				   const double value);
 
-static int json_add_obj(cJSON *parent, const char *str, cJSON *item)
-{
-	cJSON_AddItemToObject(parent, str, item);
-
-	return 0;
-}
-
-static int json_add_str(cJSON *parent, const char *str, const char *item)
-{
-	cJSON *json_str;
-
-	json_str = cJSON_CreateString(item);
-	if (json_str == NULL) {
-		return -ENOMEM;
-	}
-
-	return json_add_obj(parent, str, json_str);
-}
-
-static int json_add_number(cJSON *parent, const char *str, double item)
-{
-	cJSON *json_num;
-
-	json_num = cJSON_CreateNumber(item);
-	if (json_num == NULL) {
-		return -ENOMEM;
-	}
-
-	return json_add_obj(parent, str, json_num);
-}
-
-static int json_add_bool(cJSON *parent, const char *str, const bool value)
-{
-	cJSON *json_bool;
-
-	json_bool = cJSON_CreateBool(value);
-	if (json_bool == NULL) {
-		return -ENOMEM;
-	}
-
-	return json_add_obj(parent, str, json_bool);
-}
-
 static cJSON *json_object_decode(cJSON *obj, const char *str)
 {
 	return obj ? cJSON_GetObjectItem(obj, str) : NULL;
@@ -335,12 +294,38 @@ static bool json_value_string_compare(cJSON *obj, const char *const str)
 	return (strcmp(json_str, str) == 0);
 }
 
+struct data_ctx {
+	const struct cloud_channel_data *channel;
+	enum cloud_cmd_group group;
+	int64_t ts;
+};
+
+static void data_write(struct json_writer *w, const void *ctx)
+{
+	const struct data_ctx *data = ctx;
+
+	json_writer_obj_start(w, NULL);
+	json_writer_str(w, CMD_CHAN_KEY_STR,
+			channel_type_str[data->channel->type]);
+	json_writer_str(w, CMD_DATA_TYPE_KEY_STR, data->channel->data.buf);
+	json_writer_str(w, CMD_GROUP_KEY_STR, cmd_group_str[data->group]);
+	json_writer_int(w, DATA_TS, data->ts);
+	json_writer_obj_end(w);
+}
+
 int cloud_encode_data(const struct cloud_channel_data *channel,
 		      const enum cloud_cmd_group group,
 		      struct cloud_msg *output)
 {
 	int ret;
-	int64_t data_ts = channel->ts;
+	struct data_ctx ctx = {
+		.channel = channel,
+		.group = group,
+	};
+
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_encode_data(channel, group, output);
+	}
 
 	if (channel == NULL || channel->data.buf == NULL ||
 	    channel->data.len == 0 || output == NULL ||
@@ -348,40 +333,23 @@ int cloud_encode_data(const struct cloud_channel_data *channel,
 		return -EINVAL;
 	}
 
-	cJSON *root_obj = cJSON_CreateObject();
-	if (root_obj == NULL) {
-		cJSON_Delete(root_obj);
-		return -ENOMEM;
-	}
-
 	/** Convert sample uptime to unix time ms. If this function fails the
 	 *  uptime is cleared and an empty timestamp value is encoded.
 	 */
-	ret = date_time_uptime_to_unix_time_ms(&data_ts);
+	ctx.ts = channel->ts;
+	ret = date_time_uptime_to_unix_time_ms(&ctx.ts);
 	if (ret) {
 		LOG_WRN("date_time_uptime_to_unix_time_ms, error: %d", ret);
 		LOG_WRN("Clearing timestamp");
-		date_time_timestamp_clear(&data_ts);
+		date_time_timestamp_clear(&ctx.ts);
 	}
 
-	ret = json_add_str(root_obj, CMD_CHAN_KEY_STR,
-			   channel_type_str[channel->type]);
-	ret += json_add_str(root_obj, CMD_DATA_TYPE_KEY_STR, channel->data.buf);
-	ret += json_add_str(root_obj, CMD_GROUP_KEY_STR, cmd_group_str[group]);
-	ret += json_add_number(root_obj, DATA_TS, data_ts);
-	if (ret != 0) {
-		cJSON_Delete(root_obj);
+	output->buf = json_writer_alloc_print(data_write, &ctx, &output->len);
+	if (output->buf == NULL) {
+		output->len = 0;
 		return -ENOMEM;
 	}
 
-	char *buffer;
-
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
-
-	output->buf = buffer;
-	output->len = strlen(buffer);
-
 	return 0;
 }
 
@@ -395,6 +363,10 @@ int cloud_encode_env_sensors_data(const env_sensor_data_t *sensor_data,
 	uint8_t len;
 	struct cloud_channel_data cloud_sensor = { .ts = sensor_data->ts };
 
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_encode_env_sensors_data(sensor_data, output);
+	}
+
 	switch (sensor_data->type) {
 	case ENV_SENSOR_TEMPERATURE:
 		cloud_sensor.type = CLOUD_CHANNEL_TEMP;
@@ -435,6 +407,10 @@ int cloud_encode_motion_data(const motion_data_t *motion_data,
 		.ts = motion_data->ts
 	};
 
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_encode_motion_data(motion_data, output);
+	}
+
 	switch (motion_data->orientation) {
 	case MOTION_ORIENTATION_NORMAL:
 		cloud_sensor.data.buf = "NORMAL";
@@ -471,6 +447,10 @@ int cloud_encode_light_sensor_data(const struct light_sensor_data *sensor_data,
 					  .blue = LIGHT_SENSOR_DATA_NO_UPDATE,
 					  .ir = LIGHT_SENSOR_DATA_NO_UPDATE };
 
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_encode_light_sensor_data(sensor_data, output);
+	}
+
 	if ((sensor_data == NULL) || (output == NULL)) {
 		return -EINVAL;
 	}
@@ -503,25 +483,28 @@ int cloud_encode_light_sensor_data(const struct light_sensor_data *sensor_data,
 }
 #endif /* CONFIG_LIGHT_SENSOR */
 
+static void config_data_write(struct json_writer *w, const void *ctx)
+{
+	const enum cloud_cmd_state *gps_state = ctx;
+
+	json_writer_obj_start(w, NULL);
+	json_writer_obj_start(w, "state");
+	json_writer_obj_start(w, "reported");
+	json_writer_obj_start(w, "config");
+	json_writer_obj_start(w, channel_type_str[CLOUD_CHANNEL_GPS]);
+	json_writer_bool(w, cmd_type_str[CLOUD_CMD_ENABLE],
+			 *gps_state == CLOUD_CMD_STATE_TRUE);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+}
+
 int cloud_encode_config_data(struct cloud_msg *output)
 {
 	__ASSERT_NO_MSG(output != NULL);
 
-	cJSON *chan_obj = cJSON_CreateObject();
-	cJSON *state_obj = cJSON_CreateObject();
-	cJSON *reported_obj = cJSON_CreateObject();
-	cJSON *config_obj = cJSON_CreateObject();
-	cJSON *root_obj = cJSON_CreateObject();
-	int ret = 0;
-	char *buffer;
-
-	if (chan_obj == NULL || state_obj == NULL ||
-	    reported_obj == NULL || config_obj == NULL ||
-		root_obj == NULL) {
-		ret = -ENOMEM;
-		goto cleanup;
-	}
-
 	/* Currently, the only value that can be changed from
 	 * the device is GPS enable, so it is the only
 	 * one that needs to be sent.
@@ -529,45 +512,73 @@ int cloud_encode_config_data(struct cloud_msg *output)
 	enum cloud_cmd_state gps_state =
 		cloud_get_channel_enable_state(CLOUD_CHANNEL_GPS);
 
-	if (gps_state != CLOUD_CMD_STATE_UNDEFINED) {
-		ret = json_add_bool(chan_obj, cmd_type_str[CLOUD_CMD_ENABLE],
-				gps_state == CLOUD_CMD_STATE_TRUE);
-		if (ret != 0) {
-			ret = -ENOMEM;
-			goto cleanup;
-		}
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_encode_config_data(output);
 	}
 
-	/* No items in chan_obj is not an error, there
+	output->buf = NULL;
+	output->len = 0;
+
+	/* No GPS state is not an error, there
 	 * is just nothing to report
 	 */
-	if (cJSON_GetArraySize(chan_obj) == 0) {
-		goto cleanup;
+	if (gps_state == CLOUD_CMD_STATE_UNDEFINED) {
+		return 0;
 	}
 
-	cJSON_AddItemToObject(config_obj, channel_type_str[CLOUD_CHANNEL_GPS],
-			      chan_obj);
-	cJSON_AddItemToObject(reported_obj, "config", config_obj);
-	cJSON_AddItemToObject(state_obj, "reported", reported_obj);
-	cJSON_AddItemToObject(root_obj, "state", state_obj);
-
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
-	output->buf = buffer;
-	output->len = strlen(buffer);
+	output->buf = json_writer_alloc_print(config_data_write, &gps_state,
+					      &output->len);
+	if (output->buf == NULL) {
+		output->len = 0;
+		return -ENOMEM;
+	}
 
 	return 0;
+}
 
-cleanup:
-	output->buf = NULL;
-	output->len = 0;
-	cJSON_Delete(chan_obj);
-	cJSON_Delete(state_obj);
-	cJSON_Delete(reported_obj);
-	cJSON_Delete(config_obj);
-	cJSON_Delete(root_obj);
+struct device_status_ctx {
+	void *modem_param;
+	const char *const *ui;
+	uint32_t ui_count;
+	const char *const *fota;
+	uint32_t fota_count;
+	uint16_t fota_version;
+	const char *channel_type;
+};
+
+static void device_status_write(struct json_writer *w, const void *ctx)
+{
+	const struct device_status_ctx *status = ctx;
+
+	json_writer_obj_start(w, NULL);
+	json_writer_obj_start(w, "state");
+	json_writer_obj_start(w, "reported");
+
+	/* Workaround for deleting "DEVICE" objects (with uppercase key) if
+	 * it already exists in the digital twin.
+	 * The cloud implementations expect the key to be lowercase "device",
+	 * but that would duplicate the information and needlessly increase
+	 * the size of the digital twin document if the "DEVICE" is not
+	 * deleted at the same time.
+	 */
+	json_writer_null(w, CLOUD_CHANNEL_STR_DEVICE_INFO);
+
+	json_writer_obj_start(w, status->channel_type);
+
+#ifdef CONFIG_MODEM_INFO
+	if (status->modem_param) {
+		modem_info_json_object_write(status->modem_param, w);
+	}
+#endif
 
-	return ret;
+	service_info_json_object_write(status->ui, status->ui_count,
+				       status->fota, status->fota_count,
+				       status->fota_version, w);
+
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
 }
 
 int cloud_encode_device_status_data(
@@ -581,91 +592,37 @@ int cloud_encode_device_status_data(
 	__ASSERT_NO_MSG((fota != NULL) || !fota_count);
 	__ASSERT_NO_MSG(output != NULL);
 
-	cJSON *root_obj = cJSON_CreateObject();
-	cJSON *state_obj = cJSON_CreateObject();
-	cJSON *reported_obj = cJSON_CreateObject();
-	cJSON *device_obj = cJSON_CreateObject();
 	char dev_str[] = CLOUD_CHANNEL_STR_DEVICE_INFO;
-	const char *channel_type;
-	int ret = 0;
-
-	if (root_obj == NULL || state_obj == NULL ||
-	    reported_obj == NULL || device_obj == NULL) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(reported_obj);
-		cJSON_Delete(device_obj);
-		return -ENOMEM;
-	}
+	struct device_status_ctx ctx = {
+		.modem_param = modem_param,
+		.ui = ui,
+		.ui_count = ui_count,
+		.fota = fota,
+		.fota_count = fota_count,
+		.fota_version = fota_version,
+		.channel_type = dev_str,
+	};
 
-	/* Workaround for deleting "DEVICE" objects (with uppercase key) if
-	 * it already exists in the digital twin.
-	 * The cloud implementations expect the key to be lowercase "device",
-	 * but that would duplicate the information and needlessly increase
-	 * the size of the digital twin document if the "DEVICE" is not
-	 * deleted at the same time.
-	 */
-	cJSON *dummy_obj = cJSON_CreateNull();
-
-	if (dummy_obj == NULL) {
-		/* Dummy creation failed, but we'll let it do so
-		 * silently as it's not a functionally critical error.
-		 */
-	} else {
-		ret += json_add_obj(reported_obj, dev_str, dummy_obj);
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_encode_device_status_data(modem_param,
+							    ui, ui_count,
+							    fota, fota_count,
+							    fota_version,
+							    output);
 	}
 
 	/* Convert to lowercase for shadow */
 	for (int i = 0; dev_str[i]; ++i) {
 		dev_str[i] = tolower(dev_str[i]);
 	}
-	channel_type = dev_str;
-
-	size_t item_cnt = 0;
-
-#ifdef CONFIG_MODEM_INFO
-	if (modem_param) {
-		int val;
-
-		val = modem_info_json_object_encode((struct modem_param_info *)
-			modem_param, device_obj);
-		if (val > 0) {
-			item_cnt = (size_t)val;
-		}
-	}
-#endif
 
-	if (service_info_json_object_encode(ui, ui_count,
-					    fota, fota_count,
-					    fota_version,
-					    device_obj) == 0) {
-		++item_cnt;
-	}
-
-	if (item_cnt != 0) {
-		ret += json_add_obj(reported_obj, channel_type, device_obj);
-		ret += json_add_obj(state_obj, "reported", reported_obj);
-		ret += json_add_obj(root_obj, "state", state_obj);
-	} else {
-		ret = -ECHILD;
-	}
-
-	if (ret != 0) {
-		cJSON_Delete(root_obj);
-		cJSON_Delete(state_obj);
-		cJSON_Delete(reported_obj);
-		cJSON_Delete(device_obj);
-		return -EAGAIN;
+	output->buf = json_writer_alloc_print(device_status_write, &ctx,
+					      &output->len);
+	if (output->buf == NULL) {
+		output->len = 0;
+		return -ENOMEM;
 	}
 
-	char *buffer;
-
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
-
-	output->buf = buffer;
-	output->len = strlen(buffer);
-
 	return 0;
 }
 
@@ -693,6 +650,18 @@ static int cloud_decode_modem_params(cJSON *const data_obj,
 			-ESRCH : 0);
 }
 
+static void cloud_cmd_validate_interval(struct cloud_command *const cmd)
+{
+	if ((cmd->type == CLOUD_CMD_INTERVAL) &&
+	    (cmd->data.sv.state == CLOUD_CMD_STATE_UNDEFINED)) {
+		if (cmd->data.sv.value == DISABLE_SEND_INTERVAL_VAL) {
+			cmd->data.sv.state = CLOUD_CMD_STATE_FALSE;
+		} else if (cmd->data.sv.value < MIN_INTERVAL_VAL_SECONDS) {
+			cmd->data.sv.value = MIN_INTERVAL_VAL_SECONDS;
+		}
+	}
+}
+
 static int cloud_cmd_parse_type(const struct cmd *const type_cmd,
 				cJSON *type_obj,
 				struct cloud_command *const parsed_cmd)
@@ -785,18 +754,8 @@ static int cloud_cmd_parse_type(const struct cmd *const type_cmd,
 		return -EINVAL;
 	}
 
-	/* Validate interval value */
-	if ((type_cmd->type == CLOUD_CMD_INTERVAL) &&
-	    (parsed_cmd->data.sv.state == CLOUD_CMD_STATE_UNDEFINED)) {
-		if (parsed_cmd->data.sv.value == DISABLE_SEND_INTERVAL_VAL) {
-			parsed_cmd->data.sv.state = CLOUD_CMD_STATE_FALSE;
-		} else if (parsed_cmd->data.sv.value <
-				   MIN_INTERVAL_VAL_SECONDS) {
-			parsed_cmd->data.sv.value = MIN_INTERVAL_VAL_SECONDS;
-		}
-	}
-
 	parsed_cmd->type = type_cmd->type;
+	cloud_cmd_validate_interval(parsed_cmd);
 
 	return 0;
 }
@@ -958,7 +917,55 @@ static int cloud_search_config(cJSON * const root_obj)
 	return 0;
 }
 
-int cloud_decode_command(char const *input)
+int cloud_codec_cmd_dispatch(struct cloud_command *cmd)
+{
+	const struct cmd *group = NULL;
+	const struct cmd *chan = NULL;
+	const struct cmd *type = NULL;
+
+	for (size_t i = 0; i < ARRAY_SIZE(cmd_groups); ++i) {
+		if (cmd_groups[i]->group == cmd->group) {
+			group = cmd_groups[i];
+			break;
+		}
+	}
+
+	for (size_t j = 0; group && (j < group->num_children); ++j) {
+		if (group->children[j].channel == cmd->channel) {
+			chan = &group->children[j];
+			break;
+		}
+	}
+
+	for (size_t k = 0; chan && (k < chan->num_children); ++k) {
+		if (chan->children[k].type == cmd->type) {
+			type = &chan->children[k];
+			break;
+		}
+	}
+
+	if (type == NULL) {
+		return -ENOTSUP;
+	}
+
+	cloud_cmd_validate_interval(cmd);
+
+	LOG_INF("[%s:%d] Found cmd %s, %s, %s\n", __func__, __LINE__,
+		log_strdup(cmd_group_str[cmd->group]),
+		log_strdup(channel_type_str[cmd->channel]),
+		log_strdup(cmd_type_str[cmd->type]));
+
+	/* Handle cfg commands */
+	(void)cloud_cmd_handle_sensor_set_chan_cfg(cmd);
+
+	if (cloud_command_cb) {
+		cloud_command_cb(cmd);
+	}
+
+	return 0;
+}
+
+int cloud_decode_command(char const *input, size_t len)
 {
 	cJSON *root_obj = NULL;
 
@@ -966,9 +973,16 @@ int cloud_decode_command(char const *input)
 		return -EINVAL;
 	}
 
+	if (IS_ENABLED(CONFIG_CLOUD_CODEC_CBOR)) {
+		return cloud_cbor_decode_command((const uint8_t *)input, len);
+	}
+
+	cJSON_ArenaBegin();
+
 	root_obj = cJSON_Parse(input);
 	if (root_obj == NULL) {
 		LOG_DBG("[%s:%d] Unable to parse input", __func__, __LINE__);
+		cJSON_ArenaEnd();
 		return -ENOENT;
 	}
 
@@ -977,6 +991,7 @@ int cloud_decode_command(char const *input)
 	cloud_search_config(root_obj);
 
 	cJSON_Delete(root_obj);
+	cJSON_ArenaEnd();
 
 	return 0;
 }
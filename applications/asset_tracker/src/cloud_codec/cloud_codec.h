@@ -209,10 +209,12 @@ int cloud_encode_data(const struct cloud_channel_data *channel,
  * @brief Decode cloud data.
  *
  * @param input Pointer to the cloud data input.
+ * @param len Length of the input. Only used by the CBOR codec, JSON input
+ *	      must be null-terminated.
  *
  * @return 0 if the operation was successful, otherwise a (negative) error code.
  */
-int cloud_decode_command(char const *input);
+int cloud_decode_command(char const *input, size_t len);
 
 /**
  * @brief Init the cloud decoder.
@@ -0,0 +1,771 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <stdlib.h>
+#include <tinycbor/cbor.h>
+#include <tinycbor/cbor_buf_reader.h>
+#include <tinycbor/cbor_buf_writer.h>
+#if defined(CONFIG_MODEM_INFO)
+#include <modem/modem_info.h>
+#endif
+#include <date_time.h>
+
+#include "cloud_codec.h"
+#include "cloud_codec_cbor.h"
+
+#include <logging/log.h>
+LOG_MODULE_REGISTER(cloud_codec_cbor, CONFIG_ASSET_TRACKER_LOG_LEVEL);
+
+/* Maximum encoded lengths of the CBOR data items: the initial byte, followed
+ * by the argument. Keys and container lengths are below 24, and fit in the
+ * initial byte.
+ */
+#define CBOR_SMALL_LEN		1
+#define CBOR_INT32_MAX_LEN	5
+#define CBOR_INT64_MAX_LEN	9
+#define CBOR_FLOAT_LEN		5
+
+/* Upper bound of a data message without its data: the map, its four keys,
+ * the channel, the group and the timestamp.
+ */
+#define DATA_MSG_OVERHEAD	(5 * CBOR_SMALL_LEN + 2 * CBOR_INT32_MAX_LEN + \
+				 CBOR_INT64_MAX_LEN)
+#define STR_DATA_MSG_LEN(len)	(DATA_MSG_OVERHEAD + CBOR_INT32_MAX_LEN + (len))
+#define FLOAT_DATA_MSG_LEN	(DATA_MSG_OVERHEAD + CBOR_FLOAT_LEN)
+#define UINT_DATA_MSG_LEN	(DATA_MSG_OVERHEAD + CBOR_INT32_MAX_LEN)
+#define LIGHT_DATA_MSG_LEN	(DATA_MSG_OVERHEAD + CBOR_SMALL_LEN + \
+				 4 * CBOR_INT32_MAX_LEN)
+
+typedef CborError (*msg_encode_t)(CborEncoder *enc, const void *ctx);
+
+struct data_msg {
+	enum cloud_channel channel;
+	enum cloud_cmd_group group;
+	int64_t ts;
+	const void *data;
+};
+
+/* Encode a message into a heap buffer that is released with
+ * cloud_release_data().
+ */
+static int msg_encode(msg_encode_t encode, const void *ctx, size_t size,
+		      struct cloud_msg *output)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder enc;
+	uint8_t *buf;
+
+	buf = k_malloc(size);
+	if (buf == NULL) {
+		return -ENOMEM;
+	}
+
+	cbor_buf_writer_init(&writer, buf, size);
+	cbor_encoder_init(&enc, &writer.enc, 0);
+
+	if (encode(&enc, ctx) != CborNoError) {
+		k_free(buf);
+		return -ENOMEM;
+	}
+
+	output->buf = (char *)buf;
+	output->len = writer.ptr - buf;
+
+	return 0;
+}
+
+static int64_t unix_ts_get(int64_t uptime)
+{
+	int64_t ts = uptime;
+	int err;
+
+	/* If the conversion fails, an empty timestamp is encoded. */
+	err = date_time_uptime_to_unix_time_ms(&ts);
+	if (err) {
+		LOG_WRN("date_time_uptime_to_unix_time_ms, error: %d", err);
+		date_time_timestamp_clear(&ts);
+	}
+
+	return ts;
+}
+
+/* Encode the keys common to the data messages, the data is encoded by the
+ * caller after this.
+ */
+static CborError data_msg_start(CborEncoder *enc, CborEncoder *map,
+				const struct data_msg *msg)
+{
+	CborError err;
+
+	err = cbor_encoder_create_map(enc, map, 4);
+	err |= cbor_encode_uint(map, CLOUD_CBOR_KEY_CHANNEL);
+	err |= cbor_encode_uint(map, msg->channel);
+	err |= cbor_encode_uint(map, CLOUD_CBOR_KEY_GROUP);
+	err |= cbor_encode_uint(map, msg->group);
+	err |= cbor_encode_uint(map, CLOUD_CBOR_KEY_TS);
+	err |= cbor_encode_int(map, msg->ts);
+	err |= cbor_encode_uint(map, CLOUD_CBOR_KEY_DATA);
+
+	return err;
+}
+
+static CborError str_data_encode(CborEncoder *enc, const void *ctx)
+{
+	const struct data_msg *msg = ctx;
+	const struct cloud_data *data = msg->data;
+	CborEncoder map;
+	CborError err;
+
+	err = data_msg_start(enc, &map, msg);
+	err |= cbor_encode_text_string(&map, data->buf, strlen(data->buf));
+	err |= cbor_encoder_close_container(enc, &map);
+
+	return err;
+}
+
+static CborError float_data_encode(CborEncoder *enc, const void *ctx)
+{
+	const struct data_msg *msg = ctx;
+	const double *value = msg->data;
+	CborEncoder map;
+	CborError err;
+
+	err = data_msg_start(enc, &map, msg);
+	err |= cbor_encode_float(&map, (float)*value);
+	err |= cbor_encoder_close_container(enc, &map);
+
+	return err;
+}
+
+static CborError uint_data_encode(CborEncoder *enc, const void *ctx)
+{
+	const struct data_msg *msg = ctx;
+	const uint32_t *value = msg->data;
+	CborEncoder map;
+	CborError err;
+
+	err = data_msg_start(enc, &map, msg);
+	err |= cbor_encode_uint(&map, *value);
+	err |= cbor_encoder_close_container(enc, &map);
+
+	return err;
+}
+
+int cloud_cbor_encode_data(const struct cloud_channel_data *channel,
+			   const enum cloud_cmd_group group,
+			   struct cloud_msg *output)
+{
+	struct data_msg msg;
+
+	if (channel == NULL || channel->data.buf == NULL ||
+	    channel->data.len == 0 || output == NULL ||
+	    group >= CLOUD_CMD_GROUP__TOTAL) {
+		return -EINVAL;
+	}
+
+	msg.channel = channel->type;
+	msg.group = group;
+	msg.ts = unix_ts_get(channel->ts);
+	msg.data = &channel->data;
+
+	return msg_encode(str_data_encode, &msg,
+			  STR_DATA_MSG_LEN(strlen(channel->data.buf)), output);
+}
+
+int cloud_cbor_encode_env_sensors_data(const env_sensor_data_t *sensor_data,
+				       struct cloud_msg *output)
+{
+	__ASSERT_NO_MSG(sensor_data != NULL);
+	__ASSERT_NO_MSG(output != NULL);
+
+	struct data_msg msg = {
+		.group = CLOUD_CMD_GROUP_DATA,
+		.ts = unix_ts_get(sensor_data->ts),
+		.data = &sensor_data->value,
+	};
+
+	switch (sensor_data->type) {
+	case ENV_SENSOR_TEMPERATURE:
+		msg.channel = CLOUD_CHANNEL_TEMP;
+		break;
+
+	case ENV_SENSOR_HUMIDITY:
+		msg.channel = CLOUD_CHANNEL_HUMID;
+		break;
+
+	case ENV_SENSOR_AIR_PRESSURE:
+		msg.channel = CLOUD_CHANNEL_AIR_PRESS;
+		break;
+
+	case ENV_SENSOR_AIR_QUALITY:
+		msg.channel = CLOUD_CHANNEL_AIR_QUAL;
+		break;
+
+	default:
+		return -1;
+	}
+
+	return msg_encode(float_data_encode, &msg, FLOAT_DATA_MSG_LEN, output);
+}
+
+int cloud_cbor_encode_motion_data(const motion_data_t *motion_data,
+				  struct cloud_msg *output)
+{
+	__ASSERT_NO_MSG(motion_data != NULL);
+	__ASSERT_NO_MSG(output != NULL);
+
+	uint32_t orientation = motion_data->orientation;
+	struct data_msg msg = {
+		.channel = CLOUD_CHANNEL_FLIP,
+		.group = CLOUD_CMD_GROUP_DATA,
+		.data = &orientation,
+	};
+
+	if ((motion_data->orientation != MOTION_ORIENTATION_NORMAL) &&
+	    (motion_data->orientation != MOTION_ORIENTATION_UPSIDE_DOWN)) {
+		return -1;
+	}
+
+	msg.ts = unix_ts_get(motion_data->ts);
+
+	return msg_encode(uint_data_encode, &msg, UINT_DATA_MSG_LEN, output);
+}
+
+#if CONFIG_LIGHT_SENSOR
+#define LIGHT_SENSOR_DATA_NO_UPDATE (-1)
+
+static CborError light_data_encode(CborEncoder *enc, const void *ctx)
+{
+	const struct data_msg *msg = ctx;
+	const struct light_sensor_data *data = msg->data;
+	CborEncoder map, arr;
+	CborError err;
+
+	err = data_msg_start(enc, &map, msg);
+	err |= cbor_encoder_create_array(&map, &arr, 4);
+	err |= cbor_encode_int(&arr, data->red);
+	err |= cbor_encode_int(&arr, data->green);
+	err |= cbor_encode_int(&arr, data->blue);
+	err |= cbor_encode_int(&arr, data->ir);
+	err |= cbor_encoder_close_container(&map, &arr);
+	err |= cbor_encoder_close_container(enc, &map);
+
+	return err;
+}
+
+int cloud_cbor_encode_light_sensor_data(
+	const struct light_sensor_data *sensor_data,
+	struct cloud_msg *output)
+{
+	struct light_sensor_data send = {
+		.red = LIGHT_SENSOR_DATA_NO_UPDATE,
+		.green = LIGHT_SENSOR_DATA_NO_UPDATE,
+		.blue = LIGHT_SENSOR_DATA_NO_UPDATE,
+		.ir = LIGHT_SENSOR_DATA_NO_UPDATE,
+	};
+	struct data_msg msg = {
+		.channel = CLOUD_CHANNEL_LIGHT_SENSOR,
+		.group = CLOUD_CMD_GROUP_DATA,
+		.data = &send,
+	};
+
+	if ((sensor_data == NULL) || (output == NULL)) {
+		return -EINVAL;
+	}
+
+	if (cloud_is_send_allowed(CLOUD_CHANNEL_LIGHT_RED, sensor_data->red)) {
+		send.red = sensor_data->red;
+	}
+
+	if (cloud_is_send_allowed(CLOUD_CHANNEL_LIGHT_GREEN,
+				  sensor_data->green)) {
+		send.green = sensor_data->green;
+	}
+
+	if (cloud_is_send_allowed(CLOUD_CHANNEL_LIGHT_BLUE,
+				  sensor_data->blue)) {
+		send.blue = sensor_data->blue;
+	}
+
+	if (cloud_is_send_allowed(CLOUD_CHANNEL_LIGHT_IR, sensor_data->ir)) {
+		send.ir = sensor_data->ir;
+	}
+
+	msg.ts = unix_ts_get(sensor_data->ts);
+
+	return msg_encode(light_data_encode, &msg, LIGHT_DATA_MSG_LEN, output);
+}
+#endif /* CONFIG_LIGHT_SENSOR */
+
+#if defined(CONFIG_MODEM_INFO)
+static CborError modem_param_encode(CborEncoder *map,
+				    const struct lte_param *param)
+{
+	CborError err;
+
+	err = cbor_encode_int(map, param->type);
+
+	if ((modem_info_type_get(param->type) == AT_PARAM_TYPE_STRING) &&
+	    (param->type != MODEM_INFO_AREA_CODE)) {
+		err |= cbor_encode_text_stringz(map, param->value_string);
+	} else {
+		err |= cbor_encode_uint(map, param->value);
+	}
+
+	return err;
+}
+
+static CborError network_encode(CborEncoder *map,
+				const struct network_param *network)
+{
+	CborEncoder obj;
+	CborError err;
+	uint32_t mode = 0;
+
+	err = cbor_encode_uint(map, CLOUD_CBOR_DEVICE_NETWORK);
+	err |= cbor_encoder_create_map(map, &obj, CborIndefiniteLength);
+	err |= modem_param_encode(&obj, &network->current_band);
+	err |= modem_param_encode(&obj, &network->sup_band);
+	err |= modem_param_encode(&obj, &network->area_code);
+	err |= modem_param_encode(&obj, &network->current_operator);
+	err |= modem_param_encode(&obj, &network->ip_address);
+	err |= modem_param_encode(&obj, &network->ue_mode);
+	err |= cbor_encode_int(&obj, network->cellid_hex.type);
+	err |= cbor_encode_uint(&obj, network->cellid_dec);
+
+	/* The network mode is encoded as a bit field instead of a string:
+	 * bit 0 for LTE-M, bit 1 for NB-IoT and bit 2 for GPS.
+	 */
+	if (network->lte_mode.value == 1) {
+		mode |= BIT(0);
+	} else if (network->nbiot_mode.value == 1) {
+		mode |= BIT(1);
+	}
+
+	if (network->gps_mode.value == 1) {
+		mode |= BIT(2);
+	}
+
+	err |= cbor_encode_int(&obj, CLOUD_CBOR_MODEM_NETWORK_MODE);
+	err |= cbor_encode_uint(&obj, mode);
+	err |= cbor_encoder_close_container(map, &obj);
+
+	return err;
+}
+
+static CborError sim_encode(CborEncoder *map, const struct sim_param *sim)
+{
+	CborEncoder obj;
+	CborError err;
+
+	err = cbor_encode_uint(map, CLOUD_CBOR_DEVICE_SIM);
+	err |= cbor_encoder_create_map(map, &obj, 3);
+	err |= modem_param_encode(&obj, &sim->uicc);
+	err |= modem_param_encode(&obj, &sim->iccid);
+	err |= modem_param_encode(&obj, &sim->imsi);
+	err |= cbor_encoder_close_container(map, &obj);
+
+	return err;
+}
+
+static CborError device_info_encode(CborEncoder *map,
+				    const struct device_param *device)
+{
+	CborEncoder obj;
+	CborError err;
+
+	err = cbor_encode_uint(map, CLOUD_CBOR_DEVICE_INFO);
+	err |= cbor_encoder_create_map(map, &obj, 6);
+	err |= modem_param_encode(&obj, &device->modem_fw);
+	err |= modem_param_encode(&obj, &device->battery);
+	err |= modem_param_encode(&obj, &device->imei);
+	err |= cbor_encode_int(&obj, CLOUD_CBOR_MODEM_BOARD);
+	err |= cbor_encode_text_stringz(&obj, device->board);
+	err |= cbor_encode_int(&obj, CLOUD_CBOR_MODEM_APP_VERSION);
+	err |= cbor_encode_text_stringz(&obj, device->app_version);
+	err |= cbor_encode_int(&obj, CLOUD_CBOR_MODEM_APP_NAME);
+	err |= cbor_encode_text_stringz(&obj, device->app_name);
+	err |= cbor_encoder_close_container(map, &obj);
+
+	return err;
+}
+
+static CborError modem_info_encode(CborEncoder *map,
+				   const struct modem_param_info *modem)
+{
+	CborError err = CborNoError;
+
+	if (IS_ENABLED(CONFIG_MODEM_INFO_ADD_NETWORK)) {
+		err |= network_encode(map, &modem->network);
+	}
+
+	if (IS_ENABLED(CONFIG_MODEM_INFO_ADD_SIM)) {
+		err |= sim_encode(map, &modem->sim);
+	}
+
+	if (IS_ENABLED(CONFIG_MODEM_INFO_ADD_DEVICE)) {
+		err |= device_info_encode(map, &modem->device);
+	}
+
+	return err;
+}
+#endif /* CONFIG_MODEM_INFO */
+
+struct device_status {
+	void *modem_param;
+	const char *const *ui;
+	uint32_t ui_count;
+	const char *const *fota;
+	uint32_t fota_count;
+	uint16_t fota_version;
+};
+
+static CborError str_array_encode(CborEncoder *map, uint32_t key,
+				  const char *const items[], uint32_t count)
+{
+	CborEncoder arr;
+	CborError err;
+
+	err = cbor_encode_uint(map, key);
+	err |= cbor_encoder_create_array(map, &arr, CborIndefiniteLength);
+
+	for (uint32_t i = 0; i < count; i++) {
+		if (items[i] != NULL) {
+			err |= cbor_encode_text_stringz(&arr, items[i]);
+		}
+	}
+
+	err |= cbor_encoder_close_container(map, &arr);
+
+	return err;
+}
+
+static CborError device_status_encode(CborEncoder *enc, const void *ctx)
+{
+	const struct device_status *status = ctx;
+	CborEncoder root, map;
+	CborError err;
+
+	err = cbor_encoder_create_map(enc, &root, 1);
+	err |= cbor_encode_uint(&root, CLOUD_CBOR_KEY_DEVICE);
+	err |= cbor_encoder_create_map(&root, &map, CborIndefiniteLength);
+
+#if defined(CONFIG_MODEM_INFO)
+	if (status->modem_param) {
+		err |= modem_info_encode(&map, status->modem_param);
+	}
+#endif
+
+	err |= str_array_encode(&map, CLOUD_CBOR_DEVICE_UI, status->ui,
+				status->ui_count);
+	err |= str_array_encode(&map, CLOUD_CBOR_DEVICE_FOTA, status->fota,
+				status->fota_count);
+	err |= cbor_encode_uint(&map, CLOUD_CBOR_DEVICE_FOTA_VERSION);
+	err |= cbor_encode_uint(&map, status->fota_version);
+
+	err |= cbor_encoder_close_container(&root, &map);
+	err |= cbor_encoder_close_container(enc, &root);
+
+	return err;
+}
+
+int cloud_cbor_encode_device_status_data(
+	void *modem_param,
+	const char *const ui[], const uint32_t ui_count,
+	const char *const fota[], const uint32_t fota_count,
+	const uint16_t fota_version,
+	struct cloud_msg *output)
+{
+	__ASSERT_NO_MSG((ui != NULL) || !ui_count);
+	__ASSERT_NO_MSG((fota != NULL) || !fota_count);
+	__ASSERT_NO_MSG(output != NULL);
+
+	struct device_status status = {
+		.modem_param = modem_param,
+		.ui = ui,
+		.ui_count = ui_count,
+		.fota = fota,
+		.fota_count = fota_count,
+		.fota_version = fota_version,
+	};
+
+	return msg_encode(device_status_encode, &status,
+			  CONFIG_CLOUD_CODEC_CBOR_MSG_MAX_LEN, output);
+}
+
+static CborError config_encode(CborEncoder *enc, const void *ctx)
+{
+	const enum cloud_cmd_state *gps_state = ctx;
+	CborEncoder root, config, chan;
+	CborError err;
+
+	err = cbor_encoder_create_map(enc, &root, 1);
+	err |= cbor_encode_uint(&root, CLOUD_CBOR_KEY_CONFIG);
+	err |= cbor_encoder_create_map(&root, &config, 1);
+	err |= cbor_encode_uint(&config, CLOUD_CHANNEL_GPS);
+	err |= cbor_encoder_create_map(&config, &chan, 1);
+	err |= cbor_encode_uint(&chan, CLOUD_CMD_ENABLE);
+	err |= cbor_encode_boolean(&chan, *gps_state == CLOUD_CMD_STATE_TRUE);
+	err |= cbor_encoder_close_container(&config, &chan);
+	err |= cbor_encoder_close_container(&root, &config);
+	err |= cbor_encoder_close_container(enc, &root);
+
+	return err;
+}
+
+int cloud_cbor_encode_config_data(struct cloud_msg *output)
+{
+	__ASSERT_NO_MSG(output != NULL);
+
+	/* Currently, the only value that can be changed from
+	 * the device is GPS enable, so it is the only
+	 * one that needs to be sent.
+	 */
+	enum cloud_cmd_state gps_state =
+		cloud_get_channel_enable_state(CLOUD_CHANNEL_GPS);
+
+	output->buf = NULL;
+	output->len = 0;
+
+	if (gps_state == CLOUD_CMD_STATE_UNDEFINED) {
+		return 0;
+	}
+
+	return msg_encode(config_encode, &gps_state, DATA_MSG_OVERHEAD,
+			  output);
+}
+
+static int number_get(CborValue *value, double *num)
+{
+	int64_t i;
+	float f;
+
+	if (cbor_value_is_integer(value)) {
+		if (cbor_value_get_int64(value, &i) != CborNoError) {
+			return -ESRCH;
+		}
+		*num = i;
+	} else if (cbor_value_is_float(value)) {
+		if (cbor_value_get_float(value, &f) != CborNoError) {
+			return -ESRCH;
+		}
+		*num = f;
+	} else if (cbor_value_is_double(value)) {
+		if (cbor_value_get_double(value, num) != CborNoError) {
+			return -ESRCH;
+		}
+	} else {
+		return -ESRCH;
+	}
+
+	return 0;
+}
+
+/* Parse a command value and dispatch the command. Strings are allocated
+ * and released after the dispatch.
+ */
+static int cmd_value_dispatch(CborValue *value, struct cloud_command *cmd)
+{
+	char *str = NULL;
+	size_t len;
+	bool state;
+	int err;
+
+	switch (cmd->type) {
+	case CLOUD_CMD_ENABLE:
+		if (cbor_value_is_null(value)) {
+			cmd->data.sv.state = CLOUD_CMD_STATE_FALSE;
+		} else if (cbor_value_is_boolean(value)) {
+			cbor_value_get_boolean(value, &state);
+			cmd->data.sv.state = state ? CLOUD_CMD_STATE_TRUE :
+						     CLOUD_CMD_STATE_FALSE;
+		} else {
+			return -ESRCH;
+		}
+		break;
+	case CLOUD_CMD_INTERVAL:
+	case CLOUD_CMD_THRESHOLD_LOW:
+	case CLOUD_CMD_THRESHOLD_HIGH:
+		if (cbor_value_is_null(value)) {
+			cmd->data.sv.state = CLOUD_CMD_STATE_FALSE;
+		} else {
+			cmd->data.sv.state = CLOUD_CMD_STATE_UNDEFINED;
+			err = number_get(value, &cmd->data.sv.value);
+			if (err) {
+				return err;
+			}
+		}
+		break;
+	case CLOUD_CMD_COLOR:
+		err = number_get(value, &cmd->data.sv.value);
+		if (err) {
+			return err;
+		}
+		break;
+	case CLOUD_CMD_DATA_STRING:
+		if (!cbor_value_is_text_string(value) ||
+		    (cbor_value_dup_text_string(value, &str, &len, NULL) !=
+		     CborNoError)) {
+			return -ESRCH;
+		}
+		cmd->data.data_string = str;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	err = cloud_codec_cmd_dispatch(cmd);
+
+	/* Allocated by tinycbor with malloc(). */
+	free(str);
+
+	return err;
+}
+
+/* Dispatch a map from command type to value. */
+static int cmd_map_dispatch(CborValue *map, enum cloud_cmd_group group,
+			    enum cloud_channel channel)
+{
+	CborValue it;
+	uint64_t type;
+
+	if (!cbor_value_is_map(map) ||
+	    (cbor_value_enter_container(map, &it) != CborNoError)) {
+		return -EINVAL;
+	}
+
+	while (!cbor_value_at_end(&it)) {
+		struct cloud_command cmd = {
+			.group = group,
+			.channel = channel,
+		};
+		int err;
+
+		if (!cbor_value_is_unsigned_integer(&it) ||
+		    (cbor_value_get_uint64(&it, &type) != CborNoError) ||
+		    (cbor_value_advance_fixed(&it) != CborNoError)) {
+			return -EINVAL;
+		}
+
+		cmd.type = type;
+		err = cmd_value_dispatch(&it, &cmd);
+		if (err) {
+			LOG_ERR("Unhandled cmd format for group %d, "
+				"channel %d, type %d, error %d",
+				group, channel, cmd.type, err);
+		}
+
+		if (cbor_value_advance(&it) != CborNoError) {
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int config_dispatch(CborValue *config)
+{
+	CborValue it;
+	uint64_t channel;
+	int err;
+
+	if (!cbor_value_is_map(config) ||
+	    (cbor_value_enter_container(config, &it) != CborNoError)) {
+		return -EINVAL;
+	}
+
+	while (!cbor_value_at_end(&it)) {
+		if (!cbor_value_is_unsigned_integer(&it) ||
+		    (cbor_value_get_uint64(&it, &channel) != CborNoError) ||
+		    (cbor_value_advance_fixed(&it) != CborNoError)) {
+			return -EINVAL;
+		}
+
+		err = cmd_map_dispatch(&it, CLOUD_CMD_GROUP_CFG_SET, channel);
+		if (err) {
+			return err;
+		}
+
+		if (cbor_value_advance(&it) != CborNoError) {
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+int cloud_cbor_decode_command(const uint8_t *input, size_t len)
+{
+	struct cbor_buf_reader reader;
+	CborParser parser;
+	CborValue root, it;
+	CborValue data, config;
+	bool has_data = false, has_config = false;
+	uint64_t key, group = 0, channel = 0;
+
+	if (input == NULL) {
+		return -EINVAL;
+	}
+
+	cbor_buf_reader_init(&reader, input, len);
+
+	if ((cbor_parser_init(&reader.r, 0, &parser, &root) != CborNoError) ||
+	    !cbor_value_is_map(&root) ||
+	    (cbor_value_enter_container(&root, &it) != CborNoError)) {
+		LOG_DBG("Unable to parse input");
+		return -ENOENT;
+	}
+
+	/* Find the command and the configuration in the root map. */
+	while (!cbor_value_at_end(&it)) {
+		if (!cbor_value_is_unsigned_integer(&it) ||
+		    (cbor_value_get_uint64(&it, &key) != CborNoError) ||
+		    (cbor_value_advance_fixed(&it) != CborNoError)) {
+			return -ENOENT;
+		}
+
+		switch (key) {
+		case CLOUD_CBOR_KEY_GROUP:
+			if (!cbor_value_is_unsigned_integer(&it)) {
+				return -ENOENT;
+			}
+			cbor_value_get_uint64(&it, &group);
+			break;
+		case CLOUD_CBOR_KEY_CHANNEL:
+			if (!cbor_value_is_unsigned_integer(&it)) {
+				return -ENOENT;
+			}
+			cbor_value_get_uint64(&it, &channel);
+			break;
+		case CLOUD_CBOR_KEY_DATA:
+			data = it;
+			has_data = true;
+			break;
+		case CLOUD_CBOR_KEY_CONFIG:
+			config = it;
+			has_config = true;
+			break;
+		default:
+			break;
+		}
+
+		if (cbor_value_advance(&it) != CborNoError) {
+			return -ENOENT;
+		}
+	}
+
+	if (has_data) {
+		(void)cmd_map_dispatch(&data, group, channel);
+	}
+
+	if (has_config) {
+		(void)config_dispatch(&config);
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef CLOUD_CODEC_CBOR_H__
+#define CLOUD_CODEC_CBOR_H__
+
+#include <zephyr.h>
+#include "cloud_codec.h"
+
+/**
+ * @file cloud_codec_cbor.h
+ *
+ * @brief CBOR backend of the cloud codec.
+ * @defgroup cloud_codec_cbor CBOR backend of the cloud codec.
+ * @{
+ *
+ * @details The messages are CBOR maps with integer keys. Channels, groups
+ *	    and command types are encoded with the values of
+ *	    @ref cloud_channel, @ref cloud_cmd_group and @ref cloud_cmd_type.
+ *
+ *	    Data messages have the @ref CLOUD_CBOR_KEY_CHANNEL,
+ *	    @ref CLOUD_CBOR_KEY_DATA, @ref CLOUD_CBOR_KEY_GROUP and
+ *	    @ref CLOUD_CBOR_KEY_TS keys. The data is a float for the
+ *	    environment sensors, the orientation for the FLIP channel, an
+ *	    array of red, green, blue and IR levels for the light sensor and
+ *	    a text string otherwise.
+ *
+ *	    Incoming commands have the same keys, and the data is a map from
+ *	    command type to value. Configuration is a map from channel to a
+ *	    map from command type to value, under @ref CLOUD_CBOR_KEY_CONFIG.
+ */
+
+/** @brief Keys of the CBOR messages. */
+enum cloud_cbor_key {
+	/** Channel, an unsigned integer. */
+	CLOUD_CBOR_KEY_CHANNEL,
+	/** Channel data or command values. */
+	CLOUD_CBOR_KEY_DATA,
+	/** Group, an unsigned integer. */
+	CLOUD_CBOR_KEY_GROUP,
+	/** Timestamp, in UNIX time milliseconds. */
+	CLOUD_CBOR_KEY_TS,
+	/** Channel configuration. */
+	CLOUD_CBOR_KEY_CONFIG,
+	/** Device status. */
+	CLOUD_CBOR_KEY_DEVICE,
+};
+
+/** @brief Keys of the device status map. */
+enum cloud_cbor_device_key {
+	/** Network information, a map keyed by @ref modem_info. */
+	CLOUD_CBOR_DEVICE_NETWORK,
+	/** SIM information, a map keyed by @ref modem_info. */
+	CLOUD_CBOR_DEVICE_SIM,
+	/** Device information, a map keyed by @ref modem_info. */
+	CLOUD_CBOR_DEVICE_INFO,
+	/** Array of UI service strings. */
+	CLOUD_CBOR_DEVICE_UI,
+	/** Array of FOTA service strings. */
+	CLOUD_CBOR_DEVICE_FOTA,
+	/** FOTA service version. */
+	CLOUD_CBOR_DEVICE_FOTA_VERSION,
+};
+
+/** @brief Keys of the modem information that have no @ref modem_info
+ *	   value.
+ */
+enum cloud_cbor_modem_key {
+	CLOUD_CBOR_MODEM_NETWORK_MODE = -1,
+	CLOUD_CBOR_MODEM_BOARD = -2,
+	CLOUD_CBOR_MODEM_APP_VERSION = -3,
+	CLOUD_CBOR_MODEM_APP_NAME = -4,
+};
+
+int cloud_cbor_encode_data(const struct cloud_channel_data *channel,
+			   const enum cloud_cmd_group group,
+			   struct cloud_msg *output);
+
+int cloud_cbor_encode_env_sensors_data(const env_sensor_data_t *sensor_data,
+				       struct cloud_msg *output);
+
+int cloud_cbor_encode_motion_data(const motion_data_t *motion_data,
+				  struct cloud_msg *output);
+
+#if CONFIG_LIGHT_SENSOR
+int cloud_cbor_encode_light_sensor_data(
+	const struct light_sensor_data *sensor_data,
+	struct cloud_msg *output);
+#endif /* CONFIG_LIGHT_SENSOR */
+
+int cloud_cbor_encode_device_status_data(
+	void *modem_param,
+	const char *const ui[], const uint32_t ui_count,
+	const char *const fota[], const uint32_t fota_count,
+	const uint16_t fota_version,
+	struct cloud_msg *output);
+
+int cloud_cbor_encode_config_data(struct cloud_msg *output);
+
+int cloud_cbor_decode_command(const uint8_t *input, size_t len);
+
+/**
+ * @brief Pass a decoded command to the configuration handler and to the
+ *	  application.
+ *
+ * @details Implemented by the cloud codec for the backends.
+ *
+ * @param cmd Decoded command.
+ *
+ * @return 0 if the command was handled, or -ENOTSUP if the command is not
+ *	   supported.
+ */
+int cloud_codec_cmd_dispatch(struct cloud_command *cmd);
+
+/** @} */
+
+#endif /* CLOUD_CODEC_CBOR_H__ */
@@ -11,78 +11,55 @@
 #define FOTAS_JSON_NAME "fota_v"
 #define FOTAS_JSON_NAME_SIZE (sizeof(FOTAS_JSON_NAME) + 5)
 
-static int add_array_obj(const char * const items[], const uint32_t item_cnt,
-			 const char * const item_name, cJSON * const obj)
+static void add_array_obj(const char * const items[], const uint32_t item_cnt,
+			  const char * const item_name, struct json_writer *w)
 {
-	cJSON *obj_to_add = NULL;
-	cJSON *str = NULL;
+	uint32_t str_cnt = 0;
 
-	if ((obj == NULL) || (item_name == NULL)) {
-		return -EINVAL;
+	for (uint32_t cnt = 0; cnt < item_cnt; ++cnt) {
+		if (items[cnt] != NULL) {
+			++str_cnt;
+		}
 	}
 
-	obj_to_add = cJSON_CreateArray();
-	if (obj_to_add == NULL) {
-		return -ENOMEM;
+	/* if no strings are added, use NULL object */
+	if (str_cnt == 0) {
+		json_writer_null(w, item_name);
+		return;
 	}
 
+	json_writer_arr_start(w, item_name);
+
 	for (uint32_t cnt = 0; cnt < item_cnt; ++cnt) {
 		if (items[cnt] != NULL) {
-			str = cJSON_CreateString(items[cnt]);
-			if (str == NULL) {
-				cJSON_Delete(obj_to_add);
-				return -ENOMEM;
-			}
-			cJSON_AddItemToArray(obj_to_add, str);
+			json_writer_str(w, NULL, items[cnt]);
 		}
 	}
 
-	/* if no strings were added, use NULL object */
-	if (cJSON_GetArraySize(obj_to_add) == 0) {
-		obj_to_add->type = cJSON_NULL;
-	}
-
-	cJSON_AddItemToObject(obj, item_name, obj_to_add);
-
-	return 0;
+	json_writer_arr_end(w);
 }
 
-int service_info_json_object_encode(
+int service_info_json_object_write(
 	const char * const ui[], const uint32_t ui_count, const char * const fota[],
-	const uint32_t fota_count, const uint16_t fota_version, cJSON * const obj_out)
+	const uint32_t fota_count, const uint16_t fota_version,
+	struct json_writer *w)
 {
-	int err = 0;
-	cJSON *service_info_obj = NULL;
 	char fota_name[FOTAS_JSON_NAME_SIZE];
 
-	if ((obj_out == NULL) || ((ui == NULL) && ui_count) ||
+	if ((w == NULL) || ((ui == NULL) && ui_count) ||
 	    ((fota == NULL) && fota_count)) {
 		return -EINVAL;
 	}
 
-	service_info_obj = cJSON_CreateObject();
-	if (service_info_obj == NULL) {
-		return -ENOMEM;
-	}
+	json_writer_obj_start(w, SERVICE_INFO_JSON_NAME);
 
-	if (!err) {
-		err = add_array_obj(ui, ui_count, UI_JSON_NAME,
-				    service_info_obj);
-	}
+	add_array_obj(ui, ui_count, UI_JSON_NAME, w);
 
-	if (!err) {
-		snprintf(fota_name, sizeof(fota_name), "%s%hu", FOTAS_JSON_NAME,
-			 fota_version);
-		err = add_array_obj(fota, fota_count, fota_name,
-				    service_info_obj);
-	}
+	snprintf(fota_name, sizeof(fota_name), "%s%hu", FOTAS_JSON_NAME,
+		 fota_version);
+	add_array_obj(fota, fota_count, fota_name, w);
 
-	if (!err) {
-		cJSON_AddItemToObject(obj_out, SERVICE_INFO_JSON_NAME,
-				      service_info_obj);
-	} else {
-		cJSON_Delete(service_info_obj);
-	}
+	json_writer_obj_end(w);
 
-	return err;
+	return 0;
 }
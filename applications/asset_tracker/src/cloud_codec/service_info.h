@@ -8,7 +8,7 @@
 #define SERVICE_INFO_H__
 
 #include <zephyr.h>
-#include <cJSON.h>
+#include <json_writer.h>
 
 /**
  * @file service_info.h
@@ -24,24 +24,25 @@
 
 /** @brief Encode the service info to JSON.
  *
- * Service info is written to the JSON object.
+ * Service info is written as a member of the object that is currently open
+ * in the JSON writer.
  *
  * @param ui Array of UI strings.
  * @param ui_count Number of ui strings in the array.
  * @param fota Array of FOTA strings.
  * @param fota_count Number of FOTA strings in the array.
  * @param fota_version FOTA version number.
- * @param obj_out The JSON object where the data is stored.
+ * @param w The JSON writer.
  *
  * @return 0 If the operation was successful.
  *           Otherwise, a (negative) error code is returned.
  */
-int service_info_json_object_encode(const char *const ui[],
-				    const uint32_t ui_count,
-				    const char *const fota[],
-					const uint32_t fota_count,
-					const uint16_t fota_version,
-					cJSON *obj_out);
+int service_info_json_object_write(const char *const ui[],
+				   const uint32_t ui_count,
+				   const char *const fota[],
+				   const uint32_t fota_count,
+				   const uint16_t fota_version,
+				   struct json_writer *w);
 
 /** @} */
 
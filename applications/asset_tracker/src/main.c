@@ -22,6 +22,9 @@
 #include <net/cloud.h>
 #include <net/socket.h>
 #include <net/nrf_cloud.h>
+#if defined(CONFIG_CLOUD_OUTBOX)
+#include <net/cloud_outbox.h>
+#endif
 #if defined(CONFIG_NRF_CLOUD_AGPS)
 #include <net/nrf_cloud_agps.h>
 #endif
@@ -209,6 +212,8 @@ static void device_status_send(struct k_work *work);
 static void cycle_cloud_connection(struct k_work *work);
 static void set_gps_enable(const bool enable);
 static bool data_send_enabled(void);
+static bool data_store_enabled(void);
+static int data_msg_send(struct cloud_msg *msg);
 static void connection_evt_handler(const struct cloud_event *const evt);
 static void no_sim_go_offline(struct k_work *work);
 
@@ -1151,7 +1156,7 @@ static void env_data_send(void)
 		.endpoint.type = CLOUD_EP_MSG
 	};
 
-	if (!data_send_enabled()) {
+	if (!data_store_enabled()) {
 		return;
 	}
 
@@ -1165,7 +1170,7 @@ static void env_data_send(void)
 	if (env_sensors_get_temperature(&env_data) == 0) {
 		if (cloud_is_send_allowed(CLOUD_CHANNEL_TEMP, env_data.value) &&
 		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
+			err = data_msg_send(&msg);
 			cloud_release_data(&msg);
 			if (err) {
 				goto error;
@@ -1177,7 +1182,7 @@ static void env_data_send(void)
 		if (cloud_is_send_allowed(CLOUD_CHANNEL_HUMID,
 					  env_data.value) &&
 		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
+			err = data_msg_send(&msg);
 			cloud_release_data(&msg);
 			if (err) {
 				goto error;
@@ -1189,7 +1194,7 @@ static void env_data_send(void)
 		if (cloud_is_send_allowed(CLOUD_CHANNEL_AIR_PRESS,
 					  env_data.value) &&
 		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
+			err = data_msg_send(&msg);
 			cloud_release_data(&msg);
 			if (err) {
 				goto error;
@@ -1201,7 +1206,7 @@ static void env_data_send(void)
 		if (cloud_is_send_allowed(CLOUD_CHANNEL_AIR_QUAL,
 					  env_data.value) &&
 		    cloud_encode_env_sensors_data(&env_data, &msg) == 0) {
-			err = cloud_send(cloud_backend, &msg);
+			err = data_msg_send(&msg);
 			cloud_release_data(&msg);
 			if (err) {
 				goto error;
@@ -1269,7 +1274,7 @@ static void sensor_data_send(struct cloud_channel_data *data)
 			.endpoint.type = CLOUD_EP_MSG
 		};
 
-	if (!data_send_enabled() || gps_control_is_active()) {
+	if (!data_store_enabled() || gps_control_is_active()) {
 		return;
 	}
 
@@ -1277,7 +1282,7 @@ static void sensor_data_send(struct cloud_channel_data *data)
 	if (err) {
 		LOG_ERR("Unable to encode cloud data: %d", err);
 	} else {
-		err = cloud_send(cloud_backend, &msg);
+		err = data_msg_send(&msg);
 		cloud_release_data(&msg);
 		if (err) {
 			LOG_ERR("%s failed, data was not sent: %d", __func__,
@@ -1298,6 +1303,25 @@ static bool data_send_enabled(void)
 		   CLOUD_ASSOCIATION_STATE_READY);
 }
 
+/**@brief Check if sensor data should be encoded and handed over for sending.
+ *        With the cloud outbox, data is stored while the link is down and
+ *        sent when the connection is ready again.
+ */
+static bool data_store_enabled(void)
+{
+	return IS_ENABLED(CONFIG_CLOUD_OUTBOX) || data_send_enabled();
+}
+
+/**@brief Send a sensor data message, through the outbox if enabled. */
+static int data_msg_send(struct cloud_msg *msg)
+{
+#if defined(CONFIG_CLOUD_OUTBOX)
+	return cloud_outbox_send(msg);
+#else
+	return cloud_send(cloud_backend, msg);
+#endif
+}
+
 /**@brief Callback for sensor attached event from nRF Cloud. */
 void sensors_start(void)
 {
@@ -1394,6 +1418,10 @@ void cloud_event_handler(const struct cloud_backend *const backend,
 {
 	ARG_UNUSED(user_data);
 
+#if defined(CONFIG_CLOUD_OUTBOX)
+	cloud_outbox_event_notify(evt);
+#endif
+
 	switch (evt->type) {
 	case CLOUD_EVT_CONNECTED:
 	case CLOUD_EVT_CONNECTING:
@@ -1421,7 +1449,8 @@ void cloud_event_handler(const struct cloud_backend *const backend,
 		int err;
 
 		LOG_INF("CLOUD_EVT_DATA_RECEIVED");
-		err = cloud_decode_command(evt->data.msg.buf);
+		err = cloud_decode_command(evt->data.msg.buf,
+					   evt->data.msg.len);
 		if (err == 0) {
 			/* Cloud decoder has handled the data */
 			return;
@@ -1606,8 +1635,9 @@ static void cloud_api_init(void)
 {
 	int ret;
 
-	cloud_backend = cloud_get_binding("NRF_CLOUD");
-	__ASSERT(cloud_backend != NULL, "nRF Cloud backend not found");
+	cloud_backend = cloud_get_binding(CONFIG_CLOUD_BACKEND);
+	__ASSERT(cloud_backend != NULL, "%s backend not found",
+		 CONFIG_CLOUD_BACKEND);
 
 	ret = cloud_init(cloud_backend, cloud_event_handler);
 	if (ret) {
@@ -1616,6 +1646,15 @@ static void cloud_api_init(void)
 		cloud_error_handler(ret);
 	}
 
+#if defined(CONFIG_CLOUD_OUTBOX)
+	ret = cloud_outbox_init(cloud_backend);
+	if (ret) {
+		LOG_ERR("Cloud outbox could not be initialized, error: %d",
+			ret);
+		cloud_error_handler(ret);
+	}
+#endif
+
 	ret = cloud_decode_init(cloud_cmd_handler);
 	if (ret) {
 		LOG_ERR("Cloud command decoder could not be initialized, error: %d",
@@ -15,6 +15,8 @@
 
 #include <string.h>
 #include <toolchain/common.h>
+#include <sys/atomic.h>
+#include <sys/__assert.h>
 
 #include "event_manager.h"
 
@@ -22,14 +24,43 @@
 extern "C" {
 #endif
 
-/** Peer connection event. */
+/** Reference counted buffer holding data received over BLE.
+ *  Subscribers that need the data after the event has been processed
+ *  take a reference instead of copying it.
+ */
+struct ble_data_buf {
+	atomic_t ref_counter;
+	/* Called by the owner when the last reference is dropped. */
+	void (*release)(struct ble_data_buf *buf);
+	uint8_t data[];
+};
+
+/** BLE data event. */
 struct ble_data_event {
 	struct event_header header;
 
+	struct ble_data_buf *owner;
 	uint8_t *buf;
 	size_t len;
 };
 
+static inline void ble_data_buf_ref(struct ble_data_buf *buf)
+{
+	__ASSERT_NO_MSG(buf);
+
+	atomic_inc(&buf->ref_counter);
+}
+
+static inline void ble_data_buf_unref(struct ble_data_buf *buf)
+{
+	__ASSERT_NO_MSG(buf);
+
+	/* atomic_dec returns the value prior to decrement */
+	if (atomic_dec(&buf->ref_counter) == 1) {
+		buf->release(buf);
+	}
+}
+
 EVENT_TYPE_DECLARE(ble_data_event);
 
 #ifdef __cplusplus
@@ -20,14 +20,11 @@
 #include "ble_ctrl_event.h"
 #include "ble_data_event.h"
 #include "uart_data_event.h"
+#include "ble_rx_buf.h"
 
 #include <logging/log.h>
 LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_BLE_LOG_LEVEL);
 
-#define BLE_RX_BLOCK_SIZE (CONFIG_BT_L2CAP_TX_MTU - 3)
-#define BLE_RX_BUF_COUNT 4
-#define BLE_SLAB_ALIGNMENT 4
-
 #define BLE_TX_BUF_SIZE (CONFIG_BRIDGE_BUF_SIZE * 2)
 
 #define BLE_AD_IDX_FLAGS 0
@@ -37,7 +34,6 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_BLE_LOG_LEVEL);
 
 static void bt_send_work_handler(struct k_work *work);
 
-K_MEM_SLAB_DEFINE(ble_rx_slab, BLE_RX_BLOCK_SIZE, BLE_RX_BUF_COUNT, BLE_SLAB_ALIGNMENT);
 RING_BUF_DECLARE(ble_tx_ring_buf, BLE_TX_BUF_SIZE);
 
 static K_SEM_DEFINE(ble_tx_sem, 0, 1);
@@ -157,35 +153,41 @@ static void bt_send_work_handler(struct k_work *work)
 	}
 }
 
-static void bt_receive_cb(struct bt_conn *conn, const uint8_t *const data,
-			  uint16_t len)
+static void ble_rx_buf_submit(struct ble_data_buf *buf, size_t len)
 {
-	void *buf;
-	uint16_t remainder;
+	struct ble_data_event *event = new_ble_data_event();
 
-	remainder = len;
-
-	do {
-		uint16_t copy_len;
-		int err;
+	event->owner = buf;
+	event->buf = buf->data;
+	event->len = len;
+	EVENT_SUBMIT(event);
+}
 
-		err = k_mem_slab_alloc(&ble_rx_slab, &buf, K_NO_WAIT);
-		if (err) {
-			LOG_WRN("BLE RX overflow");
-			break;
-		}
+static bool bt_rx_ready_cb(struct bt_conn *conn, uint16_t len)
+{
+	/* RX blocks act as credits. Subscribers hold a reference until the
+	 * data has been forwarded. When there are not enough free blocks, the
+	 * write is refused without blocking the Bluetooth RX thread: a write
+	 * request is rejected, and the peer can retry it.
+	 */
+	if (!ble_rx_buf_accept(len)) {
+		LOG_DBG("BLE RX buffers full, %d bytes refused", len);
+		return false;
+	}
 
-		copy_len = remainder > BLE_RX_BLOCK_SIZE ?
-			BLE_RX_BLOCK_SIZE : remainder;
-		remainder -= copy_len;
-		memcpy(buf, data, copy_len);
+	return true;
+}
 
-		struct ble_data_event *event = new_ble_data_event();
+static void bt_receive_cb(struct bt_conn *conn, const uint8_t *const data,
+			  uint16_t len)
+{
+	struct ble_rx_buf_stats stats;
 
-		event->buf = buf;
-		event->len = copy_len;
-		EVENT_SUBMIT(event);
-	} while (remainder);
+	if (ble_rx_buf_put(data, len, ble_rx_buf_submit)) {
+		ble_rx_buf_stats_get(&stats);
+		LOG_WRN("BLE RX overflow, %u bytes dropped in total",
+			stats.dropped_bytes);
+	}
 }
 
 static void bt_sent_cb(struct bt_conn *conn)
@@ -199,6 +201,7 @@ static void bt_sent_cb(struct bt_conn *conn)
 
 static struct bt_nus_cb nus_cb = {
 	.received = bt_receive_cb,
+	.rx_ready = bt_rx_ready_cb,
 	.sent = bt_sent_cb,
 };
 
@@ -322,8 +325,8 @@ static bool event_handler(const struct event_header *eh)
 		const struct ble_data_event *event =
 			cast_ble_data_event(eh);
 
-		/* All subscribers have gotten a chance to copy data at this point */
-		k_mem_slab_free(&ble_rx_slab, (void **) &event->buf);
+		/* All subscribers have gotten a chance to take a reference */
+		ble_data_buf_unref(event->owner);
 
 		return false;
 	}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+
+#include "ble_rx_buf.h"
+
+#define BLE_SLAB_ALIGNMENT __alignof__(struct ble_data_buf)
+#define BLE_RX_BLOCK_SIZE \
+	ROUND_UP(sizeof(struct ble_data_buf) + BLE_RX_DATA_SIZE, BLE_SLAB_ALIGNMENT)
+#define BLE_RX_BUF_COUNT CONFIG_BRIDGE_BLE_RX_BUF_COUNT
+
+K_MEM_SLAB_DEFINE(ble_rx_slab, BLE_RX_BLOCK_SIZE, BLE_RX_BUF_COUNT, BLE_SLAB_ALIGNMENT);
+
+static atomic_t dropped_writes;
+static atomic_t dropped_bytes;
+
+static void ble_rx_buf_release(struct ble_data_buf *buf)
+{
+	k_mem_slab_free(&ble_rx_slab, (void **)&buf);
+}
+
+static void drop_count(uint16_t len)
+{
+	atomic_inc(&dropped_writes);
+	atomic_add(&dropped_bytes, len);
+}
+
+bool ble_rx_buf_accept(uint16_t len)
+{
+	/* Blocks are only allocated by the caller, so the free blocks can
+	 * only grow until the data is put.
+	 */
+	if (ble_rx_buf_credits() * BLE_RX_DATA_SIZE < len) {
+		drop_count(len);
+		return false;
+	}
+
+	return true;
+}
+
+int ble_rx_buf_put(const uint8_t *data, uint16_t len,
+		   ble_rx_buf_submit_t submit)
+{
+	struct ble_data_buf *buf;
+	const uint8_t *pos = data;
+	uint16_t remainder = len;
+
+	while (remainder) {
+		uint16_t copy_len;
+
+		if (k_mem_slab_alloc(&ble_rx_slab, (void **)&buf, K_NO_WAIT)) {
+			drop_count(remainder);
+			return -ENOBUFS;
+		}
+
+		atomic_set(&buf->ref_counter, 1);
+		buf->release = ble_rx_buf_release;
+
+		copy_len = MIN(remainder, BLE_RX_DATA_SIZE);
+		memcpy(buf->data, pos, copy_len);
+		remainder -= copy_len;
+		pos += copy_len;
+
+		submit(buf, copy_len);
+	}
+
+	return 0;
+}
+
+uint32_t ble_rx_buf_credits(void)
+{
+	return k_mem_slab_num_free_get(&ble_rx_slab);
+}
+
+void ble_rx_buf_stats_get(struct ble_rx_buf_stats *stats)
+{
+	stats->dropped_writes = atomic_get(&dropped_writes);
+	stats->dropped_bytes = atomic_get(&dropped_bytes);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _BLE_RX_BUF_H_
+#define _BLE_RX_BUF_H_
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+#include "ble_data_event.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the data held by an RX block, one ATT payload. */
+#define BLE_RX_DATA_SIZE (CONFIG_BT_L2CAP_TX_MTU - 3)
+
+/** Handler for a filled RX block. The block is passed with one reference,
+ *  which is dropped with ble_data_buf_unref() when the data has been used.
+ */
+typedef void (*ble_rx_buf_submit_t)(struct ble_data_buf *buf, size_t len);
+
+/** Statistics of the data received over BLE. */
+struct ble_rx_buf_stats {
+	/** Writes refused because no RX blocks were free. */
+	uint32_t dropped_writes;
+	/** Bytes of the refused writes. */
+	uint32_t dropped_bytes;
+};
+
+/** Check whether there are free RX blocks, which act as credits, for a
+ *  write of the given length. If not, the write is counted as dropped.
+ *  Must be called from the thread that puts the data.
+ */
+bool ble_rx_buf_accept(uint16_t len);
+
+/** Copy received data into RX blocks and submit them, without waiting.
+ *
+ * @retval 0 If all data was submitted.
+ * @retval -ENOBUFS If the RX blocks ran out. The remaining data is counted
+ *		    as dropped.
+ */
+int ble_rx_buf_put(const uint8_t *data, uint16_t len,
+		   ble_rx_buf_submit_t submit);
+
+/** Number of free RX blocks. */
+uint32_t ble_rx_buf_credits(void);
+
+/** Get the statistics of the data received over BLE. */
+void ble_rx_buf_stats_get(struct ble_rx_buf_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLE_RX_BUF_H_ */
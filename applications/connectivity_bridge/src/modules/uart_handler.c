@@ -25,6 +25,12 @@ LOG_MODULE_REGISTER(MODULE, CONFIG_BRIDGE_UART_LOG_LEVEL);
 #define UART_SLAB_ALIGNMENT 4
 #define UART_RX_TIMEOUT_MS 1
 
+#if CONFIG_BRIDGE_BLE_ENABLE
+#define UART_TX_REF_COUNT CONFIG_BRIDGE_BLE_RX_BUF_COUNT
+#else
+#define UART_TX_REF_COUNT 1
+#endif
+
 #if (defined(CONFIG_DEVICE_POWER_MANAGEMENT) &&\
 	defined(CONFIG_SYS_PM_POLICY_APP))
 #define UART_SET_PM_STATE true
@@ -58,15 +64,33 @@ struct uart_rx_buf {
 	uint8_t buf[UART_BUF_SIZE];
 };
 
+struct uart_tx_ref {
+	struct ble_data_buf *owner;
+	uint8_t *buf;
+	size_t len;
+};
+
+enum uart_tx_src {
+	UART_TX_SRC_NONE,
+	UART_TX_SRC_RING,
+	UART_TX_SRC_REF,
+};
+
 struct uart_tx_buf {
 	struct ring_buf rb;
 	uint32_t buf[UART_BUF_SIZE];
+	/* Reference counted buffers, sent without copying */
+	struct k_msgq ref_q;
+	struct uart_tx_ref refs[UART_TX_REF_COUNT];
+	/* Source of the ongoing transfer */
+	enum uart_tx_src src;
 };
 
 BUILD_ASSERT((sizeof(struct uart_rx_buf) % UART_SLAB_ALIGNMENT) == 0);
 
 /* Blocks from the same slab is used for RX for all UART instances */
 /* TX has inidividual ringbuffers per UART instance */
+/* Data received over BLE is sent directly from the BLE RX buffers */
 
 K_MEM_SLAB_DEFINE(uart_rx_slab, UART_SLAB_BLOCK_SIZE, UART_SLAB_BLOCK_COUNT, UART_SLAB_ALIGNMENT);
 
@@ -83,6 +107,7 @@ static void disable_uart_rx(uint8_t dev_idx);
 static void set_uart_power_state(uint8_t dev_idx, bool active);
 static int uart_tx_start(uint8_t dev_idx);
 static void uart_tx_finish(uint8_t dev_idx, size_t len);
+static bool uart_tx_is_empty(uint8_t dev_idx);
 
 static inline struct uart_rx_buf *block_start_get(uint8_t *buf)
 {
@@ -184,7 +209,7 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 	case UART_TX_DONE:
 		uart_tx_finish(dev_idx, evt->data.tx.len);
 
-		if (ring_buf_is_empty(&uart_tx_ringbufs[dev_idx].rb)) {
+		if (uart_tx_is_empty(dev_idx)) {
 			atomic_set(&uart_tx_started[dev_idx], false);
 		} else {
 			uart_tx_start(dev_idx);
@@ -309,16 +334,31 @@ static void disable_uart_rx(uint8_t dev_idx)
 	}
 }
 
+static bool uart_tx_is_empty(uint8_t dev_idx)
+{
+	return ring_buf_is_empty(&uart_tx_ringbufs[dev_idx].rb) &&
+	       (k_msgq_num_used_get(&uart_tx_ringbufs[dev_idx].ref_q) == 0);
+}
+
 static int uart_tx_start(uint8_t dev_idx)
 {
+	struct uart_tx_buf *tx = &uart_tx_ringbufs[dev_idx];
+	struct uart_tx_ref ref;
 	int len;
 	int err;
 	uint8_t *buf;
 
-	len = ring_buf_get_claim(
-			&uart_tx_ringbufs[dev_idx].rb,
-			&buf,
-			sizeof(uart_tx_ringbufs[dev_idx].buf));
+	if (!ring_buf_is_empty(&tx->rb)) {
+		len = ring_buf_get_claim(&tx->rb, &buf, sizeof(tx->buf));
+		tx->src = UART_TX_SRC_RING;
+	} else if (k_msgq_peek(&tx->ref_q, &ref) == 0) {
+		buf = ref.buf;
+		len = ref.len;
+		tx->src = UART_TX_SRC_REF;
+	} else {
+		tx->src = UART_TX_SRC_NONE;
+		return -ENODATA;
+	}
 
 	err = uart_tx(devices[dev_idx], buf, len, 0);
 	if (err) {
@@ -332,25 +372,35 @@ static int uart_tx_start(uint8_t dev_idx)
 
 static void uart_tx_finish(uint8_t dev_idx, size_t len)
 {
+	struct uart_tx_buf *tx = &uart_tx_ringbufs[dev_idx];
+	struct uart_tx_ref ref;
 	int err;
 
-	err = ring_buf_get_finish(&uart_tx_ringbufs[dev_idx].rb, len);
-	if (err) {
-		LOG_ERR("ring_buf_get_finish: %d", err);
+	switch (tx->src) {
+	case UART_TX_SRC_RING:
+		err = ring_buf_get_finish(&tx->rb, len);
+		if (err) {
+			LOG_ERR("ring_buf_get_finish: %d", err);
+		}
+		break;
+	case UART_TX_SRC_REF:
+		/* The buffer is released also if the transfer failed */
+		if (k_msgq_get(&tx->ref_q, &ref, K_NO_WAIT) == 0) {
+			ble_data_buf_unref(ref.owner);
+		}
+		break;
+	default:
+		break;
 	}
+
+	tx->src = UART_TX_SRC_NONE;
 }
 
-static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
+static void uart_tx_kick(uint8_t dev_idx)
 {
 	atomic_t started;
-	uint32_t written;
 	int err;
 
-	written = ring_buf_put(&uart_tx_ringbufs[dev_idx].rb, data, data_len);
-	if (written == 0) {
-		return -ENOMEM;
-	}
-
 	started = atomic_set(&uart_tx_started[dev_idx], true);
 	if (!started) {
 		err = uart_tx_start(dev_idx);
@@ -359,6 +409,18 @@ static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
 			atomic_set(&uart_tx_started[dev_idx], false);
 		}
 	}
+}
+
+static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
+{
+	uint32_t written;
+
+	written = ring_buf_put(&uart_tx_ringbufs[dev_idx].rb, data, data_len);
+	if (written == 0) {
+		return -ENOMEM;
+	}
+
+	uart_tx_kick(dev_idx);
 
 	if (written == data_len) {
 		return 0;
@@ -369,6 +431,30 @@ static int uart_tx_enqueue(uint8_t *data, size_t data_len, uint8_t dev_idx)
 	return 0;
 }
 
+static int uart_tx_enqueue_ref(struct ble_data_buf *owner, uint8_t *data,
+			       size_t data_len, uint8_t dev_idx)
+{
+	struct uart_tx_ref ref = {
+		.owner = owner,
+		.buf = data,
+		.len = data_len,
+	};
+	int err;
+
+	/* The reference is dropped when the transfer is done */
+	ble_data_buf_ref(owner);
+
+	err = k_msgq_put(&uart_tx_ringbufs[dev_idx].ref_q, &ref, K_NO_WAIT);
+	if (err) {
+		ble_data_buf_unref(owner);
+		return -ENOMEM;
+	}
+
+	uart_tx_kick(dev_idx);
+
+	return 0;
+}
+
 static bool event_handler(const struct event_header *eh)
 {
 	int err;
@@ -417,7 +503,8 @@ static bool event_handler(const struct event_header *eh)
 			return false;
 		}
 
-		err = uart_tx_enqueue(event->buf, event->len, dev_idx);
+		err = uart_tx_enqueue_ref(event->owner, event->buf, event->len,
+					  dev_idx);
 		if (err == -ENOMEM) {
 			LOG_WRN("BLE->UART_%d overflow", dev_idx);
 		} else if (err) {
@@ -500,6 +587,13 @@ static bool event_handler(const struct event_header *eh)
 					sizeof(uart_tx_ringbufs[i].buf),
 					uart_tx_ringbufs[i].buf);
 
+				k_msgq_init(
+					&uart_tx_ringbufs[i].ref_q,
+					(char *)uart_tx_ringbufs[i].refs,
+					sizeof(struct uart_tx_ref),
+					ARRAY_SIZE(uart_tx_ringbufs[i].refs));
+				uart_tx_ringbufs[i].src = UART_TX_SRC_NONE;
+
 				if (UART_SET_PM_STATE) {
 					set_uart_power_state(i, false);
 				}
@@ -6,6 +6,8 @@
 
 #include <stdlib.h>
 #include <bluetooth/bluetooth.h>
+#include <bluetooth/gatt_dm.h>
+#include <bluetooth/services/hogp.h>
 #include <shell/shell.h>
 #include <settings/settings.h>
 
@@ -250,10 +252,28 @@ static void swap_bt_stack_peer_id(void)
 	}
 }
 
+static void remove_peer_cache(const struct bt_bond_info *info,
+			      void *user_data)
+{
+	int err = bt_hogp_cache_delete(&info->addr);
+
+	if (err) {
+		LOG_WRN("Cannot remove cached HID layout (err %d)", err);
+	}
+
+	bt_gatt_dm_cache_clear(&info->addr);
+}
+
 static int remove_peers(uint8_t identity)
 {
 	LOG_INF("Remove peers on identity %u", identity);
 
+	/* Data cached for the peers is only valid while they are bonded. */
+	if (IS_ENABLED(CONFIG_BT_CENTRAL)) {
+		bt_foreach_bond(get_bt_stack_peer_id(identity),
+				remove_peer_cache, NULL);
+	}
+
 	int err = bt_unpair(get_bt_stack_peer_id(identity), BT_ADDR_LE_ANY);
 	if (err) {
 		LOG_ERR("Failed to remove");
@@ -16,6 +16,8 @@
 
 #include "hid_report_desc.h"
 #include "config_channel_transport.h"
+#include "drr.h"
+#include "hid_mouse_coalesce.h"
 
 #include "hid_event.h"
 #include "ble_event.h"
@@ -27,6 +29,7 @@
 LOG_MODULE_REGISTER(MODULE, CONFIG_DESKTOP_HID_FORWARD_LOG_LEVEL);
 
 #define MAX_ENQUEUED_ITEMS CONFIG_DESKTOP_HID_FORWARD_MAX_ENQUEUED_REPORTS
+#define DRR_QUANTUM CONFIG_DESKTOP_HID_FORWARD_DRR_QUANTUM
 #define CFG_CHAN_RSP_READ_DELAY		K_MSEC(15)
 #define CFG_CHAN_MAX_RSP_POLL_CNT	50
 #define CFG_CHAN_UNUSED_PEER_ID		UINT8_MAX
@@ -39,6 +42,7 @@ BUILD_ASSERT(CFG_CHAN_MAX_RSP_POLL_CNT <= UCHAR_MAX);
 struct enqueued_report {
 	sys_snode_t node;
 	struct hid_report_event *report;
+	uint32_t timestamp;
 };
 
 struct counted_list {
@@ -51,17 +55,30 @@ struct enqueued_reports {
 	uint8_t last_idx;
 };
 
+struct forward_stats {
+	uint64_t latency_sum;
+	uint32_t latency_max;
+	uint32_t sent_cnt;
+	uint32_t dropped_cnt;
+	uint32_t coalesced_cnt;
+};
+
+struct hids_peripheral;
+
 struct subscriber {
 	const void *id;
 	uint32_t enabled_reports_bm;
 	struct enqueued_reports enqueued_reports;
 	bool busy;
 	uint8_t last_peripheral_id;
+	struct hids_peripheral *sent_per;
+	uint32_t sent_timestamp;
 };
 
 struct hids_peripheral {
 	struct bt_hogp hogp;
 	struct enqueued_reports enqueued_reports;
+	struct forward_stats stats;
 
 	struct k_delayed_work read_rsp;
 	struct config_event *cfg_chan_rsp;
@@ -74,7 +91,21 @@ struct hids_peripheral {
 static struct subscriber subscribers[CONFIG_USB_HID_DEVICE_COUNT];
 static bt_addr_le_t peripheral_address[CONFIG_BT_MAX_PAIRED];
 static struct hids_peripheral peripherals[CONFIG_BT_MAX_CONN];
+static size_t peripheral_deficit[CONFIG_BT_MAX_CONN];
 static bool suspended;
+static uint8_t stats_peer_id = CFG_CHAN_UNUSED_PEER_ID;
+
+enum hid_forward_opt {
+	HID_FORWARD_OPT_PEER_SELECT,
+	HID_FORWARD_OPT_PEER_STATS,
+
+	HID_FORWARD_OPT_COUNT
+};
+
+static const char * const opt_descr[] = {
+	[HID_FORWARD_OPT_PEER_SELECT] = "peer_select",
+	[HID_FORWARD_OPT_PEER_STATS] = "peer_stats",
+};
 
 
 #if CONFIG_USB_HID_DEVICE_COUNT > 1
@@ -244,25 +275,49 @@ static void init_enqueued_reports(struct enqueued_reports *enqueued_reports)
 	enqueued_reports->last_idx = 0;
 }
 
-static struct enqueued_report *get_next_enqueued_report(struct enqueued_reports *enqueued_reports)
+static int get_next_enqueued_report_idx(struct enqueued_reports *enqueued_reports)
 {
-	struct enqueued_report *item = NULL;
-
 	for (size_t i = 0; i < ARRAY_SIZE(enqueued_reports->reports); i++) {
 		size_t irep_idx = next_id(enqueued_reports->last_idx + i,
 					  ARRAY_SIZE(enqueued_reports->reports));
 
 		if (is_report_enqueued(enqueued_reports, irep_idx)) {
-			item = get_enqueued_report(enqueued_reports, irep_idx);
-
-			enqueued_reports->last_idx = irep_idx;
-			break;
+			return irep_idx;
 		}
 	}
 
+	return -ENOENT;
+}
+
+static struct enqueued_report *peek_next_enqueued_report(struct enqueued_reports *enqueued_reports)
+{
+	int irep_idx = get_next_enqueued_report_idx(enqueued_reports);
+
+	if (irep_idx < 0) {
+		return NULL;
+	}
+
+	struct enqueued_report *item;
+	sys_snode_t *node = sys_slist_peek_head(&enqueued_reports->reports[irep_idx].list);
+
+	item = CONTAINER_OF(node, __typeof__(*item), node);
+
 	return item;
 }
 
+static struct enqueued_report *get_next_enqueued_report(struct enqueued_reports *enqueued_reports)
+{
+	int irep_idx = get_next_enqueued_report_idx(enqueued_reports);
+
+	if (irep_idx < 0) {
+		return NULL;
+	}
+
+	enqueued_reports->last_idx = irep_idx;
+
+	return get_enqueued_report(enqueued_reports, irep_idx);
+}
+
 static void migrate_enqueued_reports(struct enqueued_reports *dst_reports,
 				     struct enqueued_reports *src_reports)
 {
@@ -305,15 +360,17 @@ static void migrate_enqueued_reports(struct enqueued_reports *dst_reports,
 	}
 }
 
-static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
+static bool enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 			       size_t irep_idx,
-			       struct hid_report_event *report)
+			       struct hid_report_event *report,
+			       uint32_t timestamp)
 {
 	__ASSERT_NO_MSG(irep_idx < ARRAY_SIZE(enqueued_reports->reports));
 
 	struct counted_list *reports = &enqueued_reports->reports[irep_idx];
 
 	struct enqueued_report *item;
+	bool dropped = false;
 
 	if (reports->count < MAX_ENQUEUED_ITEMS) {
 		item = k_malloc(sizeof(*item));
@@ -321,17 +378,75 @@ static void enqueue_hid_report(struct enqueued_reports *enqueued_reports,
 		LOG_WRN("Enqueue dropped the oldest report");
 		item = get_enqueued_report(enqueued_reports, irep_idx);
 		k_free(item->report);
+		dropped = true;
 	}
 
 	if (!item) {
 		LOG_ERR("Dropped HID report");
 		/* Should never happen. */
 		__ASSERT_NO_MSG(false);
+		dropped = true;
 	} else {
 		item->report = report;
+		item->timestamp = timestamp;
 		sys_slist_append(&reports->list, &item->node);
 		reports->count++;
 	}
+
+	return dropped;
+}
+
+static bool coalesce_mouse_report(struct enqueued_reports *enqueued_reports,
+				  size_t irep_idx, const uint8_t *data,
+				  size_t size)
+{
+	struct counted_list *reports = &enqueued_reports->reports[irep_idx];
+	sys_snode_t *node = sys_slist_peek_tail(&reports->list);
+
+	if (!node || (size != REPORT_SIZE_MOUSE)) {
+		return false;
+	}
+
+	struct enqueued_report *item = CONTAINER_OF(node, __typeof__(*item),
+						    node);
+
+	__ASSERT_NO_MSG(item->report->dyndata.data[0] == REPORT_ID_MOUSE);
+
+	if (item->report->dyndata.size != size + sizeof(uint8_t)) {
+		return false;
+	}
+
+	return hid_mouse_coalesce(&item->report->dyndata.data[1], data);
+}
+
+static void report_submitted(struct subscriber *sub,
+			     struct hids_peripheral *per,
+			     uint32_t timestamp)
+{
+	sub->busy = true;
+	sub->sent_per = per;
+	sub->sent_timestamp = timestamp;
+}
+
+static void report_sent(struct subscriber *sub)
+{
+	struct hids_peripheral *per = sub->sent_per;
+
+	sub->busy = false;
+
+	/* Report enqueued by a peripheral that was disconnected. */
+	if (!per) {
+		return;
+	}
+
+	struct forward_stats *stats = &per->stats;
+	uint32_t latency = k_cycle_get_32() - sub->sent_timestamp;
+
+	stats->latency_sum += latency;
+	stats->latency_max = MAX(stats->latency_max, latency);
+	stats->sent_cnt++;
+
+	sub->sent_per = NULL;
 }
 
 static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
@@ -362,6 +477,15 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 		return;
 	}
 
+	uint32_t timestamp = k_cycle_get_32();
+
+	if (IS_ENABLED(CONFIG_DESKTOP_HID_FORWARD_MOUSE_COALESCE) &&
+	    (report_id == REPORT_ID_MOUSE) && sub->busy &&
+	    coalesce_mouse_report(&per->enqueued_reports, irep_idx, data, size)) {
+		per->stats.coalesced_cnt++;
+		return;
+	}
+
 	struct hid_report_event *report = new_hid_report_event(size + sizeof(report_id));
 
 	report->subscriber = sub->id;
@@ -375,9 +499,10 @@ static void forward_hid_report(struct hids_peripheral *per, uint8_t report_id,
 
 		EVENT_SUBMIT(report);
 		per->enqueued_reports.last_idx = irep_idx;
-		sub->busy = true;
-	} else {
-		enqueue_hid_report(&per->enqueued_reports, irep_idx, report);
+		report_submitted(sub, per, timestamp);
+	} else if (enqueue_hid_report(&per->enqueued_reports, irep_idx,
+				      report, timestamp)) {
+		per->stats.dropped_cnt++;
 	}
 }
 
@@ -471,13 +596,14 @@ static int register_peripheral(struct bt_gatt_dm *dm, const uint8_t *hwid,
 	}
 
 	per->sub_id = sub_id;
+	peripheral_deficit[per - peripherals] = 0;
+	memset(&per->stats, 0, sizeof(per->stats));
 
 	/* Migrate part of the unsent reports to this peripheral.
 	 * This is needed to make sure that at any time number of
 	 * allocated reports is within configured bounds.
 	 */
 	__ASSERT_NO_MSG(!is_any_report_enqueued(&per->enqueued_reports));
-	ARG_UNUSED(is_any_report_enqueued);
 	migrate_enqueued_reports(&per->enqueued_reports,
 				 &get_subscriber(per)->enqueued_reports);
 
@@ -753,6 +879,11 @@ static bool handle_config_event(struct config_event *event)
 		return true;
 	}
 
+	/* Local requests are handled by the module's option handlers. */
+	if (event->recipient == CFG_CHAN_RECIPIENT_LOCAL) {
+		return false;
+	}
+
 	struct hids_peripheral *per = find_peripheral(event->recipient);
 
 	if (!per) {
@@ -874,10 +1005,17 @@ static void disconnect_peripheral(struct hids_peripheral *per)
 		}
 	}
 
-	migrate_enqueued_reports(&get_subscriber(per)->enqueued_reports,
+	struct subscriber *sub = get_subscriber(per);
+
+	migrate_enqueued_reports(&sub->enqueued_reports,
 				 &per->enqueued_reports);
 	__ASSERT_NO_MSG(!is_any_report_enqueued(&per->enqueued_reports));
 
+	if (sub->sent_per == per) {
+		sub->sent_per = NULL;
+	}
+	peripheral_deficit[per - peripherals] = 0;
+
 	bt_hogp_release(&per->hogp);
 	k_delayed_work_cancel(&per->read_rsp);
 	memset(per->hwid, 0, sizeof(per->hwid));
@@ -982,6 +1120,43 @@ static void init(void)
 	reset_peripheral_address();
 }
 
+static int peripheral_report_size_get(size_t per_id, void *user_data)
+{
+	const struct subscriber *sub = user_data;
+	struct hids_peripheral *per = &peripherals[per_id];
+
+	/* Only the peripherals linked to the subscriber are served. */
+	if (sub != get_subscriber(per)) {
+		return -ENOENT;
+	}
+
+	struct enqueued_report *item =
+		peek_next_enqueued_report(&per->enqueued_reports);
+
+	return item ? item->report->dyndata.size : 0;
+}
+
+static struct enqueued_report *get_next_peripheral_report(struct subscriber *sub,
+							  struct hids_peripheral **report_per)
+{
+	/* Deficit round-robin keeps the share of the linked peripherals fair
+	 * in bytes, whatever the size of their reports.
+	 */
+	int per_id = drr_next(peripheral_deficit, ARRAY_SIZE(peripherals),
+			      DRR_QUANTUM, &sub->last_peripheral_id,
+			      peripheral_report_size_get, sub);
+
+	if (per_id < 0) {
+		return NULL;
+	}
+
+	struct hids_peripheral *per = &peripherals[per_id];
+
+	*report_per = per;
+
+	return get_next_enqueued_report(&per->enqueued_reports);
+}
+
 static void send_enqueued_report(struct subscriber *sub)
 {
 	if (sub->busy) {
@@ -989,37 +1164,108 @@ static void send_enqueued_report(struct subscriber *sub)
 	}
 
 	struct enqueued_report *item;
+	struct hids_peripheral *per = NULL;
 
 	/* First try to send report left at subscriber. */
 	item = get_next_enqueued_report(&sub->enqueued_reports);
 
 	if (!item) {
 		/* Look for any report to sent at linked peripherals. */
-		for (size_t i = 0; i < ARRAY_SIZE(peripherals); i++) {
-			size_t per_id = next_id(sub->last_peripheral_id + i,
-						ARRAY_SIZE(peripherals));
-			struct hids_peripheral *per = &peripherals[per_id];
+		item = get_next_peripheral_report(sub, &per);
+	}
 
-			/* Check if peripheral is linked with the subscriber. */
-			if (sub != get_subscriber(per)) {
-				continue;
-			}
+	if (item) {
+		EVENT_SUBMIT(item->report);
 
-			item = get_next_enqueued_report(&per->enqueued_reports);
+		report_submitted(sub, per, item->timestamp);
 
-			if (item) {
-				sub->last_peripheral_id = per_id;
-				break;
-			}
+		k_free(item);
+	}
+}
+
+static void config_set(const uint8_t opt_id, const uint8_t *data,
+		       const size_t size)
+{
+	switch (opt_id) {
+	case HID_FORWARD_OPT_PEER_SELECT:
+		if (size != sizeof(stats_peer_id)) {
+			LOG_WRN("Invalid size");
+		} else {
+			stats_peer_id = data[0];
+		}
+		break;
+
+	case HID_FORWARD_OPT_PEER_STATS:
+	{
+		/* Writing the option resets the statistics. */
+		struct hids_peripheral *per = find_peripheral(stats_peer_id);
+
+		if (!per) {
+			LOG_WRN("Peer %" PRIu8 " not found", stats_peer_id);
+		} else {
+			memset(&per->stats, 0, sizeof(per->stats));
 		}
+		break;
 	}
 
-	if (item) {
-		EVENT_SUBMIT(item->report);
+	default:
+		LOG_WRN("Unknown opt %" PRIu8, opt_id);
+		break;
+	}
+}
 
-		k_free(item);
+static void fill_peer_stats(uint8_t *data, size_t *size)
+{
+	const struct hids_peripheral *per = find_peripheral(stats_peer_id);
+
+	if (!per) {
+		LOG_WRN("Peer %" PRIu8 " not found", stats_peer_id);
+		*size = 0;
+		return;
+	}
+
+	const struct forward_stats *stats = &per->stats;
+	uint32_t latency_avg = 0;
+	size_t pos = 0;
 
-		sub->busy = true;
+	if (stats->sent_cnt > 0) {
+		latency_avg = stats->latency_sum / stats->sent_cnt;
+	}
+
+	sys_put_le32(stats->sent_cnt, &data[pos]);
+	pos += sizeof(uint32_t);
+
+	sys_put_le16(MIN(stats->dropped_cnt, UINT16_MAX), &data[pos]);
+	pos += sizeof(uint16_t);
+
+	sys_put_le16(MIN(stats->coalesced_cnt, UINT16_MAX), &data[pos]);
+	pos += sizeof(uint16_t);
+
+	sys_put_le32(k_cyc_to_us_floor32(latency_avg), &data[pos]);
+	pos += sizeof(uint32_t);
+
+	sys_put_le32(k_cyc_to_us_floor32(stats->latency_max), &data[pos]);
+	pos += sizeof(uint32_t);
+
+	__ASSERT_NO_MSG(pos <= CONFIG_CHANNEL_FETCHED_DATA_MAX_SIZE);
+	*size = pos;
+}
+
+static void config_fetch(const uint8_t opt_id, uint8_t *data, size_t *size)
+{
+	switch (opt_id) {
+	case HID_FORWARD_OPT_PEER_SELECT:
+		data[0] = stats_peer_id;
+		*size = sizeof(stats_peer_id);
+		break;
+
+	case HID_FORWARD_OPT_PEER_STATS:
+		fill_peer_stats(data, size);
+		break;
+
+	default:
+		LOG_WRN("Unknown opt %" PRIu8, opt_id);
+		break;
 	}
 }
 
@@ -1038,7 +1284,7 @@ static bool event_handler(const struct event_header *eh)
 		}
 		__ASSERT_NO_MSG(sub);
 
-		sub->busy = false;
+		report_sent(sub);
 		send_enqueued_report(sub);
 
 		return false;
@@ -1148,11 +1394,15 @@ static bool event_handler(const struct event_header *eh)
 	}
 
 	if (IS_ENABLED(CONFIG_DESKTOP_CONFIG_CHANNEL_ENABLE)) {
-		if (is_config_event(eh)) {
-			return handle_config_event(cast_config_event(eh));
+		if (is_config_event(eh) &&
+		    handle_config_event(cast_config_event(eh))) {
+			return true;
 		}
 	}
 
+	GEN_CONFIG_EVENT_HANDLERS(STRINGIFY(MODULE), opt_descr, config_set,
+				  config_fetch);
+
 	/* If event is unhandled, unsubscribe. */
 	__ASSERT_NO_MSG(false);
 
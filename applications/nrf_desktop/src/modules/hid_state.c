@@ -14,7 +14,6 @@
 #include <sys/types.h>
 
 #include <zephyr/types.h>
-#include <sys/slist.h>
 #include <sys/util.h>
 #include <sys/byteorder.h>
 
@@ -27,7 +26,9 @@
 
 #include "hid_keymap.h"
 #include "hid_keymap_def.h"
+#include "hid_keymap_index.h"
 #include "hid_report_desc.h"
+#include "hid_eventq.h"
 
 #define MODULE hid_state
 #include "module_state_event.h"
@@ -79,19 +80,6 @@ struct items {
 	struct item item[ITEM_COUNT]; /**< Items set. Browse from the end. */
 };
 
-/**@brief Enqueued HID state item. */
-struct item_event {
-	sys_snode_t node; /**< Event queue linked list node. */
-	struct item item; /**< HID state item which has been enqueued. */
-	uint32_t timestamp; /**< HID event timestamp. */
-};
-
-/**@brief Event queue. */
-struct eventq {
-	sys_slist_t root;
-	size_t len;
-};
-
 /**@brief Axis data. */
 struct axis_data {
 	int16_t axis[AXIS_COUNT]; /**< Array of axes. */
@@ -100,7 +88,8 @@ struct axis_data {
 
 struct report_data {
 	struct items items;
-	struct eventq eventq;
+	struct hid_eventq eventq;
+	struct hid_eventq_event eventq_buf[CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE];
 	struct axis_data axes;
 	bool update_needed;
 	struct report_state *linked_rs;
@@ -134,6 +123,9 @@ static uint8_t report_data_index[REPORT_ID_COUNT];
 static uint8_t report_state_index[REPORT_ID_COUNT];
 static struct hid_state state;
 
+static uint8_t keymap_slot[HID_KEYMAP_INDEX_SIZE(ARRAY_SIZE(hid_keymap))];
+static struct hid_keymap_index keymap_index;
+
 
 static bool report_send(struct report_data *rd, bool check_state, bool send_always);
 
@@ -175,29 +167,10 @@ static void *bsearch(const void *key, const uint8_t *base,
 	return NULL;
 }
 
-/**@brief Compare Key ID in HID Keymap entries. */
-static int hid_keymap_compare(const void *a, const void *b)
-{
-	const struct hid_keymap *p_a = a;
-	const struct hid_keymap *p_b = b;
-
-	return (p_a->key_id - p_b->key_id);
-}
-
 /**@brief Translate Key ID to HID Usage ID and target report. */
-static struct hid_keymap *hid_keymap_get(uint16_t key_id)
+static const struct hid_keymap *hid_keymap_get(uint16_t key_id)
 {
-	struct hid_keymap key = {
-		.key_id = key_id
-	};
-
-	struct hid_keymap *map = bsearch(&key,
-					 (uint8_t *)hid_keymap,
-					 ARRAY_SIZE(hid_keymap),
-					 sizeof(key),
-					 hid_keymap_compare);
-
-	return map;
+	return hid_keymap_index_get(&keymap_index, key_id);
 }
 
 /**@brief Compare two usage values. */
@@ -209,202 +182,57 @@ static int usage_id_compare(const void *a, const void *b)
 	return (p_a->usage_id - p_b->usage_id);
 }
 
-static void eventq_reset(struct eventq *eventq)
+static void eventq_cleanup(struct hid_eventq *eventq, uint32_t timestamp)
 {
-	struct item_event *event;
-	struct item_event *tmp;
+	size_t cnt = hid_eventq_cleanup(eventq, timestamp,
+					CONFIG_DESKTOP_HID_REPORT_EXPIRATION);
 
-	SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&eventq->root, event, tmp, node) {
-		sys_slist_remove(&eventq->root, NULL, &event->node);
-
-		k_free(event);
+	if (cnt > 0) {
+		LOG_WRN("%u stale events removed from the queue!", cnt);
 	}
-
-	sys_slist_init(&eventq->root);
-	eventq->len = 0;
-}
-
-static bool eventq_is_full(const struct eventq *eventq)
-{
-	return (eventq->len >= CONFIG_DESKTOP_HID_EVENT_QUEUE_SIZE);
-}
-
-
-static bool eventq_is_empty(struct eventq *eventq)
-{
-	bool empty = sys_slist_is_empty(&eventq->root);
-
-	__ASSERT_NO_MSG(!empty == (eventq->len != 0));
-
-	return empty;
 }
 
-static struct item_event *eventq_get(struct eventq *eventq)
-{
-	sys_snode_t *node = sys_slist_get(&eventq->root);
-
-	if (!node) {
-		return NULL;
-	}
-
-	eventq->len--;
-
-	return CONTAINER_OF(node, struct item_event, node);
-}
-
-static void eventq_append(struct eventq *eventq, uint16_t usage_id, int16_t value)
+/**@brief Insert an item, keeping the recorded items sorted.
+ *
+ * Recorded items are stored at the end of the array, sorted by usage ID.
+ * Items with lower usage IDs are moved by one towards the free slots
+ * at the beginning of the array.
+ */
+static void item_insert(struct items *items, uint16_t usage_id, int16_t value)
 {
-	struct item_event *hid_event = k_malloc(sizeof(*hid_event));
-
-	if (!hid_event) {
-		LOG_ERR("Failed to allocate HID event");
-		/* Should never happen. */
-		__ASSERT_NO_MSG(false);
-		return;
-	}
-
-	hid_event->item.usage_id = usage_id;
-	hid_event->item.value = value;
-	hid_event->timestamp = k_uptime_get_32();
+	size_t first = ARRAY_SIZE(items->item) - items->item_count;
+	size_t pos = first;
 
-	/* Add a new event to the queue. */
-	sys_slist_append(&eventq->root, &hid_event->node);
-
-	eventq->len++;
-}
-
-static void eventq_region_purge(struct eventq *eventq,
-				sys_snode_t *last_to_purge)
-{
-	sys_snode_t *tmp;
-	sys_snode_t *tmp_safe;
-	size_t cnt = 0;
+	__ASSERT_NO_MSG(first > 0);
 
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, tmp, tmp_safe) {
-		sys_slist_remove(&eventq->root, NULL, tmp);
-
-		k_free(CONTAINER_OF(tmp, struct item_event, node));
-		cnt++;
-
-		if (tmp == last_to_purge) {
-			break;
-		}
+	while ((pos < ARRAY_SIZE(items->item)) &&
+	       (items->item[pos].usage_id < usage_id)) {
+		pos++;
 	}
 
-	eventq->len -= cnt;
+	memmove(&items->item[first - 1], &items->item[first],
+		(pos - first) * sizeof(items->item[0]));
 
-	LOG_WRN("%u stale events removed from the queue!", cnt);
+	items->item[pos - 1].usage_id = usage_id;
+	items->item[pos - 1].value = value;
+	items->item_count += 1;
 }
 
-
-static void eventq_cleanup(struct eventq *eventq, uint32_t timestamp)
+/**@brief Remove an item, keeping the recorded items sorted. */
+static void item_remove(struct items *items, struct item *item)
 {
-	/* Find timed out events. */
-
-	sys_snode_t *first_valid;
-
-	SYS_SLIST_FOR_EACH_NODE(&eventq->root, first_valid) {
-		uint32_t diff = timestamp - CONTAINER_OF(
-			first_valid, struct item_event, node)->timestamp;
-
-		if (diff < CONFIG_DESKTOP_HID_REPORT_EXPIRATION) {
-			break;
-		}
-	}
-
-	/* Remove events but only if key up was generated for each removed
-	 * key down.
-	 */
+	size_t first = ARRAY_SIZE(items->item) - items->item_count;
+	size_t pos = item - items->item;
 
-	sys_snode_t *maxfound = sys_slist_peek_head(&eventq->root);
-	size_t maxfound_pos = 0;
+	__ASSERT_NO_MSG(items->item_count != 0);
+	__ASSERT_NO_MSG(pos >= first);
 
-	sys_snode_t *cur;
-	size_t cur_pos = 0;
+	memmove(&items->item[first + 1], &items->item[first],
+		(pos - first) * sizeof(items->item[0]));
 
-	sys_snode_t *tmp_safe;
-
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&eventq->root, cur, tmp_safe) {
-		const struct item cur_item =
-			CONTAINER_OF(cur, struct item_event, node)->item;
-
-		if (cur_item.value > 0) {
-			/* Every key down must be paired with key up.
-			 * Set hit count to value as we just detected
-			 * first key down for this usage.
-			 */
-
-			unsigned int hit_count = cur_item.value;
-			sys_snode_t *j = cur;
-			size_t j_pos = cur_pos;
-
-			SYS_SLIST_ITERATE_FROM_NODE(&eventq->root, j) {
-				j_pos++;
-				if (j == first_valid) {
-					break;
-				}
-
-				const struct item item =
-					CONTAINER_OF(j,
-						     struct item_event,
-						     node)->item;
-
-				if (cur_item.usage_id == item.usage_id) {
-					hit_count += item.value;
-
-					if (hit_count == 0) {
-						/* All events with this usage
-						 * are paired.
-						 */
-						break;
-					}
-				}
-			}
-
-			if (j == first_valid) {
-				/* Pair not found. */
-				break;
-			}
-
-			if (j_pos > maxfound_pos) {
-				maxfound = j;
-				maxfound_pos = j_pos;
-			}
-		}
-
-
-		if (cur == first_valid) {
-			break;
-		}
-
-		if (cur == maxfound) {
-			/* All events up to this point have pairs and can
-			 * be deleted.
-			 */
-			eventq_region_purge(eventq, maxfound);
-		}
-
-		cur_pos++;
-	}
-}
-
-static void sort_by_usage_id(struct item items[], size_t array_size)
-{
-	for (size_t k = 0; k < array_size; k++) {
-		size_t id = k;
-
-		for (size_t l = k + 1; l < array_size; l++) {
-			if (items[l].usage_id < items[id].usage_id) {
-				id = l;
-			}
-		}
-		if (id != k) {
-			struct item tmp = items[k];
-
-			items[k] = items[id];
-			items[id] = tmp;
-		}
-	}
+	items->item[first].usage_id = 0;
+	items->item[first].value = 0;
+	items->item_count -= 1;
 }
 
 static void clear_items(struct items *items)
@@ -424,7 +252,7 @@ static void clear_report_data(struct report_data *rd)
 
 	clear_axes(&rd->axes);
 	clear_items(&rd->items);
-	eventq_reset(&rd->eventq);
+	hid_eventq_reset(&rd->eventq);
 
 	rd->update_needed = false;
 }
@@ -590,9 +418,11 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 	/* Report equal to zero brings no change. This should never happen. */
 	__ASSERT_NO_MSG(value != 0);
 
+	/* Only recorded items are searched, free slots precede them. */
 	p_item = bsearch(&usage_id,
-			 (uint8_t *)items->item,
-			 ARRAY_SIZE(items->item),
+			 (uint8_t *)&items->item[ARRAY_SIZE(items->item) -
+						 prev_item_count],
+			 prev_item_count,
 			 sizeof(items->item[0]),
 			 usage_id_compare);
 
@@ -600,9 +430,7 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		/* Item is present in the array - update its value. */
 		p_item->value += value;
 		if (p_item->value == 0) {
-			__ASSERT_NO_MSG(items->item_count != 0);
-			items->item_count -= 1;
-			p_item->usage_id = 0;
+			item_remove(items, p_item);
 		}
 
 		update_needed = true;
@@ -619,28 +447,12 @@ static bool key_value_set(struct items *items, uint16_t usage_id, int16_t value)
 		 */
 		LOG_WRN("No place on the list to store HID item!");
 	} else {
-		/* After sort operation, free slots (zeros) are stored
-		 * at the beginning of the array.
-		 */
-		size_t const idx = ARRAY_SIZE(items->item) - prev_item_count - 1;
-
-		__ASSERT_NO_MSG(items->item[idx].usage_id == 0);
-
 		/* Record this value change. */
-		items->item[idx].usage_id = usage_id;
-		items->item[idx].value = value;
-		items->item_count += 1;
+		item_insert(items, usage_id, value);
 
 		update_needed = true;
 	}
 
-	if (prev_item_count != items->item_count) {
-		/* Sort elements on the list. Use simple algorithm
-		 * with small footprint.
-		 */
-		sort_by_usage_id(items->item, ARRAY_SIZE(items->item));
-	}
-
 	return update_needed;
 }
 
@@ -880,21 +692,16 @@ static bool update_report(struct report_data *rd)
 {
 	bool update_needed = false;
 
-	while (!update_needed && !eventq_is_empty(&rd->eventq)) {
-		/* There are enqueued events to handle. */
-		struct item_event *event = eventq_get(&rd->eventq);
-
-		__ASSERT_NO_MSG(event);
+	struct hid_eventq_event event;
 
+	while (!update_needed && hid_eventq_get(&rd->eventq, &event)) {
+		/* There are enqueued events to handle. */
 		update_needed = key_value_set(&rd->items,
-					      event->item.usage_id,
-					      event->item.value);
+					      event.usage_id,
+					      event.value);
 
 		rd->update_needed = rd->update_needed || update_needed;
 
-
-		k_free(event);
-
 		/* If no item was changed, try next event. */
 	}
 
@@ -1094,7 +901,7 @@ static void connect(const void *subscriber_id, uint8_t report_id)
 		}
 		rd->linked_rs = rs;
 
-		if (!eventq_is_empty(&rd->eventq)) {
+		if (!hid_eventq_is_empty(&rd->eventq)) {
 			/* Remove all stale events from the queue. */
 			eventq_cleanup(&rd->eventq, k_uptime_get_32());
 		}
@@ -1137,37 +944,33 @@ static void enqueue(struct report_data *rd, uint16_t usage_id, int16_t value,
 {
 	eventq_cleanup(&rd->eventq, k_uptime_get_32());
 
-	if (eventq_is_full(&rd->eventq)) {
+	if (hid_eventq_is_full(&rd->eventq)) {
 		if (!connected) {
 			/* In disconnected state no items are recorded yet.
 			 * Try to remove queued items starting from the
 			 * oldest one.
 			 */
-			sys_snode_t *i;
-
-			SYS_SLIST_FOR_EACH_NODE(&rd->eventq.root, i) {
+			for (size_t i = 0; i < rd->eventq.len; i++) {
 				/* Initial cleanup was done above. Queue will
 				 * not contain events with expired timestamp.
 				 */
 				uint32_t timestamp =
-					CONTAINER_OF(i,
-						     struct item_event,
-						     node)->timestamp +
+					hid_eventq_peek(&rd->eventq, i)->timestamp +
 					CONFIG_DESKTOP_HID_REPORT_EXPIRATION;
 
 				eventq_cleanup(&rd->eventq, timestamp);
 
-				if (!eventq_is_full(&rd->eventq)) {
+				if (!hid_eventq_is_full(&rd->eventq)) {
 					/* At least one element was removed
 					 * from the queue. Do not continue
-					 * list traverse, content was modified!
+					 * queue traverse, content was modified!
 					 */
 					break;
 				}
 			}
 		}
 
-		if (eventq_is_full(&rd->eventq)) {
+		if (hid_eventq_is_full(&rd->eventq)) {
 			/* To maintain the sanity of HID state, clear
 			 * all recorded events and items.
 			 */
@@ -1176,7 +979,12 @@ static void enqueue(struct report_data *rd, uint16_t usage_id, int16_t value,
 		}
 	}
 
-	eventq_append(&rd->eventq, usage_id, value);
+	int err = hid_eventq_append(&rd->eventq, usage_id, value,
+				    k_uptime_get_32());
+
+	/* Queue has space after the cleanup above. */
+	__ASSERT_NO_MSG(!err);
+	ARG_UNUSED(err);
 }
 
 /**@brief Function for updating the value linked to the HID usage. */
@@ -1193,7 +1001,7 @@ static void update_key(const struct hid_keymap *map, int16_t value)
 		connected = (rs->state != STATE_DISCONNECTED);
 	}
 
-	if (!connected || !eventq_is_empty(&rd->eventq)) {
+	if (!connected || !hid_eventq_is_empty(&rd->eventq)) {
 		/* Report cannot be sent yet - enqueue this HID event. */
 		enqueue(rd, map->usage_id, value, connected);
 	} else {
@@ -1207,12 +1015,14 @@ static void update_key(const struct hid_keymap *map, int16_t value)
 
 static void init(void)
 {
+	BUILD_ASSERT(ARRAY_SIZE(hid_keymap) < HID_KEYMAP_INDEX_EMPTY,
+		     "Too many entries in hid_keymap");
+
+	hid_keymap_index_init(&keymap_index, hid_keymap,
+			      ARRAY_SIZE(hid_keymap), keymap_slot,
+			      ARRAY_SIZE(keymap_slot));
+
 	if (IS_ENABLED(CONFIG_ASSERT)) {
-		/* Validate the order of key IDs on the key map array. */
-		for (size_t i = 1; i < ARRAY_SIZE(hid_keymap); i++) {
-			__ASSERT(hid_keymap[i - 1].key_id < hid_keymap[i].key_id,
-				 "The hid_keymap array must be sorted by key_id!");
-		}
 		/* Validate if report IDs are correct. */
 		for (size_t i = 0; i < ARRAY_SIZE(hid_keymap); i++) {
 			__ASSERT((hid_keymap[i].report_id != REPORT_ID_RESERVED) &&
@@ -1282,6 +1092,13 @@ static void init(void)
 
 	__ASSERT_NO_MSG(data_id == INPUT_REPORT_DATA_COUNT);
 	__ASSERT_NO_MSG(state_id == INPUT_REPORT_STATE_COUNT);
+
+	for (size_t i = 0; i < ARRAY_SIZE(state.report_data); i++) {
+		struct report_data *rd = &state.report_data[i];
+
+		hid_eventq_init(&rd->eventq, rd->eventq_buf,
+				ARRAY_SIZE(rd->eventq_buf));
+	}
 }
 
 static bool handle_motion_event(const struct motion_event *event)
@@ -1320,7 +1137,7 @@ static bool handle_wheel_event(const struct wheel_event *event)
 static bool handle_button_event(const struct button_event *event)
 {
 	/* Get usage ID and target report from HID Keymap */
-	struct hid_keymap *map = hid_keymap_get(event->key_id);
+	const struct hid_keymap *map = hid_keymap_get(event->key_id);
 
 	if (!map || !map->usage_id) {
 		LOG_WRN("No mapping, button ignored");
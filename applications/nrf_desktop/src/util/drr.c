@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+
+#include "drr.h"
+
+
+int drr_next(size_t *deficit, size_t flow_cnt, size_t quantum, uint8_t *last,
+	     drr_item_size_get_t item_size_get, void *user_data)
+{
+	__ASSERT_NO_MSG((quantum > 0) && (*last < flow_cnt));
+
+	bool pending = false;
+
+	for (size_t i = 0; i < flow_cnt; i++) {
+		if (item_size_get(i, user_data) > 0) {
+			pending = true;
+			break;
+		}
+	}
+
+	if (!pending) {
+		return -ENOENT;
+	}
+
+	size_t flow = *last;
+
+	while (true) {
+		int size = item_size_get(flow, user_data);
+
+		if (size == 0) {
+			deficit[flow] = 0;
+		} else if ((size > 0) && ((size_t)size <= deficit[flow])) {
+			deficit[flow] -= size;
+			*last = flow;
+
+			return flow;
+		}
+
+		flow = (flow + 1) % flow_cnt;
+
+		if (item_size_get(flow, user_data) >= 0) {
+			deficit[flow] += quantum;
+		}
+	}
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _DRR_H_
+#define _DRR_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+/**
+ * @file drr.h
+ *
+ * @brief Deficit round-robin scheduler.
+ *
+ * A flow keeps its turn as long as its deficit covers the size of its next
+ * item. Then the turn goes to the next served flow and its deficit is
+ * increased by the quantum. The deficit of a flow without items is cleared.
+ */
+
+/**@brief Get the size of the next item of a flow.
+ *
+ * @param[in] flow	Index of the flow.
+ * @param[in] user_data	User data passed to @ref drr_next.
+ *
+ * @return Size of the item, 0 if the flow has no items or a negative value
+ *	   if the flow is not served.
+ */
+typedef int (*drr_item_size_get_t)(size_t flow, void *user_data);
+
+/**@brief Select the flow that sends the next item.
+ *
+ * The deficit of the selected flow is decreased by the size of its item.
+ * The caller must then take the item from the flow.
+ *
+ * @param[in,out] deficit	Deficit of each flow.
+ * @param[in]     flow_cnt	Number of flows.
+ * @param[in]     quantum	Quantum added to the deficit on every turn.
+ * @param[in,out] last		Flow that sent the previous item.
+ * @param[in]     item_size_get	Function that gets the size of a flow's item.
+ * @param[in]     user_data	User data passed to item_size_get.
+ *
+ * @return Index of the selected flow, -ENOENT if no served flow has items.
+ */
+int drr_next(size_t *deficit, size_t flow_cnt, size_t quantum, uint8_t *last,
+	     drr_item_size_get_t item_size_get, void *user_data);
+
+#endif /* _DRR_H_ */
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+
+#include "hid_eventq.h"
+
+
+void hid_eventq_init(struct hid_eventq *eventq, struct hid_eventq_event *buf,
+		     uint8_t size)
+{
+	__ASSERT_NO_MSG(buf && (size > 0));
+
+	eventq->buf = buf;
+	eventq->size = size;
+	hid_eventq_reset(eventq);
+}
+
+bool hid_eventq_get(struct hid_eventq *eventq, struct hid_eventq_event *event)
+{
+	if (hid_eventq_is_empty(eventq)) {
+		return false;
+	}
+
+	*event = *hid_eventq_peek(eventq, 0);
+
+	eventq->head++;
+	if (eventq->head == eventq->size) {
+		eventq->head = 0;
+	}
+	eventq->len--;
+
+	return true;
+}
+
+int hid_eventq_append(struct hid_eventq *eventq, uint16_t usage_id,
+		      int16_t value, uint32_t timestamp)
+{
+	if (hid_eventq_is_full(eventq)) {
+		return -ENOMEM;
+	}
+
+	struct hid_eventq_event *event = hid_eventq_peek(eventq, eventq->len);
+
+	event->usage_id = usage_id;
+	event->value = value;
+	event->timestamp = timestamp;
+
+	eventq->len++;
+
+	return 0;
+}
+
+static void region_purge(struct hid_eventq *eventq, size_t cnt)
+{
+	__ASSERT_NO_MSG(cnt <= eventq->len);
+
+	eventq->head = (eventq->head + cnt) % eventq->size;
+	eventq->len -= cnt;
+}
+
+size_t hid_eventq_cleanup(struct hid_eventq *eventq, uint32_t timestamp,
+			  uint32_t timeout)
+{
+	/* Find timed out events. */
+	size_t first_valid;
+
+	for (first_valid = 0; first_valid < eventq->len; first_valid++) {
+		uint32_t diff = timestamp -
+			hid_eventq_peek(eventq, first_valid)->timestamp;
+
+		if (diff < timeout) {
+			break;
+		}
+	}
+
+	/* Remove events but only if key up was generated for each removed
+	 * key down.
+	 */
+	size_t maxfound = 0;
+	size_t purge_cnt = 0;
+
+	for (size_t cur = 0; cur < eventq->len; cur++) {
+		const struct hid_eventq_event *cur_event =
+			hid_eventq_peek(eventq, cur);
+
+		if (cur_event->value > 0) {
+			/* Every key down must be paired with key up.
+			 * Set hit count to value as we just detected
+			 * first key down for this usage.
+			 */
+			unsigned int hit_count = cur_event->value;
+			size_t j;
+
+			for (j = cur + 1; j < first_valid; j++) {
+				const struct hid_eventq_event *event =
+					hid_eventq_peek(eventq, j);
+
+				if (cur_event->usage_id == event->usage_id) {
+					hit_count += event->value;
+
+					if (hit_count == 0) {
+						/* All events with this usage
+						 * are paired.
+						 */
+						break;
+					}
+				}
+			}
+
+			if (j == first_valid) {
+				/* Pair not found. */
+				break;
+			}
+
+			if (j > maxfound) {
+				maxfound = j;
+			}
+		}
+
+		if (cur == first_valid) {
+			break;
+		}
+
+		if (cur == maxfound) {
+			/* All events up to this point have pairs and can
+			 * be deleted.
+			 */
+			purge_cnt = cur + 1;
+		}
+	}
+
+	/* Expired events are at the beginning of the ring. */
+	region_purge(eventq, purge_cnt);
+
+	return purge_cnt;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _HID_EVENTQ_H_
+#define _HID_EVENTQ_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @file hid_eventq.h
+ *
+ * @brief Queue of HID events that are waiting to be applied to the HID state.
+ *
+ * The queue is a ring of a fixed size. Events are appended at its end and
+ * taken from its beginning. Expired events are removed by moving the
+ * beginning of the ring.
+ */
+
+/**@brief Enqueued HID event. */
+struct hid_eventq_event {
+	uint16_t usage_id; /**< HID usage ID. */
+	int16_t value; /**< HID value. */
+	uint32_t timestamp; /**< HID event timestamp. */
+};
+
+/**@brief HID event queue. */
+struct hid_eventq {
+	struct hid_eventq_event *buf; /**< Ring buffer. */
+	uint8_t size; /**< Number of events that fit in the ring. */
+	uint8_t head; /**< Index of the oldest event. */
+	uint8_t len; /**< Number of enqueued events. */
+};
+
+/**@brief Initialize the event queue.
+ *
+ * @param[in] eventq	Event queue.
+ * @param[in] buf	Buffer for the events.
+ * @param[in] size	Number of events in the buffer.
+ */
+void hid_eventq_init(struct hid_eventq *eventq, struct hid_eventq_event *buf,
+		     uint8_t size);
+
+/**@brief Remove all events from the queue.
+ *
+ * @param[in] eventq	Event queue.
+ */
+static inline void hid_eventq_reset(struct hid_eventq *eventq)
+{
+	eventq->head = 0;
+	eventq->len = 0;
+}
+
+/**@brief Check if the queue is full. */
+static inline bool hid_eventq_is_full(const struct hid_eventq *eventq)
+{
+	return (eventq->len >= eventq->size);
+}
+
+/**@brief Check if the queue is empty. */
+static inline bool hid_eventq_is_empty(const struct hid_eventq *eventq)
+{
+	return (eventq->len == 0);
+}
+
+/**@brief Get an enqueued event.
+ *
+ * @param[in] eventq	Event queue.
+ * @param[in] pos	Position of the event, 0 for the oldest one.
+ *
+ * @return Pointer to the event, valid until the queue is modified.
+ */
+static inline struct hid_eventq_event *hid_eventq_peek(
+		const struct hid_eventq *eventq, size_t pos)
+{
+	size_t idx = eventq->head + pos;
+
+	if (idx >= eventq->size) {
+		idx -= eventq->size;
+	}
+
+	return &eventq->buf[idx];
+}
+
+/**@brief Take the oldest event from the queue.
+ *
+ * @param[in]  eventq	Event queue.
+ * @param[out] event	Event taken from the queue.
+ *
+ * @return true if an event was taken, false if the queue is empty.
+ */
+bool hid_eventq_get(struct hid_eventq *eventq, struct hid_eventq_event *event);
+
+/**@brief Append an event to the queue.
+ *
+ * @param[in] eventq	Event queue.
+ * @param[in] usage_id	HID usage ID.
+ * @param[in] value	HID value.
+ * @param[in] timestamp	Event timestamp.
+ *
+ * @return 0 on success, -ENOMEM if the queue is full.
+ */
+int hid_eventq_append(struct hid_eventq *eventq, uint16_t usage_id,
+		      int16_t value, uint32_t timestamp);
+
+/**@brief Remove expired events from the queue.
+ *
+ * Events are removed only if every removed key press is paired with
+ * a removed key release, so that the HID state stays consistent.
+ *
+ * @param[in] eventq	Event queue.
+ * @param[in] timestamp	Current time.
+ * @param[in] timeout	Time after which an event expires.
+ *
+ * @return Number of removed events.
+ */
+size_t hid_eventq_cleanup(struct hid_eventq *eventq, uint32_t timestamp,
+			  uint32_t timeout);
+
+#endif /* _HID_EVENTQ_H_ */
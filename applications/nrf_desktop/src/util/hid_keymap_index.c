@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+
+#include "hid_keymap_index.h"
+
+
+static size_t slot_first(const struct hid_keymap_index *index,
+			 uint16_t key_id)
+{
+	/* Multiplicative hashing spreads the row and column bits. */
+	return ((uint32_t)key_id * 2654435761u) % index->slot_count;
+}
+
+static size_t slot_next(const struct hid_keymap_index *index, size_t pos)
+{
+	pos++;
+
+	return (pos == index->slot_count) ? 0 : pos;
+}
+
+void hid_keymap_index_init(struct hid_keymap_index *index,
+			   const struct hid_keymap *keymap, size_t keymap_size,
+			   uint8_t *slot, size_t slot_count)
+{
+	__ASSERT_NO_MSG(keymap_size < HID_KEYMAP_INDEX_EMPTY);
+	__ASSERT_NO_MSG(slot_count > keymap_size);
+
+	index->keymap = keymap;
+	index->slot = slot;
+	index->slot_count = slot_count;
+
+	memset(slot, HID_KEYMAP_INDEX_EMPTY, slot_count);
+
+	for (size_t i = 0; i < keymap_size; i++) {
+		size_t pos = slot_first(index, keymap[i].key_id);
+
+		while (slot[pos] != HID_KEYMAP_INDEX_EMPTY) {
+			__ASSERT(keymap[slot[pos]].key_id != keymap[i].key_id,
+				 "Key ID used twice in hid_keymap!");
+			pos = slot_next(index, pos);
+		}
+
+		slot[pos] = i;
+	}
+}
+
+const struct hid_keymap *hid_keymap_index_get(
+		const struct hid_keymap_index *index, uint16_t key_id)
+{
+	size_t pos = slot_first(index, key_id);
+
+	/* There is always an empty slot, so the search ends. */
+	while (index->slot[pos] != HID_KEYMAP_INDEX_EMPTY) {
+		const struct hid_keymap *map = &index->keymap[index->slot[pos]];
+
+		if (map->key_id == key_id) {
+			return map;
+		}
+
+		pos = slot_next(index, pos);
+	}
+
+	return NULL;
+}
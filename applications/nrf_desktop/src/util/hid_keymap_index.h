@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _HID_KEYMAP_INDEX_H_
+#define _HID_KEYMAP_INDEX_H_
+
+#include <zephyr/types.h>
+#include <stddef.h>
+
+#include "hid_keymap.h"
+
+/**
+ * @file hid_keymap_index.h
+ *
+ * @brief Constant time translation of key IDs to HID keymap entries.
+ *
+ * Key IDs are sparse, so the index is an open addressing hash table of
+ * keymap positions. The table has twice as many slots as the keymap has
+ * entries, which keeps the probe sequences short.
+ */
+
+/**@brief Number of index slots for a keymap of a given size. */
+#define HID_KEYMAP_INDEX_SIZE(_keymap_size) (2 * (_keymap_size))
+
+/**@brief Value of an index slot that is not used. */
+#define HID_KEYMAP_INDEX_EMPTY UINT8_MAX
+
+/**@brief HID keymap index. */
+struct hid_keymap_index {
+	const struct hid_keymap *keymap; /**< Indexed keymap. */
+	uint8_t *slot; /**< Keymap positions, by hash of the key ID. */
+	size_t slot_count; /**< Number of slots. */
+};
+
+/**@brief Build the index of a keymap.
+ *
+ * @param[out] index		Keymap index.
+ * @param[in]  keymap		Keymap with unique key IDs.
+ * @param[in]  keymap_size	Number of keymap entries, below UINT8_MAX.
+ * @param[in]  slot		Buffer for the slots.
+ * @param[in]  slot_count	Number of slots, see @ref HID_KEYMAP_INDEX_SIZE.
+ */
+void hid_keymap_index_init(struct hid_keymap_index *index,
+			   const struct hid_keymap *keymap, size_t keymap_size,
+			   uint8_t *slot, size_t slot_count);
+
+/**@brief Get the keymap entry of a key.
+ *
+ * @param[in] index	Keymap index.
+ * @param[in] key_id	Key ID.
+ *
+ * @return Keymap entry or NULL if the key is not mapped.
+ */
+const struct hid_keymap *hid_keymap_index_get(
+		const struct hid_keymap_index *index, uint16_t key_id);
+
+#endif /* _HID_KEYMAP_INDEX_H_ */
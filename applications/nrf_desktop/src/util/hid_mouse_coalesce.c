@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+
+#include "hid_mouse_coalesce.h"
+#include "hid_report_mouse.h"
+
+
+static int16_t mouse_xy_get(uint16_t val)
+{
+	/* Sign-extend the 12-bit value. */
+	if (val & BIT(11)) {
+		return (int16_t)(val | 0xf000);
+	}
+
+	return val;
+}
+
+bool hid_mouse_coalesce(uint8_t *queued, const uint8_t *data)
+{
+	/* Button state changes must reach the host. */
+	if (queued[0] != data[0]) {
+		return false;
+	}
+
+	int16_t wheel = (int8_t)queued[1] + (int8_t)data[1];
+	int16_t x = mouse_xy_get(queued[2] | ((queued[3] & 0x0f) << 8)) +
+		    mouse_xy_get(data[2] | ((data[3] & 0x0f) << 8));
+	int16_t y = mouse_xy_get((queued[3] >> 4) | (queued[4] << 4)) +
+		    mouse_xy_get((data[3] >> 4) | (data[4] << 4));
+
+	/* Do not lose motion if the sum does not fit in a single report. */
+	if ((wheel < MOUSE_REPORT_WHEEL_MIN) || (wheel > MOUSE_REPORT_WHEEL_MAX) ||
+	    (x < MOUSE_REPORT_XY_MIN) || (x > MOUSE_REPORT_XY_MAX) ||
+	    (y < MOUSE_REPORT_XY_MIN) || (y > MOUSE_REPORT_XY_MAX)) {
+		return false;
+	}
+
+	queued[1] = wheel;
+	queued[2] = x & 0xff;
+	queued[3] = ((y & 0x0f) << 4) | ((x >> 8) & 0x0f);
+	queued[4] = (y >> 4) & 0xff;
+
+	return true;
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _HID_MOUSE_COALESCE_H_
+#define _HID_MOUSE_COALESCE_H_
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+/**
+ * @file hid_mouse_coalesce.h
+ *
+ * @brief Coalescing of mouse reports.
+ */
+
+/**@brief Merge a mouse report into a queued one.
+ *
+ * The motion of both reports is summed in the queued report. Both reports
+ * hold REPORT_SIZE_MOUSE bytes, without the report ID.
+ *
+ * @param[in,out] queued	Queued report.
+ * @param[in]     data		New report.
+ *
+ * @return true if the report was merged, false if the state of the buttons
+ *	   differs or if the sum does not fit in a single report.
+ */
+bool hid_mouse_coalesce(uint8_t *queued, const uint8_t *data);
+
+#endif /* _HID_MOUSE_COALESCE_H_ */
@@ -502,51 +502,39 @@ static int do_ftp_put(void)
 	return (ret == FTP_CODE_226) ? 0 : -1;
 }
 
-/**@brief API to handle FTP AT command
+/**@brief handle AT#XFTP commands
+ *  AT#XFTP=<cmd>[,<arg>[,<arg>...]]
  */
-int slm_at_ftp_parse(const char *at_cmd)
+static int handle_at_ftp(enum at_cmd_type cmd_type)
 {
-	int ret = -ENOENT;
+	int ret;
 	char op_str[16];
 	int size = 16;
 
-	if (slm_util_cmd_casecmp(at_cmd, AT_FTP_STR)) {
-		ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
-		if (ret) {
-			LOG_ERR("Failed to parse AT command %d", ret);
-			return -EINVAL;
-		}
-		if (at_parser_cmd_type_get(at_cmd) != AT_CMD_TYPE_SET_COMMAND) {
-			return -EINVAL;
-		}
-		if (at_params_valid_count_get(&at_param_list) < 2) {
-			return -EINVAL;
-		}
-		ret = at_params_string_get(&at_param_list, 1, op_str, &size);
-		if (ret) {
-			return ret;
-		}
-		op_str[size] = '\0';
-		ret = -EINVAL;
-		for (int i = 0; i < FTP_OP_MAX; i++) {
-			if (slm_util_casecmp(op_str,
-				ftp_op_list[i].op_str)) {
-				ret = ftp_op_list[i].handler();
-				break;
-			}
+	if (cmd_type != AT_CMD_TYPE_SET_COMMAND) {
+		return -EINVAL;
+	}
+	if (at_params_valid_count_get(&at_param_list) < 2) {
+		return -EINVAL;
+	}
+	ret = at_params_string_get(&at_param_list, 1, op_str, &size);
+	if (ret) {
+		return ret;
+	}
+	op_str[size] = '\0';
+	ret = -EINVAL;
+	for (int i = 0; i < FTP_OP_MAX; i++) {
+		if (slm_util_casecmp(op_str,
+			ftp_op_list[i].op_str)) {
+			ret = ftp_op_list[i].handler();
+			break;
 		}
 	}
 
 	return ret;
 }
 
-/**@brief API to list FTP AT commands
- */
-void slm_at_ftp_clac(void)
-{
-	sprintf(rsp_buf, "%s\r\n", AT_FTP_STR);
-	rsp_send(rsp_buf, strlen(rsp_buf));
-}
+SLM_AT_CMD_DEFINE(ftp, AT_FTP_STR, handle_at_ftp, SLM_AT_RSP_OK);
 
 /**@brief API to initialize FTP AT commands handler
  */
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <ctype.h>
+#include <string.h>
+#include <logging/log.h>
+
+LOG_MODULE_REGISTER(at_cmd, CONFIG_SLM_LOG_LEVEL);
+
+#include "slm_at_cmd.h"
+
+/* Hash table of the registered AT commands, must be a power of two */
+#define AT_CMD_TABLE_SIZE	128
+#define AT_CMD_TABLE_MASK	(AT_CMD_TABLE_SIZE - 1)
+
+static const struct slm_at_cmd *at_cmd_table[AT_CMD_TABLE_SIZE];
+
+/* Length of the command name, which ends before the parameters. */
+static size_t at_cmd_name_len(const char *at_cmd)
+{
+	size_t len = 0;
+
+	while (at_cmd[len] != '\0' && at_cmd[len] != '=' &&
+	       at_cmd[len] != '?' && at_cmd[len] != '\r' &&
+	       at_cmd[len] != '\n') {
+		len++;
+	}
+
+	return len;
+}
+
+/* FNV-1a hash of the command name, ignoring case. */
+static uint32_t at_cmd_hash(const char *name, size_t len)
+{
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)toupper((int)name[i]);
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* Compare a registered command with a command name, ignoring case. */
+static bool at_cmd_name_equal(const char *string, const char *name, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (toupper((int)string[i]) != toupper((int)name[i])) {
+			return false;
+		}
+	}
+
+	return string[len] == '\0';
+}
+
+int slm_at_cmd_table_init(void)
+{
+	uint32_t idx;
+	size_t len;
+	int count = 0;
+
+	memset(at_cmd_table, 0, sizeof(at_cmd_table));
+
+	Z_STRUCT_SECTION_FOREACH(slm_at_cmd, cmd) {
+		/* Keep the table at most half full, to bound the probing */
+		if (++count > AT_CMD_TABLE_SIZE / 2) {
+			LOG_ERR("Too many AT commands");
+			return -ENOMEM;
+		}
+
+		len = strlen(cmd->string);
+		idx = at_cmd_hash(cmd->string, len) & AT_CMD_TABLE_MASK;
+		while (at_cmd_table[idx] != NULL) {
+			if (at_cmd_name_equal(at_cmd_table[idx]->string,
+					      cmd->string, len)) {
+				LOG_ERR("AT command registered twice: %s",
+					log_strdup(cmd->string));
+				return -EEXIST;
+			}
+			idx = (idx + 1) & AT_CMD_TABLE_MASK;
+		}
+		at_cmd_table[idx] = cmd;
+	}
+
+	LOG_DBG("%d AT commands registered", count);
+
+	return 0;
+}
+
+const struct slm_at_cmd *slm_at_cmd_find(const char *at_cmd)
+{
+	size_t len = at_cmd_name_len(at_cmd);
+	uint32_t idx = at_cmd_hash(at_cmd, len) & AT_CMD_TABLE_MASK;
+
+	while (at_cmd_table[idx] != NULL) {
+		const struct slm_at_cmd *cmd = at_cmd_table[idx];
+
+		if (at_cmd_name_equal(cmd->string, at_cmd, len)) {
+			return cmd;
+		}
+		idx = (idx + 1) & AT_CMD_TABLE_MASK;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef SLM_AT_CMD_
+#define SLM_AT_CMD_
+
+/**@file slm_at_cmd.h
+ *
+ * @brief AT command registration for serial LTE modem
+ * @{
+ */
+
+#include <zephyr.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <modem/at_cmd_parser.h>
+
+/**@brief AT command handler type. */
+typedef int (*slm_at_handler_t) (enum at_cmd_type);
+
+/**@brief Response sent by the AT host when a command handler returns. */
+enum slm_at_rsp {
+	/** "OK" if the handler returns 0, "ERROR" otherwise. */
+	SLM_AT_RSP_OK,
+	/** As SLM_AT_RSP_OK, except that a positive value means that the
+	 *  handler has already sent the response.
+	 */
+	SLM_AT_RSP_OK_OR_NONE,
+	/** Nothing if the handler returns 0, "ERROR" otherwise. */
+	SLM_AT_RSP_NONE
+};
+
+/**@brief AT command registered with the AT host. */
+struct slm_at_cmd {
+	/** AT command name, for example "AT#XSLMVER". */
+	const char *string;
+	/** Handler, called with the parameters parsed in at_param_list. */
+	slm_at_handler_t handler;
+	/** Response sent when the handler returns. */
+	enum slm_at_rsp rsp;
+	/** Handled as a command also in data mode, to exit the data mode. */
+	bool datamode;
+};
+
+/**
+ * @brief Register an AT command with the AT host
+ *
+ * The command is placed in a dedicated linker section, so the modules do not
+ * need to be known by the AT host. The commands are indexed in a hash table
+ * by @ref slm_at_cmd_table_init.
+ *
+ * @param _name Unique name of the command entry.
+ * @param _string AT command name, for example "AT#XSLMVER".
+ * @param _handler AT command handler.
+ * @param _rsp Response mode, see @ref slm_at_rsp.
+ */
+#define SLM_AT_CMD_DEFINE(_name, _string, _handler, _rsp)		\
+	Z_SLM_AT_CMD_DEFINE(_name, _string, _handler, _rsp, false)
+
+/**
+ * @brief Register an AT command that is also handled in data mode
+ *
+ * In data mode, the data received from the host is sent to the socket,
+ * unless it is one of these commands, which are used to exit the data mode.
+ *
+ * @param _name Unique name of the command entry.
+ * @param _string AT command name, for example "AT#XTCPCLI".
+ * @param _handler AT command handler.
+ * @param _rsp Response mode, see @ref slm_at_rsp.
+ */
+#define SLM_AT_CMD_DATAMODE_DEFINE(_name, _string, _handler, _rsp)	\
+	Z_SLM_AT_CMD_DEFINE(_name, _string, _handler, _rsp, true)
+
+#define Z_SLM_AT_CMD_DEFINE(_name, _string, _handler, _rsp, _datamode)	\
+	static const Z_STRUCT_SECTION_ITERABLE(slm_at_cmd,		\
+					       slm_at_cmd_##_name) = {	\
+		.string = _string,					\
+		.handler = _handler,					\
+		.rsp = _rsp,						\
+		.datamode = _datamode,					\
+	}
+
+/**
+ * @brief Index the registered AT commands
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -ENOMEM If too many AT commands are registered.
+ * @retval -EEXIST If an AT command is registered twice.
+ */
+int slm_at_cmd_table_init(void);
+
+/**
+ * @brief Find a registered AT command
+ *
+ * @param at_cmd AT command string, with or without parameters. The name is
+ *               compared ignoring case.
+ *
+ * @return The registered AT command, or NULL if it is not registered.
+ */
+const struct slm_at_cmd *slm_at_cmd_find(const char *at_cmd);
+
+/** @} */
+
+#endif /* SLM_AT_CMD_ */
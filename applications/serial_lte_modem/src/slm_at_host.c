@@ -10,6 +10,7 @@
 #include <logging/log.h>
 #include <drivers/uart.h>
 #include <string.h>
+#include <sys/byteorder.h>
 #include <init.h>
 #include <modem/at_cmd.h>
 #include <modem/at_notif.h>
@@ -61,6 +62,12 @@ LOG_MODULE_REGISTER(at_host, CONFIG_SLM_LOG_LEVEL);
 #define UART_RX_LEN	256
 #define UART_RX_TIMEOUT 1
 
+#define BINMODE_HDR_LEN	2
+
+/* Data still received after the reception is stopped */
+BUILD_ASSERT(UART_RX_BUF_NUM * UART_RX_LEN <= SLM_BINMODE_RX_HEADROOM,
+	     "Binary data mode headroom cannot hold the UART RX buffers");
+
 /** @brief Termination Modes. */
 enum term_modes {
 	MODE_NULL_TERM, /**< Null Termination */
@@ -88,7 +95,17 @@ static uint8_t uart_rx_buf[UART_RX_BUF_NUM][UART_RX_LEN];
 static uint8_t *next_buf = uart_rx_buf[1];
 static uint8_t *uart_tx_buf;
 
+static bool host_idle;
+
 static K_SEM_DEFINE(tx_done, 0, 1);
+static K_SEM_DEFINE(tx_sync_done, 0, 1);
+static bool tx_sync;
+
+/* Binary data mode */
+static atomic_t binmode_active;
+/* UART RX is disabled because the receive buffer is nearly full */
+static atomic_t binmode_rx_paused;
+static struct k_work binmode_work;
 
 /* global functions defined in different files */
 void enter_idle(void);
@@ -124,6 +141,164 @@ void rsp_send(const uint8_t *str, size_t len)
 	}
 }
 
+/* Send from the buffer of the caller, and wait for the transfer to end. */
+static int uart_tx_sync(const uint8_t *data, size_t len)
+{
+	int ret;
+
+	ret = uart_tx(uart_dev, data, len, SYS_FOREVER_MS);
+	if (ret) {
+		LOG_WRN("uart_tx failed: %d", ret);
+		return ret;
+	}
+
+	k_sem_take(&tx_sync_done, K_FOREVER);
+
+	return 0;
+}
+
+static int binmode_frame_send(const uint8_t *data, size_t len)
+{
+	uint8_t hdr[BINMODE_HDR_LEN];
+	int ret;
+
+	if (len > UINT16_MAX) {
+		return -EMSGSIZE;
+	}
+
+	sys_put_be16(len, hdr);
+
+	k_sem_take(&tx_done, K_FOREVER);
+	tx_sync = true;
+
+	ret = uart_tx_sync(hdr, sizeof(hdr));
+	if (ret == 0 && len > 0) {
+		ret = uart_tx_sync(data, len);
+	}
+
+	tx_sync = false;
+	k_sem_give(&tx_done);
+
+	return ret;
+}
+
+int slm_at_host_binmode_send(const uint8_t *data, size_t len)
+{
+	if (!atomic_get(&binmode_active)) {
+		return -EPERM;
+	}
+
+	if (len == 0) {
+		/* A zero-length frame would end the binary data mode */
+		return 0;
+	}
+
+	return binmode_frame_send(data, len);
+}
+
+int slm_at_host_binmode_enter(slm_binmode_handler_t handler)
+{
+	if (handler == NULL) {
+		return -EINVAL;
+	}
+
+	if (atomic_get(&binmode_active)) {
+		return -EALREADY;
+	}
+
+	slm_binmode_rx_init(handler);
+	atomic_set(&binmode_rx_paused, false);
+	atomic_set(&binmode_active, true);
+
+	LOG_INF("Enter binary data mode");
+
+	return 0;
+}
+
+void slm_at_host_binmode_exit(void)
+{
+	if (!atomic_cas(&binmode_active, true, false)) {
+		return;
+	}
+
+	/* Notify the host, which can send AT commands again */
+	(void)binmode_frame_send(NULL, 0);
+
+	/* Resume the reception if it is paused */
+	k_work_submit(&binmode_work);
+
+	LOG_INF("Exit binary data mode");
+}
+
+bool slm_at_host_binmode_is_active(void)
+{
+	return atomic_get(&binmode_active);
+}
+
+static void binmode_rx(const uint8_t *data, size_t len)
+{
+	if ((slm_binmode_rx_put(data, len) == 0) &&
+	    slm_binmode_rx_space_low() &&
+	    !atomic_set(&binmode_rx_paused, true)) {
+		/* With hardware flow control, RTS is deasserted while the
+		 * reception is disabled, so the host stops sending.
+		 */
+		LOG_DBG("Binary data mode RX paused");
+		uart_rx_disable(uart_dev);
+	}
+
+	k_work_submit(&binmode_work);
+}
+
+static void binmode_rx_resume(void)
+{
+	int err;
+
+	if (!atomic_get(&binmode_rx_paused) ||
+	    (atomic_get(&binmode_active) && slm_binmode_rx_space_low())) {
+		return;
+	}
+
+	err = uart_rx_enable(uart_dev, uart_rx_buf[0],
+			     sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT);
+	if (err == -EBUSY) {
+		/* Retried when the reception is disabled */
+		return;
+	} else if (err) {
+		LOG_ERR("UART RX failed: %d", err);
+	}
+
+	atomic_set(&binmode_rx_paused, false);
+	LOG_DBG("Binary data mode RX resumed");
+}
+
+static void binmode_work_fn(struct k_work *work)
+{
+	int ret;
+
+	ARG_UNUSED(work);
+
+	while (atomic_get(&binmode_active)) {
+		ret = slm_binmode_rx_frame_process();
+		if (ret == 1) {
+			continue;
+		}
+
+		if (ret < 0) {
+			/* The frames cannot be followed after an error, so
+			 * the host is notified that the mode has ended.
+			 */
+			if (ret != -ECANCELED) {
+				LOG_ERR("Binary data mode failed: %d", ret);
+			}
+			slm_at_host_binmode_exit();
+		}
+		break;
+	}
+
+	binmode_rx_resume();
+}
+
 static int set_uart_baudrate(uint32_t baudrate)
 {
 	int err = -EINVAL;
@@ -171,53 +346,50 @@ static void response_handler(void *context, const char *response)
 	}
 }
 
-static void handle_at_clac(void)
+static int handle_at_slmver(enum at_cmd_type type)
 {
-	rsp_send(AT_CMD_SLMVER, sizeof(AT_CMD_SLMVER) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_SLMUART, sizeof(AT_CMD_SLMUART) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_SLEEP, sizeof(AT_CMD_SLEEP) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_RESET, sizeof(AT_CMD_RESET) - 1);
-	rsp_send("\r\n", 2);
-	rsp_send(AT_CMD_CLAC, sizeof(AT_CMD_CLAC) - 1);
-	rsp_send("\r\n", 2);
-	slm_at_tcp_proxy_clac();
-	slm_at_udp_proxy_clac();
-	slm_at_tcpip_clac();
-#if defined(CONFIG_SLM_NATIVE_TLS)
-	slm_at_cmng_clac();
-#endif
-	slm_at_icmp_clac();
-	slm_at_fota_clac();
-#if defined(CONFIG_SLM_GPS)
-	slm_at_gps_clac();
-#endif
-#if defined(CONFIG_SLM_FTPC)
-	slm_at_ftp_clac();
-#endif
-#if defined(CONFIG_SLM_MQTTC)
-	slm_at_mqtt_clac();
-#endif
-#if defined(CONFIG_SLM_HTTPC)
-	slm_at_httpc_clac();
-#endif
+	ARG_UNUSED(type);
+
+	rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
+
+	return 0;
 }
 
-static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
+static int handle_at_reset(enum at_cmd_type type)
 {
-	int ret = -EINVAL;
-	enum at_cmd_type type;
-	uint16_t shutdown_mode;
+	ARG_UNUSED(type);
 
-	ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
-	if (ret < 0) {
-		LOG_ERR("Failed to parse AT command %d", ret);
-		return -EINVAL;
+	rsp_send(OK_STR, sizeof(OK_STR) - 1);
+	k_sleep(K_MSEC(50));
+	slm_at_host_uninit();
+	enter_sleep(false);
+	sys_reboot(SYS_REBOOT_COLD);
+
+	return 0; /* Cannot reach here */
+}
+
+static int handle_at_clac(enum at_cmd_type type)
+{
+	ARG_UNUSED(type);
+
+	/* Commands not starting with "AT#X", like AT%CMNG, are listed by
+	 * the modem.
+	 */
+	Z_STRUCT_SECTION_FOREACH(slm_at_cmd, cmd) {
+		if (strncmp(cmd->string, "AT#X", 4) == 0) {
+			rsp_send(cmd->string, strlen(cmd->string));
+			rsp_send("\r\n", 2);
+		}
 	}
 
-	type = at_parser_cmd_type_get(at_cmd);
+	return 0;
+}
+
+static int handle_at_sleep(enum at_cmd_type type)
+{
+	int ret = -EINVAL;
+	uint16_t shutdown_mode;
+
 	if (type == AT_CMD_TYPE_SET_COMMAND) {
 		shutdown_mode = SHUTDOWN_MODE_IDLE;
 		if (at_params_valid_count_get(&at_param_list) > 1) {
@@ -229,9 +401,9 @@ static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
 			}
 		}
 		if (shutdown_mode == SHUTDOWN_MODE_IDLE) {
+			host_idle = true;
 			slm_at_host_uninit();
 			enter_idle();
-			*mode = SHUTDOWN_MODE_IDLE;
 			ret = 0; /*Will send no "OK"*/
 		} else if (shutdown_mode == SHUTDOWN_MODE_SLEEP) {
 			slm_at_host_uninit();
@@ -255,28 +427,21 @@ static int handle_at_sleep(const char *at_cmd, enum shutdown_modes *mode)
 	return ret;
 }
 
-static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
+static int handle_at_slmuart(enum at_cmd_type type)
 {
 	int ret = -EINVAL;
-	enum at_cmd_type type;
+	uint32_t baudrate = 0;
 
-	ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
-	if (ret < 0) {
-		LOG_ERR("Failed to parse AT command %d", ret);
-		return -EINVAL;
-	}
-
-	type = at_parser_cmd_type_get(at_cmd);
 	if (type == AT_CMD_TYPE_SET_COMMAND) {
 		if (at_params_valid_count_get(&at_param_list) > 1) {
 			ret = at_params_int_get(&at_param_list, 1,
-					baudrate);
+					&baudrate);
 			if (ret < 0) {
 				LOG_ERR("AT parameter error");
 				return -EINVAL;
 			}
 		}
-		switch (*baudrate) {
+		switch (baudrate) {
 		case 1200:
 		case 2400:
 		case 4800:
@@ -290,12 +455,17 @@ static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
 		case 460800:
 		case 921600:
 		case 1000000:
-			ret = 0;
 			break;
 		default:
 			LOG_ERR("Invalid uart baud rate provided.");
 			return -EINVAL;
 		}
+
+		/* Respond with the current baud rate before changing it */
+		rsp_send(OK_STR, sizeof(OK_STR) - 1);
+		k_sleep(K_MSEC(50));
+		set_uart_baudrate(baudrate);
+		ret = 1;
 	}
 
 	if (type == AT_CMD_TYPE_READ_COMMAND) {
@@ -316,176 +486,90 @@ static int handle_at_slmuart(const char *at_cmd, uint32_t *baudrate)
 	return ret;
 }
 
-static void cmd_send(struct k_work *work)
+SLM_AT_CMD_DEFINE(slmver, AT_CMD_SLMVER, handle_at_slmver, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(slmuart, AT_CMD_SLMUART, handle_at_slmuart,
+		  SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DEFINE(reset, AT_CMD_RESET, handle_at_reset, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(clac, AT_CMD_CLAC, handle_at_clac, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(sleep, AT_CMD_SLEEP, handle_at_sleep, SLM_AT_RSP_OK);
+
+static int at_cmd_dispatch(const struct slm_at_cmd *cmd, const char *at_cmd)
 {
-	char str[32];
-	static char buf[AT_MAX_CMD_LEN];
-	enum at_cmd_state state;
 	int err;
 
-	ARG_UNUSED(work);
-
-	/* Make sure the string is 0-terminated */
-	at_buf[MIN(at_buf_len, AT_MAX_CMD_LEN - 1)] = 0;
-
-	LOG_HEXDUMP_DBG(at_buf, at_buf_len, "RX");
-
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMVER)) {
-		rsp_send(SLM_VERSION, sizeof(SLM_VERSION) - 1);
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	}
-
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLMUART)) {
-		uint32_t baudrate;
-
-		err = handle_at_slmuart(at_buf, &baudrate);
-		if (err != 0) {
-			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
-		} else {
-			rsp_send(OK_STR, sizeof(OK_STR) - 1);
-			k_sleep(K_MSEC(50));
-			set_uart_baudrate(baudrate);
-			goto done;
-		}
+	err = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
+	if (err < 0) {
+		LOG_ERR("Failed to parse AT command %d", err);
+		return -EINVAL;
 	}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_RESET)) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		k_sleep(K_MSEC(50));
-		slm_at_host_uninit();
-		enter_sleep(false);
-		sys_reboot(SYS_REBOOT_COLD);
-	}
+	return cmd->handler(at_parser_cmd_type_get(at_cmd));
+}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_CLAC)) {
-		handle_at_clac();
+static void cmd_rsp_send(enum slm_at_rsp mode, int err)
+{
+	if (err < 0 || (err > 0 && mode != SLM_AT_RSP_OK_OR_NONE)) {
+		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+	} else if (err == 0 && mode != SLM_AT_RSP_NONE) {
 		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
 	}
+}
 
-	if (slm_util_cmd_casecmp(at_buf, AT_CMD_SLEEP)) {
-		enum shutdown_modes mode = SHUTDOWN_MODE_INVALID;
-
-		err = handle_at_sleep(at_buf, &mode);
-		if (err) {
-			rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-			goto done;
-		} else {
-			if (mode == SHUTDOWN_MODE_INVALID) {
-				/*Test command*/
-				rsp_send(OK_STR, sizeof(OK_STR) - 1);
-				goto done;
-			} else {
-				/*Entered IDLE*/
-				return;
-			}
-		}
-	}
+/* Data sent in data mode, or as HTTP payload, is not an AT command. */
+static int data_send(const uint8_t *data, size_t len)
+{
+	int err;
 
-	err = slm_at_tcp_proxy_parse(at_buf, at_buf_len);
-	if (err > 0) {
-		goto done;
-	} else if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+	err = slm_at_tcp_proxy_datamode_send(data, len);
+	if (err != -ENOENT) {
+		return err;
 	}
 
-	err = slm_at_udp_proxy_parse(at_buf, at_buf_len);
-	if (err > 0) {
-		goto done;
-	} else if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+	err = slm_at_udp_proxy_datamode_send(data, len);
+#if defined(CONFIG_SLM_HTTPC)
+	if (err == -ENOENT) {
+		err = slm_at_httpc_payload_send(data, len);
 	}
+#endif
 
-	err = slm_at_tcpip_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+	return err;
+}
 
-#if defined(CONFIG_SLM_NATIVE_TLS)
-	err = slm_at_cmng_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-#endif
+static void cmd_send(struct k_work *work)
+{
+	char str[32];
+	static char buf[AT_MAX_CMD_LEN];
+	const struct slm_at_cmd *cmd;
+	enum at_cmd_state state;
+	int err;
 
-	err = slm_at_icmp_parse(at_buf);
-	if (err == 0) {
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+	ARG_UNUSED(work);
 
-	err = slm_at_fota_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
+	/* Make sure the string is 0-terminated */
+	at_buf[MIN(at_buf_len, AT_MAX_CMD_LEN - 1)] = 0;
 
-#if defined(CONFIG_SLM_GPS)
-	err = slm_at_gps_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-#endif
+	LOG_HEXDUMP_DBG(at_buf, at_buf_len, "RX");
 
-#if defined(CONFIG_SLM_FTPC)
-	err = slm_at_ftp_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
-	}
-#endif
+	cmd = slm_at_cmd_find(at_buf);
 
-#if defined(CONFIG_SLM_MQTTC)
-	err = slm_at_mqtt_parse(at_buf);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
-		goto done;
+	/* In data mode, only the commands that exit it are handled. */
+	if (cmd == NULL || !cmd->datamode) {
+		err = data_send(at_buf, at_buf_len);
+		if (err != -ENOENT) {
+			cmd_rsp_send(SLM_AT_RSP_OK_OR_NONE, err);
+			goto done;
+		}
 	}
-#endif
 
-#if defined(CONFIG_SLM_HTTPC)
-	err = slm_at_httpc_parse(at_buf, at_buf_len);
-	if (err == 0) {
-		rsp_send(OK_STR, sizeof(OK_STR) - 1);
-		goto done;
-	} else if (err != -ENOENT) {
-		rsp_send(ERROR_STR, sizeof(ERROR_STR) - 1);
+	if (cmd != NULL) {
+		err = at_cmd_dispatch(cmd, at_buf);
+		if (host_idle) {
+			/* Entered IDLE, UART is off */
+			return;
+		}
+		cmd_rsp_send(cmd->rsp, err);
 		goto done;
 	}
-#endif
 
 	/* Send to modem */
 	err = at_cmd_write(at_buf, buf, AT_MAX_CMD_LEN, &state);
@@ -612,15 +696,28 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 
 	switch (evt->type) {
 	case UART_TX_DONE:
+		if (tx_sync) {
+			k_sem_give(&tx_sync_done);
+			break;
+		}
 		k_free(uart_tx_buf);
 		k_sem_give(&tx_done);
 		break;
 	case UART_TX_ABORTED:
+		if (tx_sync) {
+			k_sem_give(&tx_sync_done);
+			break;
+		}
 		k_free(uart_tx_buf);
 		k_sem_give(&tx_done);
 		LOG_INF("TX_ABORTED");
 		break;
 	case UART_RX_RDY:
+		if (atomic_get(&binmode_active)) {
+			binmode_rx(&evt->data.rx.buf[pos], evt->data.rx.len);
+			pos += evt->data.rx.len;
+			break;
+		}
 		for (int i = pos; i < (pos + evt->data.rx.len); i++) {
 			uart_rx_handler(evt->data.rx.buf[i]);
 		}
@@ -642,6 +739,9 @@ static void uart_callback(const struct device *dev, struct uart_event *evt,
 		break;
 	case UART_RX_DISABLED:
 		LOG_DBG("RX_DISABLED");
+		if (atomic_get(&binmode_rx_paused)) {
+			k_work_submit(&binmode_work);
+		}
 		break;
 	default:
 		break;
@@ -761,7 +861,14 @@ int slm_at_host_init(void)
 		return -EFAULT;
 	}
 #endif
+	err = slm_at_cmd_table_init();
+	if (err) {
+		return err;
+	}
+	host_idle = false;
+
 	k_work_init(&cmd_send_work, cmd_send);
+	k_work_init(&binmode_work, binmode_work_fn);
 	k_sem_give(&tx_done);
 	rsp_send(SLM_SYNC_STR, sizeof(SLM_SYNC_STR)-1);
 
@@ -828,6 +935,8 @@ void slm_at_host_uninit(void)
 		LOG_WRN("Can't deregister handler: %d", err);
 	}
 #endif
+	atomic_set(&binmode_active, false);
+
 	/* Power off UART module */
 	uart_rx_disable(uart_dev);
 	k_sleep(K_MSEC(100));
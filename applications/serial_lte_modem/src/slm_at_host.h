@@ -13,20 +13,14 @@
  * @{
  */
 
+#include <zephyr.h>
 #include <zephyr/types.h>
+#include <stdbool.h>
 #include <ctype.h>
 #include <modem/at_cmd_parser.h>
 #include <modem/at_cmd.h>
-
-/**@brief AT command handler type. */
-typedef int (*slm_at_handler_t) (enum at_cmd_type);
-
-/**@brief AT command list item type. */
-typedef struct slm_at_cmd_list {
-	uint8_t type;
-	char *string;
-	slm_at_handler_t handler;
-} slm_at_cmd_list_t;
+#include "slm_at_cmd.h"
+#include "slm_binmode.h"
 
 /**@brief Arbitrary data type over AT channel. */
 enum slm_data_type_t {
@@ -37,6 +31,50 @@ enum slm_data_type_t {
 	DATATYPE_OMATLV
 };
 
+/**
+ * @brief Enter binary data mode
+ *
+ * In binary data mode, the UART carries length-prefixed frames instead of
+ * AT commands. Each frame starts with its payload length as a 16-bit
+ * big-endian value. A zero-length frame from the host exits the mode.
+ * The mode starts after the response to the current AT command.
+ *
+ * @param handler Handler for the frames received from the host.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_at_host_binmode_enter(slm_binmode_handler_t handler);
+
+/**
+ * @brief Exit binary data mode
+ *
+ * A zero-length frame is sent to notify the host, which can then send AT
+ * commands again.
+ */
+void slm_at_host_binmode_exit(void);
+
+/**
+ * @brief Check if binary data mode is active
+ *
+ * @retval true If binary data mode is active.
+ */
+bool slm_at_host_binmode_is_active(void);
+
+/**
+ * @brief Send a data frame to the host in binary data mode
+ *
+ * The payload is sent from the buffer of the caller, without copying.
+ * The function returns when the frame has been sent.
+ *
+ * @param data Frame payload.
+ * @param len Length of the frame payload.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_at_host_binmode_send(const uint8_t *data, size_t len);
+
 /**
  * @brief Initialize AT host for serial LTE modem
  *
@@ -36,7 +36,9 @@ enum slm_tcp_proxy_operation {
 	AT_FILTER_SET =  AT_SERVER_START,
 	AT_CLIENT_CONNECT = AT_SERVER_START,
 	AT_SERVER_START_WITH_DATAMODE,
-	AT_CLIENT_CONNECT_WITH_DATAMODE = AT_SERVER_START_WITH_DATAMODE
+	AT_CLIENT_CONNECT_WITH_DATAMODE = AT_SERVER_START_WITH_DATAMODE,
+	AT_SERVER_START_WITH_BINMODE,
+	AT_CLIENT_CONNECT_WITH_BINMODE = AT_SERVER_START_WITH_BINMODE
 };
 
 /**@brief Proxy roles. */
@@ -45,16 +47,6 @@ enum slm_tcp_proxy_role {
 	AT_TCP_ROLE_SERVER
 };
 
-/**@brief List of supported AT commands. */
-enum slm_tcp_proxy_at_cmd_type {
-	AT_TCP_FILTER,
-	AT_TCP_SERVER,
-	AT_TCP_CLIENT,
-	AT_TCP_SEND,
-	AT_TCP_RECV,
-	AT_TCP_PROXY_MAX
-};
-
 /** forward declaration of cmd handlers **/
 static int handle_at_tcp_filter(enum at_cmd_type cmd_type);
 static int handle_at_tcp_server(enum at_cmd_type cmd_type);
@@ -62,14 +54,17 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type);
 static int handle_at_tcp_send(enum at_cmd_type cmd_type);
 static int handle_at_tcp_recv(enum at_cmd_type cmd_type);
 
-/**@brief SLM AT Command list type. */
-static slm_at_cmd_list_t tcp_proxy_at_list[AT_TCP_PROXY_MAX] = {
-	{AT_TCP_FILTER, "AT#XTCPFILTER", handle_at_tcp_filter},
-	{AT_TCP_SERVER, "AT#XTCPSVR", handle_at_tcp_server},
-	{AT_TCP_CLIENT, "AT#XTCPCLI", handle_at_tcp_client},
-	{AT_TCP_SEND, "AT#XTCPSEND", handle_at_tcp_send},
-	{AT_TCP_RECV, "AT#XTCPRECV", handle_at_tcp_recv},
-};
+/* AT commands handled by this module */
+SLM_AT_CMD_DEFINE(tcpfilter, "AT#XTCPFILTER", handle_at_tcp_filter,
+		  SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DATAMODE_DEFINE(tcpsvr, "AT#XTCPSVR", handle_at_tcp_server,
+			   SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DATAMODE_DEFINE(tcpcli, "AT#XTCPCLI", handle_at_tcp_client,
+			   SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DEFINE(tcpsend, "AT#XTCPSEND", handle_at_tcp_send,
+		  SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DEFINE(tcprecv, "AT#XTCPRECV", handle_at_tcp_recv,
+		  SLM_AT_RSP_OK_OR_NONE);
 
 static char ip_allowlist[CONFIG_SLM_TCP_FILTER_SIZE][INET_ADDRSTRLEN];
 RING_BUF_DECLARE(data_buf, CONFIG_AT_CMD_RESPONSE_MAX_LEN / 2);
@@ -85,6 +80,7 @@ static struct tcp_proxy_t {
 	int sock_peer;		/* Socket descriptor for peer. */
 	int role;		/* Client or Server proxy */
 	bool datamode;		/* Data mode flag*/
+	bool binmode;		/* Binary data mode flag */
 	bool filtermode;	/* Filtering mode flag */
 } proxy;
 static struct pollfd fds[MAX_POLL_FD];
@@ -448,11 +444,41 @@ static int tcp_data_save(uint8_t *data, uint32_t length)
 	return ring_buf_put(&data_buf, data, length);
 }
 
+static int tcp_binmode_handler(const uint8_t *data, size_t len)
+{
+	return do_tcp_send_datamode(data, len);
+}
+
+static int tcp_binmode_enter(void)
+{
+	int err;
+
+	err = slm_at_host_binmode_enter(tcp_binmode_handler);
+	if (err == 0) {
+		proxy.binmode = true;
+	}
+
+	return err;
+}
+
+static void tcp_binmode_exit(void)
+{
+	if (proxy.binmode) {
+		slm_at_host_binmode_exit();
+		proxy.binmode = false;
+	}
+}
+
 static void tcp_data_handle(uint8_t *data, uint32_t length)
 {
 	int ret;
 
-	if (proxy.datamode) {
+	if (proxy.binmode && slm_at_host_binmode_is_active()) {
+		ret = slm_at_host_binmode_send(data, length);
+		if (ret) {
+			LOG_ERR("binary data send error: %d", ret);
+		}
+	} else if (proxy.datamode) {
 		rsp_send(data, length);
 	} else if (slm_util_hex_check(data, length)) {
 		ret = slm_util_htoa(data, length, data_hex, DATA_HEX_MAX_SIZE);
@@ -666,6 +692,7 @@ exit:
 		}
 	}
 #endif
+	tcp_binmode_exit();
 	slm_at_tcp_proxy_init();
 	sprintf(rsp_buf, "#XTCPSVR: %d stopped\r\n", ret);
 	rsp_send(rsp_buf, strlen(rsp_buf));
@@ -729,6 +756,7 @@ exit:
 			LOG_WRN("close(%d) fail: %d", proxy.sock, -errno);
 		}
 	}
+	tcp_binmode_exit();
 	slm_at_tcp_proxy_init();
 	sprintf(rsp_buf, "#XTCPCLI: %d disconnected\r\n", ret);
 	rsp_send(rsp_buf, strlen(rsp_buf));
@@ -826,7 +854,8 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 			return err;
 		}
 		if (op == AT_SERVER_START ||
-		    op == AT_SERVER_START_WITH_DATAMODE) {
+		    op == AT_SERVER_START_WITH_DATAMODE ||
+		    op == AT_SERVER_START_WITH_BINMODE) {
 			uint16_t port;
 
 			if (proxy.sock != INVALID_SOCKET) {
@@ -845,6 +874,12 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 			if (err == 0 && op == AT_SERVER_START_WITH_DATAMODE) {
 				proxy.datamode = true;
 			}
+			if (err == 0 && op == AT_SERVER_START_WITH_BINMODE) {
+				err = tcp_binmode_enter();
+				if (err) {
+					(void)do_tcp_server_stop();
+				}
+			}
 		} else if (op == AT_SERVER_STOP) {
 			err = do_tcp_server_stop();
 		} break;
@@ -863,9 +898,11 @@ static int handle_at_tcp_server(enum at_cmd_type cmd_type)
 		break;
 
 	case AT_CMD_TYPE_TEST_COMMAND:
-		sprintf(rsp_buf, "#XTCPSVR: (%d, %d, %d),<port>,<sec_tag>\r\n",
+		sprintf(rsp_buf,
+			"#XTCPSVR: (%d, %d, %d, %d),<port>,<sec_tag>\r\n",
 			AT_SERVER_STOP, AT_SERVER_START,
-			AT_SERVER_START_WITH_DATAMODE);
+			AT_SERVER_START_WITH_DATAMODE,
+			AT_SERVER_START_WITH_BINMODE);
 		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
@@ -895,7 +932,8 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 			return err;
 		}
 		if (op == AT_CLIENT_CONNECT ||
-		    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
+		    op == AT_CLIENT_CONNECT_WITH_DATAMODE ||
+		    op == AT_CLIENT_CONNECT_WITH_BINMODE) {
 			uint16_t port;
 			char url[TCPIP_MAX_URL];
 			int size = TCPIP_MAX_URL;
@@ -923,6 +961,13 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 			    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
 				proxy.datamode = true;
 			}
+			if (err == 0 &&
+			    op == AT_CLIENT_CONNECT_WITH_BINMODE) {
+				err = tcp_binmode_enter();
+				if (err) {
+					(void)do_tcp_client_disconnect();
+				}
+			}
 		} else if (op == AT_CLIENT_DISCONNECT) {
 			err = do_tcp_client_disconnect();
 		} break;
@@ -941,9 +986,10 @@ static int handle_at_tcp_client(enum at_cmd_type cmd_type)
 
 	case AT_CMD_TYPE_TEST_COMMAND:
 		sprintf(rsp_buf,
-			"#XTCPCLI: (%d, %d, %d),<url>,<port>,<sec_tag>\r\n",
+			"#XTCPCLI: (%d, %d, %d, %d),<url>,<port>,<sec_tag>\r\n",
 			AT_CLIENT_DISCONNECT, AT_CLIENT_CONNECT,
-			AT_CLIENT_CONNECT_WITH_DATAMODE);
+			AT_CLIENT_CONNECT_WITH_DATAMODE,
+			AT_CLIENT_CONNECT_WITH_BINMODE);
 		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
@@ -1038,44 +1084,15 @@ static int handle_at_tcp_recv(enum at_cmd_type cmd_type)
 	return err;
 }
 
-/**@brief API to handle TCP proxy AT commands
+/**@brief API to send data in TCP proxy data mode
  */
-int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length)
+int slm_at_tcp_proxy_datamode_send(const uint8_t *data, size_t len)
 {
-	int ret = -ENOENT;
-	enum at_cmd_type type;
-
-	for (int i = 0; i < AT_TCP_PROXY_MAX; i++) {
-		if (slm_util_cmd_casecmp(at_cmd,
-			tcp_proxy_at_list[i].string)) {
-			ret = at_parser_params_from_str(at_cmd, NULL,
-						&at_param_list);
-			if (ret) {
-				LOG_ERR("Failed to parse AT command %d", ret);
-				return -EINVAL;
-			}
-			type = at_parser_cmd_type_get(at_cmd);
-			ret = tcp_proxy_at_list[i].handler(type);
-			break;
-		}
-	}
-
-	/* handle sending in data mode */
-	if (ret == -ENOENT && proxy.datamode) {
-		ret = do_tcp_send_datamode(at_cmd, length);
+	if (!proxy.datamode) {
+		return -ENOENT;
 	}
 
-	return ret;
-}
-
-/**@brief API to list TCP proxy AT commands
- */
-void slm_at_tcp_proxy_clac(void)
-{
-	for (int i = 0; i < AT_TCP_PROXY_MAX; i++) {
-		sprintf(rsp_buf, "%s\r\n", tcp_proxy_at_list[i].string);
-		rsp_send(rsp_buf, strlen(rsp_buf));
-	}
+	return do_tcp_send_datamode(data, len);
 }
 
 /**@brief API to initialize TCP proxy AT commands handler
@@ -1086,6 +1103,7 @@ int slm_at_tcp_proxy_init(void)
 	proxy.sock_peer = INVALID_SOCKET;
 	proxy.role = INVALID_ROLE;
 	proxy.datamode = false;
+	proxy.binmode = false;
 	proxy.sec_tag = INVALID_SEC_TAG;
 	nfds = 0;
 	for (int i = 0; i < MAX_POLL_FD; i++) {
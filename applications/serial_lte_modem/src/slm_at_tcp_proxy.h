@@ -17,22 +17,16 @@
 #include <modem/at_cmd.h>
 
 /**
- * @brief TCP proxy AT command parser.
+ * @brief Send data in TCP proxy data mode.
  *
- * @param at_cmd AT command or data string.
- * @param length AT command or data string length.
- *
- * @retval 0 If the operation was successful.
- *           Otherwise, negative code means error.
- *           Otherwise, positive code means data is sent in data mode.
- */
-int slm_at_tcp_proxy_parse(const char *at_cmd, uint16_t length);
-
-/**
- * @brief List TCP proxy AT commands.
+ * @param data Data received from the host.
+ * @param len Length of the data.
  *
+ * @retval -ENOENT If data mode is not active.
+ *           Otherwise, positive code means data is sent,
+ *           negative code means error.
  */
-void slm_at_tcp_proxy_clac(void);
+int slm_at_tcp_proxy_datamode_send(const uint8_t *data, size_t len);
 
 /**
  * @brief Initialize TCP proxy AT command parser.
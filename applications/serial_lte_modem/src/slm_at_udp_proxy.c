@@ -35,15 +35,9 @@ enum slm_udp_proxy_operation {
 	AT_SERVER_START,
 	AT_CLIENT_CONNECT = AT_SERVER_START,
 	AT_SERVER_START_WITH_DATAMODE,
-	AT_CLIENT_CONNECT_WITH_DATAMODE = AT_SERVER_START_WITH_DATAMODE
-};
-
-/**@brief List of supported AT commands. */
-enum slm_udp_proxy_at_cmd_type {
-	AT_UDP_SERVER,
-	AT_UDP_CLIENT,
-	AT_UDP_SEND,
-	AT_UDP_PROXY_MAX
+	AT_CLIENT_CONNECT_WITH_DATAMODE = AT_SERVER_START_WITH_DATAMODE,
+	AT_SERVER_START_WITH_BINMODE,
+	AT_CLIENT_CONNECT_WITH_BINMODE = AT_SERVER_START_WITH_BINMODE
 };
 
 /** forward declaration of cmd handlers **/
@@ -51,12 +45,13 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type);
 static int handle_at_udp_client(enum at_cmd_type cmd_type);
 static int handle_at_udp_send(enum at_cmd_type cmd_type);
 
-/**@brief SLM AT Command list type. */
-static slm_at_cmd_list_t udp_proxy_at_list[AT_UDP_PROXY_MAX] = {
-	{AT_UDP_SERVER, "AT#XUDPSVR", handle_at_udp_server},
-	{AT_UDP_CLIENT, "AT#XUDPCLI", handle_at_udp_client},
-	{AT_UDP_SEND, "AT#XUDPSEND", handle_at_udp_send},
-};
+/* AT commands handled by this module */
+SLM_AT_CMD_DATAMODE_DEFINE(udpsvr, "AT#XUDPSVR", handle_at_udp_server,
+			   SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DATAMODE_DEFINE(udpcli, "AT#XUDPCLI", handle_at_udp_client,
+			   SLM_AT_RSP_OK_OR_NONE);
+SLM_AT_CMD_DEFINE(udpsend, "AT#XUDPSEND", handle_at_udp_send,
+		  SLM_AT_RSP_OK_OR_NONE);
 
 static uint8_t data_hex[DATA_HEX_MAX_SIZE];
 static struct k_thread udp_thread;
@@ -66,6 +61,7 @@ static k_tid_t udp_thread_id;
 static struct sockaddr_in remote;
 static int udp_sock;
 static bool udp_datamode;
+static bool udp_binmode;
 
 /* global functions defined in different files */
 void rsp_send(const uint8_t *str, size_t len);
@@ -77,6 +73,33 @@ extern char rsp_buf[CONFIG_AT_CMD_RESPONSE_MAX_LEN];
 
 /** forward declaration of thread function **/
 static void udp_thread_func(void *p1, void *p2, void *p3);
+static int do_udp_send_datamode(const uint8_t *data, int datalen);
+
+static int udp_binmode_handler(const uint8_t *data, size_t len)
+{
+	/* Each frame is sent as one datagram */
+	return do_udp_send_datamode(data, len);
+}
+
+static int udp_binmode_enter(void)
+{
+	int err;
+
+	err = slm_at_host_binmode_enter(udp_binmode_handler);
+	if (err == 0) {
+		udp_binmode = true;
+	}
+
+	return err;
+}
+
+static void udp_binmode_exit(void)
+{
+	if (udp_binmode) {
+		slm_at_host_binmode_exit();
+		udp_binmode = false;
+	}
+}
 
 static int do_udp_server_start(uint16_t port)
 {
@@ -153,6 +176,7 @@ static int do_udp_server_stop(int error)
 			LOG_WRN("close() failed: %d", -errno);
 			ret = -errno;
 		}
+		udp_binmode_exit();
 		(void)slm_at_udp_proxy_init();
 		if (error) {
 			sprintf(rsp_buf, "#XUDPSVR: %d stopped\r\n", error);
@@ -261,6 +285,7 @@ static int do_udp_client_disconnect(void)
 			LOG_WRN("close() failed: %d", -errno);
 			ret = -errno;
 		}
+		udp_binmode_exit();
 		(void)slm_at_udp_proxy_init();
 		sprintf(rsp_buf, "#XUDPCLI: disconnected\r\n");
 		rsp_send(rsp_buf, strlen(rsp_buf));
@@ -350,10 +375,12 @@ static void udp_thread_func(void *p1, void *p2, void *p3)
 		LOG_DBG("Poll events 0x%08x", fds.revents);
 		if ((fds.revents & POLLERR) == POLLERR) {
 			LOG_DBG("Socket error");
+			udp_binmode_exit();
 			return;
 		}
 		if ((fds.revents & POLLNVAL) == POLLNVAL) {
 			LOG_DBG("Socket closed");
+			udp_binmode_exit();
 			return;
 		}
 		if ((fds.revents & POLLIN) != POLLIN) {
@@ -369,7 +396,12 @@ static void udp_thread_func(void *p1, void *p2, void *p3)
 		if (ret == 0) {
 			continue;
 		}
-		if (udp_datamode) {
+		if (udp_binmode && slm_at_host_binmode_is_active()) {
+			ret = slm_at_host_binmode_send(data, ret);
+			if (ret) {
+				LOG_WRN("binary data send error: %d", ret);
+			}
+		} else if (udp_datamode) {
 			rsp_send(data, ret);
 		} else if (slm_util_hex_check(data, ret)) {
 			ret = slm_util_htoa(data, ret, data_hex,
@@ -416,7 +448,8 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type)
 			return err;
 		}
 		if (op == AT_SERVER_START ||
-		    op == AT_SERVER_START_WITH_DATAMODE) {
+		    op == AT_SERVER_START_WITH_DATAMODE ||
+		    op == AT_SERVER_START_WITH_BINMODE) {
 			uint16_t port;
 
 			if (param_count < 3) {
@@ -434,6 +467,12 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type)
 			if (err == 0 && op == AT_SERVER_START_WITH_DATAMODE) {
 				udp_datamode = true;
 			}
+			if (err == 0 && op == AT_SERVER_START_WITH_BINMODE) {
+				err = udp_binmode_enter();
+				if (err) {
+					(void)do_udp_server_stop(err);
+				}
+			}
 		} else if (op == AT_SERVER_STOP) {
 			if (udp_sock < 0) {
 				LOG_WRN("Server is not running");
@@ -455,9 +494,11 @@ static int handle_at_udp_server(enum at_cmd_type cmd_type)
 		break;
 
 	case AT_CMD_TYPE_TEST_COMMAND:
-		sprintf(rsp_buf, "#XUDPSVR: (%d, %d, %d),<port>,<sec_tag>\r\n",
+		sprintf(rsp_buf,
+			"#XUDPSVR: (%d, %d, %d, %d),<port>,<sec_tag>\r\n",
 			AT_SERVER_STOP, AT_SERVER_START,
-			AT_SERVER_START_WITH_DATAMODE);
+			AT_SERVER_START_WITH_DATAMODE,
+			AT_SERVER_START_WITH_BINMODE);
 		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
@@ -490,7 +531,8 @@ static int handle_at_udp_client(enum at_cmd_type cmd_type)
 			return err;
 		}
 		if (op == AT_CLIENT_CONNECT ||
-		    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
+		    op == AT_CLIENT_CONNECT_WITH_DATAMODE ||
+		    op == AT_CLIENT_CONNECT_WITH_BINMODE) {
 			uint16_t port;
 			char url[TCPIP_MAX_URL];
 			int size = TCPIP_MAX_URL;
@@ -517,6 +559,13 @@ static int handle_at_udp_client(enum at_cmd_type cmd_type)
 			    op == AT_CLIENT_CONNECT_WITH_DATAMODE) {
 				udp_datamode = true;
 			}
+			if (err == 0 &&
+			    op == AT_CLIENT_CONNECT_WITH_BINMODE) {
+				err = udp_binmode_enter();
+				if (err) {
+					(void)do_udp_client_disconnect();
+				}
+			}
 		} else if (op == AT_CLIENT_DISCONNECT) {
 			if (udp_sock < 0) {
 				LOG_WRN("Client is not connected");
@@ -539,9 +588,10 @@ static int handle_at_udp_client(enum at_cmd_type cmd_type)
 
 	case AT_CMD_TYPE_TEST_COMMAND:
 		sprintf(rsp_buf,
-			"#XUDPCLI: (%d, %d, %d),<url>,<port>,<sec_tag>\r\n",
+			"#XUDPCLI: (%d, %d, %d, %d),<url>,<port>,<sec_tag>\r\n",
 			AT_CLIENT_DISCONNECT, AT_CLIENT_CONNECT,
-			AT_CLIENT_CONNECT_WITH_DATAMODE);
+			AT_CLIENT_CONNECT_WITH_DATAMODE,
+			AT_CLIENT_CONNECT_WITH_BINMODE);
 		rsp_send(rsp_buf, strlen(rsp_buf));
 		err = 0;
 		break;
@@ -601,44 +651,15 @@ static int handle_at_udp_send(enum at_cmd_type cmd_type)
 	return err;
 }
 
-/**@brief API to handle UDP Proxy AT commands
+/**@brief API to send data in UDP Proxy data mode
  */
-int slm_at_udp_proxy_parse(const char *at_cmd, uint16_t length)
+int slm_at_udp_proxy_datamode_send(const uint8_t *data, size_t len)
 {
-	int ret = -ENOENT;
-	enum at_cmd_type type;
-
-	for (int i = 0; i < AT_UDP_PROXY_MAX; i++) {
-		if (slm_util_cmd_casecmp(at_cmd,
-					udp_proxy_at_list[i].string)) {
-			ret = at_parser_params_from_str(at_cmd, NULL,
-						&at_param_list);
-			if (ret) {
-				LOG_ERR("Failed to parse AT command %d", ret);
-				return -EINVAL;
-			}
-			type = at_parser_cmd_type_get(at_cmd);
-			ret = udp_proxy_at_list[i].handler(type);
-			break;
-		}
+	if (!udp_datamode) {
+		return -ENOENT;
 	}
 
-	/* handle sending in data mode */
-	if (ret == -ENOENT && udp_datamode) {
-		ret = do_udp_send_datamode(at_cmd, length);
-	}
-
-	return ret;
-}
-
-/**@brief API to list UDP Proxy AT commands
- */
-void slm_at_udp_proxy_clac(void)
-{
-	for (int i = 0; i < AT_UDP_PROXY_MAX; i++) {
-		sprintf(rsp_buf, "%s\r\n", udp_proxy_at_list[i].string);
-		rsp_send(rsp_buf, strlen(rsp_buf));
-	}
+	return do_udp_send_datamode(data, len);
 }
 
 /**@brief API to initialize UDP Proxy AT commands handler
@@ -647,6 +668,7 @@ int slm_at_udp_proxy_init(void)
 {
 	udp_sock = INVALID_SOCKET;
 	udp_datamode = false;
+	udp_binmode = false;
 	remote.sin_family = AF_UNSPEC;
 	remote.sin_port = INVALID_PORT;
 
@@ -661,6 +683,7 @@ int slm_at_udp_proxy_uninit(void)
 
 	if (udp_sock != INVALID_SOCKET) {
 		k_thread_abort(udp_thread_id);
+		udp_binmode = false;
 		ret = close(udp_sock);
 		if (ret < 0) {
 			LOG_WRN("close() failed: %d", -errno);
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <logging/log.h>
+#include <sys/ring_buffer.h>
+#include <sys/byteorder.h>
+#include <sys/atomic.h>
+
+LOG_MODULE_REGISTER(binmode, CONFIG_SLM_LOG_LEVEL);
+
+#include "slm_binmode.h"
+
+#define BINMODE_HDR_LEN	2
+#define BINMODE_FRAME_MAX_LEN CONFIG_SLM_BINMODE_FRAME_MAX_LEN
+
+BUILD_ASSERT(BINMODE_FRAME_MAX_LEN <= UINT16_MAX,
+	     "Binary data mode frame length does not fit the header");
+/* A full frame must fit while the reception is paused, otherwise it would
+ * never be resumed.
+ */
+BUILD_ASSERT(BINMODE_FRAME_MAX_LEN + BINMODE_HDR_LEN +
+	     SLM_BINMODE_RX_HEADROOM <= CONFIG_SLM_BINMODE_BUF_SIZE,
+	     "Binary data mode buffer cannot hold a full frame");
+
+static slm_binmode_handler_t frame_handler;
+static int32_t frame_len;
+static uint8_t frame[BINMODE_FRAME_MAX_LEN];
+static atomic_t overrun;
+RING_BUF_DECLARE(rx_buf, CONFIG_SLM_BINMODE_BUF_SIZE);
+
+void slm_binmode_rx_init(slm_binmode_handler_t handler)
+{
+	frame_handler = handler;
+	frame_len = -1;
+	ring_buf_reset(&rx_buf);
+	atomic_set(&overrun, false);
+}
+
+int slm_binmode_rx_put(const uint8_t *data, size_t len)
+{
+	uint32_t written;
+
+	/* Once data is lost, the frame boundaries are unknown. */
+	if (atomic_get(&overrun)) {
+		return -ENOBUFS;
+	}
+
+	/* Whole DMA chunks are copied, no per-byte processing */
+	written = ring_buf_put(&rx_buf, data, len);
+	if (written < len) {
+		atomic_set(&overrun, true);
+		return -ENOBUFS;
+	}
+
+	return 0;
+}
+
+bool slm_binmode_rx_space_low(void)
+{
+	return ring_buf_space_get(&rx_buf) < SLM_BINMODE_RX_HEADROOM;
+}
+
+int slm_binmode_rx_frame_process(void)
+{
+	uint8_t hdr[BINMODE_HDR_LEN];
+	uint8_t *data;
+	uint32_t used;
+	uint32_t len;
+	int err;
+
+	if (atomic_get(&overrun)) {
+		LOG_ERR("Binary data mode RX overrun");
+		return -ENOBUFS;
+	}
+
+	used = ring_buf_capacity_get(&rx_buf) - ring_buf_space_get(&rx_buf);
+
+	if (frame_len < 0) {
+		if (used < sizeof(hdr)) {
+			return 0;
+		}
+
+		ring_buf_get(&rx_buf, hdr, sizeof(hdr));
+		used -= sizeof(hdr);
+		frame_len = sys_get_be16(hdr);
+
+		if (frame_len == 0) {
+			frame_len = -1;
+			return -ECANCELED;
+		}
+		if (frame_len > BINMODE_FRAME_MAX_LEN) {
+			LOG_ERR("Frame too long: %d", frame_len);
+			return -EMSGSIZE;
+		}
+	}
+
+	if (used < (uint32_t)frame_len) {
+		return 0;
+	}
+
+	/* Hand the frame over from the ring buffer when it is contiguous,
+	 * otherwise copy it out first.
+	 */
+	len = ring_buf_get_claim(&rx_buf, &data, frame_len);
+	if (len < (uint32_t)frame_len) {
+		ring_buf_get_finish(&rx_buf, 0);
+		ring_buf_get(&rx_buf, frame, frame_len);
+		data = frame;
+	}
+
+	err = frame_handler(data, frame_len);
+	if (err < 0) {
+		LOG_WRN("Frame not handled: %d", err);
+	}
+
+	if (data != frame) {
+		ring_buf_get_finish(&rx_buf, frame_len);
+	}
+
+	frame_len = -1;
+
+	return 1;
+}
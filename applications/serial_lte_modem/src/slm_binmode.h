@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef SLM_BINMODE_
+#define SLM_BINMODE_
+
+/**@file slm_binmode.h
+ *
+ * @brief Frame receiver of the binary data mode for serial LTE modem
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+/**
+ * Free space kept in the receive buffer when the receiver is paused. It holds
+ * the data that the UART still delivers after reception is stopped.
+ */
+#define SLM_BINMODE_RX_HEADROOM 512
+
+/**@brief Handler for a data frame received in binary data mode.
+ *
+ * @param data Frame payload.
+ * @param len Length of the frame payload.
+ *
+ * @retval Number of bytes handled, or a negative error code.
+ */
+typedef int (*slm_binmode_handler_t)(const uint8_t *data, size_t len);
+
+/**
+ * @brief Initialize the frame receiver
+ *
+ * Any data left in the receive buffer is discarded.
+ *
+ * @param handler Handler for the received frames.
+ */
+void slm_binmode_rx_init(slm_binmode_handler_t handler);
+
+/**
+ * @brief Add data received from the host
+ *
+ * This function can be called from an interrupt.
+ *
+ * @param data Received data.
+ * @param len Length of the received data.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -ENOBUFS If data was lost. The frames cannot be received anymore.
+ */
+int slm_binmode_rx_put(const uint8_t *data, size_t len);
+
+/**
+ * @brief Check if the reception must be paused
+ *
+ * @retval true If the free space in the receive buffer is below
+ *              @ref SLM_BINMODE_RX_HEADROOM.
+ */
+bool slm_binmode_rx_space_low(void);
+
+/**
+ * @brief Pass the next received frame to the handler
+ *
+ * @retval 1 If a frame was passed to the handler.
+ * @retval 0 If no complete frame has been received.
+ * @retval -ECANCELED If the host ended the binary data mode.
+ * @retval -ENOBUFS If received data was lost.
+ * @retval -EMSGSIZE If the host sent a frame that is too long.
+ */
+int slm_binmode_rx_frame_process(void);
+
+/** @} */
+
+#endif /* SLM_BINMODE_ */
@@ -7,15 +7,154 @@
 #include "cJSON_os.h"
 #include "cJSON.h"
 #include <stdint.h>
+#include <string.h>
 #include <zephyr.h>
 
 static cJSON_Hooks _cjson_hooks;
 
+#if defined(CONFIG_CJSON_ARENA)
+
+/* Alignment of the arena allocations, cJSON items hold a double. */
+#define ARENA_ALIGN 8
+
+static uint8_t __aligned(ARENA_ALIGN) arena_buf[CONFIG_CJSON_ARENA_SIZE];
+static K_MUTEX_DEFINE(arena_mutex);
+static k_tid_t arena_owner;
+static int arena_depth;
+static size_t arena_used;
+static struct cJSON_ArenaStats arena_stats = {
+	.size = sizeof(arena_buf),
+};
+
+static bool arena_contains(const void *ptr)
+{
+	return ((const uint8_t *)ptr >= arena_buf) &&
+	       ((const uint8_t *)ptr < arena_buf + sizeof(arena_buf));
+}
+
+static void *arena_alloc(size_t sz)
+{
+	size_t len = ROUND_UP(sz, ARENA_ALIGN);
+	void *ptr;
+
+	if ((arena_owner != k_current_get()) || (len == 0)) {
+		return NULL;
+	}
+
+	if (len > sizeof(arena_buf) - arena_used) {
+		arena_stats.overflows++;
+		return NULL;
+	}
+
+	ptr = &arena_buf[arena_used];
+	arena_used += len;
+	arena_stats.arena_allocs++;
+	arena_stats.peak = MAX(arena_stats.peak, arena_used);
+
+	return ptr;
+}
+
+int cJSON_ArenaBegin(void)
+{
+	/* The mutex is recursive, so the owner can nest scopes. */
+	if (k_mutex_lock(&arena_mutex, K_NO_WAIT) != 0) {
+		return -EBUSY;
+	}
+
+	if (arena_depth++ == 0) {
+		arena_owner = k_current_get();
+		arena_used = 0;
+	}
+
+	return 0;
+}
+
+void cJSON_ArenaEnd(void)
+{
+	/* Scopes that did not get the arena have nothing to release. */
+	if (arena_owner != k_current_get()) {
+		return;
+	}
+
+	if (--arena_depth == 0) {
+		arena_owner = NULL;
+		arena_used = 0;
+	}
+
+	k_mutex_unlock(&arena_mutex);
+}
+
+char *cJSON_ArenaPrintUnformatted(const cJSON *item)
+{
+	char *tmp = (char *)&arena_buf[arena_used];
+	size_t free_len = sizeof(arena_buf) - arena_used;
+	char *str;
+	size_t len;
+
+	if (arena_owner != k_current_get()) {
+		return cJSON_PrintUnformatted(item);
+	}
+
+	/* Print to the free end of the arena, so the growing print buffers
+	 * do not use the arena, and copy the result to the heap.
+	 */
+	if (!cJSON_PrintPreallocated((cJSON *)item, tmp, free_len, false)) {
+		/* Too large for the arena, print to the heap instead. */
+		arena_stats.overflows++;
+		arena_owner = NULL;
+		str = cJSON_PrintUnformatted(item);
+		arena_owner = k_current_get();
+
+		return str;
+	}
+
+	len = strlen(tmp) + 1;
+	arena_stats.peak = MAX(arena_stats.peak, arena_used + len);
+
+	str = k_malloc(len);
+	if (str != NULL) {
+		arena_stats.heap_allocs++;
+		memcpy(str, tmp, len);
+	}
+
+	return str;
+}
+
+void cJSON_ArenaStatsGet(struct cJSON_ArenaStats *stats)
+{
+	k_mutex_lock(&arena_mutex, K_FOREVER);
+	*stats = arena_stats;
+	k_mutex_unlock(&arena_mutex);
+}
+
+#endif /* CONFIG_CJSON_ARENA */
+
 /**@brief malloc() function definition. */
-static void *malloc_fn_hook(size_t sz) { return k_malloc(sz); }
+static void *malloc_fn_hook(size_t sz)
+{
+#if defined(CONFIG_CJSON_ARENA)
+	void *ptr = arena_alloc(sz);
+
+	if (ptr != NULL) {
+		return ptr;
+	}
+
+	arena_stats.heap_allocs++;
+#endif
+	return k_malloc(sz);
+}
 
 /**@brief free() function definition. */
-static void free_fn_hook(void *p_ptr) { k_free(p_ptr); }
+static void free_fn_hook(void *p_ptr)
+{
+#if defined(CONFIG_CJSON_ARENA)
+	/* Arena memory is released at the end of the scope. */
+	if (arena_contains(p_ptr)) {
+		return;
+	}
+#endif
+	k_free(p_ptr);
+}
 
 /**@brief Initialize cJSON by assigning function hooks. */
 void cJSON_Init(void)
@@ -8,6 +8,8 @@
 #define cJSON_OS_H__
 
 #include <stdint.h>
+#include <stddef.h>
+#include "cJSON.h"
 
 /**
  * @brief Initialize cJSON with OS hooks.
@@ -21,4 +23,78 @@ void cJSON_Init(void);
  */
 void cJSON_FreeString(char *ptr);
 
+/**@brief cJSON arena statistics. */
+struct cJSON_ArenaStats {
+	/** Size of the arena, in bytes. */
+	size_t size;
+	/** Highest number of bytes used in a scope. */
+	size_t peak;
+	/** Number of allocations served from the arena. */
+	uint32_t arena_allocs;
+	/** Number of allocations served from the heap. */
+	uint32_t heap_allocs;
+	/** Number of allocations in a scope that did not fit in the arena. */
+	uint32_t overflows;
+};
+
+#if defined(CONFIG_CJSON_ARENA)
+
+/**
+ * @brief Start allocating cJSON items and strings from the arena.
+ *
+ * @details Allocations made by the calling thread are served from the arena
+ *	    until cJSON_ArenaEnd() is called. Freeing an item allocated from
+ *	    the arena does nothing, the arena is released at once at the end
+ *	    of the scope. Items and strings allocated in the scope must not be
+ *	    used after the scope has ended, see cJSON_ArenaPrintUnformatted().
+ *	    Scopes can be nested by the same thread.
+ *
+ * @return 0 if the arena is used, or -EBUSY if it is in use by another
+ *	   thread. In that case, allocations are served from the heap and
+ *	   cJSON_ArenaEnd() must still be called.
+ */
+int cJSON_ArenaBegin(void);
+
+/**
+ * @brief End the scope started with cJSON_ArenaBegin().
+ *
+ * @details When the outermost scope ends, the arena is released.
+ */
+void cJSON_ArenaEnd(void);
+
+/**
+ * @brief Print a cJSON item to a heap buffer.
+ *
+ * @details The buffer can be used after the arena scope has ended, and must
+ *	    be freed with cJSON_FreeString().
+ *
+ * @param item IN -- item to print
+ * @return the printed string, or NULL on failure.
+ */
+char *cJSON_ArenaPrintUnformatted(const cJSON *item);
+
+/**
+ * @brief Get the arena statistics.
+ *
+ * @param stats OUT -- pointer to the structure where the statistics are
+ *			stored
+ */
+void cJSON_ArenaStatsGet(struct cJSON_ArenaStats *stats);
+
+#else
+
+static inline int cJSON_ArenaBegin(void)
+{
+	return 0;
+}
+
+static inline void cJSON_ArenaEnd(void) {}
+
+static inline char *cJSON_ArenaPrintUnformatted(const cJSON *item)
+{
+	return cJSON_PrintUnformatted(item);
+}
+
+#endif /* CONFIG_CJSON_ARENA */
+
 #endif /* cJSON_OS_H__ */
@@ -16,6 +16,7 @@
 
 #include <zephyr.h>
 #include <sys/__assert.h>
+#include <sys/atomic.h>
 #include <bluetooth/conn.h>
 
 #ifdef __cplusplus
@@ -47,15 +48,18 @@ struct bt_conn_ctx {
 
 	 /** The connection that the data is associated with. */
 	struct bt_conn *conn;
+
+	/** State of the context and number of references to it. */
+	atomic_t state;
 };
 
 /** @brief Bluetooth connection context library structure. */
 struct bt_conn_ctx_lib {
-	/** Connection contexts. */
+	/** Connection contexts, indexed by the connection index. */
 	struct bt_conn_ctx ctx[CONFIG_BT_MAX_CONN];
 
-	/** Context data mutex that ensures that only one connection context is
-	  * manipulated at a time. */
+	/** Context data mutex. The library does not take it. The users of
+	  * the library can take it to serialize access to the context data. */
 	struct k_mutex * const mutex;
 
 	/** Memory slab instance where the memory is allocated. */
@@ -91,6 +95,10 @@ static inline size_t bt_conn_ctx_count(struct bt_conn_ctx_lib *ctx_lib)
  *
  * This function can set the pointer to the allocated memory.
  *
+ * The context is stored at the index of the connection
+ * (see @ref bt_conn_index), so only one context can be allocated
+ * for the connection.
+ *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
  *
@@ -105,6 +113,10 @@ void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn);
 /**
  * @brief Free the allocated memory for a connection.
  *
+ * The context cannot be obtained after this function returns.
+ * If the context is still referenced, its memory is released when
+ * the last reference is released with @ref bt_conn_ctx_release.
+ *
  * @param ctx_lib	Bluetooth connection context library instance.
  * @param conn		Bluetooth connection.
  *
@@ -126,6 +138,12 @@ void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib);
  * This function finds a connection's context data in the memory pool.
  * The link to find is identified by the connection object.
  *
+ * The lookup takes constant time and does not block, so the function
+ * can be used in the notification path. The returned context holds
+ * a reference that keeps the memory allocated, but access to the data
+ * is not serialized between the users of the context. Take the mutex
+ * of the library instance to serialize it.
+ *
  * This function should be used in conjunction with
  * @ref bt_conn_ctx_release to ensure proper operation.
  *
@@ -158,8 +176,8 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
 /**
  * @brief Release a connection context from the memory pool.
  *
- * This function finds and releases a connection context in the memory pool.
- * The link to find is identified by its context data.
+ * This function finds and releases a reference to a connection context
+ * in the memory pool. The link to find is identified by its context data.
  *
  * This function should be used in conjunction with @ref bt_conn_ctx_alloc,
  * @ref bt_conn_ctx_get, or @ref bt_conn_ctx_get_by_id to ensure proper
@@ -264,9 +264,15 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * This function is asynchronous. Discovery results are passed through
  * the supplied callback.
  *
- * @note Only one discovery procedure can be started simultaneously. To start
- * another one, wait for the result of the previous procedure to finish
- * and call @ref bt_gatt_dm_data_release if it was successful.
+ * @note One discovery procedure can be started simultaneously on each
+ * connection, up to CONFIG_BT_MAX_CONN in total. To start another one on
+ * the same connection, wait for the result of the previous procedure to
+ * finish and call @ref bt_gatt_dm_data_release if it was successful.
+ *
+ * @note If CONFIG_BT_GATT_DM_CACHE is enabled, @p svc_uuid is set and the
+ * peer is bonded, the peer's Database Hash is read first. If it matches
+ * the one of a cached result, the discovery completes with the cached
+ * result without discovering the service again.
  *
  * @param[in]     conn Connection object.
  * @param[in]     svc_uuid UUID of target service
@@ -313,6 +319,21 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context);
  */
 int bt_gatt_dm_data_release(struct bt_gatt_dm *dm);
 
+/** @brief Remove cached discovery results.
+ *
+ * Call this function when a bond is removed, to release the memory used
+ * by the results of the peer.
+ *
+ * @param[in] addr Peer address, or NULL to remove all the cached results.
+ */
+#ifdef CONFIG_BT_GATT_DM_CACHE
+void bt_gatt_dm_cache_clear(const bt_addr_le_t *addr);
+#else
+static inline void bt_gatt_dm_cache_clear(const bt_addr_le_t *addr)
+{
+}
+#endif
+
 /** @brief Print service discovery data.
  *
  * This function prints GATT attributes that belong to the discovered service.
@@ -186,6 +186,46 @@ int bt_gatt_pool_ccc_alloc(struct bt_gatt_pool *gp,
 void bt_gatt_pool_free(struct bt_gatt_pool *gp);
 
 #if CONFIG_BT_GATT_POOL_STATS != 0
+/** @brief Internal pools of the module. */
+enum bt_gatt_pool_type {
+	/** Pool of 16-bit UUIDs. */
+	BT_GATT_POOL_TYPE_UUID16,
+	/** Pool of 32-bit UUIDs. */
+	BT_GATT_POOL_TYPE_UUID32,
+	/** Pool of 128-bit UUIDs. */
+	BT_GATT_POOL_TYPE_UUID128,
+	/** Pool of characteristic declarations. */
+	BT_GATT_POOL_TYPE_CHRC,
+
+	/** Number of pools. */
+	BT_GATT_POOL_TYPE_COUNT
+};
+
+/** @brief Statistics of an internal pool. */
+struct bt_gatt_pool_stats {
+	/** Number of elements in the pool. */
+	size_t size;
+	/** Number of elements in use. */
+	size_t used;
+	/** Maximum number of elements in use at the same time. */
+	size_t max_used;
+	/** Number of successful allocations. */
+	uint32_t alloc_cnt;
+	/** Number of allocations that failed because the pool was full. */
+	uint32_t fail_cnt;
+};
+
+/** @brief Get statistics of an internal pool.
+ *
+ *  @param type  Pool type.
+ *  @param stats Statistics of the pool.
+ *
+ *  @retval 0 Operation finished successfully.
+ *  @retval -EINVAL Invalid input value.
+ */
+int bt_gatt_pool_stats_get(enum bt_gatt_pool_type type,
+			   struct bt_gatt_pool_stats *stats);
+
 /** @brief Print basic module statistics (containing pool size usage).
  */
 void bt_gatt_pool_stats_print(void);
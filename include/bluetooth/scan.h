@@ -105,7 +105,7 @@ struct bt_scan_filter_info {
 	bool enabled;
 
 	/** Filter count. */
-	uint8_t cnt;
+	uint16_t cnt;
 };
 
 /**@brief Filter status structure.
@@ -221,7 +221,7 @@ struct bt_scan_uuid_filter_status {
 	const struct bt_uuid *uuid[CONFIG_BT_SCAN_UUID_CNT];
 
 	/** Matched UUID count. */
-	uint8_t count;
+	uint16_t count;
 };
 
 /**@brief Appearance filter status structure, used to inform the application
@@ -142,6 +142,12 @@ struct bt_hogp_init_params {
  */
 struct bt_hogp_rep_info;
 
+/** @brief Cached service layout.
+ *
+ * The structure is internal to the HIDS client.
+ */
+struct bt_hogp_cache;
+
 /**
  * @brief HOGP object.
  *
@@ -232,6 +238,12 @@ struct bt_hogp {
 	bool ready;
 	/** Current protocol mode. */
 	enum bt_hids_pm pm;
+#if defined(CONFIG_BT_HOGP_CACHE) || defined(__DOXYGEN__)
+	/** Service layout of a bonded peer, used to skip the reads
+	 *  done on reconnection.
+	 */
+	struct bt_hogp_cache *cache;
+#endif
 };
 
 /**
@@ -305,6 +317,26 @@ void bt_hogp_release(struct bt_hogp *hogp);
  */
 void bt_hogp_abort_all(struct bt_hogp *hogp);
 
+/**
+ * @brief Delete the cached service layout of a peer.
+ *
+ * Call this function when the bond with the peer is removed.
+ * If CONFIG_BT_HOGP_CACHE is disabled, this function does nothing.
+ *
+ * @param addr Peer address.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+#ifdef CONFIG_BT_HOGP_CACHE
+int bt_hogp_cache_delete(const bt_addr_le_t *addr);
+#else
+static inline int bt_hogp_cache_delete(const bt_addr_le_t *addr)
+{
+	return 0;
+}
+#endif
+
 /**
  * @brief Check if the assignment function was called.
  *
@@ -53,6 +53,21 @@ struct bt_nus_cb {
 	void (*received)(struct bt_conn *conn,
 			 const uint8_t *const data, uint16_t len);
 
+	/** @brief Receive readiness callback.
+	 *
+	 * Optional. Called before data written on the NUS RX Characteristic
+	 * is passed to the received callback. If the callback returns false,
+	 * a write request is rejected with the Insufficient Resources ATT
+	 * error, so that the peer can retry it, and a write command is
+	 * dropped.
+	 *
+	 * @param[in] conn  Pointer to connection object that has received data.
+	 * @param[in] len   Length of received data.
+	 *
+	 * @return true if the data can be received, false otherwise.
+	 */
+	bool (*rx_ready)(struct bt_conn *conn, uint16_t len);
+
 	/** @brief Data sent callback.
 	 *
 	 * The data has been sent as a notification and written on the NUS TX
@@ -7,6 +7,7 @@
 #define __CPU_LOAD_H
 
 #include <zephyr/types.h>
+#include <kernel.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,51 @@ void cpu_load_reset(void);
  */
 uint32_t cpu_load_get(void);
 
+/** @brief Type of the context in a per-thread CPU load entry. */
+enum cpu_load_ctx_type {
+	/** Thread, including the idle thread. */
+	CPU_LOAD_CTX_THREAD,
+	/** Interrupt service routine. */
+	CPU_LOAD_CTX_ISR,
+	/** Contexts that did not fit in the table. */
+	CPU_LOAD_CTX_OTHER,
+};
+
+/** @brief Per-thread CPU load entry. */
+struct cpu_load_ctx_stat {
+	/** Type of the context. */
+	enum cpu_load_ctx_type type;
+	/** Thread, or NULL if the context is not a thread. */
+	const struct k_thread *thread;
+	/** Interrupt number, or -1 if the context is not an ISR. */
+	int irq;
+	/** Hardware cycles spent in the context within the window. */
+	uint32_t cycles;
+	/** Share of the window spent in the context, in 0,001% units. */
+	uint32_t load;
+};
+
+/** @brief Reset the per-thread CPU load measurement.
+ *
+ * Called by @ref cpu_load_init. The measurement covers a rolling window of
+ * CONFIG_CPU_LOAD_THREADS_WINDOW_MS milliseconds.
+ */
+void cpu_load_threads_reset(void);
+
+/** @brief Get the contexts with the highest CPU load in the window.
+ *
+ * The time between the thread switches and the interrupts is charged to
+ * the thread or ISR that was running, so the loads of all the contexts add
+ * up to 100%. The time spent sleeping is charged to the idle thread.
+ *
+ * @param[out] stats     Array filled with the entries, sorted by decreasing
+ *                       load.
+ * @param[in]  max_count Size of the array.
+ *
+ * @return The number of entries stored in the array.
+ */
+size_t cpu_load_threads_get(struct cpu_load_ctx_stat *stats, size_t max_count);
+
 /** @} */
 
 #ifdef __cplusplus
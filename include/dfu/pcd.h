@@ -15,7 +15,9 @@
  * core.
  *
  * The cores communicate through a command structure (CMD) which is stored in
- * a shared memory location.
+ * a shared memory location. The peripheral core copies the image in chunks,
+ * and signals the generic core through IPC after each chunk, so that the
+ * progress can be reported and an interrupted copy can be resumed.
  *
  * The nRF5340 is an example of a system with these properties.
  */
@@ -49,18 +51,38 @@ enum pcd_status {
 	PCD_STATUS_COPY_FAILED = 2
 };
 
+/** @brief Callback reporting the progress of a network core update.
+ *
+ * @param written Number of bytes copied and verified by the network core.
+ * @param total   Number of bytes to copy.
+ */
+typedef void (*pcd_progress_cb_t)(size_t written, size_t total);
+
 /** @brief Sets up the PCD command structure with the location and size of the
  *	   firmware update. Then boots the network core and checks if the
  *	   update completed successfully.
  *
+ * If the same update was interrupted before, the network core resumes it
+ * after the last chunk it copied. If the network core stops reporting
+ * chunks, it is restarted up to CONFIG_PCD_RESUME_RETRIES times.
+ *
  * @param src_addr Start address of the data which is to be copied into the
  *                 network core.
  * @param len Length of the data which is to be copied into the network core.
  *
- * @retval 0 on success, -1 on failure.
+ * @retval 0 on success.
+ * @retval -EINVAL if the data is invalid.
+ * @retval -EIO if the network core failed the update.
+ * @retval -ETIMEDOUT if the network core stopped reporting progress.
  */
 int pcd_network_core_update(const void *src_addr, size_t len);
 
+/** @brief Set the callback reporting the progress of network core updates.
+ *
+ * @param cb The callback, or NULL to disable progress reports.
+ */
+void pcd_progress_cb_set(pcd_progress_cb_t cb);
+
 /** @brief Lock the RAM section used for IPC with the network core bootloader.
  */
 void pcd_lock_ram(void);
@@ -91,11 +113,16 @@ const void *pcd_cmd_data_ptr_get(void);
 /** @brief Perform the DFU image transfer.
  *
  * Use the information in the PCD CMD to load a DFU image to the
- * provided flash device.
+ * provided flash device. The image is copied in chunks, each of which is
+ * read back and added to the CRC of the image before it is reported to
+ * the application core. If chunks were copied before, the transfer resumes
+ * after the last one.
  *
  * @param fdev The flash device to transfer the DFU image to.
  *
- * @retval non-negative integer on success, negative errno code on failure.
+ * @retval 0 on success.
+ * @retval -EIO if the CRC of the copied image does not match.
+ * @retval negative errno code on other failures.
  */
 int pcd_fw_copy(const struct device *fdev);
 
@@ -16,6 +16,12 @@
  * @defgroup ei_ncs Edge Impulse NCS
  * @brief Module that uses Edge Impulse lib to run machine learning on device.
  *
+ * The input buffer of the module is a single-producer, single-consumer ring
+ * that is accessed without a lock. Input data must be added from one context
+ * at a time, and the buffer must be cleared and the predictions started from
+ * one context at a time. The producer and the consumer may be different
+ * threads.
+ *
  * @{
  */
 
@@ -61,6 +67,9 @@ size_t ei_ncs_get_window_size(void);
  *
  * Size of the added data must be divisible by input frame size.
  *
+ * This function is the producer side of the input buffer. It must not be
+ * called concurrently with itself or with the other function that adds data.
+ *
  * @param data       Pointer to the buffer with input data.
  * @param data_size  Size of the data (number of floating-point values).
  *
@@ -70,7 +79,31 @@ size_t ei_ncs_get_window_size(void);
 int ei_ncs_add_data(const float *data, size_t data_size);
 
 
+/** Add 16-bit input data for the library.
+ *
+ * The samples are converted to floating-point values and multiplied by
+ * the scale, directly in the input buffer of the library. The conversion uses
+ * CMSIS-DSP if @option{CONFIG_CMSIS_DSP} is enabled.
+ *
+ * Size of the added data must be divisible by input frame size.
+ *
+ * This function is the producer side of the input buffer. It must not be
+ * called concurrently with itself or with the other function that adds data.
+ *
+ * @param data       Pointer to the buffer with input data.
+ * @param data_size  Size of the data (number of 16-bit values).
+ * @param scale      Scale applied to the converted values.
+ *
+ * @return 0 if the operation was successful. Otherwise, a (negative) error
+ *	     code is returned.
+ */
+int ei_ncs_add_data_int16(const int16_t *data, size_t data_size, float scale);
+
+
 /** Clear all buffered data.
+ *
+ * This function is the consumer side of the input buffer. It must not be
+ * called concurrently with itself or with @ref ei_ncs_start_prediction.
  *
  * @return 0 if the operation was successful. Otherwise, a (negative) error
  *	     code is returned.
@@ -83,6 +116,15 @@ int ei_ncs_clear_data(void);
  * If there is not enough data in the input buffer, the prediction start is
  * delayed until the missing data is added.
  *
+ * The data before the input window is kept until the window is shifted.
+ * Shifting the window by a number of frames that is smaller than the window
+ * size results in overlapping windows, with the stride set by frame_shift.
+ *
+ * Input data can be added while the prediction is running.
+ *
+ * This function is the consumer side of the input buffer. It must not be
+ * called concurrently with itself or with @ref ei_ncs_clear_data.
+ *
  * @param window_shift  Number of windows the input window is shifted before
  *                      prediction.
  * @param frame_shift   Number of frames the input window is shifted before
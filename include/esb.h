@@ -215,6 +215,26 @@ struct esb_evt {
 	uint32_t tx_attempts;	/**< Number of TX retransmission attempts. */
 };
 
+/** @brief Enhanced ShockBurst statistics of a pipe. */
+struct esb_pipe_stats {
+	/** Number of payloads that were sent successfully. */
+	uint32_t tx_success;
+	/** Number of payloads that were not acknowledged after all
+	 *  retransmission attempts.
+	 */
+	uint32_t tx_failed;
+	/** Number of retransmissions. */
+	uint32_t retransmits;
+	/** Number of payload bytes that were sent successfully. */
+	uint32_t tx_bytes;
+	/** Number of received payloads, including the acknowledgment
+	 *  payloads in PTX mode.
+	 */
+	uint32_t rx_packets;
+	/** Number of received payload bytes. */
+	uint32_t rx_bytes;
+};
+
 /** @brief Event handler prototype. */
 typedef void (*esb_event_handler)(const struct esb_evt *event);
 
@@ -491,6 +511,25 @@ int esb_set_bitrate(enum esb_bitrate bitrate);
  */
 int esb_reuse_pid(uint8_t pipe);
 
+#if defined(CONFIG_ESB_PIPE_STATS)
+/** @brief Get the statistics of a pipe.
+ *
+ *  The counters start at zero when the module is initialized and wrap
+ *  around. The throughput of a pipe is the difference of the byte counters
+ *  between two calls, divided by the time between the calls.
+ *
+ *  @param[in]  pipe	Pipe.
+ *  @param[out] stats	Statistics of the pipe.
+ *
+ * @retval 0 If successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int esb_pipe_stats_get(uint8_t pipe, struct esb_pipe_stats *stats);
+
+/** @brief Reset the statistics of all pipes. */
+void esb_pipe_stats_reset(void);
+#endif /* defined(CONFIG_ESB_PIPE_STATS) */
+
 /** @} */
 
 #ifdef __cplusplus
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef JSON_WRITER_H__
+#define JSON_WRITER_H__
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @defgroup json_writer JSON writer
+ * @{
+ * @brief Library that serializes JSON directly into a buffer, without
+ *        building a document tree first.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief JSON writer state. */
+struct json_writer {
+	/** Output buffer, or NULL to only compute the length. */
+	char *buf;
+	/** Size of the output buffer, including the null terminator. */
+	size_t size;
+	/** Length of the document written so far. */
+	size_t len;
+	/** A separator is needed before the next member or element. */
+	bool sep;
+	/** The document did not fit in the buffer. */
+	bool overflow;
+	/** The buffer is allocated with k_malloc() and grows as needed. */
+	bool alloc;
+};
+
+/**
+ * @brief Initialize a JSON writer.
+ *
+ * @details If @p buf is NULL, nothing is written and the writer only
+ *	    computes the length of the document. This can be used to
+ *	    allocate a buffer of the exact size.
+ *
+ * @param w    Writer to initialize.
+ * @param buf  Output buffer, or NULL.
+ * @param size Size of the output buffer.
+ */
+void json_writer_init(struct json_writer *w, char *buf, size_t size);
+
+/**
+ * @brief Start an object.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL if the object is an array element or the
+ *	      root of the document.
+ */
+void json_writer_obj_start(struct json_writer *w, const char *key);
+
+/**
+ * @brief End the current object.
+ *
+ * @param w Writer.
+ */
+void json_writer_obj_end(struct json_writer *w);
+
+/**
+ * @brief Start an array.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL if the array is an array element or the
+ *	      root of the document.
+ */
+void json_writer_arr_start(struct json_writer *w, const char *key);
+
+/**
+ * @brief End the current array.
+ *
+ * @param w Writer.
+ */
+void json_writer_arr_end(struct json_writer *w);
+
+/**
+ * @brief Write a string. The string is escaped as needed.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL for an array element.
+ * @param val String to write.
+ */
+void json_writer_str(struct json_writer *w, const char *key, const char *val);
+
+/**
+ * @brief Write an integer.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL for an array element.
+ * @param val Integer to write.
+ */
+void json_writer_int(struct json_writer *w, const char *key, int64_t val);
+
+/**
+ * @brief Write a number. It is formatted like cJSON does, non-finite
+ *	  numbers are written as null.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL for an array element.
+ * @param val Number to write.
+ */
+void json_writer_num(struct json_writer *w, const char *key, double val);
+
+/**
+ * @brief Write a boolean.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL for an array element.
+ * @param val Boolean to write.
+ */
+void json_writer_bool(struct json_writer *w, const char *key, bool val);
+
+/**
+ * @brief Write a null value.
+ *
+ * @param w   Writer.
+ * @param key Member name, or NULL for an array element.
+ */
+void json_writer_null(struct json_writer *w, const char *key);
+
+/**
+ * @brief Finish the document and null-terminate the buffer.
+ *
+ * @param w Writer.
+ *
+ * @return Length of the document, without the null terminator, if
+ *	   successful. If the document did not fit in the buffer, -ENOMEM is
+ *	   returned and the required size is given by json_writer_len().
+ */
+int json_writer_finish(struct json_writer *w);
+
+/**
+ * @brief Get the length of the document written so far.
+ *
+ * @param w Writer.
+ *
+ * @return Length of the document, without the null terminator, also if it
+ *	   did not fit in the buffer.
+ */
+static inline size_t json_writer_len(const struct json_writer *w)
+{
+	return w->len;
+}
+
+/**
+ * @brief Callback that writes a document.
+ *
+ * @param w   Writer.
+ * @param ctx User data.
+ */
+typedef void (*json_writer_cb_t)(struct json_writer *w, const void *ctx);
+
+/**
+ * @brief Write a document to a heap buffer.
+ *
+ * @details The callback is called once. The document is written to a buffer
+ *	    of @option{CONFIG_JSON_WRITER_ALLOC_SIZE} bytes allocated with
+ *	    k_malloc(), which is reallocated with twice the size whenever the
+ *	    document does not fit. The returned buffer can be up to twice as
+ *	    large as the document.
+ *
+ * @param write Callback that writes the document.
+ * @param ctx   User data passed to the callback.
+ * @param len   Length of the document, without the null terminator. Can be
+ *		NULL.
+ *
+ * @return The null-terminated document, to be freed with k_free(), or NULL
+ *	   if the allocation failed.
+ */
+char *json_writer_alloc_print(json_writer_cb_t write, const void *ctx,
+			      size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* JSON_WRITER_H__ */
@@ -226,6 +226,24 @@ int modem_info_json_object_encode(struct modem_param_info *modem,
 				  cJSON *root_obj);
 #endif
 
+#ifdef CONFIG_JSON_WRITER
+struct json_writer;
+
+/** @brief Write the modem parameters with a JSON writer.
+ *
+ * The networkInfo, simInfo and deviceInfo objects are written as members
+ * of the object that is currently open in the writer.
+ *
+ * @param modem Pointer to the modem parameter structure.
+ * @param w     The JSON writer.
+ *
+ * @return Number of JSON objects written if the operation was successful.
+ *         Otherwise, a (negative) error code is returned.
+ */
+int modem_info_json_object_write(const struct modem_param_info *modem,
+				 struct json_writer *w);
+#endif
+
 /** @brief Obtain the modem parameters.
  *
  * The data is stored in the provided info structure.
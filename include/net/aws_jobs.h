@@ -275,7 +275,9 @@ int aws_jobs_get_job_execution(struct mqtt_client *const client,
 /**
  * @brief Compare topics
  *
- * Check if topics match
+ * Check if topics match. To find which of several subscribed topics a
+ * published topic matches, use the MQTT topic router library instead, which
+ * walks the published topic once.
  *
  * @param[in] sub     Topic subscribed to
  * @param[in] pub     Published topic
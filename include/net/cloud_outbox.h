@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef ZEPHYR_INCLUDE_CLOUD_OUTBOX_H_
+#define ZEPHYR_INCLUDE_CLOUD_OUTBOX_H_
+
+/**
+ * @brief Cloud outbox
+ * @defgroup cloud_outbox Cloud outbox
+ * @ingroup cloud_api
+ * @{
+ */
+
+#include <zephyr.h>
+#include <net/cloud.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**@brief Cloud outbox statistics. */
+struct cloud_outbox_stats {
+	/** Number of messages stored in the outbox. */
+	uint32_t stored;
+	/** Number of stored messages that have been sent. */
+	uint32_t sent;
+	/** Number of publications used to send the stored messages. */
+	uint32_t publications;
+	/** Number of messages dropped because the outbox was full, or because
+	 *  the backend rejected them.
+	 */
+	uint32_t dropped;
+	/** Number of messages currently waiting in the outbox. */
+	uint32_t pending;
+};
+
+/**@brief Initialize the cloud outbox.
+ *
+ * @details Messages stored in flash before a reset are sent when the
+ *	    connection is ready.
+ *
+ * @param backend Pointer to the cloud backend used to send the messages.
+ *		  The backend must be initialized.
+ *
+ * @return 0 or a negative error code indicating reason of failure.
+ */
+int cloud_outbox_init(const struct cloud_backend *const backend);
+
+/**@brief Send data to the cloud through the outbox.
+ *
+ * @details If the connection is ready and there are no messages waiting,
+ *	    the message is sent right away. Otherwise, or if sending fails,
+ *	    the message is copied to the outbox and sent when the connection
+ *	    is ready again. Messages are always sent in the order they were
+ *	    given to the outbox.
+ *
+ * @param msg Pointer to cloud message structure. The message buffer can be
+ *	      released when the function returns.
+ *
+ * @retval 0 If the message was sent or stored.
+ * @retval -EINVAL If the message is invalid.
+ * @retval -EMSGSIZE If the message could not be sent and is too large to be
+ *		     stored.
+ * @retval -ENOMEM If the message could not be sent and the outbox is full.
+ */
+int cloud_outbox_send(const struct cloud_msg *const msg);
+
+/**@brief Notify the outbox about a cloud backend event.
+ *
+ * @details Must be called from the cloud event handler of the application.
+ *	    The outbox is drained when @ref CLOUD_EVT_READY is received and
+ *	    stops sending on @ref CLOUD_EVT_DISCONNECTED.
+ *
+ * @param evt Pointer to the cloud event.
+ */
+void cloud_outbox_event_notify(const struct cloud_event *const evt);
+
+/**@brief Start sending the stored messages without waiting for the hold
+ *	  time to expire.
+ *
+ * @return 0 or a negative error code indicating reason of failure.
+ */
+int cloud_outbox_flush(void);
+
+/**@brief Get the outbox statistics.
+ *
+ * @param stats Pointer to the structure where the statistics are stored.
+ */
+void cloud_outbox_stats_get(struct cloud_outbox_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ZEPHYR_INCLUDE_CLOUD_OUTBOX_H_ */
@@ -95,21 +95,46 @@ struct ical_parser_evt {
  *
  * @param[in] event  The iCalendar event.
  *
- * @return Zero to continue the parsing, non-zero otherwise.
+ * @return Zero to continue the parsing, non-zero otherwise. After the parsing
+ *         is stopped, the parser must be initialized again.
  */
 typedef int (*icalendar_parser_callback_t)(
 	const struct ical_parser_evt *event);
 
+/** Maximum length of the property and component names that are parsed. */
+#define ICAL_PARSER_NAME_SIZE 15
+
 /**
  * @brief iCalendar parser instance.
+ *
+ * The parser does not buffer the input data. Its size is fixed, and does not
+ * depend on the size of the calendar or of its components.
  */
 struct icalendar_parser {
-	/** Internal Buffer for parsing incoming data stream */
-	char buf[CONFIG_ICAL_PARSER_BUFFER_SIZE + 1];
-	/** Offset of unparsed data in buf. */
-	size_t offset;
-	/** begin of iCalendar object delimiter pair */
-	bool icalobject_begin;
+	/** Component being parsed. */
+	struct ical_parser_evt evt;
+	/** Name of the current property, or of the component for a BEGIN
+	 *  or END property.
+	 */
+	char name[ICAL_PARSER_NAME_SIZE + 1];
+	/** Length of the name, ICAL_PARSER_NAME_SIZE + 1 if it is longer. */
+	size_t name_len;
+	/** Length of the property value stored in the component. */
+	size_t value_len;
+	/** Depth of the nested components within the current component. */
+	uint16_t depth;
+	/** Object in which the current content line is. */
+	uint8_t object;
+	/** Part of the content line being parsed. */
+	uint8_t line;
+	/** Property of the current content line. */
+	uint8_t prop;
+	/** A line break was received, and the next character tells if the
+	 *  content line is folded.
+	 */
+	bool line_break;
+	/** The application stopped the parsing. */
+	bool stopped;
 	/** Event handler. */
 	icalendar_parser_callback_t callback;
 };
@@ -128,15 +153,34 @@ int ical_parser_init(struct icalendar_parser *ical,
 /**
  * @brief Parse the iCalendar data stream. Return the parsed bytes.
  *
+ * The data can be split at any point, including within a content line or
+ * a line break. The callback is called for each component when the line
+ * following its END property starts, or when @ref ical_parser_finish is
+ * called.
+ *
  * @param[in,out] ical iCalendar parser instance.
  * @param[in] data Input data to be parsed.
  * @param[in] len  Length of input data stream.
  *
- * @retval size_t  Parsed bytes.
+ * @retval size_t  Parsed bytes. All the bytes are parsed, unless the callback
+ *                 stops the parsing.
  */
 size_t ical_parser_parse(struct icalendar_parser *ical,
 			const char *data, size_t len);
 
+/**
+ * @brief Finish parsing the iCalendar data stream.
+ *
+ * Complete the last content line, which is pending until the following line
+ * starts. Call this when the whole stream has been passed to
+ * @ref ical_parser_parse, so that the last component is reported.
+ *
+ * @param[in,out] ical iCalendar parser instance.
+ *
+ * @return 0 If successful, or an error code on failure.
+ */
+int ical_parser_finish(struct icalendar_parser *ical);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file
+ */
+
+#ifndef MQTT_TOPIC_ROUTER_H__
+#define MQTT_TOPIC_ROUTER_H__
+
+/**
+ * @defgroup mqtt_topic_router MQTT topic router
+ * @{
+ * @brief Library for dispatching incoming MQTT topics to handlers.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <zephyr/types.h>
+#include <sys/util.h>
+
+/** Index value used for an unused link in the router trie. */
+#define MQTT_TOPIC_ROUTER_NONE UINT16_MAX
+
+struct mqtt_topic_router_route;
+
+/**
+ * @brief Route handler, called by @ref mqtt_topic_router_dispatch.
+ *
+ * @param route Route that matched the topic.
+ * @param topic Topic of the incoming message. Not null-terminated.
+ * @param topic_len Length of the topic.
+ * @param user_data User data passed to @ref mqtt_topic_router_dispatch.
+ */
+typedef void (*mqtt_topic_router_handler_t)(
+	const struct mqtt_topic_router_route *route,
+	const char *topic, size_t topic_len, void *user_data);
+
+/** @brief Route from a topic filter to a handler. */
+struct mqtt_topic_router_route {
+	/** Topic filter. May contain the '+' and '#' wildcards.
+	 *  The buffer is referenced by the router and must remain valid
+	 *  until the router is reset.
+	 */
+	const char *filter;
+	/** Length of the topic filter. If set to 0, the filter must be
+	 *  null-terminated.
+	 */
+	size_t filter_len;
+	/** Application defined route identifier. Must not be negative. */
+	int id;
+	/** Optional handler, used by @ref mqtt_topic_router_dispatch. */
+	mqtt_topic_router_handler_t handler;
+};
+
+/** @brief Trie node, one per unique topic level in the filters.
+ *
+ *  The structure is internal to the router, it is only exposed so that
+ *  the node storage can be statically allocated by the user.
+ */
+struct mqtt_topic_router_node {
+	/** Topic level string, points into the route filter. */
+	const char *level;
+	/** Length of the topic level string. */
+	uint16_t level_len;
+	/** First literal child. */
+	uint16_t child;
+	/** Next literal sibling. */
+	uint16_t sibling;
+	/** Child for the single-level wildcard '+'. */
+	uint16_t plus;
+	/** Route for a filter ending at this level. */
+	const struct mqtt_topic_router_route *route;
+	/** Route for a filter with the multi-level wildcard '#' as the
+	 *  level following this one.
+	 */
+	const struct mqtt_topic_router_route *hash;
+};
+
+/** @brief Topic router instance. */
+struct mqtt_topic_router {
+	/** Node storage. */
+	struct mqtt_topic_router_node *nodes;
+	/** Number of elements in the node storage. */
+	uint16_t node_count;
+	/** Number of nodes in use, the root node included. */
+	uint16_t nodes_used;
+};
+
+/**
+ * @brief Statically define a topic router with storage for a given number
+ *	  of trie nodes.
+ *
+ * Each unique topic level among the added filters uses one node, the root
+ * node excluded. The router must be initialized with
+ * @ref mqtt_topic_router_reset before use.
+ *
+ * @param _name Name of the router instance.
+ * @param _node_count Maximum number of trie nodes, excluding the root.
+ */
+#define MQTT_TOPIC_ROUTER_DEFINE(_name, _node_count)			\
+	static struct mqtt_topic_router_node				\
+		_name##_nodes[(_node_count) + 1];			\
+	static struct mqtt_topic_router _name = {			\
+		.nodes = _name##_nodes,					\
+		.node_count = ARRAY_SIZE(_name##_nodes),		\
+	}
+
+/**
+ * @brief Remove all routes from the router.
+ *
+ * @param router Router instance.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the router has no node storage.
+ */
+int mqtt_topic_router_reset(struct mqtt_topic_router *router);
+
+/**
+ * @brief Add a route to the router.
+ *
+ * Topic levels are shared between filters with a common prefix. Routes are
+ * expected to be added once, when the corresponding subscriptions are made.
+ * The router does not provide any locking, routes must not be added while
+ * another thread is matching topics.
+ *
+ * @param router Router instance.
+ * @param route Route to add. The route is referenced, not copied, and must
+ *		remain valid until the router is reset.
+ *
+ * @retval 0 If successful.
+ * @retval -EINVAL If the filter is not a valid MQTT topic filter.
+ * @retval -EALREADY If a route with the same filter has already been added.
+ * @retval -ENOMEM If there is not enough node storage for the filter.
+ */
+int mqtt_topic_router_add(struct mqtt_topic_router *router,
+			  const struct mqtt_topic_router_route *route);
+
+/**
+ * @brief Find the route matching a topic.
+ *
+ * If several filters match the topic, literal topic levels take precedence
+ * over '+', which takes precedence over '#'. As required by the MQTT
+ * specification, topics starting with '$' are not matched by filters
+ * starting with a wildcard. Each topic level is only compared against the
+ * filter levels sharing the same parent. If the literal path does not lead
+ * to a match, the '+' path is tried, so a level may be compared more than
+ * once. Each trie node is visited at most once, so the lookup time is bounded
+ * by the number of nodes on the filter prefixes matching the topic.
+ *
+ * @param router Router instance.
+ * @param topic Topic to match. Does not need to be null-terminated.
+ * @param topic_len Length of the topic.
+ *
+ * @return Pointer to the matching route, or NULL if no route matches.
+ */
+const struct mqtt_topic_router_route *mqtt_topic_router_match(
+	const struct mqtt_topic_router *router,
+	const char *topic, size_t topic_len);
+
+/**
+ * @brief Match a topic and call the handler of the matching route.
+ *
+ * @param router Router instance.
+ * @param topic Topic to dispatch. Does not need to be null-terminated.
+ * @param topic_len Length of the topic.
+ * @param user_data User data passed to the route handler.
+ *
+ * @retval The identifier of the matching route.
+ * @retval -ENOENT If no route matches the topic.
+ */
+int mqtt_topic_router_dispatch(const struct mqtt_topic_router *router,
+			       const char *topic, size_t topic_len,
+			       void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* MQTT_TOPIC_ROUTER_H__ */
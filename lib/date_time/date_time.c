@@ -16,9 +16,11 @@
 #include <time.h>
 #include <errno.h>
 #include <string.h>
-#include <net/sntp.h>
 #include <net/socketutils.h>
 #include <sys/timeutil.h>
+#if defined(CONFIG_DATE_TIME_NTP)
+#include "date_time_ntp.h"
+#endif
 
 #include <logging/log.h>
 
@@ -57,7 +59,12 @@ struct ntp_servers servers[] = {
 	{.server_str = GOOGLE_IP_4}
 };
 
-static struct sntp_time sntp_time;
+BUILD_ASSERT(ARRAY_SIZE(servers) <= DATE_TIME_NTP_MAX_SERVERS,
+	     "Too many NTP servers");
+
+/* Last time from NTP servers, from which the drift is estimated. */
+static struct date_time_ntp_result ntp_last;
+static bool ntp_last_valid;
 #endif
 
 K_SEM_DEFINE(time_fetch_sem, 0, 1);
@@ -67,6 +74,8 @@ static struct k_delayed_work time_work;
 static struct time_aux {
 	int64_t date_time_utc;
 	int last_date_time_update;
+	/* Drift of the uptime, in parts per billion. */
+	int32_t drift_ppb;
 } time_aux;
 
 static bool initial_valid_time;
@@ -138,73 +147,105 @@ static int time_modem_get(void)
 #endif
 
 #if defined(CONFIG_DATE_TIME_NTP)
-static int sntp_time_request(struct ntp_servers *server, uint32_t timeout,
-			     struct sntp_time *time)
+static int ntp_server_resolve(struct ntp_servers *server)
 {
 	int err;
 	static struct addrinfo hints;
-	struct sntp_ctx sntp_ctx;
 
 	hints.ai_family = AF_INET;
 	hints.ai_socktype = SOCK_DGRAM;
 	hints.ai_protocol = 0;
 
-	if (server->addr == NULL) {
-		err = getaddrinfo(server->server_str, NTP_DEFAULT_PORT, &hints,
-				  &server->addr);
-		if (err) {
-			LOG_WRN("getaddrinfo, error: %d", err);
-			return err;
-		}
-	} else {
+	if (server->addr != NULL) {
 		LOG_DBG("Server address already obtained, skipping DNS lookup");
+		return 0;
 	}
 
-	err = sntp_init(&sntp_ctx, server->addr->ai_addr,
-			server->addr->ai_addrlen);
+	err = getaddrinfo(server->server_str, NTP_DEFAULT_PORT, &hints,
+			  &server->addr);
 	if (err) {
-		LOG_WRN("sntp_init, error: %d", err);
-		goto socket_close;
+		LOG_WRN("getaddrinfo, error: %d", err);
+		server->addr = NULL;
 	}
 
-	err = sntp_query(&sntp_ctx, timeout, time);
-	if (err) {
-		LOG_WRN("sntp_query, error: %d", err);
+	return err;
+}
+
+static void ntp_drift_update(const struct date_time_ntp_result *result)
+{
+	int err;
+	int32_t drift_ppb;
+
+	if (ntp_last_valid) {
+		err = date_time_ntp_drift_get(&ntp_last, result, &drift_ppb);
+		if (err == -EAGAIN) {
+			/* Too soon, the drift is estimated from the previous
+			 * time later on.
+			 */
+			return;
+		}
+
+		time_aux.drift_ppb = err ? 0 : drift_ppb;
+		LOG_DBG("Drift of the uptime: %d ppb", time_aux.drift_ppb);
 	}
 
-socket_close:
-	sntp_close(&sntp_ctx);
-	return err;
+	ntp_last = *result;
+	ntp_last_valid = true;
 }
 
 static int time_NTP_server_get(void)
 {
 	int err;
+	const struct sockaddr *addrs[ARRAY_SIZE(servers)];
+	size_t count = 0;
+	struct date_time_ntp_result result;
 
 	for (int i = 0; i < ARRAY_SIZE(servers); i++) {
-		err =  sntp_time_request(&servers[i],
-			MSEC_PER_SEC * CONFIG_DATE_TIME_NTP_QUERY_TIME_SECONDS,
-			&sntp_time);
+		err = ntp_server_resolve(&servers[i]);
 		if (err) {
-			LOG_DBG("Not getting time from NTP server %s, error %d",
+			LOG_DBG("Not querying NTP server %s, error %d",
 				log_strdup(servers[i].server_str), err);
-			LOG_DBG("Trying another address...");
 			continue;
 		}
 
-		LOG_DBG("Got time response from NTP server %s",
-			log_strdup(servers[i].server_str));
-		time_aux.date_time_utc = (int64_t)sntp_time.seconds * 1000;
-		time_aux.last_date_time_update = k_uptime_get();
-		return 0;
+		addrs[count++] = servers[i].addr->ai_addr;
 	}
 
-	LOG_WRN("Not getting time from any NTP server");
+	if (count == 0) {
+		LOG_WRN("No NTP server address obtained");
+		return -ENODATA;
+	}
+
+	err = date_time_ntp_query(addrs, count,
+			MSEC_PER_SEC * CONFIG_DATE_TIME_NTP_QUERY_TIME_SECONDS,
+			&result);
+	if (err) {
+		LOG_WRN("Not getting time from any NTP server");
+		return -ENODATA;
+	}
+
+	LOG_DBG("Got time from %d NTP servers", result.survivors);
+
+	ntp_drift_update(&result);
 
-	return -ENODATA;
+	time_aux.date_time_utc = (result.uptime_us + result.offset_us) /
+				 USEC_PER_MSEC;
+	time_aux.last_date_time_update = result.uptime_us / USEC_PER_MSEC;
+	return 0;
 }
 #endif
 
+/* Date time UTC at an uptime, corrected for the drift of the uptime since the
+ * last update.
+ */
+static int64_t uptime_to_utc(int64_t uptime)
+{
+	int64_t elapsed = uptime - time_aux.last_date_time_update;
+
+	return time_aux.date_time_utc + elapsed +
+	       (elapsed * time_aux.drift_ppb) / NSEC_PER_SEC;
+}
+
 static int current_time_check(void)
 {
 	if (time_aux.last_date_time_update == 0 ||
@@ -380,14 +421,13 @@ int date_time_uptime_to_unix_time_ms(int64_t *uptime)
 		return -ENODATA;
 	}
 
-	*uptime += time_aux.date_time_utc - time_aux.last_date_time_update;
+	*uptime = uptime_to_utc(*uptime);
 
 	/** Check if the passed in uptime was allready converted,
 	 * meaning that after a second conversion it is greater than the
 	 * current date time UTC.
 	 */
-	if (*uptime > time_aux.date_time_utc +
-	    (k_uptime_get() - time_aux.last_date_time_update)) {
+	if (*uptime > uptime_to_utc(k_uptime_get())) {
 		LOG_WRN("Uptime to large or previously converted");
 		LOG_WRN("Clear variable or set a new uptime");
 		*uptime = uptime_prev;
@@ -451,7 +491,11 @@ int date_time_clear(void)
 {
 	time_aux.date_time_utc = 0;
 	time_aux.last_date_time_update = 0;
+	time_aux.drift_ppb = 0;
 	initial_valid_time = false;
+#if defined(CONFIG_DATE_TIME_NTP)
+	ntp_last_valid = false;
+#endif
 
 	return 0;
 }
@@ -0,0 +1,506 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <net/socket.h>
+#include <random/rand32.h>
+#include <sys/byteorder.h>
+#include <logging/log.h>
+
+#include "date_time_ntp.h"
+
+LOG_MODULE_REGISTER(date_time_ntp, CONFIG_DATE_TIME_LOG_LEVEL);
+
+/* Reference: RFC 5905 Network Time Protocol Version 4 */
+
+#define NTP_VERSION		4
+#define NTP_MODE_CLIENT		3
+#define NTP_MODE_SERVER		4
+#define NTP_LI_ALARM		3
+#define NTP_STRATUM_MAX		15
+
+/* Seconds from the NTP epoch, 1900, to the Unix epoch, 1970. */
+#define NTP_UNIX_OFFSET		2208988800ULL
+
+/* Maximum root distance of an answer. */
+#define NTP_MAX_DISTANCE_US	1500000
+/* Minimum number of answers kept by the clustering. */
+#define NTP_MIN_CLUSTER		3
+/* Maximum frequency error of the local clock. */
+#define NTP_MAX_DRIFT_PPB	500000
+/* Maximum error of a drift estimate. */
+#define NTP_DRIFT_ERROR_PPB	50000
+
+struct ntp_packet {
+	uint8_t li_vn_mode;
+	uint8_t stratum;
+	uint8_t poll;
+	int8_t precision;
+	uint32_t root_delay;
+	uint32_t root_dispersion;
+	uint32_t ref_id;
+	uint32_t ref_tm_s;
+	uint32_t ref_tm_f;
+	uint32_t orig_tm_s;
+	uint32_t orig_tm_f;
+	uint32_t rx_tm_s;
+	uint32_t rx_tm_f;
+	uint32_t tx_tm_s;
+	uint32_t tx_tm_f;
+} __packed;
+
+struct ntp_query {
+	int fd;
+	/* Transmit timestamp of the request, echoed in the answer. A random
+	 * value is sent instead of the local time, so that answers which are
+	 * not for this request are recognized.
+	 */
+	uint32_t cookie_s;
+	uint32_t cookie_f;
+	/* Uptime when the request was sent. */
+	int64_t t1;
+	bool answered;
+	int64_t offset;
+	int64_t delay;
+	int64_t distance;
+};
+
+struct ntp_endpoint {
+	int64_t value;
+	/* 1 for the lower end of an interval, -1 for the upper end. */
+	int type;
+};
+
+static int64_t uptime_us(void)
+{
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static int64_t ntp_to_unix_us(uint32_t seconds, uint32_t fraction)
+{
+	uint64_t s = seconds;
+
+	/* The timestamps of NTP era 1 start in 2036. */
+	if (!(seconds & BIT(31))) {
+		s += BIT64(32);
+	}
+
+	return (int64_t)(s - NTP_UNIX_OFFSET) * USEC_PER_SEC +
+	       (int64_t)(((uint64_t)fraction * USEC_PER_SEC) >> 32);
+}
+
+static int64_t ntp_short_to_us(uint32_t value)
+{
+	return ((uint64_t)value * USEC_PER_SEC) >> 16;
+}
+
+static int request_send(struct ntp_query *q, const struct sockaddr *addr)
+{
+	struct ntp_packet pkt = {
+		.li_vn_mode = (NTP_VERSION << 3) | NTP_MODE_CLIENT,
+	};
+	socklen_t addrlen = (addr->sa_family == AF_INET6) ?
+			    sizeof(struct sockaddr_in6) :
+			    sizeof(struct sockaddr_in);
+	int err;
+
+	q->fd = socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+	if (q->fd < 0) {
+		LOG_WRN("socket, error: %d", errno);
+		return -errno;
+	}
+
+	/* Only the answers of the server are received on the socket. */
+	err = connect(q->fd, addr, addrlen);
+	if (err) {
+		LOG_WRN("connect, error: %d", errno);
+		return -errno;
+	}
+
+	q->cookie_s = sys_rand32_get();
+	q->cookie_f = sys_rand32_get();
+	pkt.tx_tm_s = sys_cpu_to_be32(q->cookie_s);
+	pkt.tx_tm_f = sys_cpu_to_be32(q->cookie_f);
+
+	q->t1 = uptime_us();
+
+	if (send(q->fd, &pkt, sizeof(pkt), 0) < 0) {
+		LOG_WRN("send, error: %d", errno);
+		return -errno;
+	}
+
+	return 0;
+}
+
+/* Compute the offset and the delay of an answer.
+ *
+ * Returns -EAGAIN if the packet is not an answer to the request, and
+ * -EINVAL if the answer is rejected.
+ */
+static int answer_parse(struct ntp_query *q, const struct ntp_packet *pkt,
+			size_t len, int64_t t4)
+{
+	uint8_t li = pkt->li_vn_mode >> 6;
+	uint8_t mode = pkt->li_vn_mode & 0x07;
+	int64_t t2;
+	int64_t t3;
+
+	if ((len < sizeof(*pkt)) || (mode != NTP_MODE_SERVER) ||
+	    (sys_be32_to_cpu(pkt->orig_tm_s) != q->cookie_s) ||
+	    (sys_be32_to_cpu(pkt->orig_tm_f) != q->cookie_f)) {
+		LOG_DBG("Not an answer to the request");
+		return -EAGAIN;
+	}
+
+	/* A stratum of 0 is a kiss-o'-death message. */
+	if ((li == NTP_LI_ALARM) || (pkt->stratum == 0) ||
+	    (pkt->stratum > NTP_STRATUM_MAX)) {
+		LOG_DBG("Server not synchronized, stratum %d", pkt->stratum);
+		return -EINVAL;
+	}
+
+	t2 = ntp_to_unix_us(sys_be32_to_cpu(pkt->rx_tm_s),
+			    sys_be32_to_cpu(pkt->rx_tm_f));
+	t3 = ntp_to_unix_us(sys_be32_to_cpu(pkt->tx_tm_s),
+			    sys_be32_to_cpu(pkt->tx_tm_f));
+	if (t3 < t2) {
+		LOG_DBG("Answer sent before the request was received");
+		return -EINVAL;
+	}
+
+	q->offset = ((t2 - q->t1) + (t3 - t4)) / 2;
+	q->delay = MAX((t4 - q->t1) - (t3 - t2), 0);
+
+	/* The true offset is within the root distance of the offset. One
+	 * tick is added for the resolution of the uptime.
+	 */
+	q->distance = ntp_short_to_us(sys_be32_to_cpu(pkt->root_delay)) / 2 +
+		      ntp_short_to_us(sys_be32_to_cpu(pkt->root_dispersion)) +
+		      q->delay / 2 + k_ticks_to_us_ceil32(1);
+	if (q->distance > NTP_MAX_DISTANCE_US) {
+		LOG_DBG("Root distance too large: %d us", (int)q->distance);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Find the point where the correctness intervals of most answers intersect,
+ * and reject the answers whose interval does not contain it.
+ *
+ * Reference: RFC 5905 11.2.1 Selection Algorithm
+ */
+static size_t answers_intersect(struct ntp_query *queries, size_t count)
+{
+	struct ntp_endpoint ep[2 * DATE_TIME_NTP_MAX_SERVERS];
+	size_t answers = 0;
+	size_t n = 0;
+	int overlap = 0;
+	int best = 0;
+	int64_t point = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		struct ntp_query *q = &queries[i];
+		struct ntp_endpoint lo = { q->offset - q->distance, 1 };
+		struct ntp_endpoint hi = { q->offset + q->distance, -1 };
+
+		if (!q->answered) {
+			continue;
+		}
+
+		answers++;
+
+		/* Insert sorted, with lower ends before upper ends. */
+		for (size_t j = 0; j < 2; j++) {
+			struct ntp_endpoint e = (j == 0) ? lo : hi;
+			size_t pos = n++;
+
+			while ((pos > 0) &&
+			       ((ep[pos - 1].value > e.value) ||
+				((ep[pos - 1].value == e.value) &&
+				 (ep[pos - 1].type < e.type)))) {
+				ep[pos] = ep[pos - 1];
+				pos--;
+			}
+			ep[pos] = e;
+		}
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		overlap += ep[i].type;
+		if (overlap > best) {
+			best = overlap;
+			point = ep[i].value;
+		}
+	}
+
+	if ((size_t)(2 * best) <= answers) {
+		LOG_WRN("No majority of %d NTP servers agree", (int)answers);
+		return 0;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		struct ntp_query *q = &queries[i];
+
+		if (q->answered && ((q->offset - q->distance > point) ||
+				    (q->offset + q->distance < point))) {
+			LOG_DBG("Server %d rejected, offset %d ms", (int)i,
+				(int)((q->offset - point) / USEC_PER_MSEC));
+			q->answered = false;
+		}
+	}
+
+	return best;
+}
+
+/* Mean square of the differences between the offset of an answer and the
+ * offsets of the other ones.
+ */
+static int64_t selection_jitter_sq(const struct ntp_query *queries,
+				   size_t count, size_t survivors,
+				   const struct ntp_query *q)
+{
+	int64_t sum = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		int64_t diff = queries[i].offset - q->offset;
+
+		if (queries[i].answered) {
+			sum += diff * diff;
+		}
+	}
+
+	return sum / (survivors - 1);
+}
+
+/* Prune the outliers until the offsets are within the smallest root distance
+ * of the answers.
+ *
+ * Reference: RFC 5905 11.2.2 Cluster Algorithm
+ */
+static size_t answers_cluster(struct ntp_query *queries, size_t count,
+			      size_t survivors)
+{
+	while (survivors > NTP_MIN_CLUSTER) {
+		struct ntp_query *worst = NULL;
+		int64_t max_jitter_sq = 0;
+		int64_t min_distance = NTP_MAX_DISTANCE_US;
+
+		for (size_t i = 0; i < count; i++) {
+			struct ntp_query *q = &queries[i];
+			int64_t jitter_sq;
+
+			if (!q->answered) {
+				continue;
+			}
+
+			jitter_sq = selection_jitter_sq(queries, count,
+							survivors, q);
+			if (jitter_sq > max_jitter_sq) {
+				max_jitter_sq = jitter_sq;
+				worst = q;
+			}
+
+			min_distance = MIN(min_distance, q->distance);
+		}
+
+		if ((worst == NULL) ||
+		    (max_jitter_sq <= min_distance * min_distance)) {
+			break;
+		}
+
+		LOG_DBG("Server %d pruned", (int)(worst - queries));
+		worst->answered = false;
+		survivors--;
+	}
+
+	return survivors;
+}
+
+/* Combine the offsets, weighted by the inverse of the root distance.
+ *
+ * Reference: RFC 5905 11.2.3 Combine Algorithm
+ */
+static void answers_combine(const struct ntp_query *queries, size_t count,
+			    struct date_time_ntp_result *result)
+{
+	const struct ntp_query *base = NULL;
+	int64_t sum = 0;
+	int64_t sum_weights = 0;
+
+	result->distance_us = NTP_MAX_DISTANCE_US;
+
+	for (size_t i = 0; i < count; i++) {
+		const struct ntp_query *q = &queries[i];
+		int64_t weight;
+
+		if (!q->answered) {
+			continue;
+		}
+
+		/* The differences to the first offset are combined, so that
+		 * the sum does not overflow.
+		 */
+		if (base == NULL) {
+			base = q;
+		}
+
+		weight = USEC_PER_SEC / MAX(q->distance, 1);
+		sum += (q->offset - base->offset) * weight;
+		sum_weights += weight;
+
+		result->distance_us = MIN(result->distance_us, q->distance);
+	}
+
+	result->offset_us = base->offset + sum / sum_weights;
+}
+
+int date_time_ntp_query(const struct sockaddr *const addrs[], size_t count,
+			uint32_t timeout_ms,
+			struct date_time_ntp_result *result)
+{
+	struct ntp_query queries[DATE_TIME_NTP_MAX_SERVERS];
+	struct pollfd fds[DATE_TIME_NTP_MAX_SERVERS];
+	int64_t deadline = k_uptime_get() + timeout_ms;
+	size_t pending = 0;
+	size_t survivors;
+	bool answered = false;
+
+	if ((count == 0) || (count > DATE_TIME_NTP_MAX_SERVERS)) {
+		return -EINVAL;
+	}
+
+	/* The requests are sent to all the servers before any answer is
+	 * received, so that an unreachable server does not delay the others.
+	 */
+	for (size_t i = 0; i < count; i++) {
+		struct ntp_query *q = &queries[i];
+
+		memset(q, 0, sizeof(*q));
+
+		if (request_send(q, addrs[i]) == 0) {
+			pending++;
+		} else if (q->fd >= 0) {
+			close(q->fd);
+			q->fd = -1;
+		}
+
+		fds[i].fd = q->fd;
+		fds[i].events = POLLIN;
+	}
+
+	while (pending > 0) {
+		int64_t remaining = deadline - k_uptime_get();
+		int ret;
+
+		if (remaining <= 0) {
+			break;
+		}
+
+		ret = poll(fds, count, remaining);
+		if (ret < 0) {
+			LOG_WRN("poll, error: %d", errno);
+			break;
+		} else if (ret == 0) {
+			break;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			struct ntp_query *q = &queries[i];
+			struct ntp_packet pkt;
+			int64_t t4;
+			ssize_t len;
+			int err = -EINVAL;
+
+			if ((fds[i].fd < 0) || (fds[i].revents == 0)) {
+				continue;
+			}
+
+			t4 = uptime_us();
+
+			if (fds[i].revents & POLLIN) {
+				len = recv(q->fd, &pkt, sizeof(pkt), 0);
+				if (len >= 0) {
+					err = answer_parse(q, &pkt, len, t4);
+				}
+			}
+
+			if (err == -EAGAIN) {
+				continue;
+			}
+
+			q->answered = (err == 0);
+			close(q->fd);
+			fds[i].fd = -1;
+			pending--;
+
+			/* The other servers are not waited for long after
+			 * the first answer.
+			 */
+			if (q->answered && !answered) {
+				answered = true;
+				deadline = MIN(deadline, k_uptime_get() +
+					       CONFIG_DATE_TIME_NTP_ANSWER_WINDOW_MS);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (fds[i].fd >= 0) {
+			LOG_DBG("No answer from server %d", (int)i);
+			close(fds[i].fd);
+		}
+	}
+
+	survivors = answers_intersect(queries, count);
+	if (survivors == 0) {
+		return -ENODATA;
+	}
+
+	survivors = answers_cluster(queries, count, survivors);
+
+	answers_combine(queries, count, result);
+	result->uptime_us = uptime_us();
+	result->survivors = survivors;
+
+	LOG_DBG("Time from %d NTP servers, error %d us", (int)survivors,
+		result->distance_us);
+
+	return 0;
+}
+
+int date_time_ntp_drift_get(const struct date_time_ntp_result *prev,
+			    const struct date_time_ntp_result *cur,
+			    int32_t *drift_ppb)
+{
+	int64_t interval = cur->uptime_us - prev->uptime_us;
+	int64_t change = cur->offset_us - prev->offset_us;
+	int64_t error = (int64_t)prev->distance_us + cur->distance_us;
+	int64_t drift;
+
+	/* The errors of the results must be small compared to the change of
+	 * the offset that the drift causes in the interval.
+	 */
+	if ((interval <= 0) ||
+	    (error > interval / (NSEC_PER_SEC / NTP_DRIFT_ERROR_PPB))) {
+		return -EAGAIN;
+	}
+
+	if (llabs(change) >
+	    interval / (NSEC_PER_SEC / NTP_MAX_DRIFT_PPB) + error) {
+		LOG_DBG("Offset changed by %d ms, not a drift",
+			(int)(change / USEC_PER_MSEC));
+		return -ERANGE;
+	}
+
+	drift = change * (int64_t)NSEC_PER_SEC / interval;
+	*drift_ppb = MIN(MAX(drift, -NTP_MAX_DRIFT_PPB), NTP_MAX_DRIFT_PPB);
+
+	return 0;
+}
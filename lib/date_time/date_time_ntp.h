@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef DATE_TIME_NTP_H__
+#define DATE_TIME_NTP_H__
+
+#include <zephyr/types.h>
+#include <net/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of NTP servers queried at the same time. */
+#define DATE_TIME_NTP_MAX_SERVERS 8
+
+/** @brief Time obtained from NTP servers. */
+struct date_time_ntp_result {
+	/** Unix time minus the uptime, in microseconds. */
+	int64_t offset_us;
+	/** Uptime when the offset was obtained, in microseconds. */
+	int64_t uptime_us;
+	/** Maximum error of the offset, in microseconds. */
+	uint32_t distance_us;
+	/** Number of servers whose answers were combined. */
+	uint8_t survivors;
+};
+
+/** @brief Query NTP servers at the same time and select the time from their
+ *         answers.
+ *
+ *  The answers are selected like in NTP (RFC 5905). The servers whose
+ *  correctness intervals do not intersect with the ones of the majority are
+ *  rejected, the outliers are pruned by clustering the offsets, and the
+ *  offsets of the remaining servers are combined.
+ *
+ *  @param[in] addrs      Addresses of the servers.
+ *  @param[in] count      Number of servers, up to DATE_TIME_NTP_MAX_SERVERS.
+ *  @param[in] timeout_ms Time to wait for the answers, in milliseconds.
+ *  @param[out] result    Time obtained.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EINVAL  If the number of servers is not supported.
+ *  @return -ENODATA If no time could be selected from the answers.
+ */
+int date_time_ntp_query(const struct sockaddr *const addrs[], size_t count,
+			uint32_t timeout_ms,
+			struct date_time_ntp_result *result);
+
+/** @brief Estimate the drift of the local clock between two results.
+ *
+ *  @param[in] prev       Previous result.
+ *  @param[in] cur        Current result.
+ *  @param[out] drift_ppb Drift of the local clock in parts per billion. It is
+ *                        positive if the local clock is slow.
+ *
+ *  @return 0        If the operation was successful.
+ *  @return -EAGAIN  If the results are too close to estimate the drift with
+ *                   the errors of the results.
+ *  @return -ERANGE  If the change of the offset is too large to be a drift.
+ */
+int date_time_ntp_drift_get(const struct date_time_ntp_result *prev,
+			    const struct date_time_ntp_result *cur,
+			    int32_t *drift_ppb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DATE_TIME_NTP_H__ */
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include "ei_data_buf.h"
+
+#if defined(CONFIG_CMSIS_DSP)
+#include <arm_math.h>
+#endif
+
+enum state {
+	STATE_DISABLED,
+	STATE_READY,
+	/* The consumer moves the window or clears the buffer. */
+	STATE_MOVING,
+	STATE_WAITING,
+	STATE_PROCESSING,
+};
+
+typedef void (*copy_fn)(float *out, const void *data, size_t offset,
+			size_t len, float scale);
+
+/* Difference of two sample counters, negative if a is behind b. */
+static int32_t cnt_diff(const struct ei_data_buf *b, uint32_t a, uint32_t c)
+{
+	uint32_t diff = (a + b->cnt_wrap - c) % b->cnt_wrap;
+
+	if (diff >= (b->cnt_wrap / 2)) {
+		return (int32_t)(diff - b->cnt_wrap);
+	}
+
+	return diff;
+}
+
+static uint32_t cnt_add(const struct ei_data_buf *b, uint32_t cnt, size_t n)
+{
+	return (cnt + n) % b->cnt_wrap;
+}
+
+static size_t data_count(const struct ei_data_buf *b)
+{
+	int32_t cnt = cnt_diff(b, atomic_get(&b->append_cnt),
+			       atomic_get(&b->process_cnt));
+
+	/* The window can be moved past the added data. */
+	return (cnt > 0) ? cnt : 0;
+}
+
+static bool window_ready_check(struct ei_data_buf *b)
+{
+	if (data_count(b) < b->window_size) {
+		return false;
+	}
+
+	/* Both the producer and the consumer can complete the window, but the
+	 * processing is requested only once.
+	 */
+	return atomic_cas(&b->state, STATE_WAITING, STATE_PROCESSING);
+}
+
+static void copy_float(float *out, const void *data, size_t offset,
+		       size_t len, float scale)
+{
+	ARG_UNUSED(scale);
+
+	memcpy(out, (const float *)data + offset, len * sizeof(*out));
+}
+
+static void copy_int16(float *out, const void *data, size_t offset,
+		       size_t len, float scale)
+{
+	const int16_t *in = (const int16_t *)data + offset;
+
+#if defined(CONFIG_CMSIS_DSP)
+	/* The q15 conversion divides the samples by 2^15. */
+	arm_q15_to_float((q15_t *)in, out, len);
+	arm_scale_f32(out, scale * 32768.0f, out, len);
+#else
+	for (size_t i = 0; i < len; i++) {
+		out[i] = in[i] * scale;
+	}
+#endif
+}
+
+static int append(struct ei_data_buf *b, const void *data, size_t len,
+		  float scale, copy_fn copy, bool *process_buf)
+{
+	*process_buf = false;
+
+	uint32_t append_cnt = atomic_get(&b->append_cnt);
+	uint32_t process_cnt = atomic_get(&b->process_cnt);
+
+	/* The window may only move forward, so the free space cannot shrink
+	 * after it is checked.
+	 */
+	if (cnt_diff(b, cnt_add(b, append_cnt, len), process_cnt) >
+	    (int32_t)b->size) {
+		return -ENOMEM;
+	}
+
+	size_t idx = append_cnt % b->size;
+	size_t copy_cnt = MIN(len, b->size - idx);
+
+	copy(&b->buf[idx], data, 0, copy_cnt, scale);
+	if (copy_cnt < len) {
+		copy(&b->buf[0], data, copy_cnt, len - copy_cnt, scale);
+	}
+
+	atomic_set(&b->append_cnt, cnt_add(b, append_cnt, len));
+
+	*process_buf = window_ready_check(b);
+
+	return 0;
+}
+
+int ei_data_buf_cleanup(struct ei_data_buf *b)
+{
+	if (!atomic_cas(&b->state, STATE_READY, STATE_MOVING) &&
+	    !atomic_cas(&b->state, STATE_WAITING, STATE_MOVING) &&
+	    !atomic_cas(&b->state, STATE_DISABLED, STATE_MOVING)) {
+		return -EBUSY;
+	}
+
+	/* Data added during the cleanup may be kept. */
+	atomic_set(&b->process_cnt, atomic_get(&b->append_cnt));
+	atomic_set(&b->state, STATE_READY);
+
+	return 0;
+}
+
+int ei_data_buf_append(struct ei_data_buf *b, const float *data, size_t len,
+		       bool *process_buf)
+{
+	return append(b, data, len, 1.0f, copy_float, process_buf);
+}
+
+int ei_data_buf_append_int16(struct ei_data_buf *b, const int16_t *data,
+			     size_t len, float scale, bool *process_buf)
+{
+	return append(b, data, len, scale, copy_int16, process_buf);
+}
+
+int ei_data_buf_move(struct ei_data_buf *b, size_t move, bool *process_buf)
+{
+	*process_buf = false;
+
+	if (!atomic_cas(&b->state, STATE_READY, STATE_MOVING)) {
+		__ASSERT_NO_MSG(atomic_get(&b->state) != STATE_DISABLED);
+		return -EBUSY;
+	}
+
+	/* The producer does not complete the window before it is moved. */
+	atomic_set(&b->process_cnt,
+		   cnt_add(b, atomic_get(&b->process_cnt), move));
+	atomic_set(&b->state, STATE_WAITING);
+
+	*process_buf = window_ready_check(b);
+
+	return 0;
+}
+
+void ei_data_buf_window_get(const struct ei_data_buf *b,
+			    struct ei_data_buf_window *window)
+{
+	/* Processing index cannot change while processing is done. */
+	__ASSERT_NO_MSG(atomic_get(&b->state) == STATE_PROCESSING);
+
+	size_t idx = (uint32_t)atomic_get(&b->process_cnt) %
+		     b->size;
+
+	window->data[0] = &b->buf[idx];
+	window->len[0] = MIN(b->window_size, b->size - idx);
+	window->data[1] = &b->buf[0];
+	window->len[1] = b->window_size - window->len[0];
+}
+
+void ei_data_buf_window_read(const struct ei_data_buf_window *window,
+			     float *out, size_t offset, size_t len)
+{
+	__ASSERT_NO_MSG((offset + len) <= (window->len[0] + window->len[1]));
+
+	if (offset < window->len[0]) {
+		size_t copy_cnt = MIN(len, window->len[0] - offset);
+
+		memcpy(out, window->data[0] + offset, copy_cnt * sizeof(*out));
+		out += copy_cnt;
+		len -= copy_cnt;
+		offset = 0;
+	} else {
+		offset -= window->len[0];
+	}
+
+	memcpy(out, window->data[1] + offset, len * sizeof(*out));
+}
+
+void ei_data_buf_processing_end(struct ei_data_buf *b)
+{
+	__ASSERT_NO_MSG(atomic_get(&b->state) == STATE_PROCESSING);
+
+	atomic_set(&b->state, STATE_READY);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef _EI_DATA_BUF_H_
+#define _EI_DATA_BUF_H_
+
+#include <zephyr.h>
+#include <sys/atomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Input data buffer of the Edge Impulse wrapper.
+ *
+ * The buffer is a single-producer, single-consumer ring. The producer adds
+ * the samples, and the consumer moves the processing window and reads it.
+ * The producer and the consumer each own one sample counter, so that no
+ * lock is needed. The counters wrap at a multiple of the ring size, and are
+ * reduced modulo the ring size to access the data.
+ *
+ * The samples before the processing window are kept until the window is
+ * moved, so consecutive windows may overlap.
+ */
+struct ei_data_buf {
+	float *buf;
+	size_t size;
+	size_t window_size;
+	uint32_t cnt_wrap;
+
+	/* Number of samples added, written only by the producer. */
+	atomic_t append_cnt;
+	/* Position of the processing window, written only by the consumer. */
+	atomic_t process_cnt;
+	atomic_t state;
+};
+
+/* Window of the buffer that is being processed.
+ *
+ * The window points to the buffer itself. If the window wraps around the end
+ * of the ring, it is made of two parts.
+ */
+struct ei_data_buf_window {
+	const float *data[2];
+	size_t len[2];
+};
+
+#define EI_DATA_BUF_DEFINE(_name, _size, _window_size)			\
+	BUILD_ASSERT((_size) > (_window_size));				\
+	static float _name##_storage[_size];				\
+	static struct ei_data_buf _name = {				\
+		.buf = _name##_storage,					\
+		.size = (_size),					\
+		.window_size = (_window_size),				\
+		.cnt_wrap = (INT32_MAX / (_size)) * (_size),		\
+	}
+
+/* Remove all the data from the buffer.
+ *
+ * Returns -EBUSY if the window is being processed.
+ */
+int ei_data_buf_cleanup(struct ei_data_buf *b);
+
+/* Add samples to the buffer.
+ *
+ * Called by the producer. process_buf is set if the window that was waiting
+ * for the data is complete and must be processed.
+ */
+int ei_data_buf_append(struct ei_data_buf *b, const float *data, size_t len,
+		       bool *process_buf);
+
+/* Add 16-bit samples to the buffer, converted to float and multiplied by
+ * scale.
+ *
+ * The samples are converted in batches directly into the ring.
+ */
+int ei_data_buf_append_int16(struct ei_data_buf *b, const int16_t *data,
+			     size_t len, float scale, bool *process_buf);
+
+/* Move the window by the given number of samples and request its processing.
+ *
+ * Called by the consumer. process_buf is set if the data of the window is
+ * already in the buffer. Otherwise, the producer completes the request when
+ * it adds the missing data.
+ *
+ * Returns -EBUSY if the previous window is still being processed or waits for
+ * data.
+ */
+int ei_data_buf_move(struct ei_data_buf *b, size_t move, bool *process_buf);
+
+/* Get the window that is being processed. */
+void ei_data_buf_window_get(const struct ei_data_buf *b,
+			    struct ei_data_buf_window *window);
+
+/* Read a part of the window that is being processed. */
+void ei_data_buf_window_read(const struct ei_data_buf_window *window,
+			     float *out, size_t offset, size_t len);
+
+/* End the processing of the window. */
+void ei_data_buf_processing_end(struct ei_data_buf *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _EI_DATA_BUF_H_ */
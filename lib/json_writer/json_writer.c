@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <json_writer.h>
+
+/* Enough for any number printed with 17 significant digits. */
+#define NUM_STR_SIZE 26
+
+/* Make room for len more bytes and the null terminator. */
+static bool reserve(struct json_writer *w, size_t len)
+{
+	size_t size;
+	char *buf;
+
+	if (w->len + len < w->size) {
+		return true;
+	}
+
+	if (!w->alloc) {
+		return false;
+	}
+
+	/* Double the size, so that the document is copied only a few times. */
+	size = MAX(2 * w->size, w->len + len + 1);
+	buf = k_malloc(size);
+	if (buf == NULL) {
+		return false;
+	}
+
+	memcpy(buf, w->buf, w->len);
+	k_free(w->buf);
+	w->buf = buf;
+	w->size = size;
+
+	return true;
+}
+
+static void put(struct json_writer *w, const char *data, size_t len)
+{
+	/* Keep counting after an overflow, to report the required size. */
+	if (!w->overflow && reserve(w, len)) {
+		memcpy(&w->buf[w->len], data, len);
+	} else {
+		w->overflow = true;
+	}
+
+	w->len += len;
+}
+
+static void put_char(struct json_writer *w, char c)
+{
+	put(w, &c, 1);
+}
+
+static void put_escaped(struct json_writer *w, const char *str)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *run = str;
+	char esc[6] = { '\\' };
+	size_t esc_len;
+
+	put_char(w, '"');
+
+	for (; *str != '\0'; str++) {
+		unsigned char c = *str;
+
+		if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+			continue;
+		}
+
+		/* Characters that need no escaping are copied in runs. */
+		put(w, run, str - run);
+		run = str + 1;
+		esc_len = 2;
+
+		switch (c) {
+		case '"':
+		case '\\':
+			esc[1] = c;
+			break;
+		case '\b':
+			esc[1] = 'b';
+			break;
+		case '\f':
+			esc[1] = 'f';
+			break;
+		case '\n':
+			esc[1] = 'n';
+			break;
+		case '\r':
+			esc[1] = 'r';
+			break;
+		case '\t':
+			esc[1] = 't';
+			break;
+		default:
+			esc[1] = 'u';
+			esc[2] = '0';
+			esc[3] = '0';
+			esc[4] = hex[c >> 4];
+			esc[5] = hex[c & 0xf];
+			esc_len = 6;
+			break;
+		}
+
+		put(w, esc, esc_len);
+	}
+
+	put(w, run, str - run);
+	put_char(w, '"');
+}
+
+/* Write the separator and member name that precede a value. */
+static void value_start(struct json_writer *w, const char *key)
+{
+	if (w->sep) {
+		put_char(w, ',');
+	}
+
+	if (key != NULL) {
+		put_escaped(w, key);
+		put_char(w, ':');
+	}
+
+	w->sep = true;
+}
+
+void json_writer_init(struct json_writer *w, char *buf, size_t size)
+{
+	__ASSERT_NO_MSG(w != NULL);
+
+	w->buf = buf;
+	w->size = (buf != NULL) ? size : 0;
+	w->len = 0;
+	w->sep = false;
+	w->overflow = false;
+	w->alloc = false;
+}
+
+void json_writer_obj_start(struct json_writer *w, const char *key)
+{
+	value_start(w, key);
+	put_char(w, '{');
+	w->sep = false;
+}
+
+void json_writer_obj_end(struct json_writer *w)
+{
+	put_char(w, '}');
+	w->sep = true;
+}
+
+void json_writer_arr_start(struct json_writer *w, const char *key)
+{
+	value_start(w, key);
+	put_char(w, '[');
+	w->sep = false;
+}
+
+void json_writer_arr_end(struct json_writer *w)
+{
+	put_char(w, ']');
+	w->sep = true;
+}
+
+void json_writer_str(struct json_writer *w, const char *key, const char *val)
+{
+	if (val == NULL) {
+		json_writer_null(w, key);
+		return;
+	}
+
+	value_start(w, key);
+	put_escaped(w, val);
+}
+
+void json_writer_int(struct json_writer *w, const char *key, int64_t val)
+{
+	char str[21];
+	char *p = &str[sizeof(str)];
+	uint64_t u = (val < 0) ? -(uint64_t)val : (uint64_t)val;
+
+	/* Formatted by hand, as 64-bit printf support is optional. */
+	do {
+		*--p = '0' + (u % 10);
+		u /= 10;
+	} while (u != 0);
+
+	if (val < 0) {
+		*--p = '-';
+	}
+
+	value_start(w, key);
+	put(w, p, &str[sizeof(str)] - p);
+}
+
+void json_writer_num(struct json_writer *w, const char *key, double val)
+{
+	char str[NUM_STR_SIZE];
+	int len;
+
+	if (isnan(val) || isinf(val)) {
+		json_writer_null(w, key);
+		return;
+	}
+
+	/* Use the shortest representation that reads back exactly. */
+	len = snprintf(str, sizeof(str), "%1.15g", val);
+	if (strtod(str, NULL) != val) {
+		len = snprintf(str, sizeof(str), "%1.17g", val);
+	}
+
+	value_start(w, key);
+	put(w, str, len);
+}
+
+void json_writer_bool(struct json_writer *w, const char *key, bool val)
+{
+	value_start(w, key);
+
+	if (val) {
+		put(w, "true", 4);
+	} else {
+		put(w, "false", 5);
+	}
+}
+
+void json_writer_null(struct json_writer *w, const char *key)
+{
+	value_start(w, key);
+	put(w, "null", 4);
+}
+
+int json_writer_finish(struct json_writer *w)
+{
+	if (w->buf == NULL) {
+		return w->len;
+	}
+
+	if (w->overflow) {
+		if (w->size > 0) {
+			w->buf[0] = '\0';
+		}
+
+		return -ENOMEM;
+	}
+
+	w->buf[w->len] = '\0';
+
+	return w->len;
+}
+
+char *json_writer_alloc_print(json_writer_cb_t write, const void *ctx,
+			      size_t *len)
+{
+	struct json_writer w;
+	char *buf;
+
+	buf = k_malloc(CONFIG_JSON_WRITER_ALLOC_SIZE);
+	if (buf == NULL) {
+		return NULL;
+	}
+
+	json_writer_init(&w, buf, CONFIG_JSON_WRITER_ALLOC_SIZE);
+	w.alloc = true;
+
+	write(&w, ctx);
+	if (json_writer_finish(&w) < 0) {
+		k_free(w.buf);
+		return NULL;
+	}
+
+	if (len != NULL) {
+		*len = json_writer_len(&w);
+	}
+
+	return w.buf;
+}
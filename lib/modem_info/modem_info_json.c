@@ -234,6 +234,8 @@ int modem_info_json_string_encode(struct modem_param_info *modem,
 	int total_len = 0;
 	int ret;
 
+	cJSON_ArenaBegin();
+
 	cJSON *root_obj		= cJSON_CreateObject();
 	cJSON *network_obj	= cJSON_CreateObject();
 	cJSON *sim_obj		= cJSON_CreateObject();
@@ -241,6 +243,7 @@ int modem_info_json_string_encode(struct modem_param_info *modem,
 
 	if (root_obj == NULL || network_obj == NULL || buf == NULL ||
 	    sim_obj == NULL || device_obj == NULL) {
+		cJSON_ArenaEnd();
 		return -ENOMEM;
 	}
 
@@ -287,6 +290,7 @@ int modem_info_json_string_encode(struct modem_param_info *modem,
 
 delete_object:
 	cJSON_Delete(root_obj);
+	cJSON_ArenaEnd();
 
 	return total_len;
 }
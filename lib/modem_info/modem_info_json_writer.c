@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <json_writer.h>
+#include <modem/modem_info.h>
+#include <modem/at_params.h>
+
+static void data_write(const struct lte_param *param, struct json_writer *w)
+{
+	char data_name[MODEM_INFO_MAX_RESPONSE_SIZE] = { 0 };
+	enum at_param_type data_type;
+
+	if (modem_info_name_get(param->type, data_name) < 0) {
+		return;
+	}
+
+	data_type = modem_info_type_get(param->type);
+	if (data_type < 0) {
+		return;
+	}
+
+	if (data_type == AT_PARAM_TYPE_STRING &&
+	    param->type != MODEM_INFO_AREA_CODE) {
+		json_writer_str(w, data_name, param->value_string);
+	} else {
+		json_writer_num(w, data_name, param->value);
+	}
+}
+
+static void network_data_write(const struct network_param *network,
+			       struct json_writer *w)
+{
+	char data_name[MODEM_INFO_MAX_RESPONSE_SIZE];
+	char network_mode[MODEM_INFO_NETWORK_MODE_MAX_SIZE] = { 0 };
+	int len;
+
+	json_writer_obj_start(w, "networkInfo");
+
+	data_write(&network->current_band, w);
+	data_write(&network->sup_band, w);
+	data_write(&network->area_code, w);
+	data_write(&network->current_operator, w);
+	data_write(&network->ip_address, w);
+	data_write(&network->ue_mode, w);
+
+	len = modem_info_name_get(network->cellid_hex.type, data_name);
+	if (len >= 0) {
+		data_name[len] = '\0';
+		json_writer_num(w, data_name, network->cellid_dec);
+	}
+
+	/* The mode is composed locally, the writer can be run twice. */
+	if (network->lte_mode.value == 1) {
+		strcat(network_mode, "LTE-M");
+	} else if (network->nbiot_mode.value == 1) {
+		strcat(network_mode, "NB-IoT");
+	}
+
+	if (network->gps_mode.value == 1) {
+		strcat(network_mode, " GPS");
+	}
+
+	json_writer_str(w, "networkMode", network_mode);
+	json_writer_obj_end(w);
+}
+
+static void sim_data_write(const struct sim_param *sim, struct json_writer *w)
+{
+	json_writer_obj_start(w, "simInfo");
+	data_write(&sim->uicc, w);
+	data_write(&sim->iccid, w);
+	data_write(&sim->imsi, w);
+	json_writer_obj_end(w);
+}
+
+static void device_data_write(const struct device_param *device,
+			      struct json_writer *w)
+{
+	json_writer_obj_start(w, "deviceInfo");
+	data_write(&device->modem_fw, w);
+	data_write(&device->battery, w);
+	data_write(&device->imei, w);
+	json_writer_str(w, "board", device->board);
+	json_writer_str(w, "appVersion", device->app_version);
+	json_writer_str(w, "appName", device->app_name);
+	json_writer_obj_end(w);
+}
+
+int modem_info_json_object_write(const struct modem_param_info *modem,
+				 struct json_writer *w)
+{
+	int obj_count = 0;
+
+	if (modem == NULL || w == NULL) {
+		return -EINVAL;
+	}
+
+	if (IS_ENABLED(CONFIG_MODEM_INFO_ADD_NETWORK)) {
+		network_data_write(&modem->network, w);
+		obj_count++;
+	}
+
+	if (IS_ENABLED(CONFIG_MODEM_INFO_ADD_SIM)) {
+		sim_data_write(&modem->sim, w);
+		obj_count++;
+	}
+
+	if (IS_ENABLED(CONFIG_MODEM_INFO_ADD_DEVICE)) {
+		device_data_write(&modem->device, w);
+		obj_count++;
+	}
+
+	return obj_count;
+}
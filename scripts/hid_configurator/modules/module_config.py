@@ -53,6 +53,20 @@ BLE_BOND_OPTIONS = {
     'peer_search':            ConfigOption(None, 'peer_search', 'Trigger peer search', None),
 }
 
+HID_FORWARD_OPTIONS = {
+    'peer_select':            ConfigOption((0,      255),        'peer_select', 'Peer ID of the peripheral that provides the statistics', int),
+    'sent_cnt':               ConfigOption((0,      0xFFFFFFFF), 'peer_stats',  'Number of forwarded reports (writing any statistic resets the statistics)', int),
+    'dropped_cnt':            ConfigOption((0,      65535),      'peer_stats',  'Number of reports dropped because of the queue limit', int),
+    'coalesced_cnt':          ConfigOption((0,      65535),      'peer_stats',  'Number of mouse reports merged into an enqueued report', int),
+    'latency_avg':            ConfigOption((0,      0xFFFFFFFF), 'peer_stats',  'Average latency of the forwarded reports [us]', int),
+    'latency_max':            ConfigOption((0,      0xFFFFFFFF), 'peer_stats',  'Maximum latency of the forwarded reports [us]', int),
+}
+
+HID_FORWARD_OPTIONS_FORMAT = {
+    'peer_select': ('<B', ['peer_select'], None, None),
+    'peer_stats': ('<IHHII', ['sent_cnt', 'dropped_cnt', 'coalesced_cnt', 'latency_avg', 'latency_max'], None, None),
+}
+
 MODULE_CONFIG = {
     'motion/paw3212' : {
         'options' : MOTION_PAW3212_OPTIONS
@@ -69,5 +83,10 @@ MODULE_CONFIG = {
 
     'ble_bond' : {
         'options' : BLE_BOND_OPTIONS
+    },
+
+    'hid_forward' : {
+        'options' : HID_FORWARD_OPTIONS,
+        'format' : HID_FORWARD_OPTIONS_FORMAT
     }
 }
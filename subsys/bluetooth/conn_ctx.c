@@ -9,100 +9,139 @@
 
 LOG_MODULE_REGISTER(bt_conn_ctx, CONFIG_BT_CONN_CTX_LOG_LEVEL);
 
-static void bt_conn_ctx_mem_free(struct k_mem_slab *mem_slab, void **data)
+/* The context state holds the number of references in the lower bits.
+ * The context is owned from the allocation until the last reference is
+ * released after the context was freed. Only a ready context can be
+ * obtained. A ready context holds one reference that is released when
+ * the context is freed.
+ */
+#define CTX_STATE_OWNED		BIT(31)
+#define CTX_STATE_READY		BIT(30)
+#define CTX_STATE_REF_MASK	(CTX_STATE_READY - 1)
+
+static struct bt_conn_ctx *ctx_ref_get(struct bt_conn_ctx *ctx)
 {
-	k_mem_slab_free(mem_slab, data);
-	*data = NULL;
+	atomic_val_t state;
+
+	do {
+		state = atomic_get(&ctx->state);
+
+		if (!(state & CTX_STATE_READY)) {
+			return NULL;
+		}
+
+		__ASSERT_NO_MSG((state & CTX_STATE_REF_MASK) <
+				CTX_STATE_REF_MASK);
+	} while (!atomic_cas(&ctx->state, state, state + 1));
+
+	return ctx;
 }
 
-void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+static void ctx_ref_put(struct bt_conn_ctx_lib *ctx_lib,
+			struct bt_conn_ctx *ctx)
 {
-	__ASSERT_NO_MSG(conn != NULL);
-	__ASSERT_NO_MSG(ctx_lib != NULL);
+	atomic_val_t state = atomic_dec(&ctx->state) - 1;
 
-	int err = -ENOMEM;
-	struct bt_conn_ctx *ctx;
+	__ASSERT_NO_MSG(state & CTX_STATE_OWNED);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	if ((state & CTX_STATE_REF_MASK) == 0) {
+		/* The context was freed and it is no longer referenced. */
+		__ASSERT_NO_MSG(!(state & CTX_STATE_READY));
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		ctx = &ctx_lib->ctx[i];
+		k_mem_slab_free(ctx_lib->mem_slab, &ctx->data);
+		ctx->data = NULL;
+		ctx->conn = NULL;
 
-		if (!ctx->conn && !ctx->data) {
-			err = k_mem_slab_alloc(ctx_lib->mem_slab,
-					       &ctx->data,
-					       K_NO_WAIT);
-			if (!err) {
-				ctx->conn = conn;
+		atomic_set(&ctx->state, 0);
+	}
+}
 
-				LOG_DBG("The memory for the connection context "
-					"has been allocated, conn %p, index: %u",
-					conn, i);
+static int ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn_ctx *ctx)
+{
+	atomic_val_t state = atomic_and(&ctx->state, ~CTX_STATE_READY);
 
-				return ctx->data;
+	if (!(state & CTX_STATE_READY)) {
+		return -EINVAL;
+	}
 
-			} else {
-				break;
-			}
+	/* Release the reference held by the ready context. */
+	ctx_ref_put(ctx_lib, ctx);
 
-		}
-	}
+	return 0;
+}
 
-	LOG_WRN("Memory can not be allocated");
-	k_mutex_unlock(ctx_lib->mutex);
+static struct bt_conn_ctx *ctx_find(struct bt_conn_ctx_lib *ctx_lib,
+				    struct bt_conn *conn)
+{
+	uint8_t index = bt_conn_index(conn);
+
+	__ASSERT_NO_MSG(index < ARRAY_SIZE(ctx_lib->ctx));
 
-	return NULL;
+	return &ctx_lib->ctx[index];
 }
 
-int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+void *bt_conn_ctx_alloc(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	struct bt_conn_ctx *ctx = ctx_find(ctx_lib, conn);
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
+	/* Take the ownership with the reference returned to the caller. */
+	if (!atomic_cas(&ctx->state, 0, CTX_STATE_OWNED | 1)) {
+		LOG_WRN("Context already allocated for conn %p", conn);
+		return NULL;
+	}
 
-		if (ctx->conn == conn) {
-			bt_conn_ctx_mem_free(ctx_lib->mem_slab, &ctx->data);
-			ctx->conn = NULL;
-			ctx->data = NULL;
+	int err = k_mem_slab_alloc(ctx_lib->mem_slab, &ctx->data, K_NO_WAIT);
 
-			LOG_DBG("The context memory for the connection "
-				"has been released, conn %p index %u",
-				conn, i);
+	if (err) {
+		LOG_WRN("Memory can not be allocated");
+		ctx->data = NULL;
+		atomic_set(&ctx->state, 0);
 
-			k_mutex_unlock(ctx_lib->mutex);
+		return NULL;
+	}
 
-			return 0;
-		}
+	ctx->conn = conn;
+
+	/* The ready context holds an additional reference. */
+	atomic_add(&ctx->state, CTX_STATE_READY | 1);
+
+	LOG_DBG("The memory for the connection context "
+		"has been allocated, conn %p, index: %u",
+		conn, ctx - ctx_lib->ctx);
+
+	return ctx->data;
+}
+
+int bt_conn_ctx_free(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
+{
+	__ASSERT_NO_MSG(conn != NULL);
+	__ASSERT_NO_MSG(ctx_lib != NULL);
+
+	struct bt_conn_ctx *ctx = ctx_find(ctx_lib, conn);
+
+	if ((ctx->conn != conn) || ctx_free(ctx_lib, ctx)) {
+		LOG_WRN("There is no allocated memory for this connection");
+		return -EINVAL;
 	}
 
-	LOG_WRN("There is no allocated memory for this connection");
-	k_mutex_unlock(ctx_lib->mutex);
+	LOG_DBG("The context memory for the connection "
+		"has been released, conn %p index %u",
+		conn, ctx - ctx_lib->ctx);
 
-	return  -EINVAL;
+	return 0;
 }
 
 void bt_conn_ctx_free_all(struct bt_conn_ctx_lib *ctx_lib)
 {
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
-
 	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
-
-		if (ctx->data != NULL) {
-			k_mem_slab_free(ctx_lib->mem_slab, &ctx->data);
-			ctx->conn = NULL;
-			ctx->data = NULL;
-		}
+		(void)ctx_free(ctx_lib, &ctx_lib->ctx[i]);
 	}
 
-	k_mutex_unlock(ctx_lib->mutex);
-
 	LOG_DBG("All allocated memory has been released");
 }
 
@@ -111,23 +150,22 @@ void *bt_conn_ctx_get(struct bt_conn_ctx_lib *ctx_lib, struct bt_conn *conn)
 	__ASSERT_NO_MSG(conn != NULL);
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
+	struct bt_conn_ctx *ctx = ctx_ref_get(ctx_find(ctx_lib, conn));
 
-	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
-		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
-
-		if (ctx->conn == conn) {
-			LOG_DBG("Memory block found for the connection");
-
-			return ctx->data;
-		}
+	if (!ctx) {
+		LOG_WRN("No memory block for connection");
+		return NULL;
 	}
 
-	LOG_WRN("No memory block for connection");
+	if (ctx->conn != conn) {
+		LOG_WRN("No memory block for connection");
+		ctx_ref_put(ctx_lib, ctx);
+		return NULL;
+	}
 
-	k_mutex_unlock(ctx_lib->mutex);
+	LOG_DBG("Memory block found for the connection");
 
-	return NULL;
+	return ctx->data;
 }
 
 const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib, uint8_t id)
@@ -135,17 +173,7 @@ const struct bt_conn_ctx *bt_conn_ctx_get_by_id(struct bt_conn_ctx_lib *ctx_lib,
 	__ASSERT_NO_MSG(ctx_lib != NULL);
 	__ASSERT_NO_MSG(id < bt_conn_ctx_count(ctx_lib));
 
-	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
-
-	struct bt_conn_ctx *ctx = &ctx_lib->ctx[id];
-
-	if (ctx_lib->ctx[id].conn != NULL) {
-		return ctx;
-	}
-
-	k_mutex_unlock(ctx_lib->mutex);
-
-	return NULL;
+	return ctx_ref_get(&ctx_lib->ctx[id]);
 }
 
 void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
@@ -157,7 +185,7 @@ void bt_conn_ctx_release(struct bt_conn_ctx_lib *ctx_lib, void *ctx_data)
 		struct bt_conn_ctx *ctx = &ctx_lib->ctx[i];
 
 		if (ctx->data == ctx_data) {
-			k_mutex_unlock(ctx_lib->mutex);
+			ctx_ref_put(ctx_lib, ctx);
 
 			return;
 		}
@@ -17,8 +17,12 @@
 #include <sdc.h>
 #include <sdc_hci.h>
 #include <sdc_hci_vs.h>
+#if defined(CONFIG_SDC_RX_STATS_SHELL)
+#include <shell/shell.h>
+#endif
 #include "multithreading_lock.h"
 #include "hci_internal.h"
+#include "hci_driver_stats.h"
 
 #define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_DEBUG_HCI_DRIVER)
 #define LOG_MODULE_NAME sdc_hci_driver
@@ -55,6 +59,13 @@ const uint32_t z_bt_ctlr_used_nrf_ppi_groups;
 
 static K_SEM_DEFINE(sem_recv, 0, 1);
 
+static struct {
+	atomic_t acl_copy_avoided;
+	atomic_t acl_copied;
+	atomic_t acl_dropped;
+	atomic_t evt_discarded;
+} stats;
+
 static struct k_thread recv_thread_data;
 static K_THREAD_STACK_DEFINE(recv_thread_stack, CONFIG_SDC_RX_STACK_SIZE);
 
@@ -198,18 +209,52 @@ static int hci_driver_send(struct net_buf *buf)
 	return err;
 }
 
-static void data_packet_process(uint8_t *hci_buf)
+/* A host buffer that was taken but not filled is kept for the next data
+ * packet. Freeing it would report a completed packet to the controller when
+ * host flow control is enabled.
+ */
+static struct net_buf *data_buf_spare;
+
+static struct net_buf *data_buf_get(k_timeout_t timeout)
 {
-	struct net_buf *data_buf = bt_buf_get_rx(BT_BUF_ACL_IN, K_FOREVER);
-	struct bt_hci_acl_hdr *hdr = (void *)hci_buf;
-	uint16_t hf, handle, len;
-	uint8_t flags, pb, bc;
+	struct net_buf *data_buf = data_buf_spare;
 
-	if (!data_buf) {
-		BT_ERR("No data buffer available");
-		return;
+	if (data_buf) {
+		data_buf_spare = NULL;
+		return data_buf;
+	}
+
+	return bt_buf_get_rx(BT_BUF_ACL_IN, timeout);
+}
+
+static void data_buf_keep(struct net_buf *data_buf)
+{
+	__ASSERT_NO_MSG(!data_buf_spare);
+
+	data_buf_spare = data_buf;
+}
+
+static bool data_packet_fits(struct net_buf *data_buf, const uint8_t *hci_buf)
+{
+	const struct bt_hci_acl_hdr *hdr = (const void *)hci_buf;
+	uint32_t len = sys_le16_to_cpu(hdr->len) + sizeof(*hdr);
+
+	if (len > net_buf_tailroom(data_buf)) {
+		BT_ERR("Data packet too long (%u)", len);
+		atomic_inc(&stats.acl_dropped);
+		return false;
 	}
 
+	return true;
+}
+
+/* The data packet is written by the controller at the tail of the buffer. */
+static void data_packet_process(struct net_buf *data_buf)
+{
+	struct bt_hci_acl_hdr *hdr = (void *)net_buf_tail(data_buf);
+	uint16_t hf, handle, len;
+	uint8_t flags, pb, bc;
+
 	len = sys_le16_to_cpu(hdr->len);
 	hf = sys_le16_to_cpu(hdr->handle);
 	handle = bt_acl_handle(hf);
@@ -220,10 +265,32 @@ static void data_packet_process(uint8_t *hci_buf)
 	BT_DBG("Data: handle (0x%02x), PB(%01d), BC(%01d), len(%u)", handle,
 	       pb, bc, len);
 
-	net_buf_add_mem(data_buf, &hci_buf[0], len + sizeof(*hdr));
+	net_buf_add(data_buf, len + sizeof(*hdr));
 	bt_recv(data_buf);
 }
 
+static void data_packet_copy_and_process(uint8_t *hci_buf)
+{
+	struct net_buf *data_buf = data_buf_get(K_FOREVER);
+	struct bt_hci_acl_hdr *hdr = (void *)hci_buf;
+
+	if (!data_buf) {
+		BT_ERR("No data buffer available");
+		return;
+	}
+
+	if (!data_packet_fits(data_buf, hci_buf)) {
+		data_buf_keep(data_buf);
+		return;
+	}
+
+	memcpy(net_buf_tail(data_buf), hci_buf,
+	       sys_le16_to_cpu(hdr->len) + sizeof(*hdr));
+	atomic_inc(&stats.acl_copied);
+
+	data_packet_process(data_buf);
+}
+
 static bool event_packet_is_discardable(const uint8_t *hci_buf)
 {
 	struct bt_hci_evt_hdr *hdr = (void *)hci_buf;
@@ -291,6 +358,7 @@ static void event_packet_process(uint8_t *hci_buf)
 	if (!evt_buf) {
 		if (discardable) {
 			BT_DBG("Discarding event");
+			atomic_inc(&stats.evt_discarded);
 			return;
 		}
 
@@ -320,21 +388,49 @@ static bool fetch_and_process_hci_evt(uint8_t *p_hci_buffer)
 	return true;
 }
 
+/* The controller writes the data packet directly to a host buffer.
+ * If no host buffer is available, or if it is too small for any packet,
+ * the packet is fetched to the driver buffer and copied once a host buffer
+ * is freed.
+ */
 static bool fetch_and_process_acl_data(uint8_t *p_hci_buffer)
 {
+	struct net_buf *data_buf = data_buf_get(K_NO_WAIT);
+	bool direct = data_buf &&
+		      (net_buf_tailroom(data_buf) >= CONFIG_BT_RX_BUF_LEN);
 	int errcode;
 
 	errcode = MULTITHREADING_LOCK_ACQUIRE();
 	if (!errcode) {
-		errcode = sdc_hci_data_get(p_hci_buffer);
+		errcode = sdc_hci_data_get(direct ? net_buf_tail(data_buf) :
+						    p_hci_buffer);
 		MULTITHREADING_LOCK_RELEASE();
 	}
 
 	if (errcode) {
+		if (data_buf) {
+			data_buf_keep(data_buf);
+		}
+
 		return false;
 	}
 
-	data_packet_process(p_hci_buffer);
+	if (direct) {
+		if (!data_packet_fits(data_buf, net_buf_tail(data_buf))) {
+			data_buf_keep(data_buf);
+			return true;
+		}
+
+		atomic_inc(&stats.acl_copy_avoided);
+		data_packet_process(data_buf);
+	} else {
+		if (data_buf) {
+			data_buf_keep(data_buf);
+		}
+
+		data_packet_copy_and_process(p_hci_buffer);
+	}
+
 	return true;
 }
 
@@ -366,6 +462,37 @@ static void recv_thread(void *p1, void *p2, void *p3)
 	}
 }
 
+void hci_driver_stats_get(struct hci_driver_stats *driver_stats)
+{
+	driver_stats->acl_copy_avoided = atomic_get(&stats.acl_copy_avoided);
+	driver_stats->acl_copied = atomic_get(&stats.acl_copied);
+	driver_stats->acl_dropped = atomic_get(&stats.acl_dropped);
+	driver_stats->evt_discarded = atomic_get(&stats.evt_discarded);
+}
+
+#if defined(CONFIG_SDC_RX_STATS_SHELL)
+static int cmd_rx_stats(const struct shell *shell, size_t argc, char **argv)
+{
+	struct hci_driver_stats driver_stats;
+
+	hci_driver_stats_get(&driver_stats);
+
+	shell_print(shell, "ACL packets without copy: %u",
+		    driver_stats.acl_copy_avoided);
+	shell_print(shell, "ACL packets copied: %u", driver_stats.acl_copied);
+	shell_print(shell, "ACL packets dropped: %u",
+		    driver_stats.acl_dropped);
+	shell_print(shell, "Events discarded: %u",
+		    driver_stats.evt_discarded);
+
+	return 0;
+}
+
+SHELL_CMD_ARG_REGISTER(sdc_rx_stats, NULL,
+		       "Print the HCI driver receive statistics",
+		       cmd_rx_stats, 1, 0);
+#endif /* CONFIG_SDC_RX_STATS_SHELL */
+
 void host_signal(void)
 {
 	/* Wake up the RX event/data thread */
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/** @file
+ *  @brief HCI driver statistics
+ */
+
+#include <stdint.h>
+
+#ifndef HCI_DRIVER_STATS_H__
+#define HCI_DRIVER_STATS_H__
+
+/** @brief Counters of the HCI driver receive path. */
+struct hci_driver_stats {
+	/** Number of ACL data packets written by the SoftDevice Controller
+	 *  directly to a host buffer.
+	 */
+	uint32_t acl_copy_avoided;
+
+	/** Number of ACL data packets copied to a host buffer, because no
+	 *  host buffer was available when the packet was fetched.
+	 */
+	uint32_t acl_copied;
+
+	/** Number of ACL data packets dropped, because their length did not
+	 *  fit in a host buffer.
+	 */
+	uint32_t acl_dropped;
+
+	/** Number of discardable events dropped, because no discardable
+	 *  event buffer was available.
+	 */
+	uint32_t evt_discarded;
+};
+
+/** @brief Get the counters of the HCI driver receive path.
+ *
+ * @param[out] driver_stats Structure where the counters are stored.
+ */
+void hci_driver_stats_get(struct hci_driver_stats *driver_stats);
+
+#endif
@@ -8,8 +8,13 @@
 #include <zephyr.h>
 #include <logging/log.h>
 
+#include <bluetooth/bluetooth.h>
 #include <bluetooth/gatt_dm.h>
 
+#if CONFIG_BT_GATT_DM_CACHE
+#include "gatt_peer_cache.h"
+#endif
+
 LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
 
 /* Available sizes: 128, 512, 2048... */
@@ -60,10 +65,58 @@ struct bt_gatt_dm {
 
 	/* The pointer to callback structure */
 	const struct bt_gatt_dm_cb *callback;
+
+#if CONFIG_BT_GATT_DM_CACHE
+	/* Parameters of the Database Hash read */
+	struct bt_gatt_read_params hash_params;
+	/* Database Hash of the peer */
+	uint8_t hash[GATT_PEER_CACHE_HASH_LEN];
+	/* The result is cached when the discovery completes */
+	bool cache_pending;
+#endif
+};
+
+/* One instance for each connection */
+static struct bt_gatt_dm bt_gatt_dm_inst[CONFIG_BT_MAX_CONN];
+/* Protects the claim of an instance */
+static struct k_spinlock instance_lock;
+
+#if CONFIG_BT_GATT_DM_CACHE
+union uuid_any {
+	struct bt_uuid uuid;
+	struct bt_uuid_16 u16;
+	struct bt_uuid_32 u32;
+	struct bt_uuid_128 u128;
+};
+
+/* Cached attribute, with the value of service and characteristic
+ * declarations.
+ */
+struct cache_attr {
+	union uuid_any uuid;
+	union uuid_any val_uuid;
+	union {
+		struct bt_gatt_service_val svc;
+		struct bt_gatt_chrc chrc;
+	} val;
+	uint16_t handle;
+	uint8_t perm;
 };
 
-/* Currently only one instance is supported */
-static struct bt_gatt_dm bt_gatt_dm_inst;
+/* Discovery result of a service on a bonded peer */
+struct cache_entry {
+	bt_addr_le_t addr;
+	uint8_t hash[GATT_PEER_CACHE_HASH_LEN];
+	union uuid_any svc_uuid;
+	uint32_t last_used;
+	size_t attr_cnt;
+	struct cache_attr attrs[];
+};
+
+static struct cache_entry *cache[CONFIG_BT_GATT_DM_CACHE_SIZE];
+static uint32_t cache_use_cnt;
+static K_MUTEX_DEFINE(cache_mutex);
+#endif /* CONFIG_BT_GATT_DM_CACHE */
 
 /* Returns pointer to newly allocated space in a dm->data_chunk */
 static void *user_data_alloc(struct bt_gatt_dm *dm,
@@ -231,10 +284,183 @@ static struct bt_gatt_dm_attr *attr_find_by_handle(
 	return NULL;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+static bool cache_entry_match(const struct cache_entry *entry,
+			      const bt_addr_le_t *addr,
+			      const struct bt_uuid *svc_uuid)
+{
+	return !bt_addr_le_cmp(&entry->addr, addr) &&
+	       !bt_uuid_cmp(&entry->svc_uuid.uuid, svc_uuid);
+}
+
+static void cache_store(struct bt_gatt_dm *dm)
+{
+	const bt_addr_le_t *addr = bt_conn_get_dst(dm->conn);
+	struct cache_entry *entry;
+	size_t slot = 0;
+
+	entry = k_malloc(sizeof(*entry) +
+			 dm->cur_attr_id * sizeof(entry->attrs[0]));
+	if (!entry) {
+		LOG_WRN("No memory to cache the discovery result");
+		return;
+	}
+
+	bt_addr_le_copy(&entry->addr, addr);
+	memcpy(entry->hash, dm->hash, sizeof(entry->hash));
+	memcpy(&entry->svc_uuid, dm->discover_params.uuid,
+	       get_uuid_size(dm->discover_params.uuid));
+	entry->attr_cnt = dm->cur_attr_id;
+
+	for (size_t i = 0; i < dm->cur_attr_id; i++) {
+		const struct bt_gatt_dm_attr *attr = &dm->attrs[i];
+		struct cache_attr *cached = &entry->attrs[i];
+		const struct bt_gatt_service_val *svc;
+		const struct bt_gatt_chrc *chrc;
+
+		memcpy(&cached->uuid, attr->uuid, get_uuid_size(attr->uuid));
+		cached->handle = attr->handle;
+		cached->perm = attr->perm;
+
+		svc = bt_gatt_dm_attr_service_val(attr);
+		chrc = bt_gatt_dm_attr_chrc_val(attr);
+		if (svc) {
+			cached->val.svc = *svc;
+			memcpy(&cached->val_uuid, svc->uuid,
+			       get_uuid_size(svc->uuid));
+		} else if (chrc) {
+			cached->val.chrc = *chrc;
+			memcpy(&cached->val_uuid, chrc->uuid,
+			       get_uuid_size(chrc->uuid));
+		}
+	}
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	entry->last_used = ++cache_use_cnt;
+
+	/* Replace the result for the same service, or else use a free slot
+	 * or the least recently used one.
+	 */
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i] &&
+		    cache_entry_match(cache[i], addr, &entry->svc_uuid.uuid)) {
+			slot = i;
+			break;
+		}
+
+		if (!cache[i] ||
+		    (cache[slot] &&
+		     (cache[i]->last_used < cache[slot]->last_used))) {
+			slot = i;
+		}
+	}
+
+	k_free(cache[slot]);
+	cache[slot] = entry;
+
+	k_mutex_unlock(&cache_mutex);
+
+	LOG_DBG("Discovery result cached, %zu attributes", entry->attr_cnt);
+}
+
+/* Fills the instance with a cached discovery result. */
+static int cache_restore(struct bt_gatt_dm *dm)
+{
+	const bt_addr_le_t *addr = bt_conn_get_dst(dm->conn);
+	struct cache_entry *entry = NULL;
+	int err = 0;
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i] &&
+		    cache_entry_match(cache[i], addr, dm->discover_params.uuid)) {
+			entry = cache[i];
+			break;
+		}
+	}
+
+	if (!entry || memcmp(entry->hash, dm->hash, sizeof(dm->hash))) {
+		k_mutex_unlock(&cache_mutex);
+		return -ENOENT;
+	}
+
+	for (size_t i = 0; (i < entry->attr_cnt) && !err; i++) {
+		const struct cache_attr *cached = &entry->attrs[i];
+		struct bt_gatt_attr attr = {
+			.uuid = &cached->uuid.uuid,
+			.handle = cached->handle,
+			.perm = cached->perm,
+		};
+		struct bt_gatt_dm_attr *cur_attr;
+		struct bt_gatt_service_val *svc;
+		struct bt_gatt_chrc *chrc;
+
+		if (!bt_uuid_cmp(attr.uuid, BT_UUID_GATT_PRIMARY) ||
+		    !bt_uuid_cmp(attr.uuid, BT_UUID_GATT_SECONDARY)) {
+			cur_attr = attr_store(dm, &attr, sizeof(*svc));
+			svc = cur_attr ? bt_gatt_dm_attr_service_val(cur_attr) :
+					 NULL;
+			if (svc) {
+				*svc = cached->val.svc;
+				svc->uuid = uuid_store(dm,
+						       &cached->val_uuid.uuid);
+				err = svc->uuid ? 0 : -ENOMEM;
+			}
+		} else if (!bt_uuid_cmp(attr.uuid, BT_UUID_GATT_CHRC)) {
+			cur_attr = attr_store(dm, &attr, sizeof(*chrc));
+			chrc = cur_attr ? bt_gatt_dm_attr_chrc_val(cur_attr) :
+					  NULL;
+			if (chrc) {
+				*chrc = cached->val.chrc;
+				chrc->uuid = uuid_store(dm,
+							&cached->val_uuid.uuid);
+				err = chrc->uuid ? 0 : -ENOMEM;
+			}
+		} else {
+			cur_attr = attr_store(dm, &attr, 0);
+		}
+
+		if (!cur_attr) {
+			err = -ENOMEM;
+		}
+	}
+
+	if (!err) {
+		entry->last_used = ++cache_use_cnt;
+	}
+
+	k_mutex_unlock(&cache_mutex);
+
+	if (err) {
+		/* The partially restored attributes are discarded, their
+		 * memory is released with the rest of the discovery data.
+		 */
+		dm->cur_attr_id = 0;
+		return err;
+	}
+
+	/* Continue with the same handle range as after a discovery. */
+	dm->discover_params.end_handle =
+		bt_gatt_dm_attr_service_val(&dm->attrs[0])->end_handle;
+
+	return 0;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 static void discovery_complete(struct bt_gatt_dm *dm)
 {
 	LOG_DBG("Discovery complete.");
 	atomic_set_bit(dm->state_flags, STATE_ATTRS_RELEASE_PENDING);
+
+#if CONFIG_BT_GATT_DM_CACHE
+	if (dm->cache_pending) {
+		dm->cache_pending = false;
+		cache_store(dm);
+	}
+#endif
+
 	if (dm->callback->completed) {
 		dm->callback->completed(dm, dm->context);
 	}
@@ -406,30 +632,29 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 			       const struct bt_gatt_attr *attr,
 			       struct bt_gatt_discover_params *params)
 {
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     discover_params);
+
 	if (!attr) {
 		LOG_DBG("NULL attribute");
 	} else {
 		LOG_DBG("Attr: handle %u", attr->handle);
 	}
 
-	if (conn != bt_gatt_dm_inst.conn) {
+	if (conn != dm->conn) {
 		LOG_ERR("Unexpected conn object. Aborting.");
-		discovery_complete_error(&bt_gatt_dm_inst, -EFAULT);
+		discovery_complete_error(dm, -EFAULT);
 		return BT_GATT_ITER_STOP;
 	}
 
 	switch (params->type) {
 	case BT_GATT_DISCOVER_PRIMARY:
 	case BT_GATT_DISCOVER_SECONDARY:
-		return discovery_process_service(&bt_gatt_dm_inst,
-						 attr, params);
+		return discovery_process_service(dm, attr, params);
 	case BT_GATT_DISCOVER_ATTRIBUTE:
-		return discovery_process_attribute(&bt_gatt_dm_inst,
-						   attr, params);
+		return discovery_process_attribute(dm, attr, params);
 	case BT_GATT_DISCOVER_CHARACTERISTIC:
-		return discovery_process_characteristic(&bt_gatt_dm_inst,
-							attr,
-							params);
+		return discovery_process_characteristic(dm, attr, params);
 	default:
 		/* This should not be possible */
 		__ASSERT(false, "Unknown param type.");
@@ -568,6 +793,82 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
 	return curr;
 }
 
+/* Checks if a discovery is running on the connection.
+ * Called with instance_lock held.
+ */
+static bool conn_busy(struct bt_conn *conn)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(bt_gatt_dm_inst); i++) {
+		if (atomic_test_bit(bt_gatt_dm_inst[i].state_flags,
+				    STATE_ATTRS_LOCKED) &&
+		    (bt_gatt_dm_inst[i].conn == conn)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Locks a free instance for the connection, unless a discovery is already
+ * running on it. The check and the claim are done under the lock, so that
+ * two discoveries started at once on a connection cannot both succeed.
+ */
+static struct bt_gatt_dm *instance_get(struct bt_conn *conn)
+{
+	struct bt_gatt_dm *dm = NULL;
+	k_spinlock_key_t key = k_spin_lock(&instance_lock);
+
+	if (!conn_busy(conn)) {
+		for (size_t i = 0; i < ARRAY_SIZE(bt_gatt_dm_inst); i++) {
+			if (!atomic_test_and_set_bit(
+				    bt_gatt_dm_inst[i].state_flags,
+				    STATE_ATTRS_LOCKED)) {
+				dm = &bt_gatt_dm_inst[i];
+				dm->conn = conn;
+				break;
+			}
+		}
+	}
+
+	k_spin_unlock(&instance_lock, key);
+
+	return dm;
+}
+
+#if CONFIG_BT_GATT_DM_CACHE
+static uint8_t hash_read_callback(struct bt_conn *conn, uint8_t err,
+				  struct bt_gatt_read_params *params,
+				  const void *data, uint16_t length)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     hash_params);
+	int ret;
+
+	/* Without the Database Hash, the result cannot be cached. */
+	if (!err && data && (length == sizeof(dm->hash))) {
+		memcpy(dm->hash, data, sizeof(dm->hash));
+
+		if (!cache_restore(dm)) {
+			LOG_DBG("Discovery result restored from cache");
+			discovery_complete(dm);
+			return BT_GATT_ITER_STOP;
+		}
+
+		dm->cache_pending = true;
+	} else {
+		LOG_DBG("No Database Hash, error: %u", err);
+	}
+
+	ret = bt_gatt_discover(conn, &dm->discover_params);
+	if (ret) {
+		LOG_ERR("Discover failed, error: %d.", ret);
+		discovery_complete_error(dm, ret);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_uuid *svc_uuid,
 		     const struct bt_gatt_dm_cb *cb,
@@ -586,13 +887,11 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 		return -EINVAL;
 	}
 
-	dm = &bt_gatt_dm_inst;
-
-	if (atomic_test_and_set_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
+	dm = instance_get(conn);
+	if (!dm) {
 		return -EALREADY;
 	}
 
-	dm->conn = conn;
 	dm->context = context;
 	dm->callback = cb;
 	dm->cur_attr_id = 0;
@@ -605,9 +904,27 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
+#if CONFIG_BT_GATT_DM_CACHE
+	dm->cache_pending = false;
+
+	/* The Database Hash tells if the cached result of a bonded peer
+	 * is still valid.
+	 */
+	if (svc_uuid && gatt_peer_cache_bonded(conn)) {
+		err = gatt_peer_cache_hash_read(conn, &dm->hash_params,
+						hash_read_callback);
+		if (!err) {
+			return 0;
+		}
+
+		LOG_WRN("Database Hash read failed, error: %d.", err);
+	}
+#endif
+
 	err = bt_gatt_discover(conn, &dm->discover_params);
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
+		svc_attr_memory_release(dm);
 		atomic_clear_bit(dm->state_flags, STATE_ATTRS_LOCKED);
 	}
 
@@ -668,6 +985,23 @@ int bt_gatt_dm_data_release(struct bt_gatt_dm *dm)
 	return 0;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+void bt_gatt_dm_cache_clear(const bt_addr_le_t *addr)
+{
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i] &&
+		    (!addr || !bt_addr_le_cmp(&cache[i]->addr, addr))) {
+			k_free(cache[i]);
+			cache[i] = NULL;
+		}
+	}
+
+	k_mutex_unlock(&cache_mutex);
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 #if CONFIG_BT_GATT_DM_DATA_PRINT
 
 #define UUID_STR_LEN 37
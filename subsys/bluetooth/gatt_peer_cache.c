@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/uuid.h>
+
+#include "gatt_peer_cache.h"
+
+/* Outlives the read, unlike BT_UUID_GATT_DB_HASH */
+static const struct bt_uuid_16 db_hash_uuid =
+	BT_UUID_INIT_16(BT_UUID_GATT_DB_HASH_VAL);
+
+struct bond_find_data {
+	const bt_addr_le_t *addr;
+	bool found;
+};
+
+static void bond_find(const struct bt_bond_info *info, void *user_data)
+{
+	struct bond_find_data *data = user_data;
+
+	if (!bt_addr_le_cmp(&info->addr, data->addr)) {
+		data->found = true;
+	}
+}
+
+bool gatt_peer_cache_bonded(struct bt_conn *conn)
+{
+	struct bt_conn_info info;
+	struct bond_find_data data = {
+		.addr = bt_conn_get_dst(conn),
+	};
+
+	if (bt_conn_get_info(conn, &info)) {
+		return false;
+	}
+
+	bt_foreach_bond(info.id, bond_find, &data);
+
+	return data.found;
+}
+
+int gatt_peer_cache_hash_read(struct bt_conn *conn,
+			      struct bt_gatt_read_params *params,
+			      bt_gatt_read_func_t func)
+{
+	params->func = func;
+	params->handle_count = 0;
+	params->by_uuid.uuid = &db_hash_uuid.uuid;
+	params->by_uuid.start_handle = 0x0001;
+	params->by_uuid.end_handle = 0xffff;
+
+	return bt_gatt_read(conn, params);
+}
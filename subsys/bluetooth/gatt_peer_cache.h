@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BT_GATT_PEER_CACHE_H_
+#define BT_GATT_PEER_CACHE_H_
+
+/**
+ * @file
+ * @brief Helpers for caching the GATT database of bonded peers.
+ *
+ * Internal module of the GATT Discovery Manager and the HIDS client.
+ */
+
+#include <stdbool.h>
+#include <bluetooth/conn.h>
+#include <bluetooth/gatt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the GATT Database Hash. */
+#define GATT_PEER_CACHE_HASH_LEN 16
+
+/** @brief Check if the peer of a connection is bonded.
+ *
+ * @param conn Connection object.
+ *
+ * @return True if a bond exists with the peer on the local identity
+ *         of the connection.
+ */
+bool gatt_peer_cache_bonded(struct bt_conn *conn);
+
+/** @brief Read the Database Hash of the peer.
+ *
+ * The read is done by UUID, over the whole handle range.
+ *
+ * @param conn   Connection object.
+ * @param params Read parameters. They must stay valid until the read
+ *               completes.
+ * @param func   Read callback.
+ *
+ * @return 0 or negative error code from @ref bt_gatt_read.
+ */
+int gatt_peer_cache_hash_read(struct bt_conn *conn,
+			      struct bt_gatt_read_params *params,
+			      bt_gatt_read_func_t func);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BT_GATT_PEER_CACHE_H_ */
@@ -14,6 +14,14 @@ LOG_MODULE_REGISTER(bt_gatt_pool, CONFIG_BT_GATT_POOL_LOG_LEVEL);
 struct svc_el_pool {
 	void *elements;
 	atomic_t *locks;
+	/* Index of the lock word where the search for a free element starts. */
+	atomic_t hint;
+#if CONFIG_BT_GATT_POOL_STATS != 0
+	atomic_t used_cnt;
+	atomic_t max_used_cnt;
+	atomic_t alloc_cnt;
+	atomic_t fail_cnt;
+#endif
 };
 
 #if CONFIG_BT_GATT_UUID16_POOL_SIZE != 0
@@ -88,19 +96,87 @@ static struct bt_uuid const * const uuid_ccc = BT_UUID_GATT_CCC;
 #define ADDR_2_INDEX(pool, el)                                                 \
 	((((uint32_t)el) - ((uint32_t)pool)) / (sizeof(pool[0])))
 
+#define LOCK_WORD_CNT(el_cnt) DIV_ROUND_UP(el_cnt, ATOMIC_BITS)
+
+static void stats_alloc_update(struct svc_el_pool *el_pool, bool success)
+{
+#if CONFIG_BT_GATT_POOL_STATS != 0
+	if (!success) {
+		atomic_inc(&el_pool->fail_cnt);
+		return;
+	}
+
+	atomic_val_t used_cnt = atomic_inc(&el_pool->used_cnt) + 1;
+	atomic_val_t max_used_cnt;
+
+	atomic_inc(&el_pool->alloc_cnt);
+
+	do {
+		max_used_cnt = atomic_get(&el_pool->max_used_cnt);
+		if (used_cnt <= max_used_cnt) {
+			break;
+		}
+	} while (!atomic_cas(&el_pool->max_used_cnt, max_used_cnt, used_cnt));
+#endif
+}
+
+static void stats_release_update(struct svc_el_pool *el_pool)
+{
+#if CONFIG_BT_GATT_POOL_STATS != 0
+	atomic_dec(&el_pool->used_cnt);
+#endif
+}
+
 static size_t free_element_find(struct svc_el_pool *el_pool, size_t el_cnt)
 {
 	__ASSERT((el_pool->elements != NULL) && (el_pool->locks != NULL),
 		 "Pool uninitialized");
 
-	for (size_t i = 0; i < el_cnt; i++) {
-		if (!atomic_test_and_set_bit(el_pool->locks, i)) {
-			return i;
+	size_t word_cnt = LOCK_WORD_CNT(el_cnt);
+	size_t start = atomic_get(&el_pool->hint);
+
+	/* Check a whole lock word at a time, starting from the word that
+	 * is likely to have a free element.
+	 */
+	for (size_t i = 0; i < word_cnt; i++) {
+		size_t word = (start + i) % word_cnt;
+		atomic_val_t locks = atomic_get(&el_pool->locks[word]);
+
+		while (~locks != 0) {
+			size_t bit = find_lsb_set(~locks) - 1;
+			size_t ind = word * ATOMIC_BITS + bit;
+
+			if (ind >= el_cnt) {
+				break;
+			}
+
+			if (atomic_cas(&el_pool->locks[word], locks,
+				       locks | BIT(bit))) {
+				atomic_set(&el_pool->hint, word);
+				stats_alloc_update(el_pool, true);
+
+				return ind;
+			}
+
+			/* Lock word was modified concurrently, try again. */
+			locks = atomic_get(&el_pool->locks[word]);
 		}
 	}
+
+	stats_alloc_update(el_pool, false);
+
 	return el_cnt;
 }
 
+static void element_release(struct svc_el_pool *el_pool, size_t ind)
+{
+	atomic_clear_bit(el_pool->locks, ind);
+
+	/* Next search starts from the word with the released element. */
+	atomic_set(&el_pool->hint, ind / ATOMIC_BITS);
+	stats_release_update(el_pool);
+}
+
 static int uuid_16_get(struct bt_uuid **uuid, struct svc_el_pool *uuid_pool)
 {
 	size_t ind = free_element_find(uuid_pool,
@@ -163,8 +239,7 @@ static int chrc_get(struct bt_gatt_chrc **chrc)
 static void chrc_release(struct bt_gatt_chrc const *chrc)
 {
 	EL_IN_POOL_VERIFY(BT_GATT_CHRC_TAB, chrc);
-	atomic_clear_bit(chrc_pool.locks,
-			 ADDR_2_INDEX(BT_GATT_CHRC_TAB, chrc));
+	element_release(&chrc_pool, ADDR_2_INDEX(BT_GATT_CHRC_TAB, chrc));
 }
 
 static int uuid_register(struct bt_uuid **dest_uuid,
@@ -210,24 +285,24 @@ static void uuid_unregister(struct bt_uuid const *uuid)
 	case BT_UUID_TYPE_16:
 		EL_IN_POOL_VERIFY(BT_UUID_16_TAB, uuid);
 #if CONFIG_BT_GATT_UUID16_POOL_SIZE != 0
-		atomic_clear_bit(uuid_16_pool.locks,
-				 ADDR_2_INDEX(BT_UUID_16_TAB, uuid));
+		element_release(&uuid_16_pool,
+				ADDR_2_INDEX(BT_UUID_16_TAB, uuid));
 #endif
 		break;
 
 	case BT_UUID_TYPE_32:
 		EL_IN_POOL_VERIFY(BT_UUID_32_TAB, uuid);
 #if CONFIG_BT_GATT_UUID32_POOL_SIZE != 0
-		atomic_clear_bit(uuid_32_pool.locks,
-				 ADDR_2_INDEX(BT_UUID_32_TAB, uuid));
+		element_release(&uuid_32_pool,
+				ADDR_2_INDEX(BT_UUID_32_TAB, uuid));
 #endif
 		break;
 
 	case BT_UUID_TYPE_128:
 		EL_IN_POOL_VERIFY(BT_UUID_128_TAB, uuid);
 #if CONFIG_BT_GATT_UUID128_POOL_SIZE != 0
-		atomic_clear_bit(uuid_128_pool.locks,
-				 ADDR_2_INDEX(BT_UUID_128_TAB, uuid));
+		element_release(&uuid_128_pool,
+				ADDR_2_INDEX(BT_UUID_128_TAB, uuid));
 #endif
 		break;
 
@@ -420,6 +495,62 @@ void bt_gatt_pool_free(struct bt_gatt_pool *gp)
 
 
 #if CONFIG_BT_GATT_POOL_STATS != 0
+int bt_gatt_pool_stats_get(enum bt_gatt_pool_type type,
+			   struct bt_gatt_pool_stats *stats)
+{
+	struct svc_el_pool *el_pool;
+	size_t el_cnt;
+
+	if (!stats) {
+		return -EINVAL;
+	}
+
+	switch (type) {
+	case BT_GATT_POOL_TYPE_UUID16:
+		el_pool = &uuid_16_pool;
+		el_cnt = CONFIG_BT_GATT_UUID16_POOL_SIZE;
+		break;
+
+	case BT_GATT_POOL_TYPE_UUID32:
+		el_pool = &uuid_32_pool;
+		el_cnt = CONFIG_BT_GATT_UUID32_POOL_SIZE;
+		break;
+
+	case BT_GATT_POOL_TYPE_UUID128:
+		el_pool = &uuid_128_pool;
+		el_cnt = CONFIG_BT_GATT_UUID128_POOL_SIZE;
+		break;
+
+	case BT_GATT_POOL_TYPE_CHRC:
+		el_pool = &chrc_pool;
+		el_cnt = CONFIG_BT_GATT_CHRC_POOL_SIZE;
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	stats->size = el_cnt;
+	stats->used = atomic_get(&el_pool->used_cnt);
+	stats->max_used = atomic_get(&el_pool->max_used_cnt);
+	stats->alloc_cnt = atomic_get(&el_pool->alloc_cnt);
+	stats->fail_cnt = atomic_get(&el_pool->fail_cnt);
+
+	return 0;
+}
+
+static void counters_print(enum bt_gatt_pool_type type)
+{
+	struct bt_gatt_pool_stats stats;
+	int err = bt_gatt_pool_stats_get(type, &stats);
+
+	__ASSERT_NO_MSG(!err);
+	ARG_UNUSED(err);
+
+	printk("Maximum usage: %u, allocations: %u, failed allocations: %u\n\n",
+	       (uint32_t)stats.max_used, stats.alloc_cnt, stats.fail_cnt);
+}
+
 static size_t mask_print(atomic_t *mask, size_t mask_size)
 {
 	size_t used_el_cnt = 0;
@@ -443,8 +574,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_UUID_16_LOCKS,
 				 ARRAY_SIZE(BT_UUID_16_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
+	printk("\nPool element usage: %d out of %d\n", used_el_cnt,
 	       CONFIG_BT_GATT_UUID16_POOL_SIZE);
+	counters_print(BT_GATT_POOL_TYPE_UUID16);
 #endif
 
 #if CONFIG_BT_GATT_UUID32_POOL_SIZE != 0
@@ -453,8 +585,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_UUID_32_LOCKS,
 				 ARRAY_SIZE(BT_UUID_32_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
+	printk("\nPool element usage: %d out of %d\n", used_el_cnt,
 	       CONFIG_BT_GATT_UUID32_POOL_SIZE);
+	counters_print(BT_GATT_POOL_TYPE_UUID32);
 #endif
 
 #if CONFIG_BT_GATT_UUID128_POOL_SIZE != 0
@@ -463,8 +596,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_UUID_128_LOCKS,
 				 ARRAY_SIZE(BT_UUID_128_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
+	printk("\nPool element usage: %d out of %d\n", used_el_cnt,
 	       CONFIG_BT_GATT_UUID128_POOL_SIZE);
+	counters_print(BT_GATT_POOL_TYPE_UUID128);
 #endif
 
 #if CONFIG_BT_GATT_CHRC_POOL_SIZE != 0
@@ -473,8 +607,9 @@ void bt_gatt_pool_stats_print(void)
 	used_el_cnt = mask_print(BT_GATT_CHRC_LOCKS,
 				 ARRAY_SIZE(BT_GATT_CHRC_LOCKS));
 
-	printk("\nPool element usage: %d out of %d\n\n", used_el_cnt,
+	printk("\nPool element usage: %d out of %d\n", used_el_cnt,
 	       CONFIG_BT_GATT_CHRC_POOL_SIZE);
+	counters_print(BT_GATT_POOL_TYPE_CHRC);
 #endif
 }
 #endif /* CONFIG_BT_GATT_POOL_STATS */
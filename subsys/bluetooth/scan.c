@@ -18,6 +18,13 @@ LOG_MODULE_REGISTER(nrf_bt_scan, CONFIG_BT_SCAN_LOG_LEVEL);
 	BT_SCAN_SHORT_NAME_FILTER | BT_SCAN_APPEARANCE_FILTER | \
 	BT_SCAN_UUID_FILTER | BT_SCAN_MANUFACTURER_DATA_FILTER)
 
+/* Address and UUID filters are indexed by hash tables with open addressing.
+ * Every slot holds the filter index incremented by one, so that zero marks
+ * a free slot. A table has twice as many slots as filters, so that the probe
+ * sequences stay short and the lookup always ends on a free slot.
+ */
+#define FILTER_HASH_SIZE(_cnt) (2 * (_cnt))
+
 /* Scan filter mutex. */
 K_MUTEX_DEFINE(scan_mutex);
 
@@ -55,8 +62,11 @@ struct bt_scan_name_filter {
 	 */
 	char target_name[CONFIG_BT_SCAN_NAME_CNT][CONFIG_BT_SCAN_NAME_MAX_LEN];
 
+	/* Filter indexes sorted by the target name. */
+	uint16_t sorted[CONFIG_BT_SCAN_NAME_CNT];
+
 	/* Name filter counter. */
-	uint8_t cnt;
+	uint16_t cnt;
 
 	/* Flag to inform about enabling or disabling this filter.
 	 */
@@ -76,8 +86,11 @@ struct bt_scan_short_name_filter {
 		uint8_t min_len;
 	} name[CONFIG_BT_SCAN_SHORT_NAME_CNT];
 
+	/* Filter indexes sorted by the target short name. */
+	uint16_t sorted[CONFIG_BT_SCAN_SHORT_NAME_CNT];
+
 	/* Short name filter counter. */
-	uint8_t cnt;
+	uint16_t cnt;
 
 	/* Flag to inform about enabling or disabling this filter. */
 	bool enabled;
@@ -89,8 +102,11 @@ struct bt_scan_addr_filter {
 	/* Addresses advertised by the peripherals. */
 	bt_addr_le_t target_addr[CONFIG_BT_SCAN_ADDRESS_CNT];
 
+	/* Hash table of the addresses. */
+	uint16_t hash[FILTER_HASH_SIZE(CONFIG_BT_SCAN_ADDRESS_CNT)];
+
 	/* Address filter counter. */
-	uint8_t cnt;
+	uint16_t cnt;
 
 	/* Flag to inform about enabling or disabling this filter. */
 	bool enabled;
@@ -120,8 +136,11 @@ struct bt_scan_uuid_filter {
 	 */
 	struct bt_scan_uuid uuid[CONFIG_BT_SCAN_UUID_CNT];
 
+	/* Hash table of the UUIDs. */
+	uint16_t hash[FILTER_HASH_SIZE(CONFIG_BT_SCAN_UUID_CNT)];
+
 	/* UUID filter counter. */
-	uint8_t cnt;
+	uint16_t cnt;
 
 	/* Flag to inform about enabling or disabling this filter. */
 	bool enabled;
@@ -501,19 +520,65 @@ static void scan_connect_with_target(struct bt_scan_control *control,
 	}
 }
 
+static uint32_t filter_hash(const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+
+	/* FNV-1a hash. */
+	uint32_t hash = 2166136261U;
+
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ bytes[i]) * 16777619U;
+	}
+
+	return hash;
+}
+
+static void filter_hash_insert(uint16_t *table, size_t size, uint32_t hash,
+			       uint16_t idx)
+{
+	size_t i = hash % size;
+
+	while (table[i] != 0) {
+		i = (i + 1) % size;
+	}
+
+	table[i] = idx + 1;
+}
+
+static const bt_addr_le_t *addr_filter_find(const bt_addr_le_t *target_addr)
+{
+	const struct bt_scan_addr_filter *addr_filter =
+			&bt_scan.scan_filters.addr;
+	const size_t size = ARRAY_SIZE(addr_filter->hash);
+
+	if (addr_filter->cnt == 0) {
+		return NULL;
+	}
+
+	for (size_t i = filter_hash(target_addr, sizeof(*target_addr)) % size;
+	     addr_filter->hash[i] != 0;
+	     i = (i + 1) % size) {
+		const bt_addr_le_t *addr =
+			&addr_filter->target_addr[addr_filter->hash[i] - 1];
+
+		if (bt_addr_le_cmp(target_addr, addr) == 0) {
+			return addr;
+		}
+	}
+
+	return NULL;
+}
+
 static bool adv_addr_compare(const bt_addr_le_t *target_addr,
 			     struct bt_scan_control *control)
 {
-	const bt_addr_le_t *addr =
-			bt_scan.scan_filters.addr.target_addr;
-	uint8_t counter = bt_scan.scan_filters.addr.cnt;
+	const bt_addr_le_t *addr = addr_filter_find(target_addr);
 
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_addr_le_cmp(target_addr, &addr[i]) == 0) {
-			control->filter_status.addr.addr = &addr[i];
+	if (addr) {
+		control->filter_status.addr.addr = addr;
 
-			return true;
-		}
+		return true;
 	}
 
 	return false;
@@ -541,9 +606,8 @@ static void check_addr(struct bt_scan_control *control,
 static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 {
 	char addr[BT_ADDR_LE_STR_LEN];
-	bt_addr_le_t *addr_filter =
-			bt_scan.scan_filters.addr.target_addr;
-	uint8_t counter = bt_scan.scan_filters.addr.cnt;
+	struct bt_scan_addr_filter *addr_filter = &bt_scan.scan_filters.addr;
+	uint16_t counter = addr_filter->cnt;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_ADDRESS_CNT) {
@@ -551,28 +615,71 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	}
 
 	/* Check for duplicated filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_addr_le_cmp(target_addr, &addr_filter[i]) == 0) {
-			return 0;
-		}
+	if (addr_filter_find(target_addr)) {
+		return 0;
 	}
 
 	/* Add target address to filter. */
-	bt_addr_le_copy(&addr_filter[counter], target_addr);
+	bt_addr_le_copy(&addr_filter->target_addr[counter], target_addr);
+	filter_hash_insert(addr_filter->hash, ARRAY_SIZE(addr_filter->hash),
+			   filter_hash(target_addr, sizeof(*target_addr)),
+			   counter);
 
 	LOG_DBG("Filter set on address type %i",
-		addr_filter[counter].type);
+		addr_filter->target_addr[counter].type);
 
 	bt_addr_le_to_str(target_addr, addr, sizeof(addr));
 
 	LOG_DBG("Address: %s", addr);
 
 	/* Increase the address filter counter. */
-	bt_scan.scan_filters.addr.cnt++;
+	addr_filter->cnt++;
 
 	return 0;
 }
 
+/* Name filters are indexed by arrays of the filter indexes sorted by
+ * the target names. The advertised name matches a filter if it is a prefix
+ * of the target name, so all matching filters are next to each other in
+ * the sorted array and the first of them is found with a binary search.
+ */
+static const char *name_filter_get(uint16_t idx)
+{
+	return bt_scan.scan_filters.name.target_name[idx];
+}
+
+static const char *short_name_filter_get(uint16_t idx)
+{
+	return bt_scan.scan_filters.short_name.name[idx].target_name;
+}
+
+static size_t name_lower_bound(const uint16_t *sorted, uint16_t cnt,
+			       const char *(*name_get)(uint16_t idx),
+			       const char *name, size_t len)
+{
+	size_t lower = 0;
+	size_t upper = cnt;
+
+	while (lower < upper) {
+		size_t m = (lower + upper) / 2;
+
+		if (strncmp(name_get(sorted[m]), name, len) < 0) {
+			lower = m + 1;
+		} else {
+			upper = m;
+		}
+	}
+
+	return lower;
+}
+
+static void name_sorted_insert(uint16_t *sorted, uint16_t cnt, size_t pos,
+			       uint16_t idx)
+{
+	memmove(&sorted[pos + 1], &sorted[pos], (cnt - pos) * sizeof(sorted[0]));
+	sorted[pos] = idx;
+}
+
 static bool adv_name_cmp(const uint8_t *data,
 			 uint8_t data_len,
 			 const char *target_name)
@@ -585,21 +692,30 @@ static bool adv_name_compare(const struct bt_data *data,
 {
 	struct bt_scan_name_filter const *name_filter =
 			&bt_scan.scan_filters.name;
-	uint8_t counter = bt_scan.scan_filters.name.cnt;
+	uint16_t counter = name_filter->cnt;
 	uint8_t data_len = data->data_len;
+	const char *target_name;
+	size_t pos;
+
+	/* Longer name cannot be a prefix of any target name. */
+	if (data_len > CONFIG_BT_SCAN_NAME_MAX_LEN) {
+		return false;
+	}
 
 	/* Compare the name found with the name filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_name_cmp(data->data,
-				 data_len,
-				 name_filter->target_name[i])) {
+	pos = name_lower_bound(name_filter->sorted, counter, name_filter_get,
+			       (const char *)data->data, data_len);
+	if (pos >= counter) {
+		return false;
+	}
 
-			control->filter_status.name.name =
-				name_filter->target_name[i];
-			control->filter_status.name.len = data_len;
+	target_name = name_filter_get(name_filter->sorted[pos]);
 
-			return true;
-		}
+	if (adv_name_cmp(data->data, data_len, target_name)) {
+		control->filter_status.name.name = target_name;
+		control->filter_status.name.len = data_len;
+
+		return true;
 	}
 
 	return false;
@@ -626,8 +742,10 @@ static void name_check(struct bt_scan_control *control,
 
 static int scan_name_filter_add(const char *name)
 {
-	uint8_t counter = bt_scan.scan_filters.name.cnt;
+	struct bt_scan_name_filter *name_filter = &bt_scan.scan_filters.name;
+	uint16_t counter = name_filter->cnt;
 	size_t name_len;
+	size_t pos;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_NAME_CNT) {
@@ -642,53 +760,56 @@ static int scan_name_filter_add(const char *name)
 	}
 
 	/* Check for duplicated filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (!strcmp(bt_scan.scan_filters.name.target_name[i], name)) {
-			return 0;
-		}
+	pos = name_lower_bound(name_filter->sorted, counter, name_filter_get,
+			       name, CONFIG_BT_SCAN_NAME_MAX_LEN);
+	if ((pos < counter) &&
+	    !strncmp(name_filter_get(name_filter->sorted[pos]), name,
+		     CONFIG_BT_SCAN_NAME_MAX_LEN)) {
+		return 0;
 	}
 
 	/* Add name to filter. */
-	memcpy(bt_scan.scan_filters.name.target_name[counter],
-	       name, name_len);
+	strncpy(name_filter->target_name[counter], name,
+		CONFIG_BT_SCAN_NAME_MAX_LEN);
+	name_sorted_insert(name_filter->sorted, counter, pos, counter);
 
-	bt_scan.scan_filters.name.cnt++;
+	name_filter->cnt++;
 
 	LOG_DBG("Adding filter on %s name", name);
 
 	return 0;
 }
 
-static bool adv_short_name_cmp(const uint8_t *data,
-			       uint8_t data_len,
-			       const char *target_name,
-			       uint8_t short_name_min_len)
-{
-	if ((data_len >= short_name_min_len) &&
-	    (strncmp(target_name, data, data_len) == 0)) {
-		return true;
-	}
-
-	return false;
-}
-
 static bool adv_short_name_compare(const struct bt_data *data,
 				   struct bt_scan_control *control)
 {
 	const struct bt_scan_short_name_filter *name_filter =
 			&bt_scan.scan_filters.short_name;
-	uint8_t counter = bt_scan.scan_filters.short_name.cnt;
+	uint16_t counter = name_filter->cnt;
 	uint8_t data_len = data->data_len;
 
-	/* Compare the name found with the name filters. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_short_name_cmp(data->data,
-				       data_len,
-				       name_filter->name[i].target_name,
-				       name_filter->name[i].min_len)) {
+	/* Longer name cannot be a prefix of any target name. */
+	if (data_len > CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN) {
+		return false;
+	}
+
+	/* Compare the name found with the name filters that have it
+	 * as a prefix.
+	 */
+	for (size_t i = name_lower_bound(name_filter->sorted, counter,
+					 short_name_filter_get,
+					 (const char *)data->data, data_len);
+	     i < counter; i++) {
+		uint16_t idx = name_filter->sorted[i];
+
+		if (!adv_name_cmp(data->data, data_len,
+				  name_filter->name[idx].target_name)) {
+			break;
+		}
 
+		if (data_len >= name_filter->name[idx].min_len) {
 			control->filter_status.short_name.name =
-				name_filter->name[i].target_name;
+				name_filter->name[idx].target_name;
 			control->filter_status.short_name.len = data_len;
 
 			return true;
@@ -719,11 +840,11 @@ static void short_name_check(struct bt_scan_control *control,
 
 static int scan_short_name_filter_add(const struct bt_scan_short_name *short_name)
 {
-	uint8_t counter =
-		bt_scan.scan_filters.short_name.cnt;
 	struct bt_scan_short_name_filter *short_name_filter =
 		    &bt_scan.scan_filters.short_name;
+	uint16_t counter = short_name_filter->cnt;
 	uint8_t name_len;
+	size_t pos;
 
 	/* If no memory for filter. */
 	if (counter >= CONFIG_BT_SCAN_SHORT_NAME_CNT) {
@@ -739,63 +860,94 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	}
 
 	/* Check for duplicated filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (!strcmp(short_name_filter->name[i].target_name,
-			    short_name->name)) {
-			return 0;
-		}
+	pos = name_lower_bound(short_name_filter->sorted, counter,
+			       short_name_filter_get, short_name->name,
+			       CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN);
+	if ((pos < counter) &&
+	    !strncmp(short_name_filter_get(short_name_filter->sorted[pos]),
+		     short_name->name, CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN)) {
+		return 0;
 	}
 
 	/* Add name to the filter. */
 	short_name_filter->name[counter].min_len = short_name->min_len;
-	memcpy(short_name_filter->name[counter].target_name,
-	       short_name->name,
-	       name_len);
+	strncpy(short_name_filter->name[counter].target_name,
+		short_name->name,
+		CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN);
+	name_sorted_insert(short_name_filter->sorted, counter, pos, counter);
 
-	bt_scan.scan_filters.short_name.cnt++;
+	short_name_filter->cnt++;
 
 	LOG_DBG("Adding filter on %s name", short_name->name);
 
 	return 0;
 }
 
-static bool find_uuid(const uint8_t *data,
-		      uint8_t data_len,
-		      uint8_t uuid_type,
-		      const struct bt_scan_uuid *target_uuid)
+static uint8_t uuid_len_get(uint8_t uuid_type)
 {
-	uint8_t uuid_len;
-
 	switch (uuid_type) {
 	case BT_UUID_TYPE_16:
-		uuid_len = sizeof(uint16_t);
+		return sizeof(uint16_t);
+
+	case BT_UUID_TYPE_32:
+		return sizeof(uint32_t);
+
+	case BT_UUID_TYPE_128:
+		return BT_SCAN_UUID_128_SIZE * sizeof(uint8_t);
+
+	default:
+		return 0;
+	}
+}
+
+/* UUIDs are hashed in the little-endian encoding used in the advertising
+ * data.
+ */
+static uint32_t uuid_hash(const struct bt_uuid *uuid)
+{
+	uint8_t data[BT_SCAN_UUID_128_SIZE];
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		sys_put_le16(BT_UUID_16(uuid)->val, data);
 		break;
 
 	case BT_UUID_TYPE_32:
-		uuid_len = sizeof(uint32_t);
+		sys_put_le32(BT_UUID_32(uuid)->val, data);
 		break;
 
 	case BT_UUID_TYPE_128:
-		uuid_len = BT_SCAN_UUID_128_SIZE * sizeof(uint8_t);
+		memcpy(data, BT_UUID_128(uuid)->val, BT_SCAN_UUID_128_SIZE);
 		break;
 
 	default:
-		return false;
+		return 0;
 	}
 
-	for (size_t i = 0; i < data_len; i += uuid_len) {
-		struct bt_uuid_128 uuid;
+	return filter_hash(data, uuid_len_get(uuid->type));
+}
 
-		if (!bt_uuid_create(&uuid.uuid, &data[i], uuid_len)) {
-			return false;
-		}
+static int uuid_filter_find(const struct bt_uuid *uuid)
+{
+	const struct bt_scan_uuid_filter *uuid_filter =
+			&bt_scan.scan_filters.uuid;
+	const size_t size = ARRAY_SIZE(uuid_filter->hash);
 
-		if (bt_uuid_cmp(&uuid.uuid, target_uuid->uuid) == 0) {
-			return true;
+	if (uuid_filter->cnt == 0) {
+		return -ENOENT;
+	}
+
+	for (size_t i = uuid_hash(uuid) % size;
+	     uuid_filter->hash[i] != 0;
+	     i = (i + 1) % size) {
+		uint16_t idx = uuid_filter->hash[i] - 1;
+
+		if (bt_uuid_cmp(uuid, uuid_filter->uuid[idx].uuid) == 0) {
+			return idx;
 		}
 	}
 
-	return false;
+	return -ENOENT;
 }
 
 static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
@@ -804,27 +956,45 @@ static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
 	const struct bt_scan_uuid_filter *uuid_filter =
 			&bt_scan.scan_filters.uuid;
 	const bool all_filters_mode = bt_scan.scan_filters.all_mode;
-	const uint8_t counter = bt_scan.scan_filters.uuid.cnt;
+	const uint16_t counter = uuid_filter->cnt;
 	uint8_t data_len = data->data_len;
-	uint8_t uuid_match_cnt = 0;
+	uint8_t uuid_len = uuid_len_get(uuid_type);
+	uint16_t uuid_match_cnt = 0;
+	uint32_t matched[DIV_ROUND_UP(CONFIG_BT_SCAN_UUID_CNT, 32)];
 
-	for (size_t i = 0; i < counter; i++) {
+	if (uuid_len == 0) {
+		return false;
+	}
 
-		if (find_uuid(data->data, data_len, uuid_type,
-			      &uuid_filter->uuid[i])) {
-			control->filter_status.uuid.uuid[uuid_match_cnt] =
-				uuid_filter->uuid[i].uuid;
+	memset(matched, 0, sizeof(matched));
 
-			uuid_match_cnt++;
+	/* Look up every advertised UUID. The same UUID can be advertised
+	 * more than once, so the matched filters are marked.
+	 */
+	for (size_t i = 0; (i + uuid_len) <= data_len; i += uuid_len) {
+		struct bt_uuid_128 uuid;
+		int idx;
 
-			/* In the normal filter mode,
-			 * only one UUID is needed to match.
-			 */
-			if (!all_filters_mode) {
-				break;
-			}
+		if (!bt_uuid_create(&uuid.uuid, &data->data[i], uuid_len)) {
+			break;
+		}
+
+		idx = uuid_filter_find(&uuid.uuid);
+		if ((idx < 0) || (matched[idx / 32] & BIT(idx % 32))) {
+			continue;
+		}
 
-		} else if (all_filters_mode) {
+		matched[idx / 32] |= BIT(idx % 32);
+
+		control->filter_status.uuid.uuid[uuid_match_cnt] =
+			uuid_filter->uuid[idx].uuid;
+
+		uuid_match_cnt++;
+
+		/* In the normal filter mode,
+		 * only one UUID is needed to match.
+		 */
+		if (!all_filters_mode) {
 			break;
 		}
 	}
@@ -864,8 +1034,9 @@ static void uuid_check(struct bt_scan_control *control,
 
 static int scan_uuid_filter_add(struct bt_uuid *uuid)
 {
-	struct bt_scan_uuid *uuid_filter = bt_scan.scan_filters.uuid.uuid;
-	uint8_t counter = bt_scan.scan_filters.uuid.cnt;
+	struct bt_scan_uuid_filter *filter = &bt_scan.scan_filters.uuid;
+	struct bt_scan_uuid *uuid_filter = filter->uuid;
+	uint16_t counter = filter->cnt;
 	struct bt_uuid_16 *uuid_16;
 	struct bt_uuid_32 *uuid_32;
 	struct bt_uuid_128 *uuid_128;
@@ -876,10 +1047,8 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 	}
 
 	/* Check for duplicated filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_uuid_cmp(uuid_filter[i].uuid, uuid) == 0) {
-			return 0;
-		}
+	if (uuid_filter_find(uuid) >= 0) {
+		return 0;
 	}
 
 	/* Add UUID to the filter. */
@@ -912,7 +1081,10 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		return -EINVAL;
 	}
 
-	bt_scan.scan_filters.uuid.cnt++;
+	filter_hash_insert(filter->hash, ARRAY_SIZE(filter->hash),
+			   uuid_hash(uuid), counter);
+
+	filter->cnt++;
 	LOG_DBG("Added filter on UUID type %x", uuid->type);
 
 	return 0;
@@ -1224,10 +1396,12 @@ void bt_scan_filter_remove_all(void)
 	struct bt_scan_addr_filter *addr_filter =
 			&bt_scan.scan_filters.addr;
 	addr_filter->cnt = 0;
+	memset(addr_filter->hash, 0, sizeof(addr_filter->hash));
 
 	struct bt_scan_uuid_filter *uuid_filter =
 			&bt_scan.scan_filters.uuid;
 	uuid_filter->cnt = 0;
+	memset(uuid_filter->hash, 0, sizeof(uuid_filter->hash));
 
 	struct bt_scan_appearance_filter *appearance_filter =
 			&bt_scan.scan_filters.appearance;
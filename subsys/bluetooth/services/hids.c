@@ -52,6 +52,30 @@
 
 LOG_MODULE_REGISTER(bt_hids, CONFIG_BT_HIDS_LOG_LEVEL);
 
+/* The connection context data is written by the functions that send input
+ * reports and by the GATT callbacks. The context library does not serialize
+ * access to it, so the data is accessed with the library mutex taken.
+ */
+static struct bt_hids_conn_data *conn_data_get(struct bt_hids *hids_obj,
+					       struct bt_conn *conn)
+{
+	struct bt_hids_conn_data *conn_data =
+		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+
+	if (conn_data) {
+		k_mutex_lock(hids_obj->conn_ctx->mutex, K_FOREVER);
+	}
+
+	return conn_data;
+}
+
+static void conn_data_release(struct bt_hids *hids_obj,
+			      struct bt_hids_conn_data *conn_data)
+{
+	k_mutex_unlock(hids_obj->conn_ctx->mutex);
+	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+}
+
 int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
@@ -66,6 +90,8 @@ int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 		return -ENOMEM;
 	}
 
+	k_mutex_lock(hids_obj->conn_ctx->mutex, K_FOREVER);
+
 	memset(conn_data, 0, bt_conn_ctx_block_size_get(hids_obj->conn_ctx));
 
 	conn_data->pm_ctx_value = BT_HIDS_PM_REPORT;
@@ -90,7 +116,7 @@ int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 		    hids_obj->outp_rep_group.reports[i].size;
 	}
 
-	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+	conn_data_release(hids_obj, conn_data);
 
 	return 0;
 }
@@ -124,7 +150,7 @@ static ssize_t hids_protocol_mode_write(struct bt_conn *conn,
 	uint8_t const *new_pm = (uint8_t const *)buf;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -134,6 +160,7 @@ static ssize_t hids_protocol_mode_write(struct bt_conn *conn,
 	uint8_t *cur_pm = &conn_data->pm_ctx_value;
 
 	if (offset + len > sizeof(uint8_t)) {
+		conn_data_release(hids, conn_data);
 		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
 	}
 
@@ -151,12 +178,13 @@ static ssize_t hids_protocol_mode_write(struct bt_conn *conn,
 		}
 		break;
 	default:
+		conn_data_release(hids, conn_data);
 		return BT_GATT_ERR(BT_ATT_ERR_NOT_SUPPORTED);
 	}
 
 	memcpy(cur_pm + offset, new_pm, len);
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return len;
 }
@@ -172,7 +200,7 @@ static ssize_t hids_protocol_mode_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -184,7 +212,7 @@ static ssize_t hids_protocol_mode_read(struct bt_conn *conn,
 	ret_len = bt_gatt_attr_read(conn, attr, buf, len, offset, protocol_mode,
 				    sizeof(*protocol_mode));
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -216,7 +244,7 @@ static ssize_t hids_inp_rep_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -228,7 +256,7 @@ static ssize_t hids_inp_rep_read(struct bt_conn *conn,
 	ret_len = bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 				    rep->size);
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -263,7 +291,7 @@ static ssize_t hids_outp_rep_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -283,7 +311,7 @@ static ssize_t hids_outp_rep_read(struct bt_conn *conn,
 		rep->handler(&report, conn, false);
 	}
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -303,7 +331,7 @@ static ssize_t hids_outp_rep_write(struct bt_conn *conn,
 	uint8_t *rep_data;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -313,6 +341,7 @@ static ssize_t hids_outp_rep_write(struct bt_conn *conn,
 	rep_data = conn_data->outp_rep_ctx + rep->offset;
 
 	if (offset + len > rep->size) {
+		conn_data_release(hids, conn_data);
 		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
 	}
 	memcpy(rep_data + offset, buf, len);
@@ -325,7 +354,7 @@ static ssize_t hids_outp_rep_write(struct bt_conn *conn,
 		rep->handler(&report, conn, true);
 	}
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return len;
 }
@@ -360,7 +389,7 @@ static ssize_t hids_feat_rep_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -380,7 +409,7 @@ static ssize_t hids_feat_rep_read(struct bt_conn *conn,
 		rep->handler(&report, conn, false);
 	}
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -406,7 +435,7 @@ static ssize_t hids_feat_rep_write(struct bt_conn *conn,
 	uint8_t *rep_data;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -416,6 +445,7 @@ static ssize_t hids_feat_rep_write(struct bt_conn *conn,
 	rep_data = conn_data->feat_rep_ctx + rep->offset;
 
 	if (offset + len > rep->size) {
+		conn_data_release(hids, conn_data);
 		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
 	}
 	memcpy(rep_data + offset, buf, len);
@@ -428,7 +458,7 @@ static ssize_t hids_feat_rep_write(struct bt_conn *conn,
 		rep->handler(&report, conn, true);
 	}
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return len;
 }
@@ -484,7 +514,7 @@ static ssize_t hids_boot_mouse_inp_report_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -497,7 +527,7 @@ static ssize_t hids_boot_mouse_inp_report_read(struct bt_conn *conn,
 	ret_len =
 	    bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 			      sizeof(conn_data->hids_boot_mouse_inp_rep_ctx));
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -540,7 +570,7 @@ static ssize_t hids_boot_kb_inp_report_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -552,7 +582,7 @@ static ssize_t hids_boot_kb_inp_report_read(struct bt_conn *conn,
 	ret_len =
 	    bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 			      sizeof(conn_data->hids_boot_kb_inp_rep_ctx));
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -597,7 +627,7 @@ static ssize_t hids_boot_kb_outp_report_read(struct bt_conn *conn,
 	ssize_t ret_len;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -617,7 +647,7 @@ static ssize_t hids_boot_kb_outp_report_read(struct bt_conn *conn,
 		rep->handler(&report, conn, false);
 	}
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return ret_len;
 }
@@ -635,7 +665,7 @@ static ssize_t hids_boot_kb_outp_report_write(struct bt_conn *conn,
 	uint8_t *rep_data;
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids->conn_ctx, conn);
+		conn_data_get(hids, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -645,6 +675,7 @@ static ssize_t hids_boot_kb_outp_report_write(struct bt_conn *conn,
 	rep_data = conn_data->hids_boot_kb_outp_rep_ctx;
 
 	if (offset + len > sizeof(uint8_t)) {
+		conn_data_release(hids, conn_data);
 		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
 	}
 	memcpy(rep_data + offset, buf, len);
@@ -658,7 +689,7 @@ static ssize_t hids_boot_kb_outp_report_write(struct bt_conn *conn,
 		rep->handler(&report, conn, true);
 	}
 
-	bt_conn_ctx_release(hids->conn_ctx, (void *)conn_data);
+	conn_data_release(hids, conn_data);
 
 	return len;
 }
@@ -1034,6 +1065,8 @@ static int inp_rep_notify_all(struct bt_hids *hids_obj,
 	const size_t contexts =
 	    bt_conn_ctx_count(hids_obj->conn_ctx);
 
+	k_mutex_lock(hids_obj->conn_ctx->mutex, K_FOREVER);
+
 	for (size_t i = 0; i < contexts; i++) {
 		const struct bt_conn_ctx *ctx =
 			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
@@ -1056,6 +1089,8 @@ static int inp_rep_notify_all(struct bt_hids *hids_obj,
 		}
 	}
 
+	k_mutex_unlock(hids_obj->conn_ctx->mutex);
+
 	if (rep_data != NULL) {
 		struct bt_gatt_notify_params params = {0};
 
@@ -1094,7 +1129,7 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 	}
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+		conn_data_get(hids_obj, conn);
 
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
@@ -1114,7 +1149,7 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 
 	int err = bt_gatt_notify_cb(conn, &params);
 
-	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+	conn_data_release(hids_obj, conn_data);
 
 	return err;
 }
@@ -1135,6 +1170,8 @@ static int boot_mouse_inp_report_notify_all(
 
 	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
 
+	k_mutex_lock(hids_obj->conn_ctx->mutex, K_FOREVER);
+
 	for (size_t i = 0; i < contexts; i++) {
 		const struct bt_conn_ctx *ctx =
 			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
@@ -1163,6 +1200,8 @@ static int boot_mouse_inp_report_notify_all(
 		}
 	}
 
+	k_mutex_unlock(hids_obj->conn_ctx->mutex);
+
 	if (rep_data != NULL) {
 		struct bt_gatt_notify_params params = {0};
 
@@ -1200,7 +1239,7 @@ int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
 	}
 
 	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+		conn_data_get(hids_obj, conn);
 
 	BUILD_ASSERT(sizeof(conn_data->hids_boot_mouse_inp_rep_ctx) >= 3,
 			 "buffer is too short");
@@ -1231,7 +1270,7 @@ int bt_hids_boot_mouse_inp_rep_send(struct bt_hids *hids_obj,
 	rep_data[1] = 0;
 	rep_data[2] = 0;
 
-	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+	conn_data_release(hids_obj, conn_data);
 
 	return err;
 }
@@ -1246,9 +1285,18 @@ boot_kb_inp_notify_all(struct bt_hids *hids_obj, uint8_t const *rep,
 	uint8_t rep_ind = hids_obj->boot_kb_inp_rep.att_ind;
 	struct bt_gatt_attr *rep_attr = &hids_obj->gp.svc.attrs[rep_ind];
 	uint8_t *rep_data = NULL;
+	uint8_t rep_buff[BT_HIDS_BOOT_KB_INPUT_REP_LEN] = {0};
+
+	if (len > sizeof(rep_buff)) {
+		return -EINVAL;
+	}
+
+	memcpy(rep_buff, rep, len);
 
 	const size_t contexts = bt_conn_ctx_count(hids_obj->conn_ctx);
 
+	k_mutex_lock(hids_obj->conn_ctx->mutex, K_FOREVER);
+
 	for (size_t i = 0; i < contexts; i++) {
 		const struct bt_conn_ctx *ctx =
 		    bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
@@ -1261,9 +1309,7 @@ boot_kb_inp_notify_all(struct bt_hids *hids_obj, uint8_t const *rep,
 				conn_data = ctx->data;
 				rep_data = conn_data->hids_boot_kb_inp_rep_ctx;
 
-				memcpy(rep_data, rep, len);
-				memset(&rep_data[len], 0,
-				       (BT_HIDS_BOOT_KB_INPUT_REP_LEN - len));
+				memcpy(rep_data, rep_buff, sizeof(rep_buff));
 			}
 
 			bt_conn_ctx_release(hids_obj->conn_ctx,
@@ -1271,12 +1317,14 @@ boot_kb_inp_notify_all(struct bt_hids *hids_obj, uint8_t const *rep,
 		}
 	}
 
+	k_mutex_unlock(hids_obj->conn_ctx->mutex);
+
 	if (rep_data != NULL) {
 		struct bt_gatt_notify_params params = {0};
 
 		params.attr = rep_attr;
-		params.data = rep_data;
-		params.len = sizeof(conn_data->hids_boot_kb_inp_rep_ctx);
+		params.data = rep_buff;
+		params.len = sizeof(rep_buff);
 		params.func = cb;
 
 		return bt_gatt_notify_cb(NULL, &params);
@@ -1304,13 +1352,14 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 		return -EACCES;
 	}
 
-	struct bt_hids_conn_data *conn_data =
-		bt_conn_ctx_get(hids_obj->conn_ctx, conn);
+	struct bt_hids_conn_data *conn_data;
 
 	if (len > sizeof(conn_data->hids_boot_kb_inp_rep_ctx)) {
 		return -EINVAL;
 	}
 
+	conn_data = conn_data_get(hids_obj, conn);
+
 	if (!conn_data) {
 		LOG_WRN("The context was not found");
 		return -EINVAL;
@@ -1331,7 +1380,7 @@ int bt_hids_boot_kb_inp_rep_send(struct bt_hids *hids_obj,
 
 	int err = bt_gatt_notify_cb(conn, &params);
 
-	bt_conn_ctx_release(hids_obj->conn_ctx, (void *)conn_data);
+	conn_data_release(hids_obj, conn_data);
 
 	return err;
 }
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
  */
 #include <kernel.h>
+#include <bluetooth/bluetooth.h>
 #include <bluetooth/conn.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt.h>
@@ -13,6 +14,11 @@
 #include <logging/log.h>
 #include <sys/byteorder.h>
 
+#if CONFIG_BT_HOGP_CACHE
+#include "hogp_cache.h"
+#include "../gatt_peer_cache.h"
+#endif
+
 LOG_MODULE_REGISTER(hogp, CONFIG_BT_HOGP_LOG_LEVEL);
 
 /* Real report structure definition */
@@ -45,6 +51,18 @@ struct bt_hogp_rep_info {
 	uint8_t size; /**< The size of the value */
 };
 
+#if CONFIG_BT_HOGP_CACHE
+/* Service layout of the connected peer */
+struct bt_hogp_cache {
+	/** Layout, as stored in settings */
+	struct hogp_cache_layout layout;
+	/** Number of report map bytes received, while it is not cached */
+	uint16_t map_rcvd;
+	/** The layout matches the stored one */
+	bool stored;
+};
+#endif /* CONFIG_BT_HOGP_CACHE */
+
 /* Memory slab used for reports */
 K_MEM_SLAB_DEFINE(bt_hogp_reports_mem,
 		  sizeof(struct bt_hogp_rep_info),
@@ -239,6 +257,143 @@ static uint16_t chrc_value_handle_by_uuid(struct bt_gatt_dm *dm,
 	return gatt_desc->handle;
 }
 
+#if CONFIG_BT_HOGP_CACHE
+/**
+ * @brief Store the service layout
+ *
+ * Stores the layout read from a bonded peer, together with
+ * the Database Hash read before.
+ *
+ * @param hogp HOGP object.
+ */
+static void cache_store(struct bt_hogp *hogp)
+{
+	struct hogp_cache_layout *layout = &hogp->cache->layout;
+	int err;
+
+	layout->info = hogp->info_val;
+	layout->rep_count = hogp->rep_count;
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		layout->rep[i].val  = hogp->rep_info[i]->handlers.val;
+		layout->rep[i].id   = hogp->rep_info[i]->ref.id;
+		layout->rep[i].type = hogp->rep_info[i]->ref.type;
+	}
+
+	err = hogp_cache_save(bt_conn_get_dst(hogp->conn), layout);
+	if (err) {
+		LOG_WRN("Cannot store service layout (err: %d)", err);
+		return;
+	}
+
+	hogp->cache->stored = true;
+}
+
+/**
+ * @brief Apply the cached service layout
+ *
+ * The layout is only applied if it describes the discovered reports.
+ *
+ * @param hogp HOGP object.
+ *
+ * @return 0 or negative error value.
+ */
+static int cache_apply(struct bt_hogp *hogp)
+{
+	const struct hogp_cache_layout *layout = &hogp->cache->layout;
+
+	if (layout->rep_count != hogp->rep_count) {
+		return -EINVAL;
+	}
+
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		const struct bt_hogp_rep_info *rep = hogp->rep_info[i];
+
+		if ((layout->rep[i].val != rep->handlers.val) ||
+		    (layout->rep[i].type != rep->ref.type)) {
+			return -EINVAL;
+		}
+	}
+
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		hogp->rep_info[i]->ref.id = layout->rep[i].id;
+	}
+	hogp->info_val = layout->info;
+
+	return 0;
+}
+
+/**
+ * @brief Capture a report map chunk
+ *
+ * Chunks are captured in order. A chunk that is shorter than the
+ * maximum read response ends the report map, which is then stored.
+ *
+ * @param hogp   HOGP object.
+ * @param data   Chunk data.
+ * @param length Chunk size.
+ * @param offset Chunk offset.
+ */
+static void cache_map_process(struct bt_hogp *hogp, const uint8_t *data,
+			      uint16_t length, size_t offset)
+{
+	struct bt_hogp_cache *cache = hogp->cache;
+	struct hogp_cache_layout *layout = &cache->layout;
+	int err;
+
+	if (layout->map_len || (offset != cache->map_rcvd)) {
+		return;
+	}
+	if (length > sizeof(layout->map) - cache->map_rcvd) {
+		LOG_DBG("Report map too big to be cached");
+		return;
+	}
+
+	memcpy(&layout->map[cache->map_rcvd], data, length);
+	cache->map_rcvd += length;
+
+	if ((length >= bt_gatt_get_mtu(hogp->conn) - 1) || !cache->stored) {
+		return;
+	}
+
+	layout->map_len = cache->map_rcvd;
+	err = hogp_cache_save(bt_conn_get_dst(hogp->conn), layout);
+	if (err) {
+		LOG_WRN("Cannot store report map (err: %d)", err);
+	}
+}
+
+/**
+ * @brief Read the report map from the cache
+ *
+ * The report map is returned in chunks of the size the server would use,
+ * so that the map callback sees the same sequence as on a remote read.
+ * Read semaphore should be already taken in @ref bt_hogp_map_read.
+ *
+ * @param hogp   HOGP object.
+ * @param func   Map callback.
+ * @param offset Chunk offset.
+ */
+static void cache_map_read(struct bt_hogp *hogp, bt_hogp_map_cb func,
+			   size_t offset)
+{
+	const struct hogp_cache_layout *layout = &hogp->cache->layout;
+	const uint8_t *data = NULL;
+	size_t size = 0;
+	uint8_t err = 0;
+
+	if (offset > layout->map_len) {
+		err = BT_ATT_ERR_INVALID_OFFSET;
+	} else {
+		data = &layout->map[offset];
+		size = MIN(layout->map_len - offset,
+			   bt_gatt_get_mtu(hogp->conn) - 1);
+	}
+
+	k_sem_give(&hogp->read_params_sem);
+	func(hogp, err, data, size, offset);
+}
+#endif /* CONFIG_BT_HOGP_CACHE */
+
 /**
  * @brief Mark hids ready to work
  *
@@ -249,6 +404,11 @@ static uint16_t chrc_value_handle_by_uuid(struct bt_gatt_dm *dm,
  */
 static void hids_mark_ready(struct bt_hogp *hogp)
 {
+#if CONFIG_BT_HOGP_CACHE
+	if (hogp->cache && !hogp->cache->stored) {
+		cache_store(hogp);
+	}
+#endif
 	k_sem_give(&hogp->read_params_sem);
 	hogp->ready = true;
 	if (hogp->ready_cb) {
@@ -538,6 +698,104 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 	return BT_GATT_ITER_STOP;
 }
 
+#if CONFIG_BT_HOGP_CACHE
+/**
+ * @brief Process Database Hash read
+ *
+ * If the layout stored for the peer has the same Database Hash, it is
+ * applied and the reads of the HID information and the report references
+ * are skipped. Otherwise, the layout is read and stored.
+ *
+ * @param conn   Connection handler.
+ * @param err    Read ATT error code.
+ * @param params Notification parameters structure - the pointer
+ *               to the structure provided to read function.
+ * @param data   Pointer to the data buffer.
+ * @param length The size of the received data.
+ *
+ * @retval BT_GATT_ITER_STOP     Stop notification
+ * @retval BT_GATT_ITER_CONTINUE Continue notification
+ */
+static uint8_t cache_hash_read_process(struct bt_conn *conn, uint8_t err,
+				       struct bt_gatt_read_params *params,
+				       const void *data, uint16_t length)
+{
+	struct bt_hogp *hogp;
+	struct bt_hogp_cache *cache;
+	int ret;
+
+	hogp = CONTAINER_OF(params, struct bt_hogp, read_params);
+	cache = hogp->cache;
+
+	if (err || !data || (length != HOGP_CACHE_DB_HASH_LEN)) {
+		LOG_DBG("No Database Hash (err: %u)", err);
+		k_free(cache);
+		hogp->cache = NULL;
+	} else if (!hogp_cache_load(bt_conn_get_dst(conn), data,
+				    &cache->layout) &&
+		   !cache_apply(hogp)) {
+		LOG_DBG("Service layout restored from cache");
+		cache->stored = true;
+
+		/* Protocol Mode is state, not layout - always read it */
+		ret = pm_read_start(hogp);
+		if (ret) {
+			hids_prep_error(hogp, ret);
+		}
+		return BT_GATT_ITER_STOP;
+	} else {
+		memset(&cache->layout, 0, sizeof(cache->layout));
+		memcpy(cache->layout.db_hash, data, length);
+	}
+
+	ret = hid_info_read_start(hogp);
+	if (ret) {
+		hids_prep_error(hogp, ret);
+	}
+
+	return BT_GATT_ITER_STOP;
+}
+
+/**
+ * @brief Start Database Hash read
+ *
+ * The Database Hash is read only from bonded peers, as only their
+ * layout is stored.
+ * Read semaphore should be already taken in @ref post_discovery_start.
+ *
+ * @param hogp  See @ref bt_hogp_handles_assign.
+ *
+ * @return 0 or negative error value.
+ */
+static int cache_read_start(struct bt_hogp *hogp)
+{
+	int err;
+
+	if (!gatt_peer_cache_bonded(hogp->conn)) {
+		return -ENOENT;
+	}
+
+	hogp->cache = k_malloc(sizeof(*hogp->cache));
+	if (!hogp->cache) {
+		LOG_WRN("No memory for the service layout cache");
+		return -ENOMEM;
+	}
+	hogp->cache->map_rcvd = 0;
+	hogp->cache->stored = false;
+
+	LOG_DBG("Database Hash read start");
+	err = gatt_peer_cache_hash_read(hogp->conn, &(hogp->read_params),
+					cache_hash_read_process);
+	if (err) {
+		LOG_WRN("Database Hash read error (err: %d)", err);
+		k_free(hogp->cache);
+		hogp->cache = NULL;
+		return err;
+	}
+	return 0;
+}
+#endif /* CONFIG_BT_HOGP_CACHE */
+
 /**
  * @brief Start anything that should be started after discovery
  *
@@ -559,6 +817,12 @@ static int post_discovery_start(struct bt_hogp *hogp)
 		return err;
 	}
 
+#if CONFIG_BT_HOGP_CACHE
+	if (!cache_read_start(hogp)) {
+		return 0;
+	}
+#endif
+
 	err = hid_info_read_start(hogp);
 	if (err) {
 		k_sem_give(&hogp->read_params_sem);
@@ -797,6 +1061,10 @@ void bt_hogp_release(struct bt_hogp *hogp)
 	if (hogp->rep_boot.mouse_inp) {
 		rep_free(&(hogp->rep_boot.mouse_inp));
 	}
+#if CONFIG_BT_HOGP_CACHE
+	k_free(hogp->cache);
+	hogp->cache = NULL;
+#endif
 	LOG_DBG("Report memory released, entities used: %u",
 		k_mem_slab_num_used_get(&bt_hogp_reports_mem));
 
@@ -813,6 +1081,13 @@ void bt_hogp_abort_all(struct bt_hogp *hogp)
 	k_sem_give(&hogp->read_params_sem);
 }
 
+#if CONFIG_BT_HOGP_CACHE
+int bt_hogp_cache_delete(const bt_addr_le_t *addr)
+{
+	return hogp_cache_delete(addr);
+}
+#endif
+
 bool bt_hogp_assign_check(const struct bt_hogp *hogp)
 {
 	return hogp->conn != NULL;
@@ -1108,6 +1383,11 @@ static uint8_t map_read_process(struct bt_conn *conn, uint8_t err,
 	}
 
 	offset = hogp->read_params.single.offset;
+#if CONFIG_BT_HOGP_CACHE
+	if (hogp->cache && !err) {
+		cache_map_process(hogp, data, length, offset);
+	}
+#endif
 	k_sem_give(&hogp->read_params_sem);
 	hogp->map_cb(hogp, err, data, length, offset);
 	return BT_GATT_ITER_STOP;
@@ -1128,6 +1408,12 @@ int bt_hogp_map_read(struct bt_hogp *hogp,
 	if (err) {
 		return err;
 	}
+#if CONFIG_BT_HOGP_CACHE
+	if (hogp->cache && hogp->cache->layout.map_len) {
+		cache_map_read(hogp, func, offset);
+		return 0;
+	}
+#endif
 	hogp->map_cb = func;
 	hogp->read_params.func = map_read_process;
 	hogp->read_params.handle_count  = 1;
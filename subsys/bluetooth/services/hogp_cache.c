@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <kernel.h>
+#include <string.h>
+#include <sys/printk.h>
+#include <settings/settings.h>
+
+#include "hogp_cache.h"
+
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(hogp, CONFIG_BT_HOGP_LOG_LEVEL);
+
+#define SETTINGS_NAME "bt/hogp"
+/* "bt/hogp/" followed by the address and its type in hex */
+#define SETTINGS_KEY_SIZE (sizeof(SETTINGS_NAME "/") + (2 * BT_ADDR_SIZE) + 2)
+#define SETTINGS_NAME_LEN (sizeof(SETTINGS_NAME "/") - 1)
+
+/* Layout requested by hogp_cache_load(), filled by the settings handler */
+static struct {
+	const char *name;
+	struct hogp_cache_layout *layout;
+	int err;
+} load_ctx;
+
+static K_MUTEX_DEFINE(load_lock);
+
+static void key_encode(char key[SETTINGS_KEY_SIZE], const bt_addr_le_t *addr)
+{
+	const uint8_t *a = addr->a.val;
+
+	snprintk(key, SETTINGS_KEY_SIZE,
+		 SETTINGS_NAME "/%02x%02x%02x%02x%02x%02x%02x",
+		 a[5], a[4], a[3], a[2], a[1], a[0], addr->type);
+}
+
+static int settings_set(const char *name, size_t len, settings_read_cb read_cb,
+			void *cb_arg)
+{
+	struct hogp_cache_layout *layout = load_ctx.layout;
+	const char *next;
+	ssize_t rc;
+
+	if ((len < offsetof(struct hogp_cache_layout, map)) ||
+	    (len > sizeof(struct hogp_cache_layout))) {
+		LOG_WRN("Invalid cached layout size: %zu", len);
+		return -EINVAL;
+	}
+
+	/* Layouts are only read for the peer that is being loaded */
+	if (!layout || !settings_name_steq(name, load_ctx.name, &next) ||
+	    next) {
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, layout, len);
+	if (rc != len) {
+		load_ctx.err = (rc < 0) ? rc : -EIO;
+		return load_ctx.err;
+	}
+
+	if ((layout->rep_count > ARRAY_SIZE(layout->rep)) ||
+	    (hogp_cache_layout_size(layout) != len)) {
+		LOG_WRN("Corrupted cached layout");
+		load_ctx.err = -EINVAL;
+		return load_ctx.err;
+	}
+
+	load_ctx.err = 0;
+
+	return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(bt_hogp, SETTINGS_NAME, NULL, settings_set,
+			       NULL, NULL);
+
+int hogp_cache_save(const bt_addr_le_t *addr,
+		    const struct hogp_cache_layout *layout)
+{
+	char key[SETTINGS_KEY_SIZE];
+
+	key_encode(key, addr);
+
+	return settings_save_one(key, layout, hogp_cache_layout_size(layout));
+}
+
+int hogp_cache_load(const bt_addr_le_t *addr, const uint8_t *db_hash,
+		    struct hogp_cache_layout *layout)
+{
+	char key[SETTINGS_KEY_SIZE];
+	int err;
+
+	key_encode(key, addr);
+
+	k_mutex_lock(&load_lock, K_FOREVER);
+
+	load_ctx.name = &key[SETTINGS_NAME_LEN];
+	load_ctx.layout = layout;
+	load_ctx.err = -ENOENT;
+
+	err = settings_load_subtree(key);
+	if (!err && load_ctx.err) {
+		err = -ENOENT;
+	}
+
+	load_ctx.layout = NULL;
+
+	k_mutex_unlock(&load_lock);
+
+	if (err) {
+		return err;
+	}
+
+	/* The peer database changed since the layout was stored */
+	if (memcmp(layout->db_hash, db_hash, sizeof(layout->db_hash))) {
+		LOG_DBG("Database Hash changed");
+		return -ENOENT;
+	}
+
+	return 0;
+}
+
+int hogp_cache_delete(const bt_addr_le_t *addr)
+{
+	char key[SETTINGS_KEY_SIZE];
+
+	key_encode(key, addr);
+
+	return settings_delete(key);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BT_HOGP_CACHE_H_
+#define BT_HOGP_CACHE_H_
+
+/**
+ * @file
+ * @brief Storage of the HID service layout of bonded peers.
+ *
+ * Internal module of the HIDS client.
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <bluetooth/addr.h>
+#include <bluetooth/services/hids.h>
+
+#include "../gatt_peer_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the GATT Database Hash. */
+#define HOGP_CACHE_DB_HASH_LEN GATT_PEER_CACHE_HASH_LEN
+
+/** @brief Cached report. */
+struct hogp_cache_rep {
+	/** Report value handle, used to validate the cached layout. */
+	uint16_t val;
+	/** Report identifier read from the Report Reference. */
+	uint8_t id;
+	/** Report type read from the Report Reference. */
+	uint8_t type;
+};
+
+/** @brief Cached layout of the HID service of a peer.
+ *
+ * Only the used part of the report map is stored.
+ */
+struct hogp_cache_layout {
+	/** Database Hash of the peer when the layout was read. */
+	uint8_t db_hash[HOGP_CACHE_DB_HASH_LEN];
+	/** HID Information. */
+	struct bt_hids_info info;
+	/** Number of reports, excluding boot reports. */
+	uint8_t rep_count;
+	/** Reports, in the order of the report characteristics. */
+	struct hogp_cache_rep rep[CONFIG_BT_HOGP_REPORTS_MAX];
+	/** Length of the report map, 0 if it was not read. */
+	uint16_t map_len;
+	/** Report map. */
+	uint8_t map[CONFIG_BT_HOGP_CACHE_MAP_SIZE];
+};
+
+/** @brief Get the number of used bytes of a layout.
+ *
+ * @param layout Layout.
+ *
+ * @return Number of bytes that are stored.
+ */
+static inline size_t hogp_cache_layout_size(
+	const struct hogp_cache_layout *layout)
+{
+	return offsetof(struct hogp_cache_layout, map) + layout->map_len;
+}
+
+/** @brief Store the layout of a peer.
+ *
+ * @param addr   Peer address.
+ * @param layout Layout to store.
+ *
+ * @return 0 or negative error code.
+ */
+int hogp_cache_save(const bt_addr_le_t *addr,
+		    const struct hogp_cache_layout *layout);
+
+/** @brief Load the layout of a peer.
+ *
+ * The layout is only loaded if it was stored with the given Database Hash.
+ *
+ * @param addr    Peer address.
+ * @param db_hash Current Database Hash of the peer.
+ * @param layout  Loaded layout.
+ *
+ * @retval 0       The layout was loaded.
+ * @retval -ENOENT No valid layout is stored for the peer.
+ */
+int hogp_cache_load(const bt_addr_le_t *addr, const uint8_t *db_hash,
+		    struct hogp_cache_layout *layout);
+
+/** @brief Delete the layout of a peer.
+ *
+ * @param addr Peer address.
+ *
+ * @return 0 or negative error code.
+ */
+int hogp_cache_delete(const bt_addr_le_t *addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BT_HOGP_CACHE_H_ */
@@ -25,6 +25,11 @@ static ssize_t on_receive(struct bt_conn *conn,
 	LOG_DBG("Received data, handle %d, conn %p",
 		attr->handle, conn);
 
+	if (nus_cb.rx_ready && !nus_cb.rx_ready(conn, len)) {
+		LOG_DBG("Not ready to receive data");
+		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
+	}
+
 	if (nus_cb.received) {
 		nus_cb.received(conn, buf, len);
 }
@@ -61,6 +66,7 @@ int bt_nus_init(struct bt_nus_cb *callbacks)
 {
 	if (callbacks) {
 		nus_cb.received = callbacks->received;
+		nus_cb.rx_ready = callbacks->rx_ready;
 		nus_cb.sent = callbacks->sent;
 	}
 
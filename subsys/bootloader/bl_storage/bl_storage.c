@@ -5,6 +5,7 @@
  */
 
 #include "bl_storage.h"
+#include "bl_storage_internal.h"
 #include <string.h>
 #include <errno.h>
 #include <nrf.h>
@@ -250,6 +251,16 @@ uint16_t num_monotonic_counter_slots(void)
 }
 
 
+#ifdef CONFIG_SECURE_BOOT_STORAGE_COUNTER_SHADOW
+/** RAM copy of the counter state, read from the OTP on first use. */
+static struct {
+	bool valid;
+	uint16_t value;
+	uint16_t free_idx;
+} counter_shadow;
+#endif
+
+
 /** Function for getting the current value and the first free slot.
  *
  * @param[out]  free_slot  Pointer to the first free slot. Can be NULL.
@@ -259,26 +270,40 @@ uint16_t num_monotonic_counter_slots(void)
  */
 static uint16_t get_counter(const uint16_t **free_slot)
 {
-	uint16_t highest_counter = 0;
-	const uint16_t *addr = NULL;
-	const uint16_t *slots =
-			get_counter_struct(COUNTER_DESC_VERSION)->counter_slots;
+	const struct monotonic_counter *counter
+			= get_counter_struct(COUNTER_DESC_VERSION);
 	uint16_t num_slots = num_monotonic_counter_slots();
+	uint16_t highest_counter;
+	uint16_t free_idx;
 
-	for (uint32_t i = 0; i < num_slots; i++) {
-		uint16_t counter = ~read_halfword(&slots[i]);
-
-		if (counter == 0) {
-			addr = &slots[i];
-			break;
-		}
-		if (highest_counter < counter) {
-			highest_counter = counter;
+	if (counter == NULL) {
+		if (free_slot != NULL) {
+			*free_slot = NULL;
 		}
+		return 0;
 	}
 
+#ifdef CONFIG_SECURE_BOOT_STORAGE_COUNTER_SHADOW
+	if (!counter_shadow.valid) {
+		/* Read every slot once, so that the shadow matches what a
+		 * full scan finds even if the slots are not in order.
+		 */
+		counter_shadow.value = counter_scan(counter->counter_slots,
+						    num_slots, read_halfword,
+						    &counter_shadow.free_idx);
+		counter_shadow.valid = true;
+	}
+
+	highest_counter = counter_shadow.value;
+	free_idx = counter_shadow.free_idx;
+#else
+	highest_counter = counter_find(counter->counter_slots, num_slots,
+				       read_halfword, &free_idx);
+#endif
+
 	if (free_slot != NULL) {
-		*free_slot = addr;
+		*free_slot = (free_idx < num_slots) ?
+			&counter->counter_slots[free_idx] : NULL;
 	}
 	return highest_counter;
 }
@@ -306,5 +331,17 @@ int set_monotonic_counter(uint16_t new_counter)
 	}
 
 	write_halfword(next_counter_addr, ~new_counter);
+
+#ifdef CONFIG_SECURE_BOOT_STORAGE_COUNTER_SHADOW
+	/* Read the slot back, so that the shadow holds what was written. */
+	uint16_t written = counter_slot_value(read_halfword, next_counter_addr);
+
+	if (written != 0) {
+		counter_shadow.free_idx++;
+	}
+	if (counter_shadow.value < written) {
+		counter_shadow.value = written;
+	}
+#endif
 	return 0;
 }
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef BL_STORAGE_INTERNAL_H__
+#define BL_STORAGE_INTERNAL_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <zephyr/types.h>
+#include <stdbool.h>
+
+/** Function for reading one counter slot. */
+typedef uint16_t (*counter_slot_read_t)(const uint16_t *slot);
+
+/** Counter values are stored with their bits flipped, so a free slot reads
+ *  as 0.
+ */
+static inline uint16_t counter_slot_value(counter_slot_read_t read,
+					 const uint16_t *slot)
+{
+	return ~read(slot);
+}
+
+/** Function for getting the current value and the first free slot by reading
+ *  every slot up to the first free one.
+ *
+ * @param[in]  slots      The counter slots.
+ * @param[in]  num_slots  Number of slots.
+ * @param[in]  read       Function for reading a slot.
+ * @param[out] free_idx   Index of the first free slot, or @p num_slots if all
+ *                        slots are written.
+ *
+ * @return The highest value before the first free slot.
+ */
+static inline uint16_t counter_scan(const uint16_t *slots,
+				    uint16_t num_slots,
+				    counter_slot_read_t read,
+				    uint16_t *free_idx)
+{
+	uint16_t highest_counter = 0;
+	uint16_t i;
+
+	for (i = 0; i < num_slots; i++) {
+		uint16_t counter = counter_slot_value(read, &slots[i]);
+
+		if (counter == 0) {
+			break;
+		}
+		if (highest_counter < counter) {
+			highest_counter = counter;
+		}
+	}
+
+	*free_idx = i;
+	return highest_counter;
+}
+
+/** Function for getting the current value and the first free slot with a
+ *  binary search.
+ *
+ * @details Slots are written in increasing order, and each new value is
+ *          larger than all the previous ones, so the written slots come first
+ *          and the last one holds the highest value. If the last write was
+ *          interrupted, the last slot may hold a smaller value than the one
+ *          before it. In that case, the written slots are scanned to find the
+ *          highest value.
+ *
+ *          The result is the same as from @ref counter_scan as long as the
+ *          slots were written in order by @ref set_monotonic_counter, and
+ *          no two consecutive writes were interrupted.
+ *
+ * @param[in]  slots      The counter slots.
+ * @param[in]  num_slots  Number of slots.
+ * @param[in]  read       Function for reading a slot.
+ * @param[out] free_idx   Index of the first free slot, or @p num_slots if all
+ *                        slots are written.
+ *
+ * @return The highest value before the first free slot.
+ */
+static inline uint16_t counter_find(const uint16_t *slots,
+				    uint16_t num_slots,
+				    counter_slot_read_t read,
+				    uint16_t *free_idx)
+{
+	uint16_t low = 0;
+	uint16_t high = num_slots;
+	uint16_t last;
+	uint16_t prev;
+
+	while (low < high) {
+		uint16_t mid = low + (high - low) / 2;
+
+		if (counter_slot_value(read, &slots[mid]) == 0) {
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	*free_idx = low;
+
+	if (low == 0) {
+		return 0;
+	}
+
+	last = counter_slot_value(read, &slots[low - 1]);
+	if (low == 1) {
+		return last;
+	}
+
+	prev = counter_slot_value(read, &slots[low - 2]);
+	if (prev < last) {
+		return last;
+	}
+
+	return counter_scan(slots, low, read, free_idx);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,6 +5,7 @@
  */
 #include <debug/cpu_load.h>
 #include <shell/shell.h>
+#include <stdlib.h>
 #ifdef DPPI_PRESENT
 #include <nrfx_dppi.h>
 #else
@@ -198,6 +199,10 @@ int cpu_load_init(void)
 
 	cpu_load_reset();
 
+	if (IS_ENABLED(CONFIG_CPU_LOAD_THREADS)) {
+		cpu_load_threads_reset();
+	}
+
 	if (IS_ENABLED(CONFIG_CPU_LOAD_LOG_PERIODIC)) {
 		ret = cpu_load_log_init();
 	}
@@ -282,12 +287,58 @@ static int cmd_cpu_load_reset(const struct shell *shell,
 	return 0;
 }
 
+#if defined(CONFIG_CPU_LOAD_THREADS)
+static int cmd_cpu_load_threads(const struct shell *shell, size_t argc,
+				char **argv)
+{
+	struct cpu_load_ctx_stat stats[CONFIG_CPU_LOAD_THREADS_MAX + 1];
+	size_t max_count = ARRAY_SIZE(stats);
+	size_t count;
+
+	if (!ready) {
+		shell_error(shell, "Not initialized.");
+		return 0;
+	}
+
+	if (argc > 1) {
+		max_count = MIN(max_count, strtoul(argv[1], NULL, 10));
+	}
+
+	count = cpu_load_threads_get(stats, max_count);
+
+	for (size_t i = 0; i < count; i++) {
+		const struct cpu_load_ctx_stat *stat = &stats[i];
+		uint32_t percent = stat->load / 1000;
+		uint32_t fraction = stat->load % 1000;
+
+		if (stat->type == CPU_LOAD_CTX_THREAD) {
+			const char *name = k_thread_name_get(
+				(k_tid_t)stat->thread);
+
+			shell_print(shell, "%3d,%03d%% thread %p %s", percent,
+				    fraction, stat->thread, name ? name : "");
+		} else if (stat->type == CPU_LOAD_CTX_ISR) {
+			shell_print(shell, "%3d,%03d%% isr %d", percent,
+				    fraction, stat->irq);
+		} else {
+			shell_print(shell, "%3d,%03d%% other", percent,
+				    fraction);
+		}
+	}
+
+	return 0;
+}
+#endif /* CONFIG_CPU_LOAD_THREADS */
+
 SHELL_STATIC_SUBCMD_SET_CREATE(sub_cmd_cpu_load,
 	SHELL_CMD_ARG(get, NULL, "Get load", cmd_cpu_load_get, 1, 0),
 	SHELL_CMD_ARG(reset, NULL, "Reset measurement",
 			cmd_cpu_load_reset, 1, 0),
 	SHELL_CMD_ARG(init, NULL, "Init",
 			cmd_cpu_load_reset, 1, 0),
+	SHELL_COND_CMD_ARG(CONFIG_CPU_LOAD_THREADS, threads, NULL,
+			"Print threads and ISRs with highest load [count]",
+			cmd_cpu_load_threads, 1, 1),
 	SHELL_SUBCMD_SET_END
 );
 
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <zephyr.h>
+#include <debug/cpu_load.h>
+#include <tracing_user.h>
+#ifdef CONFIG_CPU_CORTEX_M
+#include <arch/arm/aarch32/cortex_m/cmsis.h>
+#endif
+
+#define SLOT_COUNT CONFIG_CPU_LOAD_THREADS_MAX
+#define SLICE_COUNT CONFIG_CPU_LOAD_THREADS_WINDOW_SLICES
+/* Slot charged when all slots are in use. */
+#define SLOT_OTHER SLOT_COUNT
+/* Maximum depth of nested interrupts. */
+#define NESTING_MAX 8
+
+struct slot {
+	/* Thread, or interrupt number for an ISR slot. */
+	uintptr_t id;
+	enum cpu_load_ctx_type type;
+	/* Cycles spent in each slice of the window. */
+	uint32_t cycles[SLICE_COUNT];
+};
+
+/* One additional slot for the contexts that do not fit in the table. */
+static struct slot slots[SLOT_COUNT + 1];
+/* Slot of the context running now. */
+static uint8_t current;
+/* Slots of the contexts interrupted by the ISRs running now. */
+static uint8_t interrupted[NESTING_MAX];
+static uint8_t nesting;
+
+static uint32_t stamp;
+static uint32_t slice_start;
+static uint32_t slice_cycles;
+static uint8_t slice;
+static bool ready;
+
+static uint32_t slot_cycles(const struct slot *s)
+{
+	uint32_t sum = 0;
+
+	for (size_t i = 0; i < SLICE_COUNT; i++) {
+		sum += s->cycles[i];
+	}
+
+	return sum;
+}
+
+/* Look up the slot of a context. A slot which was not used in the whole
+ * window, for example by a thread that has exited, is reused.
+ */
+static uint8_t slot_get(enum cpu_load_ctx_type type, uintptr_t id)
+{
+	uint8_t free_slot = SLOT_OTHER;
+
+	for (uint8_t i = 0; i < SLOT_COUNT; i++) {
+		struct slot *s = &slots[i];
+
+		if ((s->id == id) && (s->type == type)) {
+			return i;
+		}
+
+		if ((free_slot == SLOT_OTHER) && (i != current) &&
+		    (slot_cycles(s) == 0)) {
+			free_slot = i;
+		}
+	}
+
+	if (free_slot != SLOT_OTHER) {
+		slots[free_slot].id = id;
+		slots[free_slot].type = type;
+	}
+
+	return free_slot;
+}
+
+/* Charge the time since the last event to the context running now. The
+ * time is split between the slices it covers, and the window is moved
+ * forward to the slice holding the current time.
+ *
+ * Must be called with interrupts locked, because an ISR entering in between
+ * would charge the same time again.
+ */
+static void charge(void)
+{
+	uint32_t now = k_cycle_get_32();
+	size_t cleared = 0;
+
+	while ((now - slice_start) >= slice_cycles) {
+		if (cleared == SLICE_COUNT) {
+			/* The whole window has passed. */
+			slice_start += ((now - slice_start) / slice_cycles) *
+				       slice_cycles;
+			stamp = slice_start;
+			break;
+		}
+
+		slice_start += slice_cycles;
+		slots[current].cycles[slice] += slice_start - stamp;
+		stamp = slice_start;
+
+		slice = (slice + 1) % SLICE_COUNT;
+		for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+			slots[i].cycles[slice] = 0;
+		}
+		cleared++;
+	}
+
+	slots[current].cycles[slice] += now - stamp;
+	stamp = now;
+}
+
+static uintptr_t isr_id(void)
+{
+#ifdef CONFIG_CPU_CORTEX_M
+	return __get_IPSR() - 16;
+#else
+	return 0;
+#endif
+}
+
+/* The hooks lock interrupts with arch_irq_lock(), which is not traced. */
+void sys_trace_thread_switched_out_user(struct k_thread *thread)
+{
+	unsigned int key = arch_irq_lock();
+
+	if (ready) {
+		charge();
+	}
+
+	arch_irq_unlock(key);
+}
+
+void sys_trace_thread_switched_in_user(struct k_thread *thread)
+{
+	unsigned int key = arch_irq_lock();
+
+	if (ready) {
+		charge();
+		current = slot_get(CPU_LOAD_CTX_THREAD, (uintptr_t)thread);
+	}
+
+	arch_irq_unlock(key);
+}
+
+void sys_trace_isr_enter_user(int nested_interrupts)
+{
+	unsigned int key = arch_irq_lock();
+
+	if (ready) {
+		charge();
+
+		if (nesting < NESTING_MAX) {
+			interrupted[nesting] = current;
+		}
+		nesting++;
+
+		current = slot_get(CPU_LOAD_CTX_ISR, isr_id());
+	}
+
+	arch_irq_unlock(key);
+}
+
+void sys_trace_isr_exit_user(int nested_interrupts)
+{
+	unsigned int key = arch_irq_lock();
+
+	if (ready && (nesting > 0)) {
+		charge();
+
+		nesting--;
+		current = (nesting < NESTING_MAX) ? interrupted[nesting] :
+						    SLOT_OTHER;
+	}
+
+	arch_irq_unlock(key);
+}
+
+void cpu_load_threads_reset(void)
+{
+	int key = irq_lock();
+
+	memset(slots, 0, sizeof(slots));
+	slice = 0;
+	slice_cycles = (uint32_t)(((uint64_t)CONFIG_CPU_LOAD_THREADS_WINDOW_MS *
+				   sys_clock_hw_cycles_per_sec()) /
+				  (MSEC_PER_SEC * SLICE_COUNT));
+	stamp = k_cycle_get_32();
+	slice_start = stamp;
+
+	/* Until the next switch, the time is charged to the context calling
+	 * this function.
+	 */
+	nesting = 0;
+	current = SLOT_OTHER;
+	current = k_is_in_isr() ?
+		  slot_get(CPU_LOAD_CTX_ISR, isr_id()) :
+		  slot_get(CPU_LOAD_CTX_THREAD, (uintptr_t)k_current_get());
+	ready = true;
+
+	irq_unlock(key);
+}
+
+size_t cpu_load_threads_get(struct cpu_load_ctx_stat *stats, size_t max_count)
+{
+	struct cpu_load_ctx_stat stat;
+	uint64_t total = 0;
+	size_t count = 0;
+	int key;
+
+	if (!ready) {
+		return 0;
+	}
+
+	key = irq_lock();
+
+	charge();
+
+	for (size_t i = 0; i < ARRAY_SIZE(slots); i++) {
+		total += slot_cycles(&slots[i]);
+	}
+
+	for (size_t i = 0; (i < ARRAY_SIZE(slots)) && (total > 0); i++) {
+		uint32_t cycles = slot_cycles(&slots[i]);
+		size_t pos;
+
+		if (cycles == 0) {
+			continue;
+		}
+
+		stat.type = (i == SLOT_OTHER) ? CPU_LOAD_CTX_OTHER :
+						 slots[i].type;
+		stat.thread = (stat.type == CPU_LOAD_CTX_THREAD) ?
+			      (const struct k_thread *)slots[i].id : NULL;
+		stat.irq = (stat.type == CPU_LOAD_CTX_ISR) ?
+			   (int)slots[i].id : -1;
+		stat.cycles = cycles;
+		stat.load = (uint32_t)((100000 * (uint64_t)cycles) / total);
+
+		/* Insert sorted by decreasing load, keeping the top ones. */
+		pos = MIN(count, max_count);
+		while ((pos > 0) && (stats[pos - 1].cycles < cycles)) {
+			if (pos < max_count) {
+				stats[pos] = stats[pos - 1];
+			}
+			pos--;
+		}
+
+		if (pos < max_count) {
+			stats[pos] = stat;
+			count = MIN(count + 1, max_count);
+		}
+	}
+
+	irq_unlock(key);
+
+	return count;
+}
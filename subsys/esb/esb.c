@@ -103,10 +103,14 @@ struct pipe_info {
 	bool ack_payload; /* State of the transmission of ACK payloads. */
 };
 
-/* First-in, first-out queue of payloads to be transmitted. */
+/* First-in, first-out queue of payloads to be transmitted.
+ *
+ * The payloads are stored in the ring itself, so that no separate pool is
+ * needed for a deep queue.
+ */
 struct payload_tx_fifo {
 	 /* Payload queue */
-	struct esb_payload *payload[CONFIG_ESB_TX_FIFO_SIZE];
+	struct esb_payload payload[CONFIG_ESB_TX_FIFO_SIZE];
 
 	uint32_t back;	/* Back of the queue (last in). */
 	uint32_t front;	/* Front of queue (first out). */
@@ -168,6 +172,20 @@ static struct payload_rx_fifo rx_fifo;
 static uint8_t tx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
 static uint8_t rx_payload_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
 
+/* Radio buffer of the current transmission in PTX mode. */
+static uint8_t *tx_buffer = tx_payload_buffer;
+
+#if defined(CONFIG_ESB_TX_BURST)
+/* Radio buffer of the next payload, prepared while the current one is sent. */
+static uint8_t tx_burst_buffer[CONFIG_ESB_MAX_PAYLOAD_LENGTH + 2];
+/* The payload that follows the current one is in the free radio buffer. */
+static bool tx_burst_staged;
+#endif
+
+#if defined(CONFIG_ESB_PIPE_STATS)
+static struct esb_pipe_stats pipe_stats[CONFIG_ESB_PIPE_COUNT];
+#endif
+
 /* Run time variables */
 static uint8_t pids[CONFIG_ESB_PIPE_COUNT];
 static struct pipe_info rx_pipe_info[CONFIG_ESB_PIPE_COUNT];
@@ -391,19 +409,19 @@ static void reset_fifos(void)
 	rx_fifo.back = 0;
 	rx_fifo.front = 0;
 	rx_fifo.count = 0;
+
+	tx_buffer = tx_payload_buffer;
+#if defined(CONFIG_ESB_TX_BURST)
+	tx_burst_staged = false;
+#endif
 }
 
 static void initialize_fifos(void)
 {
 	static struct esb_payload rx_payload[CONFIG_ESB_RX_FIFO_SIZE];
-	static struct esb_payload tx_payload[CONFIG_ESB_TX_FIFO_SIZE];
 
 	reset_fifos();
 
-	for (size_t i = 0; i < CONFIG_ESB_TX_FIFO_SIZE; i++) {
-		tx_fifo.payload[i] = &tx_payload[i];
-	}
-
 	for (size_t i = 0; i < CONFIG_ESB_RX_FIFO_SIZE; i++) {
 		rx_fifo.payload[i] = &rx_payload[i];
 	}
@@ -425,6 +443,44 @@ static void tx_fifo_remove_last(void)
 	irq_unlock(key);
 }
 
+/* Get the payload at the given position of the TX FIFO, or NULL if the
+ * FIFO holds fewer payloads.
+ */
+static struct esb_payload *tx_fifo_peek(uint32_t index)
+{
+	if (index >= tx_fifo.count) {
+		return NULL;
+	}
+
+	return &tx_fifo.payload[(tx_fifo.front + index) %
+				CONFIG_ESB_TX_FIFO_SIZE];
+}
+
+static void pipe_stats_tx_update(const struct esb_payload *payload,
+				 bool success, uint32_t attempts)
+{
+#if defined(CONFIG_ESB_PIPE_STATS)
+	struct esb_pipe_stats *stats = &pipe_stats[payload->pipe];
+
+	if (success) {
+		stats->tx_success++;
+		stats->tx_bytes += payload->length;
+	} else {
+		stats->tx_failed++;
+	}
+
+	stats->retransmits += attempts - 1;
+#endif
+}
+
+static void pipe_stats_rx_update(uint8_t pipe, uint8_t length)
+{
+#if defined(CONFIG_ESB_PIPE_STATS)
+	pipe_stats[pipe].rx_packets++;
+	pipe_stats[pipe].rx_bytes += length;
+#endif
+}
+
 /*  Function to push the content of the rx_buffer to the RX FIFO.
  *
  *  The module will point the register NRF_RADIO->PACKETPTR to a buffer for
@@ -463,6 +519,8 @@ static bool rx_fifo_push_rfbuf(uint8_t pipe, uint8_t pid)
 	rx_fifo.payload[rx_fifo.back]->pid = pid;
 	rx_fifo.payload[rx_fifo.back]->noack = !(rx_payload_buffer[1] & 0x01);
 
+	pipe_stats_rx_update(pipe, rx_fifo.payload[rx_fifo.back]->length);
+
 	if (++rx_fifo.back >= CONFIG_ESB_RX_FIFO_SIZE) {
 		rx_fifo.back = 0;
 	}
@@ -515,22 +573,78 @@ static void ppi_init(void)
 							(1 << ppi_ch_timer_compare0_radio_disable) | (1 << ppi_ch_timer_compare1_radio_txen);
 }
 
-static void start_tx_transaction(void)
+static bool tx_ack_required(const struct esb_payload *payload)
+{
+	/* Handling ack if noack is set to false or if selective auto ack is
+	 * turned off
+	 */
+	return (esb_cfg.protocol == ESB_PROTOCOL_ESB) || !payload->noack ||
+	       !esb_cfg.selective_auto_ack;
+}
+
+static void tx_buffer_fill(uint8_t *buffer, const struct esb_payload *payload)
+{
+	if (esb_cfg.protocol == ESB_PROTOCOL_ESB) {
+		buffer[0] = payload->pid;
+		buffer[1] = 0;
+	} else {
+		buffer[0] = payload->length;
+		buffer[1] = payload->pid << 1;
+		buffer[1] |= payload->noack ? 0x00 : 0x01;
+	}
+
+	memcpy(&buffer[2], payload->data, payload->length);
+}
+
+#if defined(CONFIG_ESB_TX_BURST)
+static uint8_t *tx_burst_buffer_free(void)
+{
+	return (tx_buffer == tx_payload_buffer) ? tx_burst_buffer :
+						  tx_payload_buffer;
+}
+
+/* Prepare the payload that follows the current one in the free radio
+ * buffer, so that it is ready when the current transaction ends.
+ *
+ * The radio interrupt then only switches the packet pointer before it starts
+ * the ramp-up. The DISABLED to TXEN shortcut is not used for this, because
+ * the packet pointer refers to the RX buffer until the interrupt is handled.
+ */
+static void tx_burst_stage(void)
 {
-	bool ack;
+	const struct esb_payload *next = tx_fifo_peek(1);
+
+	if (tx_burst_staged || !next) {
+		return;
+	}
+
+	tx_buffer_fill(tx_burst_buffer_free(), next);
+	tx_burst_staged = true;
+}
+#endif /* defined(CONFIG_ESB_TX_BURST) */
 
+/* Configure the radio for the payload at the front of the TX FIFO. */
+static void tx_transaction_setup(void)
+{
 	last_tx_attempts = 1;
-	/* Prepare the payload */
-	current_payload = tx_fifo.payload[tx_fifo.front];
+	current_payload = tx_fifo_peek(0);
 
-	switch (esb_cfg.protocol) {
-	case ESB_PROTOCOL_ESB:
+#if defined(CONFIG_ESB_TX_BURST)
+	if (tx_burst_staged) {
+		tx_buffer = tx_burst_buffer_free();
+		tx_burst_staged = false;
+	} else {
+		tx_buffer_fill(tx_buffer, current_payload);
+	}
+#else
+	tx_buffer_fill(tx_buffer, current_payload);
+#endif
+
+	if (esb_cfg.protocol == ESB_PROTOCOL_ESB) {
 		update_rf_payload_format(current_payload->length);
-		tx_payload_buffer[0] = current_payload->pid;
-		tx_payload_buffer[1] = 0;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
+	}
 
+	if (tx_ack_required(current_payload)) {
 		NRF_RADIO->SHORTS = radio_shorts_common |
 				    RADIO_SHORTS_DISABLED_RXEN_Msk;
 		NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk |
@@ -540,47 +654,24 @@ static void start_tx_transaction(void)
 		retransmits_remaining = esb_cfg.retransmit_count;
 		on_radio_disabled = on_radio_disabled_tx;
 		esb_state = ESB_STATE_PTX_TX_ACK;
-		break;
-
-	case ESB_PROTOCOL_ESB_DPL:
-		ack = !current_payload->noack || !esb_cfg.selective_auto_ack;
-		tx_payload_buffer[0] = current_payload->length;
-		tx_payload_buffer[1] = current_payload->pid << 1;
-		tx_payload_buffer[1] |= current_payload->noack ? 0x00 : 0x01;
-		memcpy(&tx_payload_buffer[2], current_payload->data,
-		       current_payload->length);
-
-		/* Handling ack if noack is set to false or if
-		 * selective auto ack is turned off
-		 */
-		if (ack) {
-			NRF_RADIO->SHORTS = radio_shorts_common |
-					    RADIO_SHORTS_DISABLED_RXEN_Msk;
-			NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk |
-					      RADIO_INTENSET_READY_Msk;
-
-			/* Configure the retransmit counter */
-			retransmits_remaining = esb_cfg.retransmit_count;
-			on_radio_disabled = on_radio_disabled_tx;
-			esb_state = ESB_STATE_PTX_TX_ACK;
-		} else {
-			NRF_RADIO->SHORTS = radio_shorts_common;
-			NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
-			on_radio_disabled = on_radio_disabled_tx_noack;
-			esb_state = ESB_STATE_PTX_TX;
-		}
-		break;
-
-	default:
-		/* Should not be reached */
-		break;
+	} else {
+		NRF_RADIO->SHORTS = radio_shorts_common;
+		NRF_RADIO->INTENSET = RADIO_INTENSET_DISABLED_Msk;
+		on_radio_disabled = on_radio_disabled_tx_noack;
+		esb_state = ESB_STATE_PTX_TX;
 	}
 
 	NRF_RADIO->TXADDRESS = current_payload->pipe;
 	NRF_RADIO->RXADDRESSES = 1 << current_payload->pipe;
-	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
 
-	NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
+	NRF_RADIO->PACKETPTR = (uint32_t)tx_buffer;
+}
+
+static void start_tx_transaction(void)
+{
+	tx_transaction_setup();
+
+	NRF_RADIO->FREQUENCY = esb_addr.rf_channel;
 
 	NVIC_ClearPendingIRQ(RADIO_IRQn);
 	irq_enable(RADIO_IRQn);
@@ -590,22 +681,33 @@ static void start_tx_transaction(void)
 	NRF_RADIO->EVENTS_DISABLED = 0;
 
 	NRF_RADIO->TASKS_TXEN = 1;
+
+#if defined(CONFIG_ESB_TX_BURST)
+	tx_burst_stage();
+#endif
 }
 
-static void on_radio_disabled_tx_noack(void)
+/* Continue with the next payload of the TX FIFO after a transaction. */
+static void tx_fifo_continue(bool stop)
 {
-	interrupt_flags |= INT_TX_SUCCESS_MSK;
-	tx_fifo_remove_last();
+	NVIC_SetPendingIRQ(ESB_EVT_IRQ);
 
-	if (tx_fifo.count == 0) {
+	if ((tx_fifo.count == 0) || stop) {
 		esb_state = ESB_STATE_IDLE;
-		NVIC_SetPendingIRQ(ESB_EVT_IRQ);
 	} else {
-		NVIC_SetPendingIRQ(ESB_EVT_IRQ);
 		start_tx_transaction();
 	}
 }
 
+static void on_radio_disabled_tx_noack(void)
+{
+	interrupt_flags |= INT_TX_SUCCESS_MSK;
+	pipe_stats_tx_update(current_payload, true, 1);
+	tx_fifo_remove_last();
+
+	tx_fifo_continue(false);
+}
+
 static void on_radio_disabled_tx(void)
 {
 	/* Remove the DISABLED -> RXEN shortcut, to make sure the radio stays
@@ -638,6 +740,28 @@ static void on_radio_disabled_tx(void)
 	NRF_RADIO->PACKETPTR = (uint32_t)rx_payload_buffer;
 	on_radio_disabled = on_radio_disabled_tx_wait_for_ack;
 	esb_state = ESB_STATE_PTX_RX_ACK;
+
+#if defined(CONFIG_ESB_TX_BURST)
+	tx_burst_stage();
+#endif
+}
+
+static void tx_retransmit_schedule(void)
+{
+	/* TX mode should be entered again as soon as the system timer reaches
+	 * CC[1].
+	 */
+	NRF_RADIO->SHORTS = radio_shorts_common |
+			    RADIO_SHORTS_DISABLED_RXEN_Msk;
+	update_rf_payload_format(current_payload->length);
+	NRF_RADIO->PACKETPTR = (uint32_t)tx_buffer;
+	on_radio_disabled = on_radio_disabled_tx;
+	esb_state = ESB_STATE_PTX_TX_ACK;
+	ESB_SYS_TIMER->TASKS_START = 1;
+	nrfx_gppi_channels_enable(1 << ppi_ch_timer_compare1_radio_txen);
+	if (ESB_SYS_TIMER->EVENTS_COMPARE[1]) {
+		NRF_RADIO->TASKS_TXEN = 1;
+	}
 }
 
 static void on_radio_disabled_tx_wait_for_ack(void)
@@ -657,6 +781,7 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 		last_tx_attempts = esb_cfg.retransmit_count -
 				   retransmits_remaining + 1;
 
+		pipe_stats_tx_update(current_payload, true, last_tx_attempts);
 		tx_fifo_remove_last();
 
 		if (esb_cfg.protocol != ESB_PROTOCOL_ESB &&
@@ -668,42 +793,32 @@ static void on_radio_disabled_tx_wait_for_ack(void)
 			}
 		}
 
-		if ((tx_fifo.count == 0) ||
-		    (esb_cfg.tx_mode == ESB_TXMODE_MANUAL)) {
-			esb_state = ESB_STATE_IDLE;
-			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
-		} else {
-			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
-			start_tx_transaction();
-		}
+		tx_fifo_continue(esb_cfg.tx_mode == ESB_TXMODE_MANUAL);
 	} else {
 		if (retransmits_remaining-- == 0) {
 			ESB_SYS_TIMER->TASKS_SHUTDOWN = 1;
 
-			/* All retransmits are expended, and the TX operation is
-			 * suspended
-			 */
 			last_tx_attempts = esb_cfg.retransmit_count + 1;
 			interrupt_flags |= INT_TX_FAILED_MSK;
+			pipe_stats_tx_update(current_payload, false,
+					     last_tx_attempts);
 
+#if defined(CONFIG_ESB_TX_BURST)
+			/* All retransmits are expended, the payload is dropped
+			 * and the burst goes on with the next one.
+			 */
+			tx_fifo_remove_last();
+			tx_fifo_continue(esb_cfg.tx_mode == ESB_TXMODE_MANUAL);
+#else
+			/* All retransmits are expended, and the TX operation is
+			 * suspended
+			 */
 			esb_state = ESB_STATE_IDLE;
 			NVIC_SetPendingIRQ(ESB_EVT_IRQ);
+#endif
 		} else {
-			/* There are still more retransmits left, TX mode should
-			 * be entered again as soon as the system timer reaches
-			 * CC[1].
-			 */
-			NRF_RADIO->SHORTS = radio_shorts_common |
-					    RADIO_SHORTS_DISABLED_RXEN_Msk;
-			update_rf_payload_format(current_payload->length);
-			NRF_RADIO->PACKETPTR = (uint32_t)tx_payload_buffer;
-			on_radio_disabled = on_radio_disabled_tx;
-			esb_state = ESB_STATE_PTX_TX_ACK;
-			ESB_SYS_TIMER->TASKS_START = 1;
-			nrfx_gppi_channels_enable(1 << ppi_ch_timer_compare1_radio_txen);
-			if (ESB_SYS_TIMER->EVENTS_COMPARE[1]) {
-				NRF_RADIO->TASKS_TXEN = 1;
-			}
+			/* There are still more retransmits left. */
+			tx_retransmit_schedule();
 		}
 	}
 }
@@ -731,11 +846,14 @@ static void on_radio_disabled_rx_dpl(bool retransmit_payload,
 				     struct pipe_info *pipe_info)
 {
 	if (tx_fifo.count > 0 &&
-	    (tx_fifo.payload[tx_fifo.front]->pipe == NRF_RADIO->RXMATCH)) {
+	    (tx_fifo.payload[tx_fifo.front].pipe == NRF_RADIO->RXMATCH)) {
 		/* Pipe stays in ACK with payload until TX FIFO is empty */
 		/* Do not report TX success on first ack payload or retransmit
 		 */
 		if (pipe_info->ack_payload && !retransmit_payload) {
+			pipe_stats_tx_update(&tx_fifo.payload[tx_fifo.front],
+					     true, 1);
+
 			if (++tx_fifo.front >= CONFIG_ESB_TX_FIFO_SIZE) {
 				tx_fifo.front = 0;
 			}
@@ -751,7 +869,7 @@ static void on_radio_disabled_rx_dpl(bool retransmit_payload,
 
 		pipe_info->ack_payload = true;
 
-		current_payload = tx_fifo.payload[tx_fifo.front];
+		current_payload = &tx_fifo.payload[tx_fifo.front];
 
 		update_rf_payload_format(current_payload->length);
 		tx_payload_buffer[0] = current_payload->length;
@@ -936,6 +1054,9 @@ int esb_init(const struct esb_config *config)
 
 	memset(rx_pipe_info, 0, sizeof(rx_pipe_info));
 	memset(pids, 0, sizeof(pids));
+#if defined(CONFIG_ESB_PIPE_STATS)
+	memset(pipe_stats, 0, sizeof(pipe_stats));
+#endif
 
 	update_radio_parameters();
 
@@ -1037,11 +1158,11 @@ int esb_write_payload(const struct esb_payload *payload)
 
 	uint32_t key = irq_lock();
 
-	memcpy(tx_fifo.payload[tx_fifo.back], payload,
+	memcpy(&tx_fifo.payload[tx_fifo.back], payload,
 	       sizeof(struct esb_payload));
 
 	pids[payload->pipe] = (pids[payload->pipe] + 1) % (PID_MAX + 1);
-	tx_fifo.payload[tx_fifo.back]->pid = pids[payload->pipe];
+	tx_fifo.payload[tx_fifo.back].pid = pids[payload->pipe];
 
 	if (++tx_fifo.back >= CONFIG_ESB_TX_FIFO_SIZE) {
 		tx_fifo.back = 0;
@@ -1049,6 +1170,15 @@ int esb_write_payload(const struct esb_payload *payload)
 
 	tx_fifo.count++;
 
+#if defined(CONFIG_ESB_TX_BURST)
+	/* Prepare the payload if it is the next one of an ongoing burst. */
+	if ((esb_state == ESB_STATE_PTX_TX) ||
+	    (esb_state == ESB_STATE_PTX_TX_ACK) ||
+	    (esb_state == ESB_STATE_PTX_RX_ACK)) {
+		tx_burst_stage();
+	}
+#endif
+
 	irq_unlock(key);
 
 	if (esb_cfg.mode == ESB_MODE_PTX &&
@@ -1171,6 +1301,9 @@ int esb_flush_tx(void)
 	tx_fifo.count = 0;
 	tx_fifo.back = 0;
 	tx_fifo.front = 0;
+#if defined(CONFIG_ESB_TX_BURST)
+	tx_burst_staged = false;
+#endif
 
 	irq_unlock(key);
 
@@ -1188,10 +1321,13 @@ int esb_pop_tx(void)
 
 	uint32_t key = irq_lock();
 
-	if (++tx_fifo.back >= CONFIG_ESB_TX_FIFO_SIZE) {
-		tx_fifo.back = 0;
+	if (++tx_fifo.front >= CONFIG_ESB_TX_FIFO_SIZE) {
+		tx_fifo.front = 0;
 	}
 	tx_fifo.count--;
+#if defined(CONFIG_ESB_TX_BURST)
+	tx_burst_staged = false;
+#endif
 
 	irq_unlock(key);
 
@@ -1405,3 +1541,29 @@ int esb_reuse_pid(uint8_t pipe)
 
 	return 0;
 }
+
+#if defined(CONFIG_ESB_PIPE_STATS)
+int esb_pipe_stats_get(uint8_t pipe, struct esb_pipe_stats *stats)
+{
+	if ((pipe >= CONFIG_ESB_PIPE_COUNT) || (stats == NULL)) {
+		return -EINVAL;
+	}
+
+	uint32_t key = irq_lock();
+
+	*stats = pipe_stats[pipe];
+
+	irq_unlock(key);
+
+	return 0;
+}
+
+void esb_pipe_stats_reset(void)
+{
+	uint32_t key = irq_lock();
+
+	memset(pipe_stats, 0, sizeof(pipe_stats));
+
+	irq_unlock(key);
+}
+#endif /* defined(CONFIG_ESB_PIPE_STATS) */
@@ -10,6 +10,7 @@
 #include <net/fota_download.h>
 #include <net/aws_jobs.h>
 #include <net/aws_fota.h>
+#include <net/mqtt_topic_router.h>
 #include <logging/log.h>
 
 #include "aws_fota_json.h"
@@ -48,6 +49,32 @@ static uint8_t notify_next_topic[AWS_JOBS_TOPIC_MAX_LEN];
 static uint8_t update_topic[AWS_JOBS_TOPIC_MAX_LEN];
 static uint8_t get_topic[AWS_JOBS_TOPIC_MAX_LEN];
 
+/* AWS IoT Jobs topics handled by the library */
+enum job_topic {
+	JOB_TOPIC_GET,
+	JOB_TOPIC_NOTIFY_NEXT,
+	JOB_TOPIC_UPDATE_ACCEPTED,
+	JOB_TOPIC_UPDATE_REJECTED,
+	JOB_TOPIC_COUNT
+};
+
+#define JOB_TOPIC_PREFIX "$aws/things/%.*s/jobs/"
+
+/* The update topics match any job ID, only the current job is subscribed. */
+static const char *const job_topic_formats[] = {
+	[JOB_TOPIC_GET] = JOB_TOPIC_PREFIX "$next/get/#",
+	[JOB_TOPIC_NOTIFY_NEXT] = JOB_TOPIC_PREFIX "notify-next",
+	[JOB_TOPIC_UPDATE_ACCEPTED] = JOB_TOPIC_PREFIX "+/update/accepted",
+	[JOB_TOPIC_UPDATE_REJECTED] = JOB_TOPIC_PREFIX "+/update/rejected",
+};
+
+/* One trie node per unique topic level in the topics above. */
+#define JOB_TOPIC_ROUTER_NODES 11
+
+MQTT_TOPIC_ROUTER_DEFINE(job_topic_router, JOB_TOPIC_ROUTER_NODES);
+static struct mqtt_topic_router_route job_topic_routes[JOB_TOPIC_COUNT];
+static char job_topic_filters[JOB_TOPIC_COUNT][AWS_JOBS_TOPIC_MAX_LEN];
+
 /* Allocated buffers for keeping hostname, json payload and file_path */
 static uint8_t payload_buf[CONFIG_AWS_FOTA_PAYLOAD_SIZE];
 static uint8_t hostname[CONFIG_AWS_FOTA_HOSTNAME_MAX_LEN];
@@ -333,16 +360,8 @@ static int on_publish_evt(struct mqtt_client *const client,
 				   uint32_t topic_len,
 				   uint32_t payload_len)
 {
-	bool is_get_next_topic =
-		aws_jobs_cmp(get_topic, topic, topic_len, "");
-	bool is_get_accepted =
-		aws_jobs_cmp(get_topic, topic, topic_len, "accepted");
-	bool is_notify_next_topic =
-		aws_jobs_cmp(notify_next_topic, topic, topic_len, "");
-	bool doc_update_accepted =
-		aws_jobs_cmp(update_topic, topic, topic_len, "accepted");
-	bool doc_update_rejected =
-		aws_jobs_cmp(update_topic, topic, topic_len, "rejected");
+	const struct mqtt_topic_router_route *route =
+		mqtt_topic_router_match(&job_topic_router, topic, topic_len);
 
 #if defined(CONFIG_AWS_FOTA_LOG_LEVEL_DBG)
 	char debug_log[topic_len + 1];
@@ -352,14 +371,18 @@ static int on_publish_evt(struct mqtt_client *const client,
 	LOG_DBG("Received topic: %s", log_strdup(debug_log));
 #endif
 
-	if (is_notify_next_topic || is_get_next_topic || is_get_accepted) {
+	switch (route ? route->id : JOB_TOPIC_COUNT) {
+	case JOB_TOPIC_GET:
+	case JOB_TOPIC_NOTIFY_NEXT:
 		LOG_DBG("Checking for an available job");
 		return get_job_execution(client, payload_len);
-	} else if (doc_update_accepted) {
+	case JOB_TOPIC_UPDATE_ACCEPTED:
 		return job_update_accepted(client, payload_len);
-	} else if (doc_update_rejected) {
+	case JOB_TOPIC_UPDATE_REJECTED:
 		LOG_ERR("Job document update was rejected");
 		return job_update_rejected(client, payload_len);
+	default:
+		break;
 	}
 #if defined(CONFIG_AWS_FOTA_LOG_LEVEL_DBG)
 	LOG_DBG("received an unhandled MQTT publish event on topic: %s",
@@ -369,6 +392,48 @@ static int on_publish_evt(struct mqtt_client *const client,
 	return 1;
 }
 
+/**
+ * @brief Build the router of the AWS IoT Jobs topics for the thing name of
+ *	  the MQTT client.
+ *
+ * @param[in] client  MQTT client instance.
+ *
+ * @return 0 If successful otherwise a negative error code is returned.
+ */
+static int job_topic_router_init(const struct mqtt_client *const client)
+{
+	int err;
+
+	err = mqtt_topic_router_reset(&job_topic_router);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < JOB_TOPIC_COUNT; i++) {
+		int len = snprintf(job_topic_filters[i],
+				   sizeof(job_topic_filters[i]),
+				   job_topic_formats[i],
+				   (int)client->client_id.size,
+				   client->client_id.utf8);
+
+		if ((len < 0) || (len >= sizeof(job_topic_filters[i]))) {
+			return -ENOMEM;
+		}
+
+		job_topic_routes[i].filter = job_topic_filters[i];
+		job_topic_routes[i].filter_len = len;
+		job_topic_routes[i].id = i;
+
+		err = mqtt_topic_router_add(&job_topic_router,
+					    &job_topic_routes[i]);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
 int aws_fota_mqtt_evt_handler(struct mqtt_client *const client,
 			      const struct mqtt_evt *evt)
 {
@@ -383,6 +448,13 @@ int aws_fota_mqtt_evt_handler(struct mqtt_client *const client,
 			return 1;
 		}
 
+		err = job_topic_router_init(client);
+		if (err) {
+			LOG_ERR("Unable to build the job topic router: %d",
+				err);
+			return err;
+		}
+
 		if (IS_ENABLED(CONFIG_MQTT_CLEAN_SESSION) ||
 		    !evt->param.connack.session_present_flag) {
 			err = aws_jobs_subscribe_topic_notify_next(client,
@@ -7,6 +7,7 @@
 #include <zephyr.h>
 #include <string.h>
 #include <cJSON.h>
+#include <cJSON_os.h>
 #include <sys/util.h>
 #include <net/aws_jobs.h>
 
@@ -33,6 +34,8 @@ int aws_fota_parse_UpdateJobExecution_rsp(const char *update_rsp_document,
 
 	int ret;
 
+	cJSON_ArenaBegin();
+
 	cJSON *update_response = cJSON_Parse(update_rsp_document);
 
 	if (update_response == NULL) {
@@ -53,6 +56,7 @@ int aws_fota_parse_UpdateJobExecution_rsp(const char *update_rsp_document,
 	ret = 0;
 cleanup:
 	cJSON_Delete(update_response);
+	cJSON_ArenaEnd();
 	return ret;
 }
 
@@ -73,6 +77,8 @@ int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
 
 	int ret;
 
+	cJSON_ArenaBegin();
+
 	cJSON *json_data = cJSON_Parse(job_document);
 
 	if (json_data == NULL) {
@@ -140,5 +146,6 @@ int aws_fota_parse_DescribeJobExecution_rsp(const char *job_document,
 	ret = 1;
 cleanup:
 	cJSON_Delete(json_data);
+	cJSON_ArenaEnd();
 	return ret;
 }
@@ -80,6 +80,14 @@ static inline void azure_iot_hub_prop_bag_free(char *buf)
 	k_free(buf);
 }
 
+/* @brief Build the router used to detect the topic types. Must be called
+ *	  before subscribing to the topics, topic_type_get() does not detect
+ *	  any topic type until then.
+ *
+ * @return 0 on success, or a negative error code from the topic router.
+ */
+int azure_iot_hub_topic_router_init(void);
+
 /* @brief Get topic type.
  *
  * @param buf Topic buffer.
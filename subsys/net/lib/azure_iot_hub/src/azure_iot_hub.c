@@ -571,6 +571,15 @@ static void mqtt_evt_handler(struct mqtt_client *const client,
 
 		LOG_DBG("MQTT client connected");
 
+		/* Build the topic router before the topics are subscribed to,
+		 * the incoming topics are only routed from this thread.
+		 */
+		err = azure_iot_hub_topic_router_init();
+		if (err) {
+			LOG_ERR("Failed to build the topic router, err: %d",
+				err);
+		}
+
 #if IS_ENABLED(CONFIG_AZURE_IOT_HUB_DPS)
 		if (dps_reg_in_progress()) {
 			err = dps_subscribe();
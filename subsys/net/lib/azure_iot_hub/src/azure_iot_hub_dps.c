@@ -219,9 +219,12 @@ static int dps_get_operation_id(char *json)
 	char *op_id_str;
 	int err = 0;
 
+	cJSON_ArenaBegin();
+
 	root_obj = cJSON_Parse(json);
 	if (root_obj == NULL) {
 		LOG_DBG("[%s:%d] Unable to parse input", __func__, __LINE__);
+		cJSON_ArenaEnd();
 		return -ENOMEM;
 	}
 
@@ -244,6 +247,7 @@ static int dps_get_operation_id(char *json)
 
 exit:
 	cJSON_Delete(root_obj);
+	cJSON_ArenaEnd();
 
 	return err;
 }
@@ -254,9 +258,12 @@ static int dps_check_reg_success(char *json)
 	char *status_str, *assigned_hub_str;
 	int err = 0;
 
+	cJSON_ArenaBegin();
+
 	root_obj = cJSON_Parse(json);
 	if (root_obj == NULL) {
 		LOG_DBG("[%s:%d] Unable to parse input", __func__, __LINE__);
+		cJSON_ArenaEnd();
 		return -ENOMEM;
 	}
 
@@ -315,6 +322,7 @@ static int dps_check_reg_success(char *json)
 	}
 exit:
 	cJSON_Delete(root_obj);
+	cJSON_ArenaEnd();
 
 	return err;
 }
@@ -9,6 +9,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <net/mqtt_topic_router.h>
+
 #include "azure_iot_hub_topic.h"
 
 #include <logging/log.h>
@@ -26,6 +28,57 @@ static char *topic_prefixes[] = {
 	[TOPIC_TYPE_DIRECT_METHOD] = TOPIC_PREFIX_DIRECT_METHOD,
 };
 
+/* Routes from the topic prefixes to the topic types. Each prefix ends with
+ * '/', so appending '#' gives a filter matching all topics of that type.
+ */
+static const struct mqtt_topic_router_route topic_routes[] = {
+	{
+		.filter = TOPIC_PREFIX_DEVICEBOUND "#",
+		.id = TOPIC_TYPE_DEVICEBOUND,
+	},
+	{
+		.filter = TOPIC_PREFIX_TWIN_DESIRED "#",
+		.id = TOPIC_TYPE_TWIN_UPDATE_DESIRED,
+	},
+	{
+		.filter = TOPIC_PREFIX_TWIN_RES "#",
+		.id = TOPIC_TYPE_TWIN_UPDATE_RESULT,
+	},
+	{
+		.filter = TOPIC_PREFIX_DPS_REG_RESULT "#",
+		.id = TOPIC_TYPE_DPS_REG_RESULT,
+	},
+	{
+		.filter = TOPIC_PREFIX_DIRECT_METHOD "#",
+		.id = TOPIC_TYPE_DIRECT_METHOD,
+	},
+};
+
+/* One trie node per unique topic level in the prefixes above. */
+#define TOPIC_ROUTER_NODES 12
+
+MQTT_TOPIC_ROUTER_DEFINE(topic_router, TOPIC_ROUTER_NODES);
+
+int azure_iot_hub_topic_router_init(void)
+{
+	int err;
+
+	err = mqtt_topic_router_reset(&topic_router);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(topic_routes); i++) {
+		err = mqtt_topic_router_add(&topic_router, &topic_routes[i]);
+		if (err) {
+			LOG_ERR("Failed to add topic route, error: %d", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
 /* If the topic type is TOPIC_TYPE_DEVICEBOUND, the dynamic value in the
  * topic (the device ID), is placed in the middle of the topic, and
  * the following string needs to be skipped before reaching the property
@@ -166,18 +219,18 @@ static int get_next_prop_bag(char *buf, size_t buf_len,
 
 enum topic_type topic_type_get(const char *buf, const size_t len)
 {
+	const struct mqtt_topic_router_route *route;
+
 	if (buf == NULL || len == 0) {
 		return TOPIC_TYPE_EMPTY;
 	}
 
-	for (size_t i = 0; i < ARRAY_SIZE(topic_prefixes); i++) {
-		if (strncmp(topic_prefixes[i], buf,
-			    MIN(strlen(topic_prefixes[i]), len)) == 0) {
-			return i;
-		}
+	route = mqtt_topic_router_match(&topic_router, buf, len);
+	if (route == NULL) {
+		return TOPIC_TYPE_UNEXPECTED;
 	}
 
-	return TOPIC_TYPE_UNEXPECTED;
+	return route->id;
 }
 
 int azure_iot_hub_topic_parse(struct topic_parser_data *const data)
@@ -214,7 +267,7 @@ int azure_iot_hub_topic_parse(struct topic_parser_data *const data)
 	 */
 
 	/* Detect if the topic carries more information than just the prefix. */
-	if (start_ptr == max_ptr) {
+	if (start_ptr >= max_ptr) {
 		return 0;
 	}
 
@@ -0,0 +1,670 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <string.h>
+#include <net/cloud.h>
+#include <net/cloud_outbox.h>
+#include <logging/log.h>
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+#include <fs/fcb.h>
+#include <storage/flash_map.h>
+#include <pm_config.h>
+#endif
+
+LOG_MODULE_REGISTER(cloud_outbox, CONFIG_CLOUD_OUTBOX_LOG_LEVEL);
+
+#define MSG_MAX_LEN CONFIG_CLOUD_OUTBOX_MSG_MAX_LEN
+#define EP_MAX_LEN CONFIG_CLOUD_OUTBOX_ENDPOINT_MAX_LEN
+
+/* Metadata stored in front of each message, followed by the endpoint string
+ * and the payload. The same format is used in RAM and in flash.
+ */
+struct record_hdr {
+	uint16_t len;
+	uint16_t ep_type;
+	uint8_t qos;
+	uint8_t ep_len;
+} __packed;
+
+#define RECORD_MAX_LEN (sizeof(struct record_hdr) + EP_MAX_LEN + MSG_MAX_LEN)
+
+BUILD_ASSERT(MSG_MAX_LEN <= UINT16_MAX,
+	     "CONFIG_CLOUD_OUTBOX_MSG_MAX_LEN is too large");
+BUILD_ASSERT(CONFIG_CLOUD_OUTBOX_RAM_SIZE >= RECORD_MAX_LEN,
+	     "CONFIG_CLOUD_OUTBOX_RAM_SIZE must fit the largest message");
+BUILD_ASSERT((CONFIG_CLOUD_OUTBOX_RETRY_MIN_MS > 0) &&
+	     (CONFIG_CLOUD_OUTBOX_RETRY_MIN_MS <=
+	      CONFIG_CLOUD_OUTBOX_RETRY_MAX_MS),
+	     "Invalid cloud outbox retry delays");
+
+/* Iterator over the stored records, from the oldest to the newest.
+ * RAM records are always older than the records in flash.
+ */
+struct record_iter {
+	size_t ram_idx;
+	size_t ram_off;
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+	struct fcb_entry loc;
+#endif
+};
+
+static const struct cloud_backend *outbox_backend;
+static K_MUTEX_DEFINE(outbox_lock);
+static atomic_t outbox_ready;
+
+/* RAM ring buffer of records. */
+static uint8_t ram_buf[CONFIG_CLOUD_OUTBOX_RAM_SIZE];
+static size_t ram_tail;
+static size_t ram_used;
+static size_t ram_count;
+
+/* Number of records that are being sent by the outbox thread. They must not
+ * be dropped to make room for new records.
+ */
+static size_t inflight_count;
+
+/* Buffer for one record, padded for aligned flash writes. */
+static uint8_t record_buf[ROUND_UP(RECORD_MAX_LEN, 8)] __aligned(4);
+/* Publication buffers, with room for the opening bracket of a batch. */
+static char tx_ep[EP_MAX_LEN + 1];
+static uint8_t tx_buf[MSG_MAX_LEN + 1];
+
+static struct cloud_outbox_stats stats;
+
+static K_THREAD_STACK_DEFINE(outbox_stack, CONFIG_CLOUD_OUTBOX_STACK_SIZE);
+static struct k_work_q outbox_work_q;
+static struct k_delayed_work drain_work;
+/* Delay before the next retry, 0 if the last send did not fail. Only used by
+ * the outbox thread.
+ */
+static uint32_t retry_delay_ms;
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+#define FLASH_SECTOR_MAX 16
+#define FCB_MAGIC 0x0b0c5e11
+
+static struct flash_sector flash_sectors[FLASH_SECTOR_MAX];
+static struct fcb flash_fcb;
+/* Last consumed entry. The sector pointer is NULL if no entries in flash
+ * have been consumed since the sector of the last consumed entry was erased.
+ */
+static struct fcb_entry flash_rd_loc;
+static size_t flash_count;
+#endif
+
+static void ram_read(size_t off, void *data, size_t len)
+{
+	size_t first = MIN(len, sizeof(ram_buf) - off);
+
+	memcpy(data, &ram_buf[off], first);
+	memcpy((uint8_t *)data + first, ram_buf, len - first);
+}
+
+static void ram_write(size_t off, const void *data, size_t len)
+{
+	size_t first = MIN(len, sizeof(ram_buf) - off);
+
+	memcpy(&ram_buf[off], data, first);
+	memcpy(ram_buf, (const uint8_t *)data + first, len - first);
+}
+
+static size_t ram_offset(size_t off, size_t len)
+{
+	return (off + len) % sizeof(ram_buf);
+}
+
+static size_t record_len(const struct record_hdr *hdr)
+{
+	return sizeof(*hdr) + hdr->ep_len + hdr->len;
+}
+
+static void ram_drop_oldest(void)
+{
+	struct record_hdr hdr;
+
+	ram_read(ram_tail, &hdr, sizeof(hdr));
+
+	ram_tail = ram_offset(ram_tail, record_len(&hdr));
+	ram_used -= record_len(&hdr);
+	ram_count--;
+}
+
+static int ram_store(const uint8_t *record, size_t len)
+{
+	if (len > sizeof(ram_buf) - ram_used) {
+		if (IS_ENABLED(CONFIG_CLOUD_OUTBOX_FLASH)) {
+			return -ENOMEM;
+		}
+
+		/* Without flash, drop the oldest records to make room, unless
+		 * they are being sent.
+		 */
+		while ((len > sizeof(ram_buf) - ram_used) &&
+		       (ram_count > 0) && (inflight_count == 0)) {
+			ram_drop_oldest();
+			stats.dropped++;
+			LOG_WRN("Outbox full, oldest message dropped");
+		}
+
+		if (len > sizeof(ram_buf) - ram_used) {
+			return -ENOMEM;
+		}
+	}
+
+	ram_write(ram_offset(ram_tail, ram_used), record, len);
+	ram_used += len;
+	ram_count++;
+
+	return 0;
+}
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+/* Count the unconsumed entries in the oldest sector. */
+static size_t flash_oldest_count(void)
+{
+	struct fcb_entry loc = flash_rd_loc;
+	size_t count = 0;
+
+	while ((fcb_getnext(&flash_fcb, &loc) == 0) &&
+	       (loc.fe_sector == flash_fcb.f_oldest)) {
+		count++;
+	}
+
+	return count;
+}
+
+static int flash_store(const uint8_t *record, size_t len)
+{
+	struct fcb_entry loc;
+	int err;
+
+	while (true) {
+		err = fcb_append(&flash_fcb, len, &loc);
+		if (err != -ENOSPC) {
+			break;
+		}
+
+		/* Records being sent may be in the oldest sector. */
+		if (inflight_count > ram_count) {
+			return -ENOMEM;
+		}
+
+		/* Drop the oldest sector to make room. */
+		size_t dropped = flash_oldest_count();
+
+		if (flash_rd_loc.fe_sector == flash_fcb.f_oldest) {
+			memset(&flash_rd_loc, 0, sizeof(flash_rd_loc));
+		}
+
+		err = fcb_rotate(&flash_fcb);
+		if (err) {
+			break;
+		}
+
+		flash_count -= dropped;
+		stats.dropped += dropped;
+		LOG_WRN("Outbox full, %d messages dropped", (int)dropped);
+	}
+
+	if (err) {
+		LOG_ERR("Failed to append to flash, error: %d", err);
+		return -ENOMEM;
+	}
+
+	/* Flash writes must be aligned, the record buffer is large enough to
+	 * be padded.
+	 */
+	err = flash_area_write(flash_fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc),
+			       record, ROUND_UP(len, flash_fcb.f_align));
+	if (err) {
+		LOG_ERR("Failed to write to flash, error: %d", err);
+		return -EIO;
+	}
+
+	err = fcb_append_finish(&flash_fcb, &loc);
+	if (err) {
+		LOG_ERR("Failed to finish flash append, error: %d", err);
+		return -EIO;
+	}
+
+	flash_count++;
+
+	return 0;
+}
+
+static void flash_consume(void)
+{
+	if (fcb_getnext(&flash_fcb, &flash_rd_loc)) {
+		return;
+	}
+
+	flash_count--;
+
+	/* Erase the sectors that have been consumed completely. The sector of
+	 * the last consumed entry is kept, also if the buffer is empty, so
+	 * that new entries are appended after it instead of erasing it on
+	 * every drain.
+	 */
+	while (flash_fcb.f_oldest != flash_rd_loc.fe_sector) {
+		if (fcb_rotate(&flash_fcb)) {
+			break;
+		}
+	}
+}
+
+static int flash_init(void)
+{
+	struct fcb_entry loc = { 0 };
+	uint32_t sector_cnt = ARRAY_SIZE(flash_sectors);
+	int err;
+
+	err = flash_area_get_sectors(PM_CLOUD_OUTBOX_ID, &sector_cnt,
+				     flash_sectors);
+	if (err) {
+		LOG_ERR("Failed to get flash sectors, error: %d", err);
+		return err;
+	}
+
+	flash_fcb.f_magic = FCB_MAGIC;
+	flash_fcb.f_version = 1;
+	flash_fcb.f_sectors = flash_sectors;
+	flash_fcb.f_sector_cnt = sector_cnt;
+	flash_fcb.f_scratch_cnt = 0;
+
+	err = fcb_init(PM_CLOUD_OUTBOX_ID, &flash_fcb);
+	if (err) {
+		LOG_ERR("Failed to initialize flash buffer, error: %d", err);
+		return err;
+	}
+
+	while (fcb_getnext(&flash_fcb, &loc) == 0) {
+		flash_count++;
+	}
+
+	LOG_DBG("%d messages found in flash", (int)flash_count);
+
+	return 0;
+}
+#endif /* defined(CONFIG_CLOUD_OUTBOX_FLASH) */
+
+static size_t pending_count(void)
+{
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+	return ram_count + flash_count;
+#else
+	return ram_count;
+#endif
+}
+
+static int record_store(const struct cloud_msg *const msg)
+{
+	struct record_hdr *hdr = (struct record_hdr *)record_buf;
+	size_t ep_len = msg->endpoint.str ? msg->endpoint.len : 0;
+	size_t len;
+	int err;
+
+	if ((msg->len > MSG_MAX_LEN) || (ep_len > EP_MAX_LEN)) {
+		return -EMSGSIZE;
+	}
+
+	hdr->len = msg->len;
+	hdr->ep_type = msg->endpoint.type;
+	hdr->qos = msg->qos;
+	hdr->ep_len = ep_len;
+
+	if (ep_len) {
+		memcpy(&record_buf[sizeof(*hdr)], msg->endpoint.str, ep_len);
+	}
+
+	if (msg->len) {
+		memcpy(&record_buf[sizeof(*hdr) + ep_len], msg->buf, msg->len);
+	}
+
+	len = record_len(hdr);
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+	/* Records stay in order as long as RAM is only used while there are
+	 * no records in flash.
+	 */
+	err = -ENOMEM;
+
+	if (flash_count == 0) {
+		err = ram_store(record_buf, len);
+	}
+
+	if (err) {
+		err = flash_store(record_buf, len);
+	}
+#else
+	err = ram_store(record_buf, len);
+#endif
+
+	if (err == 0) {
+		stats.stored++;
+	}
+
+	return err;
+}
+
+/* Read the record following the iterator into record_buf. */
+static int record_next(struct record_iter *it, struct record_hdr *hdr)
+{
+	if (it->ram_idx < ram_count) {
+		ram_read(it->ram_off, hdr, sizeof(*hdr));
+		ram_read(ram_offset(it->ram_off, sizeof(*hdr)),
+			 &record_buf[sizeof(*hdr)], hdr->ep_len + hdr->len);
+
+		it->ram_off = ram_offset(it->ram_off, record_len(hdr));
+		it->ram_idx++;
+
+		return 0;
+	}
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+	if (fcb_getnext(&flash_fcb, &it->loc) == 0) {
+		int err;
+
+		if (it->loc.fe_data_len > sizeof(record_buf)) {
+			return -EFAULT;
+		}
+
+		err = flash_area_read(flash_fcb.fap,
+				      FCB_ENTRY_FA_DATA_OFF(it->loc),
+				      record_buf, it->loc.fe_data_len);
+		if (err) {
+			return err;
+		}
+
+		memcpy(hdr, record_buf, sizeof(*hdr));
+
+		if (record_len(hdr) != it->loc.fe_data_len) {
+			return -EFAULT;
+		}
+
+		return 0;
+	}
+#endif
+
+	return -ENOENT;
+}
+
+static void records_consume(size_t count)
+{
+	while (count--) {
+		if (ram_count > 0) {
+			ram_drop_oldest();
+			continue;
+		}
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+		flash_consume();
+#endif
+	}
+}
+
+/* Only JSON objects are batched, since the payload format is not known to
+ * the outbox. Other payloads, for example CBOR, are sent as they are.
+ */
+static bool json_object_is(const uint8_t *buf, size_t len)
+{
+	return (len >= 2) && (buf[0] == '{') && (buf[len - 1] == '}');
+}
+
+static bool record_batchable(const struct record_hdr *first,
+			     const struct record_hdr *hdr)
+{
+	return (hdr->ep_type == first->ep_type) &&
+	       (hdr->qos == first->qos) &&
+	       (hdr->ep_len == first->ep_len) &&
+	       (memcmp(&record_buf[sizeof(*hdr)], tx_ep, hdr->ep_len) == 0) &&
+	       json_object_is(&record_buf[sizeof(*hdr) + hdr->ep_len],
+			      hdr->len);
+}
+
+/* Build a publication from the oldest records. Returns the number of records
+ * in the publication, or a negative error code.
+ */
+static int publication_build(struct cloud_msg *msg)
+{
+	struct record_iter it = {
+		.ram_off = ram_tail,
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+		.loc = flash_rd_loc,
+#endif
+	};
+	struct record_hdr first, hdr;
+	size_t len;
+	int count = 1;
+	int err;
+
+	err = record_next(&it, &first);
+	if (err) {
+		return err;
+	}
+
+	memcpy(tx_ep, &record_buf[sizeof(first)], first.ep_len);
+	tx_ep[first.ep_len] = '\0';
+
+	/* Leave room for the opening bracket of a batch. */
+	memcpy(&tx_buf[1], &record_buf[sizeof(first) + first.ep_len],
+	       first.len);
+	len = 1 + first.len;
+
+	while (IS_ENABLED(CONFIG_CLOUD_OUTBOX_BATCH) &&
+	       (first.ep_type == CLOUD_EP_MSG) &&
+	       json_object_is(&tx_buf[1], first.len) &&
+	       (record_next(&it, &hdr) == 0)) {
+		/* Room is needed for the separator and the closing bracket. */
+		if (!record_batchable(&first, &hdr) ||
+		    (len + 1 + hdr.len + 1 > MSG_MAX_LEN)) {
+			break;
+		}
+
+		tx_buf[len++] = ',';
+		memcpy(&tx_buf[len], &record_buf[sizeof(hdr) + hdr.ep_len],
+		       hdr.len);
+		len += hdr.len;
+		count++;
+	}
+
+	if (count > 1) {
+		tx_buf[0] = '[';
+		tx_buf[len++] = ']';
+		msg->buf = (char *)tx_buf;
+		msg->len = len;
+	} else {
+		msg->buf = (char *)&tx_buf[1];
+		msg->len = len - 1;
+	}
+
+	msg->qos = first.qos;
+	msg->endpoint.type = first.ep_type;
+	msg->endpoint.str = first.ep_len ? tx_ep : NULL;
+	msg->endpoint.len = first.ep_len;
+
+	return count;
+}
+
+static void drain_work_fn(struct k_work *work)
+{
+	struct cloud_msg msg;
+	int count;
+	int err;
+
+	while (atomic_get(&outbox_ready)) {
+		k_mutex_lock(&outbox_lock, K_FOREVER);
+
+		count = publication_build(&msg);
+		if (count == -ENOENT) {
+			k_mutex_unlock(&outbox_lock);
+			break;
+		} else if (count < 0) {
+			LOG_ERR("Stored message corrupted, error: %d", count);
+			records_consume(1);
+			stats.dropped++;
+			k_mutex_unlock(&outbox_lock);
+			continue;
+		}
+
+		inflight_count = count;
+		k_mutex_unlock(&outbox_lock);
+
+		LOG_DBG("Sending %d stored messages, %d bytes", count,
+			(int)msg.len);
+
+		err = cloud_send(outbox_backend, &msg);
+
+		k_mutex_lock(&outbox_lock, K_FOREVER);
+		inflight_count = 0;
+
+		if ((err == -EMSGSIZE) || (err == -EINVAL)) {
+			LOG_WRN("Stored messages rejected, error: %d", err);
+			records_consume(count);
+			stats.dropped += count;
+		} else if (err == 0) {
+			records_consume(count);
+			stats.sent += count;
+			stats.publications++;
+		}
+
+		k_mutex_unlock(&outbox_lock);
+
+		if ((err != 0) && (err != -EMSGSIZE) && (err != -EINVAL)) {
+			retry_delay_ms = (retry_delay_ms == 0) ?
+				CONFIG_CLOUD_OUTBOX_RETRY_MIN_MS :
+				MIN(2 * retry_delay_ms,
+				    CONFIG_CLOUD_OUTBOX_RETRY_MAX_MS);
+
+			/* Also retried right away on the next ready event. */
+			LOG_WRN("Failed to send stored messages, error: %d, "
+				"retrying in %d ms", err, retry_delay_ms);
+			k_delayed_work_submit_to_queue(&outbox_work_q,
+						       &drain_work,
+						       K_MSEC(retry_delay_ms));
+			break;
+		}
+
+		retry_delay_ms = 0;
+	}
+}
+
+int cloud_outbox_send(const struct cloud_msg *const msg)
+{
+	bool empty;
+	int err;
+
+	if ((outbox_backend == NULL) || (msg == NULL) ||
+	    ((msg->buf == NULL) && (msg->len != 0))) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+	empty = (pending_count() == 0);
+	k_mutex_unlock(&outbox_lock);
+
+	if (empty && atomic_get(&outbox_ready) &&
+	    (CONFIG_CLOUD_OUTBOX_HOLD_TIME_MS == 0)) {
+		err = cloud_send(outbox_backend, (struct cloud_msg *)msg);
+		if (err == 0) {
+			return 0;
+		}
+
+		LOG_WRN("Failed to send message, storing it, error: %d", err);
+	}
+
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+	err = record_store(msg);
+	if (err) {
+		stats.dropped++;
+	}
+	k_mutex_unlock(&outbox_lock);
+
+	if (err) {
+		LOG_ERR("Failed to store message, error: %d", err);
+		return err;
+	}
+
+	if (atomic_get(&outbox_ready)) {
+		/* Does not restart the timer if already pending, so the hold
+		 * time is counted from the oldest stored message.
+		 */
+		if (k_delayed_work_remaining_get(&drain_work) == 0) {
+			k_delayed_work_submit_to_queue(&outbox_work_q,
+				&drain_work,
+				K_MSEC(CONFIG_CLOUD_OUTBOX_HOLD_TIME_MS));
+		}
+	}
+
+	return 0;
+}
+
+void cloud_outbox_event_notify(const struct cloud_event *const evt)
+{
+	if ((outbox_backend == NULL) || (evt == NULL)) {
+		return;
+	}
+
+	switch (evt->type) {
+	case CLOUD_EVT_READY:
+		atomic_set(&outbox_ready, 1);
+		(void)cloud_outbox_flush();
+		break;
+	case CLOUD_EVT_DISCONNECTED:
+		atomic_set(&outbox_ready, 0);
+		break;
+	default:
+		break;
+	}
+}
+
+int cloud_outbox_flush(void)
+{
+	if (outbox_backend == NULL) {
+		return -ENOENT;
+	}
+
+	return k_delayed_work_submit_to_queue(&outbox_work_q, &drain_work,
+					      K_NO_WAIT);
+}
+
+void cloud_outbox_stats_get(struct cloud_outbox_stats *out)
+{
+	k_mutex_lock(&outbox_lock, K_FOREVER);
+	stats.pending = pending_count();
+	*out = stats;
+	k_mutex_unlock(&outbox_lock);
+}
+
+int cloud_outbox_init(const struct cloud_backend *const backend)
+{
+	if (backend == NULL) {
+		return -EINVAL;
+	}
+
+	if (outbox_backend != NULL) {
+		return -EALREADY;
+	}
+
+#if defined(CONFIG_CLOUD_OUTBOX_FLASH)
+	int err = flash_init();
+
+	if (err) {
+		return err;
+	}
+#endif
+
+	k_work_q_start(&outbox_work_q, outbox_stack,
+		       K_THREAD_STACK_SIZEOF(outbox_stack),
+		       K_PRIO_PREEMPT(CONFIG_CLOUD_OUTBOX_THREAD_PRIO));
+	k_thread_name_set(&outbox_work_q.thread, "cloud_outbox");
+	k_delayed_work_init(&drain_work, drain_work_fn);
+
+	outbox_backend = backend;
+
+	return 0;
+}
@@ -14,402 +14,354 @@
 
 LOG_MODULE_REGISTER(icalendar_parser, CONFIG_ICAL_PARSER_LOG_LEVEL);
 
-static size_t unfold_contentline(const char *buf, char *prop_buf)
-{
-	size_t unfold_size = 0;
-	const char *sol = buf;
-	char *eol;
-	uint16_t total_line_len = 0, single_line_len = 0;
-
-	while (1) {
-		eol = strstr(sol, "\r\n");
-		if (!eol) {
-			return 0;
-		}
-		single_line_len = eol - sol;
-		if ((total_line_len + single_line_len)
-		    <= CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE) {
-			memcpy(prop_buf +
-			       total_line_len, sol, single_line_len);
-			total_line_len += single_line_len;
-		} else {
-			LOG_DBG("Property value overflow."
-				"Increase CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE.");
-			return 0;
-		}
-		if (!strncmp(eol, "\r\n ", strlen("\r\n "))) {
-			/* Long content line is split into multiple lines.
-			 * Copy the folded part to unfolded buffer.
-			 */
-			sol = eol + strlen("\r\n ");
-		} else {
-			/* Content line is delimited. Count parsed bytes */
-			unfold_size = eol - buf;
-			break;
-		}
-	}
-	prop_buf[unfold_size] = '\0';
+/* The data is parsed one character at a time, so that it can be split at
+ * any point. Only the name of the current property and the component being
+ * parsed are stored. The values of the properties that are not reported are
+ * skipped without being stored.
+ *
+ * Reference: RFC 5545 3.1 Content Lines
+ */
 
-	return unfold_size;
+/* Object in which the current content line is. */
+enum ical_object {
+	/* Before BEGIN:VCALENDAR */
+	ICAL_OBJECT_NONE,
+	/* Calendar properties, or between components */
+	ICAL_OBJECT_CALENDAR,
+	/* Calendar component */
+	ICAL_OBJECT_COMPONENT,
+	/* Component which is not reported */
+	ICAL_OBJECT_UNKNOWN,
+};
+
+/* Part of the content line being parsed. */
+enum ical_line {
+	ICAL_LINE_NAME,
+	ICAL_LINE_PARAM,
+	ICAL_LINE_VALUE,
+	ICAL_LINE_SKIP,
+};
+
+/* Property of the current content line. */
+enum ical_prop {
+	ICAL_PROP_NONE,
+	ICAL_PROP_BEGIN,
+	ICAL_PROP_END,
+	ICAL_PROP_SUMMARY,
+	ICAL_PROP_LOCATION,
+	ICAL_PROP_DESCRIPTION,
+	ICAL_PROP_DTSTART,
+	ICAL_PROP_DTEND,
+};
+
+struct ical_prop_info {
+	const char *name;
+	enum ical_parser_error_id error;
+	/* Whether the value can follow property parameters. */
+	bool param;
+	size_t offset;
+	size_t max_len;
+};
+
+#define VEVENT_PROP(_name, _field, _param) {				\
+	.name = #_name,							\
+	.error = ICAL_ERROR_##_name,					\
+	.param = _param,						\
+	.offset = offsetof(struct ical_parser_evt, ical_com._field),	\
+	.max_len = CONFIG_ICAL_PARSER_##_name##_SIZE,			\
 }
 
-static bool parse_desc_props(const char *buf,
-			     const char *name,
-			     size_t name_size,
-			     char *value,
-			     size_t max_value_len)
+static const struct ical_prop_info vevent_props[] = {
+	[ICAL_PROP_SUMMARY] = VEVENT_PROP(SUMMARY, summary, false),
+	[ICAL_PROP_LOCATION] = VEVENT_PROP(LOCATION, location, false),
+	[ICAL_PROP_DESCRIPTION] = VEVENT_PROP(DESCRIPTION, description, false),
+	[ICAL_PROP_DTSTART] = VEVENT_PROP(DTSTART, dtstart, true),
+	[ICAL_PROP_DTEND] = VEVENT_PROP(DTEND, dtend, true),
+};
+
+static const struct {
+	const char *name;
+	enum ical_parser_evt_id id;
+} components[] = {
+	{ "VEVENT", ICAL_EVT_VEVENT },
+	{ "VTODO", ICAL_EVT_VTODO },
+	{ "VJOURNAL", ICAL_EVT_VJOURNAL },
+	{ "VFREEBUSY", ICAL_EVT_VFREEBUSY },
+	{ "VTIMEZONE", ICAL_EVT_VTIMEZONE },
+};
+
+static bool name_is(const struct icalendar_parser *ical, const char *name)
 {
-	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s no value/param.", name);
-		return false;
-	}
-
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
-
-		if (value_len <= max_value_len) {
-			memcpy(value,
-				ical_prop_buf + name_size + 1,
-				value_len);
-			value[value_len] = '\0';
-			ret = true;
-		} else {
-			/* Property value overflow. */
-			LOG_ERR("%s value overflow.", name);
-			ret = false;
-		}
-	} else if (ical_prop_buf[name_size] == ';') {
-		/* Does not support property parameter. */
-		LOG_ERR("%s param not supported.", name);
-		ret = false;
-	} else {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s wrong format.", name);
-		ret = false;
-	}
-
-	return ret;
+	return (ical->name_len <= ICAL_PARSER_NAME_SIZE) &&
+	       !strcasecmp(ical->name, name);
 }
 
-static bool parse_datetime_props(const char *buf,
-				 const char *name,
-				 size_t name_size,
-				 char *value,
-				 size_t max_value_len)
+static void prop_error(struct icalendar_parser *ical, const char *reason)
 {
-	bool ret;
-	size_t unfold_size;
-	char ical_prop_buf[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
-
-	unfold_size = unfold_contentline(buf, ical_prop_buf);
-	if (unfold_size <= 0) {
-		/* Property wrong format - fail to unfold property. */
-		LOG_ERR("%s wrong format. Fail to unfold property", name);
-		return false;
-	}
+	const struct ical_prop_info *info = &vevent_props[ical->prop];
 
-	if (ical_prop_buf[name_size] == ':') {
-		size_t value_len = unfold_size - name_size - 1;
+	LOG_ERR("%s %s.", info->name, reason);
 
-		if (value_len <= max_value_len) {
-			memcpy(value,
-				ical_prop_buf + name_size + 1,
-				value_len);
-			value[value_len] = '\0';
-			ret = true;
-		} else {
-			/* Property value overflow. */
-			LOG_ERR("%s value overflow.", name);
-			ret = false;
-		}
-	} else if (ical_prop_buf[name_size] == ';') {
-		char *dtvalue;
-
-		dtvalue = strchr(ical_prop_buf, ':');
-		if (dtvalue) {
-			dtvalue = dtvalue + 1;
-			size_t value_len;
-
-			value_len = unfold_size -
-					(dtvalue - ical_prop_buf);
-			if (value_len <= max_value_len) {
-				memcpy(value, dtvalue, value_len);
-				value[value_len] = '\0';
-				ret = true;
-			} else {
-				/* Property value overflow. */
-				LOG_ERR("%s value overflow.", name);
-				ret = false;
-			}
-		} else {
-			/* Property wrong format - no value. */
-			LOG_ERR("%s wrong format - no value.", name);
-			ret = false;
-		}
-	} else {
-		/* Property wrong format - no parameter or value. */
-		LOG_ERR("%s wrong format.", name);
-		ret = false;
-	}
+	ical->evt.error = info->error;
+	ical->line = ICAL_LINE_SKIP;
+}
 
-	return ret;
+static char *prop_value(struct icalendar_parser *ical)
+{
+	return (char *)&ical->evt + vevent_props[ical->prop].offset;
 }
 
-static size_t parse_calprops(const char *buf)
+static bool vevent_props_parsed(const struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *end = NULL;
-	char prop_value[CONFIG_ICAL_PARSER_MAX_PROPERTY_SIZE + 1];
+	/* Properties of nested components, such as VALARM, are skipped. The
+	 * properties after an error are skipped as well.
+	 */
+	return (ical->object == ICAL_OBJECT_COMPONENT) &&
+	       (ical->evt.id == ICAL_EVT_VEVENT) && (ical->depth == 0) &&
+	       (ical->evt.error == ICAL_ERROR_NONE);
+}
 
-	parsed = strstr(parsed, "BEGIN:VCALENDAR\r\n");
-	if (parsed == NULL) {
-		return 0;
+/* Find the reported property with the current name. */
+static enum ical_prop prop_find(const struct icalendar_parser *ical)
+{
+	if (!vevent_props_parsed(ical)) {
+		return ICAL_PROP_NONE;
 	}
-	parsed += strlen("BEGIN:VCALENDAR\r\n");
 
-	end = strstr(parsed, "\r\nBEGIN:");
-	if (end == NULL) {
-		return 0;
-	}
-	end += strlen("\r\n");
-
-	while (parsed < end) {
-		memset(prop_value, 0, sizeof(prop_value));
-		if (!strncmp(parsed, "PRODID", 6)) {
-			if (!parse_desc_props(parsed, "PRODID", 6,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong PRODID");
-			}
-		} else if (!strncmp(parsed, "VERSION", 7)) {
-			if (!parse_desc_props(parsed, "VERSION", 7,
-					prop_value, sizeof(prop_value))) {
-				LOG_ERR("Wrong VERSION");
-			}
+	for (size_t i = ICAL_PROP_SUMMARY; i < ARRAY_SIZE(vevent_props); i++) {
+		if (name_is(ical, vevent_props[i].name)) {
+			return i;
 		}
-		parsed = strstr(parsed, "\r\n");
-		parsed += strlen("\r\n");
 	}
 
-	return (parsed - buf);
+	return ICAL_PROP_NONE;
 }
 
-static size_t parse_eventprop(const char *buf,
-			      struct ical_parser_evt *evt)
+/* Called at the end of the property name, at the first ':' or ';'. */
+static void name_end(struct icalendar_parser *ical, char delim)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	if (strncmp(buf, "BEGIN:VEVENT\r\n", strlen("BEGIN:VEVENT\r\n"))) {
-		return 0;
+	ical->name[MIN(ical->name_len, ICAL_PARSER_NAME_SIZE)] = '\0';
+	ical->line = ICAL_LINE_SKIP;
+
+	if (name_is(ical, "BEGIN") || name_is(ical, "END")) {
+		ical->prop = name_is(ical, "BEGIN") ?
+			     ICAL_PROP_BEGIN : ICAL_PROP_END;
+		if (delim == ':') {
+			/* The value is stored in place of the name. */
+			ical->name_len = 0;
+			ical->line = ICAL_LINE_VALUE;
+		}
+		return;
 	}
 
-	com_end = strstr(buf, "END:VEVENT\r\n");
-	if (com_end == NULL) {
-		return 0;
+	ical->prop = prop_find(ical);
+	if (ical->prop == ICAL_PROP_NONE) {
+		return;
 	}
 
-	evt->id = ICAL_EVT_VEVENT;
-	evt->error = ICAL_ERROR_NONE;
-	com_end += strlen("END:VEVENT\r\n");
-	while (parsed < com_end) {
-		if (!strncasecmp(parsed, "SUMMARY", 7)) {
-			if (!parse_desc_props(
-				parsed, "SUMMARY", 7,
-				evt->ical_com.summary,
-				CONFIG_ICAL_PARSER_SUMMARY_SIZE)) {
-				evt->error = ICAL_ERROR_SUMMARY;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "LOCATION", 8)) {
-			if (!parse_desc_props(
-				parsed, "LOCATION", 8,
-				evt->ical_com.location,
-				CONFIG_ICAL_PARSER_LOCATION_SIZE)) {
-				evt->error = ICAL_ERROR_LOCATION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DESCRIPTION", 11)) {
-			if (!parse_desc_props(
-				parsed, "DESCRIPTION", 11,
-				evt->ical_com.description,
-				CONFIG_ICAL_PARSER_DESCRIPTION_SIZE)) {
-				evt->error = ICAL_ERROR_DESCRIPTION;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed, "DTSTART", 7)) {
-			if (!parse_datetime_props(
-				parsed, "DTSTART", 7,
-				evt->ical_com.dtstart,
-				CONFIG_ICAL_PARSER_DTSTART_SIZE)) {
-				evt->error = ICAL_ERROR_DTSTART;
-				parsed = com_end;
-			}
-		} else if (!strncasecmp(parsed,
-					"DTEND", 5)) {
-			if (!parse_datetime_props(
-				parsed, "DTEND", 5,
-				evt->ical_com.dtend,
-				CONFIG_ICAL_PARSER_DTEND_SIZE)) {
-				evt->error = ICAL_ERROR_DTEND;
-				parsed = com_end;
-			}
-		}
+	ical->value_len = 0;
+	prop_value(ical)[0] = '\0';
 
-		/* Move parsed pointer to end of line break */
-		parsed = strstr(parsed, "\r\n") + 2;
+	if (delim == ':') {
+		ical->line = ICAL_LINE_VALUE;
+	} else if (vevent_props[ical->prop].param) {
+		/* The parameters are skipped. */
+		ical->line = ICAL_LINE_PARAM;
+	} else {
+		prop_error(ical, "param not supported");
 	}
-
-	return parsed - buf;
 }
 
-static size_t parse_todoprop(const char *buf,
-				struct ical_parser_evt *evt)
+static void component_begin(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
-
-	com_end = strstr(buf, "END:VTODO\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTODO\r\n");
+	memset(&ical->evt, 0, sizeof(ical->evt));
+	ical->depth = 0;
+	ical->object = ICAL_OBJECT_UNKNOWN;
+
+	for (size_t i = 0; i < ARRAY_SIZE(components); i++) {
+		if (name_is(ical, components[i].name)) {
+			ical->evt.id = components[i].id;
+			ical->object = ICAL_OBJECT_COMPONENT;
+			break;
+		}
 	}
-	evt->id = ICAL_EVT_VTODO;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
-
-	return parsed - buf;
-}
-
-static size_t parse_jourprop(const char *buf,
-				struct ical_parser_evt *evt)
-{
-	const char *parsed = buf;
-	char *com_end;
 
-	com_end = strstr(buf, "END:VJOURNAL\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VJOURNAL\r\n");
+	if ((ical->object == ICAL_OBJECT_COMPONENT) &&
+	    (ical->evt.id != ICAL_EVT_VEVENT)) {
+		ical->evt.error = ICAL_ERROR_COM_NOT_SUPPORTED;
 	}
-	evt->id = ICAL_EVT_VJOURNAL;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
-
-	return parsed - buf;
 }
 
-static size_t parse_fbprop(const char *buf, struct ical_parser_evt *evt)
+static void component_end(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
+	bool report = (ical->object == ICAL_OBJECT_COMPONENT);
 
-	com_end = strstr(buf, "END:VFREEBUSY\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VFREEBUSY\r\n");
-	}
-	evt->id = ICAL_EVT_VFREEBUSY;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
+	ical->object = ICAL_OBJECT_CALENDAR;
 
-	return parsed - buf;
+	if (report && ical->callback(&ical->evt)) {
+		LOG_DBG("Parsing stopped by the application");
+		ical->stopped = true;
+	}
 }
 
-static size_t parse_tzprop(const char *buf, struct ical_parser_evt *evt)
+/* Called at the end of an unfolded content line. */
+static void line_end(struct icalendar_parser *ical)
 {
-	const char *parsed = buf;
-	char *com_end;
+	bool begin = (ical->prop == ICAL_PROP_BEGIN);
 
-	com_end = strstr(buf, "END:VTIMEZONE\r\n");
-	if (com_end) {
-		parsed = com_end + strlen("END:VTIMEZONE\r\n");
+	if (ical->prop >= ICAL_PROP_SUMMARY) {
+		if (ical->line == ICAL_LINE_VALUE) {
+			prop_value(ical)[ical->value_len] = '\0';
+		} else if (ical->line == ICAL_LINE_PARAM) {
+			prop_error(ical, "wrong format - no value");
+		}
+	} else if (ical->line == ICAL_LINE_NAME) {
+		/* A property without any ':' or ';'. */
+		ical->name[MIN(ical->name_len, ICAL_PARSER_NAME_SIZE)] = '\0';
+		ical->prop = prop_find(ical);
+		if (ical->prop != ICAL_PROP_NONE) {
+			prop_error(ical, "wrong format");
+		}
+	} else if ((ical->line == ICAL_LINE_VALUE) &&
+		   ((ical->prop == ICAL_PROP_BEGIN) ||
+		    (ical->prop == ICAL_PROP_END))) {
+		ical->name[MIN(ical->name_len, ICAL_PARSER_NAME_SIZE)] = '\0';
+
+		switch (ical->object) {
+		case ICAL_OBJECT_NONE:
+			/* Reference: RFC 5545 3.4 iCalendar Object */
+			if (begin && name_is(ical, "VCALENDAR")) {
+				LOG_DBG("Found a calendar stream");
+				ical->object = ICAL_OBJECT_CALENDAR;
+			}
+			break;
+		case ICAL_OBJECT_CALENDAR:
+			/* Reference: RFC 5545 3.6 Calendar Components */
+			if (begin) {
+				component_begin(ical);
+			} else if (name_is(ical, "VCALENDAR")) {
+				ical->object = ICAL_OBJECT_NONE;
+			}
+			break;
+		case ICAL_OBJECT_COMPONENT:
+		case ICAL_OBJECT_UNKNOWN:
+			if (begin) {
+				ical->depth++;
+			} else if (ical->depth > 0) {
+				ical->depth--;
+			} else {
+				component_end(ical);
+			}
+			break;
+		}
 	}
-	evt->id = ICAL_EVT_VTIMEZONE;
-	evt->error = ICAL_ERROR_COM_NOT_SUPPORTED;
 
-	return parsed - buf;
+	ical->line = ICAL_LINE_NAME;
+	ical->prop = ICAL_PROP_NONE;
+	ical->name_len = 0;
 }
 
-static size_t parse_component(char *buf, struct ical_parser_evt *evt)
+static void value_add(struct icalendar_parser *ical, char c)
 {
-	char *com_begin = buf;
-	size_t ret = 0;
-
-	/* Search begin of component */
-	if (!strncmp(com_begin, "BEGIN:VEVENT\r\n", 14)) {
-		ret += parse_eventprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTODO\r\n", 13)) {
-		ret += parse_todoprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VJOURNAL\r\n", 16)) {
-		ret += parse_jourprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VFREEBUSY\r\n", 17)) {
-		ret += parse_fbprop(com_begin, evt);
-	} else if (!strncmp(com_begin, "BEGIN:VTIMEZONE\r\n", 17)) {
-		ret += parse_tzprop(com_begin, evt);
+	if ((ical->prop == ICAL_PROP_BEGIN) || (ical->prop == ICAL_PROP_END)) {
+		if (ical->name_len < ICAL_PARSER_NAME_SIZE) {
+			ical->name[ical->name_len] = c;
+		}
+		/* A name which does not fit matches nothing. */
+		ical->name_len = MIN(ical->name_len + 1,
+				     ICAL_PARSER_NAME_SIZE + 1);
+	} else if (ical->value_len < vevent_props[ical->prop].max_len) {
+		prop_value(ical)[ical->value_len++] = c;
+	} else {
+		prop_value(ical)[0] = '\0';
+		prop_error(ical, "value overflow");
 	}
-
-	return ret;
 }
 
-static size_t parse_icalbody(char *buf,
-				icalendar_parser_callback_t callback)
+static void char_parse(struct icalendar_parser *ical, char c)
 {
-	size_t parsed_bytes = 0, parsed_offset = 0;
-
-	do {
-		struct ical_parser_evt evt;
-
-		parsed_bytes = parse_component(buf + parsed_offset, &evt);
-		parsed_offset += parsed_bytes;
-		if (parsed_bytes > 0) {
-			callback(&evt);
+	switch (ical->line) {
+	case ICAL_LINE_NAME:
+		if ((c == ':') || (c == ';')) {
+			name_end(ical, c);
+		} else {
+			if (ical->name_len < ICAL_PARSER_NAME_SIZE) {
+				ical->name[ical->name_len] = c;
+			}
+			ical->name_len = MIN(ical->name_len + 1,
+					     ICAL_PARSER_NAME_SIZE + 1);
 		}
-	} while (parsed_bytes > 0);
-
-	return parsed_offset;
+		break;
+	case ICAL_LINE_PARAM:
+		if (c == ':') {
+			ical->line = ICAL_LINE_VALUE;
+		}
+		break;
+	case ICAL_LINE_VALUE:
+		value_add(ical, c);
+		break;
+	case ICAL_LINE_SKIP:
+		break;
+	}
 }
 
 size_t ical_parser_parse(struct icalendar_parser *ical,
 			const char *data, size_t len)
 {
-	size_t parsed_offset = 0;
+	size_t i;
 
-	if (CONFIG_ICAL_PARSER_BUFFER_SIZE < (ical->offset + len)) {
-		return -ENOBUFS;
-	}
+	for (i = 0; (i < len) && !ical->stopped; i++) {
+		char c = data[i];
 
-	memcpy(ical->buf + ical->offset, data, len);
-	ical->buf[ical->offset + len] = '\0';
+		if (ical->line_break) {
+			ical->line_break = false;
 
-	/* Check begin of iCalendar object delimiter
-	 * Reference: RFC 5545 3.4 iCalendar Object
-	 */
-	if (!ical->icalobject_begin) {
-		/* The body of the iCalendar object consists of
-		 * a sequence of calendar properties and
-		 * one or more calendar components.
-		 *
-		 * Reference: RFC 5545 3.6 Calendar Components
-		 */
-		parsed_offset += parse_calprops(ical->buf);
-		if (parsed_offset > 0) {
-			LOG_DBG("Found a calendar stream");
-			ical->icalobject_begin = true;
+			/* A line break followed by a white space is a fold
+			 * within a long content line.
+			 *
+			 * Reference: RFC 5545 3.1 Content Lines
+			 */
+			if ((c == ' ') || (c == '\t')) {
+				continue;
+			}
+
+			line_end(ical);
+			if (ical->stopped) {
+				break;
+			}
+		}
+
+		if (c == '\r') {
+			continue;
+		} else if (c == '\n') {
+			ical->line_break = true;
+		} else {
+			char_parse(ical, c);
 		}
 	}
 
-	/* If we got a calendar property, start parsing calendar body. */
-	if (ical->icalobject_begin) {
-		parsed_offset += parse_icalbody(ical->buf + parsed_offset,
-						ical->callback);
+	return i;
+}
+
+int ical_parser_finish(struct icalendar_parser *ical)
+{
+	if (ical == NULL) {
+		return -EINVAL;
 	}
 
-	if (parsed_offset) {
-		ical->offset = ical->offset + len - parsed_offset;
-		memcpy(ical->buf, ical->buf + parsed_offset, ical->offset);
+	/* The last content line may be terminated by the end of the stream
+	 * instead of a line break, so there is no following line to tell
+	 * that it is complete.
+	 */
+	if (!ical->stopped &&
+	    (ical->line_break || (ical->line != ICAL_LINE_NAME) ||
+	     (ical->name_len > 0))) {
+		line_end(ical);
 	}
 
-	return parsed_offset;
+	ical->line_break = false;
+
+	return 0;
 }
 
 int ical_parser_init(struct icalendar_parser *ical,
@@ -419,9 +371,11 @@ int ical_parser_init(struct icalendar_parser *ical,
 		return -EINVAL;
 	}
 
+	memset(ical, 0, sizeof(*ical));
 	ical->callback = callback;
-	ical->icalobject_begin = false;
-	ical->offset = 0;
+	ical->object = ICAL_OBJECT_NONE;
+	ical->line = ICAL_LINE_NAME;
+	ical->prop = ICAL_PROP_NONE;
 
 	return 0;
 }
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <net/mqtt_topic_router.h>
+
+#define ROOT_NODE 0
+
+#define LEVEL_SEPARATOR '/'
+#define WILDCARD_SINGLE '+'
+#define WILDCARD_MULTI  '#'
+
+/* Topic level iterator. The level pointed to by *pos is returned in
+ * level/len, and *pos is advanced past the following separator.
+ * When the last level has been returned, *pos is set to NULL.
+ */
+static void level_next(const char **pos, const char *end,
+		       const char **level, size_t *len)
+{
+	const char *sep = memchr(*pos, LEVEL_SEPARATOR, end - *pos);
+
+	*level = *pos;
+
+	if (sep == NULL) {
+		*len = end - *pos;
+		*pos = NULL;
+	} else {
+		*len = sep - *pos;
+		*pos = sep + 1;
+	}
+}
+
+static bool level_is(const char *level, size_t len, char c)
+{
+	return (len == 1) && (level[0] == c);
+}
+
+static void node_init(struct mqtt_topic_router_node *node,
+		      const char *level, size_t len)
+{
+	node->level = level;
+	node->level_len = len;
+	node->child = MQTT_TOPIC_ROUTER_NONE;
+	node->sibling = MQTT_TOPIC_ROUTER_NONE;
+	node->plus = MQTT_TOPIC_ROUTER_NONE;
+	node->route = NULL;
+	node->hash = NULL;
+}
+
+static int node_alloc(struct mqtt_topic_router *router,
+		      const char *level, size_t len)
+{
+	if (router->nodes_used >= router->node_count) {
+		return -ENOMEM;
+	}
+
+	node_init(&router->nodes[router->nodes_used], level, len);
+
+	return router->nodes_used++;
+}
+
+/* Find the literal child of a node matching the given level. */
+static uint16_t child_find(const struct mqtt_topic_router *router,
+			   uint16_t parent, const char *level, size_t len)
+{
+	uint16_t idx = router->nodes[parent].child;
+
+	while (idx != MQTT_TOPIC_ROUTER_NONE) {
+		const struct mqtt_topic_router_node *node = &router->nodes[idx];
+
+		if ((node->level_len == len) &&
+		    (memcmp(node->level, level, len) == 0)) {
+			return idx;
+		}
+
+		idx = node->sibling;
+	}
+
+	return MQTT_TOPIC_ROUTER_NONE;
+}
+
+int mqtt_topic_router_reset(struct mqtt_topic_router *router)
+{
+	if ((router == NULL) || (router->nodes == NULL) ||
+	    (router->node_count == 0)) {
+		return -EINVAL;
+	}
+
+	node_init(&router->nodes[ROOT_NODE], NULL, 0);
+	router->nodes_used = 1;
+
+	return 0;
+}
+
+int mqtt_topic_router_add(struct mqtt_topic_router *router,
+			  const struct mqtt_topic_router_route *route)
+{
+	const char *pos, *end, *level;
+	size_t len, filter_len;
+	uint16_t idx = ROOT_NODE;
+	int ret;
+
+	if ((router == NULL) || (router->nodes_used == 0) ||
+	    (route == NULL) || (route->filter == NULL) || (route->id < 0)) {
+		return -EINVAL;
+	}
+
+	filter_len = route->filter_len ? route->filter_len :
+					 strlen(route->filter);
+	if (filter_len == 0) {
+		return -EINVAL;
+	}
+
+	pos = route->filter;
+	end = route->filter + filter_len;
+
+	while (pos != NULL) {
+		struct mqtt_topic_router_node *node = &router->nodes[idx];
+
+		level_next(&pos, end, &level, &len);
+
+		if (len > UINT16_MAX) {
+			return -EINVAL;
+		}
+
+		if (level_is(level, len, WILDCARD_MULTI)) {
+			/* '#' must be the last level of the filter. */
+			if (pos != NULL) {
+				return -EINVAL;
+			}
+
+			if (node->hash != NULL) {
+				return -EALREADY;
+			}
+
+			node->hash = route;
+
+			return 0;
+		}
+
+		if (level_is(level, len, WILDCARD_SINGLE)) {
+			if (node->plus == MQTT_TOPIC_ROUTER_NONE) {
+				ret = node_alloc(router, level, len);
+				if (ret < 0) {
+					return ret;
+				}
+
+				node->plus = ret;
+			}
+
+			idx = node->plus;
+			continue;
+		}
+
+		/* Wildcard characters are only allowed as a full level. */
+		if (memchr(level, WILDCARD_SINGLE, len) ||
+		    memchr(level, WILDCARD_MULTI, len)) {
+			return -EINVAL;
+		}
+
+		ret = child_find(router, idx, level, len);
+		if (ret == MQTT_TOPIC_ROUTER_NONE) {
+			ret = node_alloc(router, level, len);
+			if (ret < 0) {
+				return ret;
+			}
+
+			router->nodes[ret].sibling = node->child;
+			node->child = ret;
+		}
+
+		idx = ret;
+	}
+
+	if (router->nodes[idx].route != NULL) {
+		return -EALREADY;
+	}
+
+	router->nodes[idx].route = route;
+
+	return 0;
+}
+
+/* Match the remainder of a topic, starting at pos, against the subtree of a
+ * node that matched the previous topic level. pos is NULL if the previous
+ * level was the last one in the topic.
+ *
+ * The literal child is tried before the '+' child, and '#' last, which gives
+ * the match precedence. Going back to the '+' child walks the same topic
+ * levels again, but as the trie is a tree, no node is visited twice.
+ */
+static const struct mqtt_topic_router_route *subtree_match(
+	const struct mqtt_topic_router *router, uint16_t idx,
+	const char *pos, const char *end, bool wildcards)
+{
+	const struct mqtt_topic_router_node *node = &router->nodes[idx];
+	const struct mqtt_topic_router_route *route;
+	const char *level;
+	size_t len;
+	uint16_t child;
+
+	if (pos == NULL) {
+		/* "a/#" also matches the parent level "a". */
+		return node->route ? node->route : node->hash;
+	}
+
+	level_next(&pos, end, &level, &len);
+
+	child = child_find(router, idx, level, len);
+	if (child != MQTT_TOPIC_ROUTER_NONE) {
+		route = subtree_match(router, child, pos, end, true);
+		if (route != NULL) {
+			return route;
+		}
+	}
+
+	if (!wildcards) {
+		return NULL;
+	}
+
+	if (node->plus != MQTT_TOPIC_ROUTER_NONE) {
+		route = subtree_match(router, node->plus, pos, end, true);
+		if (route != NULL) {
+			return route;
+		}
+	}
+
+	return node->hash;
+}
+
+const struct mqtt_topic_router_route *mqtt_topic_router_match(
+	const struct mqtt_topic_router *router,
+	const char *topic, size_t topic_len)
+{
+	if ((router == NULL) || (router->nodes_used == 0) ||
+	    (topic == NULL) || (topic_len == 0)) {
+		return NULL;
+	}
+
+	return subtree_match(router, ROOT_NODE, topic, topic + topic_len,
+			     topic[0] != '$');
+}
+
+int mqtt_topic_router_dispatch(const struct mqtt_topic_router *router,
+			       const char *topic, size_t topic_len,
+			       void *user_data)
+{
+	const struct mqtt_topic_router_route *route =
+		mqtt_topic_router_match(router, topic, topic_len);
+
+	if (route == NULL) {
+		return -ENOENT;
+	}
+
+	if (route->handler != NULL) {
+		route->handler(route, topic, topic_len, user_data);
+	}
+
+	return route->id;
+}
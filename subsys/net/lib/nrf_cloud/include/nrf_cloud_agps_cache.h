@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef NRF_CLOUD_AGPS_CACHE_H_
+#define NRF_CLOUD_AGPS_CACHE_H_
+
+#include <zephyr.h>
+#include <drivers/gps.h>
+
+#include "nrf_cloud_agps_schema_v1.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cache of the A-GPS data that stays valid for hours or days: ephemerides,
+ * almanacs, UTC parameters and Klobuchar corrections.
+ *
+ * The cached elements are stored in the settings storage together with the
+ * GPS time (in seconds) at which they expire. The cache also tracks which
+ * elements have been injected into the GNSS since boot, so that identical
+ * data received again is not written a second time.
+ *
+ * A time of 0 means that the current time is not known. In that case, the
+ * request is not filtered and the received elements are not cached.
+ */
+
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+
+/* Load the cache from the settings storage. None of the loaded elements is
+ * considered injected.
+ */
+int nrf_cloud_agps_cache_init(void);
+
+/* Remove the data types and satellites that are valid in the cache from the
+ * request. The removed elements are marked as not injected, as the GNSS
+ * requested them, so that they are injected from the cache instead.
+ */
+void nrf_cloud_agps_cache_request_filter(struct gps_agps_request *request,
+					 uint32_t now);
+
+/* Update the cache with an element received from nRF Cloud.
+ *
+ * Returns true if the element must be injected, or false if the same data
+ * has already been injected. Elements of types that are not cached must
+ * always be injected.
+ */
+bool nrf_cloud_agps_cache_update(const struct nrf_cloud_apgs_element *element,
+				 uint32_t now);
+
+/* Get the valid cached elements that have not been injected yet, and mark
+ * them as injected. The elements point to the cache storage.
+ *
+ * Returns the number of elements stored in the array.
+ */
+size_t nrf_cloud_agps_cache_pending_get(struct nrf_cloud_apgs_element *elements,
+					size_t max_count, uint32_t now);
+
+/* Mark all the cached elements as not injected. */
+void nrf_cloud_agps_cache_injection_reset(void);
+
+/* Store the elements updated since the last call in the settings storage. */
+int nrf_cloud_agps_cache_save(void);
+
+#else
+
+static inline int nrf_cloud_agps_cache_init(void)
+{
+	return 0;
+}
+
+static inline void nrf_cloud_agps_cache_request_filter(
+	struct gps_agps_request *request, uint32_t now)
+{
+}
+
+static inline bool nrf_cloud_agps_cache_update(
+	const struct nrf_cloud_apgs_element *element, uint32_t now)
+{
+	return true;
+}
+
+static inline size_t nrf_cloud_agps_cache_pending_get(
+	struct nrf_cloud_apgs_element *elements, size_t max_count, uint32_t now)
+{
+	return 0;
+}
+
+static inline void nrf_cloud_agps_cache_injection_reset(void)
+{
+}
+
+static inline int nrf_cloud_agps_cache_save(void)
+{
+	return 0;
+}
+
+#endif /* defined(CONFIG_NRF_CLOUD_AGPS_CACHE) */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_CLOUD_AGPS_CACHE_H_ */
@@ -12,6 +12,9 @@
 
 #include <modem/modem_info.h>
 #include <net/nrf_cloud_agps.h>
+#if defined(CONFIG_DATE_TIME)
+#include <date_time.h>
+#endif
 
 #include <logging/log.h>
 
@@ -19,12 +22,37 @@ LOG_MODULE_REGISTER(nrf_cloud_agps, CONFIG_NRF_CLOUD_AGPS_LOG_LEVEL);
 
 #include "nrf_cloud_transport.h"
 #include "nrf_cloud_agps_schema_v1.h"
+#include "nrf_cloud_agps_cache.h"
+
+/* GPS time starts at 1980-01-06 and is ahead of UTC by the leap seconds
+ * inserted since then.
+ */
+#define GPS_UNIX_EPOCH_OFFSET_S		315964800
+#define GPS_UTC_LEAP_SECONDS		18
+#define SECONDS_PER_DAY			86400
+
+/* Ephemerides and almanacs for all satellites, and one element of each of
+ * the other types.
+ */
+#define AGPS_BATCH_SIZE		(2 * NRF_CLOUD_AGPS_MAX_SV_TOW + 8)
 
 extern void agps_print(enum nrf_cloud_agps_type type, void *data);
 
 static int fd = -1;
 static bool agps_print_enabled;
 static const struct device *gps_dev;
+static bool cache_loaded;
+
+/* Elements to be injected, collected before they are written to the GNSS
+ * in one sequence.
+ */
+static struct nrf_cloud_apgs_element batch[AGPS_BATCH_SIZE];
+static struct nrf_cloud_agps_system_time sys_time;
+
+struct agps_parser {
+	uint16_t elements_left;
+	enum nrf_cloud_agps_type element_type;
+};
 
 static enum gps_agps_type type_lookup_socket2gps[] = {
 	[NRF_GNSS_AGPS_UTC_PARAMETERS]	= GPS_AGPS_UTC_PARAMETERS,
@@ -69,6 +97,101 @@ static int type_array2str(enum gps_agps_type *types, size_t type_count,
 	return 0;
 }
 
+/* Current GPS time in seconds, or 0 if it is not known. Leap seconds
+ * inserted after the library was written are not accounted for, which is
+ * negligible compared to the validity of the cached data.
+ */
+static uint32_t gps_time_now(void)
+{
+#if defined(CONFIG_DATE_TIME)
+	int64_t unix_time_ms;
+
+	if (date_time_now(&unix_time_ms) == 0) {
+		return (uint32_t)(unix_time_ms / MSEC_PER_SEC -
+				  GPS_UNIX_EPOCH_OFFSET_S +
+				  GPS_UTC_LEAP_SECONDS);
+	}
+#endif
+	return 0;
+}
+
+static int agps_target_set(const int *socket)
+{
+	if (socket) {
+		LOG_DBG("Using user-provided socket, fd %d", *socket);
+
+		gps_dev = NULL;
+		fd = *socket;
+	} else if (gps_dev == NULL) {
+		gps_dev = device_get_binding("NRF9160_GPS");
+		if (gps_dev == NULL) {
+			return -ENODEV;
+		}
+	}
+
+	return 0;
+}
+
+static void agps_cache_load(void)
+{
+	int err;
+
+	if (cache_loaded) {
+		return;
+	}
+
+	err = nrf_cloud_agps_cache_init();
+	if (err) {
+		LOG_WRN("A-GPS cache not loaded, error: %d", err);
+		return;
+	}
+
+	cache_loaded = true;
+}
+
+static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data);
+
+static int batch_inject(size_t count)
+{
+	int err;
+
+	for (size_t i = 0; i < count; i++) {
+		err = agps_send_to_modem(&batch[i]);
+		if (err) {
+			LOG_ERR("Failed to send data to modem, error: %d", err);
+
+			/* It is not known what the GNSS received, so the
+			 * cached data is injected again next time.
+			 */
+			nrf_cloud_agps_cache_injection_reset();
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+/* Inject the cached data that the GNSS requested. */
+static void cache_pending_inject(uint32_t now)
+{
+	size_t count;
+
+	if (!IS_ENABLED(CONFIG_NRF_CLOUD_AGPS_CACHE) ||
+	    ((fd < 0) && agps_target_set(NULL))) {
+		return;
+	}
+
+	count = nrf_cloud_agps_cache_pending_get(batch, ARRAY_SIZE(batch),
+						 now);
+	if (count == 0) {
+		return;
+	}
+
+	LOG_DBG("Injecting %d cached A-GPS elements", count);
+
+	(void)batch_inject(count);
+}
+
 int nrf_cloud_agps_request(const struct gps_agps_request request)
 {
 	int err, len;
@@ -81,43 +204,50 @@ int nrf_cloud_agps_request(const struct gps_agps_request request)
 	};
 	enum gps_agps_type types[9];
 	size_t type_count = 0;
+	struct gps_agps_request filtered = request;
+	uint32_t now = gps_time_now();
+
+	/* Only the data that is not valid in the cache is requested. */
+	agps_cache_load();
+	nrf_cloud_agps_cache_request_filter(&filtered, now);
+	cache_pending_inject(now);
 
-	if (request.utc) {
+	if (filtered.utc) {
 		types[type_count] = GPS_AGPS_UTC_PARAMETERS;
 		type_count += 1;
 	}
 
-	if (request.sv_mask_ephe) {
+	if (filtered.sv_mask_ephe) {
 		types[type_count] = GPS_AGPS_EPHEMERIDES;
 		type_count += 1;
 	}
 
-	if (request.sv_mask_alm) {
+	if (filtered.sv_mask_alm) {
 		types[type_count] = GPS_AGPS_ALMANAC;
 		type_count += 1;
 	}
 
-	if (request.klobuchar) {
+	if (filtered.klobuchar) {
 		types[type_count] = GPS_AGPS_KLOBUCHAR_CORRECTION;
 		type_count += 1;
 	}
 
-	if (request.nequick) {
+	if (filtered.nequick) {
 		types[type_count] = GPS_AGPS_NEQUICK_CORRECTION;
 		type_count += 1;
 	}
 
-	if (request.system_time_tow) {
+	if (filtered.system_time_tow) {
 		types[type_count] = GPS_AGPS_GPS_SYSTEM_CLOCK_AND_TOWS;
 		type_count += 1;
 	}
 
-	if (request.position) {
+	if (filtered.position) {
 		types[type_count] = GPS_AGPS_LOCATION;
 		type_count += 1;
 	}
 
-	if (request.integrity) {
+	if (filtered.integrity) {
 		types[type_count] = GPS_AGPS_INTEGRITY;
 		type_count += 1;
 	}
@@ -465,28 +595,27 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 	return 0;
 }
 
-static size_t get_next_agps_element(struct nrf_cloud_apgs_element *element,
+static size_t get_next_agps_element(struct agps_parser *parser,
+				    struct nrf_cloud_apgs_element *element,
 				    const char *buf)
 {
-	static uint16_t elements_left_to_process;
-	static enum nrf_cloud_agps_type element_type;
 	size_t len = 0;
 
 	/* Check if there are more elements left in the array to process.
 	 * The element type is only given once before the array, and not for
 	 * each element.
 	 */
-	if (elements_left_to_process == 0) {
+	if (parser->elements_left == 0) {
 		element->type =
 			(enum nrf_cloud_agps_type)buf[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET];
-		element_type = element->type;
-		elements_left_to_process =
+		parser->element_type = element->type;
+		parser->elements_left =
 			*(uint16_t *)&buf[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET] - 1;
 		len += NRF_CLOUD_AGPS_BIN_TYPE_SIZE +
 			NRF_CLOUD_AGPS_BIN_COUNT_SIZE;
 	} else {
-		element->type = element_type;
-		elements_left_to_process -= 1;
+		element->type = parser->element_type;
+		parser->elements_left -= 1;
 	}
 
 	switch (element->type) {
@@ -538,9 +667,13 @@ static size_t get_next_agps_element(struct nrf_cloud_apgs_element *element,
 int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
 {
 	int err;
+	struct agps_parser parser = {0};
 	struct nrf_cloud_apgs_element element = {};
-	struct nrf_cloud_agps_system_time sys_time;
 	size_t parsed_len = 0;
+	size_t count = 0;
+	size_t inject_count = 0;
+	bool sys_time_received = false;
+	uint32_t now;
 	uint8_t version;
 
 	version = buf[NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_INDEX];
@@ -552,33 +685,44 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
 	LOG_DBG("Receievd AGPS data. Schema version: %d, length: %d",
 		version, buf_len);
 
-	if (socket) {
-		LOG_DBG("Using user-provided socket, fd %d", fd);
-
-		gps_dev = NULL;
-		fd = *socket;
-	} else if (gps_dev == NULL) {
-		gps_dev = device_get_binding("NRF9160_GPS");
-		if (gps_dev == NULL) {
-			LOG_ERR("GPS is not enabled, A-GPS response unhandled");
-			return -ENODEV;
-		}
+	err = agps_target_set(socket);
+	if (err) {
+		LOG_ERR("GPS is not enabled, A-GPS response unhandled");
+		return err;
 	}
 
+	agps_cache_load();
+	memset(&sys_time, 0, sizeof(sys_time));
+
+	/* All the elements are parsed before any of them is injected, so that
+	 * the system clock is injected together with the TOWs that follow it.
+	 */
 	while (parsed_len < buf_len) {
-		size_t element_size =
-			get_next_agps_element(&element, &buf[parsed_len]);
+		size_t element_size = get_next_agps_element(&parser, &element,
+							    &buf[parsed_len]);
 
 		if (element_size == 0) {
 			LOG_DBG("Parsing finished\n");
 			break;
 		}
 
+		if (element_size > (buf_len - parsed_len)) {
+			LOG_WRN("Truncated A-GPS data, type: %d", element.type);
+			break;
+		}
+
 		parsed_len += element_size;
 
 		LOG_DBG("Parsed_len: %d\n", parsed_len);
 
 		if (element.type == NRF_CLOUD_AGPS_GPS_TOWS) {
+			if ((element.tow->sv_id == 0) ||
+			    (element.tow->sv_id > NRF_CLOUD_AGPS_MAX_SV_TOW)) {
+				LOG_WRN("Invalid TOW satellite ID: %d",
+					element.tow->sv_id);
+				continue;
+			}
+
 			memcpy(&sys_time.sv_tow[element.tow->sv_id - 1],
 				element.tow,
 				sizeof(sys_time.sv_tow[0]));
@@ -589,17 +733,45 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len, const int *socket)
 		} else if (element.type == NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK) {
 			memcpy(&sys_time, element.time_and_tow,
 				sizeof(sys_time) - sizeof(sys_time.sv_tow));
+			element.time_and_tow = &sys_time;
+			sys_time_received = true;
 
 			LOG_DBG("TOWs copied, bitmask: 0x%08x",
-				element.time_and_tow->sv_mask);
+				sys_time.sv_mask);
 		}
 
-		err = agps_send_to_modem(&element);
-		if (err) {
-			LOG_ERR("Failed to send data to modem, error: %d", err);
-			return err;
+		if (count == ARRAY_SIZE(batch)) {
+			LOG_WRN("Too many A-GPS elements, type %d dropped",
+				element.type);
+			continue;
+		}
+
+		batch[count++] = element;
+	}
+
+	if (sys_time_received) {
+		now = (uint32_t)sys_time.date_day * SECONDS_PER_DAY +
+		      sys_time.time_full_s;
+	} else {
+		now = gps_time_now();
+	}
+
+	/* Leave out the data that has already been injected. */
+	for (size_t i = 0; i < count; i++) {
+		if (nrf_cloud_agps_cache_update(&batch[i], now)) {
+			batch[inject_count++] = batch[i];
 		}
 	}
 
-	return 0;
+	LOG_DBG("%d A-GPS elements already injected",
+		count - inject_count);
+
+	inject_count += nrf_cloud_agps_cache_pending_get(
+		&batch[inject_count], ARRAY_SIZE(batch) - inject_count, now);
+
+	err = batch_inject(inject_count);
+
+	(void)nrf_cloud_agps_cache_save();
+
+	return err;
 }
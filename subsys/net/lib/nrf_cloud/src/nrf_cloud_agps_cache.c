@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <settings/settings.h>
+
+#include <logging/log.h>
+
+LOG_MODULE_DECLARE(nrf_cloud_agps, CONFIG_NRF_CLOUD_AGPS_LOG_LEVEL);
+
+#include "nrf_cloud_agps_cache.h"
+
+#define SETTINGS_NAME "nrf_cloud_agps"
+
+/* Cached data of one A-GPS type. The satellite-specific types have one entry
+ * per satellite, indexed by the satellite ID minus one.
+ */
+struct cache_type {
+	enum nrf_cloud_agps_type type;
+	const char *key;
+	void *data;
+	size_t size;
+	size_t count;
+	uint32_t *expiry;
+	uint32_t validity;
+	/* Bitmasks of the entries, as there are at most 32 of them. */
+	uint32_t injected;
+	uint32_t dirty;
+};
+
+union cache_data {
+	struct nrf_cloud_agps_ephemeris ephemeris;
+	struct nrf_cloud_agps_almanac almanac;
+	struct nrf_cloud_agps_utc utc;
+	struct nrf_cloud_agps_klobuchar klobuchar;
+};
+
+/* Format of the entries in the settings storage. */
+struct cache_value {
+	uint32_t expiry;
+	union cache_data data;
+} __packed;
+
+static struct nrf_cloud_agps_ephemeris ephemerides[NRF_CLOUD_AGPS_MAX_SV_TOW];
+static uint32_t ephemeris_expiry[NRF_CLOUD_AGPS_MAX_SV_TOW];
+static struct nrf_cloud_agps_almanac almanacs[NRF_CLOUD_AGPS_MAX_SV_TOW];
+static uint32_t almanac_expiry[NRF_CLOUD_AGPS_MAX_SV_TOW];
+static struct nrf_cloud_agps_utc utc;
+static uint32_t utc_expiry;
+static struct nrf_cloud_agps_klobuchar klobuchar;
+static uint32_t klobuchar_expiry;
+
+enum cache_type_idx {
+	CACHE_EPHEMERIDES,
+	CACHE_ALMANAC,
+	CACHE_UTC,
+	CACHE_KLOBUCHAR,
+	CACHE_TYPE_COUNT,
+};
+
+static struct cache_type cache[CACHE_TYPE_COUNT] = {
+	[CACHE_EPHEMERIDES] = {
+		.type = NRF_CLOUD_AGPS_EPHEMERIDES,
+		.key = "eph",
+		.data = ephemerides,
+		.size = sizeof(ephemerides[0]),
+		.count = ARRAY_SIZE(ephemerides),
+		.expiry = ephemeris_expiry,
+		.validity = CONFIG_NRF_CLOUD_AGPS_CACHE_EPHEMERIS_VALIDITY,
+	},
+	[CACHE_ALMANAC] = {
+		.type = NRF_CLOUD_AGPS_ALMANAC,
+		.key = "alm",
+		.data = almanacs,
+		.size = sizeof(almanacs[0]),
+		.count = ARRAY_SIZE(almanacs),
+		.expiry = almanac_expiry,
+		.validity = CONFIG_NRF_CLOUD_AGPS_CACHE_ALMANAC_VALIDITY,
+	},
+	[CACHE_UTC] = {
+		.type = NRF_CLOUD_AGPS_UTC_PARAMETERS,
+		.key = "utc",
+		.data = &utc,
+		.size = sizeof(utc),
+		.count = 1,
+		.expiry = &utc_expiry,
+		.validity = CONFIG_NRF_CLOUD_AGPS_CACHE_IONO_UTC_VALIDITY,
+	},
+	[CACHE_KLOBUCHAR] = {
+		.type = NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION,
+		.key = "klob",
+		.data = &klobuchar,
+		.size = sizeof(klobuchar),
+		.count = 1,
+		.expiry = &klobuchar_expiry,
+		.validity = CONFIG_NRF_CLOUD_AGPS_CACHE_IONO_UTC_VALIDITY,
+	},
+};
+
+static void *entry_data(const struct cache_type *ct, size_t idx)
+{
+	return (uint8_t *)ct->data + idx * ct->size;
+}
+
+static bool entry_valid(const struct cache_type *ct, size_t idx, uint32_t now)
+{
+	return (now != 0) && (ct->expiry[idx] > now);
+}
+
+static uint32_t valid_mask(const struct cache_type *ct, uint32_t now)
+{
+	uint32_t mask = 0;
+
+	for (size_t i = 0; i < ct->count; i++) {
+		if (entry_valid(ct, i, now)) {
+			mask |= BIT(i);
+		}
+	}
+
+	return mask;
+}
+
+static struct cache_type *cache_type_get(enum nrf_cloud_agps_type type)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].type == type) {
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Get the cached type of an element, and the index and data of its entry. */
+static struct cache_type *element_entry_get(
+	const struct nrf_cloud_apgs_element *element, size_t *idx,
+	const void **data)
+{
+	struct cache_type *ct = cache_type_get(element->type);
+	uint8_t sv_id = 1;
+
+	if (ct == NULL) {
+		return NULL;
+	}
+
+	switch (element->type) {
+	case NRF_CLOUD_AGPS_EPHEMERIDES:
+		sv_id = element->ephemeris->sv_id;
+		*data = element->ephemeris;
+		break;
+	case NRF_CLOUD_AGPS_ALMANAC:
+		sv_id = element->almanac->sv_id;
+		*data = element->almanac;
+		break;
+	case NRF_CLOUD_AGPS_UTC_PARAMETERS:
+		*data = element->utc;
+		break;
+	case NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION:
+		*data = element->ion_correction.klobuchar;
+		break;
+	default:
+		return NULL;
+	}
+
+	if ((sv_id == 0) || (sv_id > ct->count)) {
+		LOG_WRN("Invalid satellite ID %d, A-GPS type %d not cached",
+			sv_id, element->type);
+		return NULL;
+	}
+
+	*idx = sv_id - 1;
+
+	return ct;
+}
+
+static void element_set(struct nrf_cloud_apgs_element *element,
+			const struct cache_type *ct, size_t idx)
+{
+	void *data = entry_data(ct, idx);
+
+	element->type = ct->type;
+
+	switch (ct->type) {
+	case NRF_CLOUD_AGPS_EPHEMERIDES:
+		element->ephemeris = data;
+		break;
+	case NRF_CLOUD_AGPS_ALMANAC:
+		element->almanac = data;
+		break;
+	case NRF_CLOUD_AGPS_UTC_PARAMETERS:
+		element->utc = data;
+		break;
+	case NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION:
+		element->ion_correction.klobuchar = data;
+		break;
+	default:
+		break;
+	}
+}
+
+static int settings_set(const char *key, size_t len_rd,
+			settings_read_cb read_cb, void *cb_arg)
+{
+	struct cache_value value;
+	const char *next;
+	struct cache_type *ct = NULL;
+	size_t name_len;
+	unsigned long idx;
+
+	if (!key) {
+		return -EINVAL;
+	}
+
+	name_len = settings_name_next(key, &next);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		if ((strlen(cache[i].key) == name_len) &&
+		    !strncmp(key, cache[i].key, name_len)) {
+			ct = &cache[i];
+			break;
+		}
+	}
+
+	if (ct == NULL) {
+		return -ENOENT;
+	}
+
+	idx = next ? strtoul(next, NULL, 10) : 0;
+
+	if ((idx >= ct->count) ||
+	    (len_rd != sizeof(value.expiry) + ct->size)) {
+		LOG_WRN("Invalid A-GPS cache entry: %s", log_strdup(key));
+		return -EINVAL;
+	}
+
+	if (read_cb(cb_arg, &value, len_rd) != len_rd) {
+		return -EIO;
+	}
+
+	ct->expiry[idx] = value.expiry;
+	memcpy(entry_data(ct, idx), &value.data, ct->size);
+
+	return 0;
+}
+
+int nrf_cloud_agps_cache_init(void)
+{
+	static struct settings_handler sh = {
+		.name = SETTINGS_NAME,
+		.h_set = settings_set,
+	};
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		memset(cache[i].expiry, 0,
+		       cache[i].count * sizeof(cache[i].expiry[0]));
+		cache[i].injected = 0;
+		cache[i].dirty = 0;
+	}
+
+	/* settings_subsys_init is idempotent so this is safe to do. */
+	err = settings_subsys_init();
+	if (err) {
+		LOG_ERR("Settings init failed: %d", err);
+		return err;
+	}
+
+	err = settings_register(&sh);
+	if (err && (err != -EEXIST)) {
+		LOG_ERR("Cannot register settings handler: %d", err);
+		return err;
+	}
+
+	err = settings_load_subtree(SETTINGS_NAME);
+	if (err) {
+		LOG_ERR("Cannot load A-GPS cache: %d", err);
+		return err;
+	}
+
+	return 0;
+}
+
+void nrf_cloud_agps_cache_request_filter(struct gps_agps_request *request,
+					 uint32_t now)
+{
+	uint32_t mask;
+
+	if (now == 0) {
+		return;
+	}
+
+	mask = request->sv_mask_ephe & valid_mask(&cache[CACHE_EPHEMERIDES],
+						  now);
+	cache[CACHE_EPHEMERIDES].injected &= ~mask;
+	request->sv_mask_ephe &= ~mask;
+
+	mask = request->sv_mask_alm & valid_mask(&cache[CACHE_ALMANAC], now);
+	cache[CACHE_ALMANAC].injected &= ~mask;
+	request->sv_mask_alm &= ~mask;
+
+	if (request->utc && entry_valid(&cache[CACHE_UTC], 0, now)) {
+		cache[CACHE_UTC].injected = 0;
+		request->utc = 0;
+	}
+
+	if (request->klobuchar &&
+	    entry_valid(&cache[CACHE_KLOBUCHAR], 0, now)) {
+		cache[CACHE_KLOBUCHAR].injected = 0;
+		request->klobuchar = 0;
+	}
+}
+
+bool nrf_cloud_agps_cache_update(const struct nrf_cloud_apgs_element *element,
+				 uint32_t now)
+{
+	struct cache_type *ct;
+	const void *data;
+	void *entry;
+	size_t idx;
+
+	ct = element_entry_get(element, &idx, &data);
+	if ((ct == NULL) || (now == 0)) {
+		return true;
+	}
+
+	entry = entry_data(ct, idx);
+
+	/* The validity of the data depends on when it was generated, so it is
+	 * not extended when the same data is received again.
+	 */
+	if (entry_valid(ct, idx, now) && !memcmp(entry, data, ct->size)) {
+		if (ct->injected & BIT(idx)) {
+			return false;
+		}
+	} else {
+		memcpy(entry, data, ct->size);
+		ct->expiry[idx] = now + ct->validity;
+		ct->dirty |= BIT(idx);
+	}
+
+	ct->injected |= BIT(idx);
+
+	return true;
+}
+
+size_t nrf_cloud_agps_cache_pending_get(struct nrf_cloud_apgs_element *elements,
+					size_t max_count, uint32_t now)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		struct cache_type *ct = &cache[i];
+		uint32_t pending = valid_mask(ct, now) & ~ct->injected;
+
+		for (size_t idx = 0; pending && (count < max_count); idx++) {
+			if (!(pending & BIT(idx))) {
+				continue;
+			}
+
+			element_set(&elements[count++], ct, idx);
+			ct->injected |= BIT(idx);
+			pending &= ~BIT(idx);
+		}
+	}
+
+	return count;
+}
+
+void nrf_cloud_agps_cache_injection_reset(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		cache[i].injected = 0;
+	}
+}
+
+int nrf_cloud_agps_cache_save(void)
+{
+	char key[sizeof(SETTINGS_NAME) + 16];
+	struct cache_value value;
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache); i++) {
+		struct cache_type *ct = &cache[i];
+
+		for (size_t idx = 0; ct->dirty; idx++) {
+			if (!(ct->dirty & BIT(idx))) {
+				continue;
+			}
+
+			if (ct->count > 1) {
+				snprintf(key, sizeof(key),
+					 SETTINGS_NAME "/%s/%u", ct->key,
+					 (unsigned int)idx);
+			} else {
+				snprintf(key, sizeof(key), SETTINGS_NAME "/%s",
+					 ct->key);
+			}
+
+			value.expiry = ct->expiry[idx];
+			memcpy(&value.data, entry_data(ct, idx), ct->size);
+
+			err = settings_save_one(key, &value,
+						sizeof(value.expiry) +
+						ct->size);
+			if (err) {
+				LOG_ERR("Cannot save A-GPS cache entry %s: %d",
+					log_strdup(key), err);
+				return err;
+			}
+
+			ct->dirty &= ~BIT(idx);
+		}
+	}
+
+	return 0;
+}
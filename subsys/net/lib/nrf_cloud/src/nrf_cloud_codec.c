@@ -13,6 +13,7 @@
 #include <logging/log.h>
 #include "cJSON.h"
 #include "cJSON_os.h"
+#include <json_writer.h>
 
 LOG_MODULE_REGISTER(nrf_cloud_codec, CONFIG_NRF_CLOUD_LOG_LEVEL);
 
@@ -130,6 +131,8 @@ int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
 	__ASSERT_NO_MSG(sensor->data.len != 0);
 	__ASSERT_NO_MSG(output != NULL);
 
+	cJSON_ArenaBegin();
+
 	cJSON *root_obj = cJSON_CreateObject();
 	cJSON *state_obj = cJSON_CreateObject();
 	cJSON *reported_obj = cJSON_CreateObject();
@@ -138,6 +141,7 @@ int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
 		cJSON_Delete(root_obj);
 		cJSON_Delete(state_obj);
 		cJSON_Delete(reported_obj);
+		cJSON_ArenaEnd();
 		return -ENOMEM;
 	}
 
@@ -152,8 +156,9 @@ int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
 		cJSON_Delete(reported_obj);
 	}
 
-	buffer = cJSON_PrintUnformatted(root_obj);
+	buffer = cJSON_ArenaPrintUnformatted(root_obj);
 	cJSON_Delete(root_obj);
+	cJSON_ArenaEnd();
 
 	output->ptr = buffer;
 	output->len = strlen(buffer);
@@ -161,38 +166,36 @@ int nrf_cloud_encode_shadow_data(const struct nrf_cloud_sensor_data *sensor,
 	return 0;
 }
 
+static void sensor_data_write(struct json_writer *w, const void *ctx)
+{
+	const struct nrf_cloud_sensor_data *sensor = ctx;
+
+	json_writer_obj_start(w, NULL);
+	json_writer_str(w, "appId", sensor_type_str[sensor->type]);
+	json_writer_str(w, "data", sensor->data.ptr);
+	json_writer_str(w, "messageType", "DATA");
+	json_writer_obj_end(w);
+}
+
 int nrf_cloud_encode_sensor_data(const struct nrf_cloud_sensor_data *sensor,
 				 struct nrf_cloud_data *output)
 {
-	int ret;
+	char *buffer;
+	size_t len;
 
 	__ASSERT_NO_MSG(sensor != NULL);
 	__ASSERT_NO_MSG(sensor->data.ptr != NULL);
 	__ASSERT_NO_MSG(sensor->data.len != 0);
 	__ASSERT_NO_MSG(output != NULL);
 
-	cJSON *root_obj = cJSON_CreateObject();
-
-	if (root_obj == NULL) {
-		return -ENOMEM;
-	}
-
-	ret = json_add_str(root_obj, "appId", sensor_type_str[sensor->type]);
-	ret += json_add_str(root_obj, "data", sensor->data.ptr);
-	ret += json_add_str(root_obj, "messageType", "DATA");
-
-	if (ret != 0) {
-		cJSON_Delete(root_obj);
+	/* Written directly to the output buffer, without a cJSON tree. */
+	buffer = json_writer_alloc_print(sensor_data_write, sensor, &len);
+	if (buffer == NULL) {
 		return -ENOMEM;
 	}
 
-	char *buffer;
-
-	buffer = cJSON_PrintUnformatted(root_obj);
-	cJSON_Delete(root_obj);
-
 	output->ptr = buffer;
-	output->len = strlen(buffer);
+	output->len = len;
 
 	return 0;
 }
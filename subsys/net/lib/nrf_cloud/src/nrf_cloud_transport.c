@@ -13,6 +13,7 @@
 #include <net/mqtt.h>
 #include <net/socket.h>
 #include <net/cloud.h>
+#include <net/mqtt_topic_router.h>
 #include <logging/log.h>
 #include <sys/util.h>
 #include <settings/settings.h>
@@ -111,8 +112,10 @@ static bool persistent_session;
 #define NCT_CC_SUBSCRIBE_ID 1234
 #define NCT_DC_SUBSCRIBE_ID 8765
 
-#define NCT_RX_LIST 0
-#define NCT_TX_LIST 1
+/* Number of trie nodes needed to route the control channel topics, one per
+ * unique topic level.
+ */
+#define NCT_CC_ROUTER_NODES 12
 
 static int nct_settings_set(const char *key, size_t len_rd,
 			    settings_read_cb read_cb, void *cb_arg);
@@ -192,6 +195,11 @@ static uint32_t const nct_cc_rx_opcode_map[] = {
 	NCT_CC_OPCODE_UPDATE_ACCEPT_RSP
 };
 
+/* Router from the control channel topics to their opcodes. */
+MQTT_TOPIC_ROUTER_DEFINE(nct_cc_router, NCT_CC_ROUTER_NODES);
+static struct mqtt_topic_router_route nct_cc_rx_routes[
+	ARRAY_SIZE(nct_cc_rx_list)];
+
 /* Internal routine to reset data endpoint information. */
 static void dc_endpoint_reset(void)
 {
@@ -274,39 +282,48 @@ static uint32_t dc_send(const struct nct_dc_data *dc_data, uint8_t qos)
 	return mqtt_publish(&nct.client, &publish);
 }
 
-static bool strings_compare(const char *s1, const char *s2, uint32_t s1_len,
-			    uint32_t s2_len)
+/* Build the router for the control channel topics. */
+static int control_channel_router_init(void)
 {
-	return (strncmp(s1, s2, MIN(s1_len, s2_len))) ? false : true;
+	int err;
+
+	err = mqtt_topic_router_reset(&nct_cc_router);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(nct_cc_rx_list); i++) {
+		nct_cc_rx_routes[i].filter =
+			(const char *)nct_cc_rx_list[i].topic.utf8;
+		nct_cc_rx_routes[i].filter_len = nct_cc_rx_list[i].topic.size;
+		nct_cc_rx_routes[i].id = nct_cc_rx_opcode_map[i];
+
+		err = mqtt_topic_router_add(&nct_cc_router,
+					    &nct_cc_rx_routes[i]);
+		if (err) {
+			LOG_ERR("Failed to add control channel route: %d", err);
+			return err;
+		}
+	}
+
+	return 0;
 }
 
 /* Verify if the topic is a control channel topic or not. */
-static bool control_channel_topic_match(uint32_t list_id,
-					const struct mqtt_topic *topic,
+static bool control_channel_topic_match(const struct mqtt_topic *topic,
 					enum nct_cc_opcode *opcode)
 {
-	struct mqtt_topic *topic_list;
-	uint32_t list_size;
-
-	if (list_id == NCT_RX_LIST) {
-		topic_list = (struct mqtt_topic *)nct_cc_rx_list;
-		list_size = ARRAY_SIZE(nct_cc_rx_list);
-	} else if (list_id == NCT_TX_LIST) {
-		topic_list = (struct mqtt_topic *)nct_cc_tx_list;
-		list_size = ARRAY_SIZE(nct_cc_tx_list);
-	} else {
+	const struct mqtt_topic_router_route *route =
+		mqtt_topic_router_match(&nct_cc_router,
+					(const char *)topic->topic.utf8,
+					topic->topic.size);
+
+	if (route == NULL) {
 		return false;
 	}
 
-	for (uint32_t index = 0; index < list_size; index++) {
-		if (strings_compare(
-			    topic->topic.utf8, topic_list[index].topic.utf8,
-			    topic->topic.size, topic_list[index].topic.size)) {
-			*opcode = nct_cc_rx_opcode_map[index];
-			return true;
-		}
-	}
-	return false;
+	*opcode = route->id;
+	return true;
 }
 
 /* Function to get the client id */
@@ -390,7 +407,7 @@ static int nct_topics_populate(void)
 	}
 	LOG_DBG("shadow_get_topic: %s", log_strdup(shadow_get_topic));
 
-	return 0;
+	return control_channel_router_init();
 }
 
 /* Provisions root CA certificate using modem_key_mgmt API */
@@ -830,7 +847,7 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 		/* If the data arrives on one of the subscribed control channel
 		 * topic. Then we notify the same.
 		 */
-		if (control_channel_topic_match(NCT_RX_LIST, &p->message.topic,
+		if (control_channel_topic_match(&p->message.topic,
 						&cc.opcode)) {
 			cc.id = p->message_id;
 			cc.data.ptr = nct.payload_buf;
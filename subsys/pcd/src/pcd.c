@@ -9,6 +9,9 @@
 #include <dfu/pcd.h>
 #include <logging/log.h>
 #include <storage/stream_flash.h>
+#include <drivers/flash.h>
+#include <sys/atomic.h>
+#include <sys/crc.h>
 
 LOG_MODULE_REGISTER(pcd, CONFIG_PCD_LOG_LEVEL);
 
@@ -27,18 +30,54 @@ LOG_MODULE_REGISTER(pcd, CONFIG_PCD_LOG_LEVEL);
 #define NET_CORE_APP_OFFSET PM_CPUNET_B0N_SIZE
 #endif
 
+#if defined(CONFIG_SOC_SERIES_NRF53X)
+#include <hal/nrf_ipc.h>
+#endif
+
+/* The stream flash buffer is empty at the end of each chunk. */
+BUILD_ASSERT((CONFIG_PCD_CHUNK_SIZE % CONFIG_PCD_BUF_SIZE) == 0,
+	     "The chunk size must be a multiple of the buffer size");
+
+/* Resuming at a chunk erases the page it starts in, so the chunks must not
+ * share a page.
+ */
+#if DT_NODE_HAS_PROP(DT_CHOSEN(zephyr_flash), erase_block_size)
+BUILD_ASSERT((CONFIG_PCD_CHUNK_SIZE %
+	      DT_PROP(DT_CHOSEN(zephyr_flash), erase_block_size)) == 0,
+	     "The chunk size must be a multiple of the flash page size");
+#endif
+
 struct pcd_cmd {
 	uint32_t magic; /* Magic value to identify this structure in memory */
 	const void *data;     /* Data to copy*/
 	size_t len;           /* Number of bytes to copy */
 	off_t offset;         /* Offset to store the flash image in */
+	/* The fields below are appended so that the fields above keep their
+	 * location for network core bootloaders that copy in one go.
+	 */
+	uint32_t chunk_size;  /* Number of bytes copied between reports */
+	uint32_t crc;         /* CRC32 of the data to copy */
+	atomic_t chunks_done; /* Number of chunks copied and verified */
+	uint32_t running_crc; /* CRC32 of the chunks copied */
 } __aligned(4);
 
 static struct pcd_cmd *cmd = (struct pcd_cmd *)PCD_CMD_ADDRESS;
 
+/** Signal the application core that the CMD has been updated. */
+static void pcd_evt_signal(void)
+{
+#if defined(CONFIG_SOC_SERIES_NRF53X)
+	nrf_ipc_send_config_set(NRF_IPC, CONFIG_PCD_IPC_CHANNEL,
+				BIT(CONFIG_PCD_IPC_CHANNEL));
+	nrf_ipc_task_trigger(NRF_IPC,
+			     nrf_ipc_send_task_get(CONFIG_PCD_IPC_CHANNEL));
+#endif
+}
+
 void pcd_fw_copy_invalidate(void)
 {
 	cmd->magic = PCD_CMD_MAGIC_FAIL;
+	pcd_evt_signal();
 }
 
 enum pcd_status pcd_fw_copy_status_get(void)
@@ -57,30 +96,119 @@ const void *pcd_cmd_data_ptr_get(void)
 	return cmd->data;
 }
 
+/** Read back a chunk written to flash and add it to the CRC. */
+static int chunk_crc_update(const struct device *fdev, off_t offset,
+			    size_t len, uint8_t *buf, size_t buf_len,
+			    uint32_t *crc)
+{
+	while (len > 0) {
+		size_t read_len = MIN(len, buf_len);
+		int rc = flash_read(fdev, offset, buf, read_len);
+
+		if (rc != 0) {
+			LOG_ERR("flash_read failed: %d", rc);
+			return rc;
+		}
+
+		*crc = crc32_ieee_update(*crc, buf, read_len);
+		offset += read_len;
+		len -= read_len;
+	}
+
+	return 0;
+}
+
 int pcd_fw_copy(const struct device *fdev)
 {
 	struct stream_flash_ctx stream;
+	struct flash_pages_info page;
 	uint8_t buf[CONFIG_PCD_BUF_SIZE];
+	uint32_t chunk_size = cmd->chunk_size;
+	uint32_t num_chunks;
+	uint32_t done;
+	uint32_t crc;
 	int rc;
 
 	if (cmd->magic != PCD_CMD_MAGIC_COPY) {
 		return -EFAULT;
 	}
 
-	rc = stream_flash_init(&stream, fdev, buf, sizeof(buf),
-			       cmd->offset, 0, NULL);
+	if ((chunk_size == 0) || (chunk_size % sizeof(buf) != 0)) {
+		LOG_ERR("Invalid chunk size: %d", chunk_size);
+		return -EINVAL;
+	}
+
+	rc = flash_get_page_info_by_offs(fdev, cmd->offset, &page);
 	if (rc != 0) {
-		LOG_ERR("stream_flash_init failed: %d", rc);
+		LOG_ERR("flash_get_page_info_by_offs failed: %d", rc);
 		return rc;
 	}
 
-	rc = stream_flash_buffered_write(&stream, (uint8_t *)cmd->data,
-					 cmd->len, true);
+	/* The chunk size is set by the application core, so it is checked
+	 * against the page size of this flash device.
+	 */
+	if ((page.start_offset != cmd->offset) ||
+	    (chunk_size % page.size != 0)) {
+		LOG_ERR("Chunk size %d not aligned to the %d byte pages",
+			chunk_size, page.size);
+		return -EINVAL;
+	}
+
+	num_chunks = DIV_ROUND_UP(cmd->len, chunk_size);
+	done = atomic_get(&cmd->chunks_done);
+	if (done > num_chunks) {
+		LOG_ERR("Invalid number of chunks done: %d", done);
+		return -EINVAL;
+	}
+
+	if (done > 0) {
+		LOG_INF("Resuming transfer at chunk %d of %d", done,
+			num_chunks);
+	}
+
+	crc = (done > 0) ? cmd->running_crc : 0;
+
+	rc = stream_flash_init(&stream, fdev, buf, sizeof(buf),
+			       cmd->offset + done * chunk_size, 0, NULL);
 	if (rc != 0) {
-		LOG_ERR("stream_flash_buffered_write fail: %d", rc);
+		LOG_ERR("stream_flash_init failed: %d", rc);
 		return rc;
 	}
 
+	for (uint32_t i = done; i < num_chunks; i++) {
+		off_t chunk_offset = i * chunk_size;
+		size_t len = MIN(chunk_size, cmd->len - chunk_offset);
+
+		rc = stream_flash_buffered_write(&stream,
+				(const uint8_t *)cmd->data + chunk_offset,
+				len, true);
+		if (rc != 0) {
+			LOG_ERR("stream_flash_buffered_write fail: %d", rc);
+			return rc;
+		}
+
+		/* The chunk has been flushed, so the stream flash buffer can
+		 * be used to read it back.
+		 */
+		rc = chunk_crc_update(fdev, cmd->offset + chunk_offset, len,
+				      buf, sizeof(buf), &crc);
+		if (rc != 0) {
+			return rc;
+		}
+
+		/* The CRC must be stored before the chunk is reported, so
+		 * that the transfer can be resumed after this chunk.
+		 */
+		cmd->running_crc = crc;
+		atomic_set(&cmd->chunks_done, i + 1);
+		pcd_evt_signal();
+	}
+
+	if (crc != cmd->crc) {
+		LOG_ERR("CRC mismatch: 0x%08x, expected 0x%08x", crc, cmd->crc);
+		return -EIO;
+	}
+
 	LOG_INF("Transfer done");
 
 	return 0;
@@ -90,11 +218,68 @@ void pcd_fw_copy_done(void)
 {
 	/* Signal complete by setting magic to DONE */
 	cmd->magic = PCD_CMD_MAGIC_DONE;
+	pcd_evt_signal();
 }
 
 #if defined(CONFIG_SOC_NRF5340_CPUAPP) && defined(CONFIG_MCUBOOT)
 
+/** Interval at which the IPC event from the network core is polled.
+ *
+ * The network core is only updated from MCUboot, which runs without the IPC
+ * interrupt and may run without threads, so the event is polled instead of
+ * being waited for on a semaphore. The CPU has nothing else to do while it
+ * waits.
+ */
+#define PCD_EVT_POLL_US 1000
+
+static pcd_progress_cb_t progress_cb;
+
+void pcd_progress_cb_set(pcd_progress_cb_t cb)
+{
+	progress_cb = cb;
+}
+
+static void evt_enable(bool enable)
+{
+	nrf_ipc_receive_config_set(NRF_IPC, CONFIG_PCD_IPC_CHANNEL,
+				   enable ? BIT(CONFIG_PCD_IPC_CHANNEL) : 0);
+	nrf_ipc_event_clear(NRF_IPC,
+			    nrf_ipc_receive_event_get(CONFIG_PCD_IPC_CHANNEL));
+}
+
+/** @brief Wait for the network core to signal that the CMD has been updated.
+ *
+ * The polling is deliberate, see PCD_EVT_POLL_US. Only the IPC event is
+ * polled, so the network core is not slowed down by accesses to the shared
+ * RAM while it updates the CMD.
+ *
+ * @retval true if the event was received, false on timeout.
+ */
+static bool evt_wait(uint32_t timeout_ms)
+{
+	nrf_ipc_event_t evt =
+		nrf_ipc_receive_event_get(CONFIG_PCD_IPC_CHANNEL);
+
+	for (uint32_t waited = 0; waited < timeout_ms * USEC_PER_MSEC;
+	     waited += PCD_EVT_POLL_US) {
+		if (nrf_ipc_event_check(NRF_IPC, evt)) {
+			/* The CMD is read after the event is cleared, so an
+			 * update signalled in between is not missed.
+			 */
+			nrf_ipc_event_clear(NRF_IPC, evt);
+			return true;
+		}
+
+		k_busy_wait(PCD_EVT_POLL_US);
+	}
+
+	return false;
+}
+
 /** @brief Construct a PCD CMD for copying data/firmware.
+ *
+ * If the CMD already holds the same copy operation, it is kept so that the
+ * network core resumes it from the last chunk done.
  *
  * @param data   The data to copy.
  * @param len    The number of bytes that should be copied.
@@ -105,18 +290,88 @@ void pcd_fw_copy_done(void)
  */
 static int pcd_cmd_write(const void *data, size_t len, off_t offset)
 {
+	uint32_t crc;
+
 	if (data == NULL || len == 0) {
 		return -EINVAL;
 	}
 
-	cmd->magic = PCD_CMD_MAGIC_COPY;
+	crc = crc32_ieee(data, len);
+
+	if ((cmd->magic == PCD_CMD_MAGIC_COPY) && (cmd->data == data) &&
+	    (cmd->len == len) && (cmd->offset == offset) &&
+	    (cmd->chunk_size == CONFIG_PCD_CHUNK_SIZE) && (cmd->crc == crc)) {
+		LOG_INF("Resuming update at chunk %d",
+			(int)atomic_get(&cmd->chunks_done));
+		return 0;
+	}
+
 	cmd->data = data;
 	cmd->len = len;
 	cmd->offset = offset;
+	cmd->chunk_size = CONFIG_PCD_CHUNK_SIZE;
+	cmd->crc = crc;
+	cmd->running_crc = 0;
+	atomic_set(&cmd->chunks_done, 0);
+	cmd->magic = PCD_CMD_MAGIC_COPY;
 
 	return 0;
 }
 
+/** Report the number of bytes copied by the network core. */
+static void progress_report(atomic_val_t done, size_t len)
+{
+	size_t written = MIN(len, done * CONFIG_PCD_CHUNK_SIZE);
+
+	LOG_DBG("Network core update: %d of %d bytes", written, len);
+
+	if (progress_cb) {
+		progress_cb(written, len);
+	}
+}
+
+/** @brief Wait for the network core to complete the copy operation.
+ *
+ * @retval 0 on success.
+ * @retval -EIO if the network core failed the copy.
+ * @retval -ETIMEDOUT if the network core stopped reporting progress.
+ */
+static int pcd_update_wait(size_t len)
+{
+	atomic_val_t num_chunks = DIV_ROUND_UP(len, CONFIG_PCD_CHUNK_SIZE);
+	atomic_val_t reported = atomic_get(&cmd->chunks_done);
+	bool progress = false;
+
+	progress_report(reported, len);
+
+	while (true) {
+		bool evt = evt_wait(CONFIG_PCD_CHUNK_TIMEOUT_MS);
+		enum pcd_status status = pcd_fw_copy_status_get();
+		atomic_val_t done = atomic_get(&cmd->chunks_done);
+
+		if (done != reported) {
+			progress_report(done, len);
+			progress = true;
+			reported = done;
+		} else if (!evt && progress && (done < num_chunks) &&
+			   (status == PCD_STATUS_COPY)) {
+			/* Network core bootloaders that copy in one go never
+			 * report progress, and are waited for until they are
+			 * done, like the image validation before the first
+			 * and after the last chunk.
+			 */
+			return -ETIMEDOUT;
+		}
+
+		if (status == PCD_STATUS_COPY_DONE) {
+			return 0;
+		} else if (status == PCD_STATUS_COPY_FAILED) {
+			LOG_ERR("Network core update failed");
+			return -EIO;
+		}
+	}
+}
+
 int pcd_network_core_update(const void *src_addr, size_t len)
 {
 	int err;
@@ -137,27 +392,35 @@ int pcd_network_core_update(const void *src_addr, size_t len)
 		return err;
 	}
 
-	nrf_reset_network_force_off(NRF_RESET, false);
-	LOG_INF("Turned on network core");
+	evt_enable(true);
 
-	do {
-		/* Wait for 1 second to avoid issue where network core
-		 * is unable to write to shared RAM.
-		 */
-		k_busy_wait(1 * USEC_PER_SEC);
+	for (int retry = 0; ; retry++) {
+		nrf_reset_network_force_off(NRF_RESET, false);
+		LOG_INF("Turned on network core");
 
-		err = pcd_fw_copy_status_get();
-	} while (err == PCD_STATUS_COPY);
+		err = pcd_update_wait(len);
+		if ((err != -ETIMEDOUT) ||
+		    (retry == CONFIG_PCD_RESUME_RETRIES)) {
+			break;
+		}
 
-	if (err == PCD_STATUS_COPY_FAILED) {
-		LOG_ERR("Network core update failed");
-		return err;
+		/* The network core resumes the copy at the last chunk done
+		 * when it is restarted.
+		 */
+		LOG_WRN("Network core update stalled, restarting");
+		nrf_reset_network_force_off(NRF_RESET, true);
 	}
 
+	evt_enable(false);
+
 	nrf_reset_network_force_off(NRF_RESET, true);
 	LOG_INF("Turned off network core");
 
-	return 0;
+	if (err == -ETIMEDOUT) {
+		LOG_ERR("Network core update timed out");
+	}
+
+	return err;
 }
 
 void pcd_lock_ram(void)
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr.h>
+#include <ztest.h>
+#include <date_time.h>
+#include <tinycbor/cbor.h>
+#include <tinycbor/cbor_buf_writer.h>
+
+#include "cloud_codec.h"
+#include "cloud_codec_cbor.h"
+
+#define BENCH_ITERATIONS 100
+#define TEST_TS 1611050000000LL
+#define CMD_MAX 4
+
+static const char *const ui[] = {
+	"GPS", "FLIP", "TEMP", "HUMID", "AIR_PRESS", "BUTTON", "RSRP",
+};
+static const char *const fota[] = { "APP", "MODEM" };
+
+static struct cloud_command cmds[CMD_MAX];
+static char data_string[32];
+static size_t cmd_count;
+static int64_t unix_ts;
+
+/* The timestamps are converted with the date_time library. */
+int date_time_uptime_to_unix_time_ms(int64_t *uptime)
+{
+	*uptime = unix_ts;
+
+	return 0;
+}
+
+void date_time_timestamp_clear(int64_t *unix_timestamp)
+{
+	*unix_timestamp = 0;
+}
+
+static void cmd_handler(struct cloud_command *cmd)
+{
+	zassert_true(cmd_count < CMD_MAX, "Too many commands");
+
+	cmds[cmd_count++] = *cmd;
+
+	/* The string is only valid in the callback. */
+	if (cmd->type == CLOUD_CMD_DATA_STRING) {
+		strncpy(data_string, cmd->data.data_string,
+			sizeof(data_string) - 1);
+	}
+}
+
+static void setup(void)
+{
+	memset(cmds, 0, sizeof(cmds));
+	memset(data_string, 0, sizeof(data_string));
+	cmd_count = 0;
+	unix_ts = TEST_TS;
+
+	cloud_decode_init(cmd_handler);
+}
+
+static void teardown(void)
+{
+}
+
+static const env_sensor_data_t env_data = {
+	.type = ENV_SENSOR_TEMPERATURE,
+	.value = 24.5,
+};
+
+static const motion_data_t motion_data = {
+	.orientation = MOTION_ORIENTATION_UPSIDE_DOWN,
+};
+
+static const struct light_sensor_data light_data = {
+	.red = 120, .green = 340, .blue = 56, .ir = 789,
+};
+
+static char gps_nmea[] =
+	"$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+
+static const struct cloud_channel_data gps_data = {
+	.type = CLOUD_CHANNEL_GPS,
+	.data.buf = gps_nmea,
+	.data.len = sizeof(gps_nmea) - 1,
+};
+
+static int env_json(struct cloud_msg *msg)
+{
+	return cloud_encode_env_sensors_data(&env_data, msg);
+}
+
+static int env_cbor(struct cloud_msg *msg)
+{
+	return cloud_cbor_encode_env_sensors_data(&env_data, msg);
+}
+
+static int motion_json(struct cloud_msg *msg)
+{
+	return cloud_encode_motion_data(&motion_data, msg);
+}
+
+static int motion_cbor(struct cloud_msg *msg)
+{
+	return cloud_cbor_encode_motion_data(&motion_data, msg);
+}
+
+static int gps_json(struct cloud_msg *msg)
+{
+	return cloud_encode_data(&gps_data, CLOUD_CMD_GROUP_DATA, msg);
+}
+
+static int gps_cbor(struct cloud_msg *msg)
+{
+	return cloud_cbor_encode_data(&gps_data, CLOUD_CMD_GROUP_DATA, msg);
+}
+
+static int light_json(struct cloud_msg *msg)
+{
+	return cloud_encode_light_sensor_data(&light_data, msg);
+}
+
+static int light_cbor(struct cloud_msg *msg)
+{
+	return cloud_cbor_encode_light_sensor_data(&light_data, msg);
+}
+
+static int device_status_json(struct cloud_msg *msg)
+{
+	return cloud_encode_device_status_data(NULL, ui, ARRAY_SIZE(ui),
+					       fota, ARRAY_SIZE(fota), 2, msg);
+}
+
+static int device_status_cbor(struct cloud_msg *msg)
+{
+	return cloud_cbor_encode_device_status_data(NULL, ui, ARRAY_SIZE(ui),
+						    fota, ARRAY_SIZE(fota), 2,
+						    msg);
+}
+
+static int config_json(struct cloud_msg *msg)
+{
+	return cloud_encode_config_data(msg);
+}
+
+static int config_cbor(struct cloud_msg *msg)
+{
+	return cloud_cbor_encode_config_data(msg);
+}
+
+static void compare(const char *name, int (*json)(struct cloud_msg *),
+		    int (*cbor)(struct cloud_msg *))
+{
+	uint32_t start, json_cycles, cbor_cycles;
+	struct cloud_msg json_msg, cbor_msg;
+	int err;
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		err = json(&json_msg);
+		zassert_equal(err, 0, "JSON encoding failed for %s", name);
+		cloud_release_data(&json_msg);
+	}
+	json_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		err = cbor(&cbor_msg);
+		zassert_equal(err, 0, "CBOR encoding failed for %s", name);
+		cloud_release_data(&cbor_msg);
+	}
+	cbor_cycles = k_cycle_get_32() - start;
+
+	zassert_true(cbor_msg.len < json_msg.len, "%s not smaller", name);
+
+	TC_PRINT("%s: JSON %u bytes %u cycles, CBOR %u bytes %u cycles\n",
+		 name, (uint32_t)json_msg.len, json_cycles / BENCH_ITERATIONS,
+		 (uint32_t)cbor_msg.len, cbor_cycles / BENCH_ITERATIONS);
+}
+
+/* Compare the message size and encode time with the JSON encoders. Cycle
+ * counts are only meaningful when the test is run on hardware.
+ */
+static void test_cloud_codec_compare(void)
+{
+	struct cloud_command gps_enable = {
+		.group = CLOUD_CMD_GROUP_CFG_SET,
+		.channel = CLOUD_CHANNEL_GPS,
+		.type = CLOUD_CMD_ENABLE,
+		.data.sv.state = CLOUD_CMD_STATE_TRUE,
+	};
+
+	/* The configuration is only sent when the GPS state is known. */
+	zassert_equal(cloud_codec_cmd_dispatch(&gps_enable), 0, NULL);
+
+	compare("Environment", env_json, env_cbor);
+	compare("Motion", motion_json, motion_cbor);
+	compare("GPS", gps_json, gps_cbor);
+	compare("Light sensor", light_json, light_cbor);
+	compare("Device status", device_status_json, device_status_cbor);
+	compare("Configuration", config_json, config_cbor);
+}
+
+static void test_cloud_codec_cbor_max_len(void)
+{
+	static const struct light_sensor_data light_max = {
+		.red = INT32_MIN, .green = INT32_MIN,
+		.blue = INT32_MIN, .ir = INT32_MIN,
+	};
+	static const env_sensor_data_t env_max = {
+		.type = ENV_SENSOR_AIR_QUALITY,
+		.value = -1e30,
+	};
+	struct cloud_msg msg;
+	int err;
+
+	/* The buffers fit the longest encoding of each value. */
+	unix_ts = INT64_MIN;
+
+	err = cloud_cbor_encode_light_sensor_data(&light_max, &msg);
+	zassert_equal(err, 0, "Light sensor data encoding failed: %d", err);
+	cloud_release_data(&msg);
+
+	err = cloud_cbor_encode_env_sensors_data(&env_max, &msg);
+	zassert_equal(err, 0, "Environment data encoding failed: %d", err);
+	cloud_release_data(&msg);
+
+	err = motion_cbor(&msg);
+	zassert_equal(err, 0, "Motion data encoding failed: %d", err);
+	cloud_release_data(&msg);
+
+	err = gps_cbor(&msg);
+	zassert_equal(err, 0, "GPS data encoding failed: %d", err);
+	cloud_release_data(&msg);
+}
+
+static void test_cloud_codec_cbor_decode_cmd(void)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder enc, map, data;
+	uint8_t buf[64];
+	int err;
+
+	cbor_buf_writer_init(&writer, buf, sizeof(buf));
+	cbor_encoder_init(&enc, &writer.enc, 0);
+	cbor_encoder_create_map(&enc, &map, 3);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_GROUP);
+	cbor_encode_uint(&map, CLOUD_CMD_GROUP_CFG_SET);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_CHANNEL);
+	cbor_encode_uint(&map, CLOUD_CHANNEL_GPS);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_DATA);
+	cbor_encoder_create_map(&map, &data, 2);
+	cbor_encode_uint(&data, CLOUD_CMD_ENABLE);
+	cbor_encode_boolean(&data, false);
+	cbor_encode_uint(&data, CLOUD_CMD_INTERVAL);
+	cbor_encode_uint(&data, 2);
+	cbor_encoder_close_container(&map, &data);
+	err = cbor_encoder_close_container(&enc, &map);
+	zassert_equal(err, CborNoError, NULL);
+
+	err = cloud_cbor_decode_command(buf, writer.ptr - buf);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cmd_count, 2, NULL);
+
+	zassert_equal(cmds[0].channel, CLOUD_CHANNEL_GPS, NULL);
+	zassert_equal(cmds[0].type, CLOUD_CMD_ENABLE, NULL);
+	zassert_equal(cmds[0].data.sv.state, CLOUD_CMD_STATE_FALSE, NULL);
+
+	/* The interval is validated like a JSON command. */
+	zassert_equal(cmds[1].type, CLOUD_CMD_INTERVAL, NULL);
+	zassert_equal(cmds[1].data.sv.value, 5, NULL);
+	zassert_equal(cloud_get_channel_enable_state(CLOUD_CHANNEL_GPS),
+		      CLOUD_CMD_STATE_FALSE, NULL);
+}
+
+static void test_cloud_codec_cbor_decode_config(void)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder enc, map, config, chan;
+	uint8_t buf[64];
+	int err;
+
+	cbor_buf_writer_init(&writer, buf, sizeof(buf));
+	cbor_encoder_init(&enc, &writer.enc, 0);
+	cbor_encoder_create_map(&enc, &map, 1);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_CONFIG);
+	cbor_encoder_create_map(&map, &config, 2);
+	cbor_encode_uint(&config, CLOUD_CHANNEL_TEMP);
+	cbor_encoder_create_map(&config, &chan, 1);
+	cbor_encode_uint(&chan, CLOUD_CMD_THRESHOLD_HIGH);
+	cbor_encode_float(&chan, 30.5f);
+	cbor_encoder_close_container(&config, &chan);
+	/* Not a configurable command, must be ignored. */
+	cbor_encode_uint(&config, CLOUD_CHANNEL_FLIP);
+	cbor_encoder_create_map(&config, &chan, 1);
+	cbor_encode_uint(&chan, CLOUD_CMD_ENABLE);
+	cbor_encode_boolean(&chan, true);
+	cbor_encoder_close_container(&config, &chan);
+	cbor_encoder_close_container(&map, &config);
+	err = cbor_encoder_close_container(&enc, &map);
+	zassert_equal(err, CborNoError, NULL);
+
+	err = cloud_cbor_decode_command(buf, writer.ptr - buf);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cmd_count, 1, NULL);
+	zassert_equal(cmds[0].group, CLOUD_CMD_GROUP_CFG_SET, NULL);
+	zassert_equal(cmds[0].channel, CLOUD_CHANNEL_TEMP, NULL);
+	zassert_equal(cmds[0].type, CLOUD_CMD_THRESHOLD_HIGH, NULL);
+	zassert_equal(cmds[0].data.sv.value, 30.5, NULL);
+}
+
+static void test_cloud_codec_cbor_decode_string(void)
+{
+	struct cbor_buf_writer writer;
+	CborEncoder enc, map, data;
+	uint8_t buf[64];
+	int err;
+
+	cbor_buf_writer_init(&writer, buf, sizeof(buf));
+	cbor_encoder_init(&enc, &writer.enc, 0);
+	cbor_encoder_create_map(&enc, &map, 3);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_GROUP);
+	cbor_encode_uint(&map, CLOUD_CMD_GROUP_COMMAND);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_CHANNEL);
+	cbor_encode_uint(&map, CLOUD_CHANNEL_MODEM);
+	cbor_encode_uint(&map, CLOUD_CBOR_KEY_DATA);
+	cbor_encoder_create_map(&map, &data, 1);
+	cbor_encode_uint(&data, CLOUD_CMD_DATA_STRING);
+	cbor_encode_text_stringz(&data, "AT+CFUN?");
+	cbor_encoder_close_container(&map, &data);
+	err = cbor_encoder_close_container(&enc, &map);
+	zassert_equal(err, CborNoError, NULL);
+
+	err = cloud_cbor_decode_command(buf, writer.ptr - buf);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(cmd_count, 1, NULL);
+	zassert_equal(cmds[0].type, CLOUD_CMD_DATA_STRING, NULL);
+	zassert_true(strcmp(data_string, "AT+CFUN?") == 0, NULL);
+
+	/* Not a CBOR map. */
+	err = cloud_cbor_decode_command((const uint8_t *)"{}", 2);
+	zassert_equal(err, -ENOENT, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cloud_codec_test,
+		ztest_unit_test_setup_teardown(
+			test_cloud_codec_compare, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_codec_cbor_max_len, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_codec_cbor_decode_cmd, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_codec_cbor_decode_config, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_codec_cbor_decode_string, setup, teardown)
+	);
+
+	ztest_run_test_suite(cloud_codec_test);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+
+#include "ble_rx_buf.h"
+
+#define BUF_COUNT CONFIG_BRIDGE_BLE_RX_BUF_COUNT
+#define STREAM_LEN (64 * 1024)
+/* Data rate of a peer writing with 2M PHY and data length extension */
+#define BLE_RATE 170000
+/* Data rate of the UART at 1000000 baud */
+#define UART_RATE 100000
+
+struct rx_block {
+	struct ble_data_buf *buf;
+	size_t len;
+};
+
+/* Stand-in for the UART handler, which sends the blocks in order. */
+static struct rx_block uart_queue[BUF_COUNT];
+static size_t queue_head;
+static size_t queue_count;
+static size_t queue_sent;
+
+static uint8_t stream[STREAM_LEN];
+static uint8_t uart_out[STREAM_LEN];
+static size_t uart_out_len;
+
+static void uart_queue_submit(struct ble_data_buf *buf, size_t len)
+{
+	zassert_true(queue_count < BUF_COUNT, "More blocks than credits");
+
+	uart_queue[(queue_head + queue_count) % BUF_COUNT].buf = buf;
+	uart_queue[(queue_head + queue_count) % BUF_COUNT].len = len;
+	queue_count++;
+}
+
+/* Send up to len bytes on the UART, releasing the blocks that are done. */
+static void uart_send(size_t len)
+{
+	while ((len > 0) && (queue_count > 0)) {
+		struct rx_block *block = &uart_queue[queue_head];
+		size_t send_len = MIN(len, block->len - queue_sent);
+
+		memcpy(&uart_out[uart_out_len], &block->buf->data[queue_sent],
+		       send_len);
+		uart_out_len += send_len;
+		queue_sent += send_len;
+		len -= send_len;
+
+		if (queue_sent == block->len) {
+			ble_data_buf_unref(block->buf);
+			queue_head = (queue_head + 1) % BUF_COUNT;
+			queue_count--;
+			queue_sent = 0;
+		}
+	}
+}
+
+static void setup(void)
+{
+	for (size_t i = 0; i < sizeof(stream); i++) {
+		stream[i] = (uint8_t)(i * 31 + (i >> 8));
+	}
+
+	queue_head = 0;
+	queue_count = 0;
+	queue_sent = 0;
+	uart_out_len = 0;
+
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT, "Blocks not released");
+}
+
+static void test_split_write(void)
+{
+	uint16_t len = 3 * BLE_RX_DATA_SIZE + 5;
+
+	zassert_true(ble_rx_buf_accept(len), NULL);
+	zassert_equal(ble_rx_buf_put(stream, len, uart_queue_submit), 0,
+		      NULL);
+	zassert_equal(queue_count, 4, "%d blocks", queue_count);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 4, NULL);
+
+	uart_send(len);
+	zassert_equal(uart_out_len, len, NULL);
+	zassert_mem_equal(uart_out, stream, len, "Data corrupted");
+}
+
+static void test_credits(void)
+{
+	struct ble_rx_buf_stats before, after;
+
+	ble_rx_buf_stats_get(&before);
+
+	for (size_t i = 0; i < BUF_COUNT; i++) {
+		zassert_true(ble_rx_buf_accept(BLE_RX_DATA_SIZE), NULL);
+		zassert_equal(ble_rx_buf_put(stream, BLE_RX_DATA_SIZE,
+					     uart_queue_submit), 0, NULL);
+	}
+
+	/* Without credits, writes are refused and counted. */
+	zassert_false(ble_rx_buf_accept(1), "Write accepted without credits");
+	zassert_equal(ble_rx_buf_put(stream, 10, uart_queue_submit), -ENOBUFS,
+		      NULL);
+
+	ble_rx_buf_stats_get(&after);
+	zassert_equal(after.dropped_writes - before.dropped_writes, 2, NULL);
+	zassert_equal(after.dropped_bytes - before.dropped_bytes, 11, NULL);
+
+	/* A credit is returned when the UART has sent a block. */
+	uart_send(BLE_RX_DATA_SIZE);
+	zassert_equal(ble_rx_buf_credits(), 1, NULL);
+	zassert_true(ble_rx_buf_accept(BLE_RX_DATA_SIZE), NULL);
+	zassert_false(ble_rx_buf_accept(BLE_RX_DATA_SIZE + 1), NULL);
+
+	uart_send(SIZE_MAX);
+}
+
+/* Loop the stream from the peer to the UART, in steps of one millisecond of
+ * modelled time at the rates above. This checks the credit flow, not the
+ * speed: the time used by the real path is measured by the uart_handler test.
+ * A refused write request is retried by the peer, a refused write command
+ * is lost. Returns the time used, in milliseconds.
+ */
+static uint32_t loopback_run(bool write_req)
+{
+	uint32_t ble_budget = 0;
+	uint32_t uart_budget = 0;
+	uint32_t ms = 0;
+	size_t pos = 0;
+
+	while ((pos < sizeof(stream)) || (queue_count > 0)) {
+		ble_budget += BLE_RATE;
+		while (pos < sizeof(stream)) {
+			uint16_t len = MIN(BLE_RX_DATA_SIZE,
+					   sizeof(stream) - pos);
+
+			if (ble_budget < len * 1000) {
+				break;
+			}
+
+			if (ble_rx_buf_accept(len)) {
+				zassert_equal(ble_rx_buf_put(&stream[pos], len,
+							     uart_queue_submit),
+					      0, NULL);
+			} else if (write_req) {
+				/* Retried after the response. */
+				ble_budget = 0;
+				break;
+			}
+
+			ble_budget -= len * 1000;
+			pos += len;
+		}
+
+		uart_budget += UART_RATE;
+		uart_send(uart_budget / 1000);
+		uart_budget %= 1000;
+		ms++;
+	}
+
+	return ms;
+}
+
+static void test_loopback_write_req(void)
+{
+	struct ble_rx_buf_stats before, after;
+	uint32_t ms;
+
+	ble_rx_buf_stats_get(&before);
+	ms = loopback_run(true);
+	ble_rx_buf_stats_get(&after);
+
+	TC_PRINT("Write requests: %u writes refused\n",
+		 after.dropped_writes - before.dropped_writes);
+
+	zassert_equal(uart_out_len, sizeof(stream), "Data lost");
+	zassert_mem_equal(uart_out, stream, sizeof(stream), "Data corrupted");
+	zassert_true(uart_out_len * 1000 / ms >= UART_RATE * 95 / 100,
+		     "UART not kept busy");
+}
+
+static void test_loopback_write_cmd(void)
+{
+	struct ble_rx_buf_stats before, after;
+	uint32_t dropped;
+
+	ble_rx_buf_stats_get(&before);
+	(void)loopback_run(false);
+	ble_rx_buf_stats_get(&after);
+	dropped = after.dropped_bytes - before.dropped_bytes;
+
+	TC_PRINT("Write commands: %u bytes dropped\n", dropped);
+
+	/* The peer is faster than the UART, so data is lost, and all of it
+	 * is counted.
+	 */
+	zassert_true(dropped > 0, "No data dropped");
+	zassert_equal(uart_out_len + dropped, sizeof(stream),
+		      "Dropped data not counted");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(bridge_ble_rx_buf,
+		ztest_unit_test_setup_teardown(test_split_write,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_credits,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_loopback_write_req,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_loopback_write_cmd,
+			setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(bridge_ble_rx_buf);
+}
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <drivers/uart.h>
+
+#define MODULE main
+#include "module_state_event.h"
+#include "peer_conn_event.h"
+#include "ble_data_event.h"
+#include "ble_rx_buf.h"
+
+#define BUF_COUNT CONFIG_BRIDGE_BLE_RX_BUF_COUNT
+#define STREAM_LEN (32 * 1024)
+#define EVENT_TIMEOUT K_SECONDS(1)
+
+/* UART device with the asynchronous API. Transfers are completed by the
+ * test, in place of the interrupt.
+ */
+struct test_uart_data {
+	uart_callback_t callback;
+	void *user_data;
+	const uint8_t *tx_buf;
+	size_t tx_len;
+	uint32_t tx_count;
+	int tx_err;
+};
+
+static struct test_uart_data uart_data[2];
+
+static uint8_t stream[STREAM_LEN];
+static uint8_t uart_out[STREAM_LEN];
+static size_t uart_out_len;
+
+static K_SEM_DEFINE(event_sem, 0, K_SEM_MAX_LIMIT);
+
+static int test_uart_callback_set(const struct device *dev,
+				  uart_callback_t callback, void *user_data)
+{
+	struct test_uart_data *data = dev->data;
+
+	data->callback = callback;
+	data->user_data = user_data;
+
+	return 0;
+}
+
+static int test_uart_tx(const struct device *dev, const uint8_t *buf,
+			size_t len, int32_t timeout)
+{
+	struct test_uart_data *data = dev->data;
+
+	data->tx_count++;
+
+	if (data->tx_err) {
+		return data->tx_err;
+	}
+
+	zassert_is_null(data->tx_buf, "Transfer already ongoing");
+	data->tx_buf = buf;
+	data->tx_len = len;
+
+	return 0;
+}
+
+static int test_uart_tx_abort(const struct device *dev)
+{
+	return -ENOTSUP;
+}
+
+static int test_uart_rx_enable(const struct device *dev, uint8_t *buf,
+			       size_t len, int32_t timeout)
+{
+	return 0;
+}
+
+static int test_uart_rx_buf_rsp(const struct device *dev, uint8_t *buf,
+				size_t len)
+{
+	return 0;
+}
+
+static int test_uart_rx_disable(const struct device *dev)
+{
+	return 0;
+}
+
+static int test_uart_poll_in(const struct device *dev, unsigned char *c)
+{
+	return -1;
+}
+
+static void test_uart_poll_out(const struct device *dev, unsigned char c)
+{
+}
+
+static int test_uart_configure(const struct device *dev,
+			       const struct uart_config *cfg)
+{
+	return 0;
+}
+
+static int test_uart_config_get(const struct device *dev,
+				struct uart_config *cfg)
+{
+	cfg->baudrate = 1000000;
+	cfg->parity = UART_CFG_PARITY_NONE;
+	cfg->stop_bits = UART_CFG_STOP_BITS_1;
+	cfg->data_bits = UART_CFG_DATA_BITS_8;
+	cfg->flow_ctrl = UART_CFG_FLOW_CTRL_RTS_CTS;
+
+	return 0;
+}
+
+static int test_uart_init(const struct device *dev)
+{
+	return 0;
+}
+
+static const struct uart_driver_api test_uart_api = {
+	.callback_set = test_uart_callback_set,
+	.tx = test_uart_tx,
+	.tx_abort = test_uart_tx_abort,
+	.rx_enable = test_uart_rx_enable,
+	.rx_buf_rsp = test_uart_rx_buf_rsp,
+	.rx_disable = test_uart_rx_disable,
+	.poll_in = test_uart_poll_in,
+	.poll_out = test_uart_poll_out,
+	.configure = test_uart_configure,
+	.config_get = test_uart_config_get,
+};
+
+DEVICE_DEFINE(test_uart0, "UART_0",
+	      test_uart_init, device_pm_control_nop, &uart_data[0], NULL,
+	      POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &test_uart_api);
+
+DEVICE_DEFINE(test_uart1, "UART_1",
+	      test_uart_init, device_pm_control_nop, &uart_data[1], NULL,
+	      POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &test_uart_api);
+
+/* Complete the ongoing transfer on UART_0 as the driver would. */
+static void uart_tx_complete(enum uart_event_type type)
+{
+	struct test_uart_data *data = &uart_data[0];
+	const struct device *dev = device_get_binding("UART_0");
+	struct uart_event evt = {
+		.type = type,
+	};
+
+	zassert_not_null(data->tx_buf, "No transfer ongoing");
+
+	evt.data.tx.buf = data->tx_buf;
+	evt.data.tx.len = data->tx_len;
+
+	if (type == UART_TX_DONE) {
+		zassert_true(uart_out_len + data->tx_len <= sizeof(uart_out),
+			     "Too much data sent");
+		memcpy(&uart_out[uart_out_len], data->tx_buf, data->tx_len);
+		uart_out_len += data->tx_len;
+	}
+
+	data->tx_buf = NULL;
+	data->tx_len = 0;
+
+	data->callback(dev, &evt, data->user_data);
+}
+
+static void event_wait(void)
+{
+	zassert_equal(k_sem_take(&event_sem, EVENT_TIMEOUT), 0,
+		      "Event not processed");
+}
+
+/* Submit the blocks as the BLE handler does. */
+static void ble_rx_buf_submit(struct ble_data_buf *buf, size_t len)
+{
+	struct ble_data_event *event = new_ble_data_event();
+
+	event->owner = buf;
+	event->buf = buf->data;
+	event->len = len;
+	EVENT_SUBMIT(event);
+}
+
+/* Put one block of data, and wait until the UART handler has it. */
+static void ble_put(const uint8_t *data, uint16_t len)
+{
+	zassert_true(len <= BLE_RX_DATA_SIZE, NULL);
+	zassert_true(ble_rx_buf_accept(len), "No credits");
+	zassert_equal(ble_rx_buf_put(data, len, ble_rx_buf_submit), 0, NULL);
+	event_wait();
+}
+
+static void test_init(void)
+{
+	struct peer_conn_event *event;
+
+	zassert_false(event_manager_init(), "Error when initializing");
+
+	module_set_state(MODULE_STATE_READY);
+	event_wait();
+
+	/* The UART callback is set when the first peer connects. */
+	event = new_peer_conn_event();
+	event->peer_id = PEER_ID_BLE;
+	event->dev_idx = 0;
+	event->conn_state = PEER_STATE_CONNECTED;
+	event->baudrate = 0;
+	EVENT_SUBMIT(event);
+	event_wait();
+
+	zassert_not_null(uart_data[0].callback, "UART_0 not opened");
+}
+
+static void setup(void)
+{
+	for (size_t i = 0; i < sizeof(stream); i++) {
+		stream[i] = (uint8_t)(i * 31 + (i >> 8));
+	}
+
+	uart_data[0].tx_count = 0;
+	uart_data[0].tx_err = 0;
+	uart_out_len = 0;
+
+	zassert_is_null(uart_data[0].tx_buf, "Transfer left ongoing");
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT, "Blocks not released");
+}
+
+static void test_tx_done(void)
+{
+	ble_put(stream, BLE_RX_DATA_SIZE);
+
+	/* The block is sent from the BLE RX buffer, without copying. */
+	zassert_equal(uart_data[0].tx_count, 1, NULL);
+	zassert_equal(uart_data[0].tx_len, BLE_RX_DATA_SIZE, NULL);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 1,
+		      "Block released before the transfer is done");
+
+	ble_put(&stream[BLE_RX_DATA_SIZE], 10);
+	zassert_equal(uart_data[0].tx_count, 1, "Transfers overlap");
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 2, NULL);
+
+	/* Each block is released when its transfer is done. */
+	uart_tx_complete(UART_TX_DONE);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 1, NULL);
+	zassert_equal(uart_data[0].tx_count, 2, "Next block not sent");
+
+	uart_tx_complete(UART_TX_DONE);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT, NULL);
+	zassert_is_null(uart_data[0].tx_buf, NULL);
+
+	zassert_equal(uart_out_len, BLE_RX_DATA_SIZE + 10, NULL);
+	zassert_mem_equal(uart_out, stream, uart_out_len, "Data corrupted");
+}
+
+static void test_tx_error(void)
+{
+	uart_data[0].tx_err = -EIO;
+
+	/* The block is released when the transfer can not be started. */
+	ble_put(stream, BLE_RX_DATA_SIZE);
+	zassert_equal(uart_data[0].tx_count, 1, NULL);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT,
+		      "Block not released on error");
+
+	/* The next block is sent once the UART works again. */
+	uart_data[0].tx_err = 0;
+	ble_put(stream, 10);
+	zassert_equal(uart_data[0].tx_count, 2, "UART left blocked");
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 1, NULL);
+
+	uart_tx_complete(UART_TX_DONE);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT, NULL);
+	zassert_equal(uart_out_len, 10, NULL);
+}
+
+static void test_tx_aborted(void)
+{
+	ble_put(stream, BLE_RX_DATA_SIZE);
+	ble_put(&stream[BLE_RX_DATA_SIZE], BLE_RX_DATA_SIZE);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 2, NULL);
+
+	/* The aborted block is released, the queued one is kept. */
+	uart_tx_complete(UART_TX_ABORTED);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT - 1,
+		      "Block not released on abort");
+	zassert_is_null(uart_data[0].tx_buf, NULL);
+
+	/* New data restarts the UART with the queued block first. */
+	ble_put(&stream[2 * BLE_RX_DATA_SIZE], 10);
+	zassert_equal(uart_data[0].tx_count, 2, NULL);
+	zassert_equal(uart_data[0].tx_len, BLE_RX_DATA_SIZE, NULL);
+	zassert_mem_equal(uart_data[0].tx_buf, &stream[BLE_RX_DATA_SIZE],
+			  BLE_RX_DATA_SIZE, "Blocks out of order");
+
+	uart_tx_complete(UART_TX_DONE);
+	uart_tx_complete(UART_TX_DONE);
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT, NULL);
+
+	zassert_equal(uart_out_len, BLE_RX_DATA_SIZE + 10, NULL);
+	zassert_mem_equal(uart_out, &stream[BLE_RX_DATA_SIZE], uart_out_len,
+			  "Data corrupted");
+}
+
+/* Forward a stream through the RX blocks, the event manager and the UART
+ * handler. The UART completes each transfer at once, so the time measured
+ * is the time used by the software path alone.
+ */
+static void test_throughput(void)
+{
+	uint32_t start;
+	uint32_t cycles;
+	uint64_t us;
+	size_t pos = 0;
+
+	start = k_cycle_get_32();
+
+	while (pos < sizeof(stream)) {
+		uint16_t len = MIN(BLE_RX_DATA_SIZE, sizeof(stream) - pos);
+
+		if (ble_rx_buf_accept(len)) {
+			zassert_equal(ble_rx_buf_put(&stream[pos], len,
+						     ble_rx_buf_submit),
+				      0, NULL);
+			event_wait();
+			pos += len;
+		} else {
+			uart_tx_complete(UART_TX_DONE);
+		}
+	}
+
+	while (uart_data[0].tx_buf) {
+		uart_tx_complete(UART_TX_DONE);
+	}
+
+	cycles = k_cycle_get_32() - start;
+	us = k_cyc_to_us_floor64(cycles);
+
+	zassert_equal(uart_out_len, sizeof(stream), "Data lost");
+	zassert_mem_equal(uart_out, stream, sizeof(stream), "Data corrupted");
+	zassert_equal(ble_rx_buf_credits(), BUF_COUNT, NULL);
+
+	if (us > 0) {
+		TC_PRINT("%u bytes in %u us: %u B/s\n", STREAM_LEN,
+			 (uint32_t)us,
+			 (uint32_t)(STREAM_LEN * 1000000ULL / us));
+	} else {
+		/* The cycle counter is not running during the test. */
+		TC_PRINT("%u bytes in %u cycles, time not measurable\n",
+			 STREAM_LEN, cycles);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(bridge_uart_handler,
+		ztest_unit_test(test_init),
+		ztest_unit_test_setup_teardown(test_tx_done,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_tx_error,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_tx_aborted,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_throughput,
+			setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(bridge_uart_handler);
+}
+
+static bool event_handler(const struct event_header *eh)
+{
+	if (is_ble_data_event(eh)) {
+		const struct ble_data_event *event = cast_ble_data_event(eh);
+
+		/* All subscribers have gotten a chance to take a reference */
+		ble_data_buf_unref(event->owner);
+	}
+
+	k_sem_give(&event_sem);
+
+	return false;
+}
+
+EVENT_LISTENER(MODULE, event_handler);
+EVENT_SUBSCRIBE_FINAL(MODULE, module_state_event);
+EVENT_SUBSCRIBE_FINAL(MODULE, peer_conn_event);
+EVENT_SUBSCRIBE_FINAL(MODULE, ble_data_event);
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+
+#include "drr.h"
+
+#define FLOW_COUNT	3
+#define QUANTUM		16
+#define ITEM_MAX_COUNT	64
+#define NOT_SERVED	-1
+
+/* Flows with items of fixed sizes, like peripherals that send reports. */
+struct flow {
+	int item_size;
+	size_t item_cnt;
+	size_t sent_cnt;
+	size_t sent_bytes;
+};
+
+static struct flow flows[FLOW_COUNT];
+static size_t deficit[FLOW_COUNT];
+static uint8_t last;
+
+static int item_size_get(size_t flow, void *user_data)
+{
+	zassert_equal_ptr(user_data, flows, NULL);
+	zassert_true(flow < FLOW_COUNT, NULL);
+
+	if (flows[flow].item_size == NOT_SERVED) {
+		return -ENOENT;
+	}
+
+	return (flows[flow].item_cnt > 0) ? flows[flow].item_size : 0;
+}
+
+/* Select a flow and take its item. */
+static int send_next(void)
+{
+	int flow = drr_next(deficit, FLOW_COUNT, QUANTUM, &last,
+			    item_size_get, flows);
+
+	if (flow >= 0) {
+		zassert_true(flows[flow].item_cnt > 0, "Empty flow selected");
+		flows[flow].item_cnt--;
+		flows[flow].sent_cnt++;
+		flows[flow].sent_bytes += flows[flow].item_size;
+	}
+
+	return flow;
+}
+
+static size_t bytes_diff(size_t flow_a, size_t flow_b)
+{
+	size_t a = flows[flow_a].sent_bytes;
+	size_t b = flows[flow_b].sent_bytes;
+
+	return (a > b) ? (a - b) : (b - a);
+}
+
+static void flows_set(int size0, int size1, int size2)
+{
+	int sizes[] = { size0, size1, size2 };
+
+	for (size_t i = 0; i < FLOW_COUNT; i++) {
+		flows[i].item_size = sizes[i];
+		flows[i].item_cnt = (sizes[i] > 0) ? ITEM_MAX_COUNT : 0;
+		flows[i].sent_cnt = 0;
+		flows[i].sent_bytes = 0;
+	}
+}
+
+static void setup(void)
+{
+	memset(deficit, 0, sizeof(deficit));
+	last = 0;
+}
+
+static void test_no_items(void)
+{
+	flows_set(0, 0, NOT_SERVED);
+	flows[2].item_cnt = ITEM_MAX_COUNT;
+
+	zassert_equal(send_next(), -ENOENT, "Flow selected without items");
+}
+
+static void test_fair_bytes(void)
+{
+	/* Small mouse reports against large reports of another peripheral. */
+	flows_set(6, 30, 0);
+
+	for (size_t i = 0; i < ITEM_MAX_COUNT; i++) {
+		zassert_true(send_next() >= 0, NULL);
+	}
+
+	/* Every flow gets the same share of the bytes, not of the items. */
+	zassert_true(bytes_diff(0, 1) <= 30 + QUANTUM,
+		     "Unfair share: %u and %u bytes",
+		     flows[0].sent_bytes, flows[1].sent_bytes);
+	zassert_true(flows[0].sent_cnt > flows[1].sent_cnt, NULL);
+	zassert_equal(deficit[2], 0, "Deficit of an empty flow kept");
+}
+
+static void test_not_served(void)
+{
+	flows_set(6, NOT_SERVED, 6);
+	flows[1].item_cnt = ITEM_MAX_COUNT;
+
+	for (size_t i = 0; i < ITEM_MAX_COUNT; i++) {
+		zassert_not_equal(send_next(), 1, "Flow not served selected");
+	}
+
+	zassert_equal(deficit[1], 0, "Flow not served credited");
+	zassert_true(bytes_diff(0, 2) <= 6 + QUANTUM, NULL);
+}
+
+static void test_large_item(void)
+{
+	/* An item larger than the quantum waits for a few turns. */
+	flows_set(3 * QUANTUM + 1, 0, 0);
+
+	zassert_equal(send_next(), 0, NULL);
+	zassert_true(deficit[0] < QUANTUM, "Deficit not used");
+}
+
+static void test_drained_flow(void)
+{
+	flows_set(30, 6, 0);
+	flows[0].item_cnt = 1;
+
+	/* The deficit left by a flow is cleared once it has no items. */
+	while (flows[0].item_cnt > 0) {
+		zassert_true(send_next() >= 0, NULL);
+	}
+
+	zassert_equal(send_next(), 1, NULL);
+	zassert_equal(deficit[0], 0, "Deficit of a drained flow kept");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(drr_test,
+		ztest_unit_test_setup_teardown(test_no_items,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_fair_bytes,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_not_served,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_large_item,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_drained_flow,
+			setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(drr_test);
+}
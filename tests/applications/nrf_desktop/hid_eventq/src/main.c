@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+
+#include "hid_eventq.h"
+
+#define QUEUE_SIZE		12
+#define EXPIRATION		500
+#define STORM_KEYSTROKES	10000
+#define STORM_KEY_COUNT		6
+
+static struct hid_eventq eventq;
+static struct hid_eventq_event eventq_buf[QUEUE_SIZE];
+static size_t malloc_cnt;
+
+void *__real_k_malloc(size_t size);
+
+void *__wrap_k_malloc(size_t size)
+{
+	malloc_cnt++;
+
+	return __real_k_malloc(size);
+}
+
+static void test_setup(void)
+{
+	hid_eventq_init(&eventq, eventq_buf, ARRAY_SIZE(eventq_buf));
+	malloc_cnt = 0;
+}
+
+static void test_order(void)
+{
+	struct hid_eventq_event event;
+
+	/* Move the beginning of the ring, so that the events wrap around. */
+	for (size_t i = 0; i < QUEUE_SIZE / 2; i++) {
+		zassert_equal(hid_eventq_append(&eventq, 0, 0, 0), 0,
+			      "Append failed");
+		zassert_true(hid_eventq_get(&eventq, &event), "Get failed");
+	}
+
+	for (size_t i = 0; i < QUEUE_SIZE; i++) {
+		zassert_equal(hid_eventq_append(&eventq, i, 1, i), 0,
+			      "Append failed");
+	}
+
+	zassert_true(hid_eventq_is_full(&eventq), "Queue not full");
+	zassert_equal(hid_eventq_append(&eventq, 0, 1, 0), -ENOMEM,
+		      "Append to full queue");
+
+	for (size_t i = 0; i < QUEUE_SIZE; i++) {
+		zassert_true(hid_eventq_get(&eventq, &event), "Get failed");
+		zassert_equal(event.usage_id, i, "Wrong order");
+		zassert_equal(event.timestamp, i, "Wrong timestamp");
+	}
+
+	zassert_true(hid_eventq_is_empty(&eventq), "Queue not empty");
+	zassert_false(hid_eventq_get(&eventq, &event), "Get from empty queue");
+}
+
+static void test_cleanup_paired(void)
+{
+	struct hid_eventq_event event;
+
+	/* Key A is pressed and released, key B is pressed. */
+	hid_eventq_append(&eventq, 0x04, 1, 0);
+	hid_eventq_append(&eventq, 0x04, -1, 10);
+	hid_eventq_append(&eventq, 0x05, 1, 20);
+
+	zassert_equal(hid_eventq_cleanup(&eventq, 10, EXPIRATION), 0,
+		      "Valid events removed");
+
+	/* Key B press must be kept until its release is enqueued. */
+	zassert_equal(hid_eventq_cleanup(&eventq, 1000, EXPIRATION), 2,
+		      "Wrong number of expired events");
+	zassert_equal(eventq.len, 1, "Wrong queue length");
+
+	zassert_true(hid_eventq_get(&eventq, &event), "Get failed");
+	zassert_equal(event.usage_id, 0x05, "Wrong event kept");
+}
+
+static void test_cleanup_unpaired(void)
+{
+	/* Key A is pressed before key B is pressed and released. */
+	hid_eventq_append(&eventq, 0x04, 1, 0);
+	hid_eventq_append(&eventq, 0x05, 1, 10);
+	hid_eventq_append(&eventq, 0x05, -1, 20);
+
+	zassert_equal(hid_eventq_cleanup(&eventq, 1000, EXPIRATION), 0,
+		      "Unpaired key press removed");
+	zassert_equal(eventq.len, 3, "Wrong queue length");
+}
+
+/* Simulate the disconnected state of hid_state: keystrokes are enqueued,
+ * expired ones are removed and the queue is emptied when it cannot take
+ * a keystroke. Every few keystrokes the connection is established and the
+ * queue is replayed.
+ */
+static void test_storm(void)
+{
+	struct hid_eventq_event event;
+	uint32_t timestamp = 0;
+	uint32_t cycles = 0;
+	uint32_t cycles_max = 0;
+	size_t dropped = 0;
+	size_t replayed = 0;
+
+	for (size_t i = 0; i < STORM_KEYSTROKES; i++) {
+		uint16_t usage_id = 0x04 + (i % STORM_KEY_COUNT);
+		uint32_t start = k_cycle_get_32();
+
+		for (int16_t value = 1; value >= -1; value -= 2) {
+			timestamp += 7;
+			hid_eventq_cleanup(&eventq, timestamp, EXPIRATION);
+
+			if (hid_eventq_is_full(&eventq)) {
+				dropped += eventq.len;
+				hid_eventq_reset(&eventq);
+			}
+
+			zassert_equal(hid_eventq_append(&eventq, usage_id,
+							value, timestamp),
+				      0, "Append failed");
+		}
+
+		if ((i % 5) == 4) {
+			while (hid_eventq_get(&eventq, &event)) {
+				replayed++;
+			}
+		}
+
+		uint32_t diff = k_cycle_get_32() - start;
+
+		cycles += diff;
+		cycles_max = MAX(cycles_max, diff);
+	}
+
+	TC_PRINT("Keystrokes: %u, replayed events: %u, dropped events: %u\n",
+		 STORM_KEYSTROKES, replayed, dropped);
+	TC_PRINT("Heap allocations: %u\n", malloc_cnt);
+	TC_PRINT("Cycles per keystroke: avg %u, max %u\n",
+		 cycles / STORM_KEYSTROKES, cycles_max);
+
+	zassert_equal(malloc_cnt, 0, "Queue allocated memory");
+	zassert_true(replayed > 0, "No events replayed");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hid_eventq_tests,
+			 ztest_unit_test_setup_teardown(test_order,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_cleanup_paired,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_cleanup_unpaired,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_storm,
+							test_setup,
+							unit_test_noop)
+			 );
+
+	ztest_run_test_suite(hid_eventq_tests);
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+
+#include "hid_keymap_index.h"
+#include "key_id.h"
+
+/* Keyboard matrix with a function layer, like the one of a desktop
+ * keyboard.
+ */
+#define COL_COUNT	18
+#define ROW_COUNT	6
+#define FN_KEY_COUNT	30
+#define KEYMAP_SIZE	(COL_COUNT * ROW_COUNT + FN_KEY_COUNT)
+#define FN_BIT		BIT(14)
+
+#define LOOKUP_COUNT	100000
+
+static struct hid_keymap keymap[KEYMAP_SIZE];
+static uint8_t slot[HID_KEYMAP_INDEX_SIZE(KEYMAP_SIZE)];
+static struct hid_keymap_index keymap_idx;
+
+/* Binary search over the sorted keymap, used as reference. */
+static const struct hid_keymap *keymap_bsearch(uint16_t key_id)
+{
+	ssize_t lower = 0;
+	ssize_t upper = ARRAY_SIZE(keymap) - 1;
+
+	while (upper >= lower) {
+		ssize_t m = (lower + upper) / 2;
+
+		if (keymap[m].key_id == key_id) {
+			return &keymap[m];
+		} else if (key_id < keymap[m].key_id) {
+			upper = m - 1;
+		} else {
+			lower = m + 1;
+		}
+	}
+
+	return NULL;
+}
+
+static void keymap_fill(void)
+{
+	size_t pos = 0;
+
+	for (size_t col = 0; col < COL_COUNT; col++) {
+		for (size_t row = 0; row < ROW_COUNT; row++) {
+			keymap[pos].key_id = KEY_ID(col, row);
+			keymap[pos].usage_id = 0x04 + pos;
+			keymap[pos].report_id = REPORT_ID_KEYBOARD_KEYS;
+			pos++;
+		}
+	}
+
+	for (size_t i = 0; i < FN_KEY_COUNT; i++) {
+		keymap[pos].key_id = KEY_ID(i / ROW_COUNT, i % ROW_COUNT) |
+				     FN_BIT;
+		keymap[pos].usage_id = 0x0180 + i;
+		keymap[pos].report_id = REPORT_ID_CONSUMER_CTRL;
+		pos++;
+	}
+
+	__ASSERT_NO_MSG(pos == ARRAY_SIZE(keymap));
+}
+
+static void test_lookup(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(keymap); i++) {
+		const struct hid_keymap *map =
+			hid_keymap_index_get(&keymap_idx, keymap[i].key_id);
+
+		zassert_equal_ptr(map, &keymap[i], "Wrong entry for key 0x%x",
+				  keymap[i].key_id);
+	}
+
+	zassert_is_null(hid_keymap_index_get(&keymap_idx,
+					     KEY_ID(COL_COUNT, 0)),
+			"Unmapped key found");
+	zassert_is_null(hid_keymap_index_get(&keymap_idx,
+					     KEY_ID(0, ROW_COUNT) | FN_BIT),
+			"Unmapped function key found");
+}
+
+static uint32_t benchmark(const struct hid_keymap *(*get)(uint16_t))
+{
+	uint32_t start = k_cycle_get_32();
+
+	for (size_t i = 0; i < LOOKUP_COUNT; i++) {
+		const struct hid_keymap *map =
+			get(keymap[(i * 7) % ARRAY_SIZE(keymap)].key_id);
+
+		__ASSERT_NO_MSG(map);
+		ARG_UNUSED(map);
+	}
+
+	return k_cycle_get_32() - start;
+}
+
+static const struct hid_keymap *index_get(uint16_t key_id)
+{
+	return hid_keymap_index_get(&keymap_idx, key_id);
+}
+
+static void test_benchmark(void)
+{
+	uint32_t index_cycles = benchmark(index_get);
+	uint32_t bsearch_cycles = benchmark(keymap_bsearch);
+
+	TC_PRINT("Keymap entries: %u, index slots: %u\n",
+		 ARRAY_SIZE(keymap), ARRAY_SIZE(slot));
+	TC_PRINT("%u lookups: index %u cycles, binary search %u cycles\n",
+		 LOOKUP_COUNT, index_cycles, bsearch_cycles);
+}
+
+void test_main(void)
+{
+	keymap_fill();
+	hid_keymap_index_init(&keymap_idx, keymap, ARRAY_SIZE(keymap), slot,
+			      ARRAY_SIZE(slot));
+
+	ztest_test_suite(hid_keymap_index_tests,
+			 ztest_unit_test(test_lookup),
+			 ztest_unit_test(test_benchmark)
+			 );
+
+	ztest_run_test_suite(hid_keymap_index_tests);
+}
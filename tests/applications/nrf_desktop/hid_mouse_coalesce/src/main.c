@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <zephyr.h>
+
+#include "hid_mouse_coalesce.h"
+#include "hid_report_mouse.h"
+
+/* Mouse report without the report ID. */
+static void report_make(uint8_t *report, uint8_t buttons, int8_t wheel,
+			int16_t x, int16_t y)
+{
+	report[0] = buttons;
+	report[1] = wheel;
+	report[2] = x & 0xff;
+	report[3] = ((y & 0x0f) << 4) | ((x >> 8) & 0x0f);
+	report[4] = (y >> 4) & 0xff;
+}
+
+static void test_motion_summed(void)
+{
+	uint8_t queued[REPORT_SIZE_MOUSE];
+	uint8_t data[REPORT_SIZE_MOUSE];
+	uint8_t expected[REPORT_SIZE_MOUSE];
+
+	report_make(queued, BIT(0), 1, 10, -5);
+	report_make(data, BIT(0), 2, -3, 7);
+	report_make(expected, BIT(0), 3, 7, 2);
+
+	zassert_true(hid_mouse_coalesce(queued, data), "Not merged");
+	zassert_mem_equal(queued, expected, sizeof(queued), "Wrong sum");
+
+	/* Negative values are sign-extended from 12 bits. */
+	report_make(queued, 0, -100, -1000, 1000);
+	report_make(data, 0, -27, -1000, 1000);
+	report_make(expected, 0, MOUSE_REPORT_WHEEL_MIN, -2000, 2000);
+
+	zassert_true(hid_mouse_coalesce(queued, data), "Not merged");
+	zassert_mem_equal(queued, expected, sizeof(queued), "Wrong sum");
+}
+
+static void test_buttons_kept(void)
+{
+	uint8_t queued[REPORT_SIZE_MOUSE];
+	uint8_t data[REPORT_SIZE_MOUSE];
+	uint8_t expected[REPORT_SIZE_MOUSE];
+
+	/* A button change must reach the host as a report of its own. */
+	report_make(queued, 0, 0, 10, 10);
+	report_make(data, BIT(1), 0, 10, 10);
+	memcpy(expected, queued, sizeof(expected));
+
+	zassert_false(hid_mouse_coalesce(queued, data), "Buttons merged");
+	zassert_mem_equal(queued, expected, sizeof(queued),
+			  "Queued report changed");
+}
+
+static void test_overflow_kept(void)
+{
+	static const struct {
+		int8_t wheel;
+		int16_t x;
+		int16_t y;
+	} sums[] = {
+		{ 100, 0, 0 },
+		{ -100, 0, 0 },
+		{ 0, 1500, 0 },
+		{ 0, -1500, 0 },
+		{ 0, 0, 1500 },
+		{ 0, 0, -1500 },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(sums); i++) {
+		uint8_t queued[REPORT_SIZE_MOUSE];
+		uint8_t data[REPORT_SIZE_MOUSE];
+		uint8_t expected[REPORT_SIZE_MOUSE];
+
+		/* Motion is not lost when the sum does not fit. */
+		report_make(queued, 0, sums[i].wheel, sums[i].x, sums[i].y);
+		report_make(data, 0, sums[i].wheel, sums[i].x, sums[i].y);
+		memcpy(expected, queued, sizeof(expected));
+
+		zassert_false(hid_mouse_coalesce(queued, data),
+			      "Overflow %u merged", i);
+		zassert_mem_equal(queued, expected, sizeof(queued),
+				  "Queued report changed");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hid_mouse_coalesce_test,
+		ztest_unit_test(test_motion_summed),
+		ztest_unit_test(test_buttons_kept),
+		ztest_unit_test(test_overflow_kept)
+	);
+
+	ztest_run_test_suite(hid_mouse_coalesce_test);
+}
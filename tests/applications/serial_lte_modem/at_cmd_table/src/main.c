@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <strings.h>
+
+#include "slm_at_cmd.h"
+
+#define LOOKUPS 10000
+
+static int handler(enum at_cmd_type cmd_type)
+{
+	ARG_UNUSED(cmd_type);
+
+	return 0;
+}
+
+/* A command table the size of the one of the serial LTE modem. */
+SLM_AT_CMD_DEFINE(slmver, "AT#XSLMVER", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(sleep, "AT#XSLEEP", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(clac, "AT#XCLAC", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(slmuart, "AT#XSLMUART", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(datactrl, "AT#XDATACTRL", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(binmode, "AT#XBINMODE", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(socket, "AT#XSOCKET", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(socketopt, "AT#XSOCKETOPT", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(bind, "AT#XBIND", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(connect, "AT#XCONNECT", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(listen, "AT#XLISTEN", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(accept, "AT#XACCEPT", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(send, "AT#XSEND", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(recv, "AT#XRECV", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(sendto, "AT#XSENDTO", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(recvfrom, "AT#XRECVFROM", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(getaddrinfo, "AT#XGETADDRINFO", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(tcpfilter, "AT#XTCPFILTER", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DATAMODE_DEFINE(tcpsvr, "AT#XTCPSVR", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DATAMODE_DEFINE(tcpcli, "AT#XTCPCLI", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(tcpsend, "AT#XTCPSEND", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(tcprecv, "AT#XTCPRECV", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DATAMODE_DEFINE(udpsvr, "AT#XUDPSVR", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DATAMODE_DEFINE(udpcli, "AT#XUDPCLI", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(udpsend, "AT#XUDPSEND", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(ping, "AT#XPING", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(fota, "AT#XFOTA", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(gps, "AT#XGPS", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(ftp, "AT#XFTP", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(mqttcon, "AT#XMQTTCON", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(mqttsub, "AT#XMQTTSUB", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(mqttpub, "AT#XMQTTPUB", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(httpccon, "AT#XHTTPCCON", handler, SLM_AT_RSP_OK);
+SLM_AT_CMD_DEFINE(httpcreq, "AT#XHTTPCREQ", handler, SLM_AT_RSP_OK);
+
+/* The commands looked up, as received from the host. */
+static const char *const at_cmds[] = {
+	"AT#XSLMVER",
+	"at#xhttpcreq=\"GET\",\"/\"",
+	"AT#XSOCKET?",
+	"AT#XTCPCLI=1,\"example.com\",1234",
+	"AT#XSEND=\"data\"",
+	"AT+CFUN=1",
+	"AT#XMQTTPUB=?",
+};
+
+/* Lookup as done before the commands were indexed: each registered command
+ * is compared in turn.
+ */
+static const struct slm_at_cmd *linear_find(const char *at_cmd)
+{
+	Z_STRUCT_SECTION_FOREACH(slm_at_cmd, cmd) {
+		size_t len = strlen(cmd->string);
+
+		if ((strncasecmp(at_cmd, cmd->string, len) == 0) &&
+		    (strchr("=?\r\n", at_cmd[len]) != NULL)) {
+			return cmd;
+		}
+	}
+
+	return NULL;
+}
+
+static void setup(void)
+{
+	int err = slm_at_cmd_table_init();
+
+	zassert_equal(err, 0, "slm_at_cmd_table_init failed: %d", err);
+}
+
+static void test_all_registered(void)
+{
+	Z_STRUCT_SECTION_FOREACH(slm_at_cmd, cmd) {
+		zassert_equal_ptr(slm_at_cmd_find(cmd->string), cmd,
+				  "%s not found", cmd->string);
+	}
+}
+
+static void test_find(void)
+{
+	const struct slm_at_cmd *cmd;
+
+	cmd = slm_at_cmd_find("at#xslmver");
+	zassert_not_null(cmd, "Lower case command not found");
+	zassert_equal(strcmp(cmd->string, "AT#XSLMVER"), 0, NULL);
+
+	cmd = slm_at_cmd_find("AT#XSEND=\"AT#XSENDTO\"");
+	zassert_not_null(cmd, NULL);
+	zassert_equal(strcmp(cmd->string, "AT#XSEND"), 0, NULL);
+
+	zassert_not_null(slm_at_cmd_find("AT#XGPS?"), NULL);
+	zassert_not_null(slm_at_cmd_find("AT#XGPS=?"), NULL);
+	zassert_not_null(slm_at_cmd_find("AT#XCLAC\r\n"), NULL);
+
+	/* A command with a registered command as prefix is not registered. */
+	zassert_is_null(slm_at_cmd_find("AT#XSENDX"), NULL);
+	zassert_is_null(slm_at_cmd_find("AT#XSEN"), NULL);
+	zassert_is_null(slm_at_cmd_find("AT+CFUN?"), NULL);
+	zassert_is_null(slm_at_cmd_find(""), NULL);
+}
+
+static void test_datamode(void)
+{
+	zassert_true(slm_at_cmd_find("AT#XTCPCLI=0")->datamode, NULL);
+	zassert_true(slm_at_cmd_find("AT#XUDPSVR=0")->datamode, NULL);
+	zassert_false(slm_at_cmd_find("AT#XSEND=\"data\"")->datamode,
+		      "Data sent in data mode would be handled as command");
+}
+
+static void test_lookup_latency(void)
+{
+	uint32_t table_cycles, linear_cycles;
+	uint32_t start;
+	int found = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(at_cmds); i++) {
+		zassert_equal_ptr(slm_at_cmd_find(at_cmds[i]),
+				  linear_find(at_cmds[i]),
+				  "Lookups differ for %s", at_cmds[i]);
+	}
+
+	start = k_cycle_get_32();
+	for (int n = 0; n < LOOKUPS; n++) {
+		found += (slm_at_cmd_find(at_cmds[n % ARRAY_SIZE(at_cmds)]) !=
+			  NULL);
+	}
+	table_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (int n = 0; n < LOOKUPS; n++) {
+		found -= (linear_find(at_cmds[n % ARRAY_SIZE(at_cmds)]) !=
+			  NULL);
+	}
+	linear_cycles = k_cycle_get_32() - start;
+
+	zassert_equal(found, 0, NULL);
+
+	TC_PRINT("%d lookups: hash table %u cycles, linear scan %u cycles\n",
+		 LOOKUPS, table_cycles, linear_cycles);
+
+	/* The cycle counter does not advance on all platforms while the CPU
+	 * is busy.
+	 */
+	if (linear_cycles > 0) {
+		zassert_true(table_cycles < linear_cycles,
+			     "Hash table lookup slower than linear scan");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(slm_at_cmd_table,
+		ztest_unit_test_setup_teardown(test_all_registered,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_find,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_datamode,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_lookup_latency,
+			setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(slm_at_cmd_table);
+}
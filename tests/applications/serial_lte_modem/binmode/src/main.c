@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <sys/byteorder.h>
+#include <net/net_ip.h>
+#include <modem/at_cmd_parser.h>
+#include <modem/at_params.h>
+
+#include "slm_at_host.h"
+#include "slm_binmode.h"
+#include "slm_util.h"
+
+/* Size of the UART RX buffers of the AT host */
+#define DMA_CHUNK_LEN 256
+#define FRAME_LEN CONFIG_SLM_BINMODE_FRAME_MAX_LEN
+/* Largest payload of an AT#XTCPSEND command, hex encoded on the UART */
+#define HEX_CHUNK_LEN (NET_IPV4_MTU / 2)
+#define STREAM_LEN (64 * 1024)
+#define AT_MAX_PARAM 9
+
+/* Stand-in for the socket, which checks the received stream. */
+static uint8_t socket_buf[FRAME_LEN];
+static size_t socket_received;
+static size_t socket_frames;
+static bool socket_corrupted;
+
+static uint8_t stream[STREAM_LEN];
+/* Frames of the stream as sent by the host, with their headers. */
+static uint8_t wire[STREAM_LEN + 2 * (STREAM_LEN / FRAME_LEN + 1)];
+static size_t wire_len;
+/* AT command of the stream as sent by the host in hexadecimal. */
+static char at_cmd[sizeof("AT#XTCPSEND=0,\"\"") + 2 * HEX_CHUNK_LEN];
+static char at_data[NET_IPV4_MTU];
+static struct at_param_list at_param_list;
+
+static int socket_send(const uint8_t *data, size_t len)
+{
+	memcpy(socket_buf, data, len);
+
+	if ((socket_received + len > sizeof(stream)) ||
+	    (memcmp(socket_buf, &stream[socket_received], len) != 0)) {
+		socket_corrupted = true;
+	}
+
+	socket_received += len;
+	socket_frames++;
+
+	return len;
+}
+
+static void socket_reset(void)
+{
+	socket_received = 0;
+	socket_frames = 0;
+	socket_corrupted = false;
+}
+
+static void wire_build(size_t frame_len)
+{
+	wire_len = 0;
+
+	for (size_t pos = 0; pos < sizeof(stream); pos += frame_len) {
+		size_t len = MIN(frame_len, sizeof(stream) - pos);
+
+		sys_put_be16(len, &wire[wire_len]);
+		memcpy(&wire[wire_len + 2], &stream[pos], len);
+		wire_len += 2 + len;
+	}
+}
+
+static void frames_process(void)
+{
+	int ret;
+
+	do {
+		ret = slm_binmode_rx_frame_process();
+	} while (ret == 1);
+
+	zassert_equal(ret, 0, "Unexpected result: %d", ret);
+}
+
+static void setup(void)
+{
+	for (size_t i = 0; i < sizeof(stream); i++) {
+		stream[i] = (uint8_t)(i * 31 + (i >> 8));
+	}
+
+	wire_build(FRAME_LEN);
+	socket_reset();
+	slm_binmode_rx_init(socket_send);
+}
+
+static void test_split_frames(void)
+{
+	static const size_t chunk_lens[] = { 1, 3, 255, DMA_CHUNK_LEN };
+
+	for (size_t i = 0; i < ARRAY_SIZE(chunk_lens); i++) {
+		socket_reset();
+		slm_binmode_rx_init(socket_send);
+
+		for (size_t pos = 0; pos < wire_len; pos += chunk_lens[i]) {
+			size_t len = MIN(chunk_lens[i], wire_len - pos);
+
+			zassert_equal(slm_binmode_rx_put(&wire[pos], len), 0,
+				      "Data lost");
+			frames_process();
+		}
+
+		zassert_equal(socket_received, sizeof(stream),
+			      "%d bytes received", socket_received);
+		zassert_false(socket_corrupted, "Stream corrupted");
+	}
+}
+
+static void test_flow_control(void)
+{
+	size_t pos = 0;
+	bool paused = false;
+	uint32_t pauses = 0;
+	uint32_t chunks = 0;
+	int ret;
+
+	/* The socket is slower than the UART: a frame is only sent after
+	 * every eighth DMA chunk.
+	 */
+	while (socket_received < sizeof(stream)) {
+		if (!paused && (pos < wire_len)) {
+			size_t len = MIN(DMA_CHUNK_LEN, wire_len - pos);
+
+			zassert_equal(slm_binmode_rx_put(&wire[pos], len), 0,
+				      "Data lost");
+			pos += len;
+
+			if (slm_binmode_rx_space_low()) {
+				paused = true;
+				pauses++;
+
+				/* The DMA buffer in use is delivered after
+				 * the reception is stopped.
+				 */
+				len = MIN(DMA_CHUNK_LEN, wire_len - pos);
+				zassert_equal(slm_binmode_rx_put(&wire[pos],
+								 len),
+					      0, "Data lost after pause");
+				pos += len;
+			}
+		}
+
+		if ((++chunks % 8 == 0) || paused || (pos == wire_len)) {
+			ret = slm_binmode_rx_frame_process();
+			zassert_true(ret >= 0, "Unexpected result: %d", ret);
+			paused = paused && slm_binmode_rx_space_low();
+		}
+	}
+
+	zassert_true(pauses > 0, "Reception never paused");
+	zassert_false(socket_corrupted, "Stream corrupted");
+}
+
+static void test_overrun(void)
+{
+	size_t pos = 0;
+	int err = 0;
+
+	/* Without flow control, the buffer overflows. */
+	while ((err == 0) && (pos < wire_len)) {
+		err = slm_binmode_rx_put(&wire[pos], DMA_CHUNK_LEN);
+		pos += DMA_CHUNK_LEN;
+	}
+
+	zassert_equal(err, -ENOBUFS, "No overrun");
+	zassert_equal(slm_binmode_rx_put(wire, 1), -ENOBUFS,
+		      "Data accepted after overrun");
+	zassert_equal(slm_binmode_rx_frame_process(), -ENOBUFS,
+		      "Frames processed after overrun");
+
+	/* The receiver is usable again after a new start. */
+	slm_binmode_rx_init(socket_send);
+	zassert_equal(slm_binmode_rx_put(wire, FRAME_LEN + 2), 0, NULL);
+	zassert_equal(slm_binmode_rx_frame_process(), 1, NULL);
+}
+
+static void test_end_and_errors(void)
+{
+	uint8_t data[] = { 0x00, 0x02, 'h', 'i', 0x00, 0x00, 0x00, 0x01 };
+	uint8_t hdr[2];
+
+	zassert_equal(slm_binmode_rx_put(data, sizeof(data)), 0, NULL);
+	zassert_equal(slm_binmode_rx_frame_process(), 1, NULL);
+	zassert_equal(socket_frames, 1, NULL);
+	zassert_equal(slm_binmode_rx_frame_process(), -ECANCELED,
+		      "End frame not detected");
+
+	slm_binmode_rx_init(socket_send);
+	sys_put_be16(FRAME_LEN + 1, hdr);
+	zassert_equal(slm_binmode_rx_put(hdr, sizeof(hdr)), 0, NULL);
+	zassert_equal(slm_binmode_rx_frame_process(), -EMSGSIZE,
+		      "Frame too long accepted");
+}
+
+/* Receive the stream as AT#XTCPSEND commands with hexadecimal data, and
+ * decode them as the AT host and the TCP proxy do. The line assembly of the
+ * AT host is not included. Returns the number of bytes sent on the UART.
+ */
+static size_t at_hex_receive(uint32_t *cycles)
+{
+	size_t uart_len = 0;
+
+	*cycles = 0;
+
+	for (size_t pos = 0; pos < sizeof(stream); pos += HEX_CHUNK_LEN) {
+		size_t len = MIN(HEX_CHUNK_LEN, sizeof(stream) - pos);
+		size_t size = sizeof(at_data);
+		uint16_t datatype;
+		uint32_t start;
+		int cmd_len;
+		int ret;
+
+		cmd_len = sprintf(at_cmd, "AT#XTCPSEND=%d,\"",
+				  DATATYPE_HEXADECIMAL);
+		ret = slm_util_htoa(&stream[pos], len, &at_cmd[cmd_len],
+				    sizeof(at_cmd) - cmd_len);
+		zassert_equal(ret, 2 * len, "Encoding failed");
+		strcat(at_cmd, "\"");
+		/* Terminated with CR LF on the UART */
+		uart_len += strlen(at_cmd) + 2;
+
+		/* Only the part done by the modem is measured. */
+		start = k_cycle_get_32();
+
+		ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
+		zassert_equal(ret, 0, "Parsing failed: %d", ret);
+		ret = at_params_short_get(&at_param_list, 1, &datatype);
+		zassert_equal(ret, 0, NULL);
+		zassert_equal(datatype, DATATYPE_HEXADECIMAL, NULL);
+		ret = at_params_string_get(&at_param_list, 2, at_data, &size);
+		zassert_equal(ret, 0, NULL);
+		ret = slm_util_atoh(at_data, size, socket_buf, size / 2);
+		zassert_equal(ret, len, "Decoding failed");
+		socket_send(socket_buf, ret);
+
+		*cycles += k_cycle_get_32() - start;
+	}
+
+	return uart_len;
+}
+
+static void binmode_receive(void)
+{
+	for (size_t pos = 0; pos < wire_len; pos += DMA_CHUNK_LEN) {
+		size_t len = MIN(DMA_CHUNK_LEN, wire_len - pos);
+
+		slm_binmode_rx_put(&wire[pos], len);
+		frames_process();
+	}
+}
+
+static uint32_t rate_get(size_t len, uint32_t cycles)
+{
+	uint64_t us = k_cyc_to_us_floor64(cycles);
+
+	return us ? (uint32_t)(len * 1000000ULL / us) : 0;
+}
+
+static void test_throughput(void)
+{
+	uint32_t binmode_cycles, hex_cycles;
+	uint32_t start;
+	size_t hex_wire_len;
+
+	start = k_cycle_get_32();
+	binmode_receive();
+	binmode_cycles = k_cycle_get_32() - start;
+	zassert_equal(socket_received, sizeof(stream), NULL);
+	zassert_false(socket_corrupted, "Stream corrupted");
+
+	socket_reset();
+	hex_wire_len = at_hex_receive(&hex_cycles);
+	zassert_equal(socket_received, sizeof(stream), NULL);
+	zassert_false(socket_corrupted, "Stream corrupted");
+
+	TC_PRINT("UART bytes for %d bytes: binary %u, hex %u\n",
+		 STREAM_LEN, (uint32_t)wire_len, (uint32_t)hex_wire_len);
+	TC_PRINT("CPU time for %d bytes: binary %u cycles, hex %u cycles\n",
+		 STREAM_LEN, binmode_cycles, hex_cycles);
+
+	zassert_true(2 * wire_len < hex_wire_len,
+		     "Binary data mode does not halve the UART traffic");
+
+	/* The cycle counter does not advance on all platforms while the CPU
+	 * is busy.
+	 */
+	if (hex_cycles > 0) {
+		TC_PRINT("Processing rate: binary %u B/s, hex %u B/s\n",
+			 rate_get(sizeof(stream), binmode_cycles),
+			 rate_get(sizeof(stream), hex_cycles));
+		zassert_true(binmode_cycles < hex_cycles,
+			     "Binary data mode uses more CPU time");
+	}
+}
+
+void test_main(void)
+{
+	at_params_list_init(&at_param_list, AT_MAX_PARAM);
+
+	ztest_test_suite(slm_binmode,
+		ztest_unit_test_setup_teardown(test_split_frames,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_flow_control,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_overrun,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_end_and_errors,
+			setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_throughput,
+			setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(slm_binmode);
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <zephyr.h>
+#include <ztest.h>
+#include <cJSON.h>
+#include <cJSON_os.h>
+
+#define THREAD_STACK_SIZE 2048
+#define BENCH_ITERATIONS 100
+
+static K_THREAD_STACK_DEFINE(thread_stack, THREAD_STACK_SIZE);
+static struct k_thread thread;
+static int thread_begin_ret;
+static uint32_t thread_heap_allocs;
+
+static uint32_t heap_allocs_get(void)
+{
+	struct cJSON_ArenaStats stats;
+
+	cJSON_ArenaStatsGet(&stats);
+
+	return stats.heap_allocs;
+}
+
+/* Device status document, as reported by the asset tracker. */
+static cJSON *device_status_create(void)
+{
+	static const char *ui[] = {
+		"GPS", "FLIP", "TEMP", "HUMID", "AIR_PRESS", "BUTTON", "RSRP",
+	};
+	static const char *fota[] = { "APP", "MODEM" };
+	cJSON *root = cJSON_CreateObject();
+	cJSON *device = cJSON_AddObjectToObject(
+		cJSON_AddObjectToObject(
+			cJSON_AddObjectToObject(root, "state"), "reported"),
+		"device");
+	cJSON *network = cJSON_AddObjectToObject(device, "networkInfo");
+	cJSON *sim = cJSON_AddObjectToObject(device, "simInfo");
+	cJSON *dev_info = cJSON_AddObjectToObject(device, "deviceInfo");
+	cJSON *service = cJSON_AddObjectToObject(device, "serviceInfo");
+
+	cJSON_AddNumberToObject(network, "currentBand", 20);
+	cJSON_AddStringToObject(network, "networkMode", "LTE-M GPS");
+	cJSON_AddNumberToObject(network, "rsrp", -98);
+	cJSON_AddNumberToObject(network, "areaCode", 30401);
+	cJSON_AddStringToObject(network, "mccmnc", "24201");
+	cJSON_AddNumberToObject(network, "cellID", 21679716);
+	cJSON_AddStringToObject(network, "ipAddress", "10.81.183.99");
+	cJSON_AddNumberToObject(sim, "uiccMode", 1);
+	cJSON_AddStringToObject(sim, "iccid", "89450421180216216095");
+	cJSON_AddStringToObject(sim, "imsi", "204080813516718");
+	cJSON_AddStringToObject(dev_info, "modemFirmware", "mfw_nrf9160_1.2.3");
+	cJSON_AddNumberToObject(dev_info, "batteryVoltage", 4408);
+	cJSON_AddStringToObject(dev_info, "imei", "352656100367872");
+	cJSON_AddStringToObject(dev_info, "board", "nrf9160dk_nrf9160");
+	cJSON_AddStringToObject(dev_info, "appVersion", "v1.5.0");
+	cJSON_AddStringToObject(dev_info, "appName", "asset_tracker");
+	cJSON_AddItemToObject(service, "ui",
+			      cJSON_CreateStringArray(ui, ARRAY_SIZE(ui)));
+	cJSON_AddItemToObject(service, "fota_v2",
+			      cJSON_CreateStringArray(fota, ARRAY_SIZE(fota)));
+
+	return root;
+}
+
+static char *device_status_encode(void)
+{
+	cJSON *root;
+	char *str;
+
+	cJSON_ArenaBegin();
+
+	root = device_status_create();
+	str = cJSON_ArenaPrintUnformatted(root);
+	cJSON_Delete(root);
+
+	cJSON_ArenaEnd();
+
+	return str;
+}
+
+static void setup(void)
+{
+	cJSON_Init();
+}
+
+static void teardown(void)
+{
+}
+
+static void test_cjson_arena_scope(void)
+{
+	struct cJSON_ArenaStats before, after;
+	uint32_t heap_allocs;
+	cJSON *obj;
+
+	cJSON_ArenaStatsGet(&before);
+	zassert_equal(before.size, CONFIG_CJSON_ARENA_SIZE, "Wrong arena size");
+
+	zassert_equal(cJSON_ArenaBegin(), 0, "Arena not available");
+	heap_allocs = heap_allocs_get();
+
+	obj = cJSON_CreateObject();
+	zassert_not_null(obj, "Allocation failed");
+	zassert_not_null(cJSON_AddStringToObject(obj, "key", "value"),
+			 "Allocation failed");
+	zassert_equal(heap_allocs_get(), heap_allocs, "Heap used in scope");
+
+	cJSON_Delete(obj);
+	cJSON_ArenaEnd();
+
+	cJSON_ArenaStatsGet(&after);
+	zassert_equal(after.arena_allocs - before.arena_allocs, 4,
+		      "Wrong arena allocation count");
+	zassert_true(after.peak > 0, "Peak usage not reported");
+}
+
+static void test_cjson_arena_nested(void)
+{
+	cJSON *outer, *inner;
+
+	zassert_equal(cJSON_ArenaBegin(), 0, "Arena not available");
+	outer = cJSON_CreateObject();
+
+	zassert_equal(cJSON_ArenaBegin(), 0, "Nested scope failed");
+	inner = cJSON_CreateObject();
+	cJSON_ArenaEnd();
+
+	/* The inner scope must not release the arena. */
+	zassert_true(inner > outer, "Arena released by nested scope");
+
+	cJSON_AddItemToObject(outer, "inner", inner);
+	cJSON_Delete(outer);
+	cJSON_ArenaEnd();
+}
+
+static void thread_fn(void *p1, void *p2, void *p3)
+{
+	uint32_t heap_allocs = heap_allocs_get();
+	cJSON *obj;
+
+	thread_begin_ret = cJSON_ArenaBegin();
+
+	obj = cJSON_CreateObject();
+	cJSON_Delete(obj);
+
+	cJSON_ArenaEnd();
+
+	thread_heap_allocs = heap_allocs_get() - heap_allocs;
+}
+
+static void test_cjson_arena_other_thread(void)
+{
+	zassert_equal(cJSON_ArenaBegin(), 0, "Arena not available");
+
+	k_thread_create(&thread, thread_stack,
+			K_THREAD_STACK_SIZEOF(thread_stack), thread_fn,
+			NULL, NULL, NULL, K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+	k_thread_join(&thread, K_FOREVER);
+
+	cJSON_ArenaEnd();
+
+	zassert_equal(thread_begin_ret, -EBUSY, "Arena shared by threads");
+	zassert_equal(thread_heap_allocs, 1, "Heap not used by other thread");
+}
+
+static void test_cjson_arena_overflow(void)
+{
+	static char big[CONFIG_CJSON_ARENA_SIZE + 1];
+	struct cJSON_ArenaStats before, after;
+	cJSON *obj;
+
+	memset(big, 'a', sizeof(big) - 1);
+
+	cJSON_ArenaStatsGet(&before);
+	cJSON_ArenaBegin();
+
+	obj = cJSON_CreateString(big);
+	zassert_not_null(obj, "Overflowing allocation failed");
+	zassert_equal(strcmp(obj->valuestring, big), 0, "Wrong string");
+
+	cJSON_Delete(obj);
+	cJSON_ArenaEnd();
+	cJSON_ArenaStatsGet(&after);
+
+	zassert_equal(after.overflows - before.overflows, 1,
+		      "Overflow not counted");
+	zassert_equal(after.heap_allocs - before.heap_allocs, 1,
+		      "Overflow not served from the heap");
+}
+
+static void test_cjson_arena_print(void)
+{
+	cJSON *root = device_status_create();
+	char *expected = cJSON_PrintUnformatted(root);
+	char *str;
+
+	cJSON_Delete(root);
+	zassert_not_null(expected, "Print failed");
+
+	str = device_status_encode();
+	zassert_not_null(str, "Print failed");
+
+	/* The arena is reused, the string must not be affected. */
+	cJSON_ArenaBegin();
+	cJSON_Delete(device_status_create());
+	cJSON_ArenaEnd();
+
+	zassert_equal(strcmp(str, expected), 0, "Wrong document: %s", str);
+
+	cJSON_FreeString(str);
+	cJSON_FreeString(expected);
+}
+
+/* Compare the heap operations and encode time of a device status document
+ * with and without the arena. Cycle counts are only meaningful when the
+ * test is run on hardware.
+ */
+static void test_cjson_arena_benchmark(void)
+{
+	struct cJSON_ArenaStats stats;
+	uint32_t start, heap_cycles, arena_cycles;
+	uint32_t heap_ops, arena_ops;
+	cJSON *root;
+	char *str;
+
+	heap_ops = heap_allocs_get();
+	start = k_cycle_get_32();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		root = device_status_create();
+		str = cJSON_PrintUnformatted(root);
+		cJSON_Delete(root);
+		cJSON_FreeString(str);
+	}
+	heap_cycles = k_cycle_get_32() - start;
+	heap_ops = heap_allocs_get() - heap_ops;
+
+	arena_ops = heap_allocs_get();
+	start = k_cycle_get_32();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		str = device_status_encode();
+		cJSON_FreeString(str);
+	}
+	arena_cycles = k_cycle_get_32() - start;
+	arena_ops = heap_allocs_get() - arena_ops;
+
+	cJSON_ArenaStatsGet(&stats);
+
+	/* Only the printed string is allocated from the heap. */
+	zassert_equal(arena_ops, BENCH_ITERATIONS, "Wrong heap allocations");
+	zassert_true(heap_ops > 10 * arena_ops, "Heap allocations not reduced");
+
+	TC_PRINT("%d documents: heap %u allocs %u cycles, "
+		 "arena %u allocs %u cycles\n",
+		 BENCH_ITERATIONS, heap_ops, heap_cycles, arena_ops,
+		 arena_cycles);
+	TC_PRINT("Arena peak usage: %u of %u bytes\n",
+		 (uint32_t)stats.peak, (uint32_t)stats.size);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cjson_arena_test,
+		ztest_unit_test_setup_teardown(
+			test_cjson_arena_scope, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cjson_arena_nested, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cjson_arena_other_thread, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cjson_arena_overflow, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cjson_arena_print, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cjson_arena_benchmark, setup, teardown)
+	);
+
+	ztest_run_test_suite(cjson_arena_test);
+}
@@ -0,0 +1,408 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <net/socket.h>
+#include <sys/byteorder.h>
+#include <date_time_ntp.h>
+
+#define NUM_SERVERS 5
+#define SERVER_ADDR "192.0.2.1"
+#define SERVER_PORT 12300
+#define STACK_SIZE 2048
+#define PRIORITY K_PRIO_PREEMPT(5)
+
+#define TIMEOUT_MS 5000
+/* Unix time when the uptime was 0. */
+#define UNIX_BASE_US (1603000000LL * USEC_PER_SEC)
+/* Maximum error of the result with the delays of the tests. */
+#define MAX_ERROR_US (30 * USEC_PER_MSEC)
+
+#define NTP_UNIX_OFFSET 2208988800ULL
+
+enum answer {
+	ANSWER_OK,
+	ANSWER_NONE,
+	ANSWER_UNSYNCHRONIZED,
+	ANSWER_KISS_OF_DEATH,
+	/* An answer with a wrong origin, followed by the right answer. */
+	ANSWER_SPOOFED,
+};
+
+struct stand_in {
+	int fd;
+	/* Error of the time of the server. */
+	int64_t error_ms;
+	/* Delay of the requests on the way to the server. */
+	uint32_t delay_ms;
+	enum answer answer;
+	uint32_t requests;
+};
+
+struct ntp_packet {
+	uint8_t li_vn_mode;
+	uint8_t stratum;
+	uint8_t poll;
+	int8_t precision;
+	uint32_t root_delay;
+	uint32_t root_dispersion;
+	uint32_t ref_id;
+	uint32_t ref_tm_s;
+	uint32_t ref_tm_f;
+	uint32_t orig_tm_s;
+	uint32_t orig_tm_f;
+	uint32_t rx_tm_s;
+	uint32_t rx_tm_f;
+	uint32_t tx_tm_s;
+	uint32_t tx_tm_f;
+} __packed;
+
+static K_THREAD_STACK_ARRAY_DEFINE(stacks, NUM_SERVERS, STACK_SIZE);
+static struct k_thread threads[NUM_SERVERS];
+static struct stand_in stand_ins[NUM_SERVERS];
+static struct sockaddr_in addrs_in[NUM_SERVERS];
+static const struct sockaddr *addrs[NUM_SERVERS];
+
+/* Set the receive and transmit timestamps of an answer. */
+static void answer_time_set(struct ntp_packet *pkt, int64_t unix_us)
+{
+	uint32_t seconds = unix_us / USEC_PER_SEC + NTP_UNIX_OFFSET;
+	uint32_t fraction = ((unix_us % USEC_PER_SEC) << 32) / USEC_PER_SEC;
+
+	pkt->rx_tm_s = sys_cpu_to_be32(seconds);
+	pkt->rx_tm_f = sys_cpu_to_be32(fraction);
+	pkt->tx_tm_s = pkt->rx_tm_s;
+	pkt->tx_tm_f = pkt->rx_tm_f;
+}
+
+static void answer_send(struct stand_in *s, const struct ntp_packet *req,
+			const struct sockaddr *to, socklen_t tolen)
+{
+	struct ntp_packet pkt = {
+		.li_vn_mode = (4 << 3) | 4,
+		.stratum = 2,
+		/* 1 ms */
+		.root_dispersion = sys_cpu_to_be32(66),
+		.orig_tm_s = req->tx_tm_s,
+		.orig_tm_f = req->tx_tm_f,
+	};
+	int64_t now = UNIX_BASE_US + k_ticks_to_us_floor64(k_uptime_ticks()) +
+		      s->error_ms * USEC_PER_MSEC;
+
+	if (s->answer == ANSWER_UNSYNCHRONIZED) {
+		pkt.li_vn_mode |= 3 << 6;
+	} else if (s->answer == ANSWER_KISS_OF_DEATH) {
+		pkt.stratum = 0;
+	}
+
+	answer_time_set(&pkt, now);
+
+	if (s->answer == ANSWER_SPOOFED) {
+		struct ntp_packet spoofed = pkt;
+
+		spoofed.orig_tm_f ^= 1;
+		answer_time_set(&spoofed, now + 3600 * USEC_PER_SEC);
+		sendto(s->fd, &spoofed, sizeof(spoofed), 0, to, tolen);
+	}
+
+	sendto(s->fd, &pkt, sizeof(pkt), 0, to, tolen);
+}
+
+static void stand_in_thread(void *p1, void *p2, void *p3)
+{
+	struct stand_in *s = p1;
+
+	while (true) {
+		struct ntp_packet req;
+		struct sockaddr_in from;
+		socklen_t fromlen = sizeof(from);
+		ssize_t len;
+
+		len = recvfrom(s->fd, &req, sizeof(req), 0,
+			       (struct sockaddr *)&from, &fromlen);
+		if (len != sizeof(req)) {
+			continue;
+		}
+
+		s->requests++;
+
+		if (s->answer == ANSWER_NONE) {
+			continue;
+		}
+
+		/* The request is delayed on the way to the server, so the
+		 * offset measured is wrong by half of the delay.
+		 */
+		k_sleep(K_MSEC(s->delay_ms));
+
+		answer_send(s, &req, (struct sockaddr *)&from, fromlen);
+	}
+}
+
+static void stand_ins_start(void)
+{
+	int err;
+
+	for (size_t i = 0; i < NUM_SERVERS; i++) {
+		struct sockaddr_in *addr = &addrs_in[i];
+
+		addr->sin_family = AF_INET;
+		addr->sin_port = htons(SERVER_PORT + i);
+		inet_pton(AF_INET, SERVER_ADDR, &addr->sin_addr);
+		addrs[i] = (struct sockaddr *)addr;
+
+		stand_ins[i].fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		zassert_true(stand_ins[i].fd >= 0, "socket failed: %d", errno);
+
+		err = bind(stand_ins[i].fd, addrs[i], sizeof(*addr));
+		zassert_equal(err, 0, "bind failed: %d", errno);
+
+		k_thread_create(&threads[i], stacks[i], STACK_SIZE,
+				stand_in_thread, &stand_ins[i], NULL, NULL,
+				PRIORITY, 0, K_NO_WAIT);
+	}
+}
+
+static void test_setup(void)
+{
+	for (size_t i = 0; i < NUM_SERVERS; i++) {
+		stand_ins[i].error_ms = 0;
+		stand_ins[i].delay_ms = 10 * (i % 2);
+		stand_ins[i].answer = ANSWER_OK;
+		stand_ins[i].requests = 0;
+	}
+}
+
+static void check_result(const struct date_time_ntp_result *result)
+{
+	int64_t error = llabs(result->offset_us - UNIX_BASE_US);
+
+	zassert_true(error <= MAX_ERROR_US, "Error of %d us", (int)error);
+	zassert_true(error <= result->distance_us, "Error of %d us, not %d",
+		     (int)error, result->distance_us);
+}
+
+static void test_servers_agree(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+	zassert_true(result.survivors >= 3, "%d survivors", result.survivors);
+
+	for (size_t i = 0; i < NUM_SERVERS; i++) {
+		zassert_equal(stand_ins[i].requests, 1, NULL);
+	}
+}
+
+static void test_concurrent_requests(void)
+{
+	struct date_time_ntp_result result;
+	int64_t start;
+	int err;
+
+	for (size_t i = 0; i < NUM_SERVERS; i++) {
+		stand_ins[i].delay_ms = 300;
+	}
+
+	start = k_uptime_get();
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+
+	/* One request after the other would take 1500 ms. */
+	zassert_true(k_uptime_get() - start < 600, "Query took %d ms",
+		     (int)(k_uptime_get() - start));
+	zassert_equal(result.survivors, NUM_SERVERS, NULL);
+}
+
+static void test_unreachable_server(void)
+{
+	struct date_time_ntp_result result;
+	int64_t start;
+	int err;
+
+	stand_ins[0].answer = ANSWER_NONE;
+
+	start = k_uptime_get();
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+
+	/* The server is not waited for until the timeout. */
+	zassert_true(k_uptime_get() - start <
+		     CONFIG_DATE_TIME_NTP_ANSWER_WINDOW_MS + 200,
+		     "Query took %d ms", (int)(k_uptime_get() - start));
+	zassert_equal(stand_ins[0].requests, 1, NULL);
+}
+
+static void test_falsetickers_rejected(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	stand_ins[1].error_ms = 3600 * MSEC_PER_SEC;
+	stand_ins[3].error_ms = -2 * MSEC_PER_SEC;
+
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+	zassert_equal(result.survivors, 3, NULL);
+}
+
+static void test_falsetickers_agree(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	/* Two wrong servers agree, but they are not the majority. */
+	stand_ins[0].error_ms = 3600 * MSEC_PER_SEC;
+	stand_ins[2].error_ms = 3600 * MSEC_PER_SEC;
+
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+	zassert_equal(result.survivors, 3, NULL);
+}
+
+static void test_no_majority(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	stand_ins[1].error_ms = 3600 * MSEC_PER_SEC;
+
+	err = date_time_ntp_query(addrs, 2, TIMEOUT_MS, &result);
+	zassert_equal(err, -ENODATA, "Unexpected result: %d", err);
+}
+
+static void test_outlier_pruned(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	/* The interval of a server with a long delay contains the time, but
+	 * its offset is far from the others.
+	 */
+	stand_ins[4].delay_ms = 800;
+
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+	zassert_equal(result.survivors, NUM_SERVERS - 1, "%d survivors",
+		      result.survivors);
+}
+
+static void test_rejected_answers(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	stand_ins[0].answer = ANSWER_UNSYNCHRONIZED;
+	stand_ins[1].answer = ANSWER_KISS_OF_DEATH;
+
+	err = date_time_ntp_query(addrs, NUM_SERVERS, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+	zassert_equal(result.survivors, 3, NULL);
+
+	/* No time from servers which are not synchronized. */
+	err = date_time_ntp_query(addrs, 2, TIMEOUT_MS, &result);
+	zassert_equal(err, -ENODATA, "Unexpected result: %d", err);
+}
+
+static void test_spoofed_answer(void)
+{
+	struct date_time_ntp_result result;
+	int err;
+
+	stand_ins[0].answer = ANSWER_SPOOFED;
+
+	err = date_time_ntp_query(addrs, 1, TIMEOUT_MS, &result);
+	zassert_equal(err, 0, "Query failed: %d", err);
+	check_result(&result);
+}
+
+static void test_invalid_count(void)
+{
+	const struct sockaddr *many[DATE_TIME_NTP_MAX_SERVERS + 1] = { 0 };
+	struct date_time_ntp_result result;
+	int err;
+
+	err = date_time_ntp_query(addrs, 0, TIMEOUT_MS, &result);
+	zassert_equal(err, -EINVAL, NULL);
+
+	err = date_time_ntp_query(many, ARRAY_SIZE(many), TIMEOUT_MS, &result);
+	zassert_equal(err, -EINVAL, NULL);
+}
+
+static void test_drift(void)
+{
+	struct date_time_ntp_result prev = {
+		.offset_us = UNIX_BASE_US,
+		.uptime_us = 100 * USEC_PER_SEC,
+		.distance_us = 10 * USEC_PER_MSEC,
+	};
+	struct date_time_ntp_result cur = prev;
+	int32_t drift_ppb;
+	int err;
+
+	/* 36 ms in one hour */
+	cur.uptime_us += 3600 * USEC_PER_SEC;
+	cur.offset_us += 36 * USEC_PER_MSEC;
+	err = date_time_ntp_drift_get(&prev, &cur, &drift_ppb);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(drift_ppb, 10000, "Drift %d ppb", drift_ppb);
+
+	cur.offset_us = prev.offset_us - 36 * USEC_PER_MSEC;
+	err = date_time_ntp_drift_get(&prev, &cur, &drift_ppb);
+	zassert_equal(err, 0, NULL);
+	zassert_equal(drift_ppb, -10000, "Drift %d ppb", drift_ppb);
+
+	/* The errors of the results are too large for the interval. */
+	cur.uptime_us = prev.uptime_us + 60 * USEC_PER_SEC;
+	err = date_time_ntp_drift_get(&prev, &cur, &drift_ppb);
+	zassert_equal(err, -EAGAIN, NULL);
+
+	/* The time was stepped. */
+	cur.uptime_us = prev.uptime_us + 3600 * USEC_PER_SEC;
+	cur.offset_us = prev.offset_us + 10 * USEC_PER_SEC;
+	err = date_time_ntp_drift_get(&prev, &cur, &drift_ppb);
+	zassert_equal(err, -ERANGE, NULL);
+}
+
+void test_main(void)
+{
+	stand_ins_start();
+
+	ztest_test_suite(test_date_time_ntp,
+		ztest_unit_test_setup_teardown(test_servers_agree,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_concurrent_requests,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_unreachable_server,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_falsetickers_rejected,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_falsetickers_agree,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_no_majority,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_outlier_pruned,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_rejected_answers,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_spoofed_answer,
+			test_setup, unit_test_noop),
+		ztest_unit_test(test_invalid_count),
+		ztest_unit_test(test_drift)
+	);
+
+	ztest_run_test_suite(test_date_time_ntp);
+}
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <ei_data_buf.h>
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+#include "native_rtc.h"
+#endif
+
+#define FRAME_SIZE		3
+#define WINDOW_SIZE		(FRAME_SIZE * 40)
+#define BUF_SIZE		(WINDOW_SIZE * 2 + FRAME_SIZE * 7)
+#define STRIDE			(FRAME_SIZE * 10)
+#define INT16_SCALE		0.5f
+
+#define THREAD_STACK_SIZE	1024
+#define THREAD_PRIORITY		K_PRIO_PREEMPT(0)
+#define THREAD_WINDOW_CNT	500
+
+#define BENCHMARK_SAMPLE_CNT	(FRAME_SIZE * 1000000)
+#define BENCHMARK_CHUNK_SIZE	(FRAME_SIZE * 8)
+
+EI_DATA_BUF_DEFINE(test_buf, BUF_SIZE, WINDOW_SIZE);
+
+static K_THREAD_STACK_DEFINE(thread_stack, THREAD_STACK_SIZE);
+static struct k_thread thread;
+static K_SEM_DEFINE(process_sem, 0, 1);
+
+static uint32_t append_seq;
+
+/* The samples are consecutive numbers, exactly represented as floats. */
+static int seq_append(size_t len, bool *process_buf)
+{
+	static float data[BUF_SIZE];
+
+	__ASSERT_NO_MSG(len <= ARRAY_SIZE(data));
+
+	for (size_t i = 0; i < len; i++) {
+		data[i] = append_seq + i;
+	}
+
+	int err = ei_data_buf_append(&test_buf, data, len, process_buf);
+
+	if (!err) {
+		append_seq += len;
+	}
+
+	return err;
+}
+
+static void window_check(uint32_t first)
+{
+	struct ei_data_buf_window window;
+	float data[WINDOW_SIZE];
+
+	ei_data_buf_window_get(&test_buf, &window);
+	zassert_equal(window.len[0] + window.len[1], WINDOW_SIZE,
+		      "Wrong window size");
+
+	/* Read the window in frames, as the library does. */
+	for (size_t i = 0; i < WINDOW_SIZE; i += FRAME_SIZE) {
+		ei_data_buf_window_read(&window, &data[i], i, FRAME_SIZE);
+	}
+
+	for (size_t i = 0; i < WINDOW_SIZE; i++) {
+		zassert_equal(data[i], (float)(first + i),
+			      "Wrong sample %u in window at %u",
+			      (uint32_t)i, first);
+	}
+}
+
+static uint64_t time_us_get(void)
+{
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+	/* The simulated time does not advance while the CPU is busy. */
+	return native_rtc_gettime_us(RTC_CLOCK_REAL);
+#else
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+
+static void test_setup(void)
+{
+	/* Start with the sample counters close to their wrap value. */
+	atomic_set(&test_buf.append_cnt, test_buf.cnt_wrap - WINDOW_SIZE);
+	atomic_set(&test_buf.process_cnt, test_buf.cnt_wrap - WINDOW_SIZE);
+	atomic_set(&test_buf.state, 0);
+
+	int err = ei_data_buf_cleanup(&test_buf);
+
+	zassert_equal(err, 0, "Failed to clean up the buffer");
+
+	append_seq = 0;
+	k_sem_reset(&process_sem);
+}
+
+static void test_data_buf_full(void)
+{
+	bool process_buf;
+	int err;
+
+	for (size_t i = 0; i < BUF_SIZE; i += FRAME_SIZE) {
+		err = seq_append(FRAME_SIZE, &process_buf);
+		zassert_equal(err, 0, "Failed to append data");
+		zassert_false(process_buf, "Processing without a request");
+	}
+
+	err = seq_append(FRAME_SIZE, &process_buf);
+	zassert_equal(err, -ENOMEM, "Data appended to a full buffer");
+
+	err = ei_data_buf_move(&test_buf, 0, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	zassert_true(process_buf, "Window not ready");
+	window_check(0);
+
+	/* The window is kept until the processing ends. */
+	err = seq_append(FRAME_SIZE, &process_buf);
+	zassert_equal(err, -ENOMEM, "Data appended over the window");
+
+	ei_data_buf_processing_end(&test_buf);
+
+	err = ei_data_buf_move(&test_buf, STRIDE, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	window_check(STRIDE);
+	ei_data_buf_processing_end(&test_buf);
+
+	/* Moving the window frees the data before it. */
+	for (size_t i = 0; i < STRIDE; i += FRAME_SIZE) {
+		err = seq_append(FRAME_SIZE, &process_buf);
+		zassert_equal(err, 0, "Failed to append data");
+	}
+
+	err = seq_append(FRAME_SIZE, &process_buf);
+	zassert_equal(err, -ENOMEM, "Data appended to a full buffer");
+}
+
+static void test_data_buf_overlap(void)
+{
+	uint32_t first = 0;
+	bool process_buf;
+	int err;
+
+	err = seq_append(WINDOW_SIZE, &process_buf);
+	zassert_equal(err, 0, "Failed to append data");
+
+	err = ei_data_buf_move(&test_buf, 0, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	zassert_true(process_buf, "Window not ready");
+
+	/* Overlapping windows move around the ring several times. */
+	for (size_t i = 0; i < (4 * BUF_SIZE / STRIDE); i++) {
+		window_check(first);
+		ei_data_buf_processing_end(&test_buf);
+
+		err = ei_data_buf_move(&test_buf, STRIDE, &process_buf);
+		zassert_equal(err, 0, "Failed to move the window");
+		zassert_false(process_buf, "Window ready without data");
+		first += STRIDE;
+
+		for (size_t j = 0; j < STRIDE; j += FRAME_SIZE) {
+			err = seq_append(FRAME_SIZE, &process_buf);
+			zassert_equal(err, 0, "Failed to append data");
+			zassert_equal(process_buf, (j + FRAME_SIZE == STRIDE),
+				      "Window completed by wrong frame");
+		}
+	}
+}
+
+static void test_data_buf_skip(void)
+{
+	bool process_buf;
+	int err;
+
+	err = seq_append(WINDOW_SIZE, &process_buf);
+	zassert_equal(err, 0, "Failed to append data");
+
+	/* Move the window past the added data. */
+	err = ei_data_buf_move(&test_buf, WINDOW_SIZE + STRIDE, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	zassert_false(process_buf, "Window ready without data");
+
+	err = ei_data_buf_move(&test_buf, 0, &process_buf);
+	zassert_equal(err, -EBUSY, "Window moved while waiting for data");
+
+	/* The skipped data does not use the buffer space. */
+	for (size_t i = 0; i < (STRIDE + WINDOW_SIZE); i += FRAME_SIZE) {
+		zassert_false(process_buf, "Window ready without data");
+		err = seq_append(FRAME_SIZE, &process_buf);
+		zassert_equal(err, 0, "Failed to append data");
+	}
+
+	zassert_true(process_buf, "Window not ready");
+	window_check(WINDOW_SIZE + STRIDE);
+
+	err = ei_data_buf_cleanup(&test_buf);
+	zassert_equal(err, -EBUSY, "Buffer cleaned up while processing");
+
+	ei_data_buf_processing_end(&test_buf);
+
+	/* A window waiting for data can be cleaned up. */
+	err = ei_data_buf_move(&test_buf, STRIDE, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	zassert_false(process_buf, "Window ready without data");
+
+	err = ei_data_buf_cleanup(&test_buf);
+	zassert_equal(err, 0, "Failed to clean up the buffer");
+
+	err = ei_data_buf_move(&test_buf, 0, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	zassert_false(process_buf, "Window ready after cleanup");
+
+	append_seq = 0;
+	err = seq_append(WINDOW_SIZE, &process_buf);
+	zassert_equal(err, 0, "Failed to append data");
+	zassert_true(process_buf, "Window not ready");
+	window_check(0);
+	ei_data_buf_processing_end(&test_buf);
+}
+
+static void test_data_buf_int16(void)
+{
+	int16_t data[WINDOW_SIZE];
+	struct ei_data_buf_window window;
+	float out[WINDOW_SIZE];
+	bool process_buf;
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(data); i++) {
+		data[i] = (i % 2) ? (INT16_MIN + i) : (INT16_MAX - i);
+	}
+
+	/* Let the window wrap around the end of the ring. */
+	size_t idx = atomic_get(&test_buf.process_cnt) % BUF_SIZE;
+	size_t move = (2 * BUF_SIZE - WINDOW_SIZE / 2 - idx) % BUF_SIZE;
+
+	err = seq_append(move, &process_buf);
+	zassert_equal(err, 0, "Failed to append data");
+
+	err = ei_data_buf_move(&test_buf, move, &process_buf);
+	zassert_equal(err, 0, "Failed to move the window");
+	zassert_false(process_buf, "Window ready without data");
+
+	err = ei_data_buf_append_int16(&test_buf, data, ARRAY_SIZE(data),
+				       INT16_SCALE, &process_buf);
+	zassert_equal(err, 0, "Failed to append data");
+	zassert_true(process_buf, "Window not ready");
+
+	ei_data_buf_window_get(&test_buf, &window);
+	zassert_not_equal(window.len[1], 0, "Window does not wrap around");
+
+	ei_data_buf_window_read(&window, out, 0, ARRAY_SIZE(out));
+
+	for (size_t i = 0; i < ARRAY_SIZE(data); i++) {
+		zassert_equal(out[i], data[i] * INT16_SCALE,
+			      "Wrong sample %u", (uint32_t)i);
+	}
+
+	ei_data_buf_processing_end(&test_buf);
+}
+
+static void producer_fn(void)
+{
+	bool process_buf;
+
+	while (append_seq < (THREAD_WINDOW_CNT * STRIDE + WINDOW_SIZE)) {
+		if (seq_append(FRAME_SIZE, &process_buf)) {
+			k_yield();
+			continue;
+		}
+
+		if (process_buf) {
+			k_sem_give(&process_sem);
+		}
+
+		/* Let the consumer run while the data is added. */
+		if ((append_seq % (FRAME_SIZE * 4)) == 0) {
+			k_yield();
+		}
+	}
+}
+
+static void test_data_buf_threads(void)
+{
+	bool process_buf;
+	int err;
+
+	k_thread_create(&thread, thread_stack, THREAD_STACK_SIZE,
+			(k_thread_entry_t)producer_fn, NULL, NULL, NULL,
+			THREAD_PRIORITY, 0, K_NO_WAIT);
+
+	for (size_t i = 0; i < THREAD_WINDOW_CNT; i++) {
+		err = ei_data_buf_move(&test_buf, (i > 0) ? STRIDE : 0,
+				       &process_buf);
+		zassert_equal(err, 0, "Failed to move the window");
+
+		if (!process_buf) {
+			err = k_sem_take(&process_sem, K_SECONDS(1));
+			zassert_equal(err, 0, "Window not completed");
+		}
+
+		window_check(i * STRIDE);
+		ei_data_buf_processing_end(&test_buf);
+	}
+
+	k_thread_join(&thread, K_SECONDS(1));
+}
+
+static void test_data_buf_benchmark(void)
+{
+	static float data_float[BENCHMARK_CHUNK_SIZE];
+	static int16_t data_int16[BENCHMARK_CHUNK_SIZE];
+	bool process_buf;
+	uint64_t start;
+	uint32_t duration[2];
+
+	for (size_t type = 0; type < ARRAY_SIZE(duration); type++) {
+		start = time_us_get();
+
+		for (size_t i = 0; i < BENCHMARK_SAMPLE_CNT;
+		     i += BENCHMARK_CHUNK_SIZE) {
+			int err;
+
+			if (type == 0) {
+				err = ei_data_buf_append(&test_buf, data_float,
+							 BENCHMARK_CHUNK_SIZE,
+							 &process_buf);
+			} else {
+				err = ei_data_buf_append_int16(&test_buf,
+							       data_int16,
+							       BENCHMARK_CHUNK_SIZE,
+							       INT16_SCALE,
+							       &process_buf);
+			}
+
+			zassert_equal(err, 0, "Failed to append data");
+
+			/* Drop the data as soon as it is added. */
+			err = ei_data_buf_cleanup(&test_buf);
+			zassert_equal(err, 0, "Failed to clean up the buffer");
+		}
+
+		duration[type] = MAX(time_us_get() - start, 1);
+	}
+
+	TC_PRINT("float: %u samples in %u us (%u samples/ms)\n",
+		 BENCHMARK_SAMPLE_CNT, duration[0],
+		 (uint32_t)((uint64_t)BENCHMARK_SAMPLE_CNT * 1000 / duration[0]));
+	TC_PRINT("int16: %u samples in %u us (%u samples/ms)\n",
+		 BENCHMARK_SAMPLE_CNT, duration[1],
+		 (uint32_t)((uint64_t)BENCHMARK_SAMPLE_CNT * 1000 / duration[1]));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(
+		test_ei_data_buf,
+		ztest_unit_test_setup_teardown(test_data_buf_full, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_data_buf_overlap, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_data_buf_skip, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_data_buf_int16, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_data_buf_threads, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_data_buf_benchmark, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_ei_data_buf);
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <math.h>
+#include <zephyr.h>
+#include <ztest.h>
+#include <cJSON.h>
+#include <json_writer.h>
+
+#define BENCH_ITERATIONS 100
+/* Keeps the cJSON allocations aligned for the double in cJSON items. */
+#define HEAP_HDR_SIZE 8
+
+static size_t heap_used;
+static size_t heap_peak;
+
+static const char *const ui[] = {
+	"GPS", "FLIP", "TEMP", "HUMID", "AIR_PRESS", "BUTTON", "RSRP",
+};
+static const char *const fota[] = { "APP", "MODEM" };
+
+/* cJSON hooks that keep track of the peak heap usage. */
+static void *heap_malloc(size_t sz)
+{
+	uint8_t *ptr = k_malloc(sz + HEAP_HDR_SIZE);
+
+	if (ptr == NULL) {
+		return NULL;
+	}
+
+	*(size_t *)ptr = sz;
+	heap_used += sz;
+	heap_peak = MAX(heap_peak, heap_used);
+
+	return ptr + HEAP_HDR_SIZE;
+}
+
+static void heap_free(void *ptr)
+{
+	uint8_t *hdr = (uint8_t *)ptr - HEAP_HDR_SIZE;
+
+	if (ptr == NULL) {
+		return;
+	}
+
+	heap_used -= *(size_t *)hdr;
+	k_free(hdr);
+}
+
+static void heap_peak_reset(void)
+{
+	heap_peak = heap_used;
+}
+
+/* Sensor message, as sent by the asset tracker. */
+static void sensor_write(struct json_writer *w, const void *ctx)
+{
+	json_writer_obj_start(w, NULL);
+	json_writer_str(w, "appId", "TEMP");
+	json_writer_str(w, "data", "24.5");
+	json_writer_str(w, "messageType", "DATA");
+	json_writer_int(w, "ts", 1611050000000LL);
+	json_writer_obj_end(w);
+}
+
+static char *sensor_cjson_print(void)
+{
+	cJSON *root = cJSON_CreateObject();
+	char *str;
+
+	cJSON_AddStringToObject(root, "appId", "TEMP");
+	cJSON_AddStringToObject(root, "data", "24.5");
+	cJSON_AddStringToObject(root, "messageType", "DATA");
+	cJSON_AddNumberToObject(root, "ts", 1611050000000.0);
+
+	str = cJSON_PrintUnformatted(root);
+	cJSON_Delete(root);
+
+	return str;
+}
+
+/* Device status document, as reported by the asset tracker. */
+static void device_status_write(struct json_writer *w, const void *ctx)
+{
+	json_writer_obj_start(w, NULL);
+	json_writer_obj_start(w, "state");
+	json_writer_obj_start(w, "reported");
+	json_writer_obj_start(w, "device");
+
+	json_writer_obj_start(w, "networkInfo");
+	json_writer_int(w, "currentBand", 20);
+	json_writer_str(w, "networkMode", "LTE-M GPS");
+	json_writer_int(w, "rsrp", -98);
+	json_writer_int(w, "areaCode", 30401);
+	json_writer_str(w, "mccmnc", "24201");
+	json_writer_int(w, "cellID", 21679716);
+	json_writer_str(w, "ipAddress", "10.81.183.99");
+	json_writer_obj_end(w);
+
+	json_writer_obj_start(w, "simInfo");
+	json_writer_int(w, "uiccMode", 1);
+	json_writer_str(w, "iccid", "89450421180216216095");
+	json_writer_str(w, "imsi", "204080813516718");
+	json_writer_obj_end(w);
+
+	json_writer_obj_start(w, "deviceInfo");
+	json_writer_str(w, "modemFirmware", "mfw_nrf9160_1.2.3");
+	json_writer_int(w, "batteryVoltage", 4408);
+	json_writer_str(w, "imei", "352656100367872");
+	json_writer_str(w, "board", "nrf9160dk_nrf9160");
+	json_writer_str(w, "appVersion", "v1.5.0");
+	json_writer_str(w, "appName", "asset_tracker");
+	json_writer_obj_end(w);
+
+	json_writer_obj_start(w, "serviceInfo");
+	json_writer_arr_start(w, "ui");
+	for (int i = 0; i < ARRAY_SIZE(ui); i++) {
+		json_writer_str(w, NULL, ui[i]);
+	}
+	json_writer_arr_end(w);
+	json_writer_arr_start(w, "fota_v2");
+	for (int i = 0; i < ARRAY_SIZE(fota); i++) {
+		json_writer_str(w, NULL, fota[i]);
+	}
+	json_writer_arr_end(w);
+	json_writer_obj_end(w);
+
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+	json_writer_obj_end(w);
+}
+
+static char *device_status_cjson_print(void)
+{
+	cJSON *root = cJSON_CreateObject();
+	cJSON *device = cJSON_AddObjectToObject(
+		cJSON_AddObjectToObject(
+			cJSON_AddObjectToObject(root, "state"), "reported"),
+		"device");
+	cJSON *network = cJSON_AddObjectToObject(device, "networkInfo");
+	cJSON *sim = cJSON_AddObjectToObject(device, "simInfo");
+	cJSON *dev_info = cJSON_AddObjectToObject(device, "deviceInfo");
+	cJSON *service = cJSON_AddObjectToObject(device, "serviceInfo");
+	char *str;
+
+	cJSON_AddNumberToObject(network, "currentBand", 20);
+	cJSON_AddStringToObject(network, "networkMode", "LTE-M GPS");
+	cJSON_AddNumberToObject(network, "rsrp", -98);
+	cJSON_AddNumberToObject(network, "areaCode", 30401);
+	cJSON_AddStringToObject(network, "mccmnc", "24201");
+	cJSON_AddNumberToObject(network, "cellID", 21679716);
+	cJSON_AddStringToObject(network, "ipAddress", "10.81.183.99");
+	cJSON_AddNumberToObject(sim, "uiccMode", 1);
+	cJSON_AddStringToObject(sim, "iccid", "89450421180216216095");
+	cJSON_AddStringToObject(sim, "imsi", "204080813516718");
+	cJSON_AddStringToObject(dev_info, "modemFirmware", "mfw_nrf9160_1.2.3");
+	cJSON_AddNumberToObject(dev_info, "batteryVoltage", 4408);
+	cJSON_AddStringToObject(dev_info, "imei", "352656100367872");
+	cJSON_AddStringToObject(dev_info, "board", "nrf9160dk_nrf9160");
+	cJSON_AddStringToObject(dev_info, "appVersion", "v1.5.0");
+	cJSON_AddStringToObject(dev_info, "appName", "asset_tracker");
+	cJSON_AddItemToObject(service, "ui",
+			      cJSON_CreateStringArray((const char **)ui,
+						      ARRAY_SIZE(ui)));
+	cJSON_AddItemToObject(service, "fota_v2",
+			      cJSON_CreateStringArray((const char **)fota,
+						      ARRAY_SIZE(fota)));
+
+	str = cJSON_PrintUnformatted(root);
+	cJSON_Delete(root);
+
+	return str;
+}
+
+static void setup(void)
+{
+	cJSON_Hooks hooks = {
+		.malloc_fn = heap_malloc,
+		.free_fn = heap_free,
+	};
+
+	cJSON_InitHooks(&hooks);
+}
+
+static void teardown(void)
+{
+}
+
+static void test_json_writer_values(void)
+{
+	char buf[128];
+	struct json_writer w;
+	int len;
+
+	json_writer_init(&w, buf, sizeof(buf));
+	json_writer_obj_start(&w, NULL);
+	json_writer_int(&w, "min", INT64_MIN);
+	json_writer_int(&w, "zero", 0);
+	json_writer_num(&w, "num", 0.1);
+	json_writer_num(&w, "nan", NAN);
+	json_writer_bool(&w, "t", true);
+	json_writer_bool(&w, "f", false);
+	json_writer_str(&w, "str", NULL);
+	json_writer_arr_start(&w, "arr");
+	json_writer_obj_start(&w, NULL);
+	json_writer_obj_end(&w);
+	json_writer_arr_start(&w, NULL);
+	json_writer_arr_end(&w);
+	json_writer_null(&w, NULL);
+	json_writer_arr_end(&w);
+	json_writer_obj_end(&w);
+	len = json_writer_finish(&w);
+
+	zassert_equal(strcmp(buf, "{\"min\":-9223372036854775808,\"zero\":0,"
+				  "\"num\":0.1,\"nan\":null,\"t\":true,"
+				  "\"f\":false,\"str\":null,"
+				  "\"arr\":[{},[],null]}"),
+		      0, "Wrong document: %s", buf);
+	zassert_equal(len, strlen(buf), "Wrong length");
+}
+
+static void test_json_writer_escape(void)
+{
+	static const char str[] = "\"quote\" \\ \b\f\n\r\t \x01 / \xc3\xa5";
+	cJSON *item = cJSON_CreateString(str);
+	char *expected = cJSON_PrintUnformatted(item);
+	char buf[64];
+	struct json_writer w;
+
+	cJSON_Delete(item);
+
+	json_writer_init(&w, buf, sizeof(buf));
+	json_writer_str(&w, NULL, str);
+	zassert_true(json_writer_finish(&w) > 0, "Write failed");
+
+	zassert_equal(strcmp(buf, expected), 0, "Wrong escaping: %s", buf);
+
+	cJSON_free(expected);
+}
+
+static void test_json_writer_overflow(void)
+{
+	char buf[16];
+	struct json_writer w;
+	size_t len;
+
+	json_writer_init(&w, buf, sizeof(buf));
+	device_status_write(&w, NULL);
+	len = json_writer_len(&w);
+
+	zassert_equal(json_writer_finish(&w), -ENOMEM, "Overflow not reported");
+	zassert_equal(buf[0], '\0', "Partial document in buffer");
+
+	/* The required length is reported. */
+	json_writer_init(&w, NULL, 0);
+	device_status_write(&w, NULL);
+	zassert_equal(json_writer_finish(&w), len, "Wrong required length");
+}
+
+static void test_json_writer_cjson_compare(void)
+{
+	char *expected, *str;
+	size_t len;
+
+	expected = sensor_cjson_print();
+	str = json_writer_alloc_print(sensor_write, NULL, &len);
+	zassert_not_null(str, "Allocation failed");
+	zassert_equal(strcmp(str, expected), 0, "Wrong document: %s", str);
+	zassert_equal(len, strlen(expected), "Wrong length");
+	cJSON_free(expected);
+	k_free(str);
+
+	expected = device_status_cjson_print();
+	str = json_writer_alloc_print(device_status_write, NULL, &len);
+	zassert_not_null(str, "Allocation failed");
+	zassert_equal(strcmp(str, expected), 0, "Wrong document: %s", str);
+	cJSON_free(expected);
+	k_free(str);
+}
+
+static void benchmark(const char *name, json_writer_cb_t write,
+		      char *(*cjson_print)(void))
+{
+	uint32_t start, cjson_cycles, writer_cycles;
+	size_t cjson_peak, writer_peak, len;
+	char *str;
+
+	heap_peak_reset();
+	start = k_cycle_get_32();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		str = cjson_print();
+		cJSON_free(str);
+	}
+	cjson_cycles = k_cycle_get_32() - start;
+	cjson_peak = heap_peak;
+
+	start = k_cycle_get_32();
+	for (int i = 0; i < BENCH_ITERATIONS; i++) {
+		str = json_writer_alloc_print(write, NULL, &len);
+		k_free(str);
+	}
+	writer_cycles = k_cycle_get_32() - start;
+
+	/* The only memory used by the writer is the output buffer. While it
+	 * grows, the old and the new buffer, at most three times the size of
+	 * the document, are allocated.
+	 */
+	writer_peak = MAX(CONFIG_JSON_WRITER_ALLOC_SIZE, 3 * (len + 1));
+
+	zassert_true(writer_peak < cjson_peak, "Peak RAM not reduced");
+
+	TC_PRINT("%s: %u bytes, cJSON %u cycles %u peak RAM, "
+		 "writer %u cycles %u peak RAM\n",
+		 name, (uint32_t)len, cjson_cycles / BENCH_ITERATIONS,
+		 (uint32_t)cjson_peak, writer_cycles / BENCH_ITERATIONS,
+		 (uint32_t)writer_peak);
+}
+
+/* Compare the encode time and peak heap usage per message with the cJSON
+ * path. Cycle counts are only meaningful when the test is run on hardware.
+ */
+static void test_json_writer_benchmark(void)
+{
+	benchmark("Sensor data", sensor_write, sensor_cjson_print);
+	benchmark("Device status", device_status_write,
+		  device_status_cjson_print);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(json_writer_test,
+		ztest_unit_test_setup_teardown(
+			test_json_writer_values, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_json_writer_escape, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_json_writer_overflow, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_json_writer_cjson_compare, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_json_writer_benchmark, setup, teardown)
+	);
+
+	ztest_run_test_suite(json_writer_test);
+}
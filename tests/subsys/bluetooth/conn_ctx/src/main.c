@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <bluetooth/conn_ctx.h>
+
+#define NOTIFY_THREAD_COUNT	4
+#define NOTIFY_THREAD_PRIO	K_PRIO_PREEMPT(1)
+#define NOTIFY_STACK_SIZE	1024
+#define RECONNECT_COUNT		2000
+
+struct test_ctx {
+	struct bt_conn *conn;
+	uint32_t seq;
+};
+
+BT_CONN_CTX_DEF(test, CONFIG_BT_MAX_CONN, sizeof(struct test_ctx));
+
+/* Simulated connection objects. */
+static uint8_t conn_buf[CONFIG_BT_MAX_CONN];
+
+static K_THREAD_STACK_ARRAY_DEFINE(notify_stack, NOTIFY_THREAD_COUNT,
+				   NOTIFY_STACK_SIZE);
+static struct k_thread notify_thread[NOTIFY_THREAD_COUNT];
+static K_SEM_DEFINE(notify_done, 0, NOTIFY_THREAD_COUNT);
+static atomic_t notify_stop;
+static atomic_t notify_found;
+static atomic_t notify_missed;
+static atomic_t notify_error;
+
+uint8_t __wrap_bt_conn_index(struct bt_conn *conn)
+{
+	return (uint8_t *)conn - conn_buf;
+}
+
+static struct bt_conn *conn_get(size_t i)
+{
+	return (struct bt_conn *)&conn_buf[i];
+}
+
+static struct test_ctx *connect(size_t i, uint32_t seq)
+{
+	/* Notifications are not received before the context is initialized. */
+	k_sched_lock();
+
+	struct test_ctx *ctx = bt_conn_ctx_alloc(&test_ctx_lib, conn_get(i));
+
+	if (ctx) {
+		ctx->conn = conn_get(i);
+		ctx->seq = seq;
+		bt_conn_ctx_release(&test_ctx_lib, ctx);
+	}
+
+	k_sched_unlock();
+
+	return ctx;
+}
+
+static void test_setup(void)
+{
+	bt_conn_ctx_free_all(&test_ctx_lib);
+
+	zassert_equal(k_mem_slab_num_free_get(test_ctx_lib.mem_slab),
+		      CONFIG_BT_MAX_CONN, "Memory leaked");
+}
+
+static void test_conn_ctx_lookup(void)
+{
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		zassert_not_null(connect(i, i), "Cannot allocate context");
+	}
+
+	zassert_is_null(bt_conn_ctx_alloc(&test_ctx_lib, conn_get(0)),
+			"Context allocated twice");
+
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		struct test_ctx *ctx = bt_conn_ctx_get(&test_ctx_lib,
+						       conn_get(i));
+
+		zassert_not_null(ctx, "Context not found");
+		zassert_equal_ptr(ctx->conn, conn_get(i), "Wrong context");
+		bt_conn_ctx_release(&test_ctx_lib, ctx);
+
+		const struct bt_conn_ctx *conn_ctx =
+			bt_conn_ctx_get_by_id(&test_ctx_lib, i);
+
+		zassert_not_null(conn_ctx, "Context not found by id");
+		zassert_equal_ptr(conn_ctx->conn, conn_get(i), "Wrong context");
+		bt_conn_ctx_release(&test_ctx_lib, conn_ctx->data);
+	}
+
+	zassert_equal(bt_conn_ctx_free(&test_ctx_lib, conn_get(1)), 0,
+		      "Cannot free context");
+	zassert_is_null(bt_conn_ctx_get(&test_ctx_lib, conn_get(1)),
+			"Freed context found");
+	zassert_is_null(bt_conn_ctx_get_by_id(&test_ctx_lib, 1),
+			"Freed context found by id");
+	zassert_equal(bt_conn_ctx_free(&test_ctx_lib, conn_get(1)), -EINVAL,
+		      "Context freed twice");
+}
+
+static void test_conn_ctx_free_referenced(void)
+{
+	zassert_not_null(connect(0, 0), "Cannot allocate context");
+
+	struct test_ctx *ctx = bt_conn_ctx_get(&test_ctx_lib, conn_get(0));
+
+	zassert_not_null(ctx, "Context not found");
+
+	/* Disconnection while the context is used. */
+	zassert_equal(bt_conn_ctx_free(&test_ctx_lib, conn_get(0)), 0,
+		      "Cannot free context");
+	zassert_is_null(bt_conn_ctx_get(&test_ctx_lib, conn_get(0)),
+			"Freed context found");
+	zassert_is_null(bt_conn_ctx_alloc(&test_ctx_lib, conn_get(0)),
+			"Context allocated while in use");
+	zassert_equal(k_mem_slab_num_free_get(test_ctx_lib.mem_slab),
+		      CONFIG_BT_MAX_CONN - 1, "Memory released while in use");
+	zassert_equal_ptr(ctx->conn, conn_get(0), "Context data overwritten");
+
+	bt_conn_ctx_release(&test_ctx_lib, ctx);
+
+	zassert_equal(k_mem_slab_num_free_get(test_ctx_lib.mem_slab),
+		      CONFIG_BT_MAX_CONN, "Memory not released");
+	zassert_not_null(connect(0, 1), "Cannot allocate context again");
+}
+
+/* Looks up the contexts like a service does on every received
+ * notification.
+ */
+static void notify_fn(void *p1, void *p2, void *p3)
+{
+	size_t i = (uintptr_t)p1;
+
+	while (!atomic_get(&notify_stop)) {
+		struct bt_conn *conn = conn_get(i % CONFIG_BT_MAX_CONN);
+		struct test_ctx *ctx = bt_conn_ctx_get(&test_ctx_lib, conn);
+
+		i++;
+
+		if (!ctx) {
+			atomic_inc(&notify_missed);
+			k_yield();
+			continue;
+		}
+
+		uint32_t seq = ctx->seq;
+
+		k_yield();
+
+		/* The context must not be reused while it is referenced. */
+		if ((ctx->conn != conn) || (ctx->seq != seq)) {
+			atomic_inc(&notify_error);
+		}
+
+		bt_conn_ctx_release(&test_ctx_lib, ctx);
+		atomic_inc(&notify_found);
+	}
+
+	k_sem_give(&notify_done);
+}
+
+static void test_conn_ctx_stress(void)
+{
+	atomic_set(&notify_stop, false);
+	atomic_set(&notify_found, 0);
+	atomic_set(&notify_missed, 0);
+	atomic_set(&notify_error, 0);
+
+	for (size_t i = 0; i < CONFIG_BT_MAX_CONN; i++) {
+		zassert_not_null(connect(i, 0), "Cannot allocate context");
+	}
+
+	for (size_t i = 0; i < NOTIFY_THREAD_COUNT; i++) {
+		k_thread_create(&notify_thread[i], notify_stack[i],
+				K_THREAD_STACK_SIZEOF(notify_stack[i]),
+				notify_fn, (void *)i, NULL, NULL,
+				NOTIFY_THREAD_PRIO, 0, K_NO_WAIT);
+	}
+
+	uint32_t start = k_cycle_get_32();
+
+	/* Connections are dropped and established while notified. */
+	for (uint32_t seq = 1; seq <= RECONNECT_COUNT; seq++) {
+		size_t i = seq % CONFIG_BT_MAX_CONN;
+
+		zassert_equal(bt_conn_ctx_free(&test_ctx_lib, conn_get(i)), 0,
+			      "Cannot free context");
+
+		k_yield();
+
+		/* The previous context may still be referenced. */
+		while (!connect(i, seq)) {
+			k_sleep(K_MSEC(1));
+		}
+
+		if ((seq % 16) == 0) {
+			k_sleep(K_MSEC(1));
+		}
+	}
+
+	uint32_t cycles = k_cycle_get_32() - start;
+
+	atomic_set(&notify_stop, true);
+
+	for (size_t i = 0; i < NOTIFY_THREAD_COUNT; i++) {
+		zassert_equal(k_sem_take(&notify_done, K_SECONDS(1)), 0,
+			      "Notification thread not stopped");
+	}
+
+	TC_PRINT("Reconnections: %u, lookups: found %u, missed %u\n",
+		 RECONNECT_COUNT, (uint32_t)atomic_get(&notify_found),
+		 (uint32_t)atomic_get(&notify_missed));
+	TC_PRINT("Duration: %u us\n", k_cyc_to_us_floor32(cycles));
+
+	zassert_equal(atomic_get(&notify_error), 0, "Context reused while used");
+	zassert_true(atomic_get(&notify_found) > 0, "No context found");
+
+	bt_conn_ctx_free_all(&test_ctx_lib);
+	zassert_equal(k_mem_slab_num_free_get(test_ctx_lib.mem_slab),
+		      CONFIG_BT_MAX_CONN, "Memory leaked");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(
+		test_conn_ctx,
+		ztest_unit_test_setup_teardown(test_conn_ctx_lookup, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_conn_ctx_free_referenced, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_conn_ctx_stress, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_conn_ctx);
+}
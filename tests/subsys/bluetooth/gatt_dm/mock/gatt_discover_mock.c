@@ -11,21 +11,41 @@
 #include <ztest.h>
 #include <sys/util.h>
 
+#include "gatt_discover_mock.h"
 
 /* Settings of the discover mock */
 static struct bt_discover_mock {
 	const struct bt_gatt_attr *attr;
 	size_t len;
+	size_t count;
+} discover_mock_data;
+
+/* Discovery running on a connection */
+static struct bt_discover_mock_proc {
 	struct bt_conn *conn;
 	struct bt_gatt_discover_params *params;
 	struct k_delayed_work work;
-} discover_mock_data;
+} discover_mock_proc[CONFIG_BT_MAX_CONN];
+
+/* Settings of the read mock */
+static struct bt_read_mock {
+	const uint8_t *db_hash;
+	struct bt_conn *conn;
+	struct bt_gatt_read_params *params;
+	struct k_delayed_work work;
+} read_mock_data;
 
 
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len)
 {
 	discover_mock_data.attr = attr;
 	discover_mock_data.len  = len;
+	discover_mock_data.count = 0;
+}
+
+size_t bt_gatt_discover_mock_count(void)
+{
+	return discover_mock_data.count;
 }
 
 static bool bt_gatt_primary_check(const struct bt_gatt_attr *attr_cur,
@@ -43,8 +63,8 @@ static bool bt_gatt_primary_check(const struct bt_gatt_attr *attr_cur,
 
 static void bt_gatt_discover_work(struct k_work *work)
 {
-	struct bt_discover_mock *mock_data =
-		CONTAINER_OF(work, struct bt_discover_mock, work);
+	struct bt_discover_mock_proc *mock_data =
+		CONTAINER_OF(work, struct bt_discover_mock_proc, work);
 	const struct bt_gatt_attr *const attr_end =
 		discover_mock_data.attr + discover_mock_data.len;
 	const struct bt_gatt_attr *attr_cur;
@@ -122,11 +142,63 @@ static void bt_gatt_discover_work(struct k_work *work)
 int bt_gatt_discover(struct bt_conn *conn,
 		     struct bt_gatt_discover_params *params)
 {
+	struct bt_discover_mock_proc *mock_data = NULL;
+
 	printk("Running %s mock\n", __func__);
-	discover_mock_data.conn = conn;
-	discover_mock_data.params = params;
 
-	k_delayed_work_init(&(discover_mock_data.work), bt_gatt_discover_work);
-	k_delayed_work_submit(&(discover_mock_data.work), K_MSEC(5));
+	/* Each discovery uses its own parameters for all its procedures. */
+	for (size_t i = 0; i < ARRAY_SIZE(discover_mock_proc); i++) {
+		if ((discover_mock_proc[i].params == params) ||
+		    (!mock_data && !discover_mock_proc[i].params)) {
+			mock_data = &discover_mock_proc[i];
+		}
+	}
+	zassert_not_null(mock_data, "Too many discoveries");
+
+	discover_mock_data.count++;
+	mock_data->conn = conn;
+	mock_data->params = params;
+
+	k_delayed_work_init(&(mock_data->work), bt_gatt_discover_work);
+	k_delayed_work_submit(&(mock_data->work), K_MSEC(5));
+	return 0;
+}
+
+void bt_gatt_read_mock_setup(const uint8_t *db_hash)
+{
+	read_mock_data.db_hash = db_hash;
+}
+
+static void bt_gatt_read_work(struct k_work *work)
+{
+	struct bt_gatt_read_params *params = read_mock_data.params;
+
+	if (read_mock_data.db_hash) {
+		(void)params->func(read_mock_data.conn, 0, params,
+				   read_mock_data.db_hash,
+				   BT_GATT_DISCOVER_MOCK_HASH_LEN);
+	} else {
+		(void)params->func(read_mock_data.conn,
+				   BT_ATT_ERR_ATTRIBUTE_NOT_FOUND, params,
+				   NULL, 0);
+	}
+}
+
+/* Mocked version of the bt_gatt_read, for the Database Hash only */
+/* Call the bt_gatt_read_mock_setup function first */
+int __wrap_bt_gatt_read(struct bt_conn *conn,
+			struct bt_gatt_read_params *params)
+{
+	printk("Running %s mock\n", __func__);
+
+	zassert_equal(params->handle_count, 0, "Unexpected read by handle");
+	zassert_equal(bt_uuid_cmp(params->by_uuid.uuid, BT_UUID_GATT_DB_HASH),
+		      0, "Unexpected read by UUID");
+
+	read_mock_data.conn = conn;
+	read_mock_data.params = params;
+
+	k_delayed_work_init(&(read_mock_data.work), bt_gatt_read_work);
+	k_delayed_work_submit(&(read_mock_data.work), K_MSEC(5));
 	return 0;
 }
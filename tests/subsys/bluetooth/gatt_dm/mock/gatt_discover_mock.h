@@ -18,6 +18,9 @@
  * @brief The API used to setup the mock for bt_gatt_discover
  */
 
+/** Size of the Database Hash returned by the bt_gatt_read mock. */
+#define BT_GATT_DISCOVER_MOCK_HASH_LEN 16
+
 /**
  * @brief Service definition
  *
@@ -90,5 +93,25 @@
  */
 void bt_gatt_discover_mock_setup(const struct bt_gatt_attr *attr, size_t len);
 
+/**
+ * @brief Get the number of discovery procedures
+ *
+ * @return Number of @ref bt_gatt_discover calls since the last
+ *         @ref bt_gatt_discover_mock_setup.
+ */
+size_t bt_gatt_discover_mock_count(void);
+
+/**
+ * @brief GATT read mock setup
+ *
+ * This function setups the mock for @ref bt_gatt_read function.
+ * Only the read of the Database Hash is supported.
+ *
+ * @param db_hash Database Hash of the peer, of
+ *                @ref BT_GATT_DISCOVER_MOCK_HASH_LEN bytes,
+ *                or NULL if the peer has none.
+ */
+void bt_gatt_read_mock_setup(const uint8_t *db_hash);
+
 /** @} */
 #endif /* #define BT_GATT_DISCOVERY_MOCK_H_ */
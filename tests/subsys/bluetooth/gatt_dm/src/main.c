@@ -6,6 +6,7 @@
 #include <ztest.h>
 #include <kernel.h>
 #include <stddef.h>
+#include <string.h>
 #include <sys/util.h>
 #include <bluetooth/uuid.h>
 #include <bluetooth/gatt_dm.h>
@@ -15,7 +16,21 @@
 #define SERVICE_DISCOVERY_TIMEOUT 2000
 
 static char dummy_conn;
-K_SEM_DEFINE(discovery_finished, 0, 1);
+static char dummy_conn2;
+K_SEM_DEFINE(discovery_finished, 0, CONFIG_BT_MAX_CONN);
+
+static const bt_addr_le_t peer_addr = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a.val = { 0x01, 0x02, 0x03, 0x04, 0x05, 0xc6 },
+};
+
+static const bt_addr_le_t peer2_addr = {
+	.type = BT_ADDR_LE_PUBLIC,
+	.a.val = { 0x11, 0x12, 0x13, 0x14, 0x15, 0x16 },
+};
+
+static bool peer_bonded;
+static uint8_t db_hash[BT_GATT_DISCOVER_MOCK_HASH_LEN];
 
 
 const struct bt_gatt_attr discover_sim[] = {
@@ -73,10 +88,25 @@ struct bt_gatt_dm_cb test_hids_cb = {
 	.error_found       = test_cb_error_found
 };
 
+const bt_addr_le_t *__wrap_bt_conn_get_dst(const struct bt_conn *conn)
+{
+	return ((const char *)conn == &dummy_conn) ? &peer_addr : &peer2_addr;
+}
+
+bool __wrap_gatt_peer_cache_bonded(struct bt_conn *conn)
+{
+	return peer_bonded;
+}
+
 void test_setup(void)
 {
 	k_sem_reset(&discovery_finished);
 	bt_gatt_discover_mock_setup(discover_sim, ARRAY_SIZE(discover_sim));
+
+	peer_bonded = false;
+	memset(db_hash, 0xa5, sizeof(db_hash));
+	bt_gatt_read_mock_setup(db_hash);
+	bt_gatt_dm_cache_clear(NULL);
 }
 
 struct bt_gatt_dm *run_dm(const struct bt_uuid *svc_uuid)
@@ -376,6 +406,159 @@ void test_gatt_generic_serv(void)
 	/* No cleanup here - cleanup is done in run_dm_next */
 }
 
+/* Only one discovery can run at a time on a connection */
+void test_gatt_busy_conn(void)
+{
+	struct bt_gatt_dm *dm;
+	struct bt_gatt_dm *dm_busy = NULL;
+	int err;
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+			       BT_UUID_HIDS, &test_hids_cb, &dm);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+			       BT_UUID_DIS, &test_hids_cb, &dm_busy);
+	zassert_equal(-EALREADY, err, "Unexpected error: %d", err);
+
+	err = k_sem_take(&discovery_finished, K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+	zassert_equal(0, err, "It seems that no callback function was called: %d", err);
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_is_null(dm_busy, "Unexpected discovery result");
+
+	bt_gatt_dm_data_release(dm);
+}
+
+/* Discoveries on two connections run at the same time */
+void test_gatt_two_conns(void)
+{
+	struct bt_gatt_dm *dm = NULL;
+	struct bt_gatt_dm *dm2 = NULL;
+	struct bt_gatt_dm *dm_busy = NULL;
+	char dummy_conn3;
+	int err;
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn,
+			       BT_UUID_HIDS, &test_hids_cb, &dm);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn2,
+			       BT_UUID_DIS, &test_hids_cb, &dm2);
+	zassert_false(err, "Second connection not discovered: %d", err);
+
+	/* All the instances are in use */
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn3,
+			       BT_UUID_DIS, &test_hids_cb, &dm_busy);
+	zassert_equal(-EALREADY, err, "Unexpected error: %d", err);
+
+	for (int i = 0; i < 2; i++) {
+		err = k_sem_take(&discovery_finished,
+				 K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+		zassert_equal(0, err, "Discovery %d not completed", i);
+	}
+
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_not_null(dm2, "Device Manager pointer not set");
+	zassert_not_equal(dm, dm2, "Instance shared by the connections");
+	zassert_equal_ptr(bt_gatt_dm_conn_get(dm), &dummy_conn,
+			  "Wrong connection");
+	zassert_equal_ptr(bt_gatt_dm_conn_get(dm2), &dummy_conn2,
+			  "Wrong connection");
+	zassert_equal(11, bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+	zassert_equal(5, bt_gatt_dm_attr_cnt(dm2),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm2));
+	zassert_is_null(dm_busy, "Unexpected discovery result");
+
+	bt_gatt_dm_data_release(dm);
+	bt_gatt_dm_data_release(dm2);
+}
+
+/* Checks the attributes of the HIDS, discovered or restored from cache */
+static void check_hids(struct bt_gatt_dm *dm)
+{
+	const struct bt_gatt_dm_attr *attr;
+	const struct bt_gatt_chrc *chrc_val;
+
+	zassert_not_null(dm, "Device Manager pointer not set");
+	zassert_equal(11, bt_gatt_dm_attr_cnt(dm),
+		      "Unexpected number of attributes detected: %d",
+		      bt_gatt_dm_attr_cnt(dm));
+
+	attr = NULL;
+	for (int i = 2; i <= 11; ++i) {
+		attr = bt_gatt_dm_attr_next(dm, attr);
+		zassert_not_null(attr, "Attr handle: %d", i);
+		zassert_equal(i, attr->handle, "Attr handle: %d", i);
+	}
+
+	attr = bt_gatt_dm_char_by_uuid(dm, BT_UUID_HIDS_REPORT);
+	zassert_not_null(attr, "Report characteristic not found");
+	chrc_val = bt_gatt_dm_attr_chrc_val(attr);
+	zassert_equal(BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
+		      chrc_val->properties, "Unexpected properties");
+	attr = bt_gatt_dm_desc_by_uuid(dm, attr, BT_UUID_GATT_CCC);
+	zassert_not_null(attr, "CCC not found");
+	zassert_equal(8, attr->handle, "Unexpected handle: %d", attr->handle);
+}
+
+static size_t run_dm_hids_cached(void)
+{
+	struct bt_gatt_dm *dm;
+	size_t count;
+
+	bt_gatt_discover_mock_setup(discover_sim, ARRAY_SIZE(discover_sim));
+	dm = run_dm(BT_UUID_HIDS);
+	count = bt_gatt_discover_mock_count();
+	check_hids(dm);
+	bt_gatt_dm_data_release(dm);
+
+	return count;
+}
+
+/* A bonded peer with the same Database Hash is not discovered again */
+void test_gatt_cache_hit(void)
+{
+	peer_bonded = true;
+
+	zassert_true(run_dm_hids_cached() > 0, "Service not discovered");
+	zassert_equal(0, run_dm_hids_cached(), "Cached result not used");
+
+	/* The cache is cleared when the bond is removed */
+	bt_gatt_dm_cache_clear(&peer_addr);
+	zassert_true(run_dm_hids_cached() > 0,
+		     "Cached result used after clear");
+}
+
+/* The cached result is not used when the Database Hash changed */
+void test_gatt_cache_hash_changed(void)
+{
+	peer_bonded = true;
+
+	zassert_true(run_dm_hids_cached() > 0, "Service not discovered");
+
+	db_hash[0] ^= 0x01;
+	zassert_true(run_dm_hids_cached() > 0,
+		     "Cached result used after database change");
+	zassert_equal(0, run_dm_hids_cached(),
+		      "Result after database change not cached");
+}
+
+/* Results are only cached for bonded peers with a Database Hash */
+void test_gatt_cache_miss(void)
+{
+	zassert_true(run_dm_hids_cached() > 0, "Service not discovered");
+	zassert_true(run_dm_hids_cached() > 0, "Result cached without bond");
+
+	peer_bonded = true;
+	bt_gatt_read_mock_setup(NULL);
+	zassert_true(run_dm_hids_cached() > 0, "Service not discovered");
+	zassert_true(run_dm_hids_cached() > 0,
+		     "Result cached without Database Hash");
+}
+
 void test_main(void)
 {
 	ztest_test_suite(
@@ -387,7 +570,12 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_attr_by_handle, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_next_chrc_access, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_chrc_by_uuid, test_setup, unit_test_noop),
-		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop)
+		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_busy_conn, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_two_conns, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_hit, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_hash_changed, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_cache_miss, test_setup, unit_test_noop)
 	);
 
 	ztest_run_test_suite(test_gatt);
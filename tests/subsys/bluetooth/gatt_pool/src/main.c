@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <bluetooth/gatt_pool.h>
+
+/* Service similar to the HID service with many reports. */
+#define REPORT_CNT		30
+#define SVC_UUID16_CNT		(1 + 2 * REPORT_CNT)
+#define SVC_ATTR_CNT		(1 + 4 * REPORT_CNT)
+#define BENCHMARK_ITERATIONS	1000
+
+static struct bt_gatt_pool svc_a = BT_GATT_POOL_INIT(SVC_ATTR_CNT);
+static struct bt_gatt_pool svc_b = BT_GATT_POOL_INIT(SVC_ATTR_CNT);
+static struct _bt_gatt_ccc ccc_a[REPORT_CNT];
+static struct _bt_gatt_ccc ccc_b[REPORT_CNT];
+
+static int service_build(struct bt_gatt_pool *gp, struct _bt_gatt_ccc *ccc)
+{
+	static const struct bt_gatt_attr chrc_attr =
+		BT_GATT_ATTRIBUTE(BT_UUID_HIDS_REPORT, BT_GATT_PERM_READ,
+				  NULL, NULL, NULL);
+	static const struct bt_gatt_attr desc_attr =
+		BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ,
+				   NULL, NULL, NULL);
+	int err;
+
+	err = bt_gatt_pool_svc_alloc(gp, BT_UUID_HIDS);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < REPORT_CNT; i++) {
+		err = bt_gatt_pool_chrc_alloc(gp, BT_GATT_CHRC_READ |
+						  BT_GATT_CHRC_NOTIFY,
+					      &chrc_attr);
+		if (err) {
+			return err;
+		}
+
+		ccc[i] = (struct _bt_gatt_ccc)BT_GATT_CCC_INITIALIZER(NULL,
+								      NULL,
+								      NULL);
+		err = bt_gatt_pool_ccc_alloc(gp, &ccc[i], BT_GATT_PERM_READ |
+							  BT_GATT_PERM_WRITE);
+		if (err) {
+			return err;
+		}
+
+		err = bt_gatt_pool_desc_alloc(gp, &desc_attr);
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static void service_verify(struct bt_gatt_pool *gp)
+{
+	zassert_equal(gp->svc.attr_count, SVC_ATTR_CNT,
+		      "Wrong number of attributes");
+	zassert_false(bt_uuid_cmp(gp->svc.attrs[0].user_data, BT_UUID_HIDS),
+		      "Wrong service UUID");
+
+	for (size_t i = 0; i < REPORT_CNT; i++) {
+		const struct bt_gatt_attr *attr = &gp->svc.attrs[1 + 4 * i];
+		const struct bt_gatt_chrc *chrc = attr[0].user_data;
+
+		zassert_false(bt_uuid_cmp(chrc->uuid, BT_UUID_HIDS_REPORT),
+			      "Wrong characteristic declaration");
+		zassert_false(bt_uuid_cmp(attr[1].uuid, BT_UUID_HIDS_REPORT),
+			      "Wrong characteristic value UUID");
+		zassert_false(bt_uuid_cmp(attr[3].uuid, BT_UUID_HIDS_REPORT_REF),
+			      "Wrong descriptor UUID");
+	}
+}
+
+static void stats_get(enum bt_gatt_pool_type type,
+		      struct bt_gatt_pool_stats *stats)
+{
+	zassert_equal(bt_gatt_pool_stats_get(type, stats), 0,
+		      "Cannot get statistics");
+}
+
+static void test_setup(void)
+{
+	bt_gatt_pool_free(&svc_a);
+	bt_gatt_pool_free(&svc_b);
+}
+
+static void test_gatt_pool_build(void)
+{
+	struct bt_gatt_pool_stats uuid_stats;
+	struct bt_gatt_pool_stats chrc_stats;
+
+	zassert_equal(service_build(&svc_a, ccc_a), 0, "Cannot build service");
+	service_verify(&svc_a);
+
+	stats_get(BT_GATT_POOL_TYPE_UUID16, &uuid_stats);
+	stats_get(BT_GATT_POOL_TYPE_CHRC, &chrc_stats);
+
+	zassert_equal(uuid_stats.size, CONFIG_BT_GATT_UUID16_POOL_SIZE,
+		      "Wrong pool size");
+	zassert_equal(uuid_stats.used, SVC_UUID16_CNT, "Wrong UUID usage");
+	zassert_equal(chrc_stats.used, REPORT_CNT, "Wrong chrc usage");
+	zassert_true(uuid_stats.max_used >= SVC_UUID16_CNT,
+		     "Wrong maximum UUID usage");
+
+	bt_gatt_pool_free(&svc_a);
+
+	stats_get(BT_GATT_POOL_TYPE_UUID16, &uuid_stats);
+	stats_get(BT_GATT_POOL_TYPE_CHRC, &chrc_stats);
+
+	zassert_equal(uuid_stats.used, 0, "UUIDs not released");
+	zassert_equal(chrc_stats.used, 0, "Chrcs not released");
+
+	zassert_equal(bt_gatt_pool_stats_get(BT_GATT_POOL_TYPE_COUNT,
+					     &uuid_stats),
+		      -EINVAL, "Statistics of unknown pool");
+}
+
+static void test_gatt_pool_fragmented(void)
+{
+	zassert_equal(service_build(&svc_a, ccc_a), 0, "Cannot build service");
+	zassert_equal(service_build(&svc_b, ccc_b), 0, "Cannot build service");
+
+	/* Free elements are placed before the elements in use. */
+	bt_gatt_pool_free(&svc_a);
+	zassert_equal(service_build(&svc_a, ccc_a), 0,
+		      "Cannot build service again");
+
+	service_verify(&svc_a);
+	service_verify(&svc_b);
+}
+
+static void test_gatt_pool_exhausted(void)
+{
+	static struct bt_gatt_pool svc_c = BT_GATT_POOL_INIT(SVC_ATTR_CNT);
+	static struct _bt_gatt_ccc ccc_c[REPORT_CNT];
+	struct bt_gatt_pool_stats before;
+	struct bt_gatt_pool_stats after;
+
+	BUILD_ASSERT(3 * SVC_UUID16_CNT > CONFIG_BT_GATT_UUID16_POOL_SIZE);
+
+	stats_get(BT_GATT_POOL_TYPE_UUID16, &before);
+
+	zassert_equal(service_build(&svc_a, ccc_a), 0, "Cannot build service");
+	zassert_equal(service_build(&svc_b, ccc_b), 0, "Cannot build service");
+	zassert_equal(service_build(&svc_c, ccc_c), -ENOMEM,
+		      "Service built in exhausted pool");
+
+	stats_get(BT_GATT_POOL_TYPE_UUID16, &after);
+
+	zassert_equal(after.used, CONFIG_BT_GATT_UUID16_POOL_SIZE,
+		      "Pool not exhausted");
+	zassert_equal(after.max_used, CONFIG_BT_GATT_UUID16_POOL_SIZE,
+		      "Wrong maximum usage");
+	zassert_equal(after.fail_cnt, before.fail_cnt + 1,
+		      "Failed allocation not counted");
+
+	bt_gatt_pool_free(&svc_c);
+	bt_gatt_pool_free(&svc_a);
+
+	zassert_equal(service_build(&svc_a, ccc_a), 0,
+		      "Cannot build service after release");
+	service_verify(&svc_a);
+	service_verify(&svc_b);
+}
+
+static void test_gatt_pool_benchmark(void)
+{
+	struct bt_gatt_pool_stats before;
+	struct bt_gatt_pool_stats after;
+	uint32_t build_cycles = 0;
+	uint32_t free_cycles = 0;
+
+	stats_get(BT_GATT_POOL_TYPE_UUID16, &before);
+
+	for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		uint32_t start = k_cycle_get_32();
+
+		zassert_equal(service_build(&svc_a, ccc_a), 0,
+			      "Cannot build service");
+		zassert_equal(service_build(&svc_b, ccc_b), 0,
+			      "Cannot build service");
+
+		uint32_t mid = k_cycle_get_32();
+
+		bt_gatt_pool_free(&svc_b);
+		bt_gatt_pool_free(&svc_a);
+
+		build_cycles += mid - start;
+		free_cycles += k_cycle_get_32() - mid;
+	}
+
+	stats_get(BT_GATT_POOL_TYPE_UUID16, &after);
+
+	TC_PRINT("%u iterations of %u attributes\n", BENCHMARK_ITERATIONS,
+		 2 * SVC_ATTR_CNT);
+	TC_PRINT("Build: %u us, free: %u us per iteration\n",
+		 k_cyc_to_us_floor32(build_cycles / BENCHMARK_ITERATIONS),
+		 k_cyc_to_us_floor32(free_cycles / BENCHMARK_ITERATIONS));
+
+	zassert_equal(after.alloc_cnt - before.alloc_cnt,
+		      2 * SVC_UUID16_CNT * BENCHMARK_ITERATIONS,
+		      "Wrong number of allocations");
+	zassert_equal(after.used, 0, "Elements not released");
+
+	bt_gatt_pool_stats_print();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(
+		test_gatt_pool,
+		ztest_unit_test_setup_teardown(test_gatt_pool_build, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_pool_fragmented, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_pool_exhausted, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_pool_benchmark, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_gatt_pool);
+}
@@ -0,0 +1,463 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <bluetooth/bluetooth.h>
+#include <bluetooth/buf.h>
+#include <bluetooth/hci.h>
+#include <drivers/bluetooth/hci_driver.h>
+
+#include "hci_driver_stats.h"
+
+#define ACL_LONG_PAYLOAD_LEN	251
+#define ADV_REPORT_CNT		(CONFIG_BT_DISCARDABLE_BUF_COUNT + 5)
+#define CAPTURE_MAX		16
+#define ACL_HOLD_MAX		32
+#define REPLAY_TIMEOUT		K_MSEC(500)
+
+struct packet {
+	uint8_t type;
+	const uint8_t *data;
+	size_t len;
+};
+
+#define PACKET(_type, _data) {			\
+	.type = _type,				\
+	.data = _data,				\
+	.len = sizeof(_data),			\
+}
+
+/* HCI packets recorded from a connection of a peripheral. */
+static const uint8_t evt_le_conn_complete[] = {
+	0x3e, 0x13, 0x01, 0x00, 0x01, 0x00, 0x01, 0x01, 0x11, 0x22, 0x33,
+	0x44, 0x55, 0xc6, 0x28, 0x00, 0x00, 0x00, 0x2c, 0x01, 0x00
+};
+static const uint8_t evt_num_completed_packets[] = {
+	0x13, 0x05, 0x01, 0x01, 0x00, 0x02, 0x00
+};
+static const uint8_t evt_disconn_complete[] = {
+	0x05, 0x04, 0x00, 0x01, 0x00, 0x13
+};
+static const uint8_t evt_le_adv_report[] = {
+	0x3e, 0x0c, 0x02, 0x01, 0x00, 0x01, 0x11, 0x22, 0x33, 0x44, 0x55,
+	0xc6, 0x00, 0xc4
+};
+static const uint8_t acl_att_read_rsp[] = {
+	0x01, 0x20, 0x07, 0x00, 0x03, 0x00, 0x04, 0x00, 0x0b, 0x03, 0x00
+};
+static const uint8_t acl_l2cap_cont[] = {
+	0x01, 0x10, 0x02, 0x00, 0xaa, 0x55
+};
+static uint8_t acl_att_notify[sizeof(struct bt_hci_acl_hdr) +
+			      ACL_LONG_PAYLOAD_LEN];
+/* Header of a packet longer than a host buffer. */
+static const uint8_t acl_too_long[] = {
+	0x01, 0x20, 0xff, 0x00
+};
+
+static const struct packet stream[] = {
+	PACKET(BT_BUF_EVT, evt_le_conn_complete),
+	PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+	PACKET(BT_BUF_ACL_IN, acl_att_notify),
+	PACKET(BT_BUF_EVT, evt_num_completed_packets),
+	PACKET(BT_BUF_ACL_IN, acl_l2cap_cont),
+	PACKET(BT_BUF_ACL_IN, acl_att_notify),
+	PACKET(BT_BUF_EVT, evt_le_adv_report),
+	PACKET(BT_BUF_ACL_IN, acl_att_notify),
+	PACKET(BT_BUF_EVT, evt_disconn_complete),
+};
+
+static const struct packet *replay;
+static size_t replay_cnt;
+static size_t evt_idx;
+static size_t acl_idx;
+
+static struct net_buf *captured[CAPTURE_MAX];
+static atomic_t captured_cnt;
+static K_SEM_DEFINE(captured_sem, 0, CAPTURE_MAX);
+
+static k_tid_t test_thread;
+static uint8_t acl_pool_id;
+/* Host data buffers freed by the driver without being filled. */
+static atomic_t acl_unfilled_freed;
+
+void host_signal(void);
+int __real_hci_internal_evt_get(uint8_t *evt_out);
+int __real_sdc_hci_data_get(uint8_t *data_out);
+int __real_bt_recv(struct net_buf *buf);
+void __real_net_buf_unref(struct net_buf *buf);
+
+/* Returns the next packet of the given type. */
+static const struct packet *packet_next(const struct packet *packets,
+					size_t cnt, uint8_t type, size_t *idx)
+{
+	while (*idx < cnt) {
+		const struct packet *packet = &packets[(*idx)++];
+
+		if (packet->type == type) {
+			return packet;
+		}
+	}
+
+	return NULL;
+}
+
+int __wrap_hci_internal_evt_get(uint8_t *evt_out)
+{
+	if (!replay) {
+		return __real_hci_internal_evt_get(evt_out);
+	}
+
+	const struct packet *packet = packet_next(replay, replay_cnt,
+						  BT_BUF_EVT, &evt_idx);
+
+	if (!packet) {
+		return -1;
+	}
+
+	memcpy(evt_out, packet->data, packet->len);
+
+	return 0;
+}
+
+int __wrap_sdc_hci_data_get(uint8_t *data_out)
+{
+	if (!replay) {
+		return __real_sdc_hci_data_get(data_out);
+	}
+
+	const struct packet *packet = packet_next(replay, replay_cnt,
+						  BT_BUF_ACL_IN, &acl_idx);
+
+	if (!packet) {
+		return -1;
+	}
+
+	memcpy(data_out, packet->data, packet->len);
+
+	return 0;
+}
+
+int __wrap_bt_recv(struct net_buf *buf)
+{
+	if (!replay) {
+		return __real_bt_recv(buf);
+	}
+
+	atomic_val_t idx = atomic_get(&captured_cnt);
+
+	if (idx >= CAPTURE_MAX) {
+		net_buf_unref(buf);
+		return 0;
+	}
+
+	captured[idx] = buf;
+	atomic_inc(&captured_cnt);
+	k_sem_give(&captured_sem);
+
+	return 0;
+}
+
+/* With host flow control, freeing a data buffer reports a completed packet
+ * to the controller, so the driver must only free the buffers that it passed
+ * to the host.
+ */
+void __wrap_net_buf_unref(struct net_buf *buf)
+{
+	if (replay && (k_current_get() != test_thread) &&
+	    (buf->pool_id == acl_pool_id) && (buf->len == 0)) {
+		atomic_inc(&acl_unfilled_freed);
+	}
+
+	__real_net_buf_unref(buf);
+}
+
+static void replay_start(const struct packet *packets, size_t cnt)
+{
+	evt_idx = 0;
+	acl_idx = 0;
+	replay_cnt = cnt;
+	atomic_set(&captured_cnt, 0);
+	k_sem_reset(&captured_sem);
+	replay = packets;
+
+	/* Signal the receive thread as the controller does. */
+	host_signal();
+}
+
+static void captured_wait(size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		zassert_equal(k_sem_take(&captured_sem, REPLAY_TIMEOUT), 0,
+			      "Packet %u not received", i);
+	}
+
+	/* Let the receive thread finish the replay. */
+	k_sleep(K_MSEC(10));
+	replay = NULL;
+}
+
+static void captured_release(void)
+{
+	for (size_t i = 0; i < atomic_get(&captured_cnt); i++) {
+		net_buf_unref(captured[i]);
+	}
+
+	atomic_set(&captured_cnt, 0);
+}
+
+/* The packets of each type are passed to the host in order, but the events
+ * and the data packets may be interleaved differently.
+ */
+static void captured_verify(const struct packet *packets, size_t cnt)
+{
+	size_t evt_next = 0;
+	size_t acl_next = 0;
+
+	zassert_equal(atomic_get(&captured_cnt), cnt, "Packets lost");
+
+	for (size_t i = 0; i < cnt; i++) {
+		struct net_buf *buf = captured[i];
+		uint8_t type = bt_buf_get_type(buf);
+		const struct packet *packet =
+			packet_next(packets, cnt, type,
+				    (type == BT_BUF_EVT) ? &evt_next : &acl_next);
+
+		zassert_not_null(packet, "Unexpected packet %u", i);
+		zassert_equal(buf->len, packet->len, "Wrong packet %u length",
+			      i);
+		zassert_mem_equal(buf->data, packet->data, packet->len,
+				  "Packet %u not identical", i);
+	}
+}
+
+static size_t acl_pool_hold(struct net_buf **held, size_t cnt)
+{
+	size_t held_cnt = 0;
+
+	while (held_cnt < cnt) {
+		held[held_cnt] = bt_buf_get_rx(BT_BUF_ACL_IN, K_NO_WAIT);
+		if (!held[held_cnt]) {
+			break;
+		}
+
+		held_cnt++;
+	}
+
+	zassert_true(held_cnt < cnt, "Pool not exhausted");
+
+	return held_cnt;
+}
+
+static void acl_pool_release(struct net_buf **held, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++) {
+		net_buf_unref(held[i]);
+	}
+}
+
+static void test_setup(void)
+{
+	captured_release();
+	atomic_set(&acl_unfilled_freed, 0);
+}
+
+static void test_hci_driver_replay(void)
+{
+	struct hci_driver_stats before;
+	struct hci_driver_stats after;
+	size_t acl_cnt = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(stream); i++) {
+		if (stream[i].type == BT_BUF_ACL_IN) {
+			acl_cnt++;
+		}
+	}
+
+	hci_driver_stats_get(&before);
+
+	replay_start(stream, ARRAY_SIZE(stream));
+	captured_wait(ARRAY_SIZE(stream));
+	captured_verify(stream, ARRAY_SIZE(stream));
+
+	hci_driver_stats_get(&after);
+
+	zassert_equal(after.acl_copy_avoided - before.acl_copy_avoided,
+		      acl_cnt, "Data packets copied");
+	zassert_equal(after.acl_copied, before.acl_copied,
+		      "Data packets copied");
+	zassert_equal(atomic_get(&acl_unfilled_freed), 0,
+		      "Data buffer freed without data");
+}
+
+static void test_hci_driver_evt_only(void)
+{
+	static const struct packet packets[] = {
+		PACKET(BT_BUF_EVT, evt_le_conn_complete),
+		PACKET(BT_BUF_EVT, evt_num_completed_packets),
+		PACKET(BT_BUF_EVT, evt_disconn_complete),
+	};
+
+	/* Every wakeup also polls the controller for data. */
+	for (size_t i = 0; i < ARRAY_SIZE(packets); i++) {
+		replay_start(&packets[i], 1);
+		captured_wait(1);
+		captured_verify(&packets[i], 1);
+		captured_release();
+	}
+
+	zassert_equal(atomic_get(&acl_unfilled_freed), 0,
+		      "Data buffer freed without data");
+}
+
+static void test_hci_driver_pool_exhausted(void)
+{
+	static const struct packet packets[] = {
+		PACKET(BT_BUF_ACL_IN, acl_att_notify),
+		PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+	};
+	struct net_buf *held[ACL_HOLD_MAX];
+	struct hci_driver_stats before;
+	struct hci_driver_stats after;
+	size_t held_cnt;
+
+	hci_driver_stats_get(&before);
+
+	held_cnt = acl_pool_hold(held, ARRAY_SIZE(held));
+
+	replay_start(packets, ARRAY_SIZE(packets));
+
+	/* The receive thread waits for a buffer. Only the buffer that the
+	 * driver keeps for the next packet can be used.
+	 */
+	k_sleep(K_MSEC(10));
+	zassert_true(atomic_get(&captured_cnt) <= 1,
+		     "Packet received without buffer");
+
+	acl_pool_release(held, held_cnt);
+
+	captured_wait(ARRAY_SIZE(packets));
+	captured_verify(packets, ARRAY_SIZE(packets));
+
+	hci_driver_stats_get(&after);
+
+	zassert_true(after.acl_copied - before.acl_copied >= 1,
+		      "Fallback copy not counted");
+	zassert_equal((after.acl_copied - before.acl_copied) +
+		      (after.acl_copy_avoided - before.acl_copy_avoided),
+		      ARRAY_SIZE(packets), "Data packets not counted");
+}
+
+static void test_hci_driver_acl_too_long(void)
+{
+	static const struct packet packets[] = {
+		PACKET(BT_BUF_ACL_IN, acl_too_long),
+		PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+		PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+		PACKET(BT_BUF_ACL_IN, acl_too_long),
+		PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+	};
+	static const struct packet expected[] = {
+		PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+		PACKET(BT_BUF_ACL_IN, acl_att_read_rsp),
+	};
+	struct net_buf *held[ACL_HOLD_MAX];
+	struct hci_driver_stats before;
+	struct hci_driver_stats after;
+	size_t held_cnt;
+
+	hci_driver_stats_get(&before);
+
+	/* The first packets are written directly to a host buffer. */
+	replay_start(packets, 2);
+	captured_wait(1);
+	captured_verify(expected, 1);
+	captured_release();
+
+	/* The first of the next packets uses the buffer kept by the driver.
+	 * The packet after it is fetched to the driver buffer, and dropped
+	 * once a host buffer is freed.
+	 */
+	held_cnt = acl_pool_hold(held, ARRAY_SIZE(held));
+	replay_start(&packets[2], 3);
+	k_sleep(K_MSEC(10));
+	acl_pool_release(held, held_cnt);
+	captured_wait(ARRAY_SIZE(expected));
+	captured_verify(expected, ARRAY_SIZE(expected));
+
+	hci_driver_stats_get(&after);
+
+	zassert_equal(after.acl_dropped - before.acl_dropped, 2,
+		      "Dropped packets not counted");
+	zassert_equal(atomic_get(&acl_unfilled_freed), 0,
+		      "Data buffer freed without data");
+}
+
+static void test_hci_driver_evt_discarded(void)
+{
+	static struct packet packets[ADV_REPORT_CNT];
+	struct hci_driver_stats before;
+	struct hci_driver_stats after;
+
+	for (size_t i = 0; i < ARRAY_SIZE(packets); i++) {
+		packets[i] = (struct packet)PACKET(BT_BUF_EVT,
+						   evt_le_adv_report);
+	}
+
+	hci_driver_stats_get(&before);
+
+	/* The reports are not released by the host. */
+	replay_start(packets, ARRAY_SIZE(packets));
+	captured_wait(CONFIG_BT_DISCARDABLE_BUF_COUNT);
+
+	hci_driver_stats_get(&after);
+
+	zassert_equal(atomic_get(&captured_cnt),
+		      CONFIG_BT_DISCARDABLE_BUF_COUNT,
+		      "Wrong number of reports received");
+	zassert_equal(after.evt_discarded - before.evt_discarded,
+		      ADV_REPORT_CNT - CONFIG_BT_DISCARDABLE_BUF_COUNT,
+		      "Discarded reports not counted");
+
+	captured_verify(packets, CONFIG_BT_DISCARDABLE_BUF_COUNT);
+}
+
+void test_main(void)
+{
+	struct bt_hci_acl_hdr *hdr = (void *)acl_att_notify;
+	uint8_t *payload = &acl_att_notify[sizeof(*hdr)];
+
+	hdr->handle = sys_cpu_to_le16(bt_acl_handle_pack(0x0001, BT_ACL_START));
+	hdr->len = sys_cpu_to_le16(ACL_LONG_PAYLOAD_LEN);
+
+	/* L2CAP header of the ATT channel and ATT Handle Value Notification. */
+	sys_put_le16(ACL_LONG_PAYLOAD_LEN - 4, &payload[0]);
+	sys_put_le16(0x0004, &payload[2]);
+	payload[4] = 0x1b;
+	sys_put_le16(0x0010, &payload[5]);
+	for (size_t i = 7; i < ACL_LONG_PAYLOAD_LEN; i++) {
+		payload[i] = i;
+	}
+
+	zassert_equal(bt_enable(NULL), 0, "Bluetooth not enabled");
+
+	struct net_buf *buf = bt_buf_get_rx(BT_BUF_ACL_IN, K_NO_WAIT);
+
+	zassert_not_null(buf, "No data buffer");
+	acl_pool_id = buf->pool_id;
+	net_buf_unref(buf);
+	test_thread = k_current_get();
+
+	ztest_test_suite(
+		test_hci_driver,
+		ztest_unit_test_setup_teardown(test_hci_driver_replay, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hci_driver_evt_only, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hci_driver_pool_exhausted, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hci_driver_acl_too_long, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hci_driver_evt_discarded, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_hci_driver);
+}
@@ -0,0 +1,654 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <string.h>
+#include <settings/settings.h>
+#include <bluetooth/gatt_dm.h>
+#include <bluetooth/services/hogp.h>
+#include <sys/byteorder.h>
+
+#include "hogp_cache.h"
+
+/* Timeout of the simulated GATT procedures in ms */
+#define SIM_TIMEOUT 2000
+#define SIM_MTU 23
+
+/* Handles of the simulated HID service */
+enum {
+	HANDLE_SVC = 1,
+	HANDLE_INFO_CHRC,
+	HANDLE_INFO,
+	HANDLE_MAP_CHRC,
+	HANDLE_MAP,
+	HANDLE_INPUT_CHRC,
+	HANDLE_INPUT,
+	HANDLE_INPUT_CCC,
+	HANDLE_INPUT_REF,
+	HANDLE_FEATURE_CHRC,
+	HANDLE_FEATURE,
+	HANDLE_FEATURE_REF,
+	HANDLE_CP_CHRC,
+	HANDLE_CP,
+	HANDLE_COUNT
+};
+
+#define SIM_SERV(_handle, _uuid, _end_handle) {                           \
+		.uuid = BT_UUID_GATT_PRIMARY,                             \
+		.handle = _handle,                                        \
+		.user_data = (void *)(&(const struct bt_gatt_service_val) \
+			{ .uuid = _uuid, .end_handle = _end_handle })     \
+	}
+
+#define SIM_CHRC(_handle, _uuid, _props) {                         \
+		.uuid = BT_UUID_GATT_CHRC,                         \
+		.handle = _handle,                                 \
+		.user_data = (void *)(&(const struct bt_gatt_chrc) \
+			{ .uuid = _uuid, .properties = _props })   \
+	}
+
+#define SIM_DESC(_handle, _uuid) { \
+		.uuid = _uuid,     \
+		.handle = _handle  \
+	}
+
+static const bt_addr_le_t peer_addr = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a.val = { 0x01, 0x02, 0x03, 0x04, 0x05, 0xc6 },
+};
+
+/* Settings key of the layout of peer_addr */
+#define PEER_KEY "bt/hogp/c6050403020101"
+
+static const bt_addr_le_t other_addr = {
+	.type = BT_ADDR_LE_PUBLIC,
+	.a.val = { 0x11, 0x12, 0x13, 0x14, 0x15, 0x16 },
+};
+
+static const uint8_t db_hash[HOGP_CACHE_DB_HASH_LEN] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+/* Longer than a read response, to be read in two chunks */
+static const uint8_t report_map[] = {
+	0x05, 0x01, /* Usage Page (Generic Desktop) */
+	0x09, 0x02, /* Usage (Mouse) */
+	0xa1, 0x01, /* Collection (Application) */
+	0x85, 0x01, /* Report Id 1 */
+	0x09, 0x01, /* Usage (Pointer) */
+	0xa1, 0x00, /* Collection (Physical) */
+	0x05, 0x09, /* Usage Page (Buttons) */
+	0x19, 0x01, /* Usage Minimum (1) */
+	0x29, 0x03, /* Usage Maximum (3) */
+	0x15, 0x00, /* Logical Minimum (0) */
+	0x25, 0x01, /* Logical Maximum (1) */
+	0x95, 0x03, /* Report Count (3) */
+	0x75, 0x01, /* Report Size (1) */
+	0x81, 0x02, /* Input (Data, Variable, Absolute) */
+	0xc0,       /* End Collection */
+	0xc0,       /* End Collection */
+};
+
+/* GATT database of the simulated peer */
+static const struct bt_gatt_attr peer_db[] = {
+	SIM_SERV(HANDLE_SVC, BT_UUID_HIDS, HANDLE_CP),
+	SIM_CHRC(HANDLE_INFO_CHRC, BT_UUID_HIDS_INFO, BT_GATT_CHRC_READ),
+	SIM_DESC(HANDLE_INFO, BT_UUID_HIDS_INFO),
+	SIM_CHRC(HANDLE_MAP_CHRC, BT_UUID_HIDS_REPORT_MAP, BT_GATT_CHRC_READ),
+	SIM_DESC(HANDLE_MAP, BT_UUID_HIDS_REPORT_MAP),
+	SIM_CHRC(HANDLE_INPUT_CHRC, BT_UUID_HIDS_REPORT,
+		 BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY),
+	SIM_DESC(HANDLE_INPUT, BT_UUID_HIDS_REPORT),
+	SIM_DESC(HANDLE_INPUT_CCC, BT_UUID_GATT_CCC),
+	SIM_DESC(HANDLE_INPUT_REF, BT_UUID_HIDS_REPORT_REF),
+	SIM_CHRC(HANDLE_FEATURE_CHRC, BT_UUID_HIDS_REPORT,
+		 BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE),
+	SIM_DESC(HANDLE_FEATURE, BT_UUID_HIDS_REPORT),
+	SIM_DESC(HANDLE_FEATURE_REF, BT_UUID_HIDS_REPORT_REF),
+	SIM_CHRC(HANDLE_CP_CHRC, BT_UUID_HIDS_CTRL_POINT,
+		 BT_GATT_CHRC_WRITE_WITHOUT_RESP),
+	SIM_DESC(HANDLE_CP, BT_UUID_HIDS_CTRL_POINT),
+};
+
+/* State of the simulated peer */
+static struct {
+	bool bonded;
+	uint8_t db_hash[HOGP_CACHE_DB_HASH_LEN];
+	uint8_t info[4];
+	uint8_t input_ref[2];
+	uint8_t feature_ref[2];
+	/* Number of Database Hash reads */
+	uint32_t hash_reads;
+	/* Number of reads of each handle */
+	uint32_t reads[HANDLE_COUNT];
+} peer;
+
+static char sim_conn;
+static struct bt_gatt_discover_params *discover_params;
+static struct bt_gatt_read_params *read_params;
+static struct k_work discover_work;
+static struct k_work read_work;
+
+static struct bt_hogp hogp;
+static uint8_t map_buf[sizeof(report_map)];
+static size_t map_len;
+
+static K_SEM_DEFINE(dm_done, 0, 1);
+static K_SEM_DEFINE(hogp_ready, 0, 1);
+static K_SEM_DEFINE(map_done, 0, 1);
+
+/* Layout read on the first connection */
+static struct hogp_cache_layout stored;
+/* Layout restored on reconnection */
+static struct hogp_cache_layout restored;
+
+static void layout_fill(struct hogp_cache_layout *layout)
+{
+	memset(layout, 0, sizeof(*layout));
+	memcpy(layout->db_hash, db_hash, sizeof(layout->db_hash));
+	layout->info.bcd_hid = 0x0101;
+	layout->info.b_country_code = 0;
+	layout->info.flags = BT_HIDS_REMOTE_WAKE;
+	layout->rep_count = 2;
+	layout->rep[0].val = 0x0012;
+	layout->rep[0].id = 1;
+	layout->rep[0].type = BT_HIDS_REPORT_TYPE_INPUT;
+	layout->rep[1].val = 0x0016;
+	layout->rep[1].id = 2;
+	layout->rep[1].type = BT_HIDS_REPORT_TYPE_FEATURE;
+	layout->map_len = sizeof(report_map);
+	memcpy(layout->map, report_map, sizeof(report_map));
+}
+
+static void test_setup(void)
+{
+	(void)hogp_cache_delete(&peer_addr);
+	(void)hogp_cache_delete(&other_addr);
+	layout_fill(&stored);
+	memset(&restored, 0xff, sizeof(restored));
+}
+
+static void test_hogp_cache_reconnect(void)
+{
+	int err;
+
+	err = hogp_cache_save(&peer_addr, &stored);
+	zassert_equal(err, 0, "Cannot store the layout");
+
+	/* The peer reconnects and reports the same Database Hash */
+	err = hogp_cache_load(&peer_addr, db_hash, &restored);
+	zassert_equal(err, 0, "Cannot restore the layout");
+	zassert_equal(restored.rep_count, stored.rep_count,
+		      "Wrong report count");
+	zassert_mem_equal(restored.rep, stored.rep,
+			  stored.rep_count * sizeof(stored.rep[0]),
+			  "Wrong reports");
+	zassert_mem_equal(&restored.info, &stored.info, sizeof(stored.info),
+			  "Wrong HID information");
+	zassert_equal(restored.map_len, sizeof(report_map),
+		      "Wrong report map length");
+	zassert_mem_equal(restored.map, report_map, sizeof(report_map),
+			  "Wrong report map");
+}
+
+static void test_hogp_cache_no_map(void)
+{
+	int err;
+
+	/* The report map is stored later, if the application reads it */
+	stored.map_len = 0;
+
+	err = hogp_cache_save(&peer_addr, &stored);
+	zassert_equal(err, 0, "Cannot store the layout");
+
+	err = hogp_cache_load(&peer_addr, db_hash, &restored);
+	zassert_equal(err, 0, "Cannot restore the layout");
+	zassert_equal(restored.map_len, 0, "Unexpected report map");
+	zassert_equal(hogp_cache_layout_size(&restored),
+		      offsetof(struct hogp_cache_layout, map),
+		      "Wrong layout size");
+}
+
+static void test_hogp_cache_hash_changed(void)
+{
+	uint8_t new_hash[HOGP_CACHE_DB_HASH_LEN];
+	int err;
+
+	err = hogp_cache_save(&peer_addr, &stored);
+	zassert_equal(err, 0, "Cannot store the layout");
+
+	memcpy(new_hash, db_hash, sizeof(new_hash));
+	new_hash[0] ^= 0x01;
+
+	err = hogp_cache_load(&peer_addr, new_hash, &restored);
+	zassert_equal(err, -ENOENT, "Layout restored after database change");
+}
+
+static void test_hogp_cache_other_peer(void)
+{
+	int err;
+
+	err = hogp_cache_save(&peer_addr, &stored);
+	zassert_equal(err, 0, "Cannot store the layout");
+
+	err = hogp_cache_load(&other_addr, db_hash, &restored);
+	zassert_equal(err, -ENOENT, "Layout restored for another peer");
+}
+
+static void test_hogp_cache_delete(void)
+{
+	int err;
+
+	err = hogp_cache_save(&peer_addr, &stored);
+	zassert_equal(err, 0, "Cannot store the layout");
+
+	/* The bond is removed */
+	err = hogp_cache_delete(&peer_addr);
+	zassert_equal(err, 0, "Cannot delete the layout");
+
+	err = hogp_cache_load(&peer_addr, db_hash, &restored);
+	zassert_equal(err, -ENOENT, "Layout restored after delete");
+}
+
+static void test_hogp_cache_invalid_size(void)
+{
+	uint8_t value[4] = { 0 };
+	int err;
+
+	/* A value shorter than the fixed part of a layout */
+	err = settings_save_one(PEER_KEY, value, sizeof(value));
+	zassert_equal(err, 0, "Cannot store the value");
+
+	err = hogp_cache_load(&peer_addr, db_hash, &restored);
+	zassert_equal(err, -ENOENT, "Layout of invalid size restored");
+
+	/* Loading all settings, as done at boot, uses the same handler */
+	err = settings_load();
+	zassert_equal(err, 0, "Cannot load the settings");
+
+	err = hogp_cache_save(&peer_addr, &stored);
+	zassert_equal(err, 0, "Cannot store the layout");
+
+	err = settings_load();
+	zassert_equal(err, 0, "Cannot load the settings");
+
+	err = hogp_cache_load(&peer_addr, db_hash, &restored);
+	zassert_equal(err, 0, "Cannot restore the layout");
+}
+
+static bool discover_match(const struct bt_gatt_discover_params *params,
+			   const struct bt_gatt_attr *attr)
+{
+	const struct bt_gatt_service_val *svc = attr->user_data;
+
+	switch (params->type) {
+	case BT_GATT_DISCOVER_PRIMARY:
+		return !bt_uuid_cmp(attr->uuid, BT_UUID_GATT_PRIMARY) &&
+		       (!params->uuid || !bt_uuid_cmp(params->uuid, svc->uuid));
+	case BT_GATT_DISCOVER_CHARACTERISTIC:
+		return !bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC);
+	case BT_GATT_DISCOVER_ATTRIBUTE:
+		return true;
+	default:
+		zassert_unreachable("Invalid discovery type: %u",
+				    params->type);
+		return false;
+	}
+}
+
+static void discover_work_handler(struct k_work *work)
+{
+	struct bt_gatt_discover_params *params = discover_params;
+
+	for (size_t i = 0; i < ARRAY_SIZE(peer_db); i++) {
+		const struct bt_gatt_attr *attr = &peer_db[i];
+
+		if (attr->handle < params->start_handle) {
+			continue;
+		}
+		if (attr->handle > params->end_handle) {
+			break;
+		}
+		if (!discover_match(params, attr)) {
+			continue;
+		}
+
+		/* The callback may start the next discovery. */
+		if (params->func((struct bt_conn *)&sim_conn, attr, params) ==
+		    BT_GATT_ITER_STOP) {
+			return;
+		}
+	}
+
+	(void)params->func((struct bt_conn *)&sim_conn, NULL, params);
+}
+
+int __wrap_bt_gatt_discover(struct bt_conn *conn,
+			    struct bt_gatt_discover_params *params)
+{
+	discover_params = params;
+	k_work_submit(&discover_work);
+
+	return 0;
+}
+
+static void read_work_handler(struct k_work *work)
+{
+	struct bt_gatt_read_params *params = read_params;
+	const uint8_t *data = NULL;
+	uint16_t len = 0;
+	uint8_t err = 0;
+
+	if (params->handle_count == 0) {
+		zassert_equal(bt_uuid_cmp(params->by_uuid.uuid,
+					  BT_UUID_GATT_DB_HASH), 0,
+			      "Unexpected read by UUID");
+		peer.hash_reads++;
+		data = peer.db_hash;
+		len = sizeof(peer.db_hash);
+	} else {
+		uint16_t handle = params->single.handle;
+		size_t offset = params->single.offset;
+
+		zassert_true(handle < HANDLE_COUNT, "Invalid handle %u",
+			     handle);
+		peer.reads[handle]++;
+
+		switch (handle) {
+		case HANDLE_INFO:
+			data = peer.info;
+			len = sizeof(peer.info);
+			break;
+		case HANDLE_INPUT_REF:
+			data = peer.input_ref;
+			len = sizeof(peer.input_ref);
+			break;
+		case HANDLE_FEATURE_REF:
+			data = peer.feature_ref;
+			len = sizeof(peer.feature_ref);
+			break;
+		case HANDLE_MAP:
+			if (offset > sizeof(report_map)) {
+				err = BT_ATT_ERR_INVALID_OFFSET;
+				break;
+			}
+			data = &report_map[offset];
+			len = MIN(sizeof(report_map) - offset, SIM_MTU - 1);
+			break;
+		default:
+			err = BT_ATT_ERR_READ_NOT_PERMITTED;
+			break;
+		}
+	}
+
+	/* The callback may start the next read. */
+	(void)params->func((struct bt_conn *)&sim_conn, err, params,
+			   err ? NULL : data, len);
+}
+
+int __wrap_bt_gatt_read(struct bt_conn *conn,
+			struct bt_gatt_read_params *params)
+{
+	read_params = params;
+	k_work_submit(&read_work);
+
+	return 0;
+}
+
+uint16_t __wrap_bt_gatt_get_mtu(struct bt_conn *conn)
+{
+	return SIM_MTU;
+}
+
+const bt_addr_le_t *__wrap_bt_conn_get_dst(const struct bt_conn *conn)
+{
+	return &peer_addr;
+}
+
+bool __wrap_gatt_peer_cache_bonded(struct bt_conn *conn)
+{
+	return peer.bonded;
+}
+
+static void dm_completed(struct bt_gatt_dm *dm, void *context)
+{
+	*(struct bt_gatt_dm **)context = dm;
+	k_sem_give(&dm_done);
+}
+
+static void dm_service_not_found(struct bt_conn *conn, void *context)
+{
+	zassert_unreachable("HIDS not found");
+}
+
+static void dm_error_found(struct bt_conn *conn, int err, void *context)
+{
+	zassert_unreachable("Discovery error: %d", err);
+}
+
+static const struct bt_gatt_dm_cb dm_cb = {
+	.completed         = dm_completed,
+	.service_not_found = dm_service_not_found,
+	.error_found       = dm_error_found,
+};
+
+static void hogp_ready_cb(struct bt_hogp *hogp)
+{
+	k_sem_give(&hogp_ready);
+}
+
+static void hogp_prep_error_cb(struct bt_hogp *hogp, int err)
+{
+	zassert_unreachable("HIDS client preparation error: %d", err);
+}
+
+static void map_cb(struct bt_hogp *hogp, uint8_t err, const uint8_t *data,
+		   size_t size, size_t offset)
+{
+	int ret;
+
+	zassert_equal(err, 0, "Report map read error: %u", err);
+	zassert_true(offset + size <= sizeof(map_buf), "Report map too big");
+
+	memcpy(&map_buf[offset], data, size);
+	map_len = offset + size;
+
+	if (size < SIM_MTU - 1) {
+		k_sem_give(&map_done);
+		return;
+	}
+
+	ret = bt_hogp_map_read(hogp, map_cb, map_len, K_NO_WAIT);
+	zassert_equal(ret, 0, "Cannot read next chunk: %d", ret);
+}
+
+static void sim_setup(void)
+{
+	const struct bt_hogp_init_params params = {
+		.ready_cb = hogp_ready_cb,
+		.prep_error_cb = hogp_prep_error_cb,
+	};
+
+	test_setup();
+
+	memset(&peer, 0, sizeof(peer));
+	peer.bonded = true;
+	memcpy(peer.db_hash, db_hash, sizeof(peer.db_hash));
+	sys_put_le16(0x0101, &peer.info[0]);
+	peer.info[2] = 0;
+	peer.info[3] = BT_HIDS_NORMALLY_CONNECTABLE;
+	peer.input_ref[0] = 1;
+	peer.input_ref[1] = BT_HIDS_REPORT_TYPE_INPUT;
+	peer.feature_ref[0] = 2;
+	peer.feature_ref[1] = BT_HIDS_REPORT_TYPE_FEATURE;
+
+	k_work_init(&discover_work, discover_work_handler);
+	k_work_init(&read_work, read_work_handler);
+	k_sem_reset(&dm_done);
+	k_sem_reset(&hogp_ready);
+	k_sem_reset(&map_done);
+
+	bt_hogp_init(&hogp, &params);
+}
+
+/* Connect to the peer, and discover and prepare its HID service. */
+static void peer_connect(void)
+{
+	struct bt_gatt_dm *dm;
+	int err;
+
+	peer.hash_reads = 0;
+	memset(peer.reads, 0, sizeof(peer.reads));
+
+	err = bt_gatt_dm_start((struct bt_conn *)&sim_conn, BT_UUID_HIDS,
+			       &dm_cb, &dm);
+	zassert_equal(err, 0, "bt_gatt_dm_start failed: %d", err);
+	err = k_sem_take(&dm_done, K_MSEC(SIM_TIMEOUT));
+	zassert_equal(err, 0, "Discovery not completed");
+
+	err = bt_hogp_handles_assign(dm, &hogp);
+	zassert_equal(err, 0, "bt_hogp_handles_assign failed: %d", err);
+	bt_gatt_dm_data_release(dm);
+
+	err = k_sem_take(&hogp_ready, K_MSEC(SIM_TIMEOUT));
+	zassert_equal(err, 0, "HIDS client not ready");
+}
+
+static void peer_disconnect(void)
+{
+	bt_hogp_release(&hogp);
+}
+
+static void map_read(void)
+{
+	int err;
+
+	memset(map_buf, 0, sizeof(map_buf));
+	map_len = 0;
+
+	err = bt_hogp_map_read(&hogp, map_cb, 0, K_NO_WAIT);
+	zassert_equal(err, 0, "bt_hogp_map_read failed: %d", err);
+	err = k_sem_take(&map_done, K_MSEC(SIM_TIMEOUT));
+	zassert_equal(err, 0, "Report map not read");
+
+	zassert_equal(map_len, sizeof(report_map), "Wrong report map length");
+	zassert_mem_equal(map_buf, report_map, sizeof(report_map),
+			  "Wrong report map");
+}
+
+static void check_reports(uint8_t input_id, uint8_t feature_id)
+{
+	const struct bt_hids_info *info = bt_hogp_conn_info_val(&hogp);
+
+	zassert_equal(info->bcd_hid, 0x0101, "Wrong HID information");
+	zassert_equal(info->flags, BT_HIDS_NORMALLY_CONNECTABLE,
+		      "Wrong HID information flags");
+	zassert_equal(bt_hogp_rep_count(&hogp), 2, "Wrong report count");
+	zassert_not_null(bt_hogp_rep_find(&hogp, BT_HIDS_REPORT_TYPE_INPUT,
+					  input_id),
+			 "Input report %u not found", input_id);
+	zassert_not_null(bt_hogp_rep_find(&hogp, BT_HIDS_REPORT_TYPE_FEATURE,
+					  feature_id),
+			 "Feature report %u not found", feature_id);
+}
+
+static void check_layout_reads(uint32_t count)
+{
+	zassert_equal(peer.reads[HANDLE_INFO], count,
+		      "HID information read %u times",
+		      peer.reads[HANDLE_INFO]);
+	zassert_equal(peer.reads[HANDLE_INPUT_REF], count,
+		      "Input report reference read %u times",
+		      peer.reads[HANDLE_INPUT_REF]);
+	zassert_equal(peer.reads[HANDLE_FEATURE_REF], count,
+		      "Feature report reference read %u times",
+		      peer.reads[HANDLE_FEATURE_REF]);
+}
+
+static void test_hogp_sim_reconnect(void)
+{
+	/* First connection: the layout is read from the peer and stored */
+	peer_connect();
+	zassert_equal(peer.hash_reads, 1, "Database Hash not read");
+	check_layout_reads(1);
+	check_reports(1, 2);
+	map_read();
+	zassert_equal(peer.reads[HANDLE_MAP], 2, "Report map read %u times",
+		      peer.reads[HANDLE_MAP]);
+	peer_disconnect();
+
+	/* Reconnection: only the Database Hash is read */
+	peer_connect();
+	zassert_equal(peer.hash_reads, 1, "Database Hash not read");
+	check_layout_reads(0);
+	check_reports(1, 2);
+	map_read();
+	zassert_equal(peer.reads[HANDLE_MAP], 0,
+		      "Report map read from the peer");
+	peer_disconnect();
+}
+
+static void test_hogp_sim_hash_changed(void)
+{
+	peer_connect();
+	map_read();
+	peer_disconnect();
+
+	/* The peer updates its database: the cached layout is not used */
+	peer.db_hash[0] ^= 0x01;
+	peer.input_ref[0] = 3;
+
+	peer_connect();
+	check_layout_reads(1);
+	check_reports(3, 2);
+	map_read();
+	zassert_equal(peer.reads[HANDLE_MAP], 2,
+		      "Report map not read from the peer");
+	peer_disconnect();
+
+	/* The layout read after the change is cached */
+	peer_connect();
+	check_layout_reads(0);
+	check_reports(3, 2);
+	map_read();
+	zassert_equal(peer.reads[HANDLE_MAP], 0,
+		      "Report map read from the peer");
+	peer_disconnect();
+}
+
+static void test_hogp_sim_not_bonded(void)
+{
+	peer.bonded = false;
+
+	for (int i = 0; i < 2; i++) {
+		peer_connect();
+		zassert_equal(peer.hash_reads, 0,
+			      "Database Hash read without bond");
+		check_layout_reads(1);
+		check_reports(1, 2);
+		peer_disconnect();
+	}
+}
+
+void test_main(void)
+{
+	zassert_equal(settings_subsys_init(), 0, "Settings init failed");
+
+	ztest_test_suite(
+		test_hogp_cache,
+		ztest_unit_test_setup_teardown(test_hogp_cache_reconnect, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_cache_no_map, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_cache_hash_changed, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_cache_other_peer, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_cache_delete, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_cache_invalid_size, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_sim_reconnect, sim_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_sim_hash_changed, sim_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_hogp_sim_not_bonded, sim_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_hogp_cache);
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <stdio.h>
+#include <bluetooth/scan.h>
+
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+#include "native_rtc.h"
+#endif
+
+#define FILTER_CNT_MAX		256
+#define NAME_MAX_LEN		16
+#define REPORT_UUID_CNT		3
+#define REPORT_CNT		20000
+#define MATCH_DIVIDER		4
+
+BUILD_ASSERT(CONFIG_BT_SCAN_NAME_CNT == FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_ADDRESS_CNT == FILTER_CNT_MAX);
+BUILD_ASSERT(CONFIG_BT_SCAN_UUID_CNT == FILTER_CNT_MAX);
+
+static struct bt_le_scan_cb *scan_cb;
+static uint32_t match_cnt;
+static uint32_t no_match_cnt;
+static struct bt_scan_filter_match last_match;
+
+void __wrap_bt_le_scan_cb_register(struct bt_le_scan_cb *cb)
+{
+	scan_cb = cb;
+}
+
+static void scan_filter_match(struct bt_scan_device_info *device_info,
+			      struct bt_scan_filter_match *filter_match,
+			      bool connectable)
+{
+	match_cnt++;
+	last_match = *filter_match;
+}
+
+static void scan_filter_no_match(struct bt_scan_device_info *device_info,
+				 bool connectable)
+{
+	no_match_cnt++;
+}
+
+BT_SCAN_CB_INIT(scan_cb_data, scan_filter_match, scan_filter_no_match,
+		NULL, NULL);
+
+static void name_get(char *name, uint32_t id)
+{
+	snprintf(name, NAME_MAX_LEN, "Device %04u", id);
+}
+
+static void addr_get(bt_addr_le_t *addr, uint32_t id)
+{
+	addr->type = BT_ADDR_LE_RANDOM;
+	sys_put_le32(id, &addr->a.val[0]);
+	sys_put_le16(0xC0DE, &addr->a.val[4]);
+}
+
+static uint16_t uuid_get(uint32_t id)
+{
+	return 0x2000 + id;
+}
+
+static void filters_add(size_t cnt)
+{
+	bt_scan_filter_remove_all();
+
+	for (uint32_t i = 0; i < cnt; i++) {
+		char name[NAME_MAX_LEN];
+		bt_addr_le_t addr;
+		struct bt_uuid_16 uuid = BT_UUID_INIT_16(uuid_get(i));
+
+		name_get(name, i);
+		addr_get(&addr, i);
+
+		zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, name),
+			      0, "Cannot add name filter");
+		zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr),
+			      0, "Cannot add address filter");
+		zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_UUID,
+						 &uuid.uuid),
+			      0, "Cannot add UUID filter");
+	}
+}
+
+/* Builds an advertising report of a device with the given identifier.
+ * The report contains the name, the address and the UUIDs of the device
+ * and its neighbours.
+ */
+static void report_feed(uint32_t id)
+{
+	NET_BUF_SIMPLE_DEFINE(ad, BT_GAP_ADV_MAX_ADV_DATA_LEN);
+	char name[NAME_MAX_LEN];
+	bt_addr_le_t addr;
+	struct bt_le_scan_recv_info info = {
+		.addr = &addr,
+		.adv_props = BT_GAP_ADV_PROP_CONNECTABLE,
+	};
+
+	name_get(name, id);
+	addr_get(&addr, id);
+
+	net_buf_simple_add_u8(&ad, 2);
+	net_buf_simple_add_u8(&ad, BT_DATA_FLAGS);
+	net_buf_simple_add_u8(&ad, BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR);
+
+	net_buf_simple_add_u8(&ad, 1 + strlen(name));
+	net_buf_simple_add_u8(&ad, BT_DATA_NAME_COMPLETE);
+	net_buf_simple_add_mem(&ad, name, strlen(name));
+
+	net_buf_simple_add_u8(&ad, 1 + REPORT_UUID_CNT * sizeof(uint16_t));
+	net_buf_simple_add_u8(&ad, BT_DATA_UUID16_ALL);
+	for (uint32_t i = 0; i < REPORT_UUID_CNT; i++) {
+		net_buf_simple_add_le16(&ad, uuid_get(id + i));
+	}
+
+	scan_cb->recv(&info, &ad);
+}
+
+static uint64_t time_us_get(void)
+{
+#if defined(CONFIG_BOARD_NATIVE_POSIX)
+	/* The simulated time does not advance while the CPU is busy. */
+	return native_rtc_gettime_us(RTC_CLOCK_REAL);
+#else
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+
+static void test_setup(void)
+{
+	bt_scan_filter_remove_all();
+
+	match_cnt = 0;
+	no_match_cnt = 0;
+}
+
+static void test_scan_filter_add(void)
+{
+	struct bt_filter_status status;
+	char name[NAME_MAX_LEN];
+	bt_addr_le_t addr;
+	struct bt_uuid_16 uuid = BT_UUID_INIT_16(uuid_get(0));
+
+	filters_add(FILTER_CNT_MAX);
+
+	name_get(name, 0);
+	addr_get(&addr, 0);
+
+	/* Duplicated filters are ignored. */
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, name), 0,
+		      "Duplicated name filter rejected");
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr), 0,
+		      "Duplicated address filter rejected");
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_UUID, &uuid.uuid),
+		      0, "Duplicated UUID filter rejected");
+
+	zassert_equal(bt_scan_filter_get(&status), 0, "Cannot get status");
+	zassert_equal(status.name.cnt, FILTER_CNT_MAX,
+		      "Wrong name filter count");
+	zassert_equal(status.addr.cnt, FILTER_CNT_MAX,
+		      "Wrong address filter count");
+	zassert_equal(status.uuid.cnt, FILTER_CNT_MAX,
+		      "Wrong UUID filter count");
+
+	name_get(name, FILTER_CNT_MAX);
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, name),
+		      -ENOMEM, "Name filter added above limit");
+}
+
+static void test_scan_filter_match(void)
+{
+	const size_t filter_cnt = 32;
+
+	filters_add(filter_cnt);
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER, false), 0,
+		      "Cannot enable filters");
+
+	for (uint32_t i = 0; i < 2 * filter_cnt; i++) {
+		uint32_t prev_match_cnt = match_cnt;
+		char name[NAME_MAX_LEN];
+
+		report_feed(i);
+
+		if (i < filter_cnt) {
+			name_get(name, i);
+			zassert_equal(match_cnt, prev_match_cnt + 1,
+				      "Name %u not matched", i);
+			zassert_true(last_match.name.match, "No name match");
+			zassert_equal(strcmp(last_match.name.name, name), 0,
+				      "Wrong name matched");
+		}
+	}
+
+	zassert_equal(match_cnt, filter_cnt, "Wrong number of matches");
+
+	/* Every device advertises the UUIDs of its neighbours. */
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_ADDR_FILTER |
+					    BT_SCAN_UUID_FILTER, true), 0,
+		      "Cannot enable filters");
+
+	match_cnt = 0;
+	for (uint32_t i = 0; i < 2 * filter_cnt; i++) {
+		report_feed(i);
+	}
+
+	zassert_equal(match_cnt, 0, "Match without all UUIDs advertised");
+
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_ADDR_FILTER |
+					    BT_SCAN_UUID_FILTER, false), 0,
+		      "Cannot enable filters");
+
+	match_cnt = 0;
+	for (uint32_t i = 0; i < 2 * filter_cnt; i++) {
+		report_feed(i);
+	}
+
+	zassert_equal(match_cnt, filter_cnt, "Wrong number of matches");
+
+	bt_scan_filter_remove_all();
+
+	match_cnt = 0;
+	report_feed(0);
+	zassert_equal(match_cnt, 0, "Match after filters removed");
+}
+
+static void test_scan_name_prefix(void)
+{
+	static const char * const names[] = {
+		"Keyboard", "Mouse", "Mouse Pro", "Gamepad"
+	};
+	struct bt_scan_short_name short_name = {
+		.name = "Mouse Pro",
+		.min_len = 4,
+	};
+	NET_BUF_SIMPLE_DEFINE(ad, BT_GAP_ADV_MAX_ADV_DATA_LEN);
+	bt_addr_le_t addr = *BT_ADDR_LE_ANY;
+	struct bt_le_scan_recv_info info = {
+		.addr = &addr,
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+		zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME,
+						 names[i]),
+			      0, "Cannot add name filter");
+	}
+
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_SHORT_NAME,
+					 &short_name),
+		      0, "Cannot add short name filter");
+	zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+					    BT_SCAN_SHORT_NAME_FILTER, false),
+		      0, "Cannot enable filters");
+
+	static const struct {
+		uint8_t type;
+		const char *name;
+		bool match;
+	} reports[] = {
+		{ BT_DATA_NAME_COMPLETE, "Mouse", true },
+		{ BT_DATA_NAME_COMPLETE, "Mouse Pro", true },
+		{ BT_DATA_NAME_COMPLETE, "Mouse Pro 2", false },
+		{ BT_DATA_NAME_COMPLETE, "Gamepa", true },
+		{ BT_DATA_NAME_COMPLETE, "Joystick", false },
+		{ BT_DATA_NAME_SHORTENED, "Mous", true },
+		{ BT_DATA_NAME_SHORTENED, "Mou", false },
+		{ BT_DATA_NAME_SHORTENED, "Keyb", false },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(reports); i++) {
+		uint32_t prev_match_cnt = match_cnt;
+		size_t len = strlen(reports[i].name);
+
+		net_buf_simple_reset(&ad);
+		net_buf_simple_add_u8(&ad, 1 + len);
+		net_buf_simple_add_u8(&ad, reports[i].type);
+		net_buf_simple_add_mem(&ad, reports[i].name, len);
+
+		scan_cb->recv(&info, &ad);
+
+		zassert_equal(match_cnt - prev_match_cnt, reports[i].match,
+			      "Wrong match of %s", reports[i].name);
+	}
+}
+
+static void test_scan_benchmark(void)
+{
+	static const size_t filter_cnt[] = {1, 32, FILTER_CNT_MAX};
+
+	for (size_t i = 0; i < ARRAY_SIZE(filter_cnt); i++) {
+		filters_add(filter_cnt[i]);
+
+		zassert_equal(bt_scan_filter_enable(BT_SCAN_NAME_FILTER |
+						    BT_SCAN_ADDR_FILTER |
+						    BT_SCAN_UUID_FILTER,
+						    false),
+			      0, "Cannot enable filters");
+
+		match_cnt = 0;
+		no_match_cnt = 0;
+
+		/* Most of the devices around are not looked for. */
+		uint64_t start = time_us_get();
+
+		for (uint32_t j = 0; j < REPORT_CNT; j++) {
+			uint32_t id = j % (MATCH_DIVIDER * filter_cnt[i]);
+
+			report_feed(id);
+		}
+
+		uint64_t duration = time_us_get() - start;
+
+		TC_PRINT("%u filters: %u reports in %u us, %u matched\n",
+			 (uint32_t)filter_cnt[i], REPORT_CNT, (uint32_t)duration,
+			 match_cnt);
+
+		zassert_equal(match_cnt + no_match_cnt, REPORT_CNT,
+			      "Report not processed");
+		zassert_true(match_cnt >= REPORT_CNT / MATCH_DIVIDER,
+			     "Wrong number of matches");
+	}
+}
+
+void test_main(void)
+{
+	bt_scan_init(NULL);
+	bt_scan_cb_register(&scan_cb_data);
+
+	zassert_not_null(scan_cb, "Scan callback not registered");
+
+	ztest_test_suite(
+		test_scan,
+		ztest_unit_test_setup_teardown(test_scan_filter_add, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_scan_filter_match, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_scan_name_prefix, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_scan_benchmark, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_scan);
+}
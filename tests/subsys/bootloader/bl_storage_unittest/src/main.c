@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <../subsys/bootloader/bl_storage/bl_storage_internal.h>
+
+#define NUM_SLOTS 64
+#define FREE 0xFFFF
+
+/* Simulated OTP region holding the counter slots. */
+static uint16_t otp[NUM_SLOTS];
+static uint32_t num_reads;
+
+static uint16_t otp_read(const uint16_t *slot)
+{
+	num_reads++;
+	return *slot;
+}
+
+/* Write the slots in order, with bit-flipped values like the bootloader. */
+static void otp_fill(uint16_t num_written, uint16_t first_value)
+{
+	memset(otp, 0xFF, sizeof(otp));
+
+	for (uint16_t i = 0; i < num_written; i++) {
+		otp[i] = ~(uint16_t)(first_value + 2 * i);
+	}
+}
+
+static void check_same_as_scan(uint16_t num_slots)
+{
+	uint16_t scan_idx;
+	uint16_t find_idx;
+	uint16_t scan_value = counter_scan(otp, num_slots, otp_read,
+					   &scan_idx);
+	uint16_t find_value = counter_find(otp, num_slots, otp_read,
+					   &find_idx);
+
+	zassert_equal(scan_value, find_value, "Wrong value");
+	zassert_equal(scan_idx, find_idx, "Wrong free slot");
+}
+
+void test_empty(void)
+{
+	uint16_t free_idx = 1;
+
+	otp_fill(0, 0);
+
+	zassert_equal(0, counter_find(otp, NUM_SLOTS, otp_read, &free_idx),
+		      NULL);
+	zassert_equal(0, free_idx, NULL);
+
+	zassert_equal(0, counter_find(otp, 0, otp_read, &free_idx), NULL);
+	zassert_equal(0, free_idx, NULL);
+}
+
+void test_partially_written(void)
+{
+	for (uint16_t num_slots = 1; num_slots <= NUM_SLOTS; num_slots++) {
+		for (uint16_t written = 0; written <= num_slots; written++) {
+			otp_fill(written, 10);
+			check_same_as_scan(num_slots);
+		}
+	}
+}
+
+void test_full(void)
+{
+	uint16_t free_idx;
+
+	otp_fill(NUM_SLOTS, 10);
+
+	zassert_equal(10 + 2 * (NUM_SLOTS - 1),
+		      counter_find(otp, NUM_SLOTS, otp_read, &free_idx), NULL);
+	zassert_equal(NUM_SLOTS, free_idx, NULL);
+}
+
+void test_number_of_reads(void)
+{
+	uint16_t free_idx;
+
+	otp_fill(NUM_SLOTS / 2 + 3, 10);
+
+	num_reads = 0;
+	counter_find(otp, NUM_SLOTS, otp_read, &free_idx);
+	zassert_true(num_reads <= 9, "%u reads", num_reads);
+
+	num_reads = 0;
+	counter_scan(otp, NUM_SLOTS, otp_read, &free_idx);
+	zassert_equal(NUM_SLOTS / 2 + 4, num_reads, NULL);
+}
+
+void test_interrupted_write(void)
+{
+	/* An interrupted write leaves some bits of the last slot unwritten,
+	 * so the value is smaller than the ones before it.
+	 */
+	for (uint16_t written = 2; written <= NUM_SLOTS; written++) {
+		otp_fill(written, 100);
+		otp[written - 1] |= 0xFFF0;
+		check_same_as_scan(NUM_SLOTS);
+	}
+
+	/* The slot is still free if none of the bits were written. */
+	otp_fill(5, 100);
+	otp[5] = FREE;
+	check_same_as_scan(NUM_SLOTS);
+}
+
+void test_corrupted_slot(void)
+{
+	uint16_t free_idx;
+
+	/* A corrupted slot before the last one does not hide the value of
+	 * the last one.
+	 */
+	otp_fill(20, 100);
+	otp[7] |= 0xFF00;
+	check_same_as_scan(NUM_SLOTS);
+	zassert_equal(100 + 2 * 19,
+		      counter_find(otp, NUM_SLOTS, otp_read, &free_idx), NULL);
+
+	/* An interrupted write followed by a successful one. */
+	otp_fill(20, 100);
+	otp[18] |= 0xFFF0;
+	check_same_as_scan(NUM_SLOTS);
+}
+
+void test_written_after_free(void)
+{
+	uint16_t free_idx;
+
+	/* A written slot after a free one breaks the order of the slots. The
+	 * slot returned is still free, so it can be written.
+	 */
+	for (uint16_t hole = 0; hole < 20; hole++) {
+		otp_fill(20, 100);
+		otp[hole] = FREE;
+
+		counter_find(otp, NUM_SLOTS, otp_read, &free_idx);
+		zassert_true(free_idx < NUM_SLOTS, NULL);
+		zassert_equal(FREE, otp[free_idx], "Hole %u", hole);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(test_bl_storage_unittest,
+			 ztest_unit_test(test_empty),
+			 ztest_unit_test(test_partially_written),
+			 ztest_unit_test(test_full),
+			 ztest_unit_test(test_number_of_reads),
+			 ztest_unit_test(test_interrupted_write),
+			 ztest_unit_test(test_corrupted_slot),
+			 ztest_unit_test(test_written_after_free)
+	);
+	ztest_run_test_suite(test_bl_storage_unittest);
+}
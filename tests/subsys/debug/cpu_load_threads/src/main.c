@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <kernel.h>
+#include <debug/cpu_load.h>
+#include <tracing_user.h>
+
+#define NUM_THREADS 7
+#define STACK_SIZE 1024
+#define PRIORITY K_PRIO_PREEMPT(1)
+#define TEST_IRQ 10
+/* Longer than a slice, so that the ISR moves the window forward. */
+#define TEST_ISR_BUSY_MS 120
+
+static K_THREAD_STACK_ARRAY_DEFINE(stacks, NUM_THREADS, STACK_SIZE);
+static struct k_thread threads[NUM_THREADS];
+static struct cpu_load_ctx_stat stats[CONFIG_CPU_LOAD_THREADS_MAX + 1];
+static bool isr_armed;
+
+void posix_sw_set_pending_IRQ(unsigned int IRQn);
+uint32_t __real_sys_clock_cycle_get_32(void);
+
+/* Raise the test interrupt right after the time is read, as if it fired
+ * while a tracing hook runs. The interrupt is handled immediately, unless
+ * interrupts are locked.
+ */
+uint32_t __wrap_sys_clock_cycle_get_32(void)
+{
+	uint32_t now = __real_sys_clock_cycle_get_32();
+
+	if (isr_armed) {
+		isr_armed = false;
+		posix_sw_set_pending_IRQ(TEST_IRQ);
+	}
+
+	return now;
+}
+
+static void test_isr_handler(const void *arg)
+{
+	k_busy_wait(TEST_ISR_BUSY_MS * USEC_PER_MSEC);
+}
+
+static uint32_t ms_to_cycles(uint32_t ms)
+{
+	return (uint32_t)(((uint64_t)ms * sys_clock_hw_cycles_per_sec()) /
+			  MSEC_PER_SEC);
+}
+
+static void busy_thread(void *p1, void *p2, void *p3)
+{
+	k_busy_wait((uint32_t)(uintptr_t)p1 * USEC_PER_MSEC);
+}
+
+static void busy_thread_start(size_t idx, uint32_t busy_ms)
+{
+	k_thread_create(&threads[idx], stacks[idx], STACK_SIZE, busy_thread,
+			(void *)(uintptr_t)busy_ms, NULL, NULL, PRIORITY, 0,
+			K_NO_WAIT);
+}
+
+static const struct cpu_load_ctx_stat *stat_find(size_t count,
+						 enum cpu_load_ctx_type type,
+						 const struct k_thread *thread)
+{
+	for (size_t i = 0; i < count; i++) {
+		if ((stats[i].type == type) &&
+		    ((type != CPU_LOAD_CTX_THREAD) ||
+		     (stats[i].thread == thread))) {
+			return &stats[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void check_cycles(const struct cpu_load_ctx_stat *stat, uint32_t ms)
+{
+	uint32_t expected = ms_to_cycles(ms);
+
+	zassert_not_null(stat, "Context not found");
+	zassert_true(stat->cycles >= expected, "%u cycles", stat->cycles);
+	zassert_true(stat->cycles <= expected + expected / 10, "%u cycles",
+		     stat->cycles);
+}
+
+static void check_total(size_t count)
+{
+	uint32_t load = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		load += stats[i].load;
+	}
+
+	/* Loads are rounded down. */
+	zassert_true(load <= 100000, "Total load %u", load);
+	zassert_true(load > 100000 - count, "Total load %u", load);
+}
+
+static void test_busy_threads(void)
+{
+	const struct cpu_load_ctx_stat *a;
+	const struct cpu_load_ctx_stat *b;
+	size_t count;
+
+	cpu_load_threads_reset();
+
+	busy_thread_start(0, 20);
+	busy_thread_start(1, 60);
+	k_sleep(K_MSEC(200));
+
+	count = cpu_load_threads_get(stats, ARRAY_SIZE(stats));
+	check_total(count);
+
+	a = stat_find(count, CPU_LOAD_CTX_THREAD, &threads[0]);
+	b = stat_find(count, CPU_LOAD_CTX_THREAD, &threads[1]);
+	check_cycles(a, 20);
+	check_cycles(b, 60);
+	zassert_true(b < a, "Entries not sorted by load");
+
+	/* The rest of the time is spent sleeping in the idle thread. */
+	zassert_true(stats[0].load >= 50000, "Load %u", stats[0].load);
+	zassert_equal(stats[0].type, CPU_LOAD_CTX_THREAD, NULL);
+	zassert_equal(stats[0].thread->base.prio, K_IDLE_PRIO, NULL);
+
+	/* Only the top entries are returned. */
+	count = cpu_load_threads_get(stats, 2);
+	zassert_equal(count, 2, NULL);
+	zassert_equal(stats[1].thread, &threads[1], NULL);
+}
+
+static void test_isr(void)
+{
+	const struct cpu_load_ctx_stat *isr;
+	const struct cpu_load_ctx_stat *self;
+	size_t count;
+
+	cpu_load_threads_reset();
+
+	sys_trace_isr_enter_user(0);
+	k_busy_wait(10 * USEC_PER_MSEC);
+	sys_trace_isr_exit_user(0);
+
+	count = cpu_load_threads_get(stats, ARRAY_SIZE(stats));
+	check_total(count);
+
+	isr = stat_find(count, CPU_LOAD_CTX_ISR, NULL);
+	self = stat_find(count, CPU_LOAD_CTX_THREAD, k_current_get());
+
+	check_cycles(isr, 10);
+	zassert_not_null(self, "Thread not found");
+	zassert_true(self->cycles < ms_to_cycles(1), "%u cycles",
+		     self->cycles);
+}
+
+static void test_isr_in_switch_hook(void)
+{
+	const struct cpu_load_ctx_stat *isr;
+	uint32_t cycles = 0;
+	uint32_t elapsed;
+	uint32_t start;
+	size_t count;
+
+	IRQ_CONNECT(TEST_IRQ, 0, test_isr_handler, NULL, 0);
+	irq_enable(TEST_IRQ);
+
+	start = k_cycle_get_32();
+	cpu_load_threads_reset();
+
+	isr_armed = true;
+	sys_trace_thread_switched_out_user(k_current_get());
+	sys_trace_thread_switched_in_user(k_current_get());
+
+	count = cpu_load_threads_get(stats, ARRAY_SIZE(stats));
+	elapsed = k_cycle_get_32() - start;
+
+	irq_disable(TEST_IRQ);
+	zassert_false(isr_armed, "Interrupt not raised");
+	check_total(count);
+
+	/* The time is charged once, to the ISR and to this thread. */
+	isr = stat_find(count, CPU_LOAD_CTX_ISR, NULL);
+	check_cycles(isr, TEST_ISR_BUSY_MS);
+
+	for (size_t i = 0; i < count; i++) {
+		cycles += stats[i].cycles;
+	}
+	zassert_true(cycles <= elapsed, "%u cycles in %u", cycles, elapsed);
+}
+
+static void test_window(void)
+{
+	size_t count;
+
+	cpu_load_threads_reset();
+
+	busy_thread_start(0, 20);
+	k_sleep(K_MSEC(50));
+
+	count = cpu_load_threads_get(stats, ARRAY_SIZE(stats));
+	zassert_not_null(stat_find(count, CPU_LOAD_CTX_THREAD, &threads[0]),
+			 "Thread not found");
+
+	/* The thread has not run during the whole window. */
+	k_sleep(K_MSEC(2 * CONFIG_CPU_LOAD_THREADS_WINDOW_MS));
+
+	count = cpu_load_threads_get(stats, ARRAY_SIZE(stats));
+	check_total(count);
+	zassert_is_null(stat_find(count, CPU_LOAD_CTX_THREAD, &threads[0]),
+			"Thread still measured");
+}
+
+static void test_table_full(void)
+{
+	const struct cpu_load_ctx_stat *other;
+	uint32_t cycles = 0;
+	size_t count;
+
+	cpu_load_threads_reset();
+
+	for (size_t i = 0; i < NUM_THREADS; i++) {
+		busy_thread_start(i, 10);
+	}
+	k_sleep(K_MSEC(100));
+
+	count = cpu_load_threads_get(stats, ARRAY_SIZE(stats));
+	check_total(count);
+
+	/* The threads that did not fit in the table are reported together,
+	 * and no time is lost.
+	 */
+	other = stat_find(count, CPU_LOAD_CTX_OTHER, NULL);
+	zassert_not_null(other, "No other entry");
+	zassert_true(other->cycles >= ms_to_cycles(10), "%u cycles",
+		     other->cycles);
+
+	for (size_t i = 0; i < count; i++) {
+		cycles += stats[i].cycles;
+	}
+	zassert_true(cycles >= ms_to_cycles(100), "%u cycles", cycles);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cpu_load_threads,
+			 ztest_unit_test(test_busy_threads),
+			 ztest_unit_test(test_isr),
+			 ztest_unit_test(test_isr_in_switch_hook),
+			 ztest_unit_test(test_window),
+			 ztest_unit_test(test_table_full)
+	);
+	ztest_run_test_suite(cpu_load_threads);
+}
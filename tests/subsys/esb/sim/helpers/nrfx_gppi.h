@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* PPI channels of the simulated radio. */
+#ifndef NRFX_GPPI_SIM_H_
+#define NRFX_GPPI_SIM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void nrfx_gppi_channels_enable(uint32_t mask);
+void nrfx_gppi_channels_disable(uint32_t mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRFX_GPPI_SIM_H_ */
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Registers of the simulated radio, timer and PPI used by the ESB library
+ * on native_posix. Only the registers and fields used by ESB are present.
+ */
+#ifndef NRF_SIM_H_
+#define NRF_SIM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	RADIO_IRQn = 8,
+	TIMER0_IRQn = 9,
+	TIMER1_IRQn = 10,
+	TIMER2_IRQn = 11,
+	TIMER3_IRQn = 12,
+	TIMER4_IRQn = 13,
+	SWI0_IRQn = 14,
+	EGU0_IRQn = 15,
+} IRQn_Type;
+
+typedef struct {
+	volatile uint32_t TASKS_TXEN;
+	volatile uint32_t TASKS_RXEN;
+	volatile uint32_t TASKS_START;
+	volatile uint32_t TASKS_STOP;
+	volatile uint32_t TASKS_DISABLE;
+	volatile uint32_t EVENTS_READY;
+	volatile uint32_t EVENTS_ADDRESS;
+	volatile uint32_t EVENTS_PAYLOAD;
+	volatile uint32_t EVENTS_END;
+	volatile uint32_t EVENTS_DISABLED;
+	volatile uint32_t SHORTS;
+	volatile uint32_t INTENSET;
+	volatile uint32_t INTENCLR;
+	volatile uint32_t CRCSTATUS;
+	volatile uint32_t RXMATCH;
+	volatile uint32_t RXCRC;
+	volatile uint32_t PACKETPTR;
+	volatile uint32_t FREQUENCY;
+	volatile uint32_t TXPOWER;
+	volatile uint32_t MODE;
+	volatile uint32_t PCNF0;
+	volatile uint32_t PCNF1;
+	volatile uint32_t BASE0;
+	volatile uint32_t BASE1;
+	volatile uint32_t PREFIX0;
+	volatile uint32_t PREFIX1;
+	volatile uint32_t TXADDRESS;
+	volatile uint32_t RXADDRESSES;
+	volatile uint32_t CRCCNF;
+	volatile uint32_t CRCPOLY;
+	volatile uint32_t CRCINIT;
+	volatile uint32_t RSSISAMPLE;
+} NRF_RADIO_Type;
+
+typedef struct {
+	volatile uint32_t TASKS_START;
+	volatile uint32_t TASKS_STOP;
+	volatile uint32_t TASKS_CLEAR;
+	volatile uint32_t TASKS_SHUTDOWN;
+	volatile uint32_t EVENTS_COMPARE[4];
+	volatile uint32_t SHORTS;
+	volatile uint32_t MODE;
+	volatile uint32_t BITMODE;
+	volatile uint32_t PRESCALER;
+	volatile uint32_t CC[4];
+} NRF_TIMER_Type;
+
+extern NRF_RADIO_Type radio_sim_radio;
+extern NRF_TIMER_Type radio_sim_timer;
+
+#define NRF_RADIO (&radio_sim_radio)
+#define NRF_TIMER0 (&radio_sim_timer)
+#define NRF_TIMER1 (&radio_sim_timer)
+#define NRF_TIMER2 (&radio_sim_timer)
+#define NRF_TIMER3 (&radio_sim_timer)
+#define NRF_TIMER4 (&radio_sim_timer)
+
+#define RADIO_SHORTS_READY_START_Pos 0
+#define RADIO_SHORTS_READY_START_Msk (1UL << RADIO_SHORTS_READY_START_Pos)
+#define RADIO_SHORTS_READY_START_Enabled 1
+#define RADIO_SHORTS_END_DISABLE_Pos 1
+#define RADIO_SHORTS_END_DISABLE_Msk (1UL << RADIO_SHORTS_END_DISABLE_Pos)
+#define RADIO_SHORTS_END_DISABLE_Enabled 1
+#define RADIO_SHORTS_DISABLED_TXEN_Msk (1UL << 2)
+#define RADIO_SHORTS_DISABLED_RXEN_Msk (1UL << 3)
+#define RADIO_SHORTS_ADDRESS_RSSISTART_Msk (1UL << 4)
+#define RADIO_SHORTS_DISABLED_RSSISTOP_Msk (1UL << 8)
+
+#define RADIO_INTENSET_READY_Msk (1UL << 0)
+#define RADIO_INTENSET_ADDRESS_Msk (1UL << 1)
+#define RADIO_INTENSET_PAYLOAD_Msk (1UL << 2)
+#define RADIO_INTENSET_END_Msk (1UL << 3)
+#define RADIO_INTENSET_DISABLED_Msk (1UL << 4)
+
+#define RADIO_MODE_MODE_Pos 0
+#define RADIO_MODE_MODE_Nrf_1Mbit 0
+#define RADIO_MODE_MODE_Nrf_2Mbit 1
+#define RADIO_MODE_MODE_Nrf_250Kbit 2
+#define RADIO_MODE_MODE_Ble_1Mbit 3
+
+#define RADIO_CRCCNF_LEN_Pos 0
+#define RADIO_CRCCNF_LEN_Disabled 0
+#define RADIO_CRCCNF_LEN_One 1
+#define RADIO_CRCCNF_LEN_Two 2
+
+#define RADIO_TXPOWER_TXPOWER_Pos 0
+#define RADIO_TXPOWER_TXPOWER_Pos4dBm 0x04
+#define RADIO_TXPOWER_TXPOWER_0dBm 0x00
+#define RADIO_TXPOWER_TXPOWER_Neg4dBm 0xFC
+#define RADIO_TXPOWER_TXPOWER_Neg8dBm 0xF8
+#define RADIO_TXPOWER_TXPOWER_Neg12dBm 0xF4
+#define RADIO_TXPOWER_TXPOWER_Neg16dBm 0xF0
+#define RADIO_TXPOWER_TXPOWER_Neg20dBm 0xEC
+#define RADIO_TXPOWER_TXPOWER_Neg30dBm 0xE2
+#define RADIO_TXPOWER_TXPOWER_Neg40dBm 0xD8
+
+#define RADIO_PCNF0_LFLEN_Pos 0
+#define RADIO_PCNF0_S0LEN_Pos 8
+#define RADIO_PCNF0_S1LEN_Pos 16
+
+#define RADIO_PCNF1_MAXLEN_Pos 0
+#define RADIO_PCNF1_STATLEN_Pos 8
+#define RADIO_PCNF1_BALEN_Pos 16
+#define RADIO_PCNF1_ENDIAN_Pos 24
+#define RADIO_PCNF1_ENDIAN_Big 1
+#define RADIO_PCNF1_WHITEEN_Pos 25
+#define RADIO_PCNF1_WHITEEN_Disabled 0
+
+#define TIMER_BITMODE_BITMODE_16Bit 0
+#define TIMER_SHORTS_COMPARE1_CLEAR_Msk (1UL << 1)
+#define TIMER_SHORTS_COMPARE1_STOP_Msk (1UL << 9)
+
+#define __ALIGN(n) __attribute__((aligned(n)))
+
+static inline uint32_t __REV(uint32_t value)
+{
+	return __builtin_bswap32(value);
+}
+
+void posix_sw_set_pending_IRQ(unsigned int IRQn);
+void posix_sw_clear_pending_IRQ(unsigned int IRQn);
+
+static inline void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+	posix_sw_set_pending_IRQ(irq);
+}
+
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+	posix_sw_clear_pending_IRQ(irq);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRF_SIM_H_ */
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* PPI channels of the simulated radio. */
+#ifndef NRFX_PPI_SIM_H_
+#define NRFX_PPI_SIM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int nrfx_err_t;
+typedef uint8_t nrf_ppi_channel_t;
+
+#define NRFX_SUCCESS 0
+
+nrfx_err_t nrfx_ppi_channel_alloc(nrf_ppi_channel_t *p_channel);
+nrfx_err_t nrfx_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep,
+				   uint32_t tep);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NRFX_PPI_SIM_H_ */
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <ztest.h>
+#include <sys/byteorder.h>
+#include <esb.h>
+
+#include "radio_sim.h"
+
+#define PAYLOAD_LEN		32
+#define ISR_LATENCY_US		20
+/* Interrupt latency longer than the radio ramp-up. */
+#define ISR_LATENCY_LONG_US	(2 * RADIO_SIM_RAMP_UP_US)
+#define RETRANSMIT_CNT		3
+#define RUN_TIME_MAX_US		(60 * USEC_PER_SEC)
+#define BENCHMARK_CNT		5000
+
+static uint32_t tx_seq;
+static uint32_t tx_total;
+static uint32_t tx_success_cnt;
+static uint32_t tx_failed_cnt;
+static uint32_t rx_seq;
+static uint32_t rx_cnt;
+static uint32_t rx_order_err;
+
+static int payload_write(uint8_t pipe)
+{
+	struct esb_payload payload = {
+		.pipe = pipe,
+		.length = PAYLOAD_LEN,
+	};
+	int err;
+
+	sys_put_le32(tx_seq, payload.data);
+
+	err = esb_write_payload(&payload);
+	if (!err) {
+		tx_seq++;
+	}
+
+	return err;
+}
+
+/* Keep the TX FIFO full until all payloads are written. */
+static void tx_fifo_fill(void)
+{
+	while ((tx_seq < tx_total) && !payload_write(0)) {
+	}
+}
+
+static void event_handler(const struct esb_evt *event)
+{
+	switch (event->evt_id) {
+	case ESB_EVENT_TX_SUCCESS:
+		tx_success_cnt++;
+		break;
+	case ESB_EVENT_TX_FAILED:
+		tx_failed_cnt++;
+		break;
+	default:
+		return;
+	}
+
+	tx_fifo_fill();
+}
+
+static void rx_cb(uint8_t pipe, const uint8_t *data, uint8_t len)
+{
+	uint32_t seq = sys_get_le32(data);
+
+	if ((seq != rx_seq) || (len != PAYLOAD_LEN)) {
+		rx_order_err++;
+	}
+
+	rx_seq = seq + 1;
+	rx_cnt++;
+}
+
+static void esb_sim_init(const struct radio_sim_cfg *cfg,
+			 enum esb_tx_mode tx_mode)
+{
+	struct esb_config config = ESB_DEFAULT_CONFIG;
+	int err;
+
+	radio_sim_reset(cfg);
+
+	config.event_handler = event_handler;
+	config.retransmit_count = RETRANSMIT_CNT;
+	config.tx_mode = tx_mode;
+
+	err = esb_init(&config);
+	zassert_equal(err, 0, "Failed to initialize ESB");
+}
+
+static void test_setup(void)
+{
+	const struct radio_sim_cfg cfg = {
+		.isr_latency_us = ISR_LATENCY_US,
+		.rx_cb = rx_cb,
+	};
+
+	tx_seq = 0;
+	tx_total = 0;
+	tx_success_cnt = 0;
+	tx_failed_cnt = 0;
+	rx_seq = 0;
+	rx_cnt = 0;
+	rx_order_err = 0;
+
+	esb_sim_init(&cfg, ESB_TXMODE_AUTO);
+}
+
+static void test_esb_tx_fifo(void)
+{
+	uint32_t cnt = 0;
+	int err;
+
+	/* The payloads are not sent until the simulation runs. */
+	for (size_t i = 0; i < CONFIG_ESB_TX_FIFO_SIZE; i++) {
+		err = payload_write(0);
+		zassert_equal(err, 0, "Failed to write payload %u",
+			      (unsigned int)i);
+	}
+
+	err = payload_write(0);
+	zassert_equal(err, -ENOMEM, "Payload written to a full FIFO");
+
+	radio_sim_run(RUN_TIME_MAX_US);
+	cnt += CONFIG_ESB_TX_FIFO_SIZE;
+
+	zassert_true(esb_is_idle(), "ESB not idle");
+	zassert_equal(rx_cnt, cnt, "Wrong number of received payloads");
+
+	/* Let the front and back of the FIFO wrap around. */
+	for (size_t round = 0; round < 4; round++) {
+		for (size_t i = 0; i < (CONFIG_ESB_TX_FIFO_SIZE / 2 + 1); i++) {
+			err = payload_write(0);
+			zassert_equal(err, 0, "Failed to write payload");
+			cnt++;
+		}
+
+		radio_sim_run(RUN_TIME_MAX_US);
+		zassert_equal(rx_cnt, cnt, "Wrong number of received payloads");
+	}
+
+	zassert_equal(tx_success_cnt, cnt, "Wrong number of TX successes");
+	zassert_equal(rx_order_err, 0, "Payloads received out of order");
+
+	err = esb_pop_tx();
+	zassert_equal(err, -ENODATA, "Payload left in the FIFO");
+}
+
+static void test_esb_tx_fifo_pop_flush(void)
+{
+	const struct radio_sim_cfg cfg = {
+		.isr_latency_us = ISR_LATENCY_US,
+		.rx_cb = rx_cb,
+	};
+	int err;
+
+	esb_sim_init(&cfg, ESB_TXMODE_MANUAL);
+
+	for (size_t i = 0; i < 4; i++) {
+		err = payload_write(0);
+		zassert_equal(err, 0, "Failed to write payload");
+	}
+
+	/* Drop the first payload. */
+	err = esb_pop_tx();
+	zassert_equal(err, 0, "Failed to pop payload");
+	rx_seq = 1;
+
+	for (size_t i = 0; i < 2; i++) {
+		err = esb_start_tx();
+		zassert_equal(err, 0, "Failed to start TX");
+
+		radio_sim_run(RUN_TIME_MAX_US);
+		zassert_equal(rx_cnt, i + 1, "Wrong number of received payloads");
+	}
+
+	zassert_equal(rx_seq, 3, "Wrong payload received");
+	zassert_equal(rx_order_err, 0, "Payloads received out of order");
+
+	err = esb_flush_tx();
+	zassert_equal(err, 0, "Failed to flush the FIFO");
+
+	err = esb_start_tx();
+	zassert_equal(err, -ENODATA, "TX started with an empty FIFO");
+
+	/* The FIFO is usable after the flush. */
+	err = payload_write(0);
+	zassert_equal(err, 0, "Failed to write payload");
+	rx_seq = 4;
+
+	err = esb_start_tx();
+	zassert_equal(err, 0, "Failed to start TX");
+
+	radio_sim_run(RUN_TIME_MAX_US);
+	zassert_equal(rx_cnt, 3, "Wrong number of received payloads");
+	zassert_equal(rx_order_err, 0, "Payloads received out of order");
+}
+
+static void test_esb_retransmit(void)
+{
+	const struct radio_sim_cfg cfg = {
+		.isr_latency_us = ISR_LATENCY_US,
+		.tx_loss_period = 5,
+		.ack_loss_period = 3,
+		.rx_cb = rx_cb,
+	};
+	struct radio_sim_stats sim_stats;
+	struct esb_pipe_stats stats;
+	int err;
+
+	esb_sim_init(&cfg, ESB_TXMODE_AUTO);
+
+	tx_total = 200;
+	tx_fifo_fill();
+	radio_sim_run(RUN_TIME_MAX_US);
+
+	radio_sim_stats_get(&sim_stats);
+
+	err = esb_pipe_stats_get(0, &stats);
+	zassert_equal(err, 0, "Failed to get pipe statistics");
+
+	zassert_true(esb_is_idle(), "ESB not idle");
+	zassert_equal(tx_failed_cnt, 0, "Unexpected TX failure");
+	zassert_equal(tx_success_cnt, tx_total, "Wrong number of TX successes");
+	zassert_equal(rx_cnt, tx_total, "Wrong number of received payloads");
+	zassert_equal(rx_order_err, 0, "Payloads received out of order");
+	zassert_true(sim_stats.tx_lost > 0, "No packet lost");
+	zassert_true(sim_stats.rx_duplicates > 0, "No acknowledgment lost");
+	zassert_equal(sim_stats.tx_missed, 0, "Packet sent to a busy PRX");
+
+	zassert_equal(stats.tx_success, tx_total, "Wrong TX success count");
+	zassert_equal(stats.tx_bytes, tx_total * PAYLOAD_LEN,
+		      "Wrong TX byte count");
+	zassert_equal(stats.retransmits, sim_stats.tx_packets - tx_total,
+		      "Wrong retransmit count");
+}
+
+static void test_esb_tx_failed(void)
+{
+	const struct radio_sim_cfg cfg = {
+		.isr_latency_us = ISR_LATENCY_US,
+		.tx_loss_period = 1,
+		.rx_cb = rx_cb,
+	};
+	struct radio_sim_stats sim_stats;
+	struct esb_pipe_stats stats;
+	int err;
+
+	esb_sim_init(&cfg, ESB_TXMODE_AUTO);
+
+	tx_total = 3;
+	tx_fifo_fill();
+	radio_sim_run(RUN_TIME_MAX_US);
+
+	radio_sim_stats_get(&sim_stats);
+	esb_pipe_stats_get(0, &stats);
+
+	zassert_true(esb_is_idle(), "ESB not idle");
+	zassert_equal(rx_cnt, 0, "Payload received");
+
+	if (IS_ENABLED(CONFIG_ESB_TX_BURST)) {
+		/* The failed payloads are dropped. */
+		zassert_equal(tx_failed_cnt, tx_total,
+			      "Wrong number of TX failures");
+		zassert_equal(stats.tx_failed, tx_total,
+			      "Wrong TX failure count");
+
+		err = esb_pop_tx();
+		zassert_equal(err, -ENODATA, "Payload left in the FIFO");
+	} else {
+		/* The transmission stops at the first failed payload. */
+		zassert_equal(tx_failed_cnt, 1, "Wrong number of TX failures");
+		zassert_equal(stats.tx_failed, 1, "Wrong TX failure count");
+
+		err = esb_pop_tx();
+		zassert_equal(err, 0, "Failed payload not in the FIFO");
+	}
+
+	zassert_equal(sim_stats.tx_packets,
+		      stats.tx_failed * (RETRANSMIT_CNT + 1),
+		      "Wrong number of transmitted packets");
+	zassert_equal(stats.retransmits, stats.tx_failed * RETRANSMIT_CNT,
+		      "Wrong retransmit count");
+}
+
+static void test_esb_pipe_stats(void)
+{
+	struct esb_pipe_stats stats;
+	int err;
+
+	for (uint8_t pipe = 0; pipe < 3; pipe++) {
+		for (size_t i = 0; i <= pipe; i++) {
+			err = payload_write(pipe);
+			zassert_equal(err, 0, "Failed to write payload");
+		}
+	}
+
+	radio_sim_run(RUN_TIME_MAX_US);
+
+	for (uint8_t pipe = 0; pipe < 3; pipe++) {
+		err = esb_pipe_stats_get(pipe, &stats);
+		zassert_equal(err, 0, "Failed to get pipe statistics");
+
+		zassert_equal(stats.tx_success, pipe + 1,
+			      "Wrong TX success count");
+		zassert_equal(stats.tx_bytes, (pipe + 1) * PAYLOAD_LEN,
+			      "Wrong TX byte count");
+		zassert_equal(stats.tx_failed, 0, "Wrong TX failure count");
+		zassert_equal(stats.retransmits, 0, "Wrong retransmit count");
+		zassert_equal(stats.rx_packets, 0, "Wrong RX packet count");
+	}
+
+	err = esb_pipe_stats_get(CONFIG_ESB_PIPE_COUNT, &stats);
+	zassert_equal(err, -EINVAL, "Invalid pipe accepted");
+
+	err = esb_pipe_stats_get(0, NULL);
+	zassert_equal(err, -EINVAL, "NULL statistics accepted");
+
+	esb_pipe_stats_reset();
+
+	err = esb_pipe_stats_get(2, &stats);
+	zassert_equal(err, 0, "Failed to get pipe statistics");
+	zassert_equal(stats.tx_success, 0, "Statistics not reset");
+	zassert_equal(stats.tx_bytes, 0, "Statistics not reset");
+}
+
+static void test_esb_isr_latency(void)
+{
+	const struct radio_sim_cfg cfg = {
+		.isr_latency_us = ISR_LATENCY_LONG_US,
+		.ack_loss_period = 4,
+		.rx_cb = rx_cb,
+	};
+	struct radio_sim_stats sim_stats;
+
+	esb_sim_init(&cfg, ESB_TXMODE_AUTO);
+
+	tx_total = 200;
+	tx_fifo_fill();
+	radio_sim_run(RUN_TIME_MAX_US);
+
+	radio_sim_stats_get(&sim_stats);
+
+	/* Every packet must be sent from the radio buffer of its payload,
+	 * even if the radio interrupt is handled after the radio ramp-up.
+	 */
+	zassert_true(esb_is_idle(), "ESB not idle");
+	zassert_equal(tx_failed_cnt, 0, "Unexpected TX failure");
+	zassert_equal(tx_success_cnt, tx_total, "Wrong number of TX successes");
+	zassert_equal(rx_cnt, tx_total, "Wrong number of received payloads");
+	zassert_equal(rx_order_err, 0, "Payloads received out of order");
+	zassert_true(sim_stats.rx_duplicates > 0, "No acknowledgment lost");
+	zassert_equal(sim_stats.tx_missed, 0, "Packet sent to a busy PRX");
+}
+
+static void test_esb_benchmark(void)
+{
+	struct radio_sim_stats sim_stats;
+	struct esb_pipe_stats stats;
+	uint32_t start;
+	uint32_t time;
+	uint32_t gap;
+
+	tx_total = BENCHMARK_CNT;
+
+	start = radio_sim_time_us();
+	tx_fifo_fill();
+	time = radio_sim_run(RUN_TIME_MAX_US) - start;
+
+	radio_sim_stats_get(&sim_stats);
+	esb_pipe_stats_get(0, &stats);
+
+	zassert_equal(rx_cnt, tx_total, "Wrong number of received payloads");
+	zassert_equal(rx_order_err, 0, "Payloads received out of order");
+	zassert_equal(sim_stats.tx_missed, 0, "Packet sent to a busy PRX");
+
+	TC_PRINT("%u payloads of %u bytes in %u us of simulated time\n",
+		 (unsigned int)tx_total, PAYLOAD_LEN, (unsigned int)time);
+	TC_PRINT("Throughput: %u kbit/s, ACK to next TX: %u-%u us\n",
+		 (unsigned int)(((uint64_t)stats.tx_bytes * 8 * 1000) / time),
+		 (unsigned int)sim_stats.ack_to_tx_min_us,
+		 (unsigned int)sim_stats.ack_to_tx_max_us);
+
+	/* The ramp-up for the next payload starts in the radio interrupt
+	 * handler.
+	 */
+	gap = RADIO_SIM_DISABLE_US + ISR_LATENCY_US + RADIO_SIM_RAMP_UP_US;
+
+	zassert_equal(sim_stats.ack_to_tx_min_us, gap, "Wrong TX gap");
+	zassert_equal(sim_stats.ack_to_tx_max_us, gap, "Wrong TX gap");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(
+		test_esb,
+		ztest_unit_test_setup_teardown(test_esb_tx_fifo, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_esb_tx_fifo_pop_flush, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_esb_retransmit, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_esb_tx_failed, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_esb_pipe_stats, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_esb_isr_latency, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_esb_benchmark, test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(test_esb);
+}
@@ -0,0 +1,588 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Simulated radio, system timer and PPI for the ESB library on native_posix.
+ *
+ * The simulation runs in virtual time. It reacts to the tasks written by the
+ * library, generates the radio and timer events with their shortcuts and PPI
+ * connections, and raises the radio interrupt. The other side of the link is
+ * a PRX that acknowledges the received packets with the timing of the ESB
+ * PRX implementation.
+ */
+#include <string.h>
+#include <sys/util.h>
+#include <nrf.h>
+#include <nrfx_ppi.h>
+#include <helpers/nrfx_gppi.h>
+
+#include "radio_sim.h"
+
+#define PPI_CH_CNT	32
+#define PIPE_CNT	8
+#define TIMER_CC_CNT	2
+
+NRF_RADIO_Type radio_sim_radio;
+NRF_TIMER_Type radio_sim_timer;
+
+enum radio_state {
+	RADIO_DISABLED,
+	RADIO_RXRU,
+	RADIO_RXIDLE,
+	RADIO_RX,
+	RADIO_TXRU,
+	RADIO_TXIDLE,
+	RADIO_TX,
+	RADIO_DISABLING,
+};
+
+enum radio_evt {
+	RADIO_EVT_NONE,
+	RADIO_EVT_READY,
+	RADIO_EVT_ADDRESS,
+	RADIO_EVT_END,
+	RADIO_EVT_DISABLED,
+};
+
+struct packet {
+	uint8_t pipe;
+	uint8_t len;
+	uint8_t hdr[2];
+	uint8_t data[UINT8_MAX];
+};
+
+static struct {
+	struct radio_sim_cfg cfg;
+	struct radio_sim_stats stats;
+	uint32_t now;
+
+	enum radio_state state;
+	enum radio_evt evt;
+	uint32_t evt_time;
+	uint32_t tx_start;
+	struct packet air;
+	bool ack_end_valid;
+	uint32_t ack_end_time;
+
+	bool irq_pending;
+	uint32_t irq_time;
+
+	bool timer_running;
+	uint32_t timer_start;
+	uint32_t timer_base;
+	uint8_t timer_fired;
+
+	uint32_t ppi_eep[PPI_CH_CNT];
+	uint32_t ppi_tep[PPI_CH_CNT];
+	uint32_t ppi_enabled;
+	uint8_t ppi_cnt;
+
+	/* Simulated PRX. */
+	uint32_t prx_ready;
+	uint32_t prx_ack_cnt;
+	bool ack_pending;
+	uint32_t ack_start;
+	uint32_t ack_addr;
+	uint32_t ack_end;
+	uint8_t ack_pipe;
+	uint8_t ack_pid;
+	bool last_valid[PIPE_CNT];
+	struct packet last[PIPE_CNT];
+} sim;
+
+static bool period_hit(uint32_t period, uint32_t cnt)
+{
+	return (period != 0) && ((cnt % period) == 0);
+}
+
+static uint32_t bits_to_us(uint32_t bits)
+{
+	switch (NRF_RADIO->MODE) {
+	case RADIO_MODE_MODE_Nrf_2Mbit:
+		return bits / 2;
+	case RADIO_MODE_MODE_Nrf_250Kbit:
+		return bits * 4;
+	default:
+		return bits;
+	}
+}
+
+static bool format_dpl(void)
+{
+	return ((NRF_RADIO->PCNF0 >> RADIO_PCNF0_LFLEN_Pos) & 0xF) != 0;
+}
+
+/* Time from the start of a packet to its ADDRESS event. */
+static uint32_t address_time(void)
+{
+	uint32_t balen = (NRF_RADIO->PCNF1 >> RADIO_PCNF1_BALEN_Pos) & 0x7;
+
+	/* Preamble, base address and prefix. */
+	return bits_to_us(8 * (1 + balen + 1));
+}
+
+static uint32_t packet_time(uint8_t len)
+{
+	uint32_t lflen = (NRF_RADIO->PCNF0 >> RADIO_PCNF0_LFLEN_Pos) & 0xF;
+	uint32_t s0len = (NRF_RADIO->PCNF0 >> RADIO_PCNF0_S0LEN_Pos) & 0x1;
+	uint32_t s1len = (NRF_RADIO->PCNF0 >> RADIO_PCNF0_S1LEN_Pos) & 0xF;
+	uint32_t crclen = (NRF_RADIO->CRCCNF >> RADIO_CRCCNF_LEN_Pos) & 0x3;
+
+	return address_time() +
+	       bits_to_us(8 * s0len + lflen + s1len + 8 * (len + crclen));
+}
+
+static void packet_read(struct packet *pkt)
+{
+	const uint8_t *buf = (const uint8_t *)(uintptr_t)NRF_RADIO->PACKETPTR;
+
+	pkt->pipe = NRF_RADIO->TXADDRESS;
+	pkt->hdr[0] = buf[0];
+	pkt->hdr[1] = buf[1];
+
+	if (format_dpl()) {
+		pkt->len = buf[0];
+	} else {
+		pkt->len = (NRF_RADIO->PCNF1 >> RADIO_PCNF1_STATLEN_Pos) & 0xFF;
+	}
+
+	memcpy(pkt->data, &buf[2], pkt->len);
+}
+
+static void radio_evt_set(enum radio_evt evt, uint32_t time)
+{
+	sim.evt = evt;
+	sim.evt_time = time;
+}
+
+static void event_raise(volatile uint32_t *event, uint32_t int_msk)
+{
+	*event = 1;
+
+	for (size_t ch = 0; ch < sim.ppi_cnt; ch++) {
+		if ((sim.ppi_enabled & BIT(ch)) &&
+		    (sim.ppi_eep[ch] == (uint32_t)(uintptr_t)event)) {
+			*(volatile uint32_t *)(uintptr_t)sim.ppi_tep[ch] = 1;
+		}
+	}
+
+	if ((NRF_RADIO->INTENSET & int_msk) && !sim.irq_pending) {
+		sim.irq_pending = true;
+		sim.irq_time = sim.now + sim.cfg.isr_latency_us;
+	}
+}
+
+static uint32_t timer_counter(void)
+{
+	if (!sim.timer_running) {
+		return sim.timer_base;
+	}
+
+	return sim.timer_base + (sim.now - sim.timer_start);
+}
+
+static bool timer_compare_time(size_t i, uint32_t *time)
+{
+	uint32_t cc = radio_sim_timer.CC[i];
+
+	if (!sim.timer_running || (sim.timer_fired & BIT(i)) ||
+	    (cc < sim.timer_base)) {
+		return false;
+	}
+
+	*time = sim.timer_start + (cc - sim.timer_base);
+
+	return *time >= sim.now;
+}
+
+static void timer_compare(size_t i)
+{
+	sim.timer_fired |= BIT(i);
+	event_raise(&radio_sim_timer.EVENTS_COMPARE[i], 0);
+
+	if (i != 1) {
+		return;
+	}
+
+	if (radio_sim_timer.SHORTS & TIMER_SHORTS_COMPARE1_CLEAR_Msk) {
+		sim.timer_base = 0;
+		sim.timer_start = sim.now;
+		sim.timer_fired = 0;
+	}
+
+	if (radio_sim_timer.SHORTS & TIMER_SHORTS_COMPARE1_STOP_Msk) {
+		sim.timer_base = timer_counter();
+		sim.timer_running = false;
+	}
+}
+
+static void prx_receive(void)
+{
+	const struct packet *pkt = &sim.air;
+	struct packet *last = &sim.last[pkt->pipe];
+	bool dpl = format_dpl();
+	uint8_t pid = dpl ? (pkt->hdr[1] >> 1) : pkt->hdr[0];
+	bool ack = !sim.cfg.selective_auto_ack || !dpl || (pkt->hdr[1] & 0x01);
+
+	if (sim.tx_start < sim.prx_ready) {
+		sim.stats.tx_missed++;
+		return;
+	}
+
+	if (period_hit(sim.cfg.tx_loss_period, sim.stats.tx_packets)) {
+		sim.stats.tx_lost++;
+		return;
+	}
+
+	if (sim.last_valid[pkt->pipe] && (last->hdr[1] == pkt->hdr[1]) &&
+	    (last->hdr[0] == pkt->hdr[0]) && (last->len == pkt->len) &&
+	    !memcmp(last->data, pkt->data, pkt->len)) {
+		sim.stats.rx_duplicates++;
+	} else {
+		*last = *pkt;
+		sim.last_valid[pkt->pipe] = true;
+
+		if (sim.cfg.rx_cb) {
+			sim.cfg.rx_cb(pkt->pipe, pkt->data, pkt->len);
+		}
+	}
+
+	if (!ack) {
+		/* The PRX switches back to RX in its interrupt handler. */
+		sim.prx_ready = sim.now + RADIO_SIM_DISABLE_US +
+				sim.cfg.isr_latency_us + RADIO_SIM_DISABLE_US +
+				RADIO_SIM_RAMP_UP_US;
+		return;
+	}
+
+	/* The acknowledgment is sent after the DISABLED to TXEN shortcut, and
+	 * the PRX is back in RX after the DISABLED to RXEN shortcut.
+	 */
+	sim.ack_start = sim.now + RADIO_SIM_DISABLE_US + RADIO_SIM_RAMP_UP_US;
+	sim.ack_addr = sim.ack_start + address_time();
+	sim.ack_end = sim.ack_start + packet_time(0);
+	sim.prx_ready = sim.ack_end + RADIO_SIM_DISABLE_US +
+			RADIO_SIM_RAMP_UP_US;
+
+	sim.prx_ack_cnt++;
+	if (!period_hit(sim.cfg.ack_loss_period, sim.prx_ack_cnt)) {
+		sim.ack_pending = true;
+		sim.ack_pipe = pkt->pipe;
+		sim.ack_pid = pid;
+	}
+}
+
+static void ack_receive(void)
+{
+	uint8_t *buf = (uint8_t *)(uintptr_t)NRF_RADIO->PACKETPTR;
+
+	if (format_dpl()) {
+		buf[0] = 0;
+		buf[1] = sim.ack_pid << 1;
+	} else {
+		buf[0] = sim.ack_pid;
+		buf[1] = 0;
+	}
+
+	NRF_RADIO->CRCSTATUS = 1;
+	NRF_RADIO->RXMATCH = sim.ack_pipe;
+	NRF_RADIO->RXCRC = sim.ack_pid;
+
+	sim.ack_pending = false;
+	sim.ack_end_valid = true;
+	sim.ack_end_time = sim.now;
+	sim.stats.acks++;
+}
+
+static void radio_start(void)
+{
+	if (sim.state == RADIO_TXIDLE) {
+		sim.state = RADIO_TX;
+		sim.tx_start = sim.now;
+		sim.stats.tx_packets++;
+		packet_read(&sim.air);
+
+		if (sim.ack_end_valid) {
+			uint32_t gap = sim.now - sim.ack_end_time;
+
+			sim.stats.ack_to_tx_min_us =
+				MIN(sim.stats.ack_to_tx_min_us, gap);
+			sim.stats.ack_to_tx_max_us =
+				MAX(sim.stats.ack_to_tx_max_us, gap);
+			sim.ack_end_valid = false;
+		}
+
+		radio_evt_set(RADIO_EVT_ADDRESS, sim.now + address_time());
+	} else if (sim.state == RADIO_RXIDLE) {
+		sim.state = RADIO_RX;
+		NRF_RADIO->CRCSTATUS = 0;
+
+		if (sim.ack_pending && (sim.ack_start >= sim.now)) {
+			radio_evt_set(RADIO_EVT_ADDRESS, sim.ack_addr);
+		} else {
+			/* Listen until the radio is disabled. */
+			sim.ack_pending = false;
+			radio_evt_set(RADIO_EVT_NONE, 0);
+		}
+	}
+}
+
+static void radio_disable(void)
+{
+	if (sim.state == RADIO_DISABLED || sim.state == RADIO_DISABLING) {
+		return;
+	}
+
+	/* An acknowledgment that is not received yet is lost. */
+	if (sim.state == RADIO_RX) {
+		sim.ack_pending = false;
+	}
+
+	sim.state = RADIO_DISABLING;
+	radio_evt_set(RADIO_EVT_DISABLED, sim.now + RADIO_SIM_DISABLE_US);
+}
+
+static void radio_evt_process(void)
+{
+	enum radio_evt evt = sim.evt;
+
+	radio_evt_set(RADIO_EVT_NONE, 0);
+
+	switch (evt) {
+	case RADIO_EVT_READY:
+		sim.state = (sim.state == RADIO_TXRU) ? RADIO_TXIDLE :
+							RADIO_RXIDLE;
+		event_raise(&NRF_RADIO->EVENTS_READY, RADIO_INTENSET_READY_Msk);
+
+		if (NRF_RADIO->SHORTS & RADIO_SHORTS_READY_START_Msk) {
+			radio_start();
+		}
+		break;
+
+	case RADIO_EVT_ADDRESS:
+		event_raise(&NRF_RADIO->EVENTS_ADDRESS,
+			    RADIO_INTENSET_ADDRESS_Msk);
+
+		if (sim.state == RADIO_TX) {
+			radio_evt_set(RADIO_EVT_END,
+				      sim.tx_start + packet_time(sim.air.len));
+		} else {
+			radio_evt_set(RADIO_EVT_END, sim.ack_end);
+		}
+		break;
+
+	case RADIO_EVT_END:
+		if (sim.state == RADIO_TX) {
+			prx_receive();
+			sim.state = RADIO_TXIDLE;
+		} else {
+			ack_receive();
+			sim.state = RADIO_RXIDLE;
+		}
+
+		event_raise(&NRF_RADIO->EVENTS_END, RADIO_INTENSET_END_Msk);
+
+		if (NRF_RADIO->SHORTS & RADIO_SHORTS_END_DISABLE_Msk) {
+			radio_disable();
+		}
+		break;
+
+	case RADIO_EVT_DISABLED:
+		sim.state = RADIO_DISABLED;
+		event_raise(&NRF_RADIO->EVENTS_DISABLED,
+			    RADIO_INTENSET_DISABLED_Msk);
+
+		if (NRF_RADIO->SHORTS & RADIO_SHORTS_DISABLED_TXEN_Msk) {
+			NRF_RADIO->TASKS_TXEN = 1;
+		} else if (NRF_RADIO->SHORTS & RADIO_SHORTS_DISABLED_RXEN_Msk) {
+			NRF_RADIO->TASKS_RXEN = 1;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+static void timer_tasks_process(void)
+{
+	NRF_TIMER_Type *timer = &radio_sim_timer;
+
+	if (timer->TASKS_SHUTDOWN) {
+		timer->TASKS_SHUTDOWN = 0;
+		sim.timer_running = false;
+		sim.timer_base = 0;
+		sim.timer_fired = 0;
+	}
+
+	if (timer->TASKS_STOP) {
+		timer->TASKS_STOP = 0;
+		sim.timer_base = timer_counter();
+		sim.timer_running = false;
+	}
+
+	if (timer->TASKS_CLEAR) {
+		timer->TASKS_CLEAR = 0;
+		sim.timer_base = 0;
+		sim.timer_start = sim.now;
+		sim.timer_fired = 0;
+	}
+
+	if (timer->TASKS_START) {
+		timer->TASKS_START = 0;
+		if (!sim.timer_running) {
+			sim.timer_running = true;
+			sim.timer_start = sim.now;
+		}
+	}
+}
+
+static void radio_tasks_process(void)
+{
+	if (NRF_RADIO->INTENCLR) {
+		NRF_RADIO->INTENSET &= ~NRF_RADIO->INTENCLR;
+		NRF_RADIO->INTENCLR = 0;
+	}
+
+	if (NRF_RADIO->TASKS_DISABLE) {
+		NRF_RADIO->TASKS_DISABLE = 0;
+		radio_disable();
+	}
+
+	if (NRF_RADIO->TASKS_TXEN) {
+		NRF_RADIO->TASKS_TXEN = 0;
+		if (sim.state == RADIO_DISABLED) {
+			sim.state = RADIO_TXRU;
+			radio_evt_set(RADIO_EVT_READY,
+				      sim.now + RADIO_SIM_RAMP_UP_US);
+		}
+	}
+
+	if (NRF_RADIO->TASKS_RXEN) {
+		NRF_RADIO->TASKS_RXEN = 0;
+		if (sim.state == RADIO_DISABLED) {
+			sim.state = RADIO_RXRU;
+			radio_evt_set(RADIO_EVT_READY,
+				      sim.now + RADIO_SIM_RAMP_UP_US);
+		}
+	}
+
+	if (NRF_RADIO->TASKS_START) {
+		NRF_RADIO->TASKS_START = 0;
+		radio_start();
+	}
+}
+
+uint32_t radio_sim_run(uint32_t max_us)
+{
+	uint32_t end = sim.now + max_us;
+
+	while (true) {
+		enum {
+			SRC_NONE,
+			SRC_RADIO,
+			SRC_IRQ,
+			SRC_TIMER,
+		} src = SRC_NONE;
+		uint32_t time = UINT32_MAX;
+		size_t cc = 0;
+
+		timer_tasks_process();
+		radio_tasks_process();
+
+		if (sim.evt != RADIO_EVT_NONE) {
+			src = SRC_RADIO;
+			time = sim.evt_time;
+		}
+
+		if (sim.irq_pending && (sim.irq_time < time)) {
+			src = SRC_IRQ;
+			time = sim.irq_time;
+		}
+
+		for (size_t i = 0; i < TIMER_CC_CNT; i++) {
+			uint32_t cc_time;
+
+			if (timer_compare_time(i, &cc_time) && (cc_time < time)) {
+				src = SRC_TIMER;
+				time = cc_time;
+				cc = i;
+			}
+		}
+
+		if ((src == SRC_NONE) || (time > end)) {
+			break;
+		}
+
+		sim.now = time;
+
+		switch (src) {
+		case SRC_RADIO:
+			radio_evt_process();
+			break;
+		case SRC_IRQ:
+			sim.irq_pending = false;
+			NVIC_SetPendingIRQ(RADIO_IRQn);
+			break;
+		case SRC_TIMER:
+			timer_compare(cc);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return sim.now;
+}
+
+uint32_t radio_sim_time_us(void)
+{
+	return sim.now;
+}
+
+void radio_sim_stats_get(struct radio_sim_stats *stats)
+{
+	*stats = sim.stats;
+}
+
+void radio_sim_reset(const struct radio_sim_cfg *cfg)
+{
+	memset(&sim, 0, sizeof(sim));
+	memset(&radio_sim_radio, 0, sizeof(radio_sim_radio));
+	memset(&radio_sim_timer, 0, sizeof(radio_sim_timer));
+
+	sim.cfg = *cfg;
+	sim.stats.ack_to_tx_min_us = UINT32_MAX;
+}
+
+nrfx_err_t nrfx_ppi_channel_alloc(nrf_ppi_channel_t *p_channel)
+{
+	if (sim.ppi_cnt >= PPI_CH_CNT) {
+		return -1;
+	}
+
+	*p_channel = sim.ppi_cnt++;
+
+	return NRFX_SUCCESS;
+}
+
+nrfx_err_t nrfx_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep,
+				   uint32_t tep)
+{
+	sim.ppi_eep[channel] = eep;
+	sim.ppi_tep[channel] = tep;
+
+	return NRFX_SUCCESS;
+}
+
+void nrfx_gppi_channels_enable(uint32_t mask)
+{
+	sim.ppi_enabled |= mask;
+}
+
+void nrfx_gppi_channels_disable(uint32_t mask)
+{
+	sim.ppi_enabled &= ~mask;
+}
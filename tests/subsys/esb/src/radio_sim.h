@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef RADIO_SIM_H_
+#define RADIO_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Ramp-up time of the radio, for TX and RX. */
+#define RADIO_SIM_RAMP_UP_US	130
+/* Time from the DISABLE task to the DISABLED event. */
+#define RADIO_SIM_DISABLE_US	1
+
+/* Called for every new payload received by the simulated PRX. */
+typedef void (*radio_sim_rx_cb)(uint8_t pipe, const uint8_t *data,
+				uint8_t len);
+
+/* Simulated air and PRX. */
+struct radio_sim_cfg {
+	/* Time from an event to the start of its interrupt handler, on both
+	 * sides.
+	 */
+	uint32_t isr_latency_us;
+	/* Every n-th packet sent by the PTX is lost, 0 if none. */
+	uint32_t tx_loss_period;
+	/* Every n-th acknowledgment is lost, 0 if none. */
+	uint32_t ack_loss_period;
+	/* The PRX acknowledges only packets that request it. */
+	bool selective_auto_ack;
+	radio_sim_rx_cb rx_cb;
+};
+
+struct radio_sim_stats {
+	/* Packets sent by the PTX, including retransmissions. */
+	uint32_t tx_packets;
+	/* Packets lost on air. */
+	uint32_t tx_lost;
+	/* Packets sent while the PRX was not ready to receive. */
+	uint32_t tx_missed;
+	/* Retransmitted packets received again by the PRX. */
+	uint32_t rx_duplicates;
+	/* Acknowledgments received by the PTX. */
+	uint32_t acks;
+	/* Shortest and longest time from the end of an acknowledgment to the
+	 * start of the next packet.
+	 */
+	uint32_t ack_to_tx_min_us;
+	uint32_t ack_to_tx_max_us;
+};
+
+/* Reset the simulated hardware. Must be called before esb_init(). */
+void radio_sim_reset(const struct radio_sim_cfg *cfg);
+
+/* Run the simulation until the radio is idle or for at most the given time.
+ *
+ * Returns the simulated time in microseconds.
+ */
+uint32_t radio_sim_run(uint32_t max_us);
+
+uint32_t radio_sim_time_us(void);
+
+void radio_sim_stats_get(struct radio_sim_stats *stats);
+
+#endif /* RADIO_SIM_H_ */
@@ -280,6 +280,8 @@ static void test_topic_prop_bag_too_long(void)
 
 void test_main(void)
 {
+	zassert_equal(azure_iot_hub_topic_router_init(), 0, NULL);
+
 	ztest_test_suite(azure_iot_hub_topic,
 			 ztest_unit_test(test_topic_parse_devicebound),
 			 ztest_unit_test(test_topic_parse_twin_update_desired),
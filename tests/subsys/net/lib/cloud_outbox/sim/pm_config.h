@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* The partition manager is not used on native_posix, the outbox is stored
+ * in the storage partition instead.
+ */
+
+#ifndef PM_CONFIG_SIM_H_
+#define PM_CONFIG_SIM_H_
+
+#include <storage/flash_map.h>
+
+#define PM_CLOUD_OUTBOX_ID FLASH_AREA_ID(storage)
+
+#endif /* PM_CONFIG_SIM_H_ */
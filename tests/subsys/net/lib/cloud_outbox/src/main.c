@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <zephyr.h>
+#include <ztest.h>
+#include <net/cloud.h>
+#include <net/cloud_outbox.h>
+
+#define DRAIN_WAIT K_MSEC(100)
+#define SENT_MAX 8
+#define SENT_LEN_MAX (CONFIG_CLOUD_OUTBOX_MSG_MAX_LEN + 1)
+
+static char sent[SENT_MAX][SENT_LEN_MAX];
+static size_t sent_len[SENT_MAX];
+static enum cloud_endpoint_type sent_ep[SENT_MAX];
+static int sent_count;
+static int send_err;
+/* Number of the following sends that fail. */
+static int send_fails;
+static int send_attempts;
+
+static int mock_send(const struct cloud_backend *const backend,
+		     const struct cloud_msg *const msg)
+{
+	send_attempts++;
+
+	if (send_err) {
+		return send_err;
+	}
+
+	if (send_fails > 0) {
+		send_fails--;
+		return -EAGAIN;
+	}
+
+	zassert_true(sent_count < SENT_MAX, "Too many publications");
+	zassert_true(msg->len < SENT_LEN_MAX, "Publication too large");
+
+	memcpy(sent[sent_count], msg->buf, msg->len);
+	sent[sent_count][msg->len] = '\0';
+	sent_len[sent_count] = msg->len;
+	sent_ep[sent_count] = msg->endpoint.type;
+	sent_count++;
+
+	return 0;
+}
+
+static const struct cloud_api mock_api = {
+	.send = mock_send,
+};
+
+static struct cloud_backend_config mock_config = {
+	.name = "MOCK",
+};
+
+static const struct cloud_backend mock_backend = {
+	.api = &mock_api,
+	.config = &mock_config,
+};
+
+static void event_notify(enum cloud_event_type type)
+{
+	struct cloud_event evt = {
+		.type = type,
+	};
+
+	cloud_outbox_event_notify(&evt);
+}
+
+static int msg_send(enum cloud_endpoint_type ep, int n)
+{
+	char buf[16];
+	struct cloud_msg msg = {
+		.buf = buf,
+		.qos = CLOUD_QOS_AT_MOST_ONCE,
+		.endpoint.type = ep,
+	};
+
+	msg.len = snprintf(buf, sizeof(buf), "{\"n\":%d}", n);
+
+	return cloud_outbox_send(&msg);
+}
+
+static void setup(void)
+{
+	struct cloud_outbox_stats stats;
+
+	/* Every test starts disconnected, with an empty outbox. */
+	event_notify(CLOUD_EVT_DISCONNECTED);
+	cloud_outbox_stats_get(&stats);
+	zassert_equal(stats.pending, 0, "Outbox not empty");
+
+	memset(sent, 0, sizeof(sent));
+	sent_count = 0;
+	send_err = 0;
+	send_fails = 0;
+	send_attempts = 0;
+}
+
+static void teardown(void)
+{
+}
+
+static void test_cloud_outbox_init(void)
+{
+	zassert_equal(cloud_outbox_init(NULL), -EINVAL, "NULL backend");
+	zassert_equal(cloud_outbox_init(&mock_backend), 0, "Init failed");
+	zassert_equal(cloud_outbox_init(&mock_backend), -EALREADY,
+		      "Initialized twice");
+}
+
+static void test_cloud_outbox_send_direct(void)
+{
+	struct cloud_outbox_stats before, after;
+
+	cloud_outbox_stats_get(&before);
+	event_notify(CLOUD_EVT_READY);
+
+	zassert_equal(msg_send(CLOUD_EP_MSG, 1), 0, "Send failed");
+	zassert_equal(sent_count, 1, "Message not sent directly");
+	zassert_equal(strcmp(sent[0], "{\"n\":1}"), 0, "Wrong message");
+
+	cloud_outbox_stats_get(&after);
+	zassert_equal(after.stored, before.stored, "Message was stored");
+}
+
+static void test_cloud_outbox_batch(void)
+{
+	struct cloud_outbox_stats before, after;
+
+	cloud_outbox_stats_get(&before);
+
+	for (int i = 0; i < 3; i++) {
+		zassert_equal(msg_send(CLOUD_EP_MSG, i), 0, "Store failed");
+	}
+
+	k_sleep(DRAIN_WAIT);
+	zassert_equal(sent_count, 0, "Sent while disconnected");
+
+	event_notify(CLOUD_EVT_READY);
+	k_sleep(DRAIN_WAIT);
+
+	zassert_equal(sent_count, 1, "Messages not batched");
+	zassert_equal(strcmp(sent[0], "[{\"n\":0},{\"n\":1},{\"n\":2}]"), 0,
+		      "Wrong batch: %s", sent[0]);
+
+	cloud_outbox_stats_get(&after);
+	zassert_equal(after.sent - before.sent, 3, "Wrong sent count");
+	zassert_equal(after.publications - before.publications, 1,
+		      "Wrong publication count");
+	zassert_equal(after.pending, 0, "Messages left in outbox");
+}
+
+static void test_cloud_outbox_order(void)
+{
+	zassert_equal(msg_send(CLOUD_EP_MSG, 0), 0, "Store failed");
+	zassert_equal(msg_send(CLOUD_EP_STATE, 1), 0, "Store failed");
+	zassert_equal(msg_send(CLOUD_EP_STATE, 2), 0, "Store failed");
+	zassert_equal(msg_send(CLOUD_EP_MSG, 3), 0, "Store failed");
+
+	event_notify(CLOUD_EVT_READY);
+	k_sleep(DRAIN_WAIT);
+
+	/* Only messages to the message endpoint are batched. */
+	zassert_equal(sent_count, 4, "Wrong publication count");
+	zassert_equal(strcmp(sent[0], "{\"n\":0}"), 0, "Wrong order");
+	zassert_equal(strcmp(sent[1], "{\"n\":1}"), 0, "Wrong order");
+	zassert_equal(strcmp(sent[2], "{\"n\":2}"), 0, "Wrong order");
+	zassert_equal(strcmp(sent[3], "{\"n\":3}"), 0, "Wrong order");
+	zassert_equal(sent_ep[1], CLOUD_EP_STATE, "Wrong endpoint");
+}
+
+static void test_cloud_outbox_send_error(void)
+{
+	struct cloud_outbox_stats stats;
+
+	event_notify(CLOUD_EVT_READY);
+	send_err = -ENOTCONN;
+
+	zassert_equal(msg_send(CLOUD_EP_MSG, 1), 0, "Message not stored");
+	k_sleep(DRAIN_WAIT);
+
+	cloud_outbox_stats_get(&stats);
+	zassert_equal(stats.pending, 1, "Message not kept after error");
+
+	send_err = 0;
+	zassert_equal(cloud_outbox_flush(), 0, "Flush failed");
+	k_sleep(DRAIN_WAIT);
+
+	zassert_equal(sent_count, 1, "Message not sent after flush");
+	cloud_outbox_stats_get(&stats);
+	zassert_equal(stats.pending, 0, "Message left in outbox");
+}
+
+static void test_cloud_outbox_retry(void)
+{
+	event_notify(CLOUD_EVT_READY);
+
+	/* The direct send, the first drain and the first retry fail. */
+	send_fails = 3;
+
+	zassert_equal(msg_send(CLOUD_EP_MSG, 1), 0, "Message not stored");
+	k_sleep(K_MSEC(100));
+	zassert_equal(send_attempts, 2, "Wrong number of attempts");
+
+	/* Retried after the minimum delay. */
+	k_sleep(K_MSEC(CONFIG_CLOUD_OUTBOX_RETRY_MIN_MS));
+	zassert_equal(send_attempts, 3, "Not retried after the delay");
+	zassert_equal(sent_count, 0, "Sent before the retry succeeded");
+
+	/* Retried after twice the delay. */
+	k_sleep(K_MSEC(CONFIG_CLOUD_OUTBOX_RETRY_MIN_MS));
+	zassert_equal(send_attempts, 3, "Retry delay not increased");
+	k_sleep(K_MSEC(CONFIG_CLOUD_OUTBOX_RETRY_MIN_MS));
+	zassert_equal(send_attempts, 4, "Not retried after the delay");
+	zassert_equal(sent_count, 1, "Message not sent after retry");
+}
+
+static void test_cloud_outbox_not_json(void)
+{
+	/* CBOR map {"n": 1}. */
+	static const char cbor[] = { 0xa1, 0x61, 'n', 0x01 };
+	struct cloud_msg msg = {
+		.buf = (char *)cbor,
+		.len = sizeof(cbor),
+		.qos = CLOUD_QOS_AT_MOST_ONCE,
+		.endpoint.type = CLOUD_EP_MSG,
+	};
+
+	zassert_equal(cloud_outbox_send(&msg), 0, "Store failed");
+	zassert_equal(cloud_outbox_send(&msg), 0, "Store failed");
+	zassert_equal(msg_send(CLOUD_EP_MSG, 2), 0, "Store failed");
+	zassert_equal(msg_send(CLOUD_EP_MSG, 3), 0, "Store failed");
+
+	event_notify(CLOUD_EVT_READY);
+	k_sleep(DRAIN_WAIT);
+
+	/* Only the JSON objects are batched. */
+	zassert_equal(sent_count, IS_ENABLED(CONFIG_CLOUD_OUTBOX_BATCH) ? 3 : 4,
+		      "Wrong publication count");
+
+	for (int i = 0; i < 2; i++) {
+		zassert_equal(sent_len[i], sizeof(cbor), "Payload modified");
+		zassert_mem_equal(sent[i], cbor, sizeof(cbor),
+				  "Payload modified");
+	}
+}
+
+static int n_values_get(int *values, int max)
+{
+	int count = 0;
+
+	for (int i = 0; i < sent_count; i++) {
+		const char *p = sent[i];
+
+		while ((p = strstr(p, "\"n\":")) && (count < max)) {
+			p += strlen("\"n\":");
+			values[count++] = atoi(p);
+		}
+	}
+
+	return count;
+}
+
+static void test_cloud_outbox_flash_spill(void)
+{
+	struct cloud_outbox_stats before, after;
+	int values[24];
+	int count;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_CLOUD_OUTBOX_FLASH)) {
+		ztest_test_skip();
+	}
+
+	cloud_outbox_stats_get(&before);
+
+	/* The RAM buffer fits less than 10 records, the others go to flash. */
+	for (i = 0; i < 20; i++) {
+		zassert_equal(msg_send(CLOUD_EP_MSG, i), 0, "Store failed");
+	}
+
+	cloud_outbox_stats_get(&after);
+	zassert_equal(after.pending, 20, "Messages not kept");
+	zassert_equal(after.dropped, before.dropped, "Messages dropped");
+
+	event_notify(CLOUD_EVT_READY);
+	k_sleep(DRAIN_WAIT);
+
+	count = n_values_get(values, ARRAY_SIZE(values));
+	zassert_equal(count, 20, "%d messages sent", count);
+
+	for (i = 0; i < count; i++) {
+		zassert_equal(values[i], i, "Wrong order");
+	}
+
+	cloud_outbox_stats_get(&after);
+	zassert_equal(after.pending, 0, "Messages left in outbox");
+}
+
+static void test_cloud_outbox_full(void)
+{
+	struct cloud_outbox_stats before, after;
+	char first[16];
+	int i;
+
+	if (IS_ENABLED(CONFIG_CLOUD_OUTBOX_FLASH)) {
+		ztest_test_skip();
+	}
+
+	cloud_outbox_stats_get(&before);
+
+	/* Each record uses 13 bytes, so the oldest ones are dropped. */
+	for (i = 0; i < 12; i++) {
+		zassert_equal(msg_send(CLOUD_EP_MSG, i), 0, "Store failed");
+	}
+
+	cloud_outbox_stats_get(&after);
+	zassert_equal(after.dropped - before.dropped,
+		      12 - after.pending, "Wrong drop count");
+	zassert_true(after.pending < 12, "Nothing was dropped");
+
+	event_notify(CLOUD_EVT_READY);
+	k_sleep(DRAIN_WAIT);
+
+	snprintf(first, sizeof(first), "[{\"n\":%d}",
+		 (int)(12 - after.pending));
+	zassert_true(sent_count > 0, "Nothing sent");
+	zassert_equal(strncmp(sent[0], first, strlen(first)), 0,
+		      "Newest messages not kept: %s", sent[0]);
+}
+
+static void test_cloud_outbox_too_large(void)
+{
+	static char buf[CONFIG_CLOUD_OUTBOX_MSG_MAX_LEN + 1];
+	struct cloud_msg msg = {
+		.buf = buf,
+		.len = sizeof(buf),
+		.endpoint.type = CLOUD_EP_MSG,
+	};
+
+	zassert_equal(cloud_outbox_send(&msg), -EMSGSIZE,
+		      "Too large message stored");
+	zassert_equal(cloud_outbox_send(NULL), -EINVAL, "NULL message");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(cloud_outbox_test,
+		ztest_unit_test(test_cloud_outbox_init),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_send_direct, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_batch, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_order, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_send_error, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_retry, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_not_json, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_flash_spill, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_full, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_cloud_outbox_too_large, setup, teardown)
+	);
+
+	ztest_run_test_suite(cloud_outbox_test);
+}
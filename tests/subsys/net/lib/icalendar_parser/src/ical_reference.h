@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef ICAL_REFERENCE_H__
+#define ICAL_REFERENCE_H__
+
+#include <net/icalendar_parser.h>
+
+#define ICAL_REFERENCE_BUFFER_SIZE 16384
+
+struct ical_reference {
+	char buf[ICAL_REFERENCE_BUFFER_SIZE + 1];
+	size_t offset;
+	bool icalobject_begin;
+	icalendar_parser_callback_t callback;
+};
+
+int ical_reference_init(struct ical_reference *ical,
+			icalendar_parser_callback_t callback);
+
+size_t ical_reference_parse(struct ical_reference *ical,
+			    const char *data, size_t len);
+
+#endif /* ICAL_REFERENCE_H__ */
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#ifndef ICS_DATA_H__
+#define ICS_DATA_H__
+
+/* Calendars like the ones exported by common calendar services. The long
+ * content lines are folded at 75 octets.
+ */
+
+/* Recurring and all-day events, with a time zone */
+static const char ics_google[] =
+	"BEGIN:VCALENDAR\r\n"
+	"PRODID:-//Google Inc//Google Calendar 70.9054//EN\r\n"
+	"VERSION:2.0\r\n"
+	"CALSCALE:GREGORIAN\r\n"
+	"METHOD:PUBLISH\r\n"
+	"X-WR-CALNAME:Firmware team\r\n"
+	"X-WR-TIMEZONE:Europe/Oslo\r\n"
+	"X-WR-CALDESC:Meetings and release milestones of the firmware team\\, includi\r\n"
+	" ng the weekly synchronization meetings and the release reviews.\r\n"
+	"BEGIN:VTIMEZONE\r\n"
+	"TZID:Europe/Oslo\r\n"
+	"X-LIC-LOCATION:Europe/Oslo\r\n"
+	"BEGIN:DAYLIGHT\r\n"
+	"TZOFFSETFROM:+0100\r\n"
+	"TZOFFSETTO:+0200\r\n"
+	"TZNAME:CEST\r\n"
+	"DTSTART:19700329T020000\r\n"
+	"RRULE:FREQ=YEARLY;BYMONTH=3;BYDAY=-1SU\r\n"
+	"END:DAYLIGHT\r\n"
+	"BEGIN:STANDARD\r\n"
+	"TZOFFSETFROM:+0200\r\n"
+	"TZOFFSETTO:+0100\r\n"
+	"TZNAME:CET\r\n"
+	"DTSTART:19701025T030000\r\n"
+	"RRULE:FREQ=YEARLY;BYMONTH=10;BYDAY=-1SU\r\n"
+	"END:STANDARD\r\n"
+	"END:VTIMEZONE\r\n"
+	"BEGIN:VEVENT\r\n"
+	"DTSTART;TZID=Europe/Oslo:20211025T090000\r\n"
+	"DTEND;TZID=Europe/Oslo:20211025T093000\r\n"
+	"RRULE:FREQ=WEEKLY;WKST=MO;BYDAY=MO\r\n"
+	"DTSTAMP:20211019T101512Z\r\n"
+	"ORGANIZER;CN=Firmware team:mailto:firmware.team@example.com\r\n"
+	"UID:5k3o1v2lq7c0c9hmj4i5p6m7g8@google.com\r\n"
+	"ATTENDEE;CUTYPE=INDIVIDUAL;ROLE=REQ-PARTICIPANT;PARTSTAT=ACCEPTED;CN=Kari N\r\n"
+	" ordmann;X-NUM-GUESTS=0:mailto:kari.nordmann@example.com\r\n"
+	"ATTENDEE;CUTYPE=INDIVIDUAL;ROLE=REQ-PARTICIPANT;PARTSTAT=NEEDS-ACTION;CN=Ol\r\n"
+	" a Nordmann;X-NUM-GUESTS=0:mailto:ola.nordmann@example.com\r\n"
+	"CREATED:20210901T081512Z\r\n"
+	"DESCRIPTION:Weekly synchronization of the firmware team.\\n\\nAgenda:\\n- Stat\r\n"
+	" us of the open pull requests\\n- Test results of the nightly builds\\n- Plan\r\n"
+	" ning of the next release\\n\\nJoin the video meeting: https://meet.example.c\r\n"
+	" om/abc-defg-hij\\nOr dial: +47 21 00 00 00 PIN: 123 456 789#\r\n"
+	"LAST-MODIFIED:20211018T140223Z\r\n"
+	"LOCATION:Meeting room Nidelva\\, 3rd floor\\, Trondheim\r\n"
+	"SEQUENCE:2\r\n"
+	"STATUS:CONFIRMED\r\n"
+	"SUMMARY:Firmware team weekly sync\r\n"
+	"TRANSP:OPAQUE\r\n"
+	"END:VEVENT\r\n"
+	"BEGIN:VEVENT\r\n"
+	"DTSTART;VALUE=DATE:20211101\r\n"
+	"DTEND;VALUE=DATE:20211102\r\n"
+	"DTSTAMP:20211019T101512Z\r\n"
+	"UID:0ab1cd2ef3gh4ij5kl6mn7op8q@google.com\r\n"
+	"CREATED:20211004T120001Z\r\n"
+	"DESCRIPTION:Code freeze for the next release. Only bug fixes are merged aft\r\n"
+	" er this date.\r\n"
+	"LAST-MODIFIED:20211004T120001Z\r\n"
+	"LOCATION:\r\n"
+	"SEQUENCE:0\r\n"
+	"STATUS:CONFIRMED\r\n"
+	"SUMMARY:Code freeze\r\n"
+	"TRANSP:TRANSPARENT\r\n"
+	"END:VEVENT\r\n"
+	"END:VCALENDAR\r\n";
+
+/* Meeting request with a to-do */
+static const char ics_outlook[] =
+	"BEGIN:VCALENDAR\r\n"
+	"METHOD:REQUEST\r\n"
+	"PRODID:Microsoft Exchange Server 2010\r\n"
+	"VERSION:2.0\r\n"
+	"BEGIN:VTIMEZONE\r\n"
+	"TZID:W. Europe Standard Time\r\n"
+	"BEGIN:STANDARD\r\n"
+	"DTSTART:16010101T030000\r\n"
+	"TZOFFSETFROM:+0200\r\n"
+	"TZOFFSETTO:+0100\r\n"
+	"RRULE:FREQ=YEARLY;INTERVAL=1;BYDAY=-1SU;BYMONTH=10\r\n"
+	"END:STANDARD\r\n"
+	"BEGIN:DAYLIGHT\r\n"
+	"DTSTART:16010101T020000\r\n"
+	"TZOFFSETFROM:+0100\r\n"
+	"TZOFFSETTO:+0200\r\n"
+	"RRULE:FREQ=YEARLY;INTERVAL=1;BYDAY=-1SU;BYMONTH=3\r\n"
+	"END:DAYLIGHT\r\n"
+	"END:VTIMEZONE\r\n"
+	"BEGIN:VEVENT\r\n"
+	"ORGANIZER;CN=Nordmann, Kari:mailto:kari.nordmann@example.com\r\n"
+	"ATTENDEE;ROLE=REQ-PARTICIPANT;PARTSTAT=NEEDS-ACTION;RSVP=TRUE;CN=Nordmann, \r\n"
+	" Ola:mailto:ola.nordmann@example.com\r\n"
+	"DESCRIPTION:Hi all\\,\\n\\nLet us review the results of the power consumption \r\n"
+	" measurements of the asset tracker before the release. Please bring your me\r\n"
+	" asurement logs and the configurations that were used.\\n\\nBest regards\\,\\nK\r\n"
+	" ari\\n\r\n"
+	"UID:040000008200E00074C5B7101A82E00800000000B0D9A7C2A4C4D701000000000000000\r\n"
+	" 010000000A1B2C3D4E5F60718293A4B5C6D7E8F90\r\n"
+	"SUMMARY:Review of the power consumption measurements\r\n"
+	"DTSTART;TZID=W. Europe Standard Time:20211027T130000\r\n"
+	"DTEND;TZID=W. Europe Standard Time:20211027T143000\r\n"
+	"CLASS:PUBLIC\r\n"
+	"PRIORITY:5\r\n"
+	"DTSTAMP:20211019T094500Z\r\n"
+	"TRANSP:OPAQUE\r\n"
+	"STATUS:CONFIRMED\r\n"
+	"SEQUENCE:0\r\n"
+	"LOCATION:Microsoft Teams Meeting\r\n"
+	"X-MICROSOFT-CDO-APPT-SEQUENCE:0\r\n"
+	"X-MICROSOFT-CDO-OWNERAPPTID:2119877312\r\n"
+	"X-MICROSOFT-CDO-BUSYSTATUS:TENTATIVE\r\n"
+	"X-MICROSOFT-CDO-INTENDEDSTATUS:BUSY\r\n"
+	"X-MICROSOFT-CDO-ALLDAYEVENT:FALSE\r\n"
+	"X-MICROSOFT-CDO-IMPORTANCE:1\r\n"
+	"X-MICROSOFT-CDO-INSTTYPE:0\r\n"
+	"X-MICROSOFT-DONOTFORWARDMEETING:FALSE\r\n"
+	"X-MICROSOFT-DISALLOW-COUNTER:FALSE\r\n"
+	"END:VEVENT\r\n"
+	"BEGIN:VTODO\r\n"
+	"DTSTAMP:20211019T094500Z\r\n"
+	"UID:20211019T094500Z-0001@example.com\r\n"
+	"SUMMARY:Send the measurement logs\r\n"
+	"DUE;VALUE=DATE:20211026\r\n"
+	"STATUS:NEEDS-ACTION\r\n"
+	"END:VTODO\r\n"
+	"END:VCALENDAR\r\n";
+
+/* Events with unsupported components between them */
+static const char ics_icloud[] =
+	"BEGIN:VCALENDAR\r\n"
+	"VERSION:2.0\r\n"
+	"PRODID:-//Apple Inc.//Mac OS X 10.15.7//EN\r\n"
+	"CALSCALE:GREGORIAN\r\n"
+	"BEGIN:VEVENT\r\n"
+	"CREATED:20211012T071231Z\r\n"
+	"UID:8F2C5E3A-1B4D-4C6E-9A7B-0D1E2F3A4B5C\r\n"
+	"DTEND:20211030T180000Z\r\n"
+	"TRANSP:OPAQUE\r\n"
+	"X-APPLE-TRAVEL-ADVISORY-BEHAVIOR:AUTOMATIC\r\n"
+	"SUMMARY:Hiking trip to the mountains with the whole team and the families\r\n"
+	"LAST-MODIFIED:20211012T071309Z\r\n"
+	"DTSTAMP:20211012T071309Z\r\n"
+	"DTSTART:20211030T080000Z\r\n"
+	"LOCATION:Bymarka\\, Trondheim\\, Norway\r\n"
+	"X-APPLE-STRUCTURED-LOCATION;VALUE=URI;X-APPLE-MAPKIT-HANDLE=CAESvQEaEgmFxG6\r\n"
+	" x3ahPQBHpT2hGjWgkQA==;X-APPLE-RADIUS=2354.6796;X-TITLE=Bymarka:geo:63.421,\r\n"
+	" 10.279\r\n"
+	"SEQUENCE:1\r\n"
+	"END:VEVENT\r\n"
+	"BEGIN:VJOURNAL\r\n"
+	"UID:19970901T130000Z-123405@example.com\r\n"
+	"DTSTAMP:19970901T130000Z\r\n"
+	"DTSTART;VALUE=DATE:19970317\r\n"
+	"SUMMARY:Staff meeting minutes\r\n"
+	"DESCRIPTION:1. Staff meeting: Participants include Joe\\, Lisa\\, and Bob. Au\r\n"
+	" rora project plans were reviewed. There is currently no budget reserves fo\r\n"
+	" r this project. Lisa will escalate to management. Next meeting on Tuesday.\r\n"
+	" \\n\r\n"
+	"END:VJOURNAL\r\n"
+	"BEGIN:VFREEBUSY\r\n"
+	"UID:19970901T082949Z-FA43EF@example.com\r\n"
+	"ORGANIZER:mailto:jane_doe@example.com\r\n"
+	"ATTENDEE:mailto:john_public@example.com\r\n"
+	"DTSTART:19971015T050000Z\r\n"
+	"DTEND:19971016T050000Z\r\n"
+	"DTSTAMP:19970901T083000Z\r\n"
+	"END:VFREEBUSY\r\n"
+	"BEGIN:VEVENT\r\n"
+	"UID:A1B2C3D4-0000-4000-8000-000000000001\r\n"
+	"DTSTAMP:20211012T071309Z\r\n"
+	"DTSTART:20211102T160000Z\r\n"
+	"DTEND:20211102T170000Z\r\n"
+	"SUMMARY:Dentist\r\n"
+	"END:VEVENT\r\n"
+	"END:VCALENDAR\r\n";
+
+#endif /* ICS_DATA_H__ */
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <net/icalendar_parser.h>
+
+#include "ical_reference.h"
+#include "ics_data.h"
+
+#define MAX_EVENTS 8
+
+struct ics {
+	const char *data;
+	size_t len;
+};
+
+static const struct ics calendars[] = {
+	{ ics_google, sizeof(ics_google) - 1 },
+	{ ics_outlook, sizeof(ics_outlook) - 1 },
+	{ ics_icloud, sizeof(ics_icloud) - 1 },
+};
+
+struct events {
+	struct ical_parser_evt evt[MAX_EVENTS];
+	size_t count;
+	/* Number of events after which the callback stops the parsing. */
+	size_t stop_at;
+};
+
+static struct icalendar_parser ical;
+static struct ical_reference ref;
+static struct events parsed;
+static struct events expected;
+static char lf_only[sizeof(ics_google)];
+
+static int events_add(struct events *events, const struct ical_parser_evt *evt)
+{
+	zassert_true(events->count < MAX_EVENTS, "Too many events");
+	events->evt[events->count++] = *evt;
+
+	return (events->count == events->stop_at);
+}
+
+static int parsed_cb(const struct ical_parser_evt *evt)
+{
+	return events_add(&parsed, evt);
+}
+
+static int expected_cb(const struct ical_parser_evt *evt)
+{
+	return events_add(&expected, evt);
+}
+
+static void reference_parse(const struct ics *ics)
+{
+	memset(&expected, 0, sizeof(expected));
+	ical_reference_init(&ref, expected_cb);
+	ical_reference_parse(&ref, ics->data, ics->len);
+
+	zassert_true(expected.count > 1, "No reference events");
+}
+
+static void parse_init(void)
+{
+	int err;
+
+	memset(&parsed, 0, sizeof(parsed));
+	err = ical_parser_init(&ical, parsed_cb);
+	zassert_equal(err, 0, "ical_parser_init failed: %d", err);
+}
+
+static void parse_chunk(const char *data, size_t len)
+{
+	size_t ret = ical_parser_parse(&ical, data, len);
+
+	zassert_equal(ret, len, "%zu of %zu bytes parsed", ret, len);
+}
+
+static void parse_finish(void)
+{
+	int err = ical_parser_finish(&ical);
+
+	zassert_equal(err, 0, "ical_parser_finish failed: %d", err);
+}
+
+static void check_event(const struct ical_parser_evt *evt,
+			const struct ical_parser_evt *exp)
+{
+	zassert_equal(evt->id, exp->id, "Wrong id");
+	zassert_equal(evt->error, exp->error, "Wrong error");
+	zassert_equal(strcmp(evt->ical_com.summary, exp->ical_com.summary), 0,
+		      "Wrong summary: %s", evt->ical_com.summary);
+	zassert_equal(strcmp(evt->ical_com.location, exp->ical_com.location),
+		      0, "Wrong location: %s", evt->ical_com.location);
+	zassert_equal(strcmp(evt->ical_com.description,
+			     exp->ical_com.description), 0,
+		      "Wrong description: %s", evt->ical_com.description);
+	zassert_equal(strcmp(evt->ical_com.dtstart, exp->ical_com.dtstart), 0,
+		      "Wrong dtstart: %s", evt->ical_com.dtstart);
+	zassert_equal(strcmp(evt->ical_com.dtend, exp->ical_com.dtend), 0,
+		      "Wrong dtend: %s", evt->ical_com.dtend);
+}
+
+static void check_events(void)
+{
+	zassert_equal(parsed.count, expected.count, "%zu events",
+		      parsed.count);
+
+	for (size_t i = 0; i < parsed.count; i++) {
+		check_event(&parsed.evt[i], &expected.evt[i]);
+	}
+}
+
+static void test_split_anywhere(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(calendars); i++) {
+		const struct ics *ics = &calendars[i];
+
+		reference_parse(ics);
+
+		for (size_t split = 0; split <= ics->len; split++) {
+			parse_init();
+			parse_chunk(ics->data, split);
+			parse_chunk(ics->data + split, ics->len - split);
+			parse_finish();
+			check_events();
+		}
+	}
+}
+
+static void test_chunk_sizes(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(calendars); i++) {
+		const struct ics *ics = &calendars[i];
+
+		reference_parse(ics);
+
+		for (size_t chunk = 1; chunk <= 128; chunk++) {
+			parse_init();
+			for (size_t pos = 0; pos < ics->len; pos += chunk) {
+				parse_chunk(ics->data + pos,
+					    MIN(chunk, ics->len - pos));
+			}
+			parse_finish();
+			check_events();
+		}
+	}
+}
+
+static void test_lf_line_endings(void)
+{
+	size_t len = 0;
+
+	reference_parse(&calendars[0]);
+
+	for (size_t i = 0; i < calendars[0].len; i++) {
+		if (ics_google[i] != '\r') {
+			lf_only[len++] = ics_google[i];
+		}
+	}
+
+	parse_init();
+	parse_chunk(lf_only, len);
+	parse_finish();
+	check_events();
+}
+
+static void test_nested_component(void)
+{
+	static const char data[] =
+		"BEGIN:VCALENDAR\r\n"
+		"VERSION:2.0\r\n"
+		"BEGIN:VEVENT\r\n"
+		"SUMMARY:Release review\r\n"
+		"BEGIN:VALARM\r\n"
+		"ACTION:DISPLAY\r\n"
+		"DESCRIPTION:Reminder\r\n"
+		"TRIGGER:-PT15M\r\n"
+		"END:VALARM\r\n"
+		"DTSTART:20211102T160000Z\r\n"
+		"END:VEVENT\r\n"
+		"END:VCALENDAR\r\n";
+
+	parse_init();
+	parse_chunk(data, sizeof(data) - 1);
+
+	zassert_equal(parsed.count, 1, "%zu events", parsed.count);
+	zassert_equal(parsed.evt[0].error, ICAL_ERROR_NONE, NULL);
+	zassert_equal(strcmp(parsed.evt[0].ical_com.summary, "Release review"),
+		      0, NULL);
+	zassert_equal(strcmp(parsed.evt[0].ical_com.description, ""), 0,
+		      "Alarm description parsed");
+	zassert_equal(strcmp(parsed.evt[0].ical_com.dtstart,
+			     "20211102T160000Z"), 0, NULL);
+}
+
+static void test_end_of_stream(void)
+{
+	static const char data[] =
+		"BEGIN:VCALENDAR\r\n"
+		"BEGIN:VEVENT\r\n"
+		"SUMMARY:Release review\r\n"
+		"END:VEVENT\r\n";
+	/* The stream may end with or without a line break. */
+	const size_t lens[] = { sizeof(data) - 1, sizeof(data) - 3 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(lens); i++) {
+		parse_init();
+		parse_chunk(data, lens[i]);
+		zassert_equal(parsed.count, 0, "Reported before the end");
+
+		parse_finish();
+		zassert_equal(parsed.count, 1, "%zu events", parsed.count);
+		zassert_equal(strcmp(parsed.evt[0].ical_com.summary,
+				     "Release review"), 0, NULL);
+
+		/* Finishing again reports nothing more. */
+		parse_finish();
+		zassert_equal(parsed.count, 1, "%zu events", parsed.count);
+	}
+}
+
+static void test_error_continues(void)
+{
+	static const char data[] =
+		"BEGIN:VCALENDAR\r\n"
+		"VERSION:2.0\r\n"
+		"BEGIN:VEVENT\r\n"
+		"SUMMARY;LANGUAGE=en:Release review\r\n"
+		"DTSTART:20211102T160000Z\r\n"
+		"END:VEVENT\r\n"
+		"BEGIN:VEVENT\r\n"
+		"DTSTART:20211103T160000Z\r\n"
+		"DESCRIPTION:Follow-up\r\n"
+		"END:VEVENT\r\n"
+		"END:VCALENDAR\r\n";
+
+	parse_init();
+	parse_chunk(data, sizeof(data) - 1);
+
+	zassert_equal(parsed.count, 2, "%zu events", parsed.count);
+	zassert_equal(parsed.evt[0].error, ICAL_ERROR_SUMMARY, NULL);
+	zassert_equal(parsed.evt[1].error, ICAL_ERROR_NONE, NULL);
+	zassert_equal(strcmp(parsed.evt[1].ical_com.dtstart,
+			     "20211103T160000Z"), 0, NULL);
+	zassert_equal(strcmp(parsed.evt[1].ical_com.description, "Follow-up"),
+		      0, NULL);
+}
+
+static void test_value_overflow(void)
+{
+	static const char data[] =
+		"BEGIN:VCALENDAR\r\n"
+		"BEGIN:VEVENT\r\n"
+		"DTSTART:20211102T160000Z\r\n"
+		"DTEND:20211102T170000Z-too-long\r\n"
+		"END:VEVENT\r\n"
+		"END:VCALENDAR\r\n";
+
+	parse_init();
+	parse_chunk(data, sizeof(data) - 1);
+
+	zassert_equal(parsed.count, 1, "%zu events", parsed.count);
+	zassert_equal(parsed.evt[0].error, ICAL_ERROR_DTEND, NULL);
+	zassert_equal(strcmp(parsed.evt[0].ical_com.dtend, ""), 0, NULL);
+}
+
+static void test_stop(void)
+{
+	const struct ics *ics = &calendars[2];
+	size_t ret;
+
+	reference_parse(ics);
+
+	parse_init();
+	parsed.stop_at = 1;
+	ret = ical_parser_parse(&ical, ics->data, ics->len);
+
+	zassert_true(ret < ics->len, "All bytes parsed");
+	zassert_equal(parsed.count, 1, "%zu events", parsed.count);
+	check_event(&parsed.evt[0], &expected.evt[0]);
+
+	/* Nothing more is parsed until the parser is initialized again. */
+	zassert_equal(ical_parser_parse(&ical, ics->data + ret, ics->len - ret),
+		      0, NULL);
+	zassert_equal(parsed.count, 1, "%zu events", parsed.count);
+}
+
+static void test_footprint(void)
+{
+	/* Only the component being parsed and a short name are stored. */
+	zassert_true(sizeof(struct icalendar_parser) <=
+		     sizeof(struct ical_parser_evt) + ICAL_PARSER_NAME_SIZE +
+		     64, "%zu bytes", sizeof(struct icalendar_parser));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(icalendar_parser,
+			 ztest_unit_test(test_split_anywhere),
+			 ztest_unit_test(test_chunk_sizes),
+			 ztest_unit_test(test_lf_line_endings),
+			 ztest_unit_test(test_nested_component),
+			 ztest_unit_test(test_end_of_stream),
+			 ztest_unit_test(test_error_continues),
+			 ztest_unit_test(test_value_overflow),
+			 ztest_unit_test(test_stop),
+			 ztest_unit_test(test_footprint)
+	);
+	ztest_run_test_suite(icalendar_parser);
+}
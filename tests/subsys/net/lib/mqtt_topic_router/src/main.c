@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <stdio.h>
+#include <zephyr.h>
+#include <ztest.h>
+#include <net/mqtt_topic_router.h>
+
+#define TEST_ROUTER_NODES 32
+
+MQTT_TOPIC_ROUTER_DEFINE(router, TEST_ROUTER_NODES);
+
+static int handler_calls;
+static const struct mqtt_topic_router_route *handler_route;
+static void *handler_user_data;
+
+static void test_handler(const struct mqtt_topic_router_route *route,
+			 const char *topic, size_t topic_len, void *user_data)
+{
+	handler_calls++;
+	handler_route = route;
+	handler_user_data = user_data;
+}
+
+static const struct mqtt_topic_router_route routes[] = {
+	{ .filter = "a/b/c", .id = 1, .handler = test_handler },
+	{ .filter = "a/+/c", .id = 2 },
+	{ .filter = "a/#", .id = 3 },
+	{ .filter = "$aws/things/+/shadow/update/delta", .id = 4 },
+	{ .filter = "x/+", .id = 5 },
+	{ .filter = "+/y", .id = 6 },
+};
+
+static int match_id(const char *topic)
+{
+	const struct mqtt_topic_router_route *route =
+		mqtt_topic_router_match(&router, topic, strlen(topic));
+
+	return route ? route->id : -1;
+}
+
+static void setup(void)
+{
+	int err = mqtt_topic_router_reset(&router);
+
+	zassert_equal(err, 0, "Reset failed");
+
+	for (size_t i = 0; i < ARRAY_SIZE(routes); i++) {
+		err = mqtt_topic_router_add(&router, &routes[i]);
+		zassert_equal(err, 0, "Failed to add route %d", (int)i);
+	}
+
+	handler_calls = 0;
+	handler_route = NULL;
+	handler_user_data = NULL;
+}
+
+static void teardown(void)
+{
+}
+
+static void test_mqtt_topic_router_match_exact(void)
+{
+	zassert_equal(match_id("a/b/c"), 1, "Literal filter not matched");
+	zassert_equal(match_id("x/y/z"), -1, "Unexpected match");
+	zassert_equal(match_id(""), -1, "Empty topic matched");
+}
+
+static void test_mqtt_topic_router_match_not_terminated(void)
+{
+	const char *topic = "a/b/cd";
+	const struct mqtt_topic_router_route *route;
+
+	route = mqtt_topic_router_match(&router, topic, strlen(topic) - 1);
+	zassert_not_null(route, "Topic not matched");
+	zassert_equal(route->id, 1, "Wrong route");
+}
+
+static void test_mqtt_topic_router_match_single_level(void)
+{
+	zassert_equal(match_id("a/z/c"), 2, "'+' filter not matched");
+	zassert_equal(match_id("x/1"), 5, "'+' filter not matched");
+	zassert_equal(match_id("z/y"), 6, "'+' at root not matched");
+	zassert_equal(match_id("x/"), 5, "Empty level not matched");
+	zassert_equal(match_id("$aws/things/dev/shadow/update/delta"), 4,
+		      "'+' filter not matched");
+}
+
+static void test_mqtt_topic_router_match_multi_level(void)
+{
+	zassert_equal(match_id("a/z/d"), 3, "'#' filter not matched");
+	zassert_equal(match_id("a/b/c/d"), 3, "'#' filter not matched");
+	zassert_equal(match_id("a"), 3, "'#' should match the parent level");
+	zassert_equal(match_id("x/1/2"), -1, "'+' matched several levels");
+}
+
+static void test_mqtt_topic_router_match_dollar(void)
+{
+	const struct mqtt_topic_router_route any = { .filter = "#", .id = 7 };
+	int err = mqtt_topic_router_add(&router, &any);
+
+	zassert_equal(err, 0, "Failed to add route");
+	zassert_equal(match_id("q"), 7, "'#' should match everything");
+	zassert_equal(match_id("$SYS/y"), -1,
+		      "Wildcards should not match topics starting with '$'");
+	zassert_equal(match_id("$aws/things/dev/shadow/update/delta"), 4,
+		      "Literal '$' filter not matched");
+}
+
+static void test_mqtt_topic_router_add_invalid(void)
+{
+	const struct mqtt_topic_router_route invalid[] = {
+		{ .filter = "a/b#" },
+		{ .filter = "a/#/b" },
+		{ .filter = "a/b+/c" },
+		{ .filter = "a", .id = -1 },
+		{ .filter = NULL },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(invalid); i++) {
+		zassert_equal(mqtt_topic_router_add(&router, &invalid[i]),
+			      -EINVAL, "Invalid filter %d accepted", (int)i);
+	}
+
+	zassert_equal(mqtt_topic_router_add(&router, &routes[0]), -EALREADY,
+		      "Duplicate filter accepted");
+	zassert_equal(mqtt_topic_router_add(&router, &routes[2]), -EALREADY,
+		      "Duplicate '#' filter accepted");
+}
+
+static void test_mqtt_topic_router_add_no_mem(void)
+{
+	const struct mqtt_topic_router_route deep = {
+		.filter = "0/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9/"
+			  "0/1/2/3/4/5/6/7/8/9/0/1/2/3/4/5/6/7/8/9",
+	};
+
+	zassert_equal(mqtt_topic_router_add(&router, &deep), -ENOMEM,
+		      "Node storage should be exhausted");
+}
+
+static void test_mqtt_topic_router_dispatch(void)
+{
+	int user_data;
+	int ret;
+
+	ret = mqtt_topic_router_dispatch(&router, "a/b/c", 5, &user_data);
+	zassert_equal(ret, 1, "Wrong route identifier");
+	zassert_equal(handler_calls, 1, "Handler not called");
+	zassert_equal(handler_route, &routes[0], "Wrong route");
+	zassert_equal(handler_user_data, &user_data, "Wrong user data");
+
+	ret = mqtt_topic_router_dispatch(&router, "a/z/c", 5, NULL);
+	zassert_equal(ret, 2, "Wrong route identifier");
+	zassert_equal(handler_calls, 1, "Route without handler called");
+
+	ret = mqtt_topic_router_dispatch(&router, "b", 1, NULL);
+	zassert_equal(ret, -ENOENT, "Unexpected match");
+}
+
+/* Compare the router with a linear scan over the subscribed topics, as
+ * done by the cloud libraries before. Cycle counts are only meaningful
+ * when the test is run on hardware.
+ */
+#define BENCH_TOPIC_COUNT 48
+#define BENCH_TOPIC_LEN 64
+#define BENCH_ITERATIONS 1000
+
+static char bench_topics[BENCH_TOPIC_COUNT][BENCH_TOPIC_LEN];
+static struct mqtt_topic_router_route bench_routes[BENCH_TOPIC_COUNT];
+MQTT_TOPIC_ROUTER_DEFINE(bench_router, 4 * BENCH_TOPIC_COUNT);
+
+static int linear_match(const char *topic, size_t len)
+{
+	for (size_t i = 0; i < BENCH_TOPIC_COUNT; i++) {
+		if ((strlen(bench_topics[i]) == len) &&
+		    (strncmp(bench_topics[i], topic, len) == 0)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static void test_mqtt_topic_router_benchmark(void)
+{
+	static const char * const suffixes[] = {
+		"update/delta", "update/accepted", "get/accepted",
+		"get/rejected", "delete/accepted", "delete/rejected",
+	};
+	uint32_t start, linear_cycles, router_cycles;
+	volatile int sink;
+	int mismatches = 0;
+	int err;
+
+	err = mqtt_topic_router_reset(&bench_router);
+	zassert_equal(err, 0, "Reset failed");
+
+	for (size_t i = 0; i < BENCH_TOPIC_COUNT; i++) {
+		snprintf(bench_topics[i], BENCH_TOPIC_LEN,
+			 "$aws/things/device-%d/shadow/%s",
+			 (int)(i / ARRAY_SIZE(suffixes)),
+			 suffixes[i % ARRAY_SIZE(suffixes)]);
+
+		bench_routes[i].filter = bench_topics[i];
+		bench_routes[i].id = i;
+
+		err = mqtt_topic_router_add(&bench_router, &bench_routes[i]);
+		zassert_equal(err, 0, "Failed to add route %d", (int)i);
+	}
+
+	start = k_cycle_get_32();
+	for (size_t n = 0; n < BENCH_ITERATIONS; n++) {
+		const char *topic = bench_topics[n % BENCH_TOPIC_COUNT];
+
+		sink = linear_match(topic, strlen(topic));
+	}
+	linear_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (size_t n = 0; n < BENCH_ITERATIONS; n++) {
+		const char *topic = bench_topics[n % BENCH_TOPIC_COUNT];
+
+		sink = mqtt_topic_router_dispatch(&bench_router, topic,
+						  strlen(topic), NULL);
+		if (sink != (int)(n % BENCH_TOPIC_COUNT)) {
+			mismatches++;
+		}
+	}
+	router_cycles = k_cycle_get_32() - start;
+
+	zassert_equal(mismatches, 0, "Wrong routes matched");
+
+	TC_PRINT("%d topics, %d lookups: linear %u cycles, router %u cycles\n",
+		 BENCH_TOPIC_COUNT, BENCH_ITERATIONS, linear_cycles,
+		 router_cycles);
+	TC_PRINT("Router nodes used: %d\n", bench_router.nodes_used);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_topic_router_test,
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_match_exact, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_match_not_terminated, setup,
+			teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_match_single_level, setup,
+			teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_match_multi_level, setup,
+			teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_match_dollar, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_add_invalid, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_add_no_mem, setup, teardown),
+		ztest_unit_test_setup_teardown(
+			test_mqtt_topic_router_dispatch, setup, teardown),
+		ztest_unit_test(test_mqtt_topic_router_benchmark)
+	);
+
+	ztest_run_test_suite(mqtt_topic_router_test);
+}
@@ -0,0 +1,542 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+#include <string.h>
+#include <stdio.h>
+#include <zephyr/types.h>
+#include <stdbool.h>
+#include <ztest.h>
+#include <settings/settings.h>
+#include <modem/modem_info.h>
+#include <date_time.h>
+#include <nrf_socket.h>
+#include <net/nrf_cloud_agps.h>
+
+#include "nrf_cloud_transport.h"
+#include "nrf_cloud_agps_schema_v1.h"
+#include "nrf_cloud_agps_cache.h"
+
+#define SV_COUNT		NRF_CLOUD_AGPS_MAX_SV_TOW
+#define GNSS_SOCKET		3
+
+/* GPS time of the recorded payload: day 15000, 01:00:00. */
+#define PAYLOAD_DAY		15000
+#define PAYLOAD_TIME_S		3600
+#define PAYLOAD_GPS_TIME	(PAYLOAD_DAY * 86400 + PAYLOAD_TIME_S)
+#define GPS_TO_UNIX_S		(315964800 - 18)
+
+/* Elements of the cached types in a full payload. */
+#define CACHED_ELEMENTS		(2 * SV_COUNT + 2)
+/* System clock, location and integrity. */
+#define UNCACHED_ELEMENTS	3
+
+/* Stubs and mocks */
+struct stored_setting {
+	char key[48];
+	uint8_t value[96];
+	size_t len;
+};
+
+static struct stored_setting settings_store[CACHED_ELEMENTS];
+static size_t settings_count;
+static size_t settings_save_count;
+static struct settings_handler *settings_handler;
+
+/* Writes to the GNSS socket. */
+static size_t sink_writes[NRF_GNSS_AGPS_INTEGRITY + 1];
+static size_t sink_bytes;
+static uint32_t sink_ephe_mask;
+static nrf_gnss_agps_data_system_time_and_sv_tow_t sink_sys_time;
+
+static char request_json[256];
+static int64_t unix_time_ms;
+static bool unix_time_valid;
+
+void agps_print(enum nrf_cloud_agps_type type, void *data)
+{
+}
+
+ssize_t nrf_sendto(int socket, const void *message, size_t length, int flags,
+		   const void *dest_addr, nrf_socklen_t dest_len)
+{
+	nrf_gnss_agps_data_type_t type =
+		*(const nrf_gnss_agps_data_type_t *)dest_addr;
+
+	zassert_equal(socket, GNSS_SOCKET, "Wrong socket");
+	zassert_true(type < ARRAY_SIZE(sink_writes), "Wrong type");
+
+	sink_writes[type]++;
+	sink_bytes += length;
+
+	if (type == NRF_GNSS_AGPS_EPHEMERIDES) {
+		const nrf_gnss_agps_data_ephemeris_t *ephe = message;
+
+		sink_ephe_mask |= BIT(ephe->sv_id - 1);
+	} else if (type == NRF_GNSS_AGPS_GPS_SYSTEM_CLOCK_AND_TOWS) {
+		memcpy(&sink_sys_time, message, sizeof(sink_sys_time));
+	}
+
+	return length;
+}
+
+int nct_dc_send(const struct nct_dc_data *dc)
+{
+	size_t len = MIN(dc->data.len, sizeof(request_json) - 1);
+
+	memcpy(request_json, dc->data.ptr, len);
+	request_json[len] = '\0';
+
+	return 0;
+}
+
+int modem_info_init(void)
+{
+	return 0;
+}
+
+int modem_info_params_init(struct modem_param_info *modem)
+{
+	return 0;
+}
+
+int modem_info_params_get(struct modem_param_info *modem)
+{
+	return 0;
+}
+
+int date_time_now(int64_t *unix_time)
+{
+	if (!unix_time_valid) {
+		return -ENODATA;
+	}
+
+	*unix_time = unix_time_ms;
+
+	return 0;
+}
+
+int settings_subsys_init(void)
+{
+	return 0;
+}
+
+int settings_register(struct settings_handler *cf)
+{
+	if (settings_handler == cf) {
+		return -EEXIST;
+	}
+
+	settings_handler = cf;
+
+	return 0;
+}
+
+int settings_name_next(const char *name, const char **next)
+{
+	int len = 0;
+
+	if (next) {
+		*next = NULL;
+	}
+
+	while (name[len] && (name[len] != '/')) {
+		len++;
+	}
+
+	if (next && (name[len] == '/')) {
+		*next = &name[len + 1];
+	}
+
+	return len;
+}
+
+static ssize_t setting_read(void *cb_arg, void *data, size_t len)
+{
+	struct stored_setting *setting = cb_arg;
+
+	len = MIN(len, setting->len);
+	memcpy(data, setting->value, len);
+
+	return len;
+}
+
+int settings_load_subtree(const char *subtree)
+{
+	size_t prefix_len = strlen(subtree);
+	int err;
+
+	zassert_not_null(settings_handler, "Handler not registered");
+
+	for (size_t i = 0; i < settings_count; i++) {
+		struct stored_setting *setting = &settings_store[i];
+
+		if (strncmp(setting->key, subtree, prefix_len) ||
+		    (setting->key[prefix_len] != '/')) {
+			continue;
+		}
+
+		err = settings_handler->h_set(&setting->key[prefix_len + 1],
+					      setting->len, setting_read,
+					      setting);
+		zassert_equal(err, 0, "Cannot load %s", setting->key);
+	}
+
+	return 0;
+}
+
+int settings_save_one(const char *name, const void *value, size_t val_len)
+{
+	struct stored_setting *setting = NULL;
+
+	for (size_t i = 0; i < settings_count; i++) {
+		if (!strcmp(settings_store[i].key, name)) {
+			setting = &settings_store[i];
+			break;
+		}
+	}
+
+	if (setting == NULL) {
+		zassert_true(settings_count < ARRAY_SIZE(settings_store),
+			     "Too many settings");
+		setting = &settings_store[settings_count++];
+		strncpy(setting->key, name, sizeof(setting->key) - 1);
+	}
+
+	zassert_true(val_len <= sizeof(setting->value), "Setting too long");
+	memcpy(setting->value, value, val_len);
+	setting->len = val_len;
+	settings_save_count++;
+
+	return 0;
+}
+/* END stubs and mocks */
+
+/* A-GPS payload in the nRF Cloud binary schema, filled in the same way as a
+ * recorded response to a request for all the data types.
+ */
+static uint8_t payload[4096];
+static size_t payload_len;
+
+static void payload_array_add(enum nrf_cloud_agps_type type, uint16_t count)
+{
+	payload[payload_len] = type;
+	memcpy(&payload[payload_len + 1], &count, sizeof(count));
+	payload_len += NRF_CLOUD_AGPS_BIN_TYPE_SIZE +
+		       NRF_CLOUD_AGPS_BIN_COUNT_SIZE;
+}
+
+static void payload_add(const void *data, size_t len)
+{
+	zassert_true(payload_len + len <= sizeof(payload), "Payload too long");
+
+	memcpy(&payload[payload_len], data, len);
+	payload_len += len;
+}
+
+static void payload_build(bool with_time)
+{
+	payload_len = 0;
+	payload[payload_len++] = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+
+	struct nrf_cloud_agps_utc utc = {
+		.a1 = -5,
+		.a0 = 12,
+		.tot = 147,
+		.wn_t = 137,
+		.delta_tls = 18,
+	};
+
+	payload_array_add(NRF_CLOUD_AGPS_UTC_PARAMETERS, 1);
+	payload_add(&utc, sizeof(utc));
+
+	payload_array_add(NRF_CLOUD_AGPS_EPHEMERIDES, SV_COUNT);
+	for (uint8_t i = 0; i < SV_COUNT; i++) {
+		struct nrf_cloud_agps_ephemeris ephe;
+
+		memset(&ephe, i, sizeof(ephe));
+		ephe.sv_id = i + 1;
+		ephe.toe = 450;
+		payload_add(&ephe, sizeof(ephe));
+	}
+
+	payload_array_add(NRF_CLOUD_AGPS_ALMANAC, SV_COUNT);
+	for (uint8_t i = 0; i < SV_COUNT; i++) {
+		struct nrf_cloud_agps_almanac alm;
+
+		memset(&alm, 0x40 + i, sizeof(alm));
+		alm.sv_id = i + 1;
+		payload_add(&alm, sizeof(alm));
+	}
+
+	struct nrf_cloud_agps_klobuchar klob = {
+		.alpha0 = 11,
+		.alpha1 = 7,
+		.beta0 = 81,
+		.beta1 = 49,
+	};
+
+	payload_array_add(NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION, 1);
+	payload_add(&klob, sizeof(klob));
+
+	if (with_time) {
+		struct nrf_cloud_agps_system_time sys_time = {
+			.date_day = PAYLOAD_DAY,
+			.time_full_s = PAYLOAD_TIME_S,
+			.time_frac_ms = 250,
+			.sv_mask = 0xFFFFFFFF,
+		};
+		uint8_t reserved[4] = {0};
+
+		payload_array_add(NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK, 1);
+		payload_add(&sys_time,
+			    sizeof(sys_time) - sizeof(sys_time.sv_tow));
+		payload_add(reserved, sizeof(reserved));
+
+		payload_array_add(NRF_CLOUD_AGPS_GPS_TOWS, SV_COUNT);
+		for (uint8_t i = 0; i < SV_COUNT; i++) {
+			struct nrf_cloud_agps_tow_element tow = {
+				.sv_id = i + 1,
+				.tlm = 0x100 + i,
+				.flags = 1,
+			};
+
+			payload_add(&tow, sizeof(tow));
+		}
+	}
+
+	struct nrf_cloud_agps_location location = {
+		.latitude = 5000000,
+		.longitude = 1000000,
+		.altitude = 100,
+		.confidence = 68,
+	};
+	struct nrf_cloud_agps_integrity integrity = {0};
+
+	payload_array_add(NRF_CLOUD_AGPS_LOCATION, 1);
+	payload_add(&location, sizeof(location));
+	payload_array_add(NRF_CLOUD_AGPS_INTEGRITY, 1);
+	payload_add(&integrity, sizeof(integrity));
+}
+
+static size_t sink_cached_writes(void)
+{
+	return sink_writes[NRF_GNSS_AGPS_UTC_PARAMETERS] +
+	       sink_writes[NRF_GNSS_AGPS_EPHEMERIDES] +
+	       sink_writes[NRF_GNSS_AGPS_ALMANAC] +
+	       sink_writes[NRF_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION];
+}
+
+static size_t sink_uncached_writes(void)
+{
+	return sink_writes[NRF_GNSS_AGPS_GPS_SYSTEM_CLOCK_AND_TOWS] +
+	       sink_writes[NRF_GNSS_AGPS_LOCATION] +
+	       sink_writes[NRF_GNSS_AGPS_INTEGRITY];
+}
+
+static void sink_reset(void)
+{
+	memset(sink_writes, 0, sizeof(sink_writes));
+	memset(&sink_sys_time, 0, sizeof(sink_sys_time));
+	sink_bytes = 0;
+	sink_ephe_mask = 0;
+	settings_save_count = 0;
+}
+
+static void time_set(uint32_t gps_time)
+{
+	unix_time_ms = ((int64_t)gps_time + GPS_TO_UNIX_S) * MSEC_PER_SEC;
+	unix_time_valid = true;
+}
+
+static void process_payload(void)
+{
+	const int socket = GNSS_SOCKET;
+	int err;
+
+	err = nrf_cloud_agps_process((const char *)payload, payload_len,
+				     &socket);
+	zassert_equal(err, 0, "Processing failed");
+}
+
+static void test_setup(void)
+{
+	int err;
+
+	settings_count = 0;
+	unix_time_valid = false;
+	request_json[0] = '\0';
+	sink_reset();
+
+	/* Reboot with an empty cache. */
+	err = nrf_cloud_agps_cache_init();
+	zassert_equal(err, 0, "Cache init failed");
+}
+
+static void test_first_injection(void)
+{
+	payload_build(true);
+	process_payload();
+
+	zassert_equal(sink_cached_writes(), CACHED_ELEMENTS,
+		      "Cached types not injected");
+	zassert_equal(sink_uncached_writes(), UNCACHED_ELEMENTS,
+		      "Uncached types not injected");
+	zassert_equal(settings_save_count, CACHED_ELEMENTS,
+		      "Cache not saved");
+
+	/* The TOWs follow the system clock in the payload. */
+	zassert_equal(sink_sys_time.sv_mask, 0xFFFFFFFF, "Wrong TOW mask");
+	for (size_t i = 0; i < SV_COUNT; i++) {
+		zassert_equal(sink_sys_time.sv_tow[i].tlm, 0x100 + i,
+			      "TOW %u not injected", (unsigned int)i);
+	}
+}
+
+static void test_repeated_payload(void)
+{
+	size_t first_bytes;
+
+	payload_build(true);
+	process_payload();
+	first_bytes = sink_bytes;
+
+	sink_reset();
+	process_payload();
+
+	zassert_equal(sink_cached_writes(), 0, "Cached data injected again");
+	zassert_equal(sink_uncached_writes(), UNCACHED_ELEMENTS,
+		      "Uncached types not injected");
+	zassert_equal(settings_save_count, 0, "Unchanged data saved");
+	zassert_true(sink_bytes < first_bytes, "No bytes saved");
+
+	TC_PRINT("Injected %u bytes, then %u bytes, %u bytes saved\n",
+		 (unsigned int)first_bytes, (unsigned int)sink_bytes,
+		 (unsigned int)(first_bytes - sink_bytes));
+}
+
+static void test_changed_ephemeris(void)
+{
+	/* The first ephemeris follows the UTC parameters. */
+	struct nrf_cloud_agps_ephemeris *ephe =
+		(struct nrf_cloud_agps_ephemeris *)&payload[
+			NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION_SIZE + 3 +
+			sizeof(struct nrf_cloud_agps_utc) + 3];
+
+	payload_build(true);
+	process_payload();
+
+	zassert_equal(ephe->sv_id, 1, "Wrong payload layout");
+	ephe->toe += 1;
+
+	sink_reset();
+	process_payload();
+
+	zassert_equal(sink_cached_writes(), 1, "Wrong number of elements");
+	zassert_equal(sink_ephe_mask, BIT(0), "Wrong ephemeris injected");
+	zassert_equal(settings_save_count, 1, "Changed data not saved");
+}
+
+static void test_request_filter(void)
+{
+	payload_build(true);
+	process_payload();
+
+	time_set(PAYLOAD_GPS_TIME + 60);
+	sink_reset();
+
+	zassert_equal(nrf_cloud_agps_request_all(), 0, "Request failed");
+	zassert_not_null(strstr(request_json, "\"types\":[7,8,9]"),
+			 "Wrong request: %s", request_json);
+
+	/* The requested data is injected from the cache. */
+	zassert_equal(sink_cached_writes(), CACHED_ELEMENTS,
+		      "Cached data not injected");
+	zassert_equal(sink_uncached_writes(), 0, "Wrong data injected");
+}
+
+static void test_expired_data(void)
+{
+	payload_build(true);
+	process_payload();
+
+	/* Ephemerides have expired, the rest is still valid. */
+	time_set(PAYLOAD_GPS_TIME +
+		 CONFIG_NRF_CLOUD_AGPS_CACHE_EPHEMERIS_VALIDITY + 1);
+	sink_reset();
+
+	zassert_equal(nrf_cloud_agps_request_all(), 0, "Request failed");
+	zassert_not_null(strstr(request_json, "\"types\":[2,7,8,9]"),
+			 "Wrong request: %s", request_json);
+	zassert_equal(sink_writes[NRF_GNSS_AGPS_EPHEMERIDES], 0,
+		      "Expired data injected");
+	zassert_equal(sink_cached_writes(), SV_COUNT + 2,
+		      "Valid data not injected");
+}
+
+static void test_persistence(void)
+{
+	int err;
+
+	payload_build(true);
+	process_payload();
+
+	/* Reboot, the cache is loaded from the settings storage. */
+	err = nrf_cloud_agps_cache_init();
+	zassert_equal(err, 0, "Cache init failed");
+
+	time_set(PAYLOAD_GPS_TIME + 60);
+	sink_reset();
+
+	zassert_equal(nrf_cloud_agps_request_all(), 0, "Request failed");
+	zassert_not_null(strstr(request_json, "\"types\":[7,8,9]"),
+			 "Wrong request: %s", request_json);
+	zassert_equal(sink_cached_writes(), CACHED_ELEMENTS,
+		      "Cached data not injected after reboot");
+
+	/* The response to the request is not injected again. */
+	sink_reset();
+	process_payload();
+
+	zassert_equal(sink_cached_writes(), 0, "Cached data injected again");
+	zassert_equal(settings_save_count, 0, "Unchanged data saved");
+}
+
+static void test_unknown_time(void)
+{
+	payload_build(false);
+	process_payload();
+
+	zassert_equal(sink_cached_writes(), CACHED_ELEMENTS,
+		      "Cached types not injected");
+	zassert_equal(settings_save_count, 0, "Data cached without time");
+
+	sink_reset();
+	process_payload();
+
+	zassert_equal(sink_cached_writes(), CACHED_ELEMENTS,
+		      "Data not injected without time");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(lib_nrf_cloud_agps_test,
+		ztest_unit_test_setup_teardown(test_first_injection,
+					       test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_repeated_payload,
+					       test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_changed_ephemeris,
+					       test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_request_filter,
+					       test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_expired_data,
+					       test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_persistence,
+					       test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_unknown_time,
+					       test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(lib_nrf_cloud_agps_test);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Simulated IPC between the cores. Each channel is one event, set when the
+ * network core triggers the send task of the channel.
+ */
+#ifndef NRF_IPC_SIM_H_
+#define NRF_IPC_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NRF_IPC NULL
+
+typedef uint8_t nrf_ipc_event_t;
+typedef uint8_t nrf_ipc_task_t;
+
+/* Implemented by the test. */
+void pcd_sim_ipc_trigger(uint8_t channel);
+bool pcd_sim_ipc_event_check(uint8_t channel);
+void pcd_sim_ipc_event_clear(uint8_t channel);
+
+static inline nrf_ipc_task_t nrf_ipc_send_task_get(uint8_t index)
+{
+	return index;
+}
+
+static inline nrf_ipc_event_t nrf_ipc_receive_event_get(uint8_t index)
+{
+	return index;
+}
+
+static inline void nrf_ipc_send_config_set(void *p_reg, uint8_t index,
+					   uint32_t channels_mask)
+{
+}
+
+static inline void nrf_ipc_receive_config_set(void *p_reg, uint8_t index,
+					      uint32_t channels_mask)
+{
+}
+
+static inline void nrf_ipc_task_trigger(void *p_reg, nrf_ipc_task_t task)
+{
+	pcd_sim_ipc_trigger(task);
+}
+
+static inline bool nrf_ipc_event_check(void *p_reg, nrf_ipc_event_t event)
+{
+	return pcd_sim_ipc_event_check(event);
+}
+
+static inline void nrf_ipc_event_clear(void *p_reg, nrf_ipc_event_t event)
+{
+	pcd_sim_ipc_event_clear(event);
+}
+
+#endif /* NRF_IPC_SIM_H_ */
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Simulated network core power control. The network core is a thread,
+ * started when the force off is released and aborted when it is set.
+ */
+#ifndef NRF_RESET_SIM_H_
+#define NRF_RESET_SIM_H_
+
+#include <stdbool.h>
+
+#define NRF_RESET NULL
+
+void pcd_sim_net_core_power(bool on);
+
+static inline void nrf_reset_network_force_off(void *p_reg, bool force_off)
+{
+	pcd_sim_net_core_power(!force_off);
+}
+
+#endif /* NRF_RESET_SIM_H_ */
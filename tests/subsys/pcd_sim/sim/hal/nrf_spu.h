@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* The simulated cores share all memory, so the SPU does nothing. */
+#ifndef NRF_SPU_SIM_H_
+#define NRF_SPU_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NRF_SPU NULL
+#define NRF_SPU_MEM_PERM_READ 0x4
+
+static inline void nrf_spu_extdomain_set(void *p_reg, uint8_t domain_id,
+					 bool secure_attr, bool lock)
+{
+}
+
+static inline void nrf_spu_ramregion_set(void *p_reg, uint8_t region_id,
+					 bool secure_attr, uint32_t permissions,
+					 bool lock)
+{
+}
+
+#endif /* NRF_SPU_SIM_H_ */
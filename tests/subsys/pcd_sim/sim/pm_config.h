@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+/* Partitions of the simulated nRF5340. The shared RAM is a buffer in the
+ * test, and the network core image is written to the simulated flash.
+ */
+#ifndef PM_CONFIG_SIM_H_
+#define PM_CONFIG_SIM_H_
+
+#include <stdint.h>
+
+extern uint32_t pcd_sim_sram[];
+
+#define PM_PCD_SRAM_ADDRESS ((uintptr_t)pcd_sim_sram)
+#define PM_CPUNET_B0N_SIZE 0x10000
+
+#endif /* PM_CONFIG_SIM_H_ */
@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2021 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-BSD-5-Clause-Nordic
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <stdbool.h>
+#include <zephyr/types.h>
+#include <devicetree.h>
+#include <drivers/flash.h>
+#include <dfu/pcd.h>
+
+#define FLASH_NAME DT_CHOSEN_ZEPHYR_FLASH_CONTROLLER_LABEL
+/* Must match PM_CPUNET_B0N_SIZE in sim/pm_config.h */
+#define NET_CORE_APP_OFFSET 0x10000
+
+#define NUM_CHUNKS 11
+#define BUF_LEN ((NUM_CHUNKS - 1) * CONFIG_PCD_CHUNK_SIZE + 10)
+
+#define PCD_CMD_MAGIC_DONE 0xf103ce5d
+
+/* Leading fields of the PCD CMD, which keep their location. */
+struct pcd_cmd_head {
+	uint32_t magic;
+	const void *data;
+	size_t len;
+	off_t offset;
+	uint32_t chunk_size;
+};
+
+/* Shared RAM holding the PCD CMD, used by both simulated cores. */
+uint32_t pcd_sim_sram[32];
+
+static const struct device *fdev;
+static uint8_t data[BUF_LEN];
+static uint8_t read_buf[BUF_LEN];
+
+/* Simulated network core */
+static K_THREAD_STACK_DEFINE(net_core_stack, 2048);
+static struct k_thread net_core_thread;
+static bool net_core_on;
+static k_thread_entry_t net_core_main;
+static uint32_t net_core_starts;
+
+/* Simulated IPC event from the network core */
+static bool ipc_event;
+static uint32_t ipc_signals;
+/* The network core hangs at every multiple of this signal count. */
+static uint32_t hang_interval;
+/* Corrupt the source data at this signal count. */
+static uint32_t tamper_at;
+
+/* Progress reported to the application core */
+static size_t progress_last;
+static uint32_t progress_reports;
+static bool progress_decreased;
+
+void pcd_sim_net_core_power(bool on)
+{
+	if (net_core_on) {
+		k_thread_abort(&net_core_thread);
+		net_core_on = false;
+	}
+
+	if (on) {
+		net_core_starts++;
+		net_core_on = true;
+		k_thread_create(&net_core_thread, net_core_stack,
+				K_THREAD_STACK_SIZEOF(net_core_stack),
+				net_core_main, NULL, NULL, NULL,
+				k_thread_priority_get(k_current_get()), 0,
+				K_NO_WAIT);
+	}
+}
+
+void pcd_sim_ipc_trigger(uint8_t channel)
+{
+	zassert_equal(channel, CONFIG_PCD_IPC_CHANNEL, "Wrong channel");
+
+	ipc_event = true;
+	ipc_signals++;
+
+	if (ipc_signals == tamper_at) {
+		data[BUF_LEN - 1] ^= 0xFF;
+	}
+
+	if (hang_interval && (ipc_signals % hang_interval) == 0) {
+		/* Stays suspended until the core is turned off. */
+		k_thread_suspend(k_current_get());
+	}
+
+	/* Let the application core see the event. */
+	k_yield();
+}
+
+bool pcd_sim_ipc_event_check(uint8_t channel)
+{
+	/* Let the network core run while the application core waits. */
+	k_yield();
+
+	return ipc_event;
+}
+
+void pcd_sim_ipc_event_clear(uint8_t channel)
+{
+	ipc_event = false;
+}
+
+/* Network core bootloader, like the netboot sample. */
+static void net_core_pcd(void *p1, void *p2, void *p3)
+{
+	int err;
+
+	if (pcd_fw_copy_status_get() != PCD_STATUS_COPY) {
+		return;
+	}
+
+	err = pcd_fw_copy(fdev);
+	if (err != 0) {
+		pcd_fw_copy_invalidate();
+		return;
+	}
+
+	pcd_fw_copy_done();
+}
+
+/* Network core bootloader with a smaller flash page than the chunk size
+ * set by the application core.
+ */
+static void net_core_small_chunks(void *p1, void *p2, void *p3)
+{
+	struct flash_pages_info page;
+	int err;
+
+	err = flash_get_page_info_by_offs(fdev, NET_CORE_APP_OFFSET, &page);
+	zassert_equal(err, 0, "flash_get_page_info_by_offs failed: %d", err);
+
+	((struct pcd_cmd_head *)pcd_sim_sram)->chunk_size =
+		page.size + CONFIG_PCD_BUF_SIZE;
+
+	net_core_pcd(p1, p2, p3);
+}
+
+/* Network core bootloader that copies in one go and does not signal. */
+static void net_core_legacy(void *p1, void *p2, void *p3)
+{
+	for (int i = 0; i < 5 * CONFIG_PCD_CHUNK_TIMEOUT_MS; i++) {
+		k_yield();
+	}
+
+	pcd_sim_sram[0] = PCD_CMD_MAGIC_DONE;
+}
+
+static void progress_cb(size_t written, size_t total)
+{
+	zassert_equal(total, BUF_LEN, "Wrong total");
+	zassert_true(written <= total, "Too many bytes written");
+
+	if (written < progress_last) {
+		progress_decreased = true;
+	}
+
+	progress_last = written;
+	progress_reports++;
+}
+
+static void check_flash(void)
+{
+	int err = flash_read(fdev, NET_CORE_APP_OFFSET, read_buf,
+			     sizeof(read_buf));
+
+	zassert_equal(err, 0, "flash_read failed: %d", err);
+	zassert_mem_equal(data, read_buf, sizeof(data), "Wrong flash content");
+}
+
+static void test_setup(void)
+{
+	fdev = device_get_binding(FLASH_NAME);
+	zassert_not_null(fdev, "Flash device not found");
+
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 7 + sizeof(pcd_sim_sram));
+	}
+
+	/* Invalidate the CMD left by the previous test. */
+	memset(pcd_sim_sram, 0, sizeof(pcd_sim_sram));
+
+	net_core_main = net_core_pcd;
+	net_core_starts = 0;
+	ipc_event = false;
+	ipc_signals = 0;
+	hang_interval = 0;
+	tamper_at = 0;
+	progress_last = 0;
+	progress_reports = 0;
+	progress_decreased = false;
+
+	pcd_progress_cb_set(progress_cb);
+}
+
+static void test_update(void)
+{
+	int err;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_equal(pcd_fw_copy_status_get(), PCD_STATUS_COPY_DONE, NULL);
+	check_flash();
+
+	zassert_equal(net_core_starts, 1, NULL);
+	/* One signal per chunk, and one when the copy is done. */
+	zassert_equal(ipc_signals, NUM_CHUNKS + 1, "%u signals",
+		      ipc_signals);
+	zassert_false(progress_decreased, "Progress decreased");
+	zassert_equal(progress_last, BUF_LEN, NULL);
+	zassert_true(progress_reports >= 2, "%u reports", progress_reports);
+	zassert_false(net_core_on, "Network core not turned off");
+}
+
+static void test_resume_after_stall(void)
+{
+	int err;
+
+	hang_interval = 4;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_equal(pcd_fw_copy_status_get(), PCD_STATUS_COPY_DONE, NULL);
+	check_flash();
+
+	zassert_equal(net_core_starts, 3, NULL);
+	/* No chunk is copied twice. */
+	zassert_equal(ipc_signals, NUM_CHUNKS + 1, "%u signals",
+		      ipc_signals);
+	zassert_false(progress_decreased, "Progress decreased");
+}
+
+static void test_resume_after_reset(void)
+{
+	int err;
+
+	/* The network core stalls more often than it is restarted. */
+	hang_interval = 2;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, -ETIMEDOUT, "Unexpected result: %d", err);
+	zassert_equal(net_core_starts, CONFIG_PCD_RESUME_RETRIES + 1, NULL);
+	zassert_false(net_core_on, "Network core not turned off");
+
+	/* The same update after a reset of the application core resumes
+	 * the copy.
+	 */
+	hang_interval = 0;
+	progress_last = 0;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	check_flash();
+	zassert_equal(ipc_signals, NUM_CHUNKS + 1, "%u signals",
+		      ipc_signals);
+}
+
+static void test_new_update_restarts(void)
+{
+	int err;
+
+	hang_interval = 2;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, -ETIMEDOUT, "Unexpected result: %d", err);
+
+	/* A different update is copied from the start. */
+	hang_interval = 0;
+	ipc_signals = 0;
+	data[0] ^= 0xFF;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	check_flash();
+	zassert_equal(ipc_signals, NUM_CHUNKS + 1, "%u signals",
+		      ipc_signals);
+}
+
+static void test_crc_mismatch(void)
+{
+	int err;
+
+	/* The data changes after the application core computed the CRC. */
+	tamper_at = 2;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, -EIO, "Unexpected result: %d", err);
+	zassert_equal(pcd_fw_copy_status_get(), PCD_STATUS_COPY_FAILED, NULL);
+	zassert_false(net_core_on, "Network core not turned off");
+}
+
+static void test_unaligned_chunk_size(void)
+{
+	int err;
+
+	/* Resuming would erase verified data, so the copy is refused. */
+	net_core_main = net_core_small_chunks;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, -EIO, "Unexpected result: %d", err);
+	zassert_equal(pcd_fw_copy_status_get(), PCD_STATUS_COPY_FAILED, NULL);
+	zassert_equal(progress_last, 0, "Data copied");
+}
+
+static void test_legacy_net_core(void)
+{
+	int err;
+
+	/* A network core which never reports progress is not restarted. */
+	net_core_main = net_core_legacy;
+
+	err = pcd_network_core_update(data, sizeof(data));
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_equal(net_core_starts, 1, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(pcd_sim_test,
+		ztest_unit_test_setup_teardown(test_update,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_resume_after_stall,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_resume_after_reset,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_new_update_restarts,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_crc_mismatch,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_unaligned_chunk_size,
+			test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_legacy_net_core,
+			test_setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(pcd_sim_test);
+}